@@ -0,0 +1,165 @@
+﻿#include "benchmark/benchmark.h"
+#include "B_Fixtures.h"
+#include "UV.h"
+#include "NurbsCurve.h"
+#include "NurbsSurface.h"
+#include "SurfaceProjector.h"
+#include "PreparedCurve.h"
+using namespace LNLib;
+
+// Arguments: degree, control points count.
+static void BM_GetPointOnCurve(benchmark::State& state)
+{
+	LN_NurbsCurve curve = CreateBenchmarkCurve(state.range(0), state.range(1));
+	std::vector<double> params = CreateBenchmarkParams(256);
+	for (auto _ : state)
+	{
+		for (int i = 0; i < params.size(); i++)
+		{
+			benchmark::DoNotOptimize(NurbsCurve::GetPointOnCurve(curve, params[i]));
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * params.size());
+}
+BENCHMARK(BM_GetPointOnCurve)->ArgsProduct({ {1, 2, 3, 5}, {16, 256} });
+
+static void BM_GetPointOnCheckedCurve(benchmark::State& state)
+{
+	LN_NurbsCurve curve = CreateBenchmarkCurve(state.range(0), state.range(1));
+	LN_CheckedNurbsCurve checkedCurve = NurbsCurve::Check(curve);
+	std::vector<double> params = CreateBenchmarkParams(256);
+	for (auto _ : state)
+	{
+		for (int i = 0; i < params.size(); i++)
+		{
+			benchmark::DoNotOptimize(NurbsCurve::GetPointOnCurve(checkedCurve, params[i]));
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * params.size());
+}
+BENCHMARK(BM_GetPointOnCheckedCurve)->ArgsProduct({ {1, 2, 3, 5}, {16, 256} });
+
+static void BM_GetPointOnPreparedCurve(benchmark::State& state)
+{
+	LN_NurbsCurve curve = CreateBenchmarkCurve(state.range(0), state.range(1));
+	PreparedCurve preparedCurve(curve);
+	preparedCurve.GetPowerBasisCoefficients();
+	std::vector<double> params = CreateBenchmarkParams(256);
+	for (auto _ : state)
+	{
+		for (int i = 0; i < params.size(); i++)
+		{
+			benchmark::DoNotOptimize(preparedCurve.GetPointOnCurve(params[i]));
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * params.size());
+}
+BENCHMARK(BM_GetPointOnPreparedCurve)->ArgsProduct({ {1, 2, 3, 5}, {16, 256} });
+
+// Arguments: degree, batch size.
+static void BM_GetPointsOnCurve(benchmark::State& state)
+{
+	LN_NurbsCurve curve = CreateBenchmarkCurve(state.range(0), 64);
+	std::vector<double> params = CreateBenchmarkParams(state.range(1));
+	std::vector<XYZ> points(params.size());
+	for (auto _ : state)
+	{
+		NurbsCurve::GetPointsOnCurve(curve, params.data(), params.size(), points.data());
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * params.size());
+}
+BENCHMARK(BM_GetPointsOnCurve)->ArgsProduct({ {2, 3}, {16, 1024, 65536} });
+
+static void BM_ComputeRationalCurveDerivatives(benchmark::State& state)
+{
+	LN_NurbsCurve curve = CreateBenchmarkCurve(state.range(0), 64);
+	std::vector<double> params = CreateBenchmarkParams(256);
+	for (auto _ : state)
+	{
+		for (int i = 0; i < params.size(); i++)
+		{
+			benchmark::DoNotOptimize(NurbsCurve::ComputeRationalCurveDerivatives(curve, 2, params[i]));
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * params.size());
+}
+BENCHMARK(BM_ComputeRationalCurveDerivatives)->Arg(2)->Arg(3)->Arg(5);
+
+// Arguments: degree, control points count in each direction.
+static void BM_GetPointOnSurface(benchmark::State& state)
+{
+	LN_NurbsSurface surface = CreateBenchmarkSurface(state.range(0), state.range(1), state.range(1));
+	std::vector<double> params = CreateBenchmarkParams(16);
+	for (auto _ : state)
+	{
+		for (int i = 0; i < params.size(); i++)
+		{
+			for (int j = 0; j < params.size(); j++)
+			{
+				benchmark::DoNotOptimize(NurbsSurface::GetPointOnSurface(surface, UV(params[i], params[j])));
+			}
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * params.size() * params.size());
+}
+BENCHMARK(BM_GetPointOnSurface)->ArgsProduct({ {1, 2, 3}, {8, 64} });
+
+// Arguments: degree, grid size in each direction.
+static void BM_EvaluateGrid(benchmark::State& state)
+{
+	LN_NurbsSurface surface = CreateBenchmarkSurface(state.range(0), 32, 32);
+	std::vector<double> params = CreateBenchmarkParams(state.range(1));
+	std::vector<std::vector<XYZ>> points;
+	for (auto _ : state)
+	{
+		NurbsSurface::EvaluateGrid(surface, params, params, points);
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * params.size() * params.size());
+}
+BENCHMARK(BM_EvaluateGrid)->ArgsProduct({ {2, 3}, {16, 256} });
+
+static std::vector<XYZ> CreateProjectionPoints(const LN_NurbsSurface& surface, int count)
+{
+	std::vector<double> params = CreateBenchmarkParams(count);
+	std::vector<XYZ> points;
+	for (int i = 0; i < count; i++)
+	{
+		XYZ point = NurbsSurface::GetPointOnSurface(surface, UV(params[i], params[count - 1 - i]));
+		points.emplace_back(point + XYZ(0, 0, 0.1));
+	}
+	return points;
+}
+
+// Arguments: control points count in each direction.
+static void BM_GetParamOnSurface(benchmark::State& state)
+{
+	LN_NurbsSurface surface = CreateBenchmarkSurface(3, state.range(0), state.range(0));
+	std::vector<XYZ> points = CreateProjectionPoints(surface, 16);
+	for (auto _ : state)
+	{
+		for (int i = 0; i < points.size(); i++)
+		{
+			benchmark::DoNotOptimize(NurbsSurface::GetParamOnSurface(surface, points[i]));
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * points.size());
+}
+BENCHMARK(BM_GetParamOnSurface)->Arg(8)->Unit(benchmark::kMillisecond);
+
+static void BM_SurfaceProjector(benchmark::State& state)
+{
+	LN_NurbsSurface surface = CreateBenchmarkSurface(3, state.range(0), state.range(0));
+	SurfaceProjector projector(surface);
+	std::vector<XYZ> points = CreateProjectionPoints(surface, 16);
+	for (auto _ : state)
+	{
+		for (int i = 0; i < points.size(); i++)
+		{
+			benchmark::DoNotOptimize(projector.GetParamOnSurface(points[i]));
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * points.size());
+}
+BENCHMARK(BM_SurfaceProjector)->Arg(8)->Arg(16)->Unit(benchmark::kMicrosecond);
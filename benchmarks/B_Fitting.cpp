@@ -0,0 +1,88 @@
+﻿#include "benchmark/benchmark.h"
+#include "B_Fixtures.h"
+#include "NurbsCurve.h"
+#include "NurbsSurface.h"
+#include "MathUtils.h"
+using namespace LNLib;
+
+static std::vector<XYZ> CreateThroughPoints(int count)
+{
+	std::vector<XYZ> points(count);
+	for (int i = 0; i < count; i++)
+	{
+		double t = 20.0 * i / count;
+		points[i] = XYZ(t, std::sin(t), 0.1 * std::cos(3.0 * t));
+	}
+	return points;
+}
+
+// Arguments: degree, through points count.
+static void BM_CurveGlobalInterpolation(benchmark::State& state)
+{
+	std::vector<XYZ> throughPoints = CreateThroughPoints(state.range(1));
+	for (auto _ : state)
+	{
+		LN_NurbsCurve curve;
+		NurbsCurve::GlobalInterpolation(state.range(0), throughPoints, curve);
+		benchmark::DoNotOptimize(curve.ControlPoints.data());
+	}
+	state.SetItemsProcessed(state.iterations() * throughPoints.size());
+}
+BENCHMARK(BM_CurveGlobalInterpolation)->ArgsProduct({ {2, 3}, {100, 1000, 10000} })->Unit(benchmark::kMillisecond);
+
+// Macro workload: approximate 10k points with 200 control points.
+static void BM_CurveLeastSquaresApproximation(benchmark::State& state)
+{
+	std::vector<XYZ> throughPoints = CreateThroughPoints(10000);
+	for (auto _ : state)
+	{
+		LN_NurbsCurve curve;
+		NurbsCurve::LeastSquaresApproximation(3, throughPoints, 200, curve);
+		benchmark::DoNotOptimize(curve.ControlPoints.data());
+	}
+	state.SetItemsProcessed(state.iterations() * throughPoints.size());
+}
+BENCHMARK(BM_CurveLeastSquaresApproximation)->Unit(benchmark::kMillisecond);
+
+// Arguments: square matrix size, as in the N^T N products of fitting.
+static void BM_MatrixMultiply(benchmark::State& state)
+{
+	int size = state.range(0);
+	std::vector<std::vector<double>> matrix(size, std::vector<double>(size));
+	for (int i = 0; i < size; i++)
+	{
+		for (int j = 0; j < size; j++)
+		{
+			matrix[i][j] = std::sin(0.1 * i + 0.3 * j);
+		}
+	}
+	for (auto _ : state)
+	{
+		std::vector<std::vector<double>> product = MathUtils::MatrixMultiply(matrix, matrix);
+		benchmark::DoNotOptimize(product.data());
+	}
+	state.SetItemsProcessed(state.iterations() * size * size * size);
+}
+BENCHMARK(BM_MatrixMultiply)->Arg(64)->Arg(256)->Arg(512)->Unit(benchmark::kMillisecond);
+
+// Arguments: through points count in each direction.
+static void BM_SurfaceGlobalInterpolation(benchmark::State& state)
+{
+	int count = state.range(0);
+	std::vector<std::vector<XYZ>> throughPoints(count, std::vector<XYZ>(count));
+	for (int i = 0; i < count; i++)
+	{
+		for (int j = 0; j < count; j++)
+		{
+			throughPoints[i][j] = XYZ(i, j, std::sin(0.3 * i) * std::cos(0.3 * j));
+		}
+	}
+	for (auto _ : state)
+	{
+		LN_NurbsSurface surface;
+		NurbsSurface::GlobalInterpolation(throughPoints, 3, 3, surface);
+		benchmark::DoNotOptimize(surface.ControlPoints.data());
+	}
+	state.SetItemsProcessed(state.iterations() * count * count);
+}
+BENCHMARK(BM_SurfaceGlobalInterpolation)->Arg(10)->Arg(40)->Unit(benchmark::kMillisecond);
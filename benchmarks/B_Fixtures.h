@@ -0,0 +1,82 @@
+﻿#pragma once
+#include "XYZ.h"
+#include "XYZW.h"
+#include "LNObject.h"
+#include <vector>
+#include <cmath>
+
+namespace LNLib
+{
+	/// <summary>
+	/// Clamped uniform knot vector with (controlPointsCount - degree) spans on [0,1].
+	/// </summary>
+	inline std::vector<double> CreateUniformKnotVector(int degree, int controlPointsCount)
+	{
+		int spans = controlPointsCount - degree;
+		std::vector<double> knotVector;
+		for (int i = 0; i <= degree; i++)
+		{
+			knotVector.emplace_back(0.0);
+		}
+		for (int i = 1; i < spans; i++)
+		{
+			knotVector.emplace_back(i / static_cast<double>(spans));
+		}
+		for (int i = 0; i <= degree; i++)
+		{
+			knotVector.emplace_back(1.0);
+		}
+		return knotVector;
+	}
+
+	/// <summary>
+	/// Rational wave curve, weights vary so the rational code paths are measured.
+	/// </summary>
+	inline LN_NurbsCurve CreateBenchmarkCurve(int degree, int controlPointsCount)
+	{
+		LN_NurbsCurve curve;
+		curve.Degree = degree;
+		curve.KnotVector = CreateUniformKnotVector(degree, controlPointsCount);
+		for (int i = 0; i < controlPointsCount; i++)
+		{
+			double weight = 1.0 + 0.5 * (i % 3);
+			curve.ControlPoints.emplace_back(XYZW(XYZ(i, std::sin(0.7 * i), std::cos(0.3 * i)), weight));
+		}
+		return curve;
+	}
+
+	/// <summary>
+	/// Rational wave surface with countU x countV control points.
+	/// </summary>
+	inline LN_NurbsSurface CreateBenchmarkSurface(int degree, int countU, int countV)
+	{
+		LN_NurbsSurface surface;
+		surface.DegreeU = degree;
+		surface.DegreeV = degree;
+		surface.KnotVectorU = CreateUniformKnotVector(degree, countU);
+		surface.KnotVectorV = CreateUniformKnotVector(degree, countV);
+		surface.ControlPoints.resize(countU, std::vector<XYZW>(countV));
+		for (int i = 0; i < countU; i++)
+		{
+			for (int j = 0; j < countV; j++)
+			{
+				double weight = 1.0 + 0.25 * ((i + j) % 2);
+				surface.ControlPoints[i][j] = XYZW(XYZ(i, j, std::sin(0.5 * i) * std::cos(0.5 * j)), weight);
+			}
+		}
+		return surface;
+	}
+
+	/// <summary>
+	/// Ascending parameters in [0,1].
+	/// </summary>
+	inline std::vector<double> CreateBenchmarkParams(int count)
+	{
+		std::vector<double> params(count);
+		for (int i = 0; i < count; i++)
+		{
+			params[i] = count == 1 ? 0.5 : i / static_cast<double>(count - 1);
+		}
+		return params;
+	}
+}
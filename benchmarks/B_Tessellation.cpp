@@ -0,0 +1,64 @@
+﻿#include "benchmark/benchmark.h"
+#include "B_Fixtures.h"
+#include "UV.h"
+#include "NurbsCurve.h"
+#include "NurbsSurface.h"
+using namespace LNLib;
+
+// Arguments: degree, control points count.
+static void BM_CurveEquallyTessellate(benchmark::State& state)
+{
+	LN_NurbsCurve curve = CreateBenchmarkCurve(state.range(0), state.range(1));
+	for (auto _ : state)
+	{
+		std::vector<XYZ> points;
+		std::vector<double> knots;
+		NurbsCurve::EquallyTessellate(curve, points, knots);
+		benchmark::DoNotOptimize(points.data());
+	}
+}
+BENCHMARK(BM_CurveEquallyTessellate)->ArgsProduct({ {2, 3}, {16, 256} })->Unit(benchmark::kMicrosecond);
+
+static void BM_CurveApproximateLength(benchmark::State& state)
+{
+	LN_NurbsCurve curve = CreateBenchmarkCurve(3, 32);
+	IntegratorType type = static_cast<IntegratorType>(state.range(0));
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(NurbsCurve::ApproximateLength(curve, type));
+	}
+}
+BENCHMARK(BM_CurveApproximateLength)
+	->Arg(static_cast<int>(IntegratorType::Simpson))
+	->Arg(static_cast<int>(IntegratorType::GaussLegendre))
+	->Arg(static_cast<int>(IntegratorType::Chebyshev))
+	->Unit(benchmark::kMicrosecond);
+
+// Macro workload: degree 3 surface with 10 x 10 Bezier patches.
+// Arguments: samples per span.
+static void BM_SurfaceEquallyTessellate(benchmark::State& state)
+{
+	LN_NurbsSurface surface = CreateBenchmarkSurface(3, 13, 13);
+	for (auto _ : state)
+	{
+		std::vector<XYZ> points;
+		std::vector<UV> uvs;
+		NurbsSurface::EquallyTessellate(surface, state.range(0), points, uvs);
+		benchmark::DoNotOptimize(points.data());
+	}
+}
+BENCHMARK(BM_SurfaceEquallyTessellate)->Arg(8)->Arg(32)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// Arguments: chord tolerance in 1E-4 units.
+static void BM_SurfaceTessellate(benchmark::State& state)
+{
+	LN_NurbsSurface surface = CreateBenchmarkSurface(3, 13, 13);
+	double chordTolerance = state.range(0) * 1E-4;
+	for (auto _ : state)
+	{
+		LN_Mesh mesh;
+		NurbsSurface::Tessellate(surface, chordTolerance, 0.2, mesh);
+		benchmark::DoNotOptimize(mesh.Vertices.data());
+	}
+}
+BENCHMARK(BM_SurfaceTessellate)->Arg(10)->Arg(100)->Unit(benchmark::kMillisecond);
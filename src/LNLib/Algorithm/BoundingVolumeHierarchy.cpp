@@ -0,0 +1,291 @@
+/*
+ * Author:
+ * 2024/10/14 - Yuqing Liang (BIMCoder Liang)
+ * bim.frankliang@foxmail.com
+ * 微信公众号：BIMCoder梁老师
+ *
+ * Use of this source code is governed by a GPL-3.0 license that can be found in
+ * the LICENSE file.
+ */
+
+#include "BoundingVolumeHierarchy.h"
+#include "XYZ.h"
+#include <algorithm>
+
+namespace LNLib
+{
+	const int LeafItemCount = 4;
+
+	LN_BoundingBox MergeBoxes(const LN_BoundingBox& first, const LN_BoundingBox& second)
+	{
+		LN_BoundingBox box;
+		box.Min = XYZ(std::min(first.Min.GetX(), second.Min.GetX()), std::min(first.Min.GetY(), second.Min.GetY()), std::min(first.Min.GetZ(), second.Min.GetZ()));
+		box.Max = XYZ(std::max(first.Max.GetX(), second.Max.GetX()), std::max(first.Max.GetY(), second.Max.GetY()), std::max(first.Max.GetZ(), second.Max.GetZ()));
+		return box;
+	}
+}
+
+void LNLib::BoundingVolumeHierarchy::Build(const std::vector<LN_BoundingBox>& boxes)
+{
+	_nodes.clear();
+	_items.resize(boxes.size());
+	for (int i = 0; i < boxes.size(); i++)
+	{
+		_items[i] = i;
+	}
+	if (boxes.empty())
+	{
+		return;
+	}
+	_nodes.reserve(2 * boxes.size() / LeafItemCount + 1);
+	BuildNode(boxes, 0, boxes.size());
+}
+
+bool LNLib::BoundingVolumeHierarchy::IsEmpty() const
+{
+	return _nodes.empty();
+}
+
+int LNLib::BoundingVolumeHierarchy::BuildNode(const std::vector<LN_BoundingBox>& boxes, int start, int end)
+{
+	int index = _nodes.size();
+	_nodes.emplace_back();
+
+	LN_BoundingBox box = boxes[_items[start]];
+	for (int i = start + 1; i < end; i++)
+	{
+		box = MergeBoxes(box, boxes[_items[i]]);
+	}
+	_nodes[index].Box = box;
+	_nodes[index].Start = start;
+	_nodes[index].Count = end - start;
+	_nodes[index].Left = -1;
+	_nodes[index].Right = -1;
+
+	if (end - start <= LeafItemCount)
+	{
+		return index;
+	}
+
+	XYZ extent = box.Max - box.Min;
+	int axis = 0;
+	if (extent[1] > extent[axis]) axis = 1;
+	if (extent[2] > extent[axis]) axis = 2;
+
+	int middle = (start + end) / 2;
+	std::nth_element(_items.begin() + start, _items.begin() + middle, _items.begin() + end,
+		[&boxes, axis](int a, int b)
+		{
+			return boxes[a].Min[axis] + boxes[a].Max[axis] < boxes[b].Min[axis] + boxes[b].Max[axis];
+		});
+
+	int left = BuildNode(boxes, start, middle);
+	int right = BuildNode(boxes, middle, end);
+	_nodes[index].Left = left;
+	_nodes[index].Right = right;
+	return index;
+}
+
+double LNLib::BoundingVolumeHierarchy::SqrDistance(const LN_BoundingBox& box, const XYZ& point)
+{
+	double result = 0.0;
+	for (int i = 0; i < 3; i++)
+	{
+		double value = point[i];
+		if (value < box.Min[i])
+		{
+			result += (box.Min[i] - value) * (box.Min[i] - value);
+		}
+		else if (value > box.Max[i])
+		{
+			result += (value - box.Max[i]) * (value - box.Max[i]);
+		}
+	}
+	return result;
+}
+
+bool LNLib::BoundingVolumeHierarchy::IsOverlapped(const LN_BoundingBox& first, const LN_BoundingBox& second, double tolerance)
+{
+	for (int i = 0; i < 3; i++)
+	{
+		if (first.Min[i] > second.Max[i] + tolerance || second.Min[i] > first.Max[i] + tolerance)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+int LNLib::BoundingVolumeHierarchy::FindNearest(const XYZ& point, ItemDistanceFunction& function, double& minDistance) const
+{
+	minDistance = Constants::MaxDistance;
+	if (_nodes.empty())
+	{
+		return -1;
+	}
+
+	int result = -1;
+	double minSqrDistance = minDistance * minDistance;
+	std::vector<int> stack;
+	stack.emplace_back(0);
+	while (!stack.empty())
+	{
+		const Node& node = _nodes[stack.back()];
+		stack.pop_back();
+		if (SqrDistance(node.Box, point) >= minSqrDistance)
+		{
+			continue;
+		}
+		if (node.Left < 0)
+		{
+			for (int i = node.Start; i < node.Start + node.Count; i++)
+			{
+				double distance = function(_items[i], point);
+				if (distance < minDistance)
+				{
+					minDistance = distance;
+					minSqrDistance = distance * distance;
+					result = _items[i];
+				}
+			}
+			continue;
+		}
+
+		double leftDistance = SqrDistance(_nodes[node.Left].Box, point);
+		double rightDistance = SqrDistance(_nodes[node.Right].Box, point);
+		if (leftDistance < rightDistance)
+		{
+			stack.emplace_back(node.Right);
+			stack.emplace_back(node.Left);
+		}
+		else
+		{
+			stack.emplace_back(node.Left);
+			stack.emplace_back(node.Right);
+		}
+	}
+	return result;
+}
+
+bool LNLib::BoundingVolumeHierarchy::IntersectRay(const LN_BoundingBox& box, const XYZ& origin, const XYZ& direction, double tolerance, double& entryParam, double& exitParam)
+{
+	entryParam = 0.0;
+	exitParam = Constants::MaxDistance;
+	for (int i = 0; i < 3; i++)
+	{
+		double min = box.Min[i] - tolerance;
+		double max = box.Max[i] + tolerance;
+		if (direction[i] == 0.0)
+		{
+			if (origin[i] < min || origin[i] > max)
+			{
+				return false;
+			}
+			continue;
+		}
+		double first = (min - origin[i]) / direction[i];
+		double second = (max - origin[i]) / direction[i];
+		if (first > second)
+		{
+			std::swap(first, second);
+		}
+		entryParam = std::max(entryParam, first);
+		exitParam = std::min(exitParam, second);
+		if (entryParam > exitParam)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+int LNLib::BoundingVolumeHierarchy::FindFirstHit(const XYZ& origin, const XYZ& direction, double tolerance, ItemRayFunction& function, double& hitParam) const
+{
+	hitParam = Constants::MaxDistance;
+	if (_nodes.empty())
+	{
+		return -1;
+	}
+
+	int result = -1;
+	double entry = 0.0;
+	double exit = 0.0;
+	std::vector<std::pair<double, int>> stack;
+	if (IntersectRay(_nodes[0].Box, origin, direction, tolerance, entry, exit))
+	{
+		stack.emplace_back(entry, 0);
+	}
+	while (!stack.empty())
+	{
+		std::pair<double, int> top = stack.back();
+		stack.pop_back();
+		if (top.first >= hitParam)
+		{
+			continue;
+		}
+		const Node& node = _nodes[top.second];
+		if (node.Left < 0)
+		{
+			for (int i = node.Start; i < node.Start + node.Count; i++)
+			{
+				double param = 0.0;
+				if (function(_items[i], origin, direction, hitParam, param) && param < hitParam)
+				{
+					hitParam = param;
+					result = _items[i];
+				}
+			}
+			continue;
+		}
+
+		double leftEntry = 0.0;
+		double rightEntry = 0.0;
+		bool isLeftHit = IntersectRay(_nodes[node.Left].Box, origin, direction, tolerance, leftEntry, exit);
+		bool isRightHit = IntersectRay(_nodes[node.Right].Box, origin, direction, tolerance, rightEntry, exit);
+		if (isLeftHit && isRightHit && leftEntry > rightEntry)
+		{
+			stack.emplace_back(leftEntry, node.Left);
+			stack.emplace_back(rightEntry, node.Right);
+			continue;
+		}
+		if (isRightHit)
+		{
+			stack.emplace_back(rightEntry, node.Right);
+		}
+		if (isLeftHit)
+		{
+			stack.emplace_back(leftEntry, node.Left);
+		}
+	}
+	return result;
+}
+
+void LNLib::BoundingVolumeHierarchy::FindOverlaps(const LN_BoundingBox& box, double tolerance, std::vector<int>& items) const
+{
+	if (_nodes.empty())
+	{
+		return;
+	}
+
+	std::vector<int> stack;
+	stack.emplace_back(0);
+	while (!stack.empty())
+	{
+		const Node& node = _nodes[stack.back()];
+		stack.pop_back();
+		if (!IsOverlapped(node.Box, box, tolerance))
+		{
+			continue;
+		}
+		if (node.Left < 0)
+		{
+			for (int i = node.Start; i < node.Start + node.Count; i++)
+			{
+				items.emplace_back(_items[i]);
+			}
+			continue;
+		}
+		stack.emplace_back(node.Right);
+		stack.emplace_back(node.Left);
+	}
+}
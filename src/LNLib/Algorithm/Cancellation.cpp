@@ -0,0 +1,65 @@
+/*
+ * Author:
+ * 2024/10/14 - Yuqing Liang (BIMCoder Liang)
+ * bim.frankliang@foxmail.com
+ * 微信公众号：BIMCoder梁老师
+ *
+ * Use of this source code is governed by a GPL-3.0 license that can be found in
+ * the LICENSE file.
+ */
+
+#include "Cancellation.h"
+#include <chrono>
+#include <limits>
+
+namespace LNLib
+{
+	namespace
+	{
+		const long long NoDeadline = std::numeric_limits<long long>::max();
+
+		long long GetSteadyNanoseconds()
+		{
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+	}
+}
+
+LNLib::OperationCancelledException::OperationCancelledException() : std::runtime_error("Operation was cancelled.")
+{
+}
+
+LNLib::CancellationToken::CancellationToken() : _isCancelled(false), _deadline(NoDeadline)
+{
+}
+
+void LNLib::CancellationToken::Cancel()
+{
+	_isCancelled.store(true);
+}
+
+void LNLib::CancellationToken::SetTimeBudget(long long milliseconds)
+{
+	long long now = GetSteadyNanoseconds();
+	long long budget = milliseconds > 0 ? milliseconds : 0;
+	long long maxBudget = (NoDeadline - now) / 1000000;
+	_deadline.store(budget >= maxBudget ? NoDeadline : now + budget * 1000000);
+}
+
+bool LNLib::CancellationToken::IsCancelled() const
+{
+	if (_isCancelled.load(std::memory_order_relaxed))
+	{
+		return true;
+	}
+	long long deadline = _deadline.load(std::memory_order_relaxed);
+	return deadline != NoDeadline && GetSteadyNanoseconds() >= deadline;
+}
+
+void LNLib::CancellationToken::ThrowIfCancelled(const CancellationToken* token)
+{
+	if (token != nullptr && token->IsCancelled())
+	{
+		throw OperationCancelledException();
+	}
+}
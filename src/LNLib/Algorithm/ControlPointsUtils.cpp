@@ -11,9 +11,68 @@
 #include "ControlPointsUtils.h"
 #include "XYZ.h"
 #include "XYZW.h"
+#include "MathUtils.h"
 #include "LNLibExceptions.h"
 #include <algorithm>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LNLIB_CONTROLPOINTSUTILS_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace LNLib
+{
+	const int PointsBlockSize = 64;
+
+	/// <summary>
+	/// Row of result += row of points * block of coefficient, the inner loop runs along a row of coefficient and result.
+	/// </summary>
+	void MultiplyPointsBlock(const XYZW* points, const double* coefficient, int coefficientStride, XYZW* result, int depth, int columns)
+	{
+		for (int k = 0; k < depth; k++)
+		{
+			const XYZW& point = points[k];
+			const double* coefficientRow = coefficient + k * coefficientStride;
+#ifdef LNLIB_CONTROLPOINTSUTILS_SSE2
+			__m128d xy = _mm_loadu_pd(&point[0]);
+			__m128d zw = _mm_loadu_pd(&point[2]);
+			for (int j = 0; j < columns; j++)
+			{
+				__m128d factor = _mm_set1_pd(coefficientRow[j]);
+				XYZW& sum = result[j];
+				_mm_storeu_pd(&sum[0], _mm_add_pd(_mm_loadu_pd(&sum[0]), _mm_mul_pd(factor, xy)));
+				_mm_storeu_pd(&sum[2], _mm_add_pd(_mm_loadu_pd(&sum[2]), _mm_mul_pd(factor, zw)));
+			}
+#else
+			for (int j = 0; j < columns; j++)
+			{
+				result[j] += coefficientRow[j] * point;
+			}
+#endif
+		}
+	}
+
+	void ToFlatPoints(const std::vector<std::vector<XYZW>>& points, std::vector<XYZW>& result)
+	{
+		int columns = points[0].size();
+		result.resize(points.size() * columns);
+		for (int i = 0; i < points.size(); i++)
+		{
+			std::copy(points[i].begin(), points[i].begin() + columns, result.begin() + i * columns);
+		}
+	}
+
+	std::vector<std::vector<XYZW>> ToNestedPoints(const std::vector<XYZW>& points, int columnCount)
+	{
+		std::vector<std::vector<XYZW>> result(points.size() / columnCount);
+		for (int i = 0; i < result.size(); i++)
+		{
+			result[i].assign(points.begin() + i * columnCount, points.begin() + (i + 1) * columnCount);
+		}
+		return result;
+	}
+}
+
 using namespace LNLib;
 
 std::vector<XYZ> LNLib::ControlPointsUtils::ToXYZ(const std::vector<XYZW>& weightedControlPoints)
@@ -21,7 +80,7 @@ std::vector<XYZ> LNLib::ControlPointsUtils::ToXYZ(const std::vector<XYZW>& weigh
 	std::vector<XYZ> result;
 	for (int i = 0; i < weightedControlPoints.size(); i++)
 	{
-		result.emplace_back(const_cast<XYZW&>(weightedControlPoints[i]).ToXYZ(true));
+		result.emplace_back(weightedControlPoints[i].ToXYZ(true));
 	}
 	return result;
 }
@@ -36,7 +95,7 @@ std::vector<std::vector<XYZ>> LNLib::ControlPointsUtils::ToXYZ(const std::vector
 	{
 		for (int j = 0; j < column; j++)
 		{
-			result[i][j] = const_cast<XYZW&>(points[i][j]).ToXYZ(true);
+			result[i][j] = points[i][j].ToXYZ(true);
 		}
 	}
 	return result;
@@ -60,40 +119,218 @@ std::vector<std::vector<XYZW>> LNLib::ControlPointsUtils::ToXYZW(const std::vect
 
 std::vector<std::vector<XYZW>> LNLib::ControlPointsUtils::Multiply(const std::vector<std::vector<XYZW>>& points, const std::vector<std::vector<double>>& coefficient)
 {
-	int m = points.size();
-	int n = points[0].size();
-	int p = coefficient[0].size();
+	std::vector<XYZW> flatPoints;
+	ToFlatPoints(points, flatPoints);
+	LN_Matrix flatCoefficient;
+	MathUtils::ToFlatMatrix(coefficient, flatCoefficient);
+
+	std::vector<XYZW> result;
+	Multiply(flatPoints, flatCoefficient, result);
+	return ToNestedPoints(result, flatCoefficient.ColumnCount);
+}
+
+std::vector<std::vector<XYZW>> LNLib::ControlPointsUtils::Multiply(const std::vector<std::vector<double>>& coefficient, const std::vector<std::vector<XYZW>>& points)
+{
+	LN_Matrix flatCoefficient;
+	MathUtils::ToFlatMatrix(coefficient, flatCoefficient);
+	std::vector<XYZW> flatPoints;
+	ToFlatPoints(points, flatPoints);
+
+	std::vector<XYZW> result;
+	int columnCount = points[0].size();
+	Multiply(flatCoefficient, flatPoints, columnCount, result);
+	return ToNestedPoints(result, columnCount);
+}
+
+void LNLib::ControlPointsUtils::Multiply(const LN_Matrix& coefficient, const std::vector<XYZW>& points, int columnCount, std::vector<XYZW>& result)
+{
+	static_assert(sizeof(XYZW) == 4 * sizeof(double), "XYZW must be four packed doubles.");
+	VALIDATE_ARGUMENT(columnCount > 0 && coefficient.ColumnCount > 0 && points.size() == coefficient.ColumnCount * columnCount, "points", "Points must be a net of coefficient column count rows.");
+
+	result.resize(coefficient.RowCount * columnCount);
+	if (result.empty())
+	{
+		return;
+	}
+	MathUtils::MatrixMultiply(coefficient.Elements.data(), &points[0][0], coefficient.RowCount, coefficient.ColumnCount, 4 * columnCount, &result[0][0]);
+}
+
+void LNLib::ControlPointsUtils::Multiply(const std::vector<XYZW>& points, const LN_Matrix& coefficient, std::vector<XYZW>& result)
+{
+	int depth = coefficient.RowCount;
+	int columns = coefficient.ColumnCount;
+	VALIDATE_ARGUMENT(depth > 0 && points.size() % depth == 0, "points", "Points must be a net of coefficient row count columns.");
 
-	std::vector<std::vector<XYZW>> result(m, std::vector<XYZW>(p));
-	for (int i = 0; i < m; i++)
+	int rows = points.size() / depth;
+	result.assign(rows * columns, XYZW(0, 0, 0, 0));
+	for (int i = 0; i < rows; i++)
 	{
-		for (int j = 0; j < p; j++)
+		for (int kk = 0; kk < depth; kk += PointsBlockSize)
 		{
-			for (int k = 0; k < n; k++)
+			int blockDepth = std::min(PointsBlockSize, depth - kk);
+			for (int jj = 0; jj < columns; jj += PointsBlockSize)
 			{
-				result[i][j] += points[i][k] * coefficient[k][j];
+				int blockColumns = std::min(PointsBlockSize, columns - jj);
+				MultiplyPointsBlock(&points[i * depth + kk], coefficient.Elements.data() + kk * columns + jj, columns, &result[i * columns + jj], blockDepth, blockColumns);
 			}
 		}
 	}
-	return result;
 }
 
-std::vector<std::vector<XYZW>> LNLib::ControlPointsUtils::Multiply(const std::vector<std::vector<double>>& coefficient, const std::vector<std::vector<XYZW>>& points)
+LNLib::LN_BoundingBox LNLib::ControlPointsUtils::ComputeBoundingBox(const std::vector<XYZ>& points)
+{
+	VALIDATE_ARGUMENT(points.size() > 0, "points", "Points must not be empty.");
+
+	LN_BoundingBox box;
+	box.Min = points[0];
+	box.Max = points[0];
+	for (int i = 1; i < points.size(); i++)
+	{
+		for (int k = 0; k < 3; k++)
+		{
+			box.Min[k] = std::min(box.Min[k], points[i][k]);
+			box.Max[k] = std::max(box.Max[k], points[i][k]);
+		}
+	}
+	return box;
+}
+
+LNLib::LN_BoundingBox LNLib::ControlPointsUtils::ComputeBoundingBox(const std::vector<XYZW>& weightedControlPoints)
+{
+	return ComputeBoundingBox(ToXYZ(weightedControlPoints));
+}
+
+LNLib::LN_BoundingBox LNLib::ControlPointsUtils::ComputeBoundingBox(const std::vector<std::vector<XYZW>>& weightedControlPoints)
+{
+	VALIDATE_ARGUMENT(weightedControlPoints.size() > 0, "weightedControlPoints", "Control points must not be empty.");
+
+	LN_BoundingBox box = ComputeBoundingBox(weightedControlPoints[0]);
+	for (int i = 1; i < weightedControlPoints.size(); i++)
+	{
+		LN_BoundingBox rowBox = ComputeBoundingBox(weightedControlPoints[i]);
+		for (int k = 0; k < 3; k++)
+		{
+			box.Min[k] = std::min(box.Min[k], rowBox.Min[k]);
+			box.Max[k] = std::max(box.Max[k], rowBox.Max[k]);
+		}
+	}
+	return box;
+}
+
+void LNLib::ControlPointsUtils::ToArrays(const std::vector<XYZW>& points, LN_ControlPointArrays& arrays)
+{
+	int size = points.size();
+	arrays.WX.resize(size);
+	arrays.WY.resize(size);
+	arrays.WZ.resize(size);
+	arrays.W.resize(size);
+	for (int i = 0; i < size; i++)
+	{
+		const XYZW& point = points[i];
+		arrays.WX[i] = point.GetWX();
+		arrays.WY[i] = point.GetWY();
+		arrays.WZ[i] = point.GetWZ();
+		arrays.W[i] = point.GetW();
+	}
+}
+
+void LNLib::ControlPointsUtils::ToArrays(const std::vector<std::vector<XYZW>>& points, LN_ControlPointArrays& arrays)
+{
+	int rows = points.size();
+	int columns = rows > 0 ? points[0].size() : 0;
+	int size = rows * columns;
+	arrays.WX.resize(size);
+	arrays.WY.resize(size);
+	arrays.WZ.resize(size);
+	arrays.W.resize(size);
+	for (int i = 0; i < rows; i++)
+	{
+		VALIDATE_ARGUMENT(points[i].size() == columns, "points", "Points rows must have the same size.");
+		for (int j = 0; j < columns; j++)
+		{
+			const XYZW& point = points[i][j];
+			int index = i * columns + j;
+			arrays.WX[index] = point.GetWX();
+			arrays.WY[index] = point.GetWY();
+			arrays.WZ[index] = point.GetWZ();
+			arrays.W[index] = point.GetW();
+		}
+	}
+}
+
+int LNLib::ControlPointsUtils::DecomposeToBeziers(int degree, const std::vector<double>& knotVector, const XYZW* controlPoints, int lanes, XYZW* beziers, double* domains)
 {
-	int m = coefficient.size();
-	int n = coefficient[0].size();
-	int p = points[0].size();
+	int stride = (degree + 1) * lanes;
+	int m = knotVector.size() - 1;
+	int a = degree;
+	int b = degree + 1;
+	int nb = 0;
 
-	std::vector<std::vector<XYZW>> result(m, std::vector<XYZW>(p));
-	for (int i = 0; i < m; i++)
+	for (int i = 0; i < stride; i++)
 	{
-		for (int j = 0; j < p; j++)
+		beziers[i] = controlPoints[i];
+	}
+
+	std::vector<double> alphaVector(degree + 1);
+	while (b < m)
+	{
+		int i = b;
+		while (b < m && MathUtils::IsAlmostEqualTo(knotVector[b + 1], knotVector[b]))
+		{
+			b++;
+		}
+		int multi = b - i + 1;
+		XYZW* current = beziers + nb * stride;
+		XYZW* next = current + stride;
+		if (multi < degree)
+		{
+			double numerator = knotVector[b] - knotVector[a];
+			for (int j = degree; j > multi; j--)
+			{
+				alphaVector[j - multi - 1] = numerator / (knotVector[a + j] - knotVector[a]);
+			}
+
+			int r = degree - multi;
+			for (int j = 1; j <= r; j++)
+			{
+				int save = r - j;
+				int s = multi + j;
+				for (int k = degree; k >= s; k--)
+				{
+					double alpha = alphaVector[k - s];
+					for (int l = 0; l < lanes; l++)
+					{
+						current[k * lanes + l] = alpha * current[k * lanes + l] + (1.0 - alpha) * current[(k - 1) * lanes + l];
+					}
+				}
+				if (b < m)
+				{
+					for (int l = 0; l < lanes; l++)
+					{
+						next[save * lanes + l] = current[degree * lanes + l];
+					}
+				}
+			}
+		}
+
+		if (domains != nullptr)
+		{
+			domains[2 * nb] = knotVector[a];
+			domains[2 * nb + 1] = knotVector[b];
+		}
+		nb++;
+		if (b < m)
 		{
-			for (int k = 0; k < n; k++)
+			for (int k = degree - multi; k <= degree; k++)
 			{
-				result[i][j] += coefficient[i][k] * points[k][j];
+				for (int l = 0; l < lanes; l++)
+				{
+					next[k * lanes + l] = controlPoints[(b - degree + k) * lanes + l];
+				}
 			}
+			a = b;
+			b++;
 		}
 	}
-	return result;
-}
\ No newline at end of file
+	return nb;
+}
@@ -0,0 +1,501 @@
+/*
+ * Author:
+ * 2024/10/14 - Yuqing Liang (BIMCoder Liang)
+ * bim.frankliang@foxmail.com
+ * 微信公众号：BIMCoder梁老师
+ *
+ * Use of this source code is governed by a GPL-3.0 license that can be found in
+ * the LICENSE file.
+ */
+
+#include "GeometryStore.h"
+#include "ControlPointsUtils.h"
+#include "XYZ.h"
+#include "XYZW.h"
+#include "LNLibExceptions.h"
+#include <cstring>
+#include <cstdint>
+#include <climits>
+#include <fstream>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace LNLib
+{
+	namespace
+	{
+		static_assert(sizeof(XYZW) == 4 * sizeof(double), "Stored control points are viewed as XYZW.");
+
+		const unsigned char Magic[4] = { 'L', 'N', 'L', 'B' };
+		const unsigned int BoundsFlag = 1;
+		const size_t HeaderSize = 32;
+		const size_t CurveRecordSize = 32;
+		const size_t SurfaceRecordSize = 48;
+
+		bool IsLittleEndianHost()
+		{
+			const unsigned int one = 1;
+			return *reinterpret_cast<const unsigned char*>(&one) == 1;
+		}
+
+		void WriteUInt32(unsigned char* destination, uint32_t value)
+		{
+			for (int i = 0; i < 4; i++)
+			{
+				destination[i] = static_cast<unsigned char>(value >> (8 * i));
+			}
+		}
+
+		void WriteUInt64(unsigned char* destination, uint64_t value)
+		{
+			for (int i = 0; i < 8; i++)
+			{
+				destination[i] = static_cast<unsigned char>(value >> (8 * i));
+			}
+		}
+
+		void WriteDouble(unsigned char* destination, double value)
+		{
+			uint64_t bits;
+			std::memcpy(&bits, &value, sizeof(double));
+			WriteUInt64(destination, bits);
+		}
+
+		/// <summary>
+		/// Records are only read on little-endian hosts, so fields are copied as they are.
+		/// </summary>
+		uint32_t ReadUInt32(const unsigned char* source)
+		{
+			uint32_t value;
+			std::memcpy(&value, source, sizeof(value));
+			return value;
+		}
+
+		uint64_t ReadUInt64(const unsigned char* source)
+		{
+			uint64_t value;
+			std::memcpy(&value, source, sizeof(value));
+			return value;
+		}
+
+		void WriteXYZW(unsigned char* destination, const XYZW& point)
+		{
+			WriteDouble(destination, point.GetWX());
+			WriteDouble(destination + 8, point.GetWY());
+			WriteDouble(destination + 16, point.GetWZ());
+			WriteDouble(destination + 24, point.GetW());
+		}
+
+		void WriteBounds(unsigned char* destination, const LN_BoundingBox& box)
+		{
+			for (int c = 0; c < 3; c++)
+			{
+				WriteDouble(destination + 8 * c, box.Min[c]);
+				WriteDouble(destination + 24 + 8 * c, box.Max[c]);
+			}
+		}
+
+		/// <summary>
+		/// True when count doubles at offset lie inside size bytes and are aligned.
+		/// </summary>
+		bool IsValidArray(uint64_t offset, uint64_t count, size_t size)
+		{
+			return offset % 8 == 0 && offset <= size && count <= (size - offset) / 8;
+		}
+
+		/// <summary>
+		/// Stored counts and degrees are handed out as int.
+		/// </summary>
+		bool IsValidCount(uint64_t count)
+		{
+			return count <= static_cast<uint64_t>(INT_MAX);
+		}
+
+		/// <summary>
+		/// Bounds offsets are zero when absent, otherwise they must address six doubles whether or not the header flag is set.
+		/// </summary>
+		bool IsValidBounds(uint64_t offset, bool hasBounds, size_t size)
+		{
+			if (offset == 0)
+			{
+				return !hasBounds;
+			}
+			return offset >= HeaderSize && IsValidArray(offset, 6, size);
+		}
+
+		/// <summary>
+		/// Span search on stored knots needs a nondecreasing sequence.
+		/// </summary>
+		bool IsNondecreasing(const unsigned char* data, uint64_t offset, uint64_t count)
+		{
+			const double* knots = reinterpret_cast<const double*>(data + offset);
+			for (uint64_t k = 1; k < count; k++)
+			{
+				if (!(knots[k - 1] <= knots[k]))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+	}
+}
+
+void LNLib::GeometryStore::Write(const std::vector<LN_NurbsCurve>& curves, const std::vector<LN_NurbsSurface>& surfaces, bool includeBounds, std::vector<unsigned char>& buffer)
+{
+	int curveCount = curves.size();
+	int surfaceCount = surfaces.size();
+	uint64_t offset = HeaderSize + CurveRecordSize * curveCount + SurfaceRecordSize * surfaceCount;
+
+	std::vector<uint64_t> dataOffsets(curveCount + surfaceCount);
+	for (int i = 0; i < curveCount; i++)
+	{
+		const LN_NurbsCurve& curve = curves[i];
+		VALIDATE_ARGUMENT(curve.KnotVector.size() == curve.ControlPoints.size() + curve.Degree + 1, "curves", "Arguments must fit: m = n + p + 1");
+		dataOffsets[i] = offset;
+		offset += 8 * (curve.KnotVector.size() + 4 * curve.ControlPoints.size() + (includeBounds ? 6 : 0));
+	}
+	for (int i = 0; i < surfaceCount; i++)
+	{
+		const LN_NurbsSurface& surface = surfaces[i];
+		int rows = surface.ControlPoints.size();
+		int columns = rows > 0 ? surface.ControlPoints[0].size() : 0;
+		VALIDATE_ARGUMENT(surface.KnotVectorU.size() == rows + surface.DegreeU + 1, "surfaces", "Arguments must fit: m = n + p + 1");
+		VALIDATE_ARGUMENT(surface.KnotVectorV.size() == columns + surface.DegreeV + 1, "surfaces", "Arguments must fit: m = n + p + 1");
+		dataOffsets[curveCount + i] = offset;
+		offset += 8 * (surface.KnotVectorU.size() + surface.KnotVectorV.size() + 4 * rows * columns + (includeBounds ? 6 : 0));
+	}
+
+	buffer.assign(offset, 0);
+	unsigned char* data = buffer.data();
+	std::memcpy(data, Magic, 4);
+	WriteUInt32(data + 4, Version);
+	WriteUInt32(data + 8, includeBounds ? BoundsFlag : 0);
+	WriteUInt32(data + 12, curveCount);
+	WriteUInt32(data + 16, surfaceCount);
+
+	unsigned char* record = data + HeaderSize;
+	for (int i = 0; i < curveCount; i++, record += CurveRecordSize)
+	{
+		const LN_NurbsCurve& curve = curves[i];
+		int knotCount = curve.KnotVector.size();
+		int controlPointCount = curve.ControlPoints.size();
+		uint64_t knotsOffset = dataOffsets[i];
+		uint64_t pointsOffset = knotsOffset + 8 * knotCount;
+		uint64_t boundsOffset = pointsOffset + 32 * controlPointCount;
+
+		WriteUInt32(record, curve.Degree);
+		WriteUInt32(record + 4, knotCount);
+		WriteUInt32(record + 8, controlPointCount);
+		WriteUInt64(record + 16, knotsOffset);
+		WriteUInt64(record + 24, includeBounds ? boundsOffset : 0);
+
+		for (int k = 0; k < knotCount; k++)
+		{
+			WriteDouble(data + knotsOffset + 8 * k, curve.KnotVector[k]);
+		}
+		for (int k = 0; k < controlPointCount; k++)
+		{
+			WriteXYZW(data + pointsOffset + 32 * k, curve.ControlPoints[k]);
+		}
+		if (includeBounds)
+		{
+			WriteBounds(data + boundsOffset, ControlPointsUtils::ComputeBoundingBox(curve.ControlPoints));
+		}
+	}
+	for (int i = 0; i < surfaceCount; i++, record += SurfaceRecordSize)
+	{
+		const LN_NurbsSurface& surface = surfaces[i];
+		int knotCountU = surface.KnotVectorU.size();
+		int knotCountV = surface.KnotVectorV.size();
+		int rows = surface.ControlPoints.size();
+		int columns = rows > 0 ? surface.ControlPoints[0].size() : 0;
+		uint64_t knotsOffset = dataOffsets[curveCount + i];
+		uint64_t pointsOffset = knotsOffset + 8 * (knotCountU + knotCountV);
+		uint64_t boundsOffset = pointsOffset + 32 * rows * columns;
+
+		WriteUInt32(record, surface.DegreeU);
+		WriteUInt32(record + 4, surface.DegreeV);
+		WriteUInt32(record + 8, knotCountU);
+		WriteUInt32(record + 12, knotCountV);
+		WriteUInt32(record + 16, rows);
+		WriteUInt32(record + 20, columns);
+		WriteUInt64(record + 24, knotsOffset);
+		WriteUInt64(record + 32, includeBounds ? boundsOffset : 0);
+
+		for (int k = 0; k < knotCountU; k++)
+		{
+			WriteDouble(data + knotsOffset + 8 * k, surface.KnotVectorU[k]);
+		}
+		for (int k = 0; k < knotCountV; k++)
+		{
+			WriteDouble(data + knotsOffset + 8 * (knotCountU + k), surface.KnotVectorV[k]);
+		}
+		for (int r = 0; r < rows; r++)
+		{
+			VALIDATE_ARGUMENT(surface.ControlPoints[r].size() == columns, "surfaces", "Control point rows must have the same size.");
+			for (int c = 0; c < columns; c++)
+			{
+				WriteXYZW(data + pointsOffset + 32 * (r * columns + c), surface.ControlPoints[r][c]);
+			}
+		}
+		if (includeBounds)
+		{
+			WriteBounds(data + boundsOffset, ControlPointsUtils::ComputeBoundingBox(surface.ControlPoints));
+		}
+	}
+}
+
+bool LNLib::GeometryStore::WriteFile(const std::string& path, const std::vector<LN_NurbsCurve>& curves, const std::vector<LN_NurbsSurface>& surfaces, bool includeBounds)
+{
+	std::vector<unsigned char> buffer;
+	Write(curves, surfaces, includeBounds, buffer);
+	std::ofstream stream(path.c_str(), std::ios::binary | std::ios::trunc);
+	if (!stream)
+	{
+		return false;
+	}
+	stream.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+	return static_cast<bool>(stream);
+}
+
+LNLib::GeometryStore::GeometryStore() : _data(nullptr), _size(0), _curveCount(0), _surfaceCount(0), _mapping(nullptr), _file(nullptr)
+{
+}
+
+LNLib::GeometryStore::~GeometryStore()
+{
+	Close();
+}
+
+bool LNLib::GeometryStore::Open(const void* data, size_t size)
+{
+	Close();
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	if (!IsLittleEndianHost() || bytes == nullptr || reinterpret_cast<uintptr_t>(bytes) % 8 != 0 ||
+		size < HeaderSize || std::memcmp(bytes, Magic, 4) != 0 || ReadUInt32(bytes + 4) != Version)
+	{
+		return false;
+	}
+
+	bool hasBounds = (ReadUInt32(bytes + 8) & BoundsFlag) != 0;
+	uint64_t curveCount = ReadUInt32(bytes + 12);
+	uint64_t surfaceCount = ReadUInt32(bytes + 16);
+	if (!IsValidCount(curveCount) || !IsValidCount(surfaceCount) ||
+		curveCount * CurveRecordSize + surfaceCount * SurfaceRecordSize > size - HeaderSize)
+	{
+		return false;
+	}
+
+	// Every record is checked once here, so views never read outside the memory.
+	const unsigned char* record = bytes + HeaderSize;
+	for (uint64_t i = 0; i < curveCount; i++, record += CurveRecordSize)
+	{
+		uint64_t degree = ReadUInt32(record);
+		uint64_t knotCount = ReadUInt32(record + 4);
+		uint64_t controlPointCount = ReadUInt32(record + 8);
+		uint64_t knotsOffset = ReadUInt64(record + 16);
+		uint64_t boundsOffset = ReadUInt64(record + 24);
+		if (degree == 0 || controlPointCount == 0 || !IsValidCount(knotCount) || knotCount != controlPointCount + degree + 1 ||
+			!IsValidArray(knotsOffset, knotCount + 4 * controlPointCount, size) ||
+			!IsValidBounds(boundsOffset, hasBounds, size) ||
+			!IsNondecreasing(bytes, knotsOffset, knotCount))
+		{
+			return false;
+		}
+	}
+	for (uint64_t i = 0; i < surfaceCount; i++, record += SurfaceRecordSize)
+	{
+		uint64_t degreeU = ReadUInt32(record);
+		uint64_t degreeV = ReadUInt32(record + 4);
+		uint64_t knotCountU = ReadUInt32(record + 8);
+		uint64_t knotCountV = ReadUInt32(record + 12);
+		uint64_t rows = ReadUInt32(record + 16);
+		uint64_t columns = ReadUInt32(record + 20);
+		uint64_t knotsOffset = ReadUInt64(record + 24);
+		uint64_t boundsOffset = ReadUInt64(record + 32);
+		// Factors are bounded by the memory size before they are multiplied, so the products can not wrap.
+		uint64_t maxPoints = size / 32;
+		if (degreeU == 0 || degreeV == 0 || rows == 0 || columns == 0 ||
+			rows > maxPoints || columns > maxPoints / rows ||
+			!IsValidCount(knotCountU) || !IsValidCount(knotCountV) ||
+			knotCountU != rows + degreeU + 1 || knotCountV != columns + degreeV + 1 ||
+			!IsValidArray(knotsOffset, knotCountU + knotCountV + 4 * rows * columns, size) ||
+			!IsValidBounds(boundsOffset, hasBounds, size) ||
+			!IsNondecreasing(bytes, knotsOffset, knotCountU) ||
+			!IsNondecreasing(bytes, knotsOffset + 8 * knotCountU, knotCountV))
+		{
+			return false;
+		}
+	}
+
+	_data = bytes;
+	_size = size;
+	_curveCount = static_cast<int>(curveCount);
+	_surfaceCount = static_cast<int>(surfaceCount);
+	return true;
+}
+
+bool LNLib::GeometryStore::OpenFile(const std::string& path)
+{
+	Close();
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	LARGE_INTEGER fileSize;
+	HANDLE mapping = nullptr;
+	const void* view = nullptr;
+	if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0)
+	{
+		mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping != nullptr)
+		{
+			view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		}
+	}
+	if (view == nullptr || !Open(view, static_cast<size_t>(fileSize.QuadPart)))
+	{
+		if (view != nullptr) UnmapViewOfFile(view);
+		if (mapping != nullptr) CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+	_mapping = mapping;
+	_file = file;
+	return true;
+#else
+	int file = open(path.c_str(), O_RDONLY);
+	if (file < 0)
+	{
+		return false;
+	}
+	struct stat status;
+	void* view = MAP_FAILED;
+	if (fstat(file, &status) == 0 && status.st_size > 0)
+	{
+		view = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+	}
+	// The mapping stays valid after the descriptor is closed.
+	close(file);
+	if (view == MAP_FAILED)
+	{
+		return false;
+	}
+	size_t size = static_cast<size_t>(status.st_size);
+	if (!Open(view, size))
+	{
+		munmap(view, size);
+		return false;
+	}
+	_mapping = view;
+	return true;
+#endif
+}
+
+void LNLib::GeometryStore::Close()
+{
+	if (_mapping != nullptr)
+	{
+#ifdef _WIN32
+		UnmapViewOfFile(_data);
+		CloseHandle(static_cast<HANDLE>(_mapping));
+		CloseHandle(static_cast<HANDLE>(_file));
+#else
+		munmap(_mapping, _size);
+#endif
+	}
+	_data = nullptr;
+	_size = 0;
+	_curveCount = 0;
+	_surfaceCount = 0;
+	_mapping = nullptr;
+	_file = nullptr;
+}
+
+bool LNLib::GeometryStore::IsOpen() const
+{
+	return _data != nullptr;
+}
+
+int LNLib::GeometryStore::GetCurveCount() const
+{
+	return _curveCount;
+}
+
+int LNLib::GeometryStore::GetSurfaceCount() const
+{
+	return _surfaceCount;
+}
+
+LNLib::LN_StoredNurbsCurve LNLib::GeometryStore::GetCurveView(int index) const
+{
+	VALIDATE_ARGUMENT_RANGE(index, 0, _curveCount - 1);
+	const unsigned char* record = _data + HeaderSize + CurveRecordSize * index;
+	uint64_t boundsOffset = ReadUInt64(record + 24);
+	const double* knots = reinterpret_cast<const double*>(_data + ReadUInt64(record + 16));
+
+	LN_StoredNurbsCurve view;
+	view.Degree = ReadUInt32(record);
+	view.KnotCount = ReadUInt32(record + 4);
+	view.ControlPointCount = ReadUInt32(record + 8);
+	view.KnotVector = knots;
+	view.ControlPoints = reinterpret_cast<const XYZW*>(knots + view.KnotCount);
+	view.Bounds = boundsOffset == 0 ? nullptr : reinterpret_cast<const double*>(_data + boundsOffset);
+	return view;
+}
+
+LNLib::LN_StoredNurbsSurface LNLib::GeometryStore::GetSurfaceView(int index) const
+{
+	VALIDATE_ARGUMENT_RANGE(index, 0, _surfaceCount - 1);
+	const unsigned char* record = _data + HeaderSize + CurveRecordSize * _curveCount + SurfaceRecordSize * index;
+	uint64_t boundsOffset = ReadUInt64(record + 32);
+	const double* knots = reinterpret_cast<const double*>(_data + ReadUInt64(record + 24));
+
+	LN_StoredNurbsSurface view;
+	view.DegreeU = ReadUInt32(record);
+	view.DegreeV = ReadUInt32(record + 4);
+	view.KnotCountU = ReadUInt32(record + 8);
+	view.KnotCountV = ReadUInt32(record + 12);
+	view.Rows = ReadUInt32(record + 16);
+	view.Columns = ReadUInt32(record + 20);
+	view.KnotVectorU = knots;
+	view.KnotVectorV = knots + view.KnotCountU;
+	view.ControlPoints = reinterpret_cast<const XYZW*>(knots + view.KnotCountU + view.KnotCountV);
+	view.Bounds = boundsOffset == 0 ? nullptr : reinterpret_cast<const double*>(_data + boundsOffset);
+	return view;
+}
+
+void LNLib::GeometryStore::GetCurve(int index, LN_NurbsCurve& curve) const
+{
+	LN_StoredNurbsCurve view = GetCurveView(index);
+	curve.Degree = view.Degree;
+	curve.KnotVector.assign(view.KnotVector, view.KnotVector + view.KnotCount);
+	curve.ControlPoints.assign(view.ControlPoints, view.ControlPoints + view.ControlPointCount);
+}
+
+void LNLib::GeometryStore::GetSurface(int index, LN_NurbsSurface& surface) const
+{
+	LN_StoredNurbsSurface view = GetSurfaceView(index);
+	surface.DegreeU = view.DegreeU;
+	surface.DegreeV = view.DegreeV;
+	surface.KnotVectorU.assign(view.KnotVectorU, view.KnotVectorU + view.KnotCountU);
+	surface.KnotVectorV.assign(view.KnotVectorV, view.KnotVectorV + view.KnotCountV);
+	surface.ControlPoints.resize(view.Rows);
+	for (int i = 0; i < view.Rows; i++)
+	{
+		surface.ControlPoints[i].assign(view.ControlPoints + i * view.Columns, view.ControlPoints + (i + 1) * view.Columns);
+	}
+}
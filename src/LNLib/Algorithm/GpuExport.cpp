@@ -0,0 +1,411 @@
+/*
+ * Author:
+ * 2024/10/14 - Yuqing Liang (BIMCoder Liang)
+ * bim.frankliang@foxmail.com
+ * 微信公众号：BIMCoder梁老师
+ *
+ * Use of this source code is governed by a GPL-3.0 license that can be found in
+ * the LICENSE file.
+ */
+
+#include "GpuExport.h"
+#include "NurbsCurve.h"
+#include "NurbsSurface.h"
+#include "XYZW.h"
+#include "LNLibExceptions.h"
+#include <algorithm>
+#include <cmath>
+
+namespace LNLib
+{
+	namespace
+	{
+		const char* const CurveShaderSource = R"(#version 430
+layout(local_size_x = 64) in;
+
+layout(std430, binding = 0) readonly buffer BreakBuffer { float breaks[]; };
+layout(std430, binding = 1) readonly buffer ControlPointBuffer { vec4 controlPoints[]; };
+layout(std430, binding = 2) readonly buffer ParamBuffer { float params[]; };
+layout(std430, binding = 3) writeonly buffer PointBuffer { vec4 points[]; };
+
+uniform int Degree;
+uniform int Count;
+uniform int ParamCount;
+
+const int MaxDegree = 15;
+
+void Bernstein(int degree, float t, out float basis[MaxDegree + 1], out float derivatives[MaxDegree + 1])
+{
+	float s = 1.0 - t;
+	basis[0] = 1.0;
+	for (int j = 1; j < degree; j++)
+	{
+		float saved = 0.0;
+		for (int k = 0; k < j; k++)
+		{
+			float temp = basis[k];
+			basis[k] = saved + s * temp;
+			saved = t * temp;
+		}
+		basis[j] = saved;
+	}
+	for (int k = 0; k <= degree; k++)
+	{
+		float left = k > 0 ? basis[k - 1] : 0.0;
+		float right = k < degree ? basis[k] : 0.0;
+		derivatives[k] = float(degree) * (left - right);
+	}
+	float saved = 0.0;
+	for (int k = 0; k < degree; k++)
+	{
+		float temp = basis[k];
+		basis[k] = saved + s * temp;
+		saved = t * temp;
+	}
+	basis[degree] = saved;
+}
+
+void main()
+{
+	int i = int(gl_GlobalInvocationID.x);
+	if (i >= ParamCount) return;
+
+	float t = clamp(params[i], breaks[0], breaks[Count]);
+	int low = 0;
+	int high = Count;
+	while (high - low > 1)
+	{
+		int mid = (low + high) / 2;
+		if (t < breaks[mid]) high = mid; else low = mid;
+	}
+	float local = (t - breaks[low]) / (breaks[low + 1] - breaks[low]);
+
+	float basis[MaxDegree + 1];
+	float derivatives[MaxDegree + 1];
+	Bernstein(Degree, local, basis, derivatives);
+
+	vec4 a = vec4(0.0);
+	int first = low * (Degree + 1);
+	for (int k = 0; k <= Degree; k++)
+	{
+		a += basis[k] * controlPoints[first + k];
+	}
+	points[i] = vec4(a.xyz / a.w, 1.0);
+}
+)";
+
+		const char* const SurfaceShaderSource = R"(#version 430
+layout(local_size_x = 64) in;
+
+layout(std430, binding = 0) readonly buffer BreakUBuffer { float breaksU[]; };
+layout(std430, binding = 1) readonly buffer BreakVBuffer { float breaksV[]; };
+layout(std430, binding = 2) readonly buffer ControlPointBuffer { vec4 controlPoints[]; };
+layout(std430, binding = 3) readonly buffer ParamBuffer { vec2 uvs[]; };
+layout(std430, binding = 4) writeonly buffer PointBuffer { vec4 points[]; };
+layout(std430, binding = 5) writeonly buffer NormalBuffer { vec4 normals[]; };
+
+uniform int DegreeU;
+uniform int DegreeV;
+uniform int CountU;
+uniform int CountV;
+uniform int ParamCount;
+
+const int MaxDegree = 15;
+
+void Bernstein(int degree, float t, out float basis[MaxDegree + 1], out float derivatives[MaxDegree + 1])
+{
+	float s = 1.0 - t;
+	basis[0] = 1.0;
+	for (int j = 1; j < degree; j++)
+	{
+		float saved = 0.0;
+		for (int k = 0; k < j; k++)
+		{
+			float temp = basis[k];
+			basis[k] = saved + s * temp;
+			saved = t * temp;
+		}
+		basis[j] = saved;
+	}
+	for (int k = 0; k <= degree; k++)
+	{
+		float left = k > 0 ? basis[k - 1] : 0.0;
+		float right = k < degree ? basis[k] : 0.0;
+		derivatives[k] = float(degree) * (left - right);
+	}
+	float saved = 0.0;
+	for (int k = 0; k < degree; k++)
+	{
+		float temp = basis[k];
+		basis[k] = saved + s * temp;
+		saved = t * temp;
+	}
+	basis[degree] = saved;
+}
+
+void main()
+{
+	int i = int(gl_GlobalInvocationID.x);
+	if (i >= ParamCount) return;
+
+	float u = clamp(uvs[i].x, breaksU[0], breaksU[CountU]);
+	int lowU = 0;
+	int highU = CountU;
+	while (highU - lowU > 1)
+	{
+		int mid = (lowU + highU) / 2;
+		if (u < breaksU[mid]) highU = mid; else lowU = mid;
+	}
+	float v = clamp(uvs[i].y, breaksV[0], breaksV[CountV]);
+	int lowV = 0;
+	int highV = CountV;
+	while (highV - lowV > 1)
+	{
+		int mid = (lowV + highV) / 2;
+		if (v < breaksV[mid]) highV = mid; else lowV = mid;
+	}
+
+	float basisU[MaxDegree + 1];
+	float derivativesU[MaxDegree + 1];
+	Bernstein(DegreeU, (u - breaksU[lowU]) / (breaksU[lowU + 1] - breaksU[lowU]), basisU, derivativesU);
+	float basisV[MaxDegree + 1];
+	float derivativesV[MaxDegree + 1];
+	Bernstein(DegreeV, (v - breaksV[lowV]) / (breaksV[lowV + 1] - breaksV[lowV]), basisV, derivativesV);
+
+	vec4 a = vec4(0.0);
+	vec4 au = vec4(0.0);
+	vec4 av = vec4(0.0);
+	int first = (lowU * CountV + lowV) * (DegreeU + 1) * (DegreeV + 1);
+	for (int k = 0; k <= DegreeU; k++)
+	{
+		for (int l = 0; l <= DegreeV; l++)
+		{
+			vec4 point = controlPoints[first + k * (DegreeV + 1) + l];
+			a += basisU[k] * basisV[l] * point;
+			au += derivativesU[k] * basisV[l] * point;
+			av += basisU[k] * derivativesV[l] * point;
+		}
+	}
+
+	vec3 position = a.xyz / a.w;
+	vec3 su = (au.xyz - au.w * position) / a.w;
+	vec3 sv = (av.xyz - av.w * position) / a.w;
+	vec3 normal = cross(su, sv);
+	float normalLength = length(normal);
+	points[i] = vec4(position, 1.0);
+	normals[i] = normalLength > 0.0 ? vec4(normal / normalLength, 0.0) : vec4(0.0);
+}
+)";
+
+		/// <summary>
+		/// Bernstein basis and derivatives of degree at t, the same steps as Bernstein of the shaders.
+		/// </summary>
+		void GpuBernstein(int degree, float t, float* basis, float* derivatives)
+		{
+			float s = 1.0f - t;
+			basis[0] = 1.0f;
+			for (int j = 1; j < degree; j++)
+			{
+				float saved = 0.0f;
+				for (int k = 0; k < j; k++)
+				{
+					float temp = basis[k];
+					basis[k] = saved + s * temp;
+					saved = t * temp;
+				}
+				basis[j] = saved;
+			}
+			for (int k = 0; k <= degree; k++)
+			{
+				float left = k > 0 ? basis[k - 1] : 0.0f;
+				float right = k < degree ? basis[k] : 0.0f;
+				derivatives[k] = static_cast<float>(degree) * (left - right);
+			}
+			float saved = 0.0f;
+			for (int k = 0; k < degree; k++)
+			{
+				float temp = basis[k];
+				basis[k] = saved + s * temp;
+				saved = t * temp;
+			}
+			basis[degree] = saved;
+		}
+
+		/// <summary>
+		/// Clamps t to the breaks and returns its segment, t becomes the local parameter in [0, 1].
+		/// </summary>
+		int FindGpuSegment(const std::vector<float>& breaks, int count, float& t)
+		{
+			t = std::max(breaks[0], std::min(breaks[count], t));
+			int low = 0;
+			int high = count;
+			while (high - low > 1)
+			{
+				int mid = (low + high) / 2;
+				if (t < breaks[mid]) high = mid; else low = mid;
+			}
+			t = (t - breaks[low]) / (breaks[low + 1] - breaks[low]);
+			return low;
+		}
+
+		void PackControlPoints(const std::vector<XYZW>& controlPoints, std::vector<float>& result)
+		{
+			result.resize(4 * controlPoints.size());
+			for (int i = 0; i < controlPoints.size(); i++)
+			{
+				const XYZW& point = controlPoints[i];
+				result[4 * i] = static_cast<float>(point.GetWX());
+				result[4 * i + 1] = static_cast<float>(point.GetWY());
+				result[4 * i + 2] = static_cast<float>(point.GetWZ());
+				result[4 * i + 3] = static_cast<float>(point.GetW());
+			}
+		}
+	}
+}
+
+void LNLib::GpuExport::Pack(const LN_NurbsCurve& curve, LN_GpuCurveBuffer& buffer)
+{
+	VALIDATE_ARGUMENT_RANGE(curve.Degree, 1, MaxDegree);
+	LN_BezierSegmentArray segments;
+	NurbsCurve::DecomposeToBeziers(curve, segments);
+
+	buffer.Degree = segments.Degree;
+	buffer.Count = segments.Count;
+	buffer.Breaks.resize(segments.Count + 1);
+	for (int s = 0; s < segments.Count; s++)
+	{
+		buffer.Breaks[s] = static_cast<float>(segments.Domains[2 * s]);
+	}
+	buffer.Breaks[segments.Count] = static_cast<float>(segments.Domains[2 * segments.Count - 1]);
+	PackControlPoints(segments.ControlPoints, buffer.ControlPoints);
+}
+
+void LNLib::GpuExport::Pack(const LN_NurbsSurface& surface, LN_GpuSurfaceBuffer& buffer)
+{
+	VALIDATE_ARGUMENT_RANGE(surface.DegreeU, 1, MaxDegree);
+	VALIDATE_ARGUMENT_RANGE(surface.DegreeV, 1, MaxDegree);
+	LN_BezierPatchArray patches;
+	NurbsSurface::DecomposeToBeziers(surface, patches);
+
+	int countU = patches.CountU;
+	int countV = patches.CountV;
+	buffer.DegreeU = patches.DegreeU;
+	buffer.DegreeV = patches.DegreeV;
+	buffer.CountU = countU;
+	buffer.CountV = countV;
+	buffer.BreaksU.resize(countU + 1);
+	buffer.BreaksV.resize(countV + 1);
+	for (int i = 0; i < countU; i++)
+	{
+		buffer.BreaksU[i] = static_cast<float>(patches.Domains[4 * i * countV]);
+	}
+	buffer.BreaksU[countU] = static_cast<float>(patches.Domains[4 * (countU - 1) * countV + 1]);
+	for (int j = 0; j < countV; j++)
+	{
+		buffer.BreaksV[j] = static_cast<float>(patches.Domains[4 * j + 2]);
+	}
+	buffer.BreaksV[countV] = static_cast<float>(patches.Domains[4 * (countV - 1) + 3]);
+	PackControlPoints(patches.ControlPoints, buffer.ControlPoints);
+}
+
+const char* LNLib::GpuExport::GetCurveShaderSource()
+{
+	return CurveShaderSource;
+}
+
+const char* LNLib::GpuExport::GetSurfaceShaderSource()
+{
+	return SurfaceShaderSource;
+}
+
+void LNLib::GpuExport::EvaluateCurve(const LN_GpuCurveBuffer& buffer, const std::vector<float>& params, std::vector<float>& points)
+{
+	int degree = buffer.Degree;
+	float basis[MaxDegree + 1];
+	float derivatives[MaxDegree + 1];
+
+	int size = params.size();
+	points.resize(4 * size);
+	for (int i = 0; i < size; i++)
+	{
+		float t = params[i];
+		int segment = FindGpuSegment(buffer.Breaks, buffer.Count, t);
+		GpuBernstein(degree, t, basis, derivatives);
+
+		float a[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		const float* controlPoints = &buffer.ControlPoints[4 * segment * (degree + 1)];
+		for (int k = 0; k <= degree; k++)
+		{
+			for (int c = 0; c < 4; c++)
+			{
+				a[c] += basis[k] * controlPoints[4 * k + c];
+			}
+		}
+		for (int c = 0; c < 3; c++)
+		{
+			points[4 * i + c] = a[c] / a[3];
+		}
+		points[4 * i + 3] = 1.0f;
+	}
+}
+
+void LNLib::GpuExport::EvaluateSurface(const LN_GpuSurfaceBuffer& buffer, const std::vector<float>& uvs, std::vector<float>& points, std::vector<float>& normals)
+{
+	VALIDATE_ARGUMENT(uvs.size() % 2 == 0, "uvs", "Uvs must hold two floats per parameter.");
+	int degreeU = buffer.DegreeU;
+	int degreeV = buffer.DegreeV;
+	float basisU[MaxDegree + 1];
+	float derivativesU[MaxDegree + 1];
+	float basisV[MaxDegree + 1];
+	float derivativesV[MaxDegree + 1];
+
+	int size = uvs.size() / 2;
+	points.resize(4 * size);
+	normals.resize(4 * size);
+	for (int i = 0; i < size; i++)
+	{
+		float u = uvs[2 * i];
+		float v = uvs[2 * i + 1];
+		int segmentU = FindGpuSegment(buffer.BreaksU, buffer.CountU, u);
+		int segmentV = FindGpuSegment(buffer.BreaksV, buffer.CountV, v);
+		GpuBernstein(degreeU, u, basisU, derivativesU);
+		GpuBernstein(degreeV, v, basisV, derivativesV);
+
+		float a[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		float au[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		float av[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		const float* controlPoints = &buffer.ControlPoints[4 * (segmentU * buffer.CountV + segmentV) * (degreeU + 1) * (degreeV + 1)];
+		for (int k = 0; k <= degreeU; k++)
+		{
+			for (int l = 0; l <= degreeV; l++)
+			{
+				const float* point = controlPoints + 4 * (k * (degreeV + 1) + l);
+				for (int c = 0; c < 4; c++)
+				{
+					a[c] += basisU[k] * basisV[l] * point[c];
+					au[c] += derivativesU[k] * basisV[l] * point[c];
+					av[c] += basisU[k] * derivativesV[l] * point[c];
+				}
+			}
+		}
+
+		float position[3];
+		float su[3];
+		float sv[3];
+		for (int c = 0; c < 3; c++)
+		{
+			position[c] = a[c] / a[3];
+			su[c] = (au[c] - au[3] * position[c]) / a[3];
+			sv[c] = (av[c] - av[3] * position[c]) / a[3];
+		}
+		float normal[3] = { su[1] * sv[2] - su[2] * sv[1], su[2] * sv[0] - su[0] * sv[2], su[0] * sv[1] - su[1] * sv[0] };
+		float normalLength = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+		for (int c = 0; c < 3; c++)
+		{
+			points[4 * i + c] = position[c];
+			normals[4 * i + c] = normalLength > 0.0f ? normal[c] / normalLength : 0.0f;
+		}
+		points[4 * i + 3] = 1.0f;
+		normals[4 * i + 3] = 0.0f;
+	}
+}
@@ -0,0 +1,173 @@
+/*
+ * Author:
+ * 2024/10/14 - Yuqing Liang (BIMCoder Liang)
+ * bim.frankliang@foxmail.com
+ * 微信公众号：BIMCoder梁老师
+ *
+ * Use of this source code is governed by a GPL-3.0 license that can be found in
+ * the LICENSE file.
+ */
+
+#include "Instrumentation.h"
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <vector>
+#include <sstream>
+
+namespace LNLib
+{
+	namespace
+	{
+		const char* const CounterNames[LN_InstrumentationRecord::CounterCount] =
+		{
+			"Evaluations",
+			"SpanSearches",
+			"LinearSolves",
+			"Allocations",
+			"NewtonIterations",
+		};
+
+		std::atomic<InstrumentationCallback*> RegisteredCallback(nullptr);
+		std::atomic<bool> IsTracing(false);
+		std::mutex TraceMutex;
+		std::vector<LN_InstrumentationRecord> TraceRecords;
+
+		std::atomic<int> NextThreadId(0);
+		thread_local int CurrentThreadId = -1;
+		thread_local ScopedTimer* CurrentScope = nullptr;
+
+		long long GetElapsedMicroseconds()
+		{
+			static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+			return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - epoch).count();
+		}
+
+		int GetCurrentThreadId()
+		{
+			if (CurrentThreadId < 0)
+			{
+				CurrentThreadId = NextThreadId.fetch_add(1);
+			}
+			return CurrentThreadId;
+		}
+
+		void WriteEscaped(std::ostringstream& stream, const char* text)
+		{
+			for (const char* c = text; *c != '\0'; c++)
+			{
+				if (*c == '"' || *c == '\\')
+				{
+					stream << '\\';
+				}
+				stream << *c;
+			}
+		}
+	}
+}
+
+void LNLib::Instrumentation::SetCallback(InstrumentationCallback* callback)
+{
+	RegisteredCallback.store(callback);
+}
+
+void LNLib::Instrumentation::BeginChromeTrace()
+{
+	std::lock_guard<std::mutex> lock(TraceMutex);
+	TraceRecords.clear();
+	IsTracing.store(true);
+}
+
+std::string LNLib::Instrumentation::EndChromeTrace()
+{
+	std::vector<LN_InstrumentationRecord> records;
+	{
+		std::lock_guard<std::mutex> lock(TraceMutex);
+		IsTracing.store(false);
+		records.swap(TraceRecords);
+	}
+
+	std::ostringstream stream;
+	stream << "{\"traceEvents\":[";
+	for (int i = 0; i < records.size(); i++)
+	{
+		const LN_InstrumentationRecord& record = records[i];
+		stream << (i == 0 ? "\n" : ",\n");
+		stream << "{\"name\":\"";
+		WriteEscaped(stream, record.Name);
+		stream << "\",\"cat\":\"LNLib\",\"ph\":\"X\",\"pid\":1,\"tid\":" << record.ThreadId;
+		stream << ",\"ts\":" << record.StartTime << ",\"dur\":" << record.Duration << ",\"args\":{";
+		for (int k = 0; k < LN_InstrumentationRecord::CounterCount; k++)
+		{
+			stream << (k == 0 ? "\"" : ",\"") << CounterNames[k] << "\":" << record.Counters[k];
+		}
+		stream << "}}";
+	}
+	stream << "\n],\"displayTimeUnit\":\"ms\"}\n";
+	return stream.str();
+}
+
+bool LNLib::Instrumentation::IsEnabled()
+{
+	return RegisteredCallback.load() != nullptr || IsTracing.load();
+}
+
+void LNLib::Instrumentation::Count(InstrumentationCounter counter, long long amount)
+{
+	ScopedTimer* scope = CurrentScope;
+	if (scope != nullptr)
+	{
+		scope->_record.Counters[static_cast<int>(counter)] += amount;
+	}
+}
+
+LNLib::ScopedTimer::ScopedTimer(const char* name) : _isActive(Instrumentation::IsEnabled()), _parent(nullptr)
+{
+	if (!_isActive)
+	{
+		return;
+	}
+	_parent = CurrentScope;
+	_record.Name = name;
+	_record.ThreadId = GetCurrentThreadId();
+	_record.Depth = _parent == nullptr ? 0 : _parent->_record.Depth + 1;
+	_record.Duration = 0;
+	for (int k = 0; k < LN_InstrumentationRecord::CounterCount; k++)
+	{
+		_record.Counters[k] = 0;
+	}
+	_record.StartTime = GetElapsedMicroseconds();
+	CurrentScope = this;
+}
+
+LNLib::ScopedTimer::~ScopedTimer()
+{
+	if (!_isActive)
+	{
+		return;
+	}
+	_record.Duration = GetElapsedMicroseconds() - _record.StartTime;
+	CurrentScope = _parent;
+	if (_parent != nullptr)
+	{
+		for (int k = 0; k < LN_InstrumentationRecord::CounterCount; k++)
+		{
+			_parent->_record.Counters[k] += _record.Counters[k];
+		}
+	}
+
+	InstrumentationCallback* callback = RegisteredCallback.load();
+	if (callback != nullptr)
+	{
+		(*callback)(_record);
+	}
+	if (IsTracing.load())
+	{
+		// EndChromeTrace may have run since the check, the flag is read again under the lock.
+		std::lock_guard<std::mutex> lock(TraceMutex);
+		if (IsTracing.load())
+		{
+			TraceRecords.emplace_back(_record);
+		}
+	}
+}
@@ -11,9 +11,46 @@
 #include "Integrator.h"
 #include "FFT.h"
 #include "Constants.h"
+#include "LNLibExceptions.h"
+#include "Instrumentation.h"
+#include <algorithm>
 
 namespace LNLib
 {
+    const int GaussKronrodPointCount = 15;
+
+    struct KronrodInterval
+    {
+        double Start;
+        double End;
+        double Value;
+        double Error;
+    };
+
+    struct KronrodIntervalLess
+    {
+        bool operator()(const KronrodInterval& left, const KronrodInterval& right) const
+        {
+            return left.Error < right.Error;
+        }
+    };
+
+    void EvaluateKronrodInterval(IntegrationFunction& function, void* customData, KronrodInterval& interval)
+    {
+        double half = (interval.End - interval.Start) / 2.0;
+        double middle = (interval.Start + interval.End) / 2.0;
+        double kronrod = 0.0;
+        double gauss = 0.0;
+        for (int i = 0; i < GaussKronrodPointCount; i++)
+        {
+            double value = (function)(middle + half * Integrator::GaussKronrodAbscissae[i], customData);
+            kronrod += Integrator::GaussKronrodWeights[i] * value;
+            gauss += Integrator::GaussKronrodGaussWeights[i] * value;
+        }
+        interval.Value = half * kronrod;
+        interval.Error = fabs(half * (kronrod - gauss));
+    }
+
     double Integrator::Simpson(IntegrationFunction& function, void* customData, double start, double end)
     {
         double st = (function)(start, customData);
@@ -22,7 +59,7 @@ namespace LNLib
         double result = ((end - start) / 6.0) * (st + 4 * mt + et);
         return result;
     }
-    double Integrator::Simpson(double start, double end, std::vector<double> odds, std::vector<double> evens, double delta)
+    double Integrator::Simpson(double start, double end, const std::vector<double>& odds, const std::vector<double>& evens, double delta)
 	{
 		double oddsSum = 0.0;
 		double evensSum = 0.0;
@@ -94,6 +131,163 @@ namespace LNLib
         0.0123412297999871995468056670700372915759,
     };
 
+    const std::vector<double> Integrator::GaussKronrodAbscissae =
+    {
+        -0.991455371120812639206854697526329,
+        -0.949107912342758524526189684047851,
+        -0.864864423359769072789712788640926,
+        -0.741531185599394439863864773280788,
+        -0.586087235467691130294144845693013,
+        -0.405845151377397166906606412076961,
+        -0.207784955007898467600689403773245,
+        0.0,
+        0.207784955007898467600689403773245,
+        0.405845151377397166906606412076961,
+        0.586087235467691130294144845693013,
+        0.741531185599394439863864773280788,
+        0.864864423359769072789712788640926,
+        0.949107912342758524526189684047851,
+        0.991455371120812639206854697526329,
+    };
+
+    const std::vector<double> Integrator::GaussKronrodWeights =
+    {
+        0.022935322010529224963732008058970,
+        0.063092092629978553290700663189204,
+        0.104790010322250183839876322541518,
+        0.140653259715525918745189590510238,
+        0.169004726639267902826583426598550,
+        0.190350578064785409913256402421014,
+        0.204432940075298892414161999234649,
+        0.209482141084727828012999174891714,
+        0.204432940075298892414161999234649,
+        0.190350578064785409913256402421014,
+        0.169004726639267902826583426598550,
+        0.140653259715525918745189590510238,
+        0.104790010322250183839876322541518,
+        0.063092092629978553290700663189204,
+        0.022935322010529224963732008058970,
+    };
+
+    const std::vector<double> Integrator::GaussKronrodGaussWeights =
+    {
+        0.0,
+        0.129484966168869693270611432679082,
+        0.0,
+        0.279705391489276667901467771423780,
+        0.0,
+        0.381830050505118944950369775488975,
+        0.0,
+        0.417959183673469387755102040816327,
+        0.0,
+        0.381830050505118944950369775488975,
+        0.0,
+        0.279705391489276667901467771423780,
+        0.0,
+        0.129484966168869693270611432679082,
+        0.0,
+    };
+
+    double Integrator::GaussKronrod(IntegrationFunction& function, void* customData, const std::vector<double>& breakpoints, double tolerance, int maxEvaluations, double& error, int& evaluations)
+    {
+        LNLIB_SCOPED_TIMER("Integrator::GaussKronrod");
+        VALIDATE_ARGUMENT(breakpoints.size() > 1, "breakpoints", "Breakpoints must contains two values at least.");
+        VALIDATE_ARGUMENT(tolerance > 0.0, "tolerance", "Tolerance must greater than zero.");
+
+        std::vector<KronrodInterval> intervals;
+        intervals.reserve(breakpoints.size() - 1);
+        evaluations = 0;
+        double totalError = 0.0;
+        for (int i = 0; i < breakpoints.size() - 1; i++)
+        {
+            if (breakpoints[i + 1] <= breakpoints[i]) continue;
+            KronrodInterval interval;
+            interval.Start = breakpoints[i];
+            interval.End = breakpoints[i + 1];
+            EvaluateKronrodInterval(function, customData, interval);
+            evaluations += GaussKronrodPointCount;
+            totalError += interval.Error;
+            intervals.emplace_back(interval);
+        }
+        std::make_heap(intervals.begin(), intervals.end(), KronrodIntervalLess());
+
+        while (!intervals.empty() && totalError > tolerance && evaluations + 2 * GaussKronrodPointCount <= maxEvaluations)
+        {
+            KronrodInterval worst = intervals.front();
+            double middle = (worst.Start + worst.End) / 2.0;
+            if (middle <= worst.Start || middle >= worst.End)
+            {
+                // The interval can not be bisected further in double precision.
+                break;
+            }
+            std::pop_heap(intervals.begin(), intervals.end(), KronrodIntervalLess());
+            intervals.pop_back();
+
+            KronrodInterval left = { worst.Start, middle, 0.0, 0.0 };
+            KronrodInterval right = { middle, worst.End, 0.0, 0.0 };
+            EvaluateKronrodInterval(function, customData, left);
+            EvaluateKronrodInterval(function, customData, right);
+            evaluations += 2 * GaussKronrodPointCount;
+            totalError += left.Error + right.Error - worst.Error;
+
+            intervals.emplace_back(left);
+            std::push_heap(intervals.begin(), intervals.end(), KronrodIntervalLess());
+            intervals.emplace_back(right);
+            std::push_heap(intervals.begin(), intervals.end(), KronrodIntervalLess());
+        }
+
+        // Running sums drift, both totals are summed again from the final intervals.
+        double value = 0.0;
+        error = 0.0;
+        for (int i = 0; i < intervals.size(); i++)
+        {
+            value += intervals[i].Value;
+            error += intervals[i].Error;
+        }
+        return value;
+    }
+
+    double Integrator::GaussKronrod(IntegrationFunction& function, void* customData, double start, double end, double tolerance, int maxEvaluations)
+    {
+        std::vector<double> breakpoints = { start, end };
+        double error = 0.0;
+        int evaluations = 0;
+        return GaussKronrod(function, customData, breakpoints, tolerance, maxEvaluations, error, evaluations);
+    }
+
+    void Integrator::GaussLegendreRule(int order, std::vector<double>& abscissae, std::vector<double>& weights)
+    {
+        abscissae.resize(order);
+        weights.resize(order);
+        for (int i = 0; i < (order + 1) / 2; i++)
+        {
+            double x = cos(Constants::Pi * (i + 0.75) / (order + 0.5));
+            double derivative = 0.0;
+            for (int iteration = 0; iteration < 100; iteration++)
+            {
+                double p0 = 1.0;
+                double p1 = x;
+                for (int k = 2; k <= order; k++)
+                {
+                    double p2 = ((2 * k - 1) * x * p1 - (k - 1) * p0) / k;
+                    p0 = p1;
+                    p1 = p2;
+                }
+                derivative = order * (x * p1 - p0) / (x * x - 1.0);
+                double dx = p1 / derivative;
+                x -= dx;
+                if (fabs(dx) < 1E-15)
+                {
+                    break;
+                }
+            }
+            abscissae[i] = -x;
+            abscissae[order - 1 - i] = x;
+            weights[i] = 2.0 / ((1.0 - x * x) * derivative * derivative);
+            weights[order - 1 - i] = weights[i];
+        }
+    }
+
     std::vector<double> Integrator::ChebyshevSeries(int size)
     {
         std::vector<double> series(size);
@@ -141,6 +335,7 @@ namespace LNLib
     }
     double Integrator::ClenshawCurtisQuadrature(IntegrationFunction& function, void* customData, double start, double end, std::vector<double>& series, double epsilon)
     {
+        LNLIB_SCOPED_TIMER("Integrator::ClenshawCurtisQuadrature");
         double integration;
         int j, k, l;
         double err, esf, eref, erefh, hh, ir, iback, irback, ba, ss, x, y, fx, errir;
@@ -196,26 +391,30 @@ namespace LNLib
         }
         return integration;
     }
-    double Integrator::ClenshawCurtisQuadrature2(IntegrationFunction& function, void* customData, double start, double end, std::vector<double> series, double epsilon)
+    double Integrator::ClenshawCurtisQuadrature2(IntegrationFunction& function, void* customData, double start, double end, const std::vector<double>& series, double epsilon)
     {
+        LNLIB_SCOPED_TIMER("Integrator::ClenshawCurtisQuadrature2");
         double integration;
         int j, k, l;
         double err, esf, eref, erefh, hh, ir, iback, irback, ba, ss, x, y, fx, errir;
         int lenw = series.size() - 1;
+        // The Chebyshev table lives at the tail of series and is only read,
+        // the leading entries are scratch and never reach beyond lenw / 2.
+        std::vector<double> work(lenw / 2 + 5);
         esf = 10;
         ba = 0.5 * (end - start);
         ss = 2 * series[lenw];
         x = ba * series[lenw];
-        series[0] = 0.5 * (function)(start, customData);
-        series[3] = 0.5 * (function)(end, customData);
-        series[2] = (function)(start + x, customData);
-        series[4] = (function)(end - x, customData);
-        series[1] = (function)(start + ba, customData);
-        eref = 0.5 * (fabs(series[0]) + fabs(series[1]) + fabs(series[2]) + fabs(series[3]) + fabs(series[4]));
-        series[0] += series[3];
-        series[2] += series[4];
-        ir = series[0] + series[1] + series[2];
-        integration = series[0] * series[lenw - 1] + series[1] * series[lenw - 2] + series[2] * series[lenw - 3];
+        work[0] = 0.5 * (function)(start, customData);
+        work[3] = 0.5 * (function)(end, customData);
+        work[2] = (function)(start + x, customData);
+        work[4] = (function)(end - x, customData);
+        work[1] = (function)(start + ba, customData);
+        eref = 0.5 * (fabs(work[0]) + fabs(work[1]) + fabs(work[2]) + fabs(work[3]) + fabs(work[4]));
+        work[0] += work[3];
+        work[2] += work[4];
+        ir = work[0] + work[1] + work[2];
+        integration = work[0] * series[lenw - 1] + work[1] * series[lenw - 2] + work[2] * series[lenw - 3];
         erefh = eref * sqrt(epsilon);
         eref *= epsilon;
         hh = 0.25;
@@ -226,14 +425,14 @@ namespace LNLib
             irback = ir;
             x = ba * series[k + 1];
             y = 0;
-            integration = series[0] * series[k];
+            integration = work[0] * series[k];
             for (j = 1; j <= l; j++) {
                 x += y;
                 y += ss * (ba - x);
                 fx = (function)(start + x, customData) + (function)(end - x, customData);
                 ir += fx;
-                integration += series[j] * series[k - j] + fx * series[k - j - l];
-                series[j + l] = fx;
+                integration += work[j] * series[k - j] + fx * series[k - j - l];
+                work[j + l] = fx;
             }
             ss = 2 * series[k + 1];
             err = esf * l * fabs(integration - iback);
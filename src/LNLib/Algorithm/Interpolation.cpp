@@ -32,6 +32,12 @@ namespace LNLib
 		double ak = Getak(qk_1, qk, qk1, qk2);
 		return ((1 - ak) * qk + ak * qk1).Normalize();
 	}
+
+	double GetLeastSquaresBasis(int degree, int spanIndex, const std::vector<double>& basis, int index)
+	{
+		int offset = index - (spanIndex - degree);
+		return offset >= 0 && offset <= degree ? basis[offset] : 0.0;
+	}
 }
 
 double LNLib::Interpolation::GetTotalChordLength(const std::vector<XYZ>& throughPoints)
@@ -328,3 +334,87 @@ std::vector<LNLib::XYZ> LNLib::Interpolation::ComputeTangent(const std::vector<X
 	tangents[tangents.size() - 1] = (2 * qq[qq.size() - 1] / delta[delta.size() - 1] - tangents[tangents.size() - 2]).Normalize();
 	return tangents;
 }
+
+std::vector<std::vector<double>> LNLib::Interpolation::CreateCollocationMatrix(int degree, const std::vector<double>& knotVector, const std::vector<double>& params, int& lowerBandwidth, int& upperBandwidth)
+{
+	int size = params.size();
+	int n = size - 1;
+
+	lowerBandwidth = 0;
+	upperBandwidth = 0;
+	std::vector<int> spanIndices(size);
+	KnotSpanCursor cursor(degree, knotVector);
+	for (int i = 1; i < n; i++)
+	{
+		spanIndices[i] = cursor.Find(params[i]);
+		lowerBandwidth = std::max(lowerBandwidth, i - (spanIndices[i] - degree));
+		upperBandwidth = std::max(upperBandwidth, spanIndices[i] - i);
+	}
+
+	// Nonzero basis functions of row i are contiguous in banded storage and written in place.
+	std::vector<std::vector<double>> band = MathUtils::CreateBandedMatrix(size, lowerBandwidth, upperBandwidth);
+	for (int i = 1; i < n; i++)
+	{
+		int spanIndex = spanIndices[i];
+		Polynomials::BasisFunctions(spanIndex, degree, knotVector, params[i], &band[i][spanIndex - degree - i + lowerBandwidth]);
+	}
+	band[0][lowerBandwidth] = 1.0;
+	band[n][lowerBandwidth] = 1.0;
+	return band;
+}
+
+std::vector<std::vector<double>> LNLib::Interpolation::CreateLeastSquaresNormalMatrix(int degree, const std::vector<double>& knotVector, const std::vector<double>& params, int controlPointsCount, std::vector<int>& spanIndices, std::vector<std::vector<double>>& basis)
+{
+	int m = params.size();
+	int n = controlPointsCount;
+
+	spanIndices.resize(m);
+	basis.resize(m);
+	KnotSpanCursor cursor(degree, knotVector);
+	for (int i = 0; i < m; i++)
+	{
+		spanIndices[i] = cursor.Find(params[i]);
+		basis[i].resize(degree + 1);
+		Polynomials::BasisFunctions(spanIndices[i], degree, knotVector, params[i], basis[i].data());
+	}
+
+	std::vector<std::vector<double>> normal = MathUtils::CreateBandedMatrix(std::max(0, n - 2), degree, 0);
+	for (int i = 1; i <= m - 2; i++)
+	{
+		int spanIndex = spanIndices[i];
+		int first = std::max(1, spanIndex - degree);
+		int last = std::min(n - 2, spanIndex);
+		for (int a = first; a <= last; a++)
+		{
+			double na = basis[i][a - spanIndex + degree];
+			for (int b = first; b <= a; b++)
+			{
+				normal[a - 1][b - a + degree] += na * basis[i][b - spanIndex + degree];
+			}
+		}
+	}
+	return normal;
+}
+
+std::vector<LNLib::XYZ> LNLib::Interpolation::GetLeastSquaresRight(int degree, int controlPointsCount, const std::vector<int>& spanIndices, const std::vector<std::vector<double>>& basis, const std::vector<XYZ>& throughPoints)
+{
+	int m = throughPoints.size();
+	int n = controlPointsCount;
+	const XYZ& first = throughPoints[0];
+	const XYZ& last = throughPoints[m - 1];
+
+	std::vector<XYZ> right(std::max(0, n - 2));
+	for (int k = 1; k <= m - 2; k++)
+	{
+		int spanIndex = spanIndices[k];
+		const std::vector<double>& row = basis[k];
+		XYZ rk = throughPoints[k] - GetLeastSquaresBasis(degree, spanIndex, row, 0) * first - GetLeastSquaresBasis(degree, spanIndex, row, n - 1) * last;
+		int firstIndex = std::max(1, spanIndex - degree);
+		int lastIndex = std::min(n - 2, spanIndex);
+		for (int i = firstIndex; i <= lastIndex; i++)
+		{
+			right[i - 1] += row[i - spanIndex + degree] * rk;
+		}
+	}
+	return right;
+}
@@ -9,9 +9,1551 @@
  */
 
 #include "Intersection.h"
+#include "Constants.h"
 #include "XYZ.h"
+#include "XYZW.h"
 #include "MathUtils.h"
+#include "NurbsCurve.h"
+#include "NurbsSurface.h"
+#include "BoundingVolumeHierarchy.h"
+#include "ControlPointsUtils.h"
+#include "PreparedCurve.h"
+#include "PreparedSurface.h"
 #include "LNLibExceptions.h"
+#include <algorithm>
+
+namespace LNLib
+{
+	const int MaxClippingDepth = 32;
+	const int MaxRefinementIterations = 20;
+	const int MaxMarchingSteps = 10000;
+	const double SeedFlatnessRatio = 1E-2;
+	const double MaxStepRatio = 2E-2;
+	const double MaxTurningAngle = 0.1;
+
+	/// <summary>
+	/// Rational Bezier piece of a curve on [Start, End] with the box of its projected control points.
+	/// </summary>
+	struct BezierSegment
+	{
+		std::vector<XYZW> ControlPoints;
+		double Start;
+		double End;
+		LN_BoundingBox Box;
+	};
+
+	void UpdateSegmentBox(BezierSegment& segment)
+	{
+		segment.Box = ControlPointsUtils::ComputeBoundingBox(segment.ControlPoints);
+	}
+
+	/// <summary>
+	/// Largest distance from inner control points to the chord.
+	/// </summary>
+	double ComputeFlatness(const BezierSegment& segment)
+	{
+		int size = segment.ControlPoints.size();
+		XYZ start = segment.ControlPoints[0].ToXYZ(true);
+		XYZ end = segment.ControlPoints[size - 1].ToXYZ(true);
+		XYZ chord = end - start;
+		double squareLength = chord.DotProduct(chord);
+
+		double flatness = 0.0;
+		for (int i = 1; i < size - 1; i++)
+		{
+			XYZ point = segment.ControlPoints[i].ToXYZ(true);
+			double t = MathUtils::IsAlmostEqualTo(squareLength, 0.0) ? 0.0 : std::max(0.0, std::min(1.0, (point - start).DotProduct(chord) / squareLength));
+			flatness = std::max(flatness, point.Distance(start + chord * t));
+		}
+		return flatness;
+	}
+
+	/// <summary>
+	/// de Casteljau subdivision of one row of control points at the middle in homogeneous coordinates.
+	/// </summary>
+	void SplitControlPoints(const std::vector<XYZW>& controlPoints, std::vector<XYZW>& left, std::vector<XYZW>& right)
+	{
+		int degree = controlPoints.size() - 1;
+		std::vector<XYZW> temp = controlPoints;
+		left.resize(degree + 1);
+		right.resize(degree + 1);
+		left[0] = temp[0];
+		right[degree] = temp[degree];
+		for (int k = 1; k <= degree; k++)
+		{
+			for (int i = 0; i <= degree - k; i++)
+			{
+				temp[i] = 0.5 * (temp[i] + temp[i + 1]);
+			}
+			left[k] = temp[0];
+			right[degree - k] = temp[degree - k];
+		}
+	}
+
+	void SplitSegment(const BezierSegment& segment, BezierSegment& left, BezierSegment& right)
+	{
+		SplitControlPoints(segment.ControlPoints, left.ControlPoints, right.ControlPoints);
+
+		double middle = (segment.Start + segment.End) / 2.0;
+		left.Start = segment.Start;
+		left.End = middle;
+		right.Start = middle;
+		right.End = segment.End;
+		UpdateSegmentBox(left);
+		UpdateSegmentBox(right);
+	}
+
+	/// <summary>
+	/// Closest points of segments [p0,p1] and [q0,q1], s and t in [0,1].
+	/// </summary>
+	void ClosestParamsOfSegments(const XYZ& p0, const XYZ& p1, const XYZ& q0, const XYZ& q1, double& s, double& t)
+	{
+		XYZ d1 = p1 - p0;
+		XYZ d2 = q1 - q0;
+		XYZ r = p0 - q0;
+		double a = d1.DotProduct(d1);
+		double e = d2.DotProduct(d2);
+		double f = d2.DotProduct(r);
+
+		s = 0.0;
+		t = 0.0;
+		if (MathUtils::IsAlmostEqualTo(a, 0.0) && MathUtils::IsAlmostEqualTo(e, 0.0))
+		{
+			return;
+		}
+		if (MathUtils::IsAlmostEqualTo(a, 0.0))
+		{
+			t = std::max(0.0, std::min(1.0, f / e));
+			return;
+		}
+		double c = d1.DotProduct(r);
+		if (MathUtils::IsAlmostEqualTo(e, 0.0))
+		{
+			s = std::max(0.0, std::min(1.0, -c / a));
+			return;
+		}
+		double b = d1.DotProduct(d2);
+		double denominator = a * e - b * b;
+		s = MathUtils::IsAlmostEqualTo(denominator, 0.0) ? 0.5 : std::max(0.0, std::min(1.0, (b * f - c * e) / denominator));
+		t = (b * s + f) / e;
+		if (t < 0.0)
+		{
+			t = 0.0;
+			s = std::max(0.0, std::min(1.0, -c / a));
+		}
+		else if (t > 1.0)
+		{
+			t = 1.0;
+			s = std::max(0.0, std::min(1.0, (b - c) / a));
+		}
+	}
+
+	/// <summary>
+	/// Refined intersection candidate with the distance of both curve points.
+	/// </summary>
+	struct CurveCurveCandidate
+	{
+		LN_CurveCurveIntersection Intersection;
+		double Distance;
+	};
+
+	bool IsCandidateParam0Less(const CurveCurveCandidate& left, const CurveCurveCandidate& right)
+	{
+		return left.Intersection.Param0 < right.Intersection.Param0;
+	}
+
+	class CurveCurveIntersector
+	{
+	public:
+		CurveCurveIntersector(const LN_NurbsCurve& curve0, const LN_NurbsCurve& curve1, double tolerance)
+			: _curve0(NurbsCurve::Check(curve0)), _curve1(NurbsCurve::Check(curve1)), _tolerance(tolerance)
+		{
+		}
+
+		void Intersect(const BezierSegment& segment0, const BezierSegment& segment1, int depth)
+		{
+			if (!BoundingVolumeHierarchy::IsOverlapped(segment0.Box, segment1.Box, _tolerance))
+			{
+				return;
+			}
+
+			bool isFlat0 = ComputeFlatness(segment0) <= _tolerance;
+			bool isFlat1 = ComputeFlatness(segment1) <= _tolerance;
+			if ((isFlat0 && isFlat1) || depth >= MaxClippingDepth)
+			{
+				XYZ start0 = segment0.ControlPoints.front().ToXYZ(true);
+				XYZ end0 = segment0.ControlPoints.back().ToXYZ(true);
+				XYZ start1 = segment1.ControlPoints.front().ToXYZ(true);
+				XYZ end1 = segment1.ControlPoints.back().ToXYZ(true);
+				double s = 0.0;
+				double t = 0.0;
+				ClosestParamsOfSegments(start0, end0, start1, end1, s, t);
+				Refine(segment0.Start + s * (segment0.End - segment0.Start), segment1.Start + t * (segment1.End - segment1.Start));
+
+				// Parallel chords may overlap, their ends bound the coincident stretch.
+				XYZ chord0 = end0 - start0;
+				XYZ chord1 = end1 - start1;
+				if (chord0.CrossProduct(chord1).Length() <= Constants::DoubleEpsilon * chord0.Length() * chord1.Length())
+				{
+					ClosestParamsOfSegments(start0, start0, start1, end1, s, t);
+					Refine(segment0.Start, segment1.Start + t * (segment1.End - segment1.Start));
+					ClosestParamsOfSegments(end0, end0, start1, end1, s, t);
+					Refine(segment0.End, segment1.Start + t * (segment1.End - segment1.Start));
+				}
+				return;
+			}
+
+			const LN_BoundingBox& box0 = segment0.Box;
+			const LN_BoundingBox& box1 = segment1.Box;
+			bool splitFirst = isFlat1 || (!isFlat0 && box0.Min.Distance(box0.Max) >= box1.Min.Distance(box1.Max));
+			BezierSegment left;
+			BezierSegment right;
+			if (splitFirst)
+			{
+				SplitSegment(segment0, left, right);
+				Intersect(left, segment1, depth + 1);
+				Intersect(right, segment1, depth + 1);
+			}
+			else
+			{
+				SplitSegment(segment1, left, right);
+				Intersect(segment0, left, depth + 1);
+				Intersect(segment0, right, depth + 1);
+			}
+		}
+
+		/// <summary>
+		/// Candidates sorted by Param0 are grouped while the curves stay within tolerance halfway between neighbours.
+		/// A group is one contact reported at its closest candidate, or an overlap when it stretches beyond tolerance
+		/// with every candidate far tighter than tolerance (a tangent contact only touches at one point).
+		/// </summary>
+		std::vector<LN_CurveCurveIntersection> GetResults()
+		{
+			std::sort(_candidates.begin(), _candidates.end(), IsCandidateParam0Less);
+			std::vector<LN_CurveCurveIntersection> results;
+			int size = _candidates.size();
+			int start = 0;
+			for (int i = 1; i <= size; i++)
+			{
+				if (i < size && IsConnected(_candidates[i - 1].Intersection, _candidates[i].Intersection)) continue;
+
+				int closest = start;
+				bool isCoincident = true;
+				for (int k = start; k < i; k++)
+				{
+					if (_candidates[k].Distance < _candidates[closest].Distance)
+					{
+						closest = k;
+					}
+					isCoincident = isCoincident && _candidates[k].Distance <= SeedFlatnessRatio * _tolerance;
+				}
+				const LN_CurveCurveIntersection& first = _candidates[start].Intersection;
+				const LN_CurveCurveIntersection& last = _candidates[i - 1].Intersection;
+				if (isCoincident && first.Point.Distance(last.Point) > _tolerance)
+				{
+					LN_CurveCurveIntersection overlap = first;
+					overlap.IsOverlap = true;
+					overlap.EndParam0 = last.Param0;
+					overlap.EndParam1 = last.Param1;
+					results.emplace_back(overlap);
+				}
+				else
+				{
+					results.emplace_back(_candidates[closest].Intersection);
+				}
+				start = i;
+			}
+
+			// A contact on the seam of a closed curve0 shows up at both ends of its domain, the halfway test then wraps around the seam.
+			if (results.size() > 1 && !results.front().IsOverlap && !results.back().IsOverlap && NurbsCurve::IsClosed(_curve0.Curve()))
+			{
+				const std::vector<double>& knotVector0 = _curve0.Curve().KnotVector;
+				double first0 = knotVector0.front();
+				double last0 = knotVector0.back();
+				double middle0 = (results.back().Param0 + results.front().Param0 + last0 - first0) / 2.0;
+				if (middle0 > last0)
+				{
+					middle0 -= last0 - first0;
+				}
+				if (IsCoincidentAt(middle0, (results.front().Param1 + results.back().Param1) / 2.0))
+				{
+					results.pop_back();
+				}
+			}
+			return results;
+		}
+
+	private:
+
+		bool IsCoincidentAt(double param0, double param1)
+		{
+			XYZ point0 = NurbsCurve::GetPointOnCurve(_curve0, param0);
+			XYZ point1 = NurbsCurve::GetPointOnCurve(_curve1, param1);
+			return point0.Distance(point1) <= _tolerance;
+		}
+
+		bool IsConnected(const LN_CurveCurveIntersection& left, const LN_CurveCurveIntersection& right)
+		{
+			return IsCoincidentAt((left.Param0 + right.Param0) / 2.0, (left.Param1 + right.Param1) / 2.0);
+		}
+
+		/// <summary>
+		/// Gauss-Newton iteration on C0(s) - C1(t) = 0, params are clamped to the curve domains.
+		/// </summary>
+		void Refine(double s, double t)
+		{
+			const std::vector<double>& knotVector0 = _curve0.Curve().KnotVector;
+			const std::vector<double>& knotVector1 = _curve1.Curve().KnotVector;
+			double first0 = knotVector0[0];
+			double last0 = knotVector0[knotVector0.size() - 1];
+			double first1 = knotVector1[0];
+			double last1 = knotVector1[knotVector1.size() - 1];
+
+			XYZ ders0[2];
+			XYZ ders1[2];
+			for (int i = 0; i < MaxRefinementIterations; i++)
+			{
+				NurbsCurve::ComputeRationalCurveDerivatives(_curve0, 1, s, _workspace, ders0);
+				NurbsCurve::ComputeRationalCurveDerivatives(_curve1, 1, t, _workspace, ders1);
+				XYZ difference = ders0[0] - ders1[0];
+				if (difference.Length() <= Constants::DoubleEpsilon * _tolerance)
+				{
+					break;
+				}
+
+				XYZ a = ders0[1];
+				XYZ b = -ders1[1];
+				double aa = a.DotProduct(a);
+				double ab = a.DotProduct(b);
+				double bb = b.DotProduct(b);
+				double determinant = aa * bb - ab * ab;
+				if (MathUtils::IsAlmostEqualTo(determinant, 0.0, Constants::DoubleEpsilon * aa * bb))
+				{
+					break;
+				}
+				double fa = a.DotProduct(difference);
+				double fb = b.DotProduct(difference);
+				double ds = (ab * fb - bb * fa) / determinant;
+				double dt = (ab * fa - aa * fb) / determinant;
+
+				double newS = std::max(first0, std::min(last0, s + ds));
+				double newT = std::max(first1, std::min(last1, t + dt));
+				bool isConverged = std::abs(newS - s) <= Constants::DoubleEpsilon * (last0 - first0) &&
+					std::abs(newT - t) <= Constants::DoubleEpsilon * (last1 - first1);
+				s = newS;
+				t = newT;
+				if (isConverged)
+				{
+					break;
+				}
+			}
+
+			XYZ point0 = NurbsCurve::GetPointOnCurve(_curve0, s);
+			XYZ point1 = NurbsCurve::GetPointOnCurve(_curve1, t);
+			double distance = point0.Distance(point1);
+			if (distance > _tolerance)
+			{
+				return;
+			}
+
+			CurveCurveCandidate candidate;
+			candidate.Intersection.Param0 = s;
+			candidate.Intersection.Param1 = t;
+			candidate.Intersection.Point = (point0 + point1) / 2.0;
+			candidate.Intersection.IsOverlap = false;
+			candidate.Intersection.EndParam0 = s;
+			candidate.Intersection.EndParam1 = t;
+			candidate.Distance = distance;
+			_candidates.emplace_back(candidate);
+		}
+
+		LN_CheckedNurbsCurve _curve0;
+		LN_CheckedNurbsCurve _curve1;
+		double _tolerance;
+		LN_DerivativeWorkspace _workspace;
+		std::vector<CurveCurveCandidate> _candidates;
+	};
+
+	std::vector<BezierSegment> CreateBezierSegments(const LN_NurbsCurve& curve)
+	{
+		std::vector<double> uniqueKnots = curve.KnotVector;
+		uniqueKnots.erase(std::unique(uniqueKnots.begin(), uniqueKnots.end()), uniqueKnots.end());
+		std::vector<LN_NurbsCurve> beziers = NurbsCurve::DecomposeToBeziers(curve);
+
+		std::vector<BezierSegment> segments(uniqueKnots.size() - 1);
+		for (int i = 0; i < segments.size(); i++)
+		{
+			segments[i].ControlPoints = beziers[i].ControlPoints;
+			segments[i].Start = uniqueKnots[i];
+			segments[i].End = uniqueKnots[i + 1];
+			UpdateSegmentBox(segments[i]);
+		}
+		return segments;
+	}
+
+	/// <summary>
+	/// Rational Bezier patch of a surface on [StartU, EndU] x [StartV, EndV] with the box of its projected control points.
+	/// </summary>
+	struct BezierPatch
+	{
+		std::vector<std::vector<XYZW>> ControlPoints;
+		double StartU;
+		double EndU;
+		double StartV;
+		double EndV;
+		LN_BoundingBox Box;
+	};
+
+	void UpdatePatchBox(BezierPatch& patch)
+	{
+		patch.Box = ControlPointsUtils::ComputeBoundingBox(patch.ControlPoints);
+	}
+
+	/// <summary>
+	/// Largest distance from control points to the bilinear surface through the corner control points.
+	/// </summary>
+	double ComputePatchFlatness(const BezierPatch& patch)
+	{
+		int degreeU = patch.ControlPoints.size() - 1;
+		int degreeV = patch.ControlPoints[0].size() - 1;
+		XYZ p00 = patch.ControlPoints[0][0].ToXYZ(true);
+		XYZ p10 = patch.ControlPoints[degreeU][0].ToXYZ(true);
+		XYZ p01 = patch.ControlPoints[0][degreeV].ToXYZ(true);
+		XYZ p11 = patch.ControlPoints[degreeU][degreeV].ToXYZ(true);
+
+		double flatness = 0.0;
+		for (int i = 0; i <= degreeU; i++)
+		{
+			double s = static_cast<double>(i) / degreeU;
+			for (int j = 0; j <= degreeV; j++)
+			{
+				double t = static_cast<double>(j) / degreeV;
+				XYZ bilinear = (1.0 - s) * ((1.0 - t) * p00 + t * p01) + s * ((1.0 - t) * p10 + t * p11);
+				XYZ point = patch.ControlPoints[i][j].ToXYZ(true);
+				flatness = std::max(flatness, point.Distance(bilinear));
+			}
+		}
+		return flatness;
+	}
+
+	/// <summary>
+	/// Split along the direction whose boundary control polygons are longer.
+	/// </summary>
+	bool IsLongerInU(const BezierPatch& patch)
+	{
+		int degreeU = patch.ControlPoints.size() - 1;
+		int degreeV = patch.ControlPoints[0].size() - 1;
+		double lengthU = 0.0;
+		for (int i = 1; i <= degreeU; i++)
+		{
+			lengthU += patch.ControlPoints[i][0].ToXYZ(true).Distance(patch.ControlPoints[i - 1][0].ToXYZ(true));
+			lengthU += patch.ControlPoints[i][degreeV].ToXYZ(true).Distance(patch.ControlPoints[i - 1][degreeV].ToXYZ(true));
+		}
+		double lengthV = 0.0;
+		for (int j = 1; j <= degreeV; j++)
+		{
+			lengthV += patch.ControlPoints[0][j].ToXYZ(true).Distance(patch.ControlPoints[0][j - 1].ToXYZ(true));
+			lengthV += patch.ControlPoints[degreeU][j].ToXYZ(true).Distance(patch.ControlPoints[degreeU][j - 1].ToXYZ(true));
+		}
+		return lengthU >= lengthV;
+	}
+
+	void SplitPatch(const BezierPatch& patch, bool isUDirection, BezierPatch& first, BezierPatch& second)
+	{
+		int rows = patch.ControlPoints.size();
+		int columns = patch.ControlPoints[0].size();
+		first.StartU = second.StartU = patch.StartU;
+		first.EndU = second.EndU = patch.EndU;
+		first.StartV = second.StartV = patch.StartV;
+		first.EndV = second.EndV = patch.EndV;
+		first.ControlPoints.resize(rows);
+		second.ControlPoints.resize(rows);
+
+		if (isUDirection)
+		{
+			for (int i = 0; i < rows; i++)
+			{
+				first.ControlPoints[i].resize(columns);
+				second.ControlPoints[i].resize(columns);
+			}
+			std::vector<XYZW> column(rows);
+			std::vector<XYZW> left;
+			std::vector<XYZW> right;
+			for (int j = 0; j < columns; j++)
+			{
+				for (int i = 0; i < rows; i++)
+				{
+					column[i] = patch.ControlPoints[i][j];
+				}
+				SplitControlPoints(column, left, right);
+				for (int i = 0; i < rows; i++)
+				{
+					first.ControlPoints[i][j] = left[i];
+					second.ControlPoints[i][j] = right[i];
+				}
+			}
+			double middle = (patch.StartU + patch.EndU) / 2.0;
+			first.EndU = middle;
+			second.StartU = middle;
+		}
+		else
+		{
+			for (int i = 0; i < rows; i++)
+			{
+				SplitControlPoints(patch.ControlPoints[i], first.ControlPoints[i], second.ControlPoints[i]);
+			}
+			double middle = (patch.StartV + patch.EndV) / 2.0;
+			first.EndV = middle;
+			second.StartV = middle;
+		}
+		UpdatePatchBox(first);
+		UpdatePatchBox(second);
+	}
+
+	std::vector<BezierPatch> CreateBezierPatches(const LN_NurbsSurface& surface)
+	{
+		std::vector<double> uniqueKnotsU = surface.KnotVectorU;
+		uniqueKnotsU.erase(std::unique(uniqueKnotsU.begin(), uniqueKnotsU.end()), uniqueKnotsU.end());
+		std::vector<double> uniqueKnotsV = surface.KnotVectorV;
+		uniqueKnotsV.erase(std::unique(uniqueKnotsV.begin(), uniqueKnotsV.end()), uniqueKnotsV.end());
+		int patchesV = uniqueKnotsV.size() - 1;
+		std::vector<LN_NurbsSurface> beziers = NurbsSurface::DecomposeToBeziers(surface);
+
+		std::vector<BezierPatch> patches((uniqueKnotsU.size() - 1) * patchesV);
+		for (int p = 0; p < patches.size(); p++)
+		{
+			int spanU = p / patchesV;
+			int spanV = p % patchesV;
+			patches[p].ControlPoints = beziers[p].ControlPoints;
+			patches[p].StartU = uniqueKnotsU[spanU];
+			patches[p].EndU = uniqueKnotsU[spanU + 1];
+			patches[p].StartV = uniqueKnotsV[spanV];
+			patches[p].EndV = uniqueKnotsV[spanV + 1];
+			UpdatePatchBox(patches[p]);
+		}
+		return patches;
+	}
+
+	/// <summary>
+	/// Gaussian elimination with partial pivoting, matrix is size x size in row major order and right is overwritten by the solution.
+	/// </summary>
+	bool SolveSmallLinearSystem(double* matrix, double* right, int size)
+	{
+		double scale = 0.0;
+		for (int i = 0; i < size * size; i++)
+		{
+			scale = std::max(scale, std::abs(matrix[i]));
+		}
+		if (MathUtils::IsAlmostEqualTo(scale, 0.0, Constants::DoubleEpsilon * Constants::DoubleEpsilon))
+		{
+			return false;
+		}
+
+		for (int k = 0; k < size; k++)
+		{
+			int pivot = k;
+			for (int i = k + 1; i < size; i++)
+			{
+				if (std::abs(matrix[i * size + k]) > std::abs(matrix[pivot * size + k]))
+				{
+					pivot = i;
+				}
+			}
+			if (std::abs(matrix[pivot * size + k]) <= Constants::DoubleEpsilon * Constants::DoubleEpsilon * scale)
+			{
+				return false;
+			}
+			if (pivot != k)
+			{
+				for (int j = 0; j < size; j++)
+				{
+					std::swap(matrix[k * size + j], matrix[pivot * size + j]);
+				}
+				std::swap(right[k], right[pivot]);
+			}
+			for (int i = k + 1; i < size; i++)
+			{
+				double factor = matrix[i * size + k] / matrix[k * size + k];
+				for (int j = k; j < size; j++)
+				{
+					matrix[i * size + j] -= factor * matrix[k * size + j];
+				}
+				right[i] -= factor * right[k];
+			}
+		}
+		for (int i = size - 1; i >= 0; i--)
+		{
+			double sum = right[i];
+			for (int j = i + 1; j < size; j++)
+			{
+				sum -= matrix[i * size + j] * right[j];
+			}
+			right[i] = sum / matrix[i * size + i];
+		}
+		return true;
+	}
+
+	/// <summary>
+	/// frame[0] is S(u,v), frame[1] is Su and frame[2] is Sv.
+	/// </summary>
+	void ComputeSurfaceFrame(const LN_CheckedNurbsSurface& surface, double u, double v, XYZ* frame)
+	{
+		std::vector<std::vector<XYZ>> derivatives = NurbsSurface::ComputeRationalSurfaceDerivatives(surface, 1, UV(u, v));
+		frame[0] = derivatives[0][0];
+		frame[1] = derivatives[1][0];
+		frame[2] = derivatives[0][1];
+	}
+
+	class CurveSurfaceIntersector
+	{
+	public:
+		CurveSurfaceIntersector(const LN_NurbsCurve& curve, const LN_NurbsSurface& surface, double tolerance)
+			: _curve(NurbsCurve::Check(curve)), _surface(NurbsSurface::Check(surface)), _tolerance(tolerance)
+		{
+		}
+
+		void Intersect(const BezierSegment& segment, const BezierPatch& patch, int depth)
+		{
+			if (!BoundingVolumeHierarchy::IsOverlapped(segment.Box, patch.Box, _tolerance))
+			{
+				return;
+			}
+
+			bool isFlatSegment = ComputeFlatness(segment) <= _tolerance;
+			bool isFlatPatch = ComputePatchFlatness(patch) <= _tolerance;
+			if ((isFlatSegment && isFlatPatch) || depth >= MaxClippingDepth)
+			{
+				EstimateAndRefine(segment, patch);
+				return;
+			}
+
+			double segmentSize = segment.Box.Min.Distance(segment.Box.Max);
+			double patchSize = patch.Box.Min.Distance(patch.Box.Max);
+			if (isFlatPatch || (!isFlatSegment && segmentSize >= patchSize))
+			{
+				BezierSegment left;
+				BezierSegment right;
+				SplitSegment(segment, left, right);
+				Intersect(left, patch, depth + 1);
+				Intersect(right, patch, depth + 1);
+			}
+			else
+			{
+				BezierPatch first;
+				BezierPatch second;
+				SplitPatch(patch, IsLongerInU(patch), first, second);
+				Intersect(segment, first, depth + 1);
+				Intersect(segment, second, depth + 1);
+			}
+		}
+
+		std::vector<LN_CurveSurfaceIntersection>& GetResults()
+		{
+			return _results;
+		}
+
+	private:
+
+		/// <summary>
+		/// Intersect the chord of the segment with the plane of the patch corners for the initial guess.
+		/// </summary>
+		void EstimateAndRefine(const BezierSegment& segment, const BezierPatch& patch)
+		{
+			XYZ start = segment.ControlPoints.front().ToXYZ(true);
+			XYZ end = segment.ControlPoints.back().ToXYZ(true);
+			int degreeU = patch.ControlPoints.size() - 1;
+			int degreeV = patch.ControlPoints[0].size() - 1;
+			XYZ p00 = patch.ControlPoints[0][0].ToXYZ(true);
+			XYZ p10 = patch.ControlPoints[degreeU][0].ToXYZ(true);
+			XYZ p01 = patch.ControlPoints[0][degreeV].ToXYZ(true);
+			XYZ p11 = patch.ControlPoints[degreeU][degreeV].ToXYZ(true);
+
+			XYZ directionU = 0.5 * ((p10 - p00) + (p11 - p01));
+			XYZ directionV = 0.5 * ((p01 - p00) + (p11 - p10));
+			XYZ center = 0.25 * (p00 + p10 + p01 + p11);
+			XYZ normal = directionU.CrossProduct(directionV);
+			XYZ chord = end - start;
+
+			double s = 0.5;
+			double denominator = normal.DotProduct(chord);
+			if (!MathUtils::IsAlmostEqualTo(denominator, 0.0, Constants::DoubleEpsilon * normal.Length() * chord.Length()))
+			{
+				s = std::max(0.0, std::min(1.0, normal.DotProduct(center - start) / denominator));
+			}
+			XYZ point = start + chord * s;
+
+			double u = 0.5;
+			double v = 0.5;
+			double squareLengthU = directionU.DotProduct(directionU);
+			double squareLengthV = directionV.DotProduct(directionV);
+			if (!MathUtils::IsAlmostEqualTo(squareLengthU, 0.0))
+			{
+				u = std::max(0.0, std::min(1.0, 0.5 + (point - center).DotProduct(directionU) / squareLengthU));
+			}
+			if (!MathUtils::IsAlmostEqualTo(squareLengthV, 0.0))
+			{
+				v = std::max(0.0, std::min(1.0, 0.5 + (point - center).DotProduct(directionV) / squareLengthV));
+			}
+
+			Refine(segment.Start + s * (segment.End - segment.Start),
+				patch.StartU + u * (patch.EndU - patch.StartU),
+				patch.StartV + v * (patch.EndV - patch.StartV));
+		}
+
+		/// <summary>
+		/// Newton iteration on C(t) - S(u,v) = 0, params are clamped to the curve and surface domains.
+		/// </summary>
+		void Refine(double t, double u, double v)
+		{
+			const std::vector<double>& knotVector = _curve.Curve().KnotVector;
+			const std::vector<double>& knotVectorU = _surface.Surface().KnotVectorU;
+			const std::vector<double>& knotVectorV = _surface.Surface().KnotVectorV;
+			double firstT = knotVector[0];
+			double lastT = knotVector[knotVector.size() - 1];
+			double firstU = knotVectorU[0];
+			double lastU = knotVectorU[knotVectorU.size() - 1];
+			double firstV = knotVectorV[0];
+			double lastV = knotVectorV[knotVectorV.size() - 1];
+
+			XYZ ders[2];
+			XYZ frame[3];
+			for (int i = 0; i < MaxRefinementIterations; i++)
+			{
+				NurbsCurve::ComputeRationalCurveDerivatives(_curve, 1, t, _workspace, ders);
+				ComputeSurfaceFrame(_surface, u, v, frame);
+				XYZ difference = ders[0] - frame[0];
+				if (difference.Length() <= Constants::DoubleEpsilon * _tolerance)
+				{
+					break;
+				}
+
+				double matrix[9];
+				double right[3];
+				for (int k = 0; k < 3; k++)
+				{
+					matrix[k * 3] = ders[1][k];
+					matrix[k * 3 + 1] = -frame[1][k];
+					matrix[k * 3 + 2] = -frame[2][k];
+					right[k] = -difference[k];
+				}
+				if (!SolveSmallLinearSystem(matrix, right, 3))
+				{
+					break;
+				}
+
+				double newT = std::max(firstT, std::min(lastT, t + right[0]));
+				double newU = std::max(firstU, std::min(lastU, u + right[1]));
+				double newV = std::max(firstV, std::min(lastV, v + right[2]));
+				bool isConverged = std::abs(newT - t) <= Constants::DoubleEpsilon * (lastT - firstT) &&
+					std::abs(newU - u) <= Constants::DoubleEpsilon * (lastU - firstU) &&
+					std::abs(newV - v) <= Constants::DoubleEpsilon * (lastV - firstV);
+				t = newT;
+				u = newU;
+				v = newV;
+				if (isConverged)
+				{
+					break;
+				}
+			}
+
+			XYZ curvePoint = NurbsCurve::GetPointOnCurve(_curve, t);
+			XYZ surfacePoint = NurbsSurface::GetPointOnSurface(_surface, UV(u, v));
+			if (curvePoint.Distance(surfacePoint) > _tolerance)
+			{
+				return;
+			}
+
+			XYZ point = (curvePoint + surfacePoint) / 2.0;
+			for (int i = 0; i < _results.size(); i++)
+			{
+				if (_results[i].Point.Distance(point) <= _tolerance &&
+					MathUtils::IsAlmostEqualTo(_results[i].CurveParam, t, _tolerance * (lastT - firstT)))
+				{
+					return;
+				}
+			}
+			LN_CurveSurfaceIntersection intersection;
+			intersection.CurveParam = t;
+			intersection.SurfaceParam = UV(u, v);
+			intersection.Point = point;
+			_results.emplace_back(intersection);
+		}
+
+		LN_CheckedNurbsCurve _curve;
+		LN_CheckedNurbsSurface _surface;
+		double _tolerance;
+		LN_DerivativeWorkspace _workspace;
+		std::vector<LN_CurveSurfaceIntersection> _results;
+	};
+
+	bool IsCurveParamLess(const LN_CurveSurfaceIntersection& left, const LN_CurveSurfaceIntersection& right)
+	{
+		return left.CurveParam < right.CurveParam;
+	}
+
+	/// <summary>
+	/// Subdivides the patches a ray passes, nearer children first.
+	/// With isNearestOnly only the first hit is kept and patches entered after it are culled.
+	/// </summary>
+	class RaySurfaceIntersector
+	{
+	public:
+		RaySurfaceIntersector(const XYZ& origin, const XYZ& direction, const LN_CheckedNurbsSurface& surface, double tolerance, double maxParam, bool isNearestOnly)
+			: _origin(origin), _direction(direction), _surface(surface), _tolerance(tolerance), _maxParam(maxParam), _isNearestOnly(isNearestOnly)
+		{
+		}
+
+		void Intersect(const BezierPatch& patch, int depth)
+		{
+			double entry = 0.0;
+			double exit = 0.0;
+			if (!BoundingVolumeHierarchy::IntersectRay(patch.Box, _origin, _direction, _tolerance, entry, exit) || entry >= _maxParam)
+			{
+				return;
+			}
+			if (ComputePatchFlatness(patch) <= _tolerance || depth >= MaxClippingDepth)
+			{
+				EstimateAndRefine(patch);
+				return;
+			}
+
+			BezierPatch first;
+			BezierPatch second;
+			SplitPatch(patch, IsLongerInU(patch), first, second);
+			double firstEntry = 0.0;
+			double secondEntry = 0.0;
+			bool isFirstHit = BoundingVolumeHierarchy::IntersectRay(first.Box, _origin, _direction, _tolerance, firstEntry, exit);
+			bool isSecondHit = BoundingVolumeHierarchy::IntersectRay(second.Box, _origin, _direction, _tolerance, secondEntry, exit);
+			if (isFirstHit && isSecondHit && secondEntry < firstEntry)
+			{
+				Intersect(second, depth + 1);
+				Intersect(first, depth + 1);
+				return;
+			}
+			if (isFirstHit)
+			{
+				Intersect(first, depth + 1);
+			}
+			if (isSecondHit)
+			{
+				Intersect(second, depth + 1);
+			}
+		}
+
+		std::vector<LN_RaySurfaceIntersection>& GetResults()
+		{
+			return _results;
+		}
+
+	private:
+
+		/// <summary>
+		/// Intersect the ray with the plane of the patch corners for the initial guess.
+		/// </summary>
+		void EstimateAndRefine(const BezierPatch& patch)
+		{
+			int degreeU = patch.ControlPoints.size() - 1;
+			int degreeV = patch.ControlPoints[0].size() - 1;
+			XYZ p00 = patch.ControlPoints[0][0].ToXYZ(true);
+			XYZ p10 = patch.ControlPoints[degreeU][0].ToXYZ(true);
+			XYZ p01 = patch.ControlPoints[0][degreeV].ToXYZ(true);
+			XYZ p11 = patch.ControlPoints[degreeU][degreeV].ToXYZ(true);
+
+			XYZ directionU = 0.5 * ((p10 - p00) + (p11 - p01));
+			XYZ directionV = 0.5 * ((p01 - p00) + (p11 - p10));
+			XYZ center = 0.25 * (p00 + p10 + p01 + p11);
+			XYZ normal = directionU.CrossProduct(directionV);
+			double squareLength = _direction.DotProduct(_direction);
+
+			// Degenerated corners or a parallel ray start from the point of the ray closest to the patch center.
+			XYZ point = _origin + ((center - _origin).DotProduct(_direction) / squareLength) * _direction;
+			if (!normal.IsZero())
+			{
+				XYZ planeNormal = normal;
+				XYZ lineDirection = _direction;
+				XYZ intersectPoint;
+				LinePlaneIntersectionType type = Intersection::ComputeLineAndPlane(planeNormal, center, _origin, lineDirection, intersectPoint);
+				if (type == LinePlaneIntersectionType::Intersecting)
+				{
+					point = intersectPoint;
+				}
+				else if (type == LinePlaneIntersectionType::On)
+				{
+					point = _origin;
+				}
+			}
+			double t = (point - _origin).DotProduct(_direction) / squareLength;
+
+			double u = 0.5;
+			double v = 0.5;
+			double squareLengthU = directionU.DotProduct(directionU);
+			double squareLengthV = directionV.DotProduct(directionV);
+			if (!MathUtils::IsAlmostEqualTo(squareLengthU, 0.0))
+			{
+				u = std::max(0.0, std::min(1.0, 0.5 + (point - center).DotProduct(directionU) / squareLengthU));
+			}
+			if (!MathUtils::IsAlmostEqualTo(squareLengthV, 0.0))
+			{
+				v = std::max(0.0, std::min(1.0, 0.5 + (point - center).DotProduct(directionV) / squareLengthV));
+			}
+
+			Refine(t, patch.StartU + u * (patch.EndU - patch.StartU), patch.StartV + v * (patch.EndV - patch.StartV));
+		}
+
+		/// <summary>
+		/// Newton iteration on S(u,v) - origin - t * direction = 0, surface params are clamped to the domain.
+		/// </summary>
+		void Refine(double t, double u, double v)
+		{
+			const std::vector<double>& knotVectorU = _surface.Surface().KnotVectorU;
+			const std::vector<double>& knotVectorV = _surface.Surface().KnotVectorV;
+			double firstU = knotVectorU[0];
+			double lastU = knotVectorU[knotVectorU.size() - 1];
+			double firstV = knotVectorV[0];
+			double lastV = knotVectorV[knotVectorV.size() - 1];
+
+			XYZ frame[3];
+			for (int i = 0; i < MaxRefinementIterations; i++)
+			{
+				ComputeSurfaceFrame(_surface, u, v, frame);
+				XYZ difference = frame[0] - (_origin + t * _direction);
+				if (difference.Length() <= Constants::DoubleEpsilon * _tolerance)
+				{
+					break;
+				}
+
+				double matrix[9];
+				double right[3];
+				for (int k = 0; k < 3; k++)
+				{
+					matrix[k * 3] = frame[1][k];
+					matrix[k * 3 + 1] = frame[2][k];
+					matrix[k * 3 + 2] = -_direction[k];
+					right[k] = -difference[k];
+				}
+				if (!SolveSmallLinearSystem(matrix, right, 3))
+				{
+					break;
+				}
+
+				double newU = std::max(firstU, std::min(lastU, u + right[0]));
+				double newV = std::max(firstV, std::min(lastV, v + right[1]));
+				bool isConverged = std::abs(newU - u) <= Constants::DoubleEpsilon * (lastU - firstU) &&
+					std::abs(newV - v) <= Constants::DoubleEpsilon * (lastV - firstV) &&
+					std::abs(right[2]) <= Constants::DoubleEpsilon * std::max(1.0, std::abs(t));
+				u = newU;
+				v = newV;
+				t += right[2];
+				if (isConverged)
+				{
+					break;
+				}
+			}
+
+			XYZ point = NurbsSurface::GetPointOnSurface(_surface, UV(u, v));
+			double squareLength = _direction.DotProduct(_direction);
+			t = (point - _origin).DotProduct(_direction) / squareLength;
+			if (t < 0.0 || t >= _maxParam || point.Distance(_origin + t * _direction) > _tolerance)
+			{
+				return;
+			}
+
+			LN_RaySurfaceIntersection intersection;
+			intersection.RayParam = t;
+			intersection.SurfaceParam = UV(u, v);
+			intersection.Point = point;
+			if (_isNearestOnly)
+			{
+				_maxParam = t;
+				_results.assign(1, intersection);
+				return;
+			}
+			for (int i = 0; i < _results.size(); i++)
+			{
+				if (_results[i].Point.Distance(point) <= _tolerance)
+				{
+					return;
+				}
+			}
+			_results.emplace_back(intersection);
+		}
+
+		XYZ _origin;
+		XYZ _direction;
+		const LN_CheckedNurbsSurface& _surface;
+		double _tolerance;
+		double _maxParam;
+		bool _isNearestOnly;
+		std::vector<LN_RaySurfaceIntersection> _results;
+	};
+
+	bool IsRayParamLess(const LN_RaySurfaceIntersection& left, const LN_RaySurfaceIntersection& right)
+	{
+		return left.RayParam < right.RayParam;
+	}
+
+	/// <summary>
+	/// Subdivides the segments whose box enlarged by tolerance a ray passes and keeps the curve point nearest along the ray.
+	/// </summary>
+	class RayCurveIntersector
+	{
+	public:
+		RayCurveIntersector(const XYZ& origin, const XYZ& direction, const LN_CheckedNurbsCurve& curve, double tolerance, double maxParam)
+			: _origin(origin), _direction(direction), _curve(curve), _tolerance(tolerance), _maxParam(maxParam), _isHit(false)
+		{
+		}
+
+		void Intersect(const BezierSegment& segment, int depth)
+		{
+			double entry = 0.0;
+			double exit = 0.0;
+			if (!BoundingVolumeHierarchy::IntersectRay(segment.Box, _origin, _direction, _tolerance, entry, exit) || entry >= _maxParam)
+			{
+				return;
+			}
+			if (ComputeFlatness(segment) <= _tolerance || depth >= MaxClippingDepth)
+			{
+				XYZ start = segment.ControlPoints.front().ToXYZ(true);
+				XYZ end = segment.ControlPoints.back().ToXYZ(true);
+				double s = 0.0;
+				double t = 0.0;
+				ClosestParamsOfSegments(start, end, _origin + entry * _direction, _origin + exit * _direction, s, t);
+				Refine(segment.Start + s * (segment.End - segment.Start));
+				return;
+			}
+
+			BezierSegment left;
+			BezierSegment right;
+			SplitSegment(segment, left, right);
+			Intersect(left, depth + 1);
+			Intersect(right, depth + 1);
+		}
+
+		bool GetResult(LN_RayCurveIntersection& result) const
+		{
+			if (_isHit)
+			{
+				result = _result;
+			}
+			return _isHit;
+		}
+
+	private:
+
+		/// <summary>
+		/// Newton iteration on the derivative of the squared distance from C(s) to the ray line, s is clamped to the domain.
+		/// </summary>
+		void Refine(double s)
+		{
+			const std::vector<double>& knotVector = _curve.Curve().KnotVector;
+			double first = knotVector[0];
+			double last = knotVector[knotVector.size() - 1];
+			double squareLength = _direction.DotProduct(_direction);
+			XYZ unit = _direction / std::sqrt(squareLength);
+
+			XYZ ders[3];
+			for (int i = 0; i < MaxRefinementIterations; i++)
+			{
+				NurbsCurve::ComputeRationalCurveDerivatives(_curve, 2, s, _workspace, ders);
+				XYZ w = ders[0] - _origin;
+				double along = w.DotProduct(unit);
+				double tangentAlong = ders[1].DotProduct(unit);
+				double gradient = w.DotProduct(ders[1]) - along * tangentAlong;
+				double hessian = ders[1].DotProduct(ders[1]) + w.DotProduct(ders[2]) - tangentAlong * tangentAlong - along * ders[2].DotProduct(unit);
+				if (hessian <= 0.0)
+				{
+					break;
+				}
+				double newS = std::max(first, std::min(last, s - gradient / hessian));
+				bool isConverged = std::abs(newS - s) <= Constants::DoubleEpsilon * (last - first);
+				s = newS;
+				if (isConverged)
+				{
+					break;
+				}
+			}
+
+			XYZ point = NurbsCurve::GetPointOnCurve(_curve, s);
+			double t = (point - _origin).DotProduct(_direction) / squareLength;
+			double distance = point.Distance(_origin + t * _direction);
+			if (t < 0.0 || t >= _maxParam || distance > _tolerance)
+			{
+				return;
+			}
+			_maxParam = t;
+			_isHit = true;
+			_result.RayParam = t;
+			_result.CurveParam = s;
+			_result.Point = point;
+			_result.Distance = distance;
+		}
+
+		XYZ _origin;
+		XYZ _direction;
+		const LN_CheckedNurbsCurve& _curve;
+		double _tolerance;
+		double _maxParam;
+		bool _isHit;
+		LN_RayCurveIntersection _result;
+		LN_DerivativeWorkspace _workspace;
+	};
+
+	/// <summary>
+	/// Point on both surfaces, Params holds u0, v0, u1, v1.
+	/// </summary>
+	struct MarchingPoint
+	{
+		XYZ Point;
+		double Params[4];
+	};
+
+	/// <summary>
+	/// Distance from point to the segment [start, end].
+	/// </summary>
+	double DistanceToPolylineSegment(const XYZ& point, const XYZ& start, const XYZ& end)
+	{
+		XYZ chord = end - start;
+		double squareLength = chord.DotProduct(chord);
+		double t = MathUtils::IsAlmostEqualTo(squareLength, 0.0) ? 0.0 : std::max(0.0, std::min(1.0, (point - start).DotProduct(chord) / squareLength));
+		return point.Distance(start + chord * t);
+	}
+
+	class SurfaceSurfaceIntersector
+	{
+	public:
+		SurfaceSurfaceIntersector(const LN_NurbsSurface& surface0, const LN_NurbsSurface& surface1, double tolerance, double size)
+			: _surface0(NurbsSurface::Check(surface0)), _surface1(NurbsSurface::Check(surface1)), _tolerance(tolerance)
+		{
+			const LN_NurbsSurface* surfaces[2] = { &surface0, &surface1 };
+			for (int i = 0; i < 2; i++)
+			{
+				const std::vector<double>& knotVectorU = surfaces[i]->KnotVectorU;
+				const std::vector<double>& knotVectorV = surfaces[i]->KnotVectorV;
+				_minParams[2 * i] = knotVectorU[0];
+				_maxParams[2 * i] = knotVectorU[knotVectorU.size() - 1];
+				_minParams[2 * i + 1] = knotVectorV[0];
+				_maxParams[2 * i + 1] = knotVectorV[knotVectorV.size() - 1];
+			}
+			_seedFlatness = std::max(tolerance, SeedFlatnessRatio * size);
+			_maxStep = std::max(tolerance, MaxStepRatio * size);
+			_minStep = _maxStep * 1E-4;
+			_coverTolerance = std::max(10.0 * tolerance, _maxStep * MaxTurningAngle / 4.0);
+		}
+
+		void CollectSeeds(const BezierPatch& patch0, const BezierPatch& patch1, int depth)
+		{
+			if (!BoundingVolumeHierarchy::IsOverlapped(patch0.Box, patch1.Box, _tolerance))
+			{
+				return;
+			}
+
+			bool isFlat0 = ComputePatchFlatness(patch0) <= _seedFlatness;
+			bool isFlat1 = ComputePatchFlatness(patch1) <= _seedFlatness;
+			if ((isFlat0 && isFlat1) || depth >= MaxClippingDepth)
+			{
+				MarchingPoint seed;
+				seed.Params[0] = (patch0.StartU + patch0.EndU) / 2.0;
+				seed.Params[1] = (patch0.StartV + patch0.EndV) / 2.0;
+				seed.Params[2] = (patch1.StartU + patch1.EndU) / 2.0;
+				seed.Params[3] = (patch1.StartV + patch1.EndV) / 2.0;
+				if (RefineSeed(seed))
+				{
+					_seeds.emplace_back(seed);
+				}
+				return;
+			}
+
+			double size0 = patch0.Box.Min.Distance(patch0.Box.Max);
+			double size1 = patch1.Box.Min.Distance(patch1.Box.Max);
+			BezierPatch first;
+			BezierPatch second;
+			if (isFlat1 || (!isFlat0 && size0 >= size1))
+			{
+				SplitPatch(patch0, IsLongerInU(patch0), first, second);
+				CollectSeeds(first, patch1, depth + 1);
+				CollectSeeds(second, patch1, depth + 1);
+			}
+			else
+			{
+				SplitPatch(patch1, IsLongerInU(patch1), first, second);
+				CollectSeeds(patch0, first, depth + 1);
+				CollectSeeds(patch0, second, depth + 1);
+			}
+		}
+
+		/// <summary>
+		/// March from every seed not lying on a traced branch and fit the branches.
+		/// </summary>
+		void Trace()
+		{
+			for (int i = 0; i < _seeds.size(); i++)
+			{
+				if (IsCovered(_seeds[i].Point))
+				{
+					continue;
+				}
+
+				std::vector<MarchingPoint> forward;
+				std::vector<MarchingPoint> backward;
+				bool isClosed = March(_seeds[i], 1.0, forward);
+				if (!isClosed)
+				{
+					March(_seeds[i], -1.0, backward);
+				}
+
+				std::vector<MarchingPoint> branch(backward.rbegin(), backward.rend());
+				branch.emplace_back(_seeds[i]);
+				branch.insert(branch.end(), forward.begin(), forward.end());
+
+				LN_SurfaceSurfaceIntersection intersection;
+				for (int j = 0; j < branch.size(); j++)
+				{
+					intersection.Points.emplace_back(branch[j].Point);
+					intersection.Params0.emplace_back(UV(branch[j].Params[0], branch[j].Params[1]));
+					intersection.Params1.emplace_back(UV(branch[j].Params[2], branch[j].Params[3]));
+				}
+				intersection.Curve.Degree = 0;
+				int size = intersection.Points.size();
+				if (size >= 2)
+				{
+					NurbsCurve::GlobalInterpolation(std::min(3, size - 1), intersection.Points, intersection.Curve);
+				}
+				_results.emplace_back(intersection);
+			}
+		}
+
+		std::vector<LN_SurfaceSurfaceIntersection>& GetResults()
+		{
+			return _results;
+		}
+
+	private:
+
+		void Evaluate(const double* params, XYZ* frame0, XYZ* frame1)
+		{
+			ComputeSurfaceFrame(_surface0, params[0], params[1], frame0);
+			ComputeSurfaceFrame(_surface1, params[2], params[3], frame1);
+		}
+
+		/// <summary>
+		/// Minimum norm Gauss-Newton iteration on S0(u0,v0) - S1(u1,v1) = 0.
+		/// </summary>
+		bool RefineSeed(MarchingPoint& seed)
+		{
+			XYZ frame0[3];
+			XYZ frame1[3];
+			double* params = seed.Params;
+			for (int i = 0; i < MaxRefinementIterations; i++)
+			{
+				Evaluate(params, frame0, frame1);
+				XYZ difference = frame0[0] - frame1[0];
+				if (difference.Length() <= Constants::DoubleEpsilon * _tolerance)
+				{
+					break;
+				}
+
+				double jacobian[3][4];
+				for (int k = 0; k < 3; k++)
+				{
+					jacobian[k][0] = frame0[1][k];
+					jacobian[k][1] = frame0[2][k];
+					jacobian[k][2] = -frame1[1][k];
+					jacobian[k][3] = -frame1[2][k];
+				}
+				double matrix[9];
+				double right[3];
+				for (int r = 0; r < 3; r++)
+				{
+					for (int c = 0; c < 3; c++)
+					{
+						double sum = 0.0;
+						for (int j = 0; j < 4; j++)
+						{
+							sum += jacobian[r][j] * jacobian[c][j];
+						}
+						matrix[r * 3 + c] = sum;
+					}
+					right[r] = -difference[r];
+				}
+				if (!SolveSmallLinearSystem(matrix, right, 3))
+				{
+					break;
+				}
+
+				bool isConverged = true;
+				for (int j = 0; j < 4; j++)
+				{
+					double delta = jacobian[0][j] * right[0] + jacobian[1][j] * right[1] + jacobian[2][j] * right[2];
+					double value = std::max(_minParams[j], std::min(_maxParams[j], params[j] + delta));
+					isConverged = isConverged && std::abs(value - params[j]) <= Constants::DoubleEpsilon * (_maxParams[j] - _minParams[j]);
+					params[j] = value;
+				}
+				if (isConverged)
+				{
+					break;
+				}
+			}
+
+			Evaluate(params, frame0, frame1);
+			if (frame0[0].Distance(frame1[0]) > _tolerance)
+			{
+				return false;
+			}
+			seed.Point = (frame0[0] + frame1[0]) / 2.0;
+			return true;
+		}
+
+		/// <summary>
+		/// Unit N0 x N1, false when the surfaces are tangent.
+		/// </summary>
+		bool ComputeTangent(const MarchingPoint& point, XYZ& tangent)
+		{
+			XYZ frame0[3];
+			XYZ frame1[3];
+			Evaluate(point.Params, frame0, frame1);
+			XYZ normal0 = frame0[1].CrossProduct(frame0[2]);
+			XYZ normal1 = frame1[1].CrossProduct(frame1[2]);
+			XYZ direction = normal0.CrossProduct(normal1);
+			if (direction.Length() <= Constants::DoubleEpsilon * normal0.Length() * normal1.Length())
+			{
+				return false;
+			}
+			tangent = direction.Normalize();
+			return true;
+		}
+
+		/// <summary>
+		/// Move the params of both surfaces by step along tangent, each projected on its tangent plane.
+		/// </summary>
+		void Predict(MarchingPoint& point, const XYZ& tangent, double step)
+		{
+			XYZ frames[2][3];
+			Evaluate(point.Params, frames[0], frames[1]);
+			for (int i = 0; i < 2; i++)
+			{
+				const XYZ& tangentU = frames[i][1];
+				const XYZ& tangentV = frames[i][2];
+				double matrix[4] = { tangentU.DotProduct(tangentU), tangentU.DotProduct(tangentV), tangentV.DotProduct(tangentU), tangentV.DotProduct(tangentV) };
+				double right[2] = { step * tangentU.DotProduct(tangent), step * tangentV.DotProduct(tangent) };
+				if (!SolveSmallLinearSystem(matrix, right, 2))
+				{
+					continue;
+				}
+				for (int j = 0; j < 2; j++)
+				{
+					int index = 2 * i + j;
+					point.Params[index] = std::max(_minParams[index], std::min(_maxParams[index], point.Params[index] + right[j]));
+				}
+			}
+		}
+
+		/// <summary>
+		/// Newton iteration on S0 - S1 = 0 and tangent . (S0 - origin) = step.
+		/// When fixedIndex is not negative that param stays on its bound and the step equation is dropped.
+		/// clampedIndex reports a param pushed out of its domain by the last iteration.
+		/// </summary>
+		bool Correct(MarchingPoint& point, const XYZ& origin, const XYZ& tangent, double step, int fixedIndex, int& clampedIndex)
+		{
+			XYZ frame0[3];
+			XYZ frame1[3];
+			double* params = point.Params;
+			int size = fixedIndex < 0 ? 4 : 3;
+			bool isConverged = false;
+			for (int i = 0; i < MaxRefinementIterations && !isConverged; i++)
+			{
+				Evaluate(params, frame0, frame1);
+				XYZ difference = frame0[0] - frame1[0];
+
+				double jacobian[4][4];
+				double residual[4];
+				for (int k = 0; k < 3; k++)
+				{
+					jacobian[k][0] = frame0[1][k];
+					jacobian[k][1] = frame0[2][k];
+					jacobian[k][2] = -frame1[1][k];
+					jacobian[k][3] = -frame1[2][k];
+					residual[k] = difference[k];
+				}
+				jacobian[3][0] = tangent.DotProduct(frame0[1]);
+				jacobian[3][1] = tangent.DotProduct(frame0[2]);
+				jacobian[3][2] = 0.0;
+				jacobian[3][3] = 0.0;
+				residual[3] = tangent.DotProduct(frame0[0] - origin) - step;
+
+				int columns[4];
+				int count = 0;
+				for (int j = 0; j < 4; j++)
+				{
+					if (j != fixedIndex)
+					{
+						columns[count++] = j;
+					}
+				}
+				double matrix[16];
+				double right[4];
+				for (int r = 0; r < size; r++)
+				{
+					for (int c = 0; c < size; c++)
+					{
+						matrix[r * size + c] = jacobian[r][columns[c]];
+					}
+					right[r] = -residual[r];
+				}
+				if (!SolveSmallLinearSystem(matrix, right, size))
+				{
+					return false;
+				}
+
+				clampedIndex = -1;
+				isConverged = true;
+				for (int c = 0; c < size; c++)
+				{
+					int j = columns[c];
+					double value = params[j] + right[c];
+					if (value < _minParams[j] || value > _maxParams[j])
+					{
+						value = std::max(_minParams[j], std::min(_maxParams[j], value));
+						clampedIndex = j;
+					}
+					isConverged = isConverged && std::abs(value - params[j]) <= Constants::DoubleEpsilon * (_maxParams[j] - _minParams[j]);
+					params[j] = value;
+				}
+			}
+			if (fixedIndex < 0 && clampedIndex >= 0)
+			{
+				return false;
+			}
+
+			Evaluate(params, frame0, frame1);
+			if (frame0[0].Distance(frame1[0]) > _tolerance)
+			{
+				return false;
+			}
+			point.Point = (frame0[0] + frame1[0]) / 2.0;
+			return true;
+		}
+
+		/// <summary>
+		/// Trace from seed along direction * N0 x N1, returns true when the branch closes at the seed.
+		/// </summary>
+		bool March(const MarchingPoint& seed, double direction, std::vector<MarchingPoint>& branch)
+		{
+			XYZ tangent;
+			if (!ComputeTangent(seed, tangent))
+			{
+				return false;
+			}
+			tangent = direction * tangent;
+
+			MarchingPoint current = seed;
+			double step = _maxStep;
+			for (int n = 0; n < MaxMarchingSteps; n++)
+			{
+				if (branch.size() >= 3)
+				{
+					XYZ toSeed = seed.Point - current.Point;
+					double distance = toSeed.Length();
+					if (distance <= step && toSeed.DotProduct(tangent) > 0.0)
+					{
+						if (distance <= _tolerance)
+						{
+							branch.back() = seed;
+						}
+						else
+						{
+							branch.emplace_back(seed);
+						}
+						return true;
+					}
+				}
+
+				MarchingPoint next = current;
+				Predict(next, tangent, step);
+				int clampedIndex = -1;
+				bool isCorrected = Correct(next, current.Point, tangent, step, -1, clampedIndex);
+				bool isBoundary = false;
+				if (!isCorrected && clampedIndex >= 0)
+				{
+					int unused = -1;
+					isCorrected = Correct(next, current.Point, tangent, step, clampedIndex, unused) &&
+						(next.Point - current.Point).DotProduct(tangent) > _tolerance;
+					isBoundary = true;
+				}
+				if (!isCorrected)
+				{
+					step /= 2.0;
+					if (step < _minStep)
+					{
+						return false;
+					}
+					continue;
+				}
+
+				XYZ nextTangent;
+				if (!ComputeTangent(next, nextTangent))
+				{
+					branch.emplace_back(next);
+					return false;
+				}
+				if (nextTangent.DotProduct(tangent) < 0.0)
+				{
+					nextTangent = -nextTangent;
+				}
+				double angle = tangent.AngleTo(nextTangent);
+				if (angle > MaxTurningAngle && step / 2.0 >= _minStep)
+				{
+					step /= 2.0;
+					continue;
+				}
+
+				branch.emplace_back(next);
+				if (isBoundary)
+				{
+					return false;
+				}
+				current = next;
+				tangent = nextTangent;
+				if (angle < MaxTurningAngle / 2.0)
+				{
+					step = std::min(step * 1.5, _maxStep);
+				}
+			}
+			return false;
+		}
+
+		bool IsCovered(const XYZ& point)
+		{
+			for (int i = 0; i < _results.size(); i++)
+			{
+				const std::vector<XYZ>& points = _results[i].Points;
+				if (points.size() == 1 && points[0].Distance(point) <= _coverTolerance)
+				{
+					return true;
+				}
+				for (int j = 1; j < points.size(); j++)
+				{
+					if (DistanceToPolylineSegment(point, points[j - 1], points[j]) <= _coverTolerance)
+					{
+						return true;
+					}
+				}
+			}
+			return false;
+		}
+
+		LN_CheckedNurbsSurface _surface0;
+		LN_CheckedNurbsSurface _surface1;
+		double _tolerance;
+		double _seedFlatness;
+		double _maxStep;
+		double _minStep;
+		double _coverTolerance;
+		double _minParams[4];
+		double _maxParams[4];
+		std::vector<MarchingPoint> _seeds;
+		std::vector<LN_SurfaceSurfaceIntersection> _results;
+	};
+}
 
 using namespace LNLib;
 
@@ -81,3 +1623,205 @@ LinePlaneIntersectionType LNLib::Intersection::ComputeLineAndPlane(const XYZ& no
 	intersectPoint = d * lineDirectionNormal + pointOnLine;
 	return LinePlaneIntersectionType::Intersecting;
 }
+
+std::vector<LNLib::LN_CurveCurveIntersection> LNLib::Intersection::ComputeCurveCurve(const LN_NurbsCurve& curve0, const LN_NurbsCurve& curve1, double tolerance)
+{
+	VALIDATE_ARGUMENT(tolerance > 0.0, "tolerance", "Tolerance must greater than zero.");
+
+	CurveCurveIntersector intersector(curve0, curve1, tolerance);
+	std::vector<BezierSegment> segments0 = CreateBezierSegments(curve0);
+	std::vector<BezierSegment> segments1 = CreateBezierSegments(curve1);
+
+	// Segments of curve1 go into a hierarchy, so each segment of curve0 only meets the segments its box overlaps.
+	std::vector<LN_BoundingBox> boxes(segments1.size());
+	for (int i = 0; i < segments1.size(); i++)
+	{
+		boxes[i] = segments1[i].Box;
+	}
+	BoundingVolumeHierarchy hierarchy;
+	hierarchy.Build(boxes);
+	std::vector<int> candidates;
+	for (int i = 0; i < segments0.size(); i++)
+	{
+		candidates.clear();
+		hierarchy.FindOverlaps(segments0[i].Box, tolerance, candidates);
+		for (int j = 0; j < candidates.size(); j++)
+		{
+			intersector.Intersect(segments0[i], segments1[candidates[j]], 0);
+		}
+	}
+
+	return intersector.GetResults();
+}
+
+std::vector<LNLib::LN_CurveSurfaceIntersection> LNLib::Intersection::ComputeCurveSurface(const LN_NurbsCurve& curve, const LN_NurbsSurface& surface, double tolerance)
+{
+	VALIDATE_ARGUMENT(tolerance > 0.0, "tolerance", "Tolerance must greater than zero.");
+
+	CurveSurfaceIntersector intersector(curve, surface, tolerance);
+	std::vector<BezierSegment> segments = CreateBezierSegments(curve);
+	std::vector<BezierPatch> patches = CreateBezierPatches(surface);
+
+	// Patches go into a hierarchy, so each segment only meets the patches its box overlaps.
+	std::vector<LN_BoundingBox> boxes(patches.size());
+	for (int i = 0; i < patches.size(); i++)
+	{
+		boxes[i] = patches[i].Box;
+	}
+	BoundingVolumeHierarchy hierarchy;
+	hierarchy.Build(boxes);
+	std::vector<int> candidates;
+	for (int i = 0; i < segments.size(); i++)
+	{
+		candidates.clear();
+		hierarchy.FindOverlaps(segments[i].Box, tolerance, candidates);
+		for (int j = 0; j < candidates.size(); j++)
+		{
+			intersector.Intersect(segments[i], patches[candidates[j]], 0);
+		}
+	}
+
+	std::vector<LN_CurveSurfaceIntersection> results = intersector.GetResults();
+	std::sort(results.begin(), results.end(), IsCurveParamLess);
+	return results;
+}
+
+std::vector<LNLib::LN_RaySurfaceIntersection> LNLib::Intersection::ComputeRaySurface(const XYZ& origin, const XYZ& direction, const LN_NurbsSurface& surface, double tolerance)
+{
+	VALIDATE_ARGUMENT(!direction.IsZero(), "direction", "Direction must not be zero vector.");
+	VALIDATE_ARGUMENT(tolerance > 0.0, "tolerance", "Tolerance must greater than zero.");
+
+	LN_CheckedNurbsSurface checked = NurbsSurface::Check(surface);
+	RaySurfaceIntersector intersector(origin, direction, checked, tolerance, Constants::MaxDistance, false);
+	std::vector<BezierPatch> patches = CreateBezierPatches(surface);
+	for (int i = 0; i < patches.size(); i++)
+	{
+		intersector.Intersect(patches[i], 0);
+	}
+
+	std::vector<LN_RaySurfaceIntersection> results = intersector.GetResults();
+	std::sort(results.begin(), results.end(), IsRayParamLess);
+	return results;
+}
+
+bool LNLib::Intersection::ComputeRaySurface(const XYZ& origin, const XYZ& direction, const PreparedSurface& surface, double tolerance, double maxParam, LN_RaySurfaceIntersection& nearest)
+{
+	VALIDATE_ARGUMENT(!direction.IsZero(), "direction", "Direction must not be zero vector.");
+	VALIDATE_ARGUMENT(tolerance > 0.0, "tolerance", "Tolerance must greater than zero.");
+
+	const std::vector<LN_BoundingBox>& boxes = surface.GetSpanBoundingBoxes();
+	std::vector<std::pair<double, int>> candidates;
+	for (int i = 0; i < boxes.size(); i++)
+	{
+		double entry = 0.0;
+		double exit = 0.0;
+		if (BoundingVolumeHierarchy::IntersectRay(boxes[i], origin, direction, tolerance, entry, exit) && entry < maxParam)
+		{
+			candidates.emplace_back(entry, i);
+		}
+	}
+	std::sort(candidates.begin(), candidates.end());
+
+	const std::vector<LN_NurbsSurface>& beziers = surface.GetBeziers();
+	const std::vector<double>& spanKnotsU = surface.GetSpanKnotsU();
+	const std::vector<double>& spanKnotsV = surface.GetSpanKnotsV();
+	int patchesV = spanKnotsV.size() - 1;
+	RaySurfaceIntersector intersector(origin, direction, surface.Checked(), tolerance, maxParam, true);
+	BezierPatch patch;
+	for (int i = 0; i < candidates.size(); i++)
+	{
+		std::vector<LN_RaySurfaceIntersection>& results = intersector.GetResults();
+		if (!results.empty() && candidates[i].first >= results[0].RayParam)
+		{
+			break;
+		}
+		int index = candidates[i].second;
+		patch.ControlPoints = beziers[index].ControlPoints;
+		patch.StartU = spanKnotsU[index / patchesV];
+		patch.EndU = spanKnotsU[index / patchesV + 1];
+		patch.StartV = spanKnotsV[index % patchesV];
+		patch.EndV = spanKnotsV[index % patchesV + 1];
+		patch.Box = boxes[index];
+		intersector.Intersect(patch, 0);
+	}
+
+	std::vector<LN_RaySurfaceIntersection>& results = intersector.GetResults();
+	if (results.empty())
+	{
+		return false;
+	}
+	nearest = results[0];
+	return true;
+}
+
+bool LNLib::Intersection::ComputeRayCurve(const XYZ& origin, const XYZ& direction, const PreparedCurve& curve, double tolerance, double maxParam, LN_RayCurveIntersection& nearest)
+{
+	VALIDATE_ARGUMENT(!direction.IsZero(), "direction", "Direction must not be zero vector.");
+	VALIDATE_ARGUMENT(tolerance > 0.0, "tolerance", "Tolerance must greater than zero.");
+
+	const std::vector<LN_NurbsCurve>& beziers = curve.GetBeziers();
+	const std::vector<LN_BoundingBox>& boxes = curve.GetSpanBoundingBoxes();
+	const std::vector<double>& spanKnots = curve.GetSpanKnots();
+	RayCurveIntersector intersector(origin, direction, curve.Checked(), tolerance, maxParam);
+	BezierSegment segment;
+	for (int i = 0; i < beziers.size(); i++)
+	{
+		double entry = 0.0;
+		double exit = 0.0;
+		if (!BoundingVolumeHierarchy::IntersectRay(boxes[i], origin, direction, tolerance, entry, exit) || entry >= maxParam)
+		{
+			continue;
+		}
+		segment.ControlPoints = beziers[i].ControlPoints;
+		segment.Start = spanKnots[i];
+		segment.End = spanKnots[i + 1];
+		segment.Box = boxes[i];
+		intersector.Intersect(segment, 0);
+	}
+	return intersector.GetResult(nearest);
+}
+
+std::vector<LNLib::LN_SurfaceSurfaceIntersection> LNLib::Intersection::ComputeSurfaceSurface(const LN_NurbsSurface& surface0, const LN_NurbsSurface& surface1, double tolerance)
+{
+	VALIDATE_ARGUMENT(tolerance > 0.0, "tolerance", "Tolerance must greater than zero.");
+
+	std::vector<BezierPatch> patches0 = CreateBezierPatches(surface0);
+	std::vector<BezierPatch> patches1 = CreateBezierPatches(surface1);
+	std::vector<LN_BoundingBox> boxes(patches1.size());
+	LN_BoundingBox box1 = patches1[0].Box;
+	for (int i = 0; i < patches1.size(); i++)
+	{
+		boxes[i] = patches1[i].Box;
+		for (int k = 0; k < 3; k++)
+		{
+			box1.Min[k] = std::min(box1.Min[k], boxes[i].Min[k]);
+			box1.Max[k] = std::max(box1.Max[k], boxes[i].Max[k]);
+		}
+	}
+	LN_BoundingBox box0 = patches0[0].Box;
+	for (int i = 0; i < patches0.size(); i++)
+	{
+		for (int k = 0; k < 3; k++)
+		{
+			box0.Min[k] = std::min(box0.Min[k], patches0[i].Box.Min[k]);
+			box0.Max[k] = std::max(box0.Max[k], patches0[i].Box.Max[k]);
+		}
+	}
+	double size = std::min(box0.Min.Distance(box0.Max), box1.Min.Distance(box1.Max));
+
+	BoundingVolumeHierarchy hierarchy;
+	hierarchy.Build(boxes);
+	SurfaceSurfaceIntersector intersector(surface0, surface1, tolerance, size);
+	std::vector<int> candidates;
+	for (int i = 0; i < patches0.size(); i++)
+	{
+		candidates.clear();
+		hierarchy.FindOverlaps(patches0[i].Box, tolerance, candidates);
+		for (int j = 0; j < candidates.size(); j++)
+		{
+			intersector.CollectSeeds(patches0[i], patches1[candidates[j]], 0);
+		}
+	}
+	intersector.Trace();
+	return intersector.GetResults();
+}
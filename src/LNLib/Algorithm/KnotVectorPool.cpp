@@ -0,0 +1,147 @@
+/*
+ * Author:
+ * 2024/10/14 - Yuqing Liang (BIMCoder Liang)
+ * bim.frankliang@foxmail.com
+ * 微信公众号：BIMCoder梁老师
+ *
+ * Use of this source code is governed by a GPL-3.0 license that can be found in
+ * the LICENSE file.
+ */
+
+#include "KnotVectorPool.h"
+#include <functional>
+#include <iterator>
+
+namespace LNLib
+{
+	namespace
+	{
+		size_t HashKnotVector(const std::vector<double>& knotVector)
+		{
+			std::hash<double> hasher;
+			size_t hash = knotVector.size();
+			for (int i = 0; i < static_cast<int>(knotVector.size()); i++)
+			{
+				hash ^= hasher(knotVector[i]) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+			}
+			return hash;
+		}
+	}
+}
+
+LNLib::LN_SharedKnotVector LNLib::KnotVectorPool::Intern(const std::vector<double>& knotVector)
+{
+	size_t hash = HashKnotVector(knotVector);
+	std::lock_guard<std::mutex> lock(_mutex);
+	std::vector<WeakKnotVector>& bucket = _entries[hash];
+	for (int i = 0; i < static_cast<int>(bucket.size()); i++)
+	{
+		LN_SharedKnotVector shared = bucket[i].lock();
+		if (shared && *shared == knotVector)
+		{
+			return shared;
+		}
+	}
+
+	LN_SharedKnotVector shared = std::make_shared<const std::vector<double>>(knotVector);
+	// Released entries of the bucket are reused before it grows.
+	for (int i = 0; i < static_cast<int>(bucket.size()); i++)
+	{
+		if (bucket[i].expired())
+		{
+			bucket[i] = shared;
+			return shared;
+		}
+	}
+	bucket.emplace_back(shared);
+	return shared;
+}
+
+void LNLib::KnotVectorPool::Share(const LN_NurbsCurve& curve, LN_SharedNurbsCurve& result)
+{
+	result.Degree = curve.Degree;
+	result.KnotVector = Intern(curve.KnotVector);
+	result.ControlPoints = curve.ControlPoints;
+}
+
+void LNLib::KnotVectorPool::Share(const LN_NurbsSurface& surface, LN_SharedNurbsSurface& result)
+{
+	result.DegreeU = surface.DegreeU;
+	result.DegreeV = surface.DegreeV;
+	result.KnotVectorU = Intern(surface.KnotVectorU);
+	result.KnotVectorV = Intern(surface.KnotVectorV);
+	result.ControlPoints = surface.ControlPoints;
+}
+
+std::vector<LNLib::LN_SharedNurbsCurve> LNLib::KnotVectorPool::Share(const std::vector<LN_NurbsCurve>& curves)
+{
+	std::vector<LN_SharedNurbsCurve> result(curves.size());
+	for (int i = 0; i < static_cast<int>(curves.size()); i++)
+	{
+		Share(curves[i], result[i]);
+	}
+	return result;
+}
+
+std::vector<LNLib::LN_SharedNurbsSurface> LNLib::KnotVectorPool::Share(const std::vector<LN_NurbsSurface>& surfaces)
+{
+	std::vector<LN_SharedNurbsSurface> result(surfaces.size());
+	for (int i = 0; i < static_cast<int>(surfaces.size()); i++)
+	{
+		Share(surfaces[i], result[i]);
+	}
+	return result;
+}
+
+int LNLib::KnotVectorPool::GetCount() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	int count = 0;
+	for (auto it = _entries.begin(); it != _entries.end(); ++it)
+	{
+		const std::vector<WeakKnotVector>& bucket = it->second;
+		for (int i = 0; i < static_cast<int>(bucket.size()); i++)
+		{
+			if (!bucket[i].expired())
+			{
+				count++;
+			}
+		}
+	}
+	return count;
+}
+
+void LNLib::KnotVectorPool::Purge()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	for (auto it = _entries.begin(); it != _entries.end();)
+	{
+		std::vector<WeakKnotVector>& bucket = it->second;
+		int kept = 0;
+		for (int i = 0; i < static_cast<int>(bucket.size()); i++)
+		{
+			if (!bucket[i].expired())
+			{
+				bucket[kept++] = bucket[i];
+			}
+		}
+		bucket.resize(kept);
+		it = bucket.empty() ? _entries.erase(it) : std::next(it);
+	}
+}
+
+void LNLib::KnotVectorPool::ToCurve(const LN_SharedNurbsCurve& curve, LN_NurbsCurve& result)
+{
+	result.Degree = curve.Degree;
+	result.KnotVector = *curve.KnotVector;
+	result.ControlPoints = curve.ControlPoints;
+}
+
+void LNLib::KnotVectorPool::ToSurface(const LN_SharedNurbsSurface& surface, LN_NurbsSurface& result)
+{
+	result.DegreeU = surface.DegreeU;
+	result.DegreeV = surface.DegreeV;
+	result.KnotVectorU = *surface.KnotVectorU;
+	result.KnotVectorV = *surface.KnotVectorV;
+	result.ControlPoints = surface.ControlPoints;
+}
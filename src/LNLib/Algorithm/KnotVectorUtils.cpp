@@ -35,7 +35,7 @@ std::vector<double> LNLib::KnotVectorUtils::Rescale(const std::vector<double>& k
 	std::vector<double> result(size);
 	for (int i = 0; i < size; i++)
 	{
-		result[i] = (k * knotVector[i] - origintMin) + min;
+		result[i] = k * (knotVector[i] - origintMin) + min;
 	}
 	return result;
 }
@@ -89,9 +89,9 @@ std::unordered_map<double, int, std::hash<double>, CustomDoubleEqual> LNLib::Kno
 	auto result = GetKnotMultiplicityMap(knotVector);
 	if (!result.empty()) 
 	{
-		result.erase(result.begin());
-		auto lastElementIterator = prev(result.end(), 1);
-		result.erase(lastElementIterator);
+		// Unordered map has no first or last element, erase end knots by value.
+		result.erase(knotVector[0]);
+		result.erase(knotVector[knotVector.size() - 1]);
 	}
 	return result;
 }
@@ -217,6 +217,50 @@ std::vector<std::vector<double>> LNLib::KnotVectorUtils::GetInsertedKnotElements
 	return result;
 }
 
+int LNLib::KnotVectorUtils::GetBezierCount(int degree, const std::vector<double>& knotVector)
+{
+	int count = 1;
+	int n = knotVector.size() - degree - 2;
+	for (int i = degree + 1; i <= n; i++)
+	{
+		if (!MathUtils::IsAlmostEqualTo(knotVector[i], knotVector[i - 1]))
+		{
+			count++;
+		}
+	}
+	return count;
+}
+
+std::vector<double> LNLib::KnotVectorUtils::GetSplitKnotElements(int degree, const std::vector<double>& knotVector, const std::vector<double>& parameters, std::vector<double>& splitParameters)
+{
+	double min = knotVector[degree];
+	double max = knotVector[knotVector.size() - degree - 1];
+
+	splitParameters.clear();
+	for (int i = 0; i < parameters.size(); i++)
+	{
+		double parameter = parameters[i];
+		if (MathUtils::IsGreaterThan(parameter, min) && MathUtils::IsLessThan(parameter, max))
+		{
+			splitParameters.emplace_back(parameter);
+		}
+	}
+	std::sort(splitParameters.begin(), splitParameters.end());
+	splitParameters.erase(std::unique(splitParameters.begin(), splitParameters.end(), CustomDoubleEqual()), splitParameters.end());
+
+	std::vector<double> insertElements;
+	for (int i = 0; i < splitParameters.size(); i++)
+	{
+		double parameter = splitParameters[i];
+		int multi = Polynomials::GetKnotMultiplicity(knotVector, parameter);
+		for (int j = multi; j <= degree; j++)
+		{
+			insertElements.emplace_back(parameter);
+		}
+	}
+	return insertElements;
+}
+
 bool LNLib::KnotVectorUtils::IsUniform(const std::vector<double>& knotVector)
 {
 	auto map = GetKnotMultiplicityMap(knotVector);
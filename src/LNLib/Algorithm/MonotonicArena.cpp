@@ -0,0 +1,88 @@
+/*
+ * Author:
+ * 2024/10/14 - Yuqing Liang (BIMCoder Liang)
+ * bim.frankliang@foxmail.com
+ * 微信公众号：BIMCoder梁老师
+ *
+ * Use of this source code is governed by a GPL-3.0 license that can be found in
+ * the LICENSE file.
+ */
+
+#include "MonotonicArena.h"
+#include "LNLibExceptions.h"
+#include "Instrumentation.h"
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+struct LNLib::MonotonicArena::Block
+{
+	Block* Next;
+};
+
+LNLib::MonotonicArena::MonotonicArena(size_t blockSize)
+	: _blocks(nullptr), _current(nullptr), _end(nullptr), _blockSize(blockSize), _allocatedBytes(0), _blockCount(0)
+{
+	VALIDATE_ARGUMENT(blockSize > 0, "blockSize", "Block size must greater than zero.");
+}
+
+LNLib::MonotonicArena::~MonotonicArena()
+{
+	Release();
+}
+
+void* LNLib::MonotonicArena::Allocate(size_t bytes, size_t alignment)
+{
+	VALIDATE_ARGUMENT(alignment > 0 && (alignment & (alignment - 1)) == 0, "alignment", "Alignment must be a power of two.");
+
+	uintptr_t address = reinterpret_cast<uintptr_t>(_current);
+	uintptr_t aligned = (address + alignment - 1) & ~(uintptr_t)(alignment - 1);
+	if (_current == nullptr || aligned + bytes > reinterpret_cast<uintptr_t>(_end))
+	{
+		// Oversized requests get a block of their own size, the header keeps max_align_t alignment.
+		size_t header = (sizeof(Block) + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t);
+		size_t capacity = bytes + alignment > _blockSize ? bytes + alignment : _blockSize;
+		char* memory = static_cast<char*>(std::malloc(header + capacity));
+		LNLIB_COUNT(Allocations, 1);
+		if (memory == nullptr)
+		{
+			throw std::bad_alloc();
+		}
+		Block* block = reinterpret_cast<Block*>(memory);
+		block->Next = _blocks;
+		_blocks = block;
+		_blockCount++;
+		_current = memory + header;
+		_end = _current + capacity;
+
+		address = reinterpret_cast<uintptr_t>(_current);
+		aligned = (address + alignment - 1) & ~(uintptr_t)(alignment - 1);
+	}
+	_current = reinterpret_cast<char*>(aligned + bytes);
+	_allocatedBytes += bytes;
+	return reinterpret_cast<void*>(aligned);
+}
+
+void LNLib::MonotonicArena::Release()
+{
+	while (_blocks != nullptr)
+	{
+		Block* next = _blocks->Next;
+		std::free(_blocks);
+		_blocks = next;
+	}
+	_current = nullptr;
+	_end = nullptr;
+	_allocatedBytes = 0;
+	_blockCount = 0;
+}
+
+size_t LNLib::MonotonicArena::GetAllocatedBytes() const
+{
+	return _allocatedBytes;
+}
+
+size_t LNLib::MonotonicArena::GetBlockCount() const
+{
+	return _blockCount;
+}
@@ -0,0 +1,207 @@
+/*
+ * Author:
+ * 2024/10/14 - Yuqing Liang (BIMCoder Liang)
+ * bim.frankliang@foxmail.com
+ * 微信公众号：BIMCoder梁老师
+ *
+ * Use of this source code is governed by a GPL-3.0 license that can be found in
+ * the LICENSE file.
+ */
+
+#include "Parallel.h"
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <exception>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <cstdint>
+
+namespace LNLib
+{
+	namespace
+	{
+		/// <summary>
+		/// Remaining [begin, end) of one worker packed in one word, so the owner popping the front
+		/// and a thief splitting off the back half both update it with a single compare-exchange.
+		/// Padded to keep neighbouring workers off the same cache line.
+		/// </summary>
+		struct WorkRange
+		{
+			std::atomic<uint64_t> Range;
+			char Padding[64 - sizeof(std::atomic<uint64_t>)];
+		};
+
+		uint64_t PackRange(uint32_t begin, uint32_t end)
+		{
+			return (static_cast<uint64_t>(begin) << 32) | end;
+		}
+
+		uint32_t RangeBegin(uint64_t range)
+		{
+			return static_cast<uint32_t>(range >> 32);
+		}
+
+		uint32_t RangeEnd(uint64_t range)
+		{
+			return static_cast<uint32_t>(range);
+		}
+
+		struct WorkQueue
+		{
+			std::vector<WorkRange> Ranges;
+			std::atomic<bool> IsCancelled;
+			std::mutex ExceptionMutex;
+			std::exception_ptr Exception;
+
+			WorkQueue(int workerCount) : Ranges(workerCount)
+			{
+				IsCancelled.store(false);
+			}
+		};
+
+		bool PopFront(WorkRange& own, int& index)
+		{
+			uint64_t range = own.Range.load();
+			while (RangeBegin(range) < RangeEnd(range))
+			{
+				if (own.Range.compare_exchange_weak(range, PackRange(RangeBegin(range) + 1, RangeEnd(range))))
+				{
+					index = RangeBegin(range);
+					return true;
+				}
+			}
+			return false;
+		}
+
+		/// <summary>
+		/// Split off the back half of the largest remaining slice, ties go to the next worker in
+		/// round-robin order. The scan is repeated when the victim changed before the split.
+		/// </summary>
+		bool StealHalf(WorkQueue& queue, int worker)
+		{
+			int count = static_cast<int>(queue.Ranges.size());
+			while (true)
+			{
+				int victimIndex = -1;
+				uint64_t victimRange = 0;
+				uint32_t victimSize = 0;
+				for (int offset = 1; offset < count; offset++)
+				{
+					int index = (worker + offset) % count;
+					uint64_t range = queue.Ranges[index].Range.load();
+					if (RangeBegin(range) < RangeEnd(range) && RangeEnd(range) - RangeBegin(range) > victimSize)
+					{
+						victimIndex = index;
+						victimRange = range;
+						victimSize = RangeEnd(range) - RangeBegin(range);
+					}
+				}
+				if (victimIndex < 0)
+				{
+					return false;
+				}
+
+				uint32_t begin = RangeBegin(victimRange);
+				uint32_t end = RangeEnd(victimRange);
+				uint32_t middle = end - (end - begin + 1) / 2;
+				if (queue.Ranges[victimIndex].Range.compare_exchange_strong(victimRange, PackRange(begin, middle)))
+				{
+					queue.Ranges[worker].Range.store(PackRange(middle, end));
+					return true;
+				}
+			}
+		}
+
+		void RunWorker(ParallelTask& task, WorkQueue& queue, int worker)
+		{
+			WorkRange& own = queue.Ranges[worker];
+			while (!queue.IsCancelled.load())
+			{
+				int index = 0;
+				if (!PopFront(own, index))
+				{
+					if (StealHalf(queue, worker))
+					{
+						continue;
+					}
+					return;
+				}
+				try
+				{
+					task(index);
+				}
+				catch (...)
+				{
+					std::lock_guard<std::mutex> lock(queue.ExceptionMutex);
+					if (!queue.Exception)
+					{
+						queue.Exception = std::current_exception();
+					}
+					queue.IsCancelled.store(true);
+					return;
+				}
+			}
+		}
+	}
+}
+
+int LNLib::Parallel::GetThreadCount()
+{
+	unsigned int count = std::thread::hardware_concurrency();
+	return count == 0 ? 1 : static_cast<int>(count);
+}
+
+void LNLib::Parallel::For(int taskCount, ParallelTask& task, int threadCount)
+{
+	if (taskCount <= 0)
+	{
+		return;
+	}
+	if (threadCount <= 0)
+	{
+		threadCount = GetThreadCount();
+	}
+	threadCount = std::min(threadCount, taskCount);
+
+	// Every worker starts with an equal contiguous slice and steals half of a busy slice when done.
+	WorkQueue queue(threadCount);
+	for (int i = 0; i < threadCount; i++)
+	{
+		uint32_t begin = static_cast<uint32_t>(static_cast<int64_t>(taskCount) * i / threadCount);
+		uint32_t end = static_cast<uint32_t>(static_cast<int64_t>(taskCount) * (i + 1) / threadCount);
+		queue.Ranges[i].Range.store(PackRange(begin, end));
+	}
+
+	std::vector<std::thread> workers;
+	workers.reserve(threadCount - 1);
+	for (int i = 1; i < threadCount; i++)
+	{
+		workers.emplace_back(RunWorker, std::ref(task), std::ref(queue), i);
+	}
+	RunWorker(task, queue, 0);
+	for (int i = 0; i < workers.size(); i++)
+	{
+		workers[i].join();
+	}
+
+	if (queue.Exception)
+	{
+		std::rethrow_exception(queue.Exception);
+	}
+}
+
+void LNLib::Parallel::For(int taskCount, ParallelTask& task, ParallelExecutor* executor)
+{
+	if (executor == nullptr)
+	{
+		For(taskCount, task, 0);
+		return;
+	}
+	if (taskCount <= 0)
+	{
+		return;
+	}
+	executor->Execute(taskCount, task);
+}
@@ -0,0 +1,126 @@
+/*
+ * Author:
+ * 2024/10/14 - Yuqing Liang (BIMCoder Liang)
+ * bim.frankliang@foxmail.com
+ * 微信公众号：BIMCoder梁老师
+ *
+ * Use of this source code is governed by a GPL-3.0 license that can be found in
+ * the LICENSE file.
+ */
+
+#include "PickingScene.h"
+#include "PreparedCurve.h"
+#include "PreparedSurface.h"
+#include "Intersection.h"
+#include "ControlPointsUtils.h"
+#include "XYZ.h"
+#include "UV.h"
+#include "LNLibExceptions.h"
+
+namespace LNLib
+{
+	namespace
+	{
+		/// <summary>
+		/// Items below the surface count are surfaces, the others curves.
+		/// </summary>
+		class SceneRayFunction : public ItemRayFunction
+		{
+		public:
+			SceneRayFunction(const std::vector<std::unique_ptr<PreparedSurface>>& surfaces, const std::vector<std::unique_ptr<PreparedCurve>>& curves, double tolerance, LN_PickResult& result)
+				: _surfaces(surfaces), _curves(curves), _tolerance(tolerance), _result(result)
+			{
+			}
+
+			bool operator()(int itemIndex, const XYZ& origin, const XYZ& direction, double maxParam, double& param) override
+			{
+				int surfaceCount = _surfaces.size();
+				if (itemIndex < surfaceCount)
+				{
+					LN_RaySurfaceIntersection hit;
+					if (!Intersection::ComputeRaySurface(origin, direction, *_surfaces[itemIndex], _tolerance, maxParam, hit))
+					{
+						return false;
+					}
+					param = hit.RayParam;
+					_result.SurfaceIndex = itemIndex;
+					_result.CurveIndex = -1;
+					_result.RayParam = hit.RayParam;
+					_result.SurfaceParam = hit.SurfaceParam;
+					_result.CurveParam = 0.0;
+					_result.Point = hit.Point;
+					return true;
+				}
+
+				LN_RayCurveIntersection hit;
+				if (!Intersection::ComputeRayCurve(origin, direction, *_curves[itemIndex - surfaceCount], _tolerance, maxParam, hit))
+				{
+					return false;
+				}
+				param = hit.RayParam;
+				_result.SurfaceIndex = -1;
+				_result.CurveIndex = itemIndex - surfaceCount;
+				_result.RayParam = hit.RayParam;
+				_result.SurfaceParam = UV(0, 0);
+				_result.CurveParam = hit.CurveParam;
+				_result.Point = hit.Point;
+				return true;
+			}
+
+		private:
+			const std::vector<std::unique_ptr<PreparedSurface>>& _surfaces;
+			const std::vector<std::unique_ptr<PreparedCurve>>& _curves;
+			double _tolerance;
+			LN_PickResult& _result;
+		};
+	}
+}
+
+LNLib::PickingScene::PickingScene(const std::vector<LN_NurbsSurface>& surfaces, const std::vector<LN_NurbsCurve>& curves)
+{
+	std::vector<LN_BoundingBox> boxes;
+	boxes.reserve(surfaces.size() + curves.size());
+	_surfaces.reserve(surfaces.size());
+	for (int i = 0; i < surfaces.size(); i++)
+	{
+		_surfaces.emplace_back(new PreparedSurface(surfaces[i]));
+		boxes.emplace_back(ControlPointsUtils::ComputeBoundingBox(surfaces[i].ControlPoints));
+	}
+	_curves.reserve(curves.size());
+	for (int i = 0; i < curves.size(); i++)
+	{
+		_curves.emplace_back(new PreparedCurve(curves[i]));
+		boxes.emplace_back(ControlPointsUtils::ComputeBoundingBox(curves[i].ControlPoints));
+	}
+	_hierarchy.Build(boxes);
+}
+
+LNLib::PickingScene::~PickingScene()
+{
+}
+
+int LNLib::PickingScene::GetSurfaceCount() const
+{
+	return _surfaces.size();
+}
+
+int LNLib::PickingScene::GetCurveCount() const
+{
+	return _curves.size();
+}
+
+bool LNLib::PickingScene::Pick(const XYZ& origin, const XYZ& direction, double tolerance, LN_PickResult& result) const
+{
+	VALIDATE_ARGUMENT(!direction.IsZero(), "direction", "Direction must not be zero vector.");
+	VALIDATE_ARGUMENT(tolerance > 0.0, "tolerance", "Tolerance must greater than zero.");
+
+	LN_PickResult nearest;
+	SceneRayFunction function(_surfaces, _curves, tolerance, nearest);
+	double hitParam = 0.0;
+	if (_hierarchy.FindFirstHit(origin, direction, tolerance, function, hitParam) < 0)
+	{
+		return false;
+	}
+	result = nearest;
+	return true;
+}
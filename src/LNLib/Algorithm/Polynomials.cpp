@@ -9,10 +9,12 @@
  */
 
 #include "Polynomials.h"
+#include "Constants.h"
 #include "UV.h"
 #include "MathUtils.h"
 #include "ValidationUtils.h"
 #include "LNLibExceptions.h"
+#include "Instrumentation.h"
 #include <algorithm>
 
 using namespace LNLib;
@@ -65,6 +67,15 @@ std::vector<double> Polynomials::AllBernstein(int degree, double paramT)
 	VALIDATE_ARGUMENT_RANGE(paramT, 0.0, 1.0);
 
 	std::vector<double> bernsteinArray(degree + 1);
+	AllBernstein(degree, paramT, bernsteinArray.data());
+	return bernsteinArray;
+}
+
+void Polynomials::AllBernstein(int degree, double paramT, double* bernsteinArray)
+{
+	VALIDATE_ARGUMENT(degree > 0, "degree", "Degree must greater than zero.");
+	VALIDATE_ARGUMENT_RANGE(paramT, 0.0, 1.0);
+
 	bernsteinArray[0] = 1.0;
 
 	double t1 = 1.0 - paramT;
@@ -79,7 +90,6 @@ std::vector<double> Polynomials::AllBernstein(int degree, double paramT)
 		}
 		bernsteinArray[j] = saved;
 	}
-	return bernsteinArray;
 }
 
 double Polynomials::Horner(int degreeU, int degreeV, const std::vector<std::vector<double>>& coefficients, UV& uv)
@@ -127,7 +137,13 @@ int LNLib::Polynomials::GetKnotSpanIndex(int degree, const std::vector<double>&
 	VALIDATE_ARGUMENT(ValidationUtils::IsValidKnotVector(knotVector), "knotVector", "KnotVector must be a nondecreasing sequence of real numbers.");
 	VALIDATE_ARGUMENT_RANGE(paramT, knotVector[0], knotVector[knotVector.size() - 1]);
 
-	int n = knotVector.size() - degree - 2;
+	return GetKnotSpanIndex(degree, knotVector.data(), knotVector.size(), paramT);
+}
+
+int LNLib::Polynomials::GetKnotSpanIndex(int degree, const double* knotVector, int knotCount, double paramT)
+{
+	LNLIB_COUNT(SpanSearches, 1);
+	int n = knotCount - degree - 2;
 	if (MathUtils::IsGreaterThanOrEqual(paramT, knotVector[n + 1]))
 	{
 		return n;
@@ -157,36 +173,116 @@ int LNLib::Polynomials::GetKnotSpanIndex(int degree, const std::vector<double>&
 	return mid;
 }
 
+int LNLib::Polynomials::GetKnotSpanIndex(int degree, const std::vector<double>& knotVector, double paramT, int startSpanIndex)
+{
+	LNLIB_COUNT(SpanSearches, 1);
+	int n = knotVector.size() - degree - 2;
+	if (MathUtils::IsGreaterThanOrEqual(paramT, knotVector[n + 1]))
+	{
+		return n;
+	}
+	if (MathUtils::IsLessThanOrEqual(paramT, knotVector[degree]))
+	{
+		return degree;
+	}
+
+	int spanIndex = std::min(std::max(startSpanIndex, degree), n);
+	if (paramT < knotVector[spanIndex])
+	{
+		int low = degree;
+		int high = spanIndex;
+		int mid = (low + high) / 2;
+		while (paramT < knotVector[mid] ||
+			   paramT >= knotVector[mid + 1])
+		{
+			if (paramT < knotVector[mid])
+			{
+				high = mid;
+			}
+			else
+			{
+				low = mid;
+			}
+			mid = (low + high) / 2;
+		}
+		return mid;
+	}
+
+	while (paramT >= knotVector[spanIndex + 1])
+	{
+		spanIndex++;
+	}
+	return spanIndex;
+}
+
 std::vector<double> LNLib::Polynomials::BasisFunctions(int spanIndex, int degree, const std::vector<double>& knotVector, double paramT)
 {
-	VALIDATE_ARGUMENT(spanIndex >= 0, "spanIndex", "SpanIndex must greater than or equals zero.");
 	VALIDATE_ARGUMENT(degree >= 0, "degree", "Degree must greater than or equals zero.");
+
+	VALIDATE_ARGUMENT(spanIndex >= 0, "spanIndex", "SpanIndex must greater than or equals zero.");
 	VALIDATE_ARGUMENT(knotVector.size() > 0, "knotVector", "KnotVector size must greater than zero.");
 	VALIDATE_ARGUMENT(ValidationUtils::IsValidKnotVector(knotVector), "knotVector", "KnotVector must be a nondecreasing sequence of real numbers.");
 	VALIDATE_ARGUMENT_RANGE(paramT, knotVector[0], knotVector[knotVector.size() - 1]);
 
 	std::vector<double> basisFunctions(degree + 1);
-	basisFunctions[0] = 1.0;
+	BasisFunctions(spanIndex, degree, knotVector, paramT, basisFunctions.data());
+	return basisFunctions;
+}
 
-	std::vector<double> left(degree + 1);
-	std::vector<double> right(degree + 1);
+LNLib::KnotSpanCursor::KnotSpanCursor(int degree, const std::vector<double>& knotVector)
+	: _degree(degree), _knotVector(knotVector), _spanIndex(degree)
+{
+}
 
-	for (int j = 1; j <= degree; j++)
+int LNLib::KnotSpanCursor::Find(double paramT)
+{
+	_spanIndex = Polynomials::GetKnotSpanIndex(_degree, _knotVector, paramT, _spanIndex);
+	return _spanIndex;
+}
+
+int LNLib::KnotSpanCursor::GetSpanIndex() const
+{
+	return _spanIndex;
+}
+
+void LNLib::Polynomials::BasisFunctions(int spanIndex, int degree, const std::vector<double>& knotVector, double paramT, double* basisFunctions)
+{
+	BasisFunctions(spanIndex, degree, knotVector.data(), paramT, basisFunctions);
+}
+
+void LNLib::Polynomials::BasisFunctions(int spanIndex, int degree, const double* knotVector, double paramT, double* basisFunctions)
+{
+	switch (degree)
 	{
-		left[j] = paramT - knotVector[spanIndex + 1 - j];
-		right[j] = knotVector[spanIndex + j] - paramT;
+	case 1:
+		BasisFunctions<1>(spanIndex, knotVector, paramT, basisFunctions);
+		return;
+	case 2:
+		BasisFunctions<2>(spanIndex, knotVector, paramT, basisFunctions);
+		return;
+	case 3:
+		BasisFunctions<3>(spanIndex, knotVector, paramT, basisFunctions);
+		return;
+	default:
+		break;
+	}
 
+	basisFunctions[0] = 1.0;
+
+	for (int j = 1; j <= degree; j++)
+	{
 		double saved = 0.0;
 
 		for (int r = 0; r < j; r++)
 		{
-			double temp = basisFunctions[r] / (right[r + 1] + left[j - r]);
-			basisFunctions[r] = saved + right[r + 1] * temp;
-			saved = left[j - r] * temp;
+			double right = knotVector[spanIndex + r + 1] - paramT;
+			double left = paramT - knotVector[spanIndex + 1 - j + r];
+			double temp = basisFunctions[r] / (right + left);
+			basisFunctions[r] = saved + right * temp;
+			saved = left * temp;
 		}
 		basisFunctions[j] = saved;
 	}
-	return basisFunctions;
 }
 
 std::vector<std::vector<double>> LNLib::Polynomials::BasisFunctionsDerivatives(int spanIndex, int degree,  int derivative, const std::vector<double>& knotVector, double paramT)
@@ -198,13 +294,55 @@ std::vector<std::vector<double>> LNLib::Polynomials::BasisFunctionsDerivatives(i
 	VALIDATE_ARGUMENT(ValidationUtils::IsValidKnotVector(knotVector), "knotVector", "KnotVector must be a nondecreasing sequence of real numbers.");
 	VALIDATE_ARGUMENT_RANGE(paramT, knotVector[0], knotVector[knotVector.size() - 1]);
 
+	std::vector<double> flat((derivative + 1) * (degree + 1));
+	BasisFunctionsDerivatives(spanIndex, degree, derivative, knotVector, paramT, flat.data());
+
 	std::vector<std::vector<double>> derivatives(derivative + 1, std::vector<double>(degree + 1));
-	std::vector<std::vector<double>> ndu(degree + 1,std::vector<double>(degree + 1));
+	for (int k = 0; k <= derivative; k++)
+	{
+		std::copy(flat.begin() + k * (degree + 1), flat.begin() + (k + 1) * (degree + 1), derivatives[k].begin());
+	}
+	return derivatives;
+}
 
-	ndu[0][0] = 1.0;
+void LNLib::Polynomials::BasisFunctionsDerivatives(int spanIndex, int degree, int derivative, const std::vector<double>& knotVector, double paramT, double* derivatives)
+{
+	switch (degree)
+	{
+	case 1:
+		BasisFunctionsDerivatives<1>(spanIndex, derivative, knotVector, paramT, derivatives);
+		return;
+	case 2:
+		BasisFunctionsDerivatives<2>(spanIndex, derivative, knotVector, paramT, derivatives);
+		return;
+	case 3:
+		BasisFunctionsDerivatives<3>(spanIndex, derivative, knotVector, paramT, derivatives);
+		return;
+	default:
+		break;
+	}
+
+	// Working storage stays on the stack for degree below MaxStackBasisSize.
+	int size = degree + 1;
+	double stackNdu[Constants::MaxStackBasisSize * Constants::MaxStackBasisSize];
+	double stackLeft[Constants::MaxStackBasisSize];
+	double stackRight[Constants::MaxStackBasisSize];
+	double stackA[2 * Constants::MaxStackBasisSize];
+	std::vector<double> heap;
+	double* ndu = stackNdu;
+	double* left = stackLeft;
+	double* right = stackRight;
+	double* a = stackA;
+	if (degree >= Constants::MaxStackBasisSize)
+	{
+		heap.resize(size * size + 4 * size);
+		ndu = heap.data();
+		left = ndu + size * size;
+		right = left + size;
+		a = right + size;
+	}
 
-	std::vector<double> left(degree + 1);
-	std::vector<double> right(degree + 1);
+	ndu[0] = 1.0;
 
 	double saved = 0.0;
 	double temp = 0.0;
@@ -217,26 +355,25 @@ std::vector<std::vector<double>> LNLib::Polynomials::BasisFunctionsDerivatives(i
 		saved = 0.0;
 		for (int r = 0; r < j; r++)
 		{
-			ndu[j][r] = right[r + 1] + left[j - r];
-			temp = ndu[r][j - 1] / ndu[j][r];
+			ndu[j * size + r] = right[r + 1] + left[j - r];
+			temp = ndu[r * size + j - 1] / ndu[j * size + r];
 
-			ndu[r][j] = saved + right[r + 1] * temp;
+			ndu[r * size + j] = saved + right[r + 1] * temp;
 			saved = left[j - r] * temp;
 		}
-		ndu[j][j] = saved;
+		ndu[j * size + j] = saved;
 	}
 
 	for (int j = 0; j <= degree; j++)
 	{
-		derivatives[0][j] = ndu[j][degree];
+		derivatives[j] = ndu[j * size + degree];
 	}
 
-	std::vector<std::vector<double>> a(2,std::vector<double>(degree + 1));
 	for (int r = 0; r <= degree; r++)
 	{
 		int s1 = 0; 
 		int s2 = 1;
-		a[0][0] = 1.0;
+		a[0] = 1.0;
 
 		for (int k = 1; k <= derivative; k++)
 		{
@@ -246,8 +383,8 @@ std::vector<std::vector<double>> LNLib::Polynomials::BasisFunctionsDerivatives(i
 
 			if (r >= k)
 			{
-				a[s2][0] = a[s1][0] / ndu[pk + 1][rk];
-				d = a[s2][0] * ndu[rk][pk];
+				a[s2 * size] = a[s1 * size] / ndu[(pk + 1) * size + rk];
+				d = a[s2 * size] * ndu[rk * size + pk];
 			}
 
 			int j1 = 0;
@@ -265,15 +402,15 @@ std::vector<std::vector<double>> LNLib::Polynomials::BasisFunctionsDerivatives(i
 
 			for (int j = j1; j <= j2; j++)
 			{
-				a[s2][j] = (a[s1][j] - a[s1][j - 1]) / ndu[pk + 1][rk + j];
-				d += a[s2][j] * ndu[rk + j][pk];
+				a[s2 * size + j] = (a[s1 * size + j] - a[s1 * size + j - 1]) / ndu[(pk + 1) * size + rk + j];
+				d += a[s2 * size + j] * ndu[(rk + j) * size + pk];
 			}
 			if (r <= pk)
 			{
-				a[s2][k] = -a[s1][k - 1] / ndu[pk + 1][r];
-				d += a[s2][k] * ndu[r][pk];
+				a[s2 * size + k] = -a[s1 * size + k - 1] / ndu[(pk + 1) * size + r];
+				d += a[s2 * size + k] * ndu[r * size + pk];
 			}
-			derivatives[k][r] = d;
+			derivatives[k * (degree + 1) + r] = d;
 
 			int temp = s1; 
 			s1 = s2; 
@@ -286,11 +423,10 @@ std::vector<std::vector<double>> LNLib::Polynomials::BasisFunctionsDerivatives(i
 	{
 		for (int j = 0; j <= degree; j++)
 		{
-			derivatives[k][j] *= r;
+			derivatives[k * (degree + 1) + j] *= r;
 		}
 		r *= degree - k;
 	}
-	return derivatives;
 }
 
 double LNLib::Polynomials::OneBasisFunction(int spanIndex, int degree, const std::vector<double>& knotVector, double paramT)
@@ -472,13 +608,13 @@ std::vector<std::vector<double>> LNLib::Polynomials::BezierToPowerMatrix(int deg
 	}
 
 	matrix[0][0] = matrix[degree][degree] = 1.0;
-	matrix[degree][0] = degree % 2 == 0 ? -1.0 : 1.0;
+	matrix[degree][0] = degree % 2 == 0 ? 1.0 : -1.0;
 
 	double sign = -1.0;
 	for (int i = 1; i < degree; i++)
 	{
 		matrix[i][i] = MathUtils::Binomial(degree,i);
-		matrix[i][0] = matrix[degree][degree - 1] = sign * matrix[i][i];
+		matrix[i][0] = matrix[degree][degree - i] = sign * matrix[i][i];
 		sign = -sign;
 	}
 
@@ -519,17 +655,49 @@ std::vector<std::vector<double>> LNLib::Polynomials::PowerToBezierMatrix(int deg
 
 	for (int k = 1; k < k1; k++)
 	{
-		for (int j = k + 1; j < pk; j++)
+		for (int j = k + 1; j <= pk; j++)
 		{
 			double d = 0.0;
 			for (int i = k; i < j; i++)
 			{
 				d = d - matrix[j][i] * inverseMatrix[i][k];
 			}
-			inverseMatrix[j][k] = d / (inverseMatrix[j][j]);
+			inverseMatrix[j][k] = d / (matrix[j][j]);
 			inverseMatrix[pk][degree - j] = inverseMatrix[j][k];
 		}
 		pk = pk - 1;
 	}
 	return inverseMatrix;
 }
+
+std::vector<std::vector<double>> LNLib::Polynomials::BezierDegreeElevationMatrix(int degree, int times)
+{
+	VALIDATE_ARGUMENT(degree >= 0, "degree", "Degree must greater than or equals zero.");
+	VALIDATE_ARGUMENT(times > 0, "times", "Times must greater than zero.");
+
+	int ph = degree + times;
+	int ph2 = ph / 2;
+	std::vector<std::vector<double>> bezalfs(ph + 1, std::vector<double>(degree + 1));
+	bezalfs[0][0] = bezalfs[ph][degree] = 1.0;
+
+	for (int i = 1; i <= ph2; i++)
+	{
+		double inv = 1.0 / MathUtils::Binomial(ph, i);
+		int mpi = std::min(degree, i);
+
+		for (int j = std::max(0, i - times); j <= mpi; j++)
+		{
+			bezalfs[i][j] = inv * MathUtils::Binomial(degree, j) * MathUtils::Binomial(times, i - j);
+		}
+	}
+
+	for (int i = ph2 + 1; i <= ph - 1; i++)
+	{
+		int mpi = std::min(degree, i);
+		for (int j = std::max(0, i - times); j <= mpi; j++)
+		{
+			bezalfs[i][j] = bezalfs[ph - i][degree - j];
+		}
+	}
+	return bezalfs;
+}
@@ -13,8 +13,34 @@
 #include "Constants.h"
 #include "LNLibExceptions.h"
 #include <algorithm>
+#include <cmath>
 
 
+LNLib::EvaluationStatus LNLib::ValidationUtils::ResolveParameter(double& parameter, double min, double max, ParameterRangePolicy policy) noexcept
+{
+	if (std::isnan(parameter))
+	{
+		return EvaluationStatus::InvalidArgument;
+	}
+	if (parameter < min)
+	{
+		if (min - parameter > Constants::DoubleEpsilon && policy == ParameterRangePolicy::Fail)
+		{
+			return EvaluationStatus::OutOfRange;
+		}
+		parameter = min;
+	}
+	else if (parameter > max)
+	{
+		if (parameter - max > Constants::DoubleEpsilon && policy == ParameterRangePolicy::Fail)
+		{
+			return EvaluationStatus::OutOfRange;
+		}
+		parameter = max;
+	}
+	return EvaluationStatus::Success;
+}
+
 bool LNLib::ValidationUtils::IsValidBezier(int degree, int controlPointsCount)
 {
 	return controlPointsCount == degree + 1;
@@ -14,6 +14,7 @@
 #include "XYZW.h"
 #include "Matrix4d.h"
 #include "Polynomials.h"
+#include "Constants.h"
 #include "Intersection.h"
 #include "Interpolation.h"
 #include "ValidationUtils.h"
@@ -36,6 +37,33 @@ XYZ LNLib::BezierCurve::GetPointOnQuadraticArc(const XYZW& startPoint, const XYZ
 	return  ((1 - paramT) * (1 - paramT) * w0 * P0 + 2 * paramT * (1 - paramT) * w1 * P1 + paramT * paramT * w2 * P2) / ((1 - paramT) * (1 - paramT) * w0 + 2 * paramT * (1 - paramT) * w1 + paramT * paramT * w2);
 }
 
+void LNLib::BezierCurve::CreateBernsteinTable(int degree, const std::vector<double>& params, LN_BernsteinTable& table)
+{
+	VALIDATE_ARGUMENT(degree > 0, "degree", "Degree must greater than zero.");
+
+	int count = params.size();
+	table.Degree = degree;
+	table.Params = params;
+	table.Values.resize((degree + 1) * count);
+
+	double stackBernstein[Constants::MaxStackBasisSize];
+	std::vector<double> heapBernstein;
+	double* bernsteinArray = stackBernstein;
+	if (degree + 1 > Constants::MaxStackBasisSize)
+	{
+		heapBernstein.resize(degree + 1);
+		bernsteinArray = heapBernstein.data();
+	}
+	for (int i = 0; i < count; i++)
+	{
+		Polynomials::AllBernstein(degree, params[i], bernsteinArray);
+		for (int k = 0; k <= degree; k++)
+		{
+			table.Values[k * count + i] = bernsteinArray[k];
+		}
+	}
+}
+
 bool LNLib::BezierCurve::ComputerMiddleControlPointsOnQuadraticCurve(const XYZ& startPoint, const XYZ& startTangent, const XYZ& endPoint, const XYZ& endTangent, std::vector<XYZW>& controlPoints)
 {
 	XYZ chord = (endPoint - startPoint).Normalize();
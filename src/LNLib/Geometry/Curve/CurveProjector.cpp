@@ -0,0 +1,389 @@
+/*
+ * Author:
+ * 2024/10/14 - Yuqing Liang (BIMCoder Liang)
+ * bim.frankliang@foxmail.com
+ * 微信公众号：BIMCoder梁老师
+ *
+ * Use of this source code is governed by a GPL-3.0 license that can be found in
+ * the LICENSE file.
+ */
+
+#include "CurveProjector.h"
+#include "NurbsCurve.h"
+#include "Constants.h"
+#include "MathUtils.h"
+#include "ValidationUtils.h"
+#include "XYZ.h"
+#include "XYZW.h"
+#include "LNLibExceptions.h"
+#include "Instrumentation.h"
+#include <algorithm>
+#include <cmath>
+
+namespace LNLib
+{
+	const int ProjectionBlockSize = 256;
+
+	double GetSegmentParameter(const XYZ& start, const XYZ& end, const XYZ& point)
+	{
+		XYZ direction = end - start;
+		double squareLength = direction.SqrLength();
+		if (MathUtils::IsAlmostEqualTo(squareLength, 0.0))
+		{
+			return 0.0;
+		}
+		double t = (point - start).DotProduct(direction) / squareLength;
+		return std::max(0.0, std::min(1.0, t));
+	}
+
+	/// <summary>
+	/// The parameter of params whose curve point is nearest to point, Newton iteration may settle on a worse local minimum
+	/// than its seed and never reaches a minimum at a curve end.
+	/// </summary>
+	double GetNearestParameter(const LN_NurbsCurve& curve, const XYZ& point, const double* params, int count)
+	{
+		double nearest = params[0];
+		double minDistance = Constants::MaxDistance;
+		for (int i = 0; i < count; i++)
+		{
+			double distance = NurbsCurve::GetPointOnCurve(curve, params[i]).Distance(point);
+			if (distance < minDistance)
+			{
+				minDistance = distance;
+				nearest = params[i];
+			}
+		}
+		return nearest;
+	}
+
+	class SegmentDistanceFunction : public ItemDistanceFunction
+	{
+	public:
+		SegmentDistanceFunction(const std::vector<XYZ>& points) : _points(points) {}
+
+		double operator()(int itemIndex, const XYZ& point) override
+		{
+			const XYZ& start = _points[itemIndex];
+			const XYZ& end = _points[itemIndex + 1];
+			double t = GetSegmentParameter(start, end, point);
+			return point.Distance(start + (end - start) * t);
+		}
+
+	private:
+		const std::vector<XYZ>& _points;
+	};
+
+	class CurveProjectionTask : public ParallelTask
+	{
+	public:
+		CurveProjectionTask(const CurveProjector& projector, const std::vector<XYZ>& points, std::vector<double>& params)
+			: _projector(projector), _points(points), _params(params) {}
+
+		void operator()(int taskIndex) override
+		{
+			int start = taskIndex * ProjectionBlockSize;
+			int end = std::min(start + ProjectionBlockSize, static_cast<int>(_points.size()));
+			for (int i = start; i < end; i++)
+			{
+				_params[i] = _projector.GetParamOnCurve(_points[i]);
+			}
+		}
+
+	private:
+		const CurveProjector& _projector;
+		const std::vector<XYZ>& _points;
+		std::vector<double>& _params;
+	};
+}
+
+LNLib::CurveProjector::CurveProjector(const LN_NurbsCurve& curve)
+{
+	NurbsCurve::Check(curve);
+	_curve = curve;
+	_isClosed = NurbsCurve::IsClosed(curve);
+	_isLinear = NurbsCurve::IsLinear(curve);
+	_arcRadius = 0.0;
+	_arcSweepAngle = 0.0;
+	_isArc = !_isLinear && NurbsCurve::IsArc(curve, _arcCenter, _arcNormal, _arcRadius, _arcSweepAngle);
+	_startPoint = NurbsCurve::GetPointOnCurve(curve, curve.KnotVector[0]);
+	_endPoint = NurbsCurve::GetPointOnCurve(curve, curve.KnotVector[curve.KnotVector.size() - 1]);
+
+	XYZ minPoint = curve.ControlPoints[0].ToXYZ(true);
+	XYZ maxPoint = minPoint;
+	for (int i = 1; i < curve.ControlPoints.size(); i++)
+	{
+		XYZ point = curve.ControlPoints[i].ToXYZ(true);
+		for (int k = 0; k < 3; k++)
+		{
+			minPoint[k] = std::min(minPoint[k], point[k]);
+			maxPoint[k] = std::max(maxPoint[k], point[k]);
+		}
+	}
+	_chordTolerance = std::max(minPoint.Distance(maxPoint) * 1E-3, Constants::DistanceEpsilon);
+	NurbsCurve::Tessellate(curve, _chordTolerance, 0.2, _points, _knots);
+
+	std::vector<LN_BoundingBox> boxes(_points.size() - 1);
+	for (int i = 0; i < boxes.size(); i++)
+	{
+		const XYZ& start = _points[i];
+		const XYZ& end = _points[i + 1];
+		boxes[i].Min = XYZ(std::min(start.GetX(), end.GetX()), std::min(start.GetY(), end.GetY()), std::min(start.GetZ(), end.GetZ()));
+		boxes[i].Max = XYZ(std::max(start.GetX(), end.GetX()), std::max(start.GetY(), end.GetY()), std::max(start.GetZ(), end.GetZ()));
+	}
+	_hierarchy.Build(boxes);
+}
+
+double LNLib::CurveProjector::GetSeed(int segmentIndex, const XYZ& givenPoint) const
+{
+	double t = GetSegmentParameter(_points[segmentIndex], _points[segmentIndex + 1], givenPoint);
+	return _knots[segmentIndex] + (_knots[segmentIndex + 1] - _knots[segmentIndex]) * t;
+}
+
+double LNLib::CurveProjector::GetParamOnCurve(const XYZ& givenPoint) const
+{
+	return GetParamOnCurve(givenPoint, LN_ProjectionOptions());
+}
+
+double LNLib::CurveProjector::GetParamOnCurve(const XYZ& givenPoint, const LN_ProjectionOptions& options) const
+{
+	bool isConverged = false;
+	return Project(givenPoint, options, isConverged);
+}
+
+double LNLib::CurveProjector::GetParamOnCurve(const XYZ& givenPoint, double previousParam, const LN_ProjectionOptions& options) const
+{
+	const std::vector<double>& knotVector = _curve.KnotVector;
+	VALIDATE_ARGUMENT_RANGE(previousParam, knotVector[0], knotVector[knotVector.size() - 1]);
+	VALIDATE_ARGUMENT(options.LocalSearchRange >= 0, "options", "LocalSearchRange must greater than or equals zero.");
+
+	bool isConverged = false;
+	return Project(givenPoint, previousParam, options, isConverged);
+}
+
+LNLib::EvaluationStatus LNLib::CurveProjector::TryGetParamOnCurve(const XYZ& givenPoint, double& paramT, const LN_ProjectionOptions& options) const noexcept
+{
+	if (MathUtils::IsNaN(givenPoint.Length()) || options.MaxIterations < 0)
+	{
+		return EvaluationStatus::InvalidArgument;
+	}
+	try
+	{
+		bool isConverged = false;
+		paramT = Project(givenPoint, options, isConverged);
+		return isConverged ? EvaluationStatus::Success : EvaluationStatus::NotConverged;
+	}
+	catch (...)
+	{
+		return EvaluationStatus::Failed;
+	}
+}
+
+LNLib::EvaluationStatus LNLib::CurveProjector::TryGetParamOnCurve(const XYZ& givenPoint, double previousParam, double& paramT, const LN_ProjectionOptions& options, ParameterRangePolicy policy) const noexcept
+{
+	if (MathUtils::IsNaN(givenPoint.Length()) || options.MaxIterations < 0 || options.LocalSearchRange < 0)
+	{
+		return EvaluationStatus::InvalidArgument;
+	}
+	const std::vector<double>& knotVector = _curve.KnotVector;
+	EvaluationStatus status = ValidationUtils::ResolveParameter(previousParam, knotVector[0], knotVector[knotVector.size() - 1], policy);
+	if (status != EvaluationStatus::Success)
+	{
+		return status;
+	}
+	try
+	{
+		bool isConverged = false;
+		paramT = Project(givenPoint, previousParam, options, isConverged);
+		return isConverged ? EvaluationStatus::Success : EvaluationStatus::NotConverged;
+	}
+	catch (...)
+	{
+		return EvaluationStatus::Failed;
+	}
+}
+
+bool LNLib::CurveProjector::GetExactFootPoint(const XYZ& givenPoint, XYZ& footPoint) const
+{
+	if (_isLinear)
+	{
+		footPoint = _startPoint + (_endPoint - _startPoint) * GetSegmentParameter(_startPoint, _endPoint, givenPoint);
+		return true;
+	}
+	if (!_isArc)
+	{
+		return false;
+	}
+
+	XYZ vector = givenPoint - _arcCenter;
+	vector = vector - _arcNormal * vector.DotProduct(_arcNormal);
+	if (vector.IsZero())
+	{
+		// Every point of the circle is nearest to its axis.
+		footPoint = _startPoint;
+		return true;
+	}
+	XYZ start = _startPoint - _arcCenter;
+	double angle = std::atan2(start.CrossProduct(vector).DotProduct(_arcNormal), start.DotProduct(vector));
+	if (angle < 0)
+	{
+		angle += 2 * Constants::Pi;
+	}
+	if (angle > _arcSweepAngle)
+	{
+		footPoint = givenPoint.Distance(_startPoint) <= givenPoint.Distance(_endPoint) ? _startPoint : _endPoint;
+		return true;
+	}
+	footPoint = _arcCenter + vector.Normalize() * _arcRadius;
+	return true;
+}
+
+double LNLib::CurveProjector::Project(const XYZ& givenPoint, const LN_ProjectionOptions& options, bool& isConverged) const
+{
+	SegmentDistanceFunction function(_points);
+	double minDistance = Constants::MaxDistance;
+	XYZ footPoint;
+	if (GetExactFootPoint(givenPoint, footPoint))
+	{
+		// The foot point lies on the curve, Newton iteration towards it is well conditioned wherever the given point is.
+		int footIndex = _hierarchy.FindNearest(footPoint, function, minDistance);
+		double footParam = footIndex < 0 ? _curve.KnotVector[0] : GetSeed(footIndex, footPoint);
+		return Refine(footPoint, footParam, options, isConverged);
+	}
+
+	int segmentIndex = _hierarchy.FindNearest(givenPoint, function, minDistance);
+	double paramT = segmentIndex < 0 ? _curve.KnotVector[0] : GetSeed(segmentIndex, givenPoint);
+	const std::vector<double>& knotVector = _curve.KnotVector;
+	double candidates[4] = { Refine(givenPoint, paramT, options, isConverged), paramT, knotVector[0], knotVector[knotVector.size() - 1] };
+	return GetNearestParameter(_curve, givenPoint, candidates, 4);
+}
+
+double LNLib::CurveProjector::Project(const XYZ& givenPoint, double previousParam, const LN_ProjectionOptions& options, bool& isConverged) const
+{
+	if (_isLinear || _isArc)
+	{
+		return Project(givenPoint, options, isConverged);
+	}
+	double paramT = Refine(givenPoint, previousParam, options, isConverged);
+	double distance = NurbsCurve::GetPointOnCurve(_curve, paramT).Distance(givenPoint);
+
+	int segmentCount = _points.size() - 1;
+	int center = std::upper_bound(_knots.begin(), _knots.end(), previousParam) - _knots.begin() - 1;
+	center = std::max(0, std::min(segmentCount - 1, center));
+	int range = options.LocalSearchRange;
+	bool isWholeCurve = 2 * range + 1 >= segmentCount;
+	int first = isWholeCurve ? 0 : center - range;
+	int last = isWholeCurve ? segmentCount - 1 : center + range;
+	if (!_isClosed)
+	{
+		first = std::max(0, first);
+		last = std::min(segmentCount - 1, last);
+	}
+
+	SegmentDistanceFunction function(_points);
+	double localDistance = Constants::MaxDistance;
+	int localIndex = -1;
+	int localPosition = first;
+	for (int i = first; i <= last; i++)
+	{
+		int index = (i + segmentCount) % segmentCount;
+		double segmentDistance = function(index, givenPoint);
+		if (segmentDistance < localDistance)
+		{
+			localDistance = segmentDistance;
+			localIndex = index;
+			localPosition = i;
+		}
+	}
+	// A window clipped by the curve end does not hide a nearer segment on that side.
+	bool isOnBorder = !isWholeCurve &&
+		((localPosition == first && (_isClosed || first > 0)) || (localPosition == last && (_isClosed || last < segmentCount - 1)));
+
+	if (isOnBorder)
+	{
+		return Project(givenPoint, options, isConverged);
+	}
+	// The polyline is within the chord tolerance of the curve, a converged result that near to the best segment is the local foot point.
+	if (isConverged && distance <= localDistance + _chordTolerance)
+	{
+		return paramT;
+	}
+
+	bool isPreviousConverged = isConverged;
+	double restarted = Refine(givenPoint, GetSeed(localIndex, givenPoint), options, isConverged);
+	double restartedDistance = NurbsCurve::GetPointOnCurve(_curve, restarted).Distance(givenPoint);
+	if (restartedDistance < distance)
+	{
+		return restarted;
+	}
+	isConverged = isPreviousConverged;
+	return paramT;
+}
+
+double LNLib::CurveProjector::Refine(const XYZ& givenPoint, double paramT, const LN_ProjectionOptions& options, bool& isConverged) const
+{
+	const std::vector<double>& knotVector = _curve.KnotVector;
+	double a = knotVector[0];
+	double b = knotVector[knotVector.size() - 1];
+
+	isConverged = false;
+	int counters = 0;
+	while (counters < options.MaxIterations)
+	{
+		std::vector<XYZ> derivatives = NurbsCurve::ComputeRationalCurveDerivatives(_curve, 2, paramT);
+		XYZ difference = derivatives[0] - givenPoint;
+		double f = derivatives[1].DotProduct(difference);
+
+		double condition1 = difference.Length();
+		double condition2 = std::abs(f / (derivatives[1].Length() * condition1));
+		if (condition1 < options.DistanceTolerance ||
+			condition2 < options.CosineTolerance)
+		{
+			isConverged = true;
+			return paramT;
+		}
+
+		double df = derivatives[2].DotProduct(difference) + derivatives[1] * derivatives[1];
+		if (MathUtils::IsAlmostEqualTo(df, 0.0))
+		{
+			return paramT;
+		}
+		double temp = paramT - f / df;
+
+		if (!_isClosed)
+		{
+			temp = std::max(a, std::min(b, temp));
+		}
+		else
+		{
+			if (temp < a)
+			{
+				temp = b - (a - temp);
+			}
+			if (temp > b)
+			{
+				temp = a + (temp - b);
+			}
+		}
+
+		double condition4 = ((temp - paramT) * derivatives[1]).Length();
+		if (condition4 < options.DistanceTolerance)
+		{
+			isConverged = true;
+			return temp;
+		}
+
+		paramT = temp;
+		counters++;
+		LNLIB_COUNT(NewtonIterations, 1);
+	}
+	return paramT;
+}
+
+std::vector<double> LNLib::CurveProjector::GetParamsOnCurve(const std::vector<XYZ>& givenPoints, ParallelExecutor* executor) const
+{
+	std::vector<double> params(givenPoints.size());
+	CurveProjectionTask task(*this, givenPoints, params);
+	int blocks = (givenPoints.size() + ProjectionBlockSize - 1) / ProjectionBlockSize;
+	Parallel::For(blocks, task, executor);
+	return params;
+}
@@ -21,24 +21,271 @@
 #include "Projection.h"
 #include "ValidationUtils.h"
 #include "KnotVectorUtils.h"
+#include "ControlPointsUtils.h"
 #include "Interpolation.h"
 #include "Integrator.h"
+#include "PreparedCurve.h"
+#include "Parallel.h"
+#include "Instrumentation.h"
+#include "Cancellation.h"
 #include "LNLibExceptions.h"
 #include "LNObject.h"
 #include <vector>
 #include <algorithm>
+#include <queue>
+#include <map>
 
 namespace LNLib
 {
+	/// <summary>
+	/// Convert Cw(paramT) derivatives to C(paramT) derivatives.
+	/// </summary>
+	void ToRationalDerivatives(const XYZW* ders, int derivative, XYZ* derivatives)
+	{
+		for (int k = 0; k <= derivative; k++)
+		{
+			XYZ v = XYZ(ders[k].GetWX(), ders[k].GetWY(), ders[k].GetWZ());
+			for (int i = 1; i <= k; i++)
+			{
+				v = v - MathUtils::Binomial(k, i) * ders[i].GetW() * derivatives[k - i];
+			}
+			derivatives[k] = v / ders[0].GetW();
+		}
+	}
+
+	std::vector<XYZ> ToRationalDerivatives(const std::vector<XYZW>& ders)
+	{
+		std::vector<XYZ> derivatives(ders.size());
+		ToRationalDerivatives(ders.data(), ders.size() - 1, derivatives.data());
+		return derivatives;
+	}
+
+	/// <summary>
+	/// Compute Cw(paramT) derivatives at known span into workspace.WeightedDerivatives.
+	/// </summary>
+	void ComputeWeightedDerivatives(const LN_NurbsCurve& curve, int spanIndex, int derivative, double paramT, LN_DerivativeWorkspace& workspace)
+	{
+		int degree = curve.Degree;
+		const std::vector<XYZW>& controlPoints = curve.ControlPoints;
+
+		int du = std::min(derivative, degree);
+		workspace.BasisDerivatives.resize((du + 1) * (degree + 1));
+		double* nders = workspace.BasisDerivatives.data();
+		Polynomials::BasisFunctionsDerivatives(spanIndex, degree, du, curve.KnotVector, paramT, nders);
+
+		workspace.WeightedDerivatives.resize(derivative + 1);
+		XYZW* ders = workspace.WeightedDerivatives.data();
+		for (int k = 0; k <= derivative; k++)
+		{
+			XYZW der;
+			if (k <= du)
+			{
+				for (int j = 0; j <= degree; j++)
+				{
+					der += nders[k * (degree + 1) + j] * controlPoints[spanIndex - degree + j];
+				}
+			}
+			ders[k] = der;
+		}
+	}
+
+	/// <summary>
+	/// All weights exactly one make the curve a polynomial B-spline.
+	/// </summary>
+	bool HasUnitCurveWeights(const XYZW* controlPoints, int count)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			if (controlPoints[i].GetW() != 1.0) return false;
+		}
+		return true;
+	}
+
+	bool HasUnitCurveWeights(const std::vector<XYZW>& controlPoints)
+	{
+		return HasUnitCurveWeights(controlPoints.data(), controlPoints.size());
+	}
+
+	/// <summary>
+	/// Compute C(paramT) derivatives of a non-rational curve at known span,
+	/// with unit weights the derivatives of Cw(paramT) are the result and no quotient rule is needed.
+	/// </summary>
+	void ComputePolynomialCurveDerivatives(const LN_NurbsCurve& curve, int spanIndex, int derivative, double paramT, LN_DerivativeWorkspace& workspace, XYZ* derivatives)
+	{
+		int degree = curve.Degree;
+		const XYZW* points = &curve.ControlPoints[spanIndex - degree];
+
+		int du = std::min(derivative, degree);
+		workspace.BasisDerivatives.resize((du + 1) * (degree + 1));
+		double* nders = workspace.BasisDerivatives.data();
+		Polynomials::BasisFunctionsDerivatives(spanIndex, degree, du, curve.KnotVector, paramT, nders);
+
+		for (int k = 0; k <= derivative; k++)
+		{
+			double x = 0.0;
+			double y = 0.0;
+			double z = 0.0;
+			if (k <= du)
+			{
+				const double* n = &nders[k * (degree + 1)];
+				for (int j = 0; j <= degree; j++)
+				{
+					x += n[j] * points[j].GetWX();
+					y += n[j] * points[j].GetWY();
+					z += n[j] * points[j].GetWZ();
+				}
+			}
+			derivatives[k] = XYZ(x, y, z);
+		}
+	}
+
+	/// <summary>
+	/// Compute C(paramT) derivatives of an unchecked curve, only the degree + 1 weights of the span
+	/// decide between the polynomial and the quotient rule path so no full weight scan runs per call.
+	/// </summary>
+	void ComputeSpanCurveDerivatives(const LN_NurbsCurve& curve, int spanIndex, int derivative, double paramT, LN_DerivativeWorkspace& workspace, XYZ* derivatives)
+	{
+		int degree = curve.Degree;
+		if (HasUnitCurveWeights(&curve.ControlPoints[spanIndex - degree], degree + 1))
+		{
+			ComputePolynomialCurveDerivatives(curve, spanIndex, derivative, paramT, workspace, derivatives);
+			return;
+		}
+		ComputeWeightedDerivatives(curve, spanIndex, derivative, paramT, workspace);
+		ToRationalDerivatives(workspace.WeightedDerivatives.data(), derivative, derivatives);
+	}
+
+	void ComputeSpanCurveDerivatives(const LN_NurbsCurve& curve, int derivative, double paramT, LN_DerivativeWorkspace& workspace, XYZ* derivatives)
+	{
+		int spanIndex = Polynomials::GetKnotSpanIndex(curve.Degree, curve.KnotVector, paramT);
+		ComputeSpanCurveDerivatives(curve, spanIndex, derivative, paramT, workspace, derivatives);
+	}
+
+	double GetCurvatureFromDerivatives(const XYZ* derivatives)
+	{
+		XYZ d1 = derivatives[1];
+		XYZ d2 = derivatives[2];
+		if (MathUtils::IsAlmostEqualTo(d1.Length(), 1.0))
+		{
+			return d2.Length();
+		}
+		double numerator = d1.CrossProduct(d2).Length();
+		double denominator = pow(d1.Length(), 3);
+		return numerator / denominator;
+	}
+
+	XYZ GetNormalFromDerivatives(const XYZ* derivatives, CurveNormal normalType)
+	{
+		XYZ tangent = derivatives[1];
+		XYZ der2 = derivatives[2];
+		if (MathUtils::IsAlmostEqualTo(tangent.Length(), 1.0))
+		{
+			XYZ curveNormal = der2 / der2.Length();
+			if (normalType == CurveNormal::Normal)
+			{
+				return curveNormal;
+			}
+			else
+			{
+				return tangent.CrossProduct(curveNormal);
+			}
+		}
+		else
+		{
+			XYZ b = tangent.CrossProduct(der2) / (tangent.CrossProduct(der2).Length());
+			if (normalType == CurveNormal::Binormal)
+			{
+				return b;
+			}
+			else
+			{
+				return b.Normalize().CrossProduct(tangent.Normalize());
+			}
+		}
+	}
+
+	double GetTorsionFromDerivatives(const XYZ* derivatives)
+	{
+		XYZ tangent = derivatives[1];
+		XYZ der2 = derivatives[2];
+		XYZ der3 = derivatives[3];
+		if (MathUtils::IsAlmostEqualTo(tangent.Length(), 1.0))
+		{
+			double numerator = (tangent.CrossProduct(der2)).DotProduct(der3);
+			double denominator = der2.DotProduct(der2);
+			return numerator / denominator;
+		}
+		else
+		{
+			double numerator = (tangent.CrossProduct(der2)).DotProduct(der3);
+			double denominator = (tangent.CrossProduct(der2).DotProduct(tangent.CrossProduct(der3)));
+			return numerator / denominator;
+		}
+	}
+
 	class FirstDerivativeLengthFunction : public IntegrationFunction
 	{
+	public:
+		FirstDerivativeLengthFunction(const LN_CheckedNurbsCurve& curve) : _curve(curve)
+		{
+		}
+
 		double operator()(double parameter, void* customData)
 		{
-			LN_NurbsCurve* curve = (LN_NurbsCurve*)customData;
-			return NurbsCurve::ComputeRationalCurveDerivatives(*curve, 1, parameter)[1].Length();
+			XYZ derivatives[2];
+			NurbsCurve::ComputeRationalCurveDerivatives(_curve, 1, parameter, _workspace, derivatives);
+			return derivatives[1].Length();
 		}
+
+	private:
+		LN_CheckedNurbsCurve _curve;
+		LN_DerivativeWorkspace _workspace;
 	};
 
+	void UpdateBandwidth(int row, int firstColumn, int lastColumn, int& lowerBandwidth, int& upperBandwidth)
+	{
+		lowerBandwidth = std::max(lowerBandwidth, row - firstColumn);
+		upperBandwidth = std::max(upperBandwidth, lastColumn - row);
+	}
+
+	const int MaxTessellationDepth = 20;
+
+	double DistanceToSegment(const XYZ& point, const XYZ& start, const XYZ& end)
+	{
+		XYZ direction = end - start;
+		double squareLength = direction.DotProduct(direction);
+		if (MathUtils::IsAlmostEqualTo(squareLength, 0.0))
+		{
+			return point.Distance(start);
+		}
+		double t = (point - start).DotProduct(direction) / squareLength;
+		t = std::max(0.0, std::min(1.0, t));
+		return point.Distance(start + direction * t);
+	}
+
+	void TessellateInterval(const LN_CheckedNurbsCurve& curve, double start, double end, const XYZ& startPoint, const XYZ& middlePoint, const XYZ& endPoint, double chordTolerance, double angleTolerance, int depth, std::vector<XYZ>& tessellatedPoints, std::vector<double>& correspondingKnots)
+	{
+		double middle = (start + end) / 2.0;
+		XYZ quarterPoint = NurbsCurve::GetPointOnCurve(curve, (start + middle) / 2.0);
+		XYZ threeQuarterPoint = NurbsCurve::GetPointOnCurve(curve, (middle + end) / 2.0);
+
+		XYZ chord = endPoint - startPoint;
+		bool isFlat = DistanceToSegment(quarterPoint, startPoint, endPoint) <= chordTolerance &&
+			DistanceToSegment(middlePoint, startPoint, endPoint) <= chordTolerance &&
+			DistanceToSegment(threeQuarterPoint, startPoint, endPoint) <= chordTolerance &&
+			chord.AngleTo(quarterPoint - startPoint) <= angleTolerance &&
+			chord.AngleTo(endPoint - threeQuarterPoint) <= angleTolerance;
+
+		if (isFlat || depth >= MaxTessellationDepth)
+		{
+			correspondingKnots.emplace_back(end);
+			tessellatedPoints.emplace_back(endPoint);
+			return;
+		}
+		TessellateInterval(curve, start, middle, startPoint, quarterPoint, middlePoint, chordTolerance, angleTolerance, depth + 1, tessellatedPoints, correspondingKnots);
+		TessellateInterval(curve, middle, end, middlePoint, threeQuarterPoint, endPoint, chordTolerance, angleTolerance, depth + 1, tessellatedPoints, correspondingKnots);
+	}
+
 	double GetNode(int degree, const std::vector<double>& knotVector, int lastIndex)
 	{
 		double t = 0.0;
@@ -54,7 +301,7 @@ namespace LNLib
 		return t;
 	}
 
-	double CalculateLengthBySimpson(FirstDerivativeLengthFunction function, const LN_NurbsCurve& curve, double start, double end, double simpson, double tolearance)
+	double CalculateLengthBySimpson(FirstDerivativeLengthFunction& function, const LN_NurbsCurve& curve, double start, double end, double simpson, double tolearance)
 	{
 		double length = 0.0;
 		double m = (start + end) / 2.0;
@@ -65,203 +312,1261 @@ namespace LNLib
 		if (MathUtils::IsAlmostEqualTo(differ, 0.0) || 
 			MathUtils::IsLessThan(abs(differ) / 10.0, tolearance))
 		{
-			length = left + right + differ / 10.0;
+			length = left + right + differ / 10.0;
+		}
+		else
+		{
+			length = CalculateLengthBySimpson(function, curve, start, m, left, tolearance / 2.0) + CalculateLengthBySimpson(function, curve, m, end, right, tolearance / 2.0);
+		}
+		return length;
+	}
+
+	double InterpolateArcLength(const LN_ArcLengthTable& table, int index, double givenLength)
+	{
+		double s0 = table.Lengths[index];
+		double s1 = table.Lengths[index + 1];
+		double t0 = table.Params[index];
+		double t1 = table.Params[index + 1];
+		double h = s1 - s0;
+		if (MathUtils::IsAlmostEqualTo(h, 0.0))
+		{
+			return t0;
+		}
+
+		double x = (givenLength - s0) / h;
+		double x2 = x * x;
+		double x3 = x2 * x;
+		double h00 = 2 * x3 - 3 * x2 + 1;
+		double h10 = x3 - 2 * x2 + x;
+		double h01 = -2 * x3 + 3 * x2;
+		double h11 = x3 - x2;
+		double t = h00 * t0 + h10 * h * table.Derivatives[2 * index] + h01 * t1 + h11 * h * table.Derivatives[2 * index + 1];
+		return std::max(t0, std::min(t1, t));
+	}
+
+	int FindArcLengthInterval(const LN_ArcLengthTable& table, double givenLength)
+	{
+		int last = table.Lengths.size() - 1;
+		int index = std::upper_bound(table.Lengths.begin(), table.Lengths.end(), givenLength) - table.Lengths.begin() - 1;
+		return std::max(0, std::min(last - 1, index));
+	}
+
+	/// <summary>
+	/// Gauss-Legendre arc length of one Bezier segment.
+	/// </summary>
+	double GetBezierLengthByGaussLegendre(const LN_NurbsCurve& bezierCurve, LN_DerivativeWorkspace& workspace)
+	{
+		const std::vector<double>& bKnots = bezierCurve.KnotVector;
+		double a = bKnots[0];
+		double b = bKnots[bKnots.size() - 1];
+		double coefficient = (b - a) / 2.0;
+
+		double bLength = 0.0;
+		LN_CheckedNurbsCurve checkedBezier = NurbsCurve::Check(bezierCurve);
+		XYZ derivatives[2];
+		const std::vector<double>& abscissae = Integrator::GaussLegendreAbscissae;
+		int size = abscissae.size();
+		for (int i = 0; i < size; i++)
+		{
+			double t = coefficient * abscissae[i] + (a + b) / 2.0;
+			NurbsCurve::ComputeRationalCurveDerivatives(checkedBezier, 1, t, workspace, derivatives);
+			double derLength = derivatives[1].Length();
+			if (std::isnan(derLength))
+				derLength = 0.0;
+			bLength += Integrator::GaussLegendreWeights[i] * derLength;
+		}
+		return coefficient * bLength;
+	}
+
+	const int MaxBernsteinRootDepth = 32;
+
+	/// <summary>
+	/// Bernstein coefficients of the product of two Bernstein polynomials.
+	/// </summary>
+	std::vector<double> MultiplyBernstein(const std::vector<double>& left, const std::vector<double>& right)
+	{
+		int m = left.size() - 1;
+		int n = right.size() - 1;
+		std::vector<double> result(m + n + 1, 0.0);
+		for (int i = 0; i <= m; i++)
+		{
+			for (int j = 0; j <= n; j++)
+			{
+				result[i + j] += MathUtils::Binomial(m, i) * MathUtils::Binomial(n, j) * left[i] * right[j];
+			}
+		}
+		for (int k = 0; k <= m + n; k++)
+		{
+			result[k] /= MathUtils::Binomial(m + n, k);
+		}
+		return result;
+	}
+
+	/// <summary>
+	/// Roots of a Bernstein polynomial on [start, end] by subdivision.
+	/// Intervals whose coefficients share one sign hold no root by the convex hull property and are culled.
+	/// </summary>
+	void FindBernsteinRoots(const std::vector<double>& coefficients, double start, double end, int depth, std::vector<double>& roots)
+	{
+		bool hasPositive = false;
+		bool hasNegative = false;
+		for (int i = 0; i < coefficients.size(); i++)
+		{
+			hasPositive = hasPositive || coefficients[i] > 0.0;
+			hasNegative = hasNegative || coefficients[i] < 0.0;
+		}
+		if (!hasPositive || !hasNegative)
+		{
+			return;
+		}
+
+		if (depth >= MaxBernsteinRootDepth)
+		{
+			double first = coefficients.front();
+			double last = coefficients.back();
+			double ratio = MathUtils::IsAlmostEqualTo(first, last, 0.0) ? 0.5 : std::max(0.0, std::min(1.0, first / (first - last)));
+			roots.emplace_back(start + ratio * (end - start));
+			return;
+		}
+
+		int degree = coefficients.size() - 1;
+		std::vector<double> temp = coefficients;
+		std::vector<double> left(degree + 1);
+		std::vector<double> right(degree + 1);
+		left[0] = temp[0];
+		right[degree] = temp[degree];
+		for (int k = 1; k <= degree; k++)
+		{
+			for (int i = 0; i <= degree - k; i++)
+			{
+				temp[i] = 0.5 * (temp[i] + temp[i + 1]);
+			}
+			left[k] = temp[0];
+			right[degree - k] = temp[degree - k];
+		}
+		double middle = (start + end) / 2.0;
+		if (left[degree] == 0.0)
+		{
+			// Both halves end on this root and would cull it.
+			roots.emplace_back(middle);
+		}
+		FindBernsteinRoots(left, start, middle, depth + 1, roots);
+		FindBernsteinRoots(right, middle, end, depth + 1, roots);
+	}
+
+	void ExpandBoundingBox(LN_BoundingBox& box, const XYZ& point)
+	{
+		for (int k = 0; k < 3; k++)
+		{
+			box.Min[k] = std::min(box.Min[k], point[k]);
+			box.Max[k] = std::max(box.Max[k], point[k]);
+		}
+	}
+
+	struct CurveLengthBatchFunction
+	{
+		IntegratorType Type;
+		std::vector<double> Lengths;
+
+		CurveLengthBatchFunction(IntegratorType type, int count) : Type(type), Lengths(count)
+		{
+		}
+
+		void operator()(const LN_NurbsCurve& curve, int index)
+		{
+			Lengths[index] = NurbsCurve::ApproximateLength(curve, Type);
+		}
+	};
+
+	struct CurveTessellationBatchFunction
+	{
+		std::vector<std::vector<XYZ>>& TessellatedPoints;
+		std::vector<std::vector<double>>& CorrespondingKnots;
+
+		void operator()(const LN_NurbsCurve& curve, int index)
+		{
+			NurbsCurve::EquallyTessellate(curve, TessellatedPoints[index], CorrespondingKnots[index]);
+		}
+	};
+
+	struct CurveTransformBatchFunction
+	{
+		const Matrix4d& Matrix;
+		std::vector<LN_NurbsCurve> Curves;
+
+		CurveTransformBatchFunction(const Matrix4d& matrix, int count) : Matrix(matrix), Curves(count)
+		{
+		}
+
+		void operator()(const LN_NurbsCurve& curve, int index)
+		{
+			Curves[index] = NurbsCurve::CreateTransformed(curve, Matrix);
+		}
+	};
+
+	struct CurveTransformTask : public ParallelTask
+	{
+		std::vector<LN_NurbsCurve>& Curves;
+		const Matrix4d& Matrix;
+
+		CurveTransformTask(std::vector<LN_NurbsCurve>& curves, const Matrix4d& matrix) : Curves(curves), Matrix(matrix)
+		{
+		}
+
+		void operator()(int taskIndex) override
+		{
+			NurbsCurve::Transform(Curves[taskIndex], Matrix);
+		}
+	};
+
+	struct CurveDecompositionBatchFunction
+	{
+		std::vector<std::vector<LN_NurbsCurve>> Segments;
+
+		void operator()(const LN_NurbsCurve& curve, int index)
+		{
+			Segments[index] = NurbsCurve::DecomposeToBeziers(curve);
+		}
+	};
+
+	struct ErrorBoundApproximationJob
+	{
+		int Degree;
+		std::vector<XYZ> ThroughPoints;
+		double MaxError;
+		int MaxRemovals;
+		const CancellationToken* Cancellation;
+
+		LN_NurbsCurve operator()() const
+		{
+			LN_NurbsCurve result;
+			NurbsCurve::GlobalApproximationByErrorBound(Degree, ThroughPoints, MaxError, result, MaxRemovals, Cancellation);
+			return result;
+		}
+	};
+
+	const int OffsetDegree = 3;
+	const int OffsetSamplesPerSpan = 4;
+	const int OffsetMaxSubdivisionDepth = 16;
+	const int OffsetMaxRefinements = 16;
+
+	/// <summary>
+	/// Binormal used where the curve is straight, the Newell normal of the closed control polygon is the plane normal of a planar curve
+	/// oriented like its binormal along convex turns. A line gets the cross product of its chord with the coordinate axis least aligned to it.
+	/// </summary>
+	XYZ GetOffsetReferenceBinormal(const LN_NurbsCurve& curve)
+	{
+		const std::vector<XYZW>& controlPoints = curve.ControlPoints;
+		int size = controlPoints.size();
+		XYZ normal(0, 0, 0);
+		XYZ chord(0, 0, 0);
+		XYZ first = controlPoints[0].ToXYZ(true);
+		for (int i = 0; i < size; i++)
+		{
+			XYZ a = controlPoints[i].ToXYZ(true);
+			XYZ b = controlPoints[(i + 1) % size].ToXYZ(true);
+			normal += XYZ((a.GetY() - b.GetY()) * (a.GetZ() + b.GetZ()), (a.GetZ() - b.GetZ()) * (a.GetX() + b.GetX()), (a.GetX() - b.GetX()) * (a.GetY() + b.GetY()));
+			if ((a - first).SqrLength() > chord.SqrLength())
+			{
+				chord = a - first;
+			}
+		}
+		if (!normal.IsZero())
+		{
+			return normal.Normalize();
+		}
+
+		double x = fabs(chord.GetX());
+		double y = fabs(chord.GetY());
+		double z = fabs(chord.GetZ());
+		XYZ axis = x <= y && x <= z ? XYZ(1, 0, 0) : (y <= z ? XYZ(0, 1, 0) : XYZ(0, 0, 1));
+		return chord.CrossProduct(axis).Normalize();
+	}
+
+	/// <summary>
+	/// Offset point along CurveNormal::Normal from one derivative evaluation, workspace keeps repeated samples allocation free.
+	/// Curvature below Constants::DoubleEpsilon leaves the principal normal undefined, reference then replaces the binormal.
+	/// </summary>
+	XYZ GetOffsetCurvePoint(const LN_CheckedNurbsCurve& curve, double offset, double paramT, const XYZ& reference, LN_DerivativeWorkspace& workspace)
+	{
+		XYZ derivatives[3];
+		NurbsCurve::ComputeRationalCurveDerivatives(curve, 2, paramT, workspace, derivatives);
+		XYZ tangent = derivatives[1].Normalize();
+		XYZ binormal = derivatives[1].CrossProduct(derivatives[2]);
+		double speed = derivatives[1].Length();
+		if (binormal.Length() <= Constants::DoubleEpsilon * speed * speed * speed)
+		{
+			binormal = reference;
+		}
+		return derivatives[0] + offset * binormal.Normalize().CrossProduct(tangent).Normalize();
+	}
+
+	/// <summary>
+	/// Appends offset samples in (startParam, endParam], the interval is bisected until the midpoint lies
+	/// within maxError of the chord. Returns false when the depth limit stops a bisection outside maxError.
+	/// </summary>
+	bool SampleOffsetCurve(const LN_CheckedNurbsCurve& curve, double offset, double maxError, double startParam, const XYZ& startPoint, double endParam, const XYZ& endPoint, const XYZ& reference, int depth, LN_DerivativeWorkspace& workspace, std::vector<double>& params, std::vector<XYZ>& points)
+	{
+		double middleParam = 0.5 * (startParam + endParam);
+		XYZ middlePoint = GetOffsetCurvePoint(curve, offset, middleParam, reference, workspace);
+
+		XYZ chord = endPoint - startPoint;
+		XYZ toMiddle = middlePoint - startPoint;
+		double deviation = toMiddle.Length();
+		double chordLength = chord.Length();
+		if (!MathUtils::IsAlmostEqualTo(chordLength, 0.0))
+		{
+			double t = std::max(0.0, std::min(1.0, toMiddle.DotProduct(chord) / (chordLength * chordLength)));
+			deviation = middlePoint.Distance(startPoint + t * chord);
+		}
+
+		bool isWithin = MathUtils::IsLessThanOrEqual(deviation, maxError);
+		if (depth >= OffsetMaxSubdivisionDepth || isWithin)
+		{
+			params.emplace_back(endParam);
+			points.emplace_back(endPoint);
+			return isWithin;
+		}
+		bool isFirstWithin = SampleOffsetCurve(curve, offset, maxError, startParam, startPoint, middleParam, middlePoint, reference, depth + 1, workspace, params, points);
+		bool isSecondWithin = SampleOffsetCurve(curve, offset, maxError, middleParam, middlePoint, endParam, endPoint, reference, depth + 1, workspace, params, points);
+		return isFirstWithin && isSecondWithin;
+	}
+
+	/// <summary>
+	/// Least squares cubic on the given knot vector interpolating both end samples, parameterized like the base curve.
+	/// </summary>
+	void FitOffsetSamples(const std::vector<double>& knotVector, const std::vector<double>& params, const std::vector<XYZ>& points, LN_NurbsCurve& result)
+	{
+		int degree = OffsetDegree;
+		int n = knotVector.size() - degree - 1;
+		int m = points.size();
+
+		std::vector<XYZW> controlPoints(n);
+		controlPoints[0] = XYZW(points[0], 1);
+		controlPoints[n - 1] = XYZW(points[m - 1], 1);
+		if (n > 2)
+		{
+			std::vector<int> spanIndices;
+			std::vector<std::vector<double>> basis;
+			std::vector<std::vector<double>> normal = Interpolation::CreateLeastSquaresNormalMatrix(degree, knotVector, params, n, spanIndices, basis);
+			std::vector<XYZ> right = Interpolation::GetLeastSquaresRight(degree, n, spanIndices, basis, points);
+			std::vector<std::vector<double>> rhs(n - 2, std::vector<double>(3));
+			for (int i = 0; i < n - 2; i++)
+			{
+				for (int j = 0; j < 3; j++)
+				{
+					rhs[i][j] = right[i][j];
+				}
+			}
+			std::vector<std::vector<double>> solved = MathUtils::SolveSymmetricBandedLinearSystem(normal, degree, rhs);
+			for (int i = 0; i < n - 2; i++)
+			{
+				controlPoints[i + 1] = XYZW(XYZ(solved[i][0], solved[i][1], solved[i][2]), 1);
+			}
+		}
+
+		result.Degree = degree;
+		result.KnotVector = knotVector;
+		result.ControlPoints = controlPoints;
+	}
+
+	struct KnotRemovalCandidate
+	{
+		double Bound;
+		double Knot;
+		int Stamp;
+	};
+
+	struct KnotRemovalCandidateGreater
+	{
+		bool operator()(const KnotRemovalCandidate& left, const KnotRemovalCandidate& right) const
+		{
+			return left.Bound > right.Bound;
+		}
+	};
+
+	typedef std::priority_queue<KnotRemovalCandidate, std::vector<KnotRemovalCandidate>, KnotRemovalCandidateGreater> KnotRemovalQueue;
+
+	/// <summary>
+	/// Pushes the removal error bound of every distinct interior knot in [lowKnot, highKnot],
+	/// older entries of the same knot become stale.
+	/// </summary>
+	void PushKnotRemovalCandidates(const LN_NurbsCurve& curve, double lowKnot, double highKnot, std::map<double, int>& stamps, KnotRemovalQueue& queue)
+	{
+		int degree = curve.Degree;
+		const std::vector<double>& knotVector = curve.KnotVector;
+		int n = curve.ControlPoints.size() - 1;
+		for (int i = degree + 1; i <= n; i++)
+		{
+			double knot = knotVector[i];
+			if (knotVector[i + 1] == knot || knot < lowKnot || knot > highKnot) continue;
+			KnotRemovalCandidate candidate;
+			candidate.Bound = NurbsCurve::ComputerRemoveKnotErrorBound(curve, i);
+			candidate.Knot = knot;
+			candidate.Stamp = ++stamps[knot];
+			queue.push(candidate);
+		}
+	}
+
+	/// <summary>
+	/// The NURBS Book 2nd Edition Page185
+	/// Removes knot U[r] of multiplicity s once in place without checking the deviation, equations (5.28) and (5.29).
+	/// </summary>
+	void RemoveKnotInPlace(LN_NurbsCurve& curve, int r, int s)
+	{
+		int degree = curve.Degree;
+		std::vector<double>& knotVector = curve.KnotVector;
+		std::vector<XYZW>& controlPoints = curve.ControlPoints;
+
+		double u = knotVector[r];
+		int order = degree + 1;
+		int first = r - degree;
+		int last = r - s;
+		int off = first - 1;
+
+		std::vector<XYZW> temp(last - off + 2);
+		temp[0] = controlPoints[off];
+		temp[last + 1 - off] = controlPoints[last + 1];
+		int i = first;
+		int j = last;
+		int ii = 1;
+		int jj = last - off;
+		while (j - i > 0)
+		{
+			double alphai = (u - knotVector[i]) / (knotVector[i + order] - knotVector[i]);
+			double alphaj = (u - knotVector[j]) / (knotVector[j + order] - knotVector[j]);
+			temp[ii] = (controlPoints[i] - (1.0 - alphai) * temp[ii - 1]) / alphai;
+			temp[jj] = (controlPoints[j] - alphaj * temp[jj + 1]) / (1.0 - alphaj);
+			i++;
+			ii++;
+			j--;
+			jj--;
+		}
+
+		i = first;
+		j = last;
+		while (j - i > 0)
+		{
+			controlPoints[i] = temp[i - off];
+			controlPoints[j] = temp[j - off];
+			i++;
+			j--;
+		}
+		controlPoints.erase(controlPoints.begin() + (2 * r - s - degree) / 2);
+		knotVector.erase(knotVector.begin() + r);
+	}
+
+	const int MaxCurveDistanceDepth = 40;
+	const int MaxCurveDistanceIterations = 20;
+	const int MaxCurveDistancePieces = 1 << 16;
+	const int MaxCurveDistanceVisits = 1 << 18;
+	const double CurveDistanceFlatRatio = 0.1;
+
+	/// <summary>
+	/// Bezier piece of a curve on [Start, End], its Count control points start at First in the control point arena of the search.
+	/// Flatness is the largest distance of its control points to the chord. Left is the first of both halves once split, -1 before.
+	/// </summary>
+	struct CurveDistancePiece
+	{
+		int First;
+		int Count;
+		int Depth;
+		int Left;
+		double Start;
+		double End;
+		LN_BoundingBox Box;
+		double Flatness;
+	};
+
+	struct CurveDistancePair
+	{
+		double LowerBound;
+		int Piece0;
+		int Piece1;
+	};
+
+	struct CurveDistancePairGreater
+	{
+		bool operator()(const CurveDistancePair& left, const CurveDistancePair& right) const
+		{
+			return left.LowerBound > right.LowerBound;
+		}
+	};
+
+	typedef std::priority_queue<CurveDistancePair, std::vector<CurveDistancePair>, CurveDistancePairGreater> CurveDistanceQueue;
+
+	/// <summary>
+	/// Distance of point to segment [start, end] without a length tolerance, deep pieces have chords far below Constants::DoubleEpsilon.
+	/// </summary>
+	double GetDistanceToPieceChord(const XYZ& point, const XYZ& start, const XYZ& end)
+	{
+		XYZ chord = end - start;
+		double sqrLength = chord.SqrLength();
+		double t = sqrLength > 0.0 ? std::max(0.0, std::min(1.0, (point - start).DotProduct(chord) / sqrLength)) : 0.0;
+		return point.Distance(start + t * chord);
+	}
+
+	void UpdateCurveDistancePiece(const XYZW* controlPoints, CurveDistancePiece& piece)
+	{
+		XYZ start = controlPoints[0].ToXYZ(true);
+		XYZ end = controlPoints[piece.Count - 1].ToXYZ(true);
+		piece.Box.Min = start;
+		piece.Box.Max = start;
+		piece.Flatness = 0.0;
+		for (int i = 1; i < piece.Count; i++)
+		{
+			XYZ point = controlPoints[i].ToXYZ(true);
+			for (int k = 0; k < 3; k++)
+			{
+				piece.Box.Min[k] = std::min(piece.Box.Min[k], point[k]);
+				piece.Box.Max[k] = std::max(piece.Box.Max[k], point[k]);
+			}
+			if (i < piece.Count - 1)
+			{
+				piece.Flatness = std::max(piece.Flatness, GetDistanceToPieceChord(point, start, end));
+			}
+		}
+	}
+
+	double GetBoxDistance(const LN_BoundingBox& first, const LN_BoundingBox& second)
+	{
+		double squareDistance = 0.0;
+		for (int i = 0; i < 3; i++)
+		{
+			double gap = std::max(0.0, std::max(first.Min[i] - second.Max[i], second.Min[i] - first.Max[i]));
+			squareDistance += gap * gap;
+		}
+		return std::sqrt(squareDistance);
+	}
+
+	/// <summary>
+	/// Closest points p0 + s * (p1 - p0) and q0 + t * (q1 - q0) of two segments, s and t in [0,1].
+	/// </summary>
+	void GetClosestChordParams(const XYZ& p0, const XYZ& p1, const XYZ& q0, const XYZ& q1, double& s, double& t)
+	{
+		XYZ d0 = p1 - p0;
+		XYZ d1 = q1 - q0;
+		XYZ r = p0 - q0;
+		double a = d0.DotProduct(d0);
+		double e = d1.DotProduct(d1);
+		double f = d1.DotProduct(r);
+		if (a <= Constants::DoubleEpsilon && e <= Constants::DoubleEpsilon)
+		{
+			s = 0.0;
+			t = 0.0;
+			return;
+		}
+		if (a <= Constants::DoubleEpsilon)
+		{
+			s = 0.0;
+			t = std::max(0.0, std::min(1.0, f / e));
+			return;
+		}
+		double c = d0.DotProduct(r);
+		if (e <= Constants::DoubleEpsilon)
+		{
+			t = 0.0;
+			s = std::max(0.0, std::min(1.0, -c / a));
+			return;
+		}
+		double b = d0.DotProduct(d1);
+		double denominator = a * e - b * b;
+		s = denominator > Constants::DoubleEpsilon * a * e ? std::max(0.0, std::min(1.0, (b * f - c * e) / denominator)) : 0.0;
+		t = (b * s + f) / e;
+		if (t < 0.0)
+		{
+			t = 0.0;
+			s = std::max(0.0, std::min(1.0, -c / a));
+		}
+		else if (t > 1.0)
+		{
+			t = 1.0;
+			s = std::max(0.0, std::min(1.0, (b - c) / a));
+		}
+	}
+
+	/// <summary>
+	/// Best first search over pairs of Bezier pieces of two prepared curves.
+	/// Pieces of both curves live in one pool and are split at most once, every pair refers to them by index
+	/// so a piece shared by many pairs is subdivided and stored a single time.
+	/// Splitting stops at MaxCurveDistancePieces pieces and the search at MaxCurveDistanceVisits pairs,
+	/// which bounds memory and time on curves that stay close along their whole length.
+	/// </summary>
+	class CurveDistanceSearch
+	{
+	public:
+
+		CurveDistanceSearch(const PreparedCurve& curve0, const PreparedCurve& curve1, double tolerance) : _curve0(curve0), _curve1(curve1), _tolerance(tolerance)
+		{
+			_best.Param0 = curve0.Curve().KnotVector.front();
+			_best.Param1 = curve1.Curve().KnotVector.front();
+			_best.Distance = Constants::MaxDistance;
+		}
+
+		LN_CurveCurveDistance Run()
+		{
+			int count0 = AddPieces(_curve0);
+			int count1 = AddPieces(_curve1);
+			CurveDistanceQueue queue;
+			for (int i = 0; i < count0; i++)
+			{
+				for (int j = 0; j < count1; j++)
+				{
+					Push(queue, i, count0 + j);
+				}
+			}
+			int visits = 0;
+			while (!queue.empty() && visits < MaxCurveDistanceVisits)
+			{
+				CurveDistancePair pair = queue.top();
+				queue.pop();
+				if (pair.LowerBound >= _best.Distance - _tolerance)
+				{
+					break;
+				}
+				Visit(queue, pair);
+				visits++;
+			}
+			return _best;
+		}
+
+	private:
+
+		int AddPieces(const PreparedCurve& curve)
+		{
+			const std::vector<LN_NurbsCurve>& beziers = curve.GetBeziers();
+			const std::vector<double>& spanKnots = curve.GetSpanKnots();
+			for (int i = 0; i < beziers.size(); i++)
+			{
+				CurveDistancePiece piece;
+				piece.First = _controlPoints.size();
+				piece.Count = beziers[i].ControlPoints.size();
+				piece.Depth = 0;
+				piece.Left = -1;
+				piece.Start = spanKnots[i];
+				piece.End = spanKnots[i + 1];
+				_controlPoints.insert(_controlPoints.end(), beziers[i].ControlPoints.begin(), beziers[i].ControlPoints.end());
+				UpdateCurveDistancePiece(&_controlPoints[piece.First], piece);
+				_pieces.emplace_back(piece);
+			}
+			return beziers.size();
+		}
+
+		/// <summary>
+		/// de Casteljau subdivision of piece index at the middle of its interval, done once and shared by all pairs.
+		/// </summary>
+		int Split(int index)
+		{
+			if (_pieces[index].Left >= 0)
+			{
+				return _pieces[index].Left;
+			}
+			CurveDistancePiece left = _pieces[index];
+			CurveDistancePiece right = _pieces[index];
+			int count = left.Count;
+			_temp.assign(_controlPoints.begin() + left.First, _controlPoints.begin() + left.First + count);
+			left.First = _controlPoints.size();
+			right.First = left.First + count;
+			_controlPoints.resize(_controlPoints.size() + 2 * count);
+			XYZW* leftPoints = &_controlPoints[left.First];
+			XYZW* rightPoints = &_controlPoints[right.First];
+			leftPoints[0] = _temp[0];
+			rightPoints[count - 1] = _temp[count - 1];
+			for (int k = 1; k < count; k++)
+			{
+				for (int i = 0; i < count - k; i++)
+				{
+					_temp[i] = 0.5 * (_temp[i] + _temp[i + 1]);
+				}
+				leftPoints[k] = _temp[0];
+				rightPoints[count - 1 - k] = _temp[count - 1 - k];
+			}
+			double middle = 0.5 * (left.Start + left.End);
+			left.End = middle;
+			right.Start = middle;
+			left.Depth++;
+			right.Depth++;
+			UpdateCurveDistancePiece(leftPoints, left);
+			UpdateCurveDistancePiece(rightPoints, right);
+
+			int leftIndex = _pieces.size();
+			_pieces.emplace_back(left);
+			_pieces.emplace_back(right);
+			_pieces[index].Left = leftIndex;
+			return leftIndex;
+		}
+
+		XYZ GetStartPoint(const CurveDistancePiece& piece) const
+		{
+			return _controlPoints[piece.First].ToXYZ(true);
+		}
+
+		XYZ GetEndPoint(const CurveDistancePiece& piece) const
+		{
+			return _controlPoints[piece.First + piece.Count - 1].ToXYZ(true);
+		}
+
+		void Update(double param0, double param1, const XYZ& point0, const XYZ& point1)
+		{
+			double distance = point0.Distance(point1);
+			if (distance < _best.Distance)
+			{
+				_best.Param0 = param0;
+				_best.Param1 = param1;
+				_best.Point0 = point0;
+				_best.Point1 = point1;
+				_best.Distance = distance;
+			}
+		}
+
+		void Push(CurveDistanceQueue& queue, int index0, int index1)
+		{
+			const CurveDistancePiece& piece0 = _pieces[index0];
+			const CurveDistancePiece& piece1 = _pieces[index1];
+
+			// End control points interpolate the curves, so every pair tightens the bound before it is pruned.
+			XYZ start0 = GetStartPoint(piece0);
+			XYZ end0 = GetEndPoint(piece0);
+			XYZ start1 = GetStartPoint(piece1);
+			XYZ end1 = GetEndPoint(piece1);
+			Update(piece0.Start, piece1.Start, start0, start1);
+			Update(piece0.Start, piece1.End, start0, end1);
+			Update(piece0.End, piece1.Start, end0, start1);
+			Update(piece0.End, piece1.End, end0, end1);
+
+			// Both pieces lie within their flatness of their chords, which is a second order bound where the box distance is only first order.
+			double s = 0.0;
+			double t = 0.0;
+			GetClosestChordParams(start0, end0, start1, end1, s, t);
+			double chordDistance = (start0 + s * (end0 - start0)).Distance(start1 + t * (end1 - start1));
+			double lowerBound = std::max(GetBoxDistance(piece0.Box, piece1.Box), chordDistance - piece0.Flatness - piece1.Flatness);
+			if (lowerBound < _best.Distance - _tolerance)
+			{
+				CurveDistancePair pair;
+				pair.LowerBound = lowerBound;
+				pair.Piece0 = index0;
+				pair.Piece1 = index1;
+				queue.push(pair);
+			}
+		}
+
+		bool IsFlat(const CurveDistancePiece& piece) const
+		{
+			return piece.Flatness <= std::max(_tolerance, CurveDistanceFlatRatio * piece.Box.Min.Distance(piece.Box.Max));
 		}
-		else
+
+		bool CanSplit(const CurveDistancePiece& piece) const
 		{
-			length = CalculateLengthBySimpson(function, curve, start, m, left, tolearance / 2.0) + CalculateLengthBySimpson(function, curve, m, end, right, tolearance / 2.0);
+			return piece.Left >= 0 || (piece.Depth < MaxCurveDistanceDepth && static_cast<int>(_pieces.size()) + 2 <= MaxCurveDistancePieces);
 		}
-		return length;
-	}
 
-	double GetParamByLength(const LN_NurbsCurve& curve, double start, double end, double givenLength, IntegratorType type)
-	{
-		double middle = (start + end) / 2.0;
+		void Visit(CurveDistanceQueue& queue, const CurveDistancePair& pair)
+		{
+			const CurveDistancePiece& piece0 = _pieces[pair.Piece0];
+			const CurveDistancePiece& piece1 = _pieces[pair.Piece1];
+			bool canSplit0 = CanSplit(piece0);
+			bool canSplit1 = CanSplit(piece1);
+			bool isLeaf = !canSplit0 && !canSplit1;
+			if (isLeaf || (IsFlat(piece0) && IsFlat(piece1)))
+			{
+				XYZ start0 = GetStartPoint(piece0);
+				XYZ end0 = GetEndPoint(piece0);
+				XYZ start1 = GetStartPoint(piece1);
+				XYZ end1 = GetEndPoint(piece1);
+				double s = 0.0;
+				double t = 0.0;
+				GetClosestChordParams(start0, end0, start1, end1, s, t);
+				Refine(piece0.Start + s * (piece0.End - piece0.Start), piece1.Start + t * (piece1.End - piece1.Start), piece0.Start, piece0.End, piece1.Start, piece1.End);
+				if (isLeaf || pair.LowerBound >= _best.Distance - _tolerance)
+				{
+					return;
+				}
+			}
+
+			bool isFirst = canSplit0 && (!canSplit1 || piece0.Flatness >= piece1.Flatness);
+			int index = isFirst ? pair.Piece0 : pair.Piece1;
+			int other = isFirst ? pair.Piece1 : pair.Piece0;
+			int left = Split(index);
+			for (int k = 0; k < 2; k++)
+			{
+				if (isFirst)
+				{
+					Push(queue, left + k, other);
+				}
+				else
+				{
+					Push(queue, other, left + k);
+				}
+			}
+		}
 
-		LN_NurbsCurve left;
-		LN_NurbsCurve right;
-		bool isSplited = NurbsCurve::SplitAt(curve, middle, left, right);
-		if (!isSplited) return start;
-		double length = NurbsCurve::ApproximateLength(left, type);
-		if (MathUtils::IsAlmostEqualTo(length, givenLength, Constants::DistanceEpsilon))
+		/// <summary>
+		/// Newton iteration on f(s, t) = (d . C0'(s), -d . C1'(t)) with d = C0(s) - C1(t), the gradient of |d|^2 / 2,
+		/// clamped to [start0, end0] x [start1, end1]. Gauss-Newton steps are taken where the Hessian is not positive definite.
+		/// </summary>
+		void Refine(double s, double t, double start0, double end0, double start1, double end1)
 		{
-			return middle;
+			double spanEpsilon0 = Constants::DoubleEpsilon * (end0 - start0);
+			double spanEpsilon1 = Constants::DoubleEpsilon * (end1 - start1);
+			XYZ ders0[3];
+			XYZ ders1[3];
+			for (int iteration = 0; iteration < MaxCurveDistanceIterations; iteration++)
+			{
+				_curve0.ComputeDerivatives(2, &s, 1, ders0);
+				_curve1.ComputeDerivatives(2, &t, 1, ders1);
+				XYZ difference = ders0[0] - ders1[0];
+				double f0 = difference.DotProduct(ders0[1]);
+				double f1 = -difference.DotProduct(ders1[1]);
+				double j00 = ders0[1].DotProduct(ders0[1]) + difference.DotProduct(ders0[2]);
+				double j01 = -ders0[1].DotProduct(ders1[1]);
+				double j11 = ders1[1].DotProduct(ders1[1]) - difference.DotProduct(ders1[2]);
+				double determinant = j00 * j11 - j01 * j01;
+				if (j00 <= 0.0 || determinant <= Constants::DoubleEpsilon * std::abs(j00 * j11))
+				{
+					j00 = ders0[1].DotProduct(ders0[1]);
+					j11 = ders1[1].DotProduct(ders1[1]);
+					determinant = j00 * j11 - j01 * j01;
+					if (determinant <= Constants::DoubleEpsilon * j00 * j11)
+					{
+						break;
+					}
+				}
+				double nextS = std::max(start0, std::min(end0, s - (j11 * f0 - j01 * f1) / determinant));
+				double nextT = std::max(start1, std::min(end1, t - (j00 * f1 - j01 * f0) / determinant));
+				bool isConverged = std::abs(nextS - s) <= spanEpsilon0 && std::abs(nextT - t) <= spanEpsilon1;
+				s = nextS;
+				t = nextT;
+				if (isConverged)
+				{
+					break;
+				}
+			}
+			Update(s, t, _curve0.GetPointOnCurve(s), _curve1.GetPointOnCurve(t));
 		}
-		else if (MathUtils::IsGreaterThan(length, givenLength, Constants::DistanceEpsilon))
+
+		const PreparedCurve& _curve0;
+		const PreparedCurve& _curve1;
+		double _tolerance;
+		std::vector<CurveDistancePiece> _pieces;
+		std::vector<XYZW> _controlPoints;
+		std::vector<XYZW> _temp;
+		LN_CurveCurveDistance _best;
+	};
+
+	struct CurveDistanceBatchFunction
+	{
+		const PreparedCurve& Curve;
+		double Tolerance;
+		std::vector<LN_CurveCurveDistance> Distances;
+
+		CurveDistanceBatchFunction(const PreparedCurve& curve, double tolerance, int count) : Curve(curve), Tolerance(tolerance), Distances(count)
 		{
-			end = middle;
-			GetParamByLength(curve, start, end, givenLength, type);
 		}
-		else if (MathUtils::IsLessThan(length, givenLength, Constants::DistanceEpsilon))
+
+		void operator()(const LN_NurbsCurve& other, int index)
 		{
-			start = middle;
-			GetParamByLength(curve, start, end, givenLength, type);
+			PreparedCurve prepared(other);
+			Distances[index] = NurbsCurve::MinimumDistance(Curve, prepared, Tolerance);
 		}
-		return middle;
-	}
+	};
 }
 
-void LNLib::NurbsCurve::Check(const LN_NurbsCurve& curve)
+LNLib::LN_CheckedNurbsCurve LNLib::NurbsCurve::Check(const LN_NurbsCurve& curve)
 {
 	int degree = curve.Degree;
-	std::vector<double> knotVector = curve.KnotVector;
-	std::vector<XYZW> controlPoints = curve.ControlPoints;
+	const std::vector<double>& knotVector = curve.KnotVector;
+	const std::vector<XYZW>& controlPoints = curve.ControlPoints;
 
 	VALIDATE_ARGUMENT(degree > 0, "degree", "Degree must greater than zero.");
 	VALIDATE_ARGUMENT(knotVector.size() > 0, "knotVector", "KnotVector size must greater than zero.");
 	VALIDATE_ARGUMENT(ValidationUtils::IsValidKnotVector(knotVector), "knotVector", "KnotVector must be a nondecreasing sequence of real numbers.");
 	VALIDATE_ARGUMENT(controlPoints.size() > 0, "controlPoints", "ControlPoints must contains one point at least.");
 	VALIDATE_ARGUMENT(ValidationUtils::IsValidNurbs(degree, knotVector.size(), controlPoints.size()), "controlPoints", "Arguments must fit: m = n + p + 1");
+
+	return LN_CheckedNurbsCurve(curve, !HasUnitCurveWeights(controlPoints));
 }
 
 
 LNLib::XYZ LNLib::NurbsCurve::GetPointOnCurve(const LN_NurbsCurve& curve, double paramT)
 {
+	LNLIB_COUNT(Evaluations, 1);
+	const std::vector<double>& knotVector = curve.KnotVector;
+
 	int degree = curve.Degree;
-	std::vector<double> knotVector = curve.KnotVector;
-	std::vector<XYZW> controlPoints = curve.ControlPoints;
+	const std::vector<XYZW>& controlPoints = curve.ControlPoints;
 
 	VALIDATE_ARGUMENT_RANGE(paramT, knotVector[0], knotVector[knotVector.size() - 1]);
 
-	LN_BsplineCurve<XYZW> bsplineCurve;
-	bsplineCurve.Degree = degree;
-	bsplineCurve.KnotVector = knotVector;
-	bsplineCurve.ControlPoints = controlPoints;
+	double stackN[Constants::MaxStackBasisSize];
+	std::vector<double> heapN;
+	double* N = stackN;
+	if (degree >= Constants::MaxStackBasisSize)
+	{
+		heapN.resize(degree + 1);
+		N = heapN.data();
+	}
+
+	int spanIndex = Polynomials::GetKnotSpanIndex(degree, knotVector, paramT);
+	Polynomials::BasisFunctions(spanIndex, degree, knotVector, paramT, N);
+
+	const XYZW* points = &controlPoints[spanIndex - degree];
+	if (HasUnitCurveWeights(points, degree + 1))
+	{
+		double x = 0.0;
+		double y = 0.0;
+		double z = 0.0;
+		for (int j = 0; j <= degree; j++)
+		{
+			x += N[j] * points[j].GetWX();
+			y += N[j] * points[j].GetWY();
+			z += N[j] * points[j].GetWZ();
+		}
+		return XYZ(x, y, z);
+	}
 
-	XYZW weightPoint = BsplineCurve::GetPointOnCurve(bsplineCurve, paramT);
+	XYZW weightPoint;
+	for (int j = 0; j <= degree; j++)
+	{
+		weightPoint += N[j] * points[j];
+	}
 	return weightPoint.ToXYZ(true);
 }
 
-std::vector<LNLib::XYZ> LNLib::NurbsCurve::ComputeRationalCurveDerivatives(const LN_NurbsCurve& curve, int derivative, double paramT)
+LNLib::XYZ LNLib::NurbsCurve::GetPointOnCurve(const LN_StoredNurbsCurve& curve, double paramT)
 {
+	LNLIB_COUNT(Evaluations, 1);
 	int degree = curve.Degree;
-	std::vector<double> knotVector = curve.KnotVector;
-	std::vector<XYZW> controlPoints = curve.ControlPoints;
-
-	VALIDATE_ARGUMENT(derivative > 0, "derivative", "derivative must greater than zero.");	
-	VALIDATE_ARGUMENT_RANGE(paramT, knotVector[0], knotVector[knotVector.size() - 1]);
+	const double* knotVector = curve.KnotVector;
 
-	std::vector<LNLib::XYZ> derivatives(derivative + 1);
+	VALIDATE_ARGUMENT_RANGE(paramT, knotVector[0], knotVector[curve.KnotCount - 1]);
 
-	LN_BsplineCurve<XYZW> bsplineCurve;
-	bsplineCurve.Degree = degree;
-	bsplineCurve.KnotVector = knotVector;
-	bsplineCurve.ControlPoints = controlPoints;
+	double stackN[Constants::MaxStackBasisSize];
+	std::vector<double> heapN;
+	double* N = stackN;
+	if (degree >= Constants::MaxStackBasisSize)
+	{
+		heapN.resize(degree + 1);
+		N = heapN.data();
+	}
 
-	std::vector<XYZW> ders = BsplineCurve::ComputeDerivatives(bsplineCurve, derivative, paramT);
+	int spanIndex = Polynomials::GetKnotSpanIndex(degree, knotVector, curve.KnotCount, paramT);
+	Polynomials::BasisFunctions(spanIndex, degree, knotVector, paramT, N);
 
-	std::vector<XYZ> Aders(derivative + 1);
-	for (int i = 0; i < ders.size(); i++)
+	const XYZW* points = curve.ControlPoints + spanIndex - degree;
+	XYZW point;
+	for (int j = 0; j <= degree; j++)
 	{
-		Aders[i] = ders[i].ToXYZ(false);
+		point += N[j] * points[j];
 	}
-	std::vector<double> wders(derivative + 1);
-	for (int i = 0; i < ders.size(); i++)
+	return point.ToXYZ(true);
+}
+
+LNLib::XYZ LNLib::NurbsCurve::GetPointOnCurve(const LN_CheckedNurbsCurve& curve, double paramT)
+{
+	LNLIB_COUNT(Evaluations, 1);
+	const LN_NurbsCurve& nurbsCurve = curve.Curve();
+	int degree = nurbsCurve.Degree;
+	const std::vector<double>& knotVector = nurbsCurve.KnotVector;
+	const std::vector<XYZW>& controlPoints = nurbsCurve.ControlPoints;
+
+	double stackN[Constants::MaxStackBasisSize];
+	std::vector<double> heapN;
+	double* N = stackN;
+	if (degree >= Constants::MaxStackBasisSize)
 	{
-		wders[i] = ders[i].GetW();
+		heapN.resize(degree + 1);
+		N = heapN.data();
 	}
 
-	for (int k = 0; k <= derivative; k++)
+	int spanIndex = Polynomials::GetKnotSpanIndex(degree, knotVector, paramT, controlPoints.size() - 1);
+	Polynomials::BasisFunctions(spanIndex, degree, knotVector, paramT, N);
+
+	const XYZW* points = &controlPoints[spanIndex - degree];
+	if (!curve.IsRational())
 	{
-		XYZ v = Aders[k];
-		for (int i = 1; i <= k; i++)
+		double x = 0.0;
+		double y = 0.0;
+		double z = 0.0;
+		for (int j = 0; j <= degree; j++)
 		{
-			v = v - MathUtils::Binomial(k, i) * wders[i] * derivatives[k - i];
+			x += N[j] * points[j].GetWX();
+			y += N[j] * points[j].GetWY();
+			z += N[j] * points[j].GetWZ();
 		}
-		derivatives[k] = v / wders[0];
+		return XYZ(x, y, z);
 	}
-	return derivatives;
+
+	XYZW weightPoint;
+	for (int j = 0; j <= degree; j++)
+	{
+		weightPoint += N[j] * points[j];
+	}
+	return weightPoint.ToXYZ(true);
 }
 
-double LNLib::NurbsCurve::Curvature(const LN_NurbsCurve& curve, double paramT)
+void LNLib::NurbsCurve::GetPointsOnCurve(const LN_NurbsCurve& curve, const double* params, int count, XYZ* points)
 {
-	int degree = curve.Degree;
-	std::vector<double> knotVector = curve.KnotVector;
-	std::vector<XYZW> controlPoints = curve.ControlPoints;
+	VALIDATE_ARGUMENT(count >= 0, "count", "Count must greater than or equals zero.");
+	if (count == 0) return;
+	VALIDATE_ARGUMENT(params != nullptr, "params", "Params must not be null.");
+	VALIDATE_ARGUMENT(points != nullptr, "points", "Points must not be null.");
+	LN_CheckedNurbsCurve checkedCurve = Check(curve);
 
-	VALIDATE_ARGUMENT_RANGE(paramT, knotVector[0], knotVector[knotVector.size() - 1]);
-	
-	std::vector<XYZ> derivatives = ComputeRationalCurveDerivatives(curve, 2, paramT);
-	XYZ d1 = derivatives[1];
-	XYZ d2 = derivatives[2];
-	if (MathUtils::IsAlmostEqualTo(d1.Length(), 1.0))
+	const std::vector<double>& knotVector = curve.KnotVector;
+	double first = knotVector[0];
+	double last = knotVector[knotVector.size() - 1];
+	for (int i = 0; i < count; i++)
 	{
-		return d2.Length();
+		VALIDATE_ARGUMENT_RANGE(params[i], first, last);
 	}
-	double numerator = d1.CrossProduct(d2).Length();
-	double denominator = pow(d1.Length(), 3);
-	return numerator / denominator;
+	GetPointsOnCurve(checkedCurve, params, count, points);
 }
 
-LNLib::XYZ LNLib::NurbsCurve::Normal(const LN_NurbsCurve& curve, CurveNormal normalType, double paramT)
+void LNLib::NurbsCurve::GetPointsOnCurve(const LN_CheckedNurbsCurve& curve, const double* params, int count, XYZ* points)
 {
-	int degree = curve.Degree;
-	std::vector<double> knotVector = curve.KnotVector;
-	std::vector<XYZW> controlPoints = curve.ControlPoints;
-
-	VALIDATE_ARGUMENT_RANGE(paramT, knotVector[0], knotVector[knotVector.size() - 1]);
+	LNLIB_COUNT(Evaluations, count);
+	if (count <= 0) return;
+
+	const LN_NurbsCurve& nurbsCurve = curve.Curve();
+	int degree = nurbsCurve.Degree;
+	const std::vector<double>& knotVector = nurbsCurve.KnotVector;
+	const XYZW* controlPoints = nurbsCurve.ControlPoints.data();
+	bool isRational = curve.IsRational();
+
+	const int lanes = Constants::BatchLaneCount;
+	int basisSize = degree + 1;
+	double stackN[Constants::BatchLaneCount * Constants::MaxStackBasisSize] = { 0.0 };
+	std::vector<double> heapN;
+	double* N = stackN;
+	if (degree >= Constants::MaxStackBasisSize)
+	{
+		heapN.resize(lanes * basisSize);
+		N = heapN.data();
+	}
+	KnotSpanCursor cursor(degree, knotVector);
+	for (int start = 0; start < count; start += lanes)
+	{
+		int block = std::min(lanes, count - start);
+
+		int firstIndices[Constants::BatchLaneCount] = { 0 };
+		for (int lane = 0; lane < block; lane++)
+		{
+			double paramT = params[start + lane];
+			int spanIndex = cursor.Find(paramT);
+			Polynomials::BasisFunctions(spanIndex, degree, knotVector, paramT, &N[lane * basisSize]);
+			firstIndices[lane] = spanIndex - degree;
+		}
+
+		// Only the control points of the evaluated spans are gathered into lane arrays, the net is never copied as a whole.
+		double x[Constants::BatchLaneCount] = { 0.0 };
+		double y[Constants::BatchLaneCount] = { 0.0 };
+		double z[Constants::BatchLaneCount] = { 0.0 };
+		double h[Constants::BatchLaneCount] = { 0.0 };
+		double wx[Constants::BatchLaneCount] = { 0.0 };
+		double wy[Constants::BatchLaneCount] = { 0.0 };
+		double wz[Constants::BatchLaneCount] = { 0.0 };
+		double w[Constants::BatchLaneCount] = { 0.0 };
+		for (int j = 0; j <= degree; j++)
+		{
+			for (int lane = 0; lane < block; lane++)
+			{
+				const XYZW& controlPoint = controlPoints[firstIndices[lane] + j];
+				wx[lane] = controlPoint.GetWX();
+				wy[lane] = controlPoint.GetWY();
+				wz[lane] = controlPoint.GetWZ();
+				w[lane] = controlPoint.GetW();
+			}
+			for (int lane = 0; lane < lanes; lane++)
+			{
+				double n = N[lane * basisSize + j];
+				x[lane] += n * wx[lane];
+				y[lane] += n * wy[lane];
+				z[lane] += n * wz[lane];
+				h[lane] += n * w[lane];
+			}
+		}
 
-	std::vector<XYZ> derivatives = ComputeRationalCurveDerivatives(curve, 1, paramT);
-	XYZ tangent = derivatives[1];
-	XYZ der2 = derivatives[2];
-	if (MathUtils::IsAlmostEqualTo(tangent.Length(), 1.0))
-	{
-		XYZ curveNormal = der2 / der2.Length();
-		if (normalType == CurveNormal::Normal)
+		if (!isRational)
 		{
-			return curveNormal;
+			for (int lane = 0; lane < block; lane++)
+			{
+				points[start + lane] = XYZ(x[lane], y[lane], z[lane]);
+			}
+			continue;
 		}
-		else
+
+		for (int lane = 0; lane < block; lane++)
 		{
-			return tangent.CrossProduct(curveNormal);
+			points[start + lane] = XYZW(x[lane], y[lane], z[lane], h[lane]).ToXYZ(true);
 		}
 	}
-	else
+}
+
+std::vector<LNLib::XYZ> LNLib::NurbsCurve::GetPointsOnCurve(const LN_NurbsCurve& curve, const std::vector<double>& params)
+{
+	std::vector<XYZ> points(params.size());
+	GetPointsOnCurve(curve, params.data(), params.size(), points.data());
+	return points;
+}
+
+std::vector<LNLib::XYZ> LNLib::NurbsCurve::ComputeRationalCurveDerivatives(const LN_NurbsCurve& curve, int derivative, double paramT)
+{
+	LNLIB_COUNT(Evaluations, 1);
+	const std::vector<double>& knotVector = curve.KnotVector;
+
+	VALIDATE_ARGUMENT(derivative > 0, "derivative", "derivative must greater than zero.");	
+	VALIDATE_ARGUMENT_RANGE(paramT, knotVector[0], knotVector[knotVector.size() - 1]);
+
+	LN_DerivativeWorkspace workspace;
+	std::vector<XYZ> derivatives(derivative + 1);
+	ComputeSpanCurveDerivatives(curve, derivative, paramT, workspace, derivatives.data());
+	return derivatives;
+}
+
+std::vector<LNLib::XYZ> LNLib::NurbsCurve::ComputeRationalCurveDerivatives(const LN_CheckedNurbsCurve& curve, int derivative, double paramT)
+{
+	LN_DerivativeWorkspace workspace;
+	std::vector<XYZ> derivatives(derivative + 1);
+	ComputeRationalCurveDerivatives(curve, derivative, paramT, workspace, derivatives.data());
+	return derivatives;
+}
+
+void LNLib::NurbsCurve::ComputeRationalCurveDerivatives(const LN_CheckedNurbsCurve& curve, int derivative, double paramT, LN_DerivativeWorkspace& workspace, XYZ* derivatives)
+{
+	LNLIB_COUNT(Evaluations, 1);
+	const LN_NurbsCurve& nurbsCurve = curve.Curve();
+	int spanIndex = Polynomials::GetKnotSpanIndex(nurbsCurve.Degree, nurbsCurve.KnotVector, paramT, nurbsCurve.ControlPoints.size() - 1);
+	if (!curve.IsRational())
 	{
-		XYZ b = tangent.CrossProduct(der2) / (tangent.CrossProduct(der2).Length());
-		if (normalType == CurveNormal::Binormal)
-		{
-			return b;
-		}
-		else
+		ComputePolynomialCurveDerivatives(nurbsCurve, spanIndex, derivative, paramT, workspace, derivatives);
+		return;
+	}
+	ComputeWeightedDerivatives(nurbsCurve, spanIndex, derivative, paramT, workspace);
+	ToRationalDerivatives(workspace.WeightedDerivatives.data(), derivative, derivatives);
+}
+
+void LNLib::NurbsCurve::ComputeRationalCurveDerivatives(const LN_CheckedNurbsCurve& curve, int derivative, const double* params, int count, XYZ* derivatives)
+{
+	LNLIB_COUNT(Evaluations, count);
+	const LN_NurbsCurve& nurbsCurve = curve.Curve();
+	LN_DerivativeWorkspace workspace;
+	KnotSpanCursor cursor(nurbsCurve.Degree, nurbsCurve.KnotVector);
+	for (int i = 0; i < count; i++)
+	{
+		int spanIndex = cursor.Find(params[i]);
+		if (!curve.IsRational())
 		{
-			return b.Normalize().CrossProduct(tangent.Normalize());
+			ComputePolynomialCurveDerivatives(nurbsCurve, spanIndex, derivative, params[i], workspace, derivatives + i * (derivative + 1));
+			continue;
 		}
+		ComputeWeightedDerivatives(nurbsCurve, spanIndex, derivative, params[i], workspace);
+		ToRationalDerivatives(workspace.WeightedDerivatives.data(), derivative, derivatives + i * (derivative + 1));
 	}
 }
 
-double LNLib::NurbsCurve::Torsion(const LN_NurbsCurve& curve, double paramT)
+LNLib::EvaluationStatus LNLib::NurbsCurve::TryGetPointOnCurve(const LN_CheckedNurbsCurve& curve, double paramT, XYZ& point, ParameterRangePolicy policy) noexcept
 {
-	int degree = curve.Degree;
-	std::vector<double> knotVector = curve.KnotVector;
-	std::vector<XYZW> controlPoints = curve.ControlPoints;
-
-	VALIDATE_ARGUMENT_RANGE(paramT, knotVector[0], knotVector[knotVector.size() - 1]);
+	const std::vector<double>& knotVector = curve.Curve().KnotVector;
+	EvaluationStatus status = ValidationUtils::ResolveParameter(paramT, knotVector[0], knotVector[knotVector.size() - 1], policy);
+	if (status != EvaluationStatus::Success)
+	{
+		return status;
+	}
+	point = GetPointOnCurve(curve, paramT);
+	return EvaluationStatus::Success;
+}
 
-	std::vector<XYZ> derivatives = ComputeRationalCurveDerivatives(curve, 3, paramT);
-	XYZ tangent = derivatives[1];
-	XYZ der2 = derivatives[2];
-	XYZ der3 = derivatives[3];
-	if (MathUtils::IsAlmostEqualTo(tangent.Length(), 1.0))
+LNLib::EvaluationStatus LNLib::NurbsCurve::TryComputeRationalCurveDerivatives(const LN_CheckedNurbsCurve& curve, int derivative, double paramT, LN_DerivativeWorkspace& workspace, XYZ* derivatives, ParameterRangePolicy policy) noexcept
+{
+	if (derivative <= 0 || derivatives == nullptr)
 	{
-		double numerator = (tangent.CrossProduct(der2)).DotProduct(der3);
-		double denominator = der2.DotProduct(der2);
-		return numerator / denominator;
+		return EvaluationStatus::InvalidArgument;
 	}
-	else
+	const std::vector<double>& knotVector = curve.Curve().KnotVector;
+	EvaluationStatus status = ValidationUtils::ResolveParameter(paramT, knotVector[0], knotVector[knotVector.size() - 1], policy);
+	if (status != EvaluationStatus::Success)
 	{
-		double numerator = (tangent.CrossProduct(der2)).DotProduct(der3);
-		double denominator = (tangent.CrossProduct(der2).DotProduct(tangent.CrossProduct(der3)));
-		return numerator / denominator;
+		return status;
 	}
+	ComputeRationalCurveDerivatives(curve, derivative, paramT, workspace, derivatives);
+	return EvaluationStatus::Success;
+}
+
+double LNLib::NurbsCurve::Curvature(const LN_NurbsCurve& curve, double paramT)
+{
+	const std::vector<double>& knotVector = curve.KnotVector;
+
+	VALIDATE_ARGUMENT_RANGE(paramT, knotVector[0], knotVector[knotVector.size() - 1]);
+	
+	LN_DerivativeWorkspace workspace;
+	XYZ derivatives[3];
+	ComputeSpanCurveDerivatives(curve, 2, paramT, workspace, derivatives);
+	return GetCurvatureFromDerivatives(derivatives);
+}
+
+LNLib::XYZ LNLib::NurbsCurve::Normal(const LN_NurbsCurve& curve, CurveNormal normalType, double paramT)
+{
+	const std::vector<double>& knotVector = curve.KnotVector;
+
+	VALIDATE_ARGUMENT_RANGE(paramT, knotVector[0], knotVector[knotVector.size() - 1]);
+
+	LN_DerivativeWorkspace workspace;
+	XYZ derivatives[3];
+	ComputeSpanCurveDerivatives(curve, 2, paramT, workspace, derivatives);
+	return GetNormalFromDerivatives(derivatives, normalType);
+}
+
+double LNLib::NurbsCurve::Torsion(const LN_NurbsCurve& curve, double paramT)
+{
+	const std::vector<double>& knotVector = curve.KnotVector;
+
+	VALIDATE_ARGUMENT_RANGE(paramT, knotVector[0], knotVector[knotVector.size() - 1]);
+
+	LN_DerivativeWorkspace workspace;
+	XYZ derivatives[4];
+	ComputeSpanCurveDerivatives(curve, 3, paramT, workspace, derivatives);
+	return GetTorsionFromDerivatives(derivatives);
+}
+
+double LNLib::NurbsCurve::Curvature(const LN_CheckedNurbsCurve& curve, double paramT, LN_DerivativeWorkspace& workspace)
+{
+	XYZ derivatives[3];
+	ComputeRationalCurveDerivatives(curve, 2, paramT, workspace, derivatives);
+	return GetCurvatureFromDerivatives(derivatives);
+}
+
+LNLib::XYZ LNLib::NurbsCurve::Normal(const LN_CheckedNurbsCurve& curve, CurveNormal normalType, double paramT, LN_DerivativeWorkspace& workspace)
+{
+	XYZ derivatives[3];
+	ComputeRationalCurveDerivatives(curve, 2, paramT, workspace, derivatives);
+	return GetNormalFromDerivatives(derivatives, normalType);
+}
+
+double LNLib::NurbsCurve::Torsion(const LN_CheckedNurbsCurve& curve, double paramT, LN_DerivativeWorkspace& workspace)
+{
+	XYZ derivatives[4];
+	ComputeRationalCurveDerivatives(curve, 3, paramT, workspace, derivatives);
+	return GetTorsionFromDerivatives(derivatives);
 }
 
 
 int LNLib::NurbsCurve::InsertKnot(const LN_NurbsCurve& curve, double insertKnot, int times, LN_NurbsCurve& result)
+{
+	result = curve;
+	return InsertKnot(result, insertKnot, times);
+}
+
+int LNLib::NurbsCurve::InsertKnot(LN_NurbsCurve&& curve, double insertKnot, int times, LN_NurbsCurve& result)
+{
+	result = std::move(curve);
+	return InsertKnot(result, insertKnot, times);
+}
+
+int LNLib::NurbsCurve::InsertKnot(LN_NurbsCurve& curve, double insertKnot, int times)
 {
 	int degree = curve.Degree;
-	std::vector<double> knotVector = curve.KnotVector;
-	std::vector<XYZW> controlPoints = curve.ControlPoints;
+	std::vector<double>& knotVector = curve.KnotVector;
+	std::vector<XYZW>& controlPoints = curve.ControlPoints;
 
 	VALIDATE_ARGUMENT(times > 0, "times", "Times must greater than zero.");
 
@@ -276,30 +1581,6 @@ int LNLib::NurbsCurve::InsertKnot(const LN_NurbsCurve& curve, double insertKnot,
 	{
 		return 0;
 	}
-	
-	std::vector<double> insertedKnotVector(knotVector.size() + times);
-	for (int i = 0; i <= knotSpanIndex; i++)
-	{
-		insertedKnotVector[i] = knotVector[i];
-	}
-	for (int i = 1; i <= times; i++)
-	{
-		insertedKnotVector[knotSpanIndex + i] = insertKnot;
-	}
-	for (int i = knotSpanIndex + 1; i < knotVector.size(); i++)
-	{
-		insertedKnotVector[i + times] = knotVector[i];
-	}
-
-	std::vector<XYZW> updatedControlPoints(controlPoints.size() + times);
-	for (int i = 0; i <= knotSpanIndex - degree; i++)
-	{
-		updatedControlPoints[i] = controlPoints[i];
-	}
-	for (int i = knotSpanIndex - originMultiplicity; i < controlPoints.size(); i++)
-	{
-		updatedControlPoints[i + times] = controlPoints[i];
-	}
 
 	std::vector<XYZW> temp(degree - originMultiplicity + 1);
 	for (int i = 0; i <= degree - originMultiplicity; i++)
@@ -307,6 +1588,9 @@ int LNLib::NurbsCurve::InsertKnot(const LN_NurbsCurve& curve, double insertKnot,
 		temp[i] = controlPoints[knotSpanIndex - degree + i];
 	}
 
+	// Shift the unaffected tail right by times, the head stays where it is.
+	controlPoints.insert(controlPoints.begin() + (knotSpanIndex - originMultiplicity), times, XYZW());
+
 	int L = 0;
 	for (int j = 1; j <= times; j++)
 	{
@@ -316,31 +1600,27 @@ int LNLib::NurbsCurve::InsertKnot(const LN_NurbsCurve& curve, double insertKnot,
 			double alpha = (insertKnot - knotVector[L + i]) / (knotVector[i + knotSpanIndex + 1] - knotVector[L + i]);
 			temp[i] = alpha * temp[i + 1] + (1.0 - alpha) * temp[i];
 		}
-		updatedControlPoints[L] = temp[0];
+		controlPoints[L] = temp[0];
 		if (degree - j - originMultiplicity > 0)
 		{
-			updatedControlPoints[knotSpanIndex + times - j - originMultiplicity] = temp[degree - j - originMultiplicity];
+			controlPoints[knotSpanIndex + times - j - originMultiplicity] = temp[degree - j - originMultiplicity];
 		}
 	}
 
 	for (int i = L + 1; i < knotSpanIndex - originMultiplicity; i++)
 	{
-		updatedControlPoints[i] = temp[i - L];
+		controlPoints[i] = temp[i - L];
 	}
 
-	std::sort(insertedKnotVector.begin(), insertedKnotVector.end());
-	result.Degree = degree;
-	result.KnotVector = insertedKnotVector;
-	result.ControlPoints = updatedControlPoints;
-
+	knotVector.insert(knotVector.begin() + knotSpanIndex + 1, times, insertKnot);
 	return times;
 }
 
 LNLib::XYZ LNLib::NurbsCurve::GetPointOnCurveByCornerCut(const LN_NurbsCurve& curve, double paramT)
 {
 	int degree = curve.Degree;
-	std::vector<double> knotVector = curve.KnotVector;
-	std::vector<XYZW> controlPoints = curve.ControlPoints;
+	const std::vector<double>& knotVector = curve.KnotVector;
+	const std::vector<XYZW>& controlPoints = curve.ControlPoints;
 
 	VALIDATE_ARGUMENT_RANGE(paramT, knotVector[0], knotVector[knotVector.size() - 1]);
 
@@ -375,10 +1655,22 @@ LNLib::XYZ LNLib::NurbsCurve::GetPointOnCurveByCornerCut(const LN_NurbsCurve& cu
 }
 
 void LNLib::NurbsCurve::RefineKnotVector(const LN_NurbsCurve& curve, std::vector<double>& insertKnotElements, LN_NurbsCurve& result)
+{
+	result = curve;
+	RefineKnotVector(result, insertKnotElements);
+}
+
+void LNLib::NurbsCurve::RefineKnotVector(LN_NurbsCurve&& curve, std::vector<double>& insertKnotElements, LN_NurbsCurve& result)
+{
+	result = std::move(curve);
+	RefineKnotVector(result, insertKnotElements);
+}
+
+void LNLib::NurbsCurve::RefineKnotVector(LN_NurbsCurve& curve, const std::vector<double>& insertKnotElements)
 {
 	int degree = curve.Degree;
-	std::vector<double> knotVector = curve.KnotVector;
-	std::vector<XYZW> controlPoints = curve.ControlPoints;
+	std::vector<double>& knotVector = curve.KnotVector;
+	std::vector<XYZW>& controlPoints = curve.ControlPoints;
 
 	VALIDATE_ARGUMENT(insertKnotElements.size() > 0, "insertKnotElements", "insertKnotElements size must greater than zero.");
 
@@ -389,24 +1681,17 @@ void LNLib::NurbsCurve::RefineKnotVector(const LN_NurbsCurve& curve, std::vector
 	int a = Polynomials::GetKnotSpanIndex(degree, knotVector, insertKnotElements[0]);
 	int b = Polynomials::GetKnotSpanIndex(degree, knotVector, insertKnotElements[r]) + 1;
 
-	std::vector<double> insertedKnotVector(m + r + 2);
-	for (int j = 0; j <= a; j++)
-	{
-		insertedKnotVector[j] = knotVector[j];
-	}
-	for (int j = b + degree; j <= m; j++)
-	{
-		insertedKnotVector[j + r + 1] = knotVector[j];
-	}
-
-	std::vector<XYZW> updatedControlPoints(n + r + 2);
-	for (int j = 0; j <= a - degree; j++)
+	// A5.4 writes from the back and only ever reads original entries below the write position,
+	// so growing the buffers and shifting the tail lets it run without a second copy.
+	knotVector.resize(m + r + 2);
+	for (int j = m; j >= b + degree; j--)
 	{
-		updatedControlPoints[j] = controlPoints[j];
+		knotVector[j + r + 1] = knotVector[j];
 	}
-	for (int j = b - 1; j <= n; j++)
+	controlPoints.resize(n + r + 2);
+	for (int j = n; j >= b - 1; j--)
 	{
-		updatedControlPoints[j + r + 1] = controlPoints[j];
+		controlPoints[j + r + 1] = controlPoints[j];
 	}
 
 	int i = b + degree - 1;
@@ -415,40 +1700,37 @@ void LNLib::NurbsCurve::RefineKnotVector(const LN_NurbsCurve& curve, std::vector
 	{
 		while (insertKnotElements[j] <= knotVector[i] && i > a)
 		{
-			updatedControlPoints[k - degree - 1] = controlPoints[i - degree - 1];
-			insertedKnotVector[k] = knotVector[i];
+			controlPoints[k - degree - 1] = controlPoints[i - degree - 1];
+			knotVector[k] = knotVector[i];
 			k = k - 1;
 			i = i - 1;
 		}
 
-		updatedControlPoints[k - degree - 1] = updatedControlPoints[k - degree];
+		controlPoints[k - degree - 1] = controlPoints[k - degree];
 		for (int l = 1; l <= degree; l++)
 		{
 			int ind = k - degree + l;
-			double alpha = insertedKnotVector[k + l] - insertKnotElements[j];
+			double alpha = knotVector[k + l] - insertKnotElements[j];
 			if (MathUtils::IsAlmostEqualTo(abs(alpha), 0.0))
 			{
-				updatedControlPoints[ind - 1] = updatedControlPoints[ind];
+				controlPoints[ind - 1] = controlPoints[ind];
 			}
 			else
 			{
-				alpha = alpha / (insertedKnotVector[k + l] - knotVector[i - degree + l]);
-				updatedControlPoints[ind - 1] = alpha * updatedControlPoints[ind - 1] + (1.0 - alpha) * updatedControlPoints[ind];
+				alpha = alpha / (knotVector[k + l] - knotVector[i - degree + l]);
+				controlPoints[ind - 1] = alpha * controlPoints[ind - 1] + (1.0 - alpha) * controlPoints[ind];
 			}
 		}
-		insertedKnotVector[k] = insertKnotElements[j];
+		knotVector[k] = insertKnotElements[j];
 		k = k - 1;
 	}
-	result.Degree = degree;
-	result.KnotVector = insertedKnotVector;
-	result.ControlPoints = updatedControlPoints;
 }
 
 std::vector<LNLib::LN_NurbsCurve> LNLib::NurbsCurve::DecomposeToBeziers(const LN_NurbsCurve& curve)
 {
 	int degree = curve.Degree;
-	std::vector<double> knotVector = curve.KnotVector;
-	std::vector<XYZW> controlPoints = curve.ControlPoints;
+	const std::vector<double>& knotVector = curve.KnotVector;
+	const std::vector<XYZW>& controlPoints = curve.ControlPoints;
 
 	int knotSize = 2 * (degree + 1);
 	std::vector<double> bezierKnots(knotSize);
@@ -460,82 +1742,137 @@ std::vector<LNLib::LN_NurbsCurve> LNLib::NurbsCurve::DecomposeToBeziers(const LN
 	{
 		bezierKnots[i] = 1;
 	}
-	int bezierSize = controlPoints.size() - degree;
+
+	// One segment per distinct knot span, interior knots of any multiplicity and degree 1 are handled by the shared kernel.
+	int bezierSize = KnotVectorUtils::GetBezierCount(degree, knotVector);
+	std::vector<XYZW> bezierPoints(bezierSize * (degree + 1));
+	ControlPointsUtils::DecomposeToBeziers(degree, knotVector, controlPoints.data(), 1, bezierPoints.data(), nullptr);
+
 	std::vector<LNLib::LN_NurbsCurve> beziers(bezierSize);
 	for (int i = 0; i < bezierSize; i++)
 	{
 		beziers[i].Degree = degree;
 		beziers[i].KnotVector = bezierKnots;
-		beziers[i].ControlPoints = std::vector<XYZW>(degree + 1);
+		beziers[i].ControlPoints.assign(bezierPoints.begin() + i * (degree + 1), bezierPoints.begin() + (i + 1) * (degree + 1));
 	}
+	return beziers;
+}
 
-	int n = controlPoints.size() - 1;
-	int m = n + degree + 1;
+std::vector<std::vector<LNLib::LN_NurbsCurve>> LNLib::NurbsCurve::DecomposeToBeziers(const std::vector<LN_NurbsCurve>& curves, ParallelExecutor* executor)
+{
+	CurveDecompositionBatchFunction function;
+	function.Segments.resize(curves.size());
+	Parallel::ForEach(curves, function, executor);
+	return function.Segments;
+}
 
-	int a = degree;
-	int b = degree + 1;
+void LNLib::NurbsCurve::DecomposeToBeziers(const LN_NurbsCurve& curve, LN_BezierSegmentArray& segments)
+{
+	Check(curve);
+	int degree = curve.Degree;
+	int count = KnotVectorUtils::GetBezierCount(degree, curve.KnotVector);
 
-	int nb = 0;
-	for (int i = 0; i <= degree; i++)
-	{
-		beziers[nb].ControlPoints[i] = controlPoints[i];
-	}
+	segments.Degree = degree;
+	segments.Count = count;
+	segments.Domains.resize(2 * count);
+	segments.ControlPoints.resize(count * (degree + 1));
+	ControlPointsUtils::DecomposeToBeziers(degree, curve.KnotVector, curve.ControlPoints.data(), 1, segments.ControlPoints.data(), segments.Domains.data());
+}
 
-	while (b < m)
-	{
-		int i = b;
-		while (b < m && MathUtils::IsAlmostEqualTo(knotVector[b + 1], knotVector[b]))
+LNLib::LN_BoundingBox LNLib::NurbsCurve::GetBoundingBox(const LN_NurbsCurve& curve)
+{
+	Check(curve);
+	return ControlPointsUtils::ComputeBoundingBox(curve.ControlPoints);
+}
+
+LNLib::LN_BoundingBox LNLib::NurbsCurve::GetTightBoundingBox(const LN_NurbsCurve& curve)
+{
+	LN_CheckedNurbsCurve checkedCurve = Check(curve);
+
+	std::vector<double> uniqueKnots = curve.KnotVector;
+	uniqueKnots.erase(std::unique(uniqueKnots.begin(), uniqueKnots.end()), uniqueKnots.end());
+	std::vector<LN_NurbsCurve> beziers = DecomposeToBeziers(curve);
+
+	LN_BoundingBox box;
+	box.Min = box.Max = GetPointOnCurve(checkedCurve, uniqueKnots[0]);
+	std::vector<double> roots;
+	for (int i = 0; i < uniqueKnots.size() - 1; i++)
+	{
+		double start = uniqueKnots[i];
+		double end = uniqueKnots[i + 1];
+		XYZ endPoint = GetPointOnCurve(checkedCurve, end);
+		ExpandBoundingBox(box, endPoint);
+
+		const std::vector<XYZW>& controlPoints = beziers[i].ControlPoints;
+		int degree = controlPoints.size() - 1;
+		LN_BoundingBox hull = ControlPointsUtils::ComputeBoundingBox(controlPoints);
+		std::vector<double> weights(degree + 1);
+		std::vector<double> weightDerivatives(degree);
+		for (int j = 0; j <= degree; j++)
+		{
+			weights[j] = controlPoints[j].GetW();
+		}
+		for (int j = 0; j < degree; j++)
 		{
-			b++;
+			weightDerivatives[j] = degree * (weights[j + 1] - weights[j]);
 		}
-		int multi = b - i + 1;
-		if (multi < degree)
+
+		roots.clear();
+		for (int k = 0; k < 3; k++)
 		{
-			double numerator = knotVector[b] - knotVector[a];
-			std::vector<double> alphaVector(degree + 1);
-			for (int j = degree; j > multi; j--)
+			if (hull.Min[k] >= box.Min[k] && hull.Max[k] <= box.Max[k])
 			{
-				alphaVector[j - multi - 1] = numerator / (knotVector[a + j] - knotVector[a]);
+				continue;
 			}
 
-			int r = degree - multi;
-			for (int j = 1; j <= r; j++)
+			// Numerator of the derivative of X / W is X' * W - X * W'.
+			std::vector<double> values(degree + 1);
+			std::vector<double> derivatives(degree);
+			for (int j = 0; j <= degree; j++)
 			{
-				int save = r - j;
-				int s = multi + j;
-				for (int k = degree; k >= s; k--)
-				{
-					double alpha = alphaVector[k - s];
-					beziers[nb].ControlPoints[k] = alpha * beziers[nb].ControlPoints[k] + (1.0 - alpha) * beziers[nb].ControlPoints[k-1];
-				}
-
-				if (b < m)
-				{
-					beziers[nb + 1].ControlPoints[save] = beziers[nb].ControlPoints[degree];
-				}
+				values[j] = controlPoints[j][k];
 			}
-
-			nb++;
-			if (b < m)
+			for (int j = 0; j < degree; j++)
 			{
-				for (int i = degree - multi; i <= degree; i++)
-				{
-					beziers[nb].ControlPoints[i] = controlPoints[b - degree + i];
-				}
-
-				a = b;
-				b += 1;
+				derivatives[j] = degree * (values[j + 1] - values[j]);
 			}
+			std::vector<double> left = MultiplyBernstein(derivatives, weights);
+			std::vector<double> right = MultiplyBernstein(values, weightDerivatives);
+			for (int j = 0; j < left.size(); j++)
+			{
+				left[j] -= right[j];
+			}
+			FindBernsteinRoots(left, 0.0, 1.0, 0, roots);
+		}
+		for (int j = 0; j < roots.size(); j++)
+		{
+			ExpandBoundingBox(box, GetPointOnCurve(checkedCurve, start + roots[j] * (end - start)));
 		}
 	}
-	return beziers;
+	return box;
+}
+
+std::vector<LNLib::LN_BoundingBox> LNLib::NurbsCurve::GetSpanBoundingBoxes(const LN_NurbsCurve& curve)
+{
+	Check(curve);
+
+	std::vector<double> uniqueKnots = curve.KnotVector;
+	uniqueKnots.erase(std::unique(uniqueKnots.begin(), uniqueKnots.end()), uniqueKnots.end());
+	std::vector<LN_NurbsCurve> beziers = DecomposeToBeziers(curve);
+
+	std::vector<LN_BoundingBox> boxes(uniqueKnots.size() - 1);
+	for (int i = 0; i < boxes.size(); i++)
+	{
+		boxes[i] = ControlPointsUtils::ComputeBoundingBox(beziers[i].ControlPoints);
+	}
+	return boxes;
 }
 
 bool LNLib::NurbsCurve::RemoveKnot(const LN_NurbsCurve& curve, double removeKnot, int times, LN_NurbsCurve& result)
 {
 	int degree = curve.Degree;
-	std::vector<double> knotVector = curve.KnotVector;
-	std::vector<XYZW> controlPoints = curve.ControlPoints;
+	const std::vector<double>& knotVector = curve.KnotVector;
+	const std::vector<XYZW>& controlPoints = curve.ControlPoints;
 
 	VALIDATE_ARGUMENT_RANGE(removeKnot, knotVector[0], knotVector[knotVector.size() - 1]);
 	VALIDATE_ARGUMENT(times > 0, "times", "Times must greater than zero.");
@@ -665,38 +2002,15 @@ bool LNLib::NurbsCurve::RemoveKnot(const LN_NurbsCurve& curve, double removeKnot
 void LNLib::NurbsCurve::ElevateDegree(const LN_NurbsCurve& curve, int times, LN_NurbsCurve& result)
 {
 	int degree = curve.Degree;
-	std::vector<double> knotVector = curve.KnotVector;
-	std::vector<XYZW> controlPoints = curve.ControlPoints;
+	const std::vector<double>& knotVector = curve.KnotVector;
+	const std::vector<XYZW>& controlPoints = curve.ControlPoints;
 
 	VALIDATE_ARGUMENT(times > 0, "times", "Times must greater than zero.");
 
 	int n = controlPoints.size() - 1;
 	int m = n + degree + 1;
 	int ph = degree + times;
-	int ph2 = floor(ph / 2);
-
-	std::vector<std::vector<double>> bezalfs(degree + times + 1, std::vector<double>(degree + 1));
-	bezalfs[0][0] = bezalfs[ph][degree] = 1.0;
-
-	for (int i = 1; i <= ph2; i++)
-	{
-		double inv = 1.0 / MathUtils::Binomial(ph, i);
-		int mpi = std::min(degree, i);
-
-		for (int j = std::max(0, i - times); j <= mpi; j++)
-		{
-			bezalfs[i][j] = inv * MathUtils::Binomial(degree, j) * MathUtils::Binomial(times, i - j);
-		}
-	}
-
-	for (int i = ph2 + 1; i <= ph - 1; i++)
-	{
-		int mpi = std::min(degree, i);
-		for (int j = std::max(0, i - times); j <= mpi; j++)
-		{
-			bezalfs[i][j] = bezalfs[ph - i][degree - j];
-		}
-	}
+	std::vector<std::vector<double>> bezalfs = Polynomials::BezierDegreeElevationMatrix(degree, times);
 
 	int mh = ph;
 	int kind = ph + 1;
@@ -706,7 +2020,8 @@ void LNLib::NurbsCurve::ElevateDegree(const LN_NurbsCurve& curve, int times, LN_
 	int cind = 1;
 	double ua = knotVector[0];
 
-	int moresize = n * times * 2;
+	// Every distinct knot, including the ends, gains times control points.
+	int moresize = n + 1 + times * (n - degree + 1);
 	std::vector<XYZW> updatedControlPoints(moresize,XYZW(Constants::MaxDistance, Constants::MaxDistance, Constants::MaxDistance,1));
 	updatedControlPoints[0] = controlPoints[0];
 
@@ -881,11 +2196,18 @@ void LNLib::NurbsCurve::ElevateDegree(const LN_NurbsCurve& curve, int times, LN_
 	result.ControlPoints = updatedControlPoints;
 }
 
+LNLib::LN_NurbsCurve LNLib::NurbsCurve::ElevateDegree(const LN_NurbsCurve& curve, int times)
+{
+	LN_NurbsCurve result;
+	ElevateDegree(curve, times, result);
+	return result;
+}
+
 bool LNLib::NurbsCurve::ReduceDegree(const LN_NurbsCurve& curve, LN_NurbsCurve& result)
 {
 	int degree = curve.Degree;
-	std::vector<double> knotVector = curve.KnotVector;
-	std::vector<XYZW> controlPoints = curve.ControlPoints;
+	const std::vector<double>& knotVector = curve.KnotVector;
+	const std::vector<XYZW>& controlPoints = curve.ControlPoints;
 
 	double tol = ValidationUtils::ComputeCurveModifyTolerance(controlPoints);
 
@@ -957,13 +2279,14 @@ bool LNLib::NurbsCurve::ReduceDegree(const LN_NurbsCurve& curve, LN_NurbsCurve&
 void LNLib::NurbsCurve::EquallyTessellate(const LN_NurbsCurve& curve, std::vector<XYZ>& tessellatedPoints, std::vector<double>& correspondingKnots)
 {
 	int degree = curve.Degree;
-	std::vector<double> knotVector = curve.KnotVector;
-	std::vector<XYZW> controlPoints = curve.ControlPoints;
+	const std::vector<double>& knotVector = curve.KnotVector;
+	const std::vector<XYZW>& controlPoints = curve.ControlPoints;
 
 	std::vector<double> uniqueKv = knotVector;
 	uniqueKv.erase(unique(uniqueKv.begin(), uniqueKv.end()), uniqueKv.end());
 	int size = uniqueKv.size();
 	int intervals = 100;
+	int offset = correspondingKnots.size();
 	for (int i = 0; i < size - 1; i++)
 	{
 		double currentU = uniqueKv[i];
@@ -973,16 +2296,102 @@ void LNLib::NurbsCurve::EquallyTessellate(const LN_NurbsCurve& curve, std::vecto
 		{
 			double u = currentU + step * j;
 			correspondingKnots.emplace_back(u);
-			tessellatedPoints.emplace_back(GetPointOnCurve(curve, u));
 		}
 	}
+	int count = correspondingKnots.size() - offset;
+	tessellatedPoints.resize(tessellatedPoints.size() + count);
+	GetPointsOnCurve(curve, correspondingKnots.data() + offset, count, tessellatedPoints.data() + tessellatedPoints.size() - count);
 	correspondingKnots.emplace_back(knotVector[knotVector.size() - 1]);
-	tessellatedPoints.emplace_back(const_cast<XYZW&>(controlPoints[controlPoints.size() - 1]).ToXYZ(true));
+	tessellatedPoints.emplace_back(controlPoints[controlPoints.size() - 1].ToXYZ(true));
+}
+
+void LNLib::NurbsCurve::EquallyTessellate(const std::vector<LN_NurbsCurve>& curves, std::vector<std::vector<XYZ>>& tessellatedPoints, std::vector<std::vector<double>>& correspondingKnots, ParallelExecutor* executor)
+{
+	tessellatedPoints.assign(curves.size(), std::vector<XYZ>());
+	correspondingKnots.assign(curves.size(), std::vector<double>());
+	CurveTessellationBatchFunction function = { tessellatedPoints, correspondingKnots };
+	Parallel::ForEach(curves, function, executor);
+}
+
+void LNLib::NurbsCurve::Tessellate(const LN_NurbsCurve& curve, double chordTolerance, double angleTolerance, std::vector<XYZ>& tessellatedPoints, std::vector<double>& correspondingKnots)
+{
+	LNLIB_SCOPED_TIMER("NurbsCurve::Tessellate");
+	VALIDATE_ARGUMENT(chordTolerance > 0, "chordTolerance", "ChordTolerance must greater than zero.");
+	VALIDATE_ARGUMENT(angleTolerance > 0, "angleTolerance", "AngleTolerance must greater than zero.");
+	LN_CheckedNurbsCurve checkedCurve = Check(curve);
+
+	const std::vector<double>& knotVector = curve.KnotVector;
+	std::vector<double> uniqueKv = knotVector;
+	uniqueKv.erase(unique(uniqueKv.begin(), uniqueKv.end()), uniqueKv.end());
+	int size = uniqueKv.size();
+
+	XYZ startPoint = GetPointOnCurve(checkedCurve, uniqueKv[0]);
+	correspondingKnots.emplace_back(uniqueKv[0]);
+	tessellatedPoints.emplace_back(startPoint);
+	for (int i = 0; i < size - 1; i++)
+	{
+		double currentU = uniqueKv[i];
+		double nextU = uniqueKv[i + 1];
+		XYZ middlePoint = GetPointOnCurve(checkedCurve, (currentU + nextU) / 2.0);
+		XYZ endPoint = GetPointOnCurve(checkedCurve, nextU);
+		TessellateInterval(checkedCurve, currentU, nextU, startPoint, middlePoint, endPoint, chordTolerance, angleTolerance, 0, tessellatedPoints, correspondingKnots);
+		startPoint = endPoint;
+	}
+}
+
+void LNLib::NurbsCurve::UpdateEqualTessellation(const LN_NurbsCurve& curve, const LN_DirtyRange& dirty, std::vector<XYZ>& tessellatedPoints, const std::vector<double>& correspondingKnots)
+{
+	VALIDATE_ARGUMENT(tessellatedPoints.size() == correspondingKnots.size(), "tessellatedPoints", "TessellatedPoints and correspondingKnots must have the same size.");
+
+	int first = std::lower_bound(correspondingKnots.begin(), correspondingKnots.end(), dirty.Start) - correspondingKnots.begin();
+	int last = std::upper_bound(correspondingKnots.begin(), correspondingKnots.end(), dirty.End) - correspondingKnots.begin();
+	if (first >= last)
+	{
+		return;
+	}
+	GetPointsOnCurve(curve, correspondingKnots.data() + first, last - first, tessellatedPoints.data() + first);
+}
+
+void LNLib::NurbsCurve::UpdateTessellation(const LN_NurbsCurve& curve, const LN_DirtyRange& dirty, double chordTolerance, double angleTolerance, std::vector<XYZ>& tessellatedPoints, std::vector<double>& correspondingKnots)
+{
+	LNLIB_SCOPED_TIMER("NurbsCurve::UpdateTessellation");
+	VALIDATE_ARGUMENT(chordTolerance > 0, "chordTolerance", "ChordTolerance must greater than zero.");
+	VALIDATE_ARGUMENT(angleTolerance > 0, "angleTolerance", "AngleTolerance must greater than zero.");
+	VALIDATE_ARGUMENT(tessellatedPoints.size() == correspondingKnots.size(), "tessellatedPoints", "TessellatedPoints and correspondingKnots must have the same size.");
+	LN_CheckedNurbsCurve checkedCurve = Check(curve);
+
+	// Span ends are always tessellation knots, so the dirty spans are one contiguous run of the output.
+	int first = std::lower_bound(correspondingKnots.begin(), correspondingKnots.end(), dirty.Start) - correspondingKnots.begin();
+	int last = std::lower_bound(correspondingKnots.begin(), correspondingKnots.end(), dirty.End) - correspondingKnots.begin();
+	VALIDATE_ARGUMENT(last < correspondingKnots.size() && correspondingKnots[first] == dirty.Start && correspondingKnots[last] == dirty.End, "correspondingKnots", "CorrespondingKnots must be a tessellation of the curve knot vector.");
+
+	std::vector<double> uniqueKv = curve.KnotVector;
+	uniqueKv.erase(unique(uniqueKv.begin(), uniqueKv.end()), uniqueKv.end());
+
+	std::vector<XYZ> points;
+	std::vector<double> knots;
+	XYZ startPoint = GetPointOnCurve(checkedCurve, dirty.Start);
+	knots.emplace_back(dirty.Start);
+	points.emplace_back(startPoint);
+	for (int i = dirty.FirstSpan; i <= dirty.LastSpan; i++)
+	{
+		double currentU = uniqueKv[i];
+		double nextU = uniqueKv[i + 1];
+		XYZ middlePoint = GetPointOnCurve(checkedCurve, (currentU + nextU) / 2.0);
+		XYZ endPoint = GetPointOnCurve(checkedCurve, nextU);
+		TessellateInterval(checkedCurve, currentU, nextU, startPoint, middlePoint, endPoint, chordTolerance, angleTolerance, 0, points, knots);
+		startPoint = endPoint;
+	}
+
+	tessellatedPoints.erase(tessellatedPoints.begin() + first, tessellatedPoints.begin() + last + 1);
+	tessellatedPoints.insert(tessellatedPoints.begin() + first, points.begin(), points.end());
+	correspondingKnots.erase(correspondingKnots.begin() + first, correspondingKnots.begin() + last + 1);
+	correspondingKnots.insert(correspondingKnots.begin() + first, knots.begin(), knots.end());
 }
 
 bool LNLib::NurbsCurve::IsClosed(const LN_NurbsCurve& curve)
 {
-	std::vector<double> knotVector = curve.KnotVector;
+	const std::vector<double>& knotVector = curve.KnotVector;
 	double first = knotVector[0];
 	double end = knotVector[knotVector.size() - 1];
 
@@ -993,7 +2402,7 @@ bool LNLib::NurbsCurve::IsClosed(const LN_NurbsCurve& curve)
 	bool isMatch = MathUtils::IsAlmostEqualTo(distance, 0.0);
 	if (isMatch) return true;
 
-	std::vector<XYZW> controlPoints = curve.ControlPoints;
+	const std::vector<XYZW>& controlPoints = curve.ControlPoints;
 	int n = controlPoints.size() - 1;
 	XYZ last = controlPoints[n].ToXYZ(true);
 
@@ -1026,13 +2435,17 @@ bool LNLib::NurbsCurve::IsClosed(const LN_NurbsCurve& curve)
 
 double LNLib::NurbsCurve::GetParamOnCurve(const LN_NurbsCurve& curve, const XYZ& givenPoint)
 {
-	int degree = curve.Degree;
-	std::vector<double> knotVector = curve.KnotVector;
-	std::vector<XYZW> controlPoints = curve.ControlPoints;
+	return GetParamOnCurve(curve, givenPoint, LN_ProjectionOptions());
+}
+
+double LNLib::NurbsCurve::GetParamOnCurve(const LN_NurbsCurve& curve, const XYZ& givenPoint, const LN_ProjectionOptions& options)
+{
+	LNLIB_SCOPED_TIMER("NurbsCurve::GetParamOnCurve");
+	const std::vector<double>& knotVector = curve.KnotVector;
 
 	double minValue = Constants::MaxDistance;
 
-	int maxIterations = 10;
+	int maxIterations = options.MaxIterations;
 	double paramT = Constants::DoubleEpsilon;
 	double minParam = knotVector[0];
 	double maxParam = knotVector[knotVector.size() - 1];
@@ -1093,8 +2506,8 @@ double LNLib::NurbsCurve::GetParamOnCurve(const LN_NurbsCurve& curve, const XYZ&
 		double condition1 = difference.Length();
 		double condition2 = std::abs(f / (derivatives[1].Length() * condition1));
 
-		if (condition1 < Constants::DistanceEpsilon &&
-			condition2 < Constants::DistanceEpsilon)
+		if (condition1 < options.DistanceTolerance &&
+			condition2 < options.CosineTolerance)
 		{
 			return paramT;
 		}
@@ -1102,7 +2515,7 @@ double LNLib::NurbsCurve::GetParamOnCurve(const LN_NurbsCurve& curve, const XYZ&
 		double df = derivatives[2].DotProduct(difference) + derivatives[1] * derivatives[1];
 		double temp = paramT - f / df;
 
-		if (isClosed)
+		if (!isClosed)
 		{
 			if (temp < a)
 			{
@@ -1126,41 +2539,83 @@ double LNLib::NurbsCurve::GetParamOnCurve(const LN_NurbsCurve& curve, const XYZ&
 		}
 
 		double condition4 = ((temp - paramT) * derivatives[1]).Length();
-		if (condition4 < Constants::DistanceEpsilon) 
+		if (condition4 < options.DistanceTolerance) 
 		{
 			return paramT;
 		}
 
 		paramT = temp;
 		counters++;
+		LNLIB_COUNT(NewtonIterations, 1);
 	}
 	return paramT;
 }
 
+LNLib::LN_CurveCurveDistance LNLib::NurbsCurve::MinimumDistance(const LN_NurbsCurve& curve0, const LN_NurbsCurve& curve1, double tolerance)
+{
+	PreparedCurve prepared0(curve0);
+	PreparedCurve prepared1(curve1);
+	return MinimumDistance(prepared0, prepared1, tolerance);
+}
+
+LNLib::LN_CurveCurveDistance LNLib::NurbsCurve::MinimumDistance(const PreparedCurve& curve0, const PreparedCurve& curve1, double tolerance)
+{
+	LNLIB_SCOPED_TIMER("NurbsCurve::MinimumDistance");
+	VALIDATE_ARGUMENT(tolerance > 0, "tolerance", "Tolerance must greater than zero.");
+
+	CurveDistanceSearch search(curve0, curve1, tolerance);
+	return search.Run();
+}
+
+std::vector<LNLib::LN_CurveCurveDistance> LNLib::NurbsCurve::MinimumDistance(const PreparedCurve& curve, const std::vector<LN_NurbsCurve>& others, double tolerance, ParallelExecutor* executor)
+{
+	VALIDATE_ARGUMENT(tolerance > 0, "tolerance", "Tolerance must greater than zero.");
+
+	CurveDistanceBatchFunction function(curve, tolerance, others.size());
+	Parallel::ForEach(others, function, executor);
+	return function.Distances;
+}
+
 void LNLib::NurbsCurve::CreateTransformed(const LN_NurbsCurve& curve, const Matrix4d& matrix, LN_NurbsCurve& result)
 {
-	int degree = curve.Degree;
-	std::vector<double> knotVector = curve.KnotVector;
-	std::vector<XYZW> controlPoints = curve.ControlPoints;
+	result = CreateTransformed(curve, matrix);
+}
 
-	int size = controlPoints.size();
-	std::vector<XYZW> transformedControlPoints(size);
+LNLib::LN_NurbsCurve LNLib::NurbsCurve::CreateTransformed(const LN_NurbsCurve& curve, const Matrix4d& matrix)
+{
+	return CreateTransformed(LN_NurbsCurve(curve), matrix);
+}
 
-	Matrix4d tempMatrix = matrix;
-	for (int i = 0; i < size; i++)
-	{
-		XYZW temp = controlPoints[i];
-		transformedControlPoints[i] = tempMatrix.OfWeightedPoint(temp);
-	}
-	result = curve;
-	result.ControlPoints = transformedControlPoints;
+LNLib::LN_NurbsCurve LNLib::NurbsCurve::CreateTransformed(LN_NurbsCurve&& curve, const Matrix4d& matrix)
+{
+	Transform(curve, matrix);
+	return std::move(curve);
+}
+
+std::vector<LNLib::LN_NurbsCurve> LNLib::NurbsCurve::CreateTransformed(const std::vector<LN_NurbsCurve>& curves, const Matrix4d& matrix, ParallelExecutor* executor)
+{
+	CurveTransformBatchFunction function(matrix, curves.size());
+	Parallel::ForEach(curves, function, executor);
+	return function.Curves;
+}
+
+void LNLib::NurbsCurve::Transform(LN_NurbsCurve& curve, const Matrix4d& matrix)
+{
+	std::vector<XYZW>& controlPoints = curve.ControlPoints;
+	matrix.OfWeightedPoints(controlPoints.data(), controlPoints.size(), controlPoints.data());
+}
+
+void LNLib::NurbsCurve::Transform(std::vector<LN_NurbsCurve>& curves, const Matrix4d& matrix, ParallelExecutor* executor)
+{
+	CurveTransformTask task(curves, matrix);
+	Parallel::For(curves.size(), task, executor);
 }
 
 void LNLib::NurbsCurve::Reparametrize(const LN_NurbsCurve& curve, double alpha, double beta, double gamma, double delta, LN_NurbsCurve& result)
 {
 	int degree = curve.Degree;
-	std::vector<double> knotVector = curve.KnotVector;
-	std::vector<XYZW> controlPoints = curve.ControlPoints;
+	const std::vector<double>& knotVector = curve.KnotVector;
+	const std::vector<XYZW>& controlPoints = curve.ControlPoints;
 
 	VALIDATE_ARGUMENT(MathUtils::IsGreaterThan(alpha * delta, gamma * beta), "coefficient", "(alpha * delta - gamma * beta) must greater than zero");
 
@@ -1180,7 +2635,7 @@ void LNLib::NurbsCurve::Reparametrize(const LN_NurbsCurve& curve, double alpha,
 			temp = temp * lambda;
 		}
 		double newW = abs(controlPoints[i].GetW() * temp);
-		updatedControlPoints[i] = XYZW(const_cast<XYZW&>(controlPoints[i]).ToXYZ(true), newW);
+		updatedControlPoints[i] = XYZW(controlPoints[i].ToXYZ(true), newW);
 	}
 
 	result.Degree = degree;
@@ -1190,46 +2645,55 @@ void LNLib::NurbsCurve::Reparametrize(const LN_NurbsCurve& curve, double alpha,
 
 void LNLib::NurbsCurve::Reparametrize(const LN_NurbsCurve& curve, double min, double max, LN_NurbsCurve& result)
 {
-	std::vector<double> knotVector = curve.KnotVector;
+	result = Reparametrize(curve, min, max);
+}
+
+LNLib::LN_NurbsCurve LNLib::NurbsCurve::Reparametrize(const LN_NurbsCurve& curve, double min, double max)
+{
+	return Reparametrize(LN_NurbsCurve(curve), min, max);
+}
 
-	if (MathUtils::IsAlmostEqualTo(min, knotVector[0]) && MathUtils::IsAlmostEqualTo(max, knotVector[knotVector.size() - 1]))
+LNLib::LN_NurbsCurve LNLib::NurbsCurve::Reparametrize(LN_NurbsCurve&& curve, double min, double max)
+{
+	std::vector<double>& knotVector = curve.KnotVector;
+	if (!MathUtils::IsAlmostEqualTo(min, knotVector[0]) || !MathUtils::IsAlmostEqualTo(max, knotVector[knotVector.size() - 1]))
 	{
-		result = curve;
-		return;
+		knotVector = KnotVectorUtils::Rescale(knotVector, min, max);
 	}
-
-	std::vector<double> newKnotVector = KnotVectorUtils::Rescale(knotVector, min, max);
-	result = curve;
-	result.KnotVector = newKnotVector;
+	return std::move(curve);
 }
 
 void LNLib::NurbsCurve::Reverse(const LN_NurbsCurve& curve, LN_NurbsCurve& result)
 {
-	int degree = curve.Degree;
-	std::vector<double> knotVector = curve.KnotVector;
-	std::vector<XYZW> controlPoints = curve.ControlPoints;;
+	result = Reverse(curve);
+}
 
+LNLib::LN_NurbsCurve LNLib::NurbsCurve::Reverse(const LN_NurbsCurve& curve)
+{
+	return Reverse(LN_NurbsCurve(curve));
+}
+
+LNLib::LN_NurbsCurve LNLib::NurbsCurve::Reverse(LN_NurbsCurve&& curve)
+{
+	std::vector<double>& knotVector = curve.KnotVector;
 	int size = knotVector.size();
-	std::vector<double> reversedKnotVector(size);
 	double min = knotVector[0];
 	double max = knotVector[size - 1];
 
-	reversedKnotVector[0] = min;
-	for (int i = 1; i < size; i++)
+	// Reversed knots keep the mirrored spans: u'[i] = min + max - u[size - 1 - i].
+	std::reverse(knotVector.begin(), knotVector.end());
+	for (int i = 0; i < size; i++)
 	{
-		reversedKnotVector[i] = reversedKnotVector[i - 1] + (knotVector[size - i] - knotVector[size - i - 1]);
+		knotVector[i] = min + max - knotVector[i];
 	}
-	std::reverse(controlPoints.begin(), controlPoints.end());
-
-	result.Degree = curve.Degree;
-	result.KnotVector = reversedKnotVector;
-	result.ControlPoints = controlPoints;
+	std::reverse(curve.ControlPoints.begin(), curve.ControlPoints.end());
+	return std::move(curve);
 }
 
 bool LNLib::NurbsCurve::SplitAt(const LN_NurbsCurve& curve, double parameter, LN_NurbsCurve& left, LN_NurbsCurve& right)
 {
 	int degree = curve.Degree;
-	std::vector<double> knotVector = curve.KnotVector;
+	const std::vector<double>& knotVector = curve.KnotVector;
 	std::vector<XYZW> controlPoints = curve.ControlPoints;
 
 	if (MathUtils::IsLessThanOrEqual(parameter, knotVector[degree]) ||
@@ -1243,9 +2707,7 @@ bool LNLib::NurbsCurve::SplitAt(const LN_NurbsCurve& curve, double parameter, LN
 	left = curve;
 	if (insert.size() > 0)
 	{
-		LN_NurbsCurve temp;
-		NurbsCurve::RefineKnotVector(left, insert, temp);
-		left = temp;
+		NurbsCurve::RefineKnotVector(left, insert);
 	}
 
 	int spanIndex = Polynomials::GetKnotSpanIndex(left.Degree, left.KnotVector, parameter) - degree;
@@ -1272,71 +2734,110 @@ bool LNLib::NurbsCurve::SplitAt(const LN_NurbsCurve& curve, double parameter, LN
 	return true;
 }
 
-bool LNLib::NurbsCurve::Merge(const LN_NurbsCurve& left, const LN_NurbsCurve& right, LN_NurbsCurve& result)
+std::vector<LNLib::LN_NurbsCurve> LNLib::NurbsCurve::SplitAt(const LN_NurbsCurve& curve, const std::vector<double>& parameters)
 {
-	int degree_L = left.Degree;
-	std::vector<double> knotVector_L = left.KnotVector;
-	std::vector<XYZW> controlPoints_L = left.ControlPoints;
-
-	int degree_R = right.Degree;
-	std::vector<double> knotVector_R = right.KnotVector;
-	std::vector<XYZW> controlPoints_R = right.ControlPoints;
+	Check(curve);
+	int degree = curve.Degree;
 
-	if (!controlPoints_L[controlPoints_L.size() - 1].IsAlmostEqualTo(controlPoints_R[0]))
+	std::vector<double> splitParameters;
+	std::vector<double> insert = KnotVectorUtils::GetSplitKnotElements(degree, curve.KnotVector, parameters, splitParameters);
+	LN_NurbsCurve refined = curve;
+	if (insert.size() > 0)
 	{
-		return false;
+		NurbsCurve::RefineKnotVector(refined, insert);
 	}
 
-	int degree = std::max(degree_L, degree_R);
-	LN_NurbsCurve tempL = left;
-	if (degree > degree_L)
+	int count = splitParameters.size() + 1;
+	std::vector<LN_NurbsCurve> result(count);
+	int start = 0;
+	for (int i = 0; i < count; i++)
 	{
-		int times = degree - degree_L;
-		ElevateDegree(left, times, tempL);
+		// Every split knot has multiplicity degree + 1, so a piece ends with its control point before the last copy of the knot.
+		int end = i < count - 1 ? Polynomials::GetKnotSpanIndex(degree, refined.KnotVector, splitParameters[i]) - degree : refined.ControlPoints.size();
+		LN_NurbsCurve& piece = result[i];
+		piece.Degree = degree;
+		piece.KnotVector.assign(refined.KnotVector.begin() + start, refined.KnotVector.begin() + end + degree + 1);
+		piece.ControlPoints.assign(refined.ControlPoints.begin() + start, refined.ControlPoints.begin() + end);
+		start = end;
 	}
+	return result;
+}
 
-	LN_NurbsCurve tempR = right;
-	if (degree > degree_R)
-	{
-		int times = degree - degree_R;
-		ElevateDegree(right, times, tempR);
-	}
+bool LNLib::NurbsCurve::Merge(const LN_NurbsCurve& left, const LN_NurbsCurve& right, LN_NurbsCurve& result)
+{
+	std::vector<LN_NurbsCurve> curves = { left, right };
+	return Merge(curves, result);
+}
 
-	int l = Polynomials::GetKnotMultiplicity(tempL.KnotVector, tempL.KnotVector[tempL.KnotVector.size() - 1]);
-	int r = Polynomials::GetKnotMultiplicity(tempR.KnotVector, tempR.KnotVector[0]);
+bool LNLib::NurbsCurve::Merge(const std::vector<LN_NurbsCurve>& curves, LN_NurbsCurve& result)
+{
+	int count = curves.size();
+	VALIDATE_ARGUMENT(count > 0, "curves", "Curves size must greater than zero.");
 
-	if (l != degree + 1 || r != degree + 1)
+	int degree = 0;
+	for (int i = 0; i < count; i++)
 	{
-		return false;
+		degree = std::max(degree, curves[i].Degree);
 	}
 
-	int size = tempL.ControlPoints.size() + tempR.ControlPoints.size();
-	std::vector<XYZW> controlPoints(size);
-	int ksize = size + degree + 1;
-	std::vector<double> knotVector(ksize);
-
-	int i;
-	for (i = 0; i < tempL.ControlPoints.size(); i++)
+	std::vector<LN_NurbsCurve> elevated(count);
+	std::vector<const LN_NurbsCurve*> parts(count);
+	int size = 0;
+	for (int i = 0; i < count; i++)
 	{
-		controlPoints[i] = tempL.ControlPoints[i];
-	}
-		
-	for (; i < size; i++)
-	{
-		controlPoints[i] = tempR.ControlPoints[i - tempL.ControlPoints.size()];
-	}
-		
+		const LN_NurbsCurve& curve = curves[i];
+		if (degree > curve.Degree)
+		{
+			ElevateDegree(curve, degree - curve.Degree, elevated[i]);
+			parts[i] = &elevated[i];
+		}
+		else
+		{
+			parts[i] = &curve;
+		}
 
-	for (i = 0; i <tempL.KnotVector.size(); i++)
-	{
-		knotVector[i] = tempL.KnotVector[i];
+		const LN_NurbsCurve& part = *parts[i];
+		if (i > 0)
+		{
+			const LN_NurbsCurve& previous = *parts[i - 1];
+			if (!previous.ControlPoints[previous.ControlPoints.size() - 1].IsAlmostEqualTo(part.ControlPoints[0]))
+			{
+				return false;
+			}
+			int l = Polynomials::GetKnotMultiplicity(previous.KnotVector, previous.KnotVector[previous.KnotVector.size() - 1]);
+			int r = Polynomials::GetKnotMultiplicity(part.KnotVector, part.KnotVector[0]);
+			if (l != degree + 1 || r != degree + 1)
+			{
+				return false;
+			}
+		}
+		size += part.ControlPoints.size();
 	}
-		
-	for (; i < ksize; i++)
+
+	// Every joint keeps the end knot of the previous part with multiplicity degree + 1,
+	// the following part is shifted to start there.
+	std::vector<XYZW> controlPoints;
+	controlPoints.reserve(size);
+	std::vector<double> knotVector;
+	knotVector.reserve(size + degree + 1);
+	knotVector.insert(knotVector.end(), parts[0]->KnotVector.begin(), parts[0]->KnotVector.end());
+	for (int i = 0; i < count; i++)
 	{
-		knotVector[i] = tempR.KnotVector[i - tempL.KnotVector.size() + degree + 1];
+		const LN_NurbsCurve& part = *parts[i];
+		controlPoints.insert(controlPoints.end(), part.ControlPoints.begin(), part.ControlPoints.end());
+		if (i > 0)
+		{
+			double shift = knotVector[knotVector.size() - 1] - part.KnotVector[0];
+			for (int k = degree + 1; k < part.KnotVector.size(); k++)
+			{
+				knotVector.emplace_back(part.KnotVector[k] + shift);
+			}
+		}
 	}
 
+	result.Degree = degree;
+	result.KnotVector = std::move(knotVector);
+	result.ControlPoints = std::move(controlPoints);
 	return true;
 }
 
@@ -1366,6 +2867,119 @@ void LNLib::NurbsCurve::Offset(const LN_NurbsCurve& curve, double offset, LN_Nur
 	GlobalInterpolation(3, newPoints, result);
 }
 
+bool LNLib::NurbsCurve::Offset(const LN_NurbsCurve& curve, double offset, double maxError, LN_NurbsCurve& result)
+{
+	VALIDATE_ARGUMENT(MathUtils::IsGreaterThan(maxError, 0.0), "maxError", "MaxError must greater than zero.");
+
+	if (MathUtils::IsAlmostEqualTo(offset, 0.0))
+	{
+		result = curve;
+		return true;
+	}
+
+	LN_CheckedNurbsCurve checkedCurve = Check(curve);
+	const std::vector<double>& knotVector = curve.KnotVector;
+	int degree = curve.Degree;
+	int n = curve.ControlPoints.size() - 1;
+
+	// Interior knots of the fit start from the distinct interior knots of the curve.
+	std::vector<double> knots;
+	LN_DerivativeWorkspace workspace;
+	std::vector<double> params;
+	std::vector<XYZ> points;
+	XYZ reference = GetOffsetReferenceBinormal(curve);
+	bool isSampled = true;
+	double startParam = knotVector[degree];
+	XYZ startPoint = GetOffsetCurvePoint(checkedCurve, offset, startParam, reference, workspace);
+	params.emplace_back(startParam);
+	points.emplace_back(startPoint);
+	for (int i = degree + 1; i <= n + 1; i++)
+	{
+		double spanEnd = knotVector[i];
+		if (MathUtils::IsAlmostEqualTo(spanEnd, startParam)) continue;
+		if (i <= n)
+		{
+			knots.emplace_back(spanEnd);
+		}
+
+		// A few fixed samples per span so inflecting offsets are not mistaken for straight ones.
+		double step = (spanEnd - startParam) / OffsetSamplesPerSpan;
+		for (int k = 1; k <= OffsetSamplesPerSpan; k++)
+		{
+			double endParam = k == OffsetSamplesPerSpan ? spanEnd : startParam + step;
+			XYZ endPoint = GetOffsetCurvePoint(checkedCurve, offset, endParam, reference, workspace);
+			if (!SampleOffsetCurve(checkedCurve, offset, maxError, startParam, startPoint, endParam, endPoint, reference, 0, workspace, params, points))
+			{
+				isSampled = false;
+			}
+			startParam = endParam;
+			startPoint = endPoint;
+		}
+	}
+
+	double first = params.front();
+	double last = params.back();
+	int minSamples = 2 * (OffsetDegree + 1);
+	bool isFitted = false;
+	for (int iteration = 0; iteration < OffsetMaxRefinements; iteration++)
+	{
+		std::vector<double> fitKnotVector(OffsetDegree + 1, first);
+		fitKnotVector.insert(fitKnotVector.end(), knots.begin(), knots.end());
+		fitKnotVector.insert(fitKnotVector.end(), OffsetDegree + 1, last);
+		FitOffsetSamples(fitKnotVector, params, points, result);
+
+		// Spans holding a sample beyond maxError are halved while they keep enough samples for the fit, otherwise they are sampled denser.
+		std::vector<XYZ> fitted = GetPointsOnCurve(result, params);
+		std::vector<int> spanSamples(knots.size() + 1, 0);
+		std::vector<bool> isExceeded(knots.size() + 1, false);
+		for (int k = 0; k < params.size(); k++)
+		{
+			int span = std::upper_bound(knots.begin(), knots.end(), params[k]) - knots.begin();
+			spanSamples[span]++;
+			if (MathUtils::IsGreaterThan(fitted[k].Distance(points[k]), maxError))
+			{
+				isExceeded[span] = true;
+			}
+		}
+
+		isFitted = std::find(isExceeded.begin(), isExceeded.end(), true) == isExceeded.end();
+		std::vector<double> insertKnots;
+		for (int span = 0; span <= knots.size(); span++)
+		{
+			if (!isExceeded[span] || spanSamples[span] < minSamples) continue;
+			double spanStart = span == 0 ? first : knots[span - 1];
+			double spanEnd = span == knots.size() ? last : knots[span];
+			insertKnots.emplace_back(0.5 * (spanStart + spanEnd));
+		}
+
+		std::vector<double> denseParams;
+		std::vector<XYZ> densePoints;
+		denseParams.reserve(2 * params.size());
+		densePoints.reserve(2 * points.size());
+		for (int k = 0; k < params.size(); k++)
+		{
+			if (k > 0)
+			{
+				int span = std::upper_bound(knots.begin(), knots.end(), params[k - 1]) - knots.begin();
+				if (isExceeded[span] && spanSamples[span] < minSamples)
+				{
+					double middleParam = 0.5 * (params[k - 1] + params[k]);
+					denseParams.emplace_back(middleParam);
+					densePoints.emplace_back(GetOffsetCurvePoint(checkedCurve, offset, middleParam, reference, workspace));
+				}
+			}
+			denseParams.emplace_back(params[k]);
+			densePoints.emplace_back(points[k]);
+		}
+		if (insertKnots.empty() && denseParams.size() == params.size()) break;
+		params.swap(denseParams);
+		points.swap(densePoints);
+		knots.insert(knots.end(), insertKnots.begin(), insertKnots.end());
+		std::sort(knots.begin(), knots.end());
+	}
+	return isSampled && isFitted;
+}
+
 void LNLib::NurbsCurve::CreateLine(const XYZ& start, const XYZ& end, LN_NurbsCurve& result)
 {
 	VALIDATE_ARGUMENT(!start.IsAlmostEqualTo(end), "end", "start must not be equal to end.");
@@ -1465,8 +3079,8 @@ bool LNLib::NurbsCurve::CreateArc(const XYZ& center, const XYZ& xAxis, const XYZ
 		knotVector[3] = knotVector[4] = 0.5;
 		break;
 	case 3:
-		knotVector[3] = knotVector[4] = 1 / 3;
-		knotVector[5] = knotVector[6] = 2 / 3;
+		knotVector[3] = knotVector[4] = 1.0 / 3.0;
+		knotVector[5] = knotVector[6] = 2.0 / 3.0;
 		break;
 	case 4:
 		knotVector[3] = knotVector[4] = 0.25;
@@ -1644,10 +3258,10 @@ bool LNLib::NurbsCurve::CreateOpenConic(const XYZ& start, const XYZ& startTangen
 
 void LNLib::NurbsCurve::GlobalInterpolation(int degree, const std::vector<XYZ>& throughPoints, LN_NurbsCurve& curve, const std::vector<double>& params)
 {
+	LNLIB_SCOPED_TIMER("NurbsCurve::GlobalInterpolation");
 	VALIDATE_ARGUMENT(degree > 0, "degree", "Degree must greater than zero.");
 	VALIDATE_ARGUMENT(throughPoints.size() > degree, "throughPoints", "ThroughPoints size must greater than degree.");
 	int size = throughPoints.size();
-	int n = size - 1;
 
 	std::vector<double> uk(size);
 	if (params.size() == 0)
@@ -1661,19 +3275,9 @@ void LNLib::NurbsCurve::GlobalInterpolation(int degree, const std::vector<XYZ>&
 	}
 	std::vector<double> knotVector = Interpolation::AverageKnotVector(degree, uk);
 
-	std::vector<std::vector<double>> A(size, std::vector<double>(size));
-	for (int i = 1; i < n; i++)
-	{
-		int spanIndex = Polynomials::GetKnotSpanIndex(degree, knotVector, uk[i]);
-		std::vector<double> basis = Polynomials::BasisFunctions(spanIndex, degree, knotVector, uk[i]);
-
-		for (int j = 0; j <= degree; j++)
-		{
-			A[i][spanIndex - degree + j] = basis[j];
-		}
-	}
-	A[0][0] = 1.0;
-	A[n][n] = 1.0;
+	int lowerBandwidth = 0;
+	int upperBandwidth = 0;
+	std::vector<std::vector<double>> A = Interpolation::CreateCollocationMatrix(degree, knotVector, uk, lowerBandwidth, upperBandwidth);
 
 	std::vector<std::vector<double>> right(size, std::vector<double>(3));
 	for (int i = 0; i < size; i++)
@@ -1685,7 +3289,7 @@ void LNLib::NurbsCurve::GlobalInterpolation(int degree, const std::vector<XYZ>&
 	}
 
 	std::vector<XYZW> controlPoints(size);
-	std::vector<std::vector<double>> result = MathUtils::SolveLinearSystem(A, right);
+	std::vector<std::vector<double>> result = MathUtils::SolveBandedLinearSystem(A, lowerBandwidth, upperBandwidth, right);
 	for (int i = 0; i < result.size(); i++)
 	{
 		XYZ temp = XYZ(0, 0, 0);
@@ -1702,6 +3306,7 @@ void LNLib::NurbsCurve::GlobalInterpolation(int degree, const std::vector<XYZ>&
 
 void LNLib::NurbsCurve::GlobalInterpolation(int degree, const std::vector<XYZ>& throughPoints, const std::vector<XYZ>& tangents, double tangentFactor, LN_NurbsCurve& curve)
 {
+	LNLIB_SCOPED_TIMER("NurbsCurve::GlobalInterpolation");
 	VALIDATE_ARGUMENT(degree > 0, "degree", "Degree must greater than zero.");
 	VALIDATE_ARGUMENT(throughPoints.size() > degree, "throughPoints", "ThroughPoints size must greater than degree.");
 	VALIDATE_ARGUMENT(MathUtils::IsGreaterThan(tangentFactor, 0.0), "tangentFactor", "TangentFactor must greater than zero.");
@@ -1771,24 +3376,36 @@ void LNLib::NurbsCurve::GlobalInterpolation(int degree, const std::vector<XYZ>&
 	}
 	}
 
-	std::vector<std::vector<double>> A(n, std::vector<double>(n));
+	int lowerBandwidth = 1;
+	int upperBandwidth = 1;
+	std::vector<int> spanIndices(size);
+	KnotSpanCursor cursor(degree, knotVector);
+	for (int i = 1; i < size - 1; i++)
+	{
+		spanIndices[i] = cursor.Find(uk[i]);
+		UpdateBandwidth(2 * i, spanIndices[i] - degree, spanIndices[i], lowerBandwidth, upperBandwidth);
+		UpdateBandwidth(2 * i + 1, spanIndices[i] - degree, spanIndices[i], lowerBandwidth, upperBandwidth);
+	}
+
+	std::vector<std::vector<double>> A = MathUtils::CreateBandedMatrix(n, lowerBandwidth, upperBandwidth);
+	std::vector<double> derBasis(2 * (degree + 1));
 	for (int i = 1; i < size - 1; i++)
 	{
-		int spanIndex = Polynomials::GetKnotSpanIndex(degree, knotVector, uk[i]);
-		std::vector<double> basis = Polynomials::BasisFunctions(spanIndex, degree, knotVector, uk[i]);
-		std::vector<std::vector<double>> derBasis = Polynomials::BasisFunctionsDerivatives(spanIndex, degree, 1, knotVector, uk[i]);
+		int spanIndex = spanIndices[i];
+		Polynomials::BasisFunctionsDerivatives(spanIndex, degree, 1, knotVector, uk[i], derBasis.data());
 		for (int j = 0; j <= degree; j++)
 		{
-			A[2 * i][spanIndex - degree + j] = basis[j];
-			A[2 * i + 1][spanIndex - degree + j] = derBasis[1][j];
+			int column = spanIndex - degree + j;
+			A[2 * i][column - 2 * i + lowerBandwidth] = derBasis[j];
+			A[2 * i + 1][column - 2 * i - 1 + lowerBandwidth] = derBasis[degree + 1 + j];
 		}
 	}
-	A[0][0] = 1.0;
-	A[1][0] = -1.0;
-	A[1][1] = 1.0;
-	A[A.size() - 2][A[0].size() - 2] = -1.0;
-	A[A.size() - 2][A[0].size() - 1] = 1.0;
-	A[A.size() - 1][A[0].size() - 1] = 1.0;
+	A[0][lowerBandwidth] = 1.0;
+	A[1][lowerBandwidth - 1] = -1.0;
+	A[1][lowerBandwidth] = 1.0;
+	A[n - 2][lowerBandwidth] = -1.0;
+	A[n - 2][lowerBandwidth + 1] = 1.0;
+	A[n - 1][lowerBandwidth] = 1.0;
 
 	std::vector<std::vector<double>> right(n, std::vector<double>(3));
 	for (int i = 0; i < size; i++)
@@ -1809,11 +3426,11 @@ void LNLib::NurbsCurve::GlobalInterpolation(int degree, const std::vector<XYZ>&
 	for (int j = 0; j < 3; j++)
 	{
 		right[1][j] = d0 * dp0[j] * d;
-		right[A[0].size() - 2][j] = dn * dpn[j] * d;
-		right[A[0].size() - 1][j] = qpn[j];
+		right[n - 2][j] = dn * dpn[j] * d;
+		right[n - 1][j] = qpn[j];
 	}
 
-	std::vector<std::vector<double>> result = MathUtils::SolveLinearSystem(A, right);
+	std::vector<std::vector<double>> result = MathUtils::SolveBandedLinearSystem(A, lowerBandwidth, upperBandwidth, right);
 	for (int i = 0; i < result.size(); i++)
 	{
 		XYZ temp = XYZ(0, 0, 0);
@@ -1896,6 +3513,7 @@ bool LNLib::NurbsCurve::CubicLocalInterpolation(const std::vector<XYZ>& throughP
 
 bool LNLib::NurbsCurve::LeastSquaresApproximation(int degree, const std::vector<XYZ>& throughPoints, int controlPointsCount, LN_NurbsCurve& curve)
 {
+	LNLIB_SCOPED_TIMER("NurbsCurve::LeastSquaresApproximation");
 	VALIDATE_ARGUMENT(degree > 0, "degree", "Degree must greater than zero.");
 	VALIDATE_ARGUMENT(controlPointsCount > 0, "controlPointsCount", "controlPointsCount must greater than zero.");
 
@@ -1923,64 +3541,27 @@ bool LNLib::NurbsCurve::LeastSquaresApproximation(int degree, const std::vector<
 	}
 
 	std::vector<XYZW> controlPoints(n);
-	std::vector<XYZ> R(n);
-	std::vector<XYZ> rk(m);
-	std::vector<double> funs(degree + 1);
-	std::vector<std::vector<double>> N(m, std::vector<double>(n));
-	R[0] = throughPoints[0];
-	R[n - 1] = throughPoints[m - 1];
-	N[0][0] = 1.0;
-	N[m - 1][n - 1] = 1.0;
-
-	for (int i = 0; i < m; i++)
-	{
-		int spanIndex = Polynomials::GetKnotSpanIndex(degree, knotVector, uk[i]);
-		std::vector<double> basis = Polynomials::BasisFunctions(spanIndex, degree, knotVector, uk[i]);
-		for (int j = 0; j <= degree; j++)
-		{
-			N[i][spanIndex - degree + j] = basis[j];
-		}
-		rk[i] = throughPoints[i] - N[i][0] * throughPoints[0] - N[i][n - 1] * throughPoints[m - 1];
-	}
-
-	for (int i = 0; i < n; i++) 
-	{
-		R[i] = XYZ();
-		for (int j = 0; j < m; j++)
-		{
-			R[i] += N[j][i] * rk[j];
-		}
-			
-		if (R[i].IsAlmostEqualTo(XYZ()))
-		{
-			return false;
-		}
-	}
-	
 	if (n - 2 > 0) 
 	{
-		std::vector<std::vector<double>> X(n - 2, std::vector<double>(3));
+		std::vector<int> spanIndices;
+		std::vector<std::vector<double>> basis;
+		std::vector<std::vector<double>> NTN = Interpolation::CreateLeastSquaresNormalMatrix(degree, knotVector, uk, n, spanIndices, basis);
+		std::vector<XYZ> R = Interpolation::GetLeastSquaresRight(degree, n, spanIndices, basis, throughPoints);
+
 		std::vector<std::vector<double>> B(n - 2, std::vector<double>(3));
-		std::vector<std::vector<double>> Ns(m - 2, std::vector<double>(n-2));
 		for (int i = 0; i < n - 2; i++) 
 		{
+			if (R[i].IsAlmostEqualTo(XYZ()))
+			{
+				return false;
+			}
 			for (int j = 0; j < 3; j++)
 			{
-				B[i][j] = R[i + 1][j];
+				B[i][j] = R[i][j];
 			}	
 		}
-		for (int i = 1; i <= m - 2; i++)
-		{
-			for (int j = 1; j <= n - 2; j++)
-			{
-				Ns[i - 1][j - 1] = N[i][j];
-			}
-		}
-		std::vector<std::vector<double>> NsT;
-		MathUtils::Transpose(Ns, NsT);
-		auto NsTNs = MathUtils::MatrixMultiply(NsT, Ns);
-		X = MathUtils::SolveLinearSystem(NsTNs, B);
 
+		std::vector<std::vector<double>> X = MathUtils::SolveSymmetricBandedLinearSystem(NTN, degree, B);
 		for (int i = 0; i < n - 2; i++)
 		{
 			double x = X[i][0];
@@ -2051,18 +3632,19 @@ bool LNLib::NurbsCurve::WeightedAndContrainedLeastSquaresApproximation(int degre
 	std::vector<XYZW> controlPoints(controlPointsCount);
 
 	int j = 0;
-	int mu2 = 0;
 	int mc2 = 0;
 
-	std::vector<std::vector<double>> N(mu + 1, std::vector<double>(n + 1));
-	std::vector<XYZ> S(mu + 1);
-	std::vector<double> W(mu + 1);
-	std::vector<std::vector<double>> M(mc + 1, std::vector<double>(n + 1));
-	std::vector<XYZ> T(mc + 1);
+	// Rows of N only keep their degree + 1 nonzeros, N^T * W * N is assembled straight into symmetric banded storage.
+	std::vector<std::vector<double>> NTWN = MathUtils::CreateBandedMatrix(n + 1, degree, 0);
+	std::vector<std::vector<double>> NTWS(n + 1, std::vector<double>(3, 0.0));
+	std::vector<std::vector<double>> M(mc + 1, std::vector<double>(n + 1, 0.0));
+	std::vector<std::vector<double>> T(mc + 1, std::vector<double>(3));
 
+	KnotSpanCursor cursor(degree, knotVector);
 	for (int i = 0; i <= r; i++)
 	{
-		int spanIndex = Polynomials::GetKnotSpanIndex(degree, knotVector, uk[i]);
+		int spanIndex = cursor.Find(uk[i]);
+		int first = spanIndex - degree;
 		std::vector<std::vector<double>> basis = Polynomials::BasisFunctionsDerivatives(spanIndex, degree, 1, knotVector, uk[i]);
 
 		bool dflag = false;
@@ -2070,115 +3652,86 @@ bool LNLib::NurbsCurve::WeightedAndContrainedLeastSquaresApproximation(int degre
 		{
 			dflag = true;
 		}
-		if (MathUtils::IsGreaterThan(weights[i], 0.0))
-		{
-			W[mu2] = weights[i];
-			N[mu2] = basis[0];
-			S[mu2] = W[mu2] * throughPoints[i];
-			mu2++;
-		}
-		else
+		for (int d = 0; d <= (dflag ? 1 : 0); d++)
 		{
-			M[mc2] = basis[0];
-			T[mc2] = throughPoints[i];
-			mc2++;
-		}
-		if (dflag)
-		{
-			if (MathUtils::IsGreaterThan(weightedTangents[j], 0.0))
+			double w = d == 0 ? weights[i] : weightedTangents[j];
+			const XYZ& point = d == 0 ? throughPoints[i] : tangents[j];
+			const std::vector<double>& row = basis[d];
+			if (MathUtils::IsGreaterThan(w, 0.0))
 			{
-				W[mu2] = weightedTangents[j];
-				N[mu2] = basis[1];
-				S[mu2] = W[mu2] * tangents[j];
-				mu2++;
+				for (int a = 0; a <= degree; a++)
+				{
+					double wa = w * row[a];
+					for (int b = 0; b <= a; b++)
+					{
+						NTWN[first + a][b - a + degree] += wa * row[b];
+					}
+					for (int k = 0; k < 3; k++)
+					{
+						NTWS[first + a][k] += wa * point[k];
+					}
+				}
 			}
 			else
 			{
-				M[mc2] = basis[1];
-				T[mc2] = tangents[j];
+				for (int a = 0; a <= degree; a++)
+				{
+					M[mc2][first + a] = row[a];
+				}
+				for (int k = 0; k < 3; k++)
+				{
+					T[mc2][k] = point[k];
+				}
 				mc2++;
 			}
-			j++;
 		}
-	}
-	std::vector<std::vector<double>> NT;
-	MathUtils::Transpose(N, NT);
-
-	std::vector<std::vector<double>> W_ = MathUtils::MakeDiagonal(W.size());
-	std::vector<std::vector<double>> NTW = MathUtils::MatrixMultiply(NT, W_);
-	std::vector<std::vector<double>> NTWN = MathUtils::MatrixMultiply(NTW, N);
-
-	std::vector<std::vector<double>> S_(S.size(), std::vector<double>(3));
-	for (int i = 0; i < S.size(); i++)
-	{
-		for (int j = 0; j < 3; j++)
+		if (dflag)
 		{
-			S_[i][j] = S[i][j];
+			j++;
 		}
 	}
-	std::vector<std::vector<double>> NTWS = MathUtils::MatrixMultiply(NTW, S_);
+
+	std::vector<std::vector<double>> result;
 	if (mc < 0)
 	{
-		std::vector<std::vector<double>> result = MathUtils::SolveLinearSystem(NTWN, NTWS);
-		for (int i = 0; i < result.size(); i++)
-		{
-			XYZ temp = XYZ(0, 0, 0);
-			for (int j = 0; j < 3; j++)
-			{
-				temp[j] = result[i][j];
-			}
-			controlPoints[i] = XYZW(temp, 1.0);
-		}
-		return true;
+		result = MathUtils::SolveSymmetricBandedLinearSystem(NTWN, degree, NTWS);
 	}
+	else
+	{
+		bool canDecompose = MathUtils::SymmetricBandedCholeskyDecomposition(NTWN, degree);
+		if (!canDecompose) return false;
 
-	std::vector<std::vector<double>> INTWN;
-	bool canInverse = MathUtils::MakeInverse(NTWN, INTWN);
-	if (!canInverse) return false;
+		std::vector<std::vector<double>> MT;
+		MathUtils::Transpose(M, MT);
 
-	std::vector<std::vector<double>> MT;
-	MathUtils::Transpose(M,MT);
-	
-	std::vector<std::vector<double>> MINTWN = MathUtils::MatrixMultiply(M,INTWN);
-	std::vector<std::vector<double>> MINTWNMT = MathUtils::MatrixMultiply(MINTWN, MT);
+		std::vector<std::vector<double>> INTWNMT = MathUtils::SymmetricBandedForwardAndBackwardSubstitution(NTWN, degree, MT);
+		std::vector<std::vector<double>> MINTWNMT = MathUtils::MatrixMultiply(M, INTWNMT);
 
-	std::vector<std::vector<double>> MINTWNNTWS = MathUtils::MatrixMultiply(MINTWN, NTWS);
-	std::vector<std::vector<double>> T_(T.size(), std::vector<double>(3));
-	for (int i = 0; i < T.size(); i++)
-	{
-		for (int j = 0; j < 3; j++)
-		{
-			T_[i][j] = T[i][j];
-		}
-	}
-	std::vector<std::vector<double>> MINTWNNTWST(T.size(),std::vector<double>(3));
-	for (int i = 0; i < T.size(); i++)
-	{
-		for (int j = 0; j < 3; j++)
+		std::vector<std::vector<double>> INTWNNTWS = MathUtils::SymmetricBandedForwardAndBackwardSubstitution(NTWN, degree, NTWS);
+		std::vector<std::vector<double>> MINTWNNTWST = MathUtils::MatrixMultiply(M, INTWNNTWS);
+		for (int i = 0; i < T.size(); i++)
 		{
-			MINTWNNTWST[i][j] = MINTWNNTWS[i][j] - T_[i][j];
+			for (int k = 0; k < 3; k++)
+			{
+				MINTWNNTWST[i][k] -= T[i][k];
+			}
 		}
-	}
 
-	std::vector<std::vector<double>> A = MathUtils::SolveLinearSystem(MINTWNMT, MINTWNNTWST);
-	std::vector<std::vector<double>> MTA = MathUtils::MatrixMultiply(MT, A);
-	std::vector<std::vector<double>> NTWS_MTA(NTWS.size(), std::vector<double>(3));
-	for (int i = 0; i < NTWS.size(); i++)
-	{
-		for (int j = 0; j < 3; j++)
+		std::vector<std::vector<double>> A = MathUtils::SolveLinearSystem(MINTWNMT, MINTWNNTWST);
+		std::vector<std::vector<double>> MTA = MathUtils::MatrixMultiply(MT, A);
+		std::vector<std::vector<double>> NTWS_MTA(NTWS.size(), std::vector<double>(3));
+		for (int i = 0; i < NTWS.size(); i++)
 		{
-			NTWS_MTA[i][j] = NTWS[i][j] - MTA[i][j];
+			for (int k = 0; k < 3; k++)
+			{
+				NTWS_MTA[i][k] = NTWS[i][k] - MTA[i][k];
+			}
 		}
+		result = MathUtils::SymmetricBandedForwardAndBackwardSubstitution(NTWN, degree, NTWS_MTA);
 	}
-	std::vector<std::vector<double>> result = MathUtils::MatrixMultiply(INTWN, NTWS_MTA);
 	for (int i = 0; i < result.size(); i++)
 	{
-		XYZ temp = XYZ(0, 0, 0);
-		for (int j = 0; j < 3; j++)
-		{
-			temp[j] = result[i][j];
-		}
-		controlPoints[i] = XYZW(temp, 1.0);
+		controlPoints[i] = XYZW(XYZ(result[i][0], result[i][1], result[i][2]), 1.0);
 	}
 	curve.Degree = degree;
 	curve.KnotVector = knotVector;
@@ -2190,8 +3743,8 @@ bool LNLib::NurbsCurve::WeightedAndContrainedLeastSquaresApproximation(int degre
 double LNLib::NurbsCurve::ComputerRemoveKnotErrorBound(const LN_NurbsCurve& curve, int removalIndex)
 {
 	int degree = curve.Degree;
-	std::vector<double> knotVector = curve.KnotVector;
-	std::vector<XYZW> controlPoints = curve.ControlPoints;
+	const std::vector<double>& knotVector = curve.KnotVector;
+	const std::vector<XYZW>& controlPoints = curve.ControlPoints;
 
 	VALIDATE_ARGUMENT_RANGE(removalIndex, 0, knotVector.size()-1);
 
@@ -2235,215 +3788,87 @@ double LNLib::NurbsCurve::ComputerRemoveKnotErrorBound(const LN_NurbsCurve& curv
 	}
 }
 
-void LNLib::NurbsCurve::RemoveKnotsByGivenBound(const LN_NurbsCurve& curve, const std::vector<double> params, std::vector<double>& errors, double maxError, LN_NurbsCurve& result)
+int LNLib::NurbsCurve::RemoveKnotsByGivenBound(const LN_NurbsCurve& curve, const std::vector<double>& params, std::vector<double>& errors, double maxError, LN_NurbsCurve& result, int maxRemovals, const CancellationToken* cancellation)
 {
-	int degree = curve.Degree;
-	std::vector<double> knotVector = curve.KnotVector;
-	std::vector<XYZW> controlPoints = curve.ControlPoints;
-
 	VALIDATE_ARGUMENT(params.size() > 0, "params", "Params size must greater than zero.");
 	VALIDATE_ARGUMENT(params.size() == errors.size(), "errors", "Errors size must equal to params size.");
 	VALIDATE_ARGUMENT(MathUtils::IsGreaterThan(maxError,0.0), "maxError", "Maxerror must greater than zero.");
 
-	int knotSize = knotVector.size();
-	std::vector<double> Br(knotSize, Constants::MaxDistance);
-	std::vector<int> S(knotSize, 0);
-	std::vector<int> Nl(knotSize);
-	std::vector<int> Nr(knotSize, params.size() - 1);
-
-	std::vector<double> uk = params;
-	int ukSize = uk.size();
-	std::vector<double> NewError(ukSize);
-	std::vector<double> temp(ukSize);
-
-	int i, BrMinIndex = 0;
-	int r, s, Rstart, Rend, k;
-	double BrMin, u;
-
-	int controlPointsSize = controlPoints.size();
-	int n = controlPointsSize - 1;
-	s = 1;
-	for (int i = degree + 1; i < controlPointsSize; i++)
-	{
-		if (MathUtils::IsLessThan(knotVector[i],knotVector[i + 1]))
-		{
-			Br[i] = ComputerRemoveKnotErrorBound(curve, i);
-			S[i] = Polynomials::GetKnotMultiplicity(knotVector, knotVector[i]);
-			s = 1;
-		}
-		else {
-			Br[i] = Constants::MaxDistance;
-			S[i] = 1;
-			s++;
-		}
-	}
-
-	Nl[0] = 0;
-	for (int i = 0; i < ukSize; i++)
-	{
-		int spanIndex = Polynomials::GetKnotSpanIndex(degree, knotVector, uk[i]);
-		if (!Nl[spanIndex])
-		{
-			Nl[spanIndex] = i;
-		}
-		if (i + 1 < ukSize)
-		{
-			Nr[spanIndex] = i + 1;
-		}
-	}
-
-	std::vector<double> tempU = knotVector;
-	std::vector<XYZW> tempCP = controlPoints;
-
-	std::vector<double> updatedKnotVector;
-	std::vector<XYZW> updatedControlPoints;
-
-	while (1)
-	{
-		double minStandard = Constants::MaxDistance;
-		for (int i = 0; i < Br.size(); i++)
-		{
-			if (MathUtils::IsLessThan(Br[i],minStandard))
-			{
-				BrMinIndex = i;
-				minStandard = Br[i];
-			}
+	result = curve;
+	int degree = result.Degree;
+	const std::vector<double>& knotVector = result.KnotVector;
+	const std::vector<XYZW>& controlPoints = result.ControlPoints;
+
+	std::map<double, int> stamps;
+	KnotRemovalQueue queue;
+	PushKnotRemovalCandidates(result, knotVector.front(), knotVector.back(), stamps, queue);
+
+	int removed = 0;
+	std::vector<double> newErrors(params.size());
+	while (!queue.empty() && (maxRemovals <= 0 || removed < maxRemovals) && controlPoints.size() > degree + 1)
+	{
+		CancellationToken::ThrowIfCancelled(cancellation);
+		KnotRemovalCandidate candidate = queue.top();
+		queue.pop();
+		std::map<double, int>::iterator stamp = stamps.find(candidate.Knot);
+		if (stamp == stamps.end() || stamp->second != candidate.Stamp) continue;
+		// Looked at until a neighbouring removal pushes a fresh bound.
+		stamp->second++;
+
+		int r = std::upper_bound(knotVector.begin(), knotVector.end(), candidate.Knot) - knotVector.begin() - 1;
+		int s = Polynomials::GetKnotMultiplicity(knotVector, candidate.Knot);
+
+		// Only parameters inside the support of the basis function scaling the bound are affected.
+		int basisIndex = 0;
+		double scale = candidate.Bound;
+		if ((degree + s) % 2)
+		{
+			int k = (degree + s + 1) / 2;
+			basisIndex = r - k + 1;
+			double a = (knotVector[r] - knotVector[basisIndex]) / (knotVector[r - k + degree + 2] - knotVector[basisIndex]);
+			scale *= 1.0 - a;
 		}
-		BrMin = Br[BrMinIndex];
-
-		if (BrMin == Constants::MaxDistance)
+		else
 		{
-			updatedKnotVector = tempU;
-			updatedControlPoints = tempCP;
-			break;
+			int k = (degree + s) / 2;
+			basisIndex = r - k;
 		}
-		r = BrMinIndex;
-		s = S[BrMinIndex];
-
-		Rstart = std::max(r - degree, degree + 1);
-		Rend = std::min(r + degree - S[r + degree] + 1, n);
-		Rstart = Nl[Rstart];
-		Rend = Nr[Rend];
+		int startIndex = std::lower_bound(params.begin(), params.end(), knotVector[basisIndex]) - params.begin();
+		int endIndex = std::upper_bound(params.begin(), params.end(), knotVector[basisIndex + degree + 1]) - params.begin();
 
 		bool removable = true;
-		for (i = Rstart; i <= Rend; i++)
+		for (int i = startIndex; i < endIndex; i++)
 		{
-			double a;
-			s = S[r];
-			if ((degree + s) % 2)
-			{
-				u = uk[i];
-				k = (degree + s + 1) / 2;
-				a = tempU[r] - tempU[r - k + 1];
-				a /= tempU[r - k + degree + 2] - tempU[r - k + 1];
-				NewError[i] = (1.0 - a) * Br[r] * Polynomials::OneBasisFunction(r - k + 1, degree, tempU, u);
-			}
-			else
-			{
-				u = uk[i];
-				k = (degree + s) / 2;
-				NewError[i] = Br[r] * Polynomials::OneBasisFunction(r - k, degree, tempU, u);
-			}
-			temp[i] = NewError[i] + errors[i];
-			if (MathUtils::IsGreaterThan(temp[i],maxError))
+			newErrors[i] = errors[i] + scale * Polynomials::OneBasisFunction(basisIndex, degree, knotVector, params[i]);
+			if (MathUtils::IsGreaterThan(newErrors[i], maxError))
 			{
 				removable = false;
-				Br[r] = Constants::MaxDistance;
-				updatedKnotVector = tempU;
-				updatedControlPoints = tempCP;
 				break;
 			}
 		}
+		if (!removable) continue;
 
-		if (removable)
+		for (int i = startIndex; i < endIndex; i++)
 		{
-			LN_NurbsCurve tc;
-			tc.Degree = degree;
-			tc.KnotVector = tempU;
-			tc.ControlPoints = tempCP;
-
-			LN_NurbsCurve newtc;
-			RemoveKnot(tc, tempU[r], 1, newtc);
-			std::vector<double> tempNewU = newtc.KnotVector;
-			std::vector<XYZW> tempNewCP = newtc.ControlPoints;
-
-			controlPointsSize = tempNewCP.size();
-			for (int i = Rstart; i <= Rend; i++)
-			{
-				errors[i] = temp[i];
-			}
-
-			if (controlPointsSize <= degree + 1)
-			{
-				updatedKnotVector = tempU;
-				updatedControlPoints = tempCP;
-				break;
-			}
-
-			Rstart = Nl[r - degree - 1];
-			Rend = Nr[r - S[r]];
-			int spanIndex = 0;
-			int oldspanIndex = -1;
-			for (int k = Rstart; k <= Rend; k++)
-			{
-				spanIndex = Polynomials::GetKnotSpanIndex(degree, tempNewU, uk[k]);
-				if (spanIndex != oldspanIndex)
-				{
-					Nl[spanIndex] = k;
-				}
-				if (k + 1 < ukSize)
-				{
-					Nr[spanIndex] = k + 1;
-				}
-				oldspanIndex = spanIndex;
-			}
-			for (int k = r - S[r] + 1; k < Nl.size() - 1; k++) {
-				Nl[k] = Nl[k + 1];
-				Nr[k] = Nr[k + 1];
-			}
-			Nl.resize(Nl.size() - 1);
-			Nr.resize(Nr.size() - 1);
-
-			Rstart = std::max(r - degree, degree + 1);
-			Rend = std::min(r + degree - S[r] + 1, controlPointsSize);
-			s = S[Rstart];
-			for (i = Rstart; i <= Rend; i++)
-			{
-				if (MathUtils::IsLessThan(tempNewU[i],tempNewU[i + 1]))
-				{
-					Br[i] = ComputerRemoveKnotErrorBound(newtc, i);
-					S[i] = s;
-					s = 1;
-				}
-				else {
-					Br[i] = Constants::MaxDistance;
-					S[i] = 1;
-					s++;
-				}
-			}
-			for (int i = Rend + 1; i < Br.size() - 1; i++)
-			{
-				Br[i] = Br[i + 1];
-				S[i] = S[i + 1];
-			}
-			Br.resize(Br.size() - 1);
-
-			tempU = tempNewU;
-			tempCP = tempNewCP;
+			errors[i] = newErrors[i];
 		}
-		else
+		RemoveKnotInPlace(result, r, s);
+		removed++;
+		if (s == 1)
 		{
-			Br[r] = Constants::MaxDistance;
+			stamps.erase(stamp);
 		}
-	}
 
-	result.Degree = degree;
-	result.KnotVector = updatedKnotVector;
-	result.ControlPoints = updatedControlPoints;
+		int low = std::max(0, r - degree - 1);
+		int high = std::min((int)knotVector.size() - 1, r + degree + 1);
+		PushKnotRemovalCandidates(result, knotVector[low], knotVector[high], stamps, queue);
+	}
+	return removed;
 }
 
-void LNLib::NurbsCurve::GlobalApproximationByErrorBound(int degree, const std::vector<XYZ>& throughPoints, double maxError, LN_NurbsCurve& result)
+void LNLib::NurbsCurve::GlobalApproximationByErrorBound(int degree, const std::vector<XYZ>& throughPoints, double maxError, LN_NurbsCurve& result, int maxRemovals, const CancellationToken* cancellation)
 {
+	LNLIB_SCOPED_TIMER("NurbsCurve::GlobalApproximationByErrorBound");
 	VALIDATE_ARGUMENT(degree > 0, "degree", "Degree must greater than zero.");
 	VALIDATE_ARGUMENT(throughPoints.size() > degree, "throughPoints", "ThroughPoints size must greater than degree.");
 	VALIDATE_ARGUMENT(MathUtils::IsGreaterThan(maxError, 0.0), "maxError", "Maxerror must greater than zero.");
@@ -2473,9 +3898,17 @@ void LNLib::NurbsCurve::GlobalApproximationByErrorBound(int degree, const std::v
 	tc.KnotVector = knotVector;
 	tc.ControlPoints = controlPoints;
 
-	LN_NurbsCurve newtc;
-	ElevateDegree(tc, degree - 1, newtc);
-	RemoveKnotsByGivenBound(newtc, uk, errors, maxError, result);
+	if (degree > 1)
+	{
+		tc = ElevateDegree(tc, degree - 1);
+	}
+	RemoveKnotsByGivenBound(tc, uk, errors, maxError, result, maxRemovals, cancellation);
+}
+
+std::future<LNLib::LN_NurbsCurve> LNLib::NurbsCurve::GlobalApproximationByErrorBoundAsync(int degree, const std::vector<XYZ>& throughPoints, double maxError, int maxRemovals, const CancellationToken* cancellation)
+{
+	ErrorBoundApproximationJob job = { degree, throughPoints, maxError, maxRemovals, cancellation };
+	return std::async(std::launch::async, job);
 }
 
 bool LNLib::NurbsCurve::FitWithConic(const std::vector<XYZ>& throughPoints, int startPointIndex, int endPointIndex, const XYZ& startTangent, const XYZ& endTangent, double maxError, std::vector<XYZW>& middleControlPoints)
@@ -2746,7 +4179,7 @@ bool LNLib::NurbsCurve::ControlPointReposition(const LN_NurbsCurve& curve, doubl
 {
 	int degree = curve.Degree;
 	std::vector<double> knotVector = curve.KnotVector;
-	std::vector<XYZW> controlPoints = curve.ControlPoints;
+	const std::vector<XYZW>& controlPoints = curve.ControlPoints;
 
 	VALIDATE_ARGUMENT_RANGE(parameter, knotVector[0], knotVector[knotVector.size() - 1]);
 	VALIDATE_ARGUMENT_RANGE(moveIndex, 0, controlPoints.size() - 1);
@@ -2775,14 +4208,14 @@ void LNLib::NurbsCurve::WeightModification(const LN_NurbsCurve& curve, double pa
 {
 	int degree = curve.Degree;
 	std::vector<double> knotVector = curve.KnotVector;
-	std::vector<XYZW> controlPoints = curve.ControlPoints;
+	const std::vector<XYZW>& controlPoints = curve.ControlPoints;
 
 	VALIDATE_ARGUMENT_RANGE(parameter, knotVector[0], knotVector[knotVector.size() - 1]);
 	VALIDATE_ARGUMENT_RANGE(moveIndex, 0, controlPoints.size() - 1);
 	VALIDATE_ARGUMENT(!MathUtils::IsAlmostEqualTo(moveDistance, 0.0), "moveDistance", "MoveDistance must not be zero.");
 
 	XYZ point = GetPointOnCurve(curve, parameter);
-	XYZ movePoint = const_cast<XYZW&>(controlPoints[moveIndex]).ToXYZ(true);
+	XYZ movePoint = controlPoints[moveIndex].ToXYZ(true);
 	double distance =  point.Distance(movePoint);
 	int spanIndex = Polynomials::GetKnotSpanIndex(degree, knotVector, parameter);
 	double Rkp = Polynomials::BasisFunctions(spanIndex, degree, knotVector, parameter)[0];
@@ -2799,7 +4232,7 @@ bool LNLib::NurbsCurve::NeighborWeightsModification(const LN_NurbsCurve& curve,
 {
 	int degree = curve.Degree;
 	std::vector<double> knotVector = curve.KnotVector;
-	std::vector<XYZW> controlPoints = curve.ControlPoints;
+	const std::vector<XYZW>& controlPoints = curve.ControlPoints;
 
 	VALIDATE_ARGUMENT_RANGE(parameter, knotVector[0], knotVector[knotVector.size() - 1]);
 	VALIDATE_ARGUMENT_RANGE(moveIndex, 0, controlPoints.size() - 1);
@@ -2807,9 +4240,9 @@ bool LNLib::NurbsCurve::NeighborWeightsModification(const LN_NurbsCurve& curve,
 	VALIDATE_ARGUMENT(!MathUtils::IsAlmostEqualTo(scale, 0.0), "scale", "Scale must not be zero.");
 
 	std::vector<XYZW> tempControlPoints = controlPoints;
-	XYZ movePoint1 = const_cast<XYZW&>(tempControlPoints[moveIndex]).ToXYZ(true);
+	XYZ movePoint1 = tempControlPoints[moveIndex].ToXYZ(true);
 	tempControlPoints[moveIndex] = XYZW(movePoint1, 0.0);
-	XYZ movePoint2 = const_cast<XYZW&>(tempControlPoints[moveIndex+1]).ToXYZ(true);
+	XYZ movePoint2 = tempControlPoints[moveIndex+1].ToXYZ(true);
 	tempControlPoints[moveIndex+1] = XYZW(movePoint2, 0.0);
 
 	LN_NurbsCurve tc;
@@ -2874,11 +4307,59 @@ bool LNLib::NurbsCurve::NeighborWeightsModification(const LN_NurbsCurve& curve,
 	return true;
 }
 
+bool LNLib::NurbsCurve::ControlPointReposition(const LN_NurbsCurve& curve, double parameter, int moveIndex, XYZ moveDirection, double moveDistance, LN_NurbsCurve& result, LN_DirtyRange& dirty)
+{
+	if (!ControlPointReposition(curve, parameter, moveIndex, moveDirection, moveDistance, result))
+	{
+		return false;
+	}
+	dirty = GetDirtyRange(result, moveIndex, moveIndex);
+	return true;
+}
+
+void LNLib::NurbsCurve::WeightModification(const LN_NurbsCurve& curve, double parameter, int moveIndex, double moveDistance, LN_NurbsCurve& result, LN_DirtyRange& dirty)
+{
+	WeightModification(curve, parameter, moveIndex, moveDistance, result);
+	dirty = GetDirtyRange(result, moveIndex, moveIndex);
+}
+
+bool LNLib::NurbsCurve::NeighborWeightsModification(const LN_NurbsCurve& curve, double parameter, int moveIndex, double moveDistance, double scale, LN_NurbsCurve& result, LN_DirtyRange& dirty)
+{
+	if (!NeighborWeightsModification(curve, parameter, moveIndex, moveDistance, scale, result))
+	{
+		return false;
+	}
+	dirty = GetDirtyRange(result, moveIndex, moveIndex + 1);
+	return true;
+}
+
+LNLib::LN_DirtyRange LNLib::NurbsCurve::GetDirtyRange(const LN_NurbsCurve& curve, int firstIndex, int lastIndex)
+{
+	int degree = curve.Degree;
+	const std::vector<double>& knotVector = curve.KnotVector;
+	int n = curve.ControlPoints.size() - 1;
+
+	VALIDATE_ARGUMENT_RANGE(firstIndex, 0, n);
+	VALIDATE_ARGUMENT_RANGE(lastIndex, firstIndex, n);
+
+	LN_DirtyRange dirty;
+	dirty.FirstIndex = firstIndex;
+	dirty.LastIndex = lastIndex;
+	dirty.Start = knotVector[firstIndex];
+	dirty.End = knotVector[lastIndex + degree + 1];
+
+	std::vector<double> uniqueKv = knotVector;
+	uniqueKv.erase(unique(uniqueKv.begin(), uniqueKv.end()), uniqueKv.end());
+	dirty.FirstSpan = std::lower_bound(uniqueKv.begin(), uniqueKv.end(), dirty.Start) - uniqueKv.begin();
+	dirty.LastSpan = std::lower_bound(uniqueKv.begin(), uniqueKv.end(), dirty.End) - uniqueKv.begin() - 1;
+	return dirty;
+}
+
 void LNLib::NurbsCurve::Warping(const LN_NurbsCurve& curve, const std::vector<double>& warpShape, double warpDistance, const XYZ& planeNormal, double startParameter, double endParameter, LN_NurbsCurve& result)
 {
 	int degree = curve.Degree;
 	std::vector<double> knotVector = curve.KnotVector;
-	std::vector<XYZW> controlPoints = curve.ControlPoints;
+	const std::vector<XYZW>& controlPoints = curve.ControlPoints;
 
 	VALIDATE_ARGUMENT(controlPoints.size() == warpShape.size(), "warpShape", "WarpShape size must equals to control points size.");
 	VALIDATE_ARGUMENT(!MathUtils::IsAlmostEqualTo(warpDistance, 0.0), "warpDistance", "WarpDistance must not be zero.");
@@ -2910,7 +4391,7 @@ bool LNLib::NurbsCurve::Flattening(const LN_NurbsCurve& curve, XYZ lineStartPoin
 {
 	int degree = curve.Degree;
 	std::vector<double> knotVector = curve.KnotVector;
-	std::vector<XYZW> controlPoints = curve.ControlPoints;
+	const std::vector<XYZW>& controlPoints = curve.ControlPoints;
 
 	VALIDATE_ARGUMENT(!lineStartPoint.IsAlmostEqualTo(lineEndPoint), "lineEndPoint", "lineEndPoint must not be equals to lineStartPoint.");
 	VALIDATE_ARGUMENT_RANGE(startParameter, knotVector[0], knotVector[knotVector.size() - 1]);
@@ -2923,7 +4404,7 @@ bool LNLib::NurbsCurve::Flattening(const LN_NurbsCurve& curve, XYZ lineStartPoin
 	std::unordered_map<int, XYZ> selectedControlPoints;
 	for (int i = spanMinIndex; i <= spanMaxIndex - degree - 1; i++)
 	{
-		XYZ p = const_cast<XYZW&>(controlPoints[i]).ToXYZ(true);
+		XYZ p = controlPoints[i].ToXYZ(true);
 		selectedControlPoints.insert({ i, p });
 	}
 	
@@ -2955,7 +4436,7 @@ void LNLib::NurbsCurve::Bending(const LN_NurbsCurve& curve, double startParamete
 {
 	int degree = curve.Degree;
 	std::vector<double> knotVector = curve.KnotVector;
-	std::vector<XYZW> controlPoints = curve.ControlPoints;
+	const std::vector<XYZW>& controlPoints = curve.ControlPoints;
 
 	VALIDATE_ARGUMENT_RANGE(startParameter, knotVector[0], knotVector[knotVector.size() - 1]);
 	VALIDATE_ARGUMENT_RANGE(endParameter, knotVector[0], knotVector[knotVector.size() - 1]);
@@ -2968,7 +4449,7 @@ void LNLib::NurbsCurve::Bending(const LN_NurbsCurve& curve, double startParamete
 	std::unordered_map<int, XYZ> selectedControlPoints;
 	for (int i = spanMinIndex; i <= spanMaxIndex - degree - 1; i++)
 	{
-		XYZ p = const_cast<XYZW&>(updatedControlPoints[i]).ToXYZ(true);
+		XYZ p = updatedControlPoints[i].ToXYZ(true);
 		selectedControlPoints.insert({ i, p });
 	}
 
@@ -3060,10 +4541,6 @@ void LNLib::NurbsCurve::ConstraintBasedModification(const LN_NurbsCurve& curve,
 	std::vector<std::vector<double>> Bt;
 	MathUtils::Transpose(Bopt, Bt);
 	std::vector<std::vector<double>> BoptBt = MathUtils::MatrixMultiply(Bopt, Bt);
-	std::vector<std::vector<double>> BBt;
-	MathUtils::MakeInverse(BoptBt, BBt);
-
-	auto A = MathUtils::MatrixMultiply(Bt, BBt);
 	std::vector<std::vector<double>> dD(D.size(), std::vector<double>(3));
 	for (int i = 0; i < D.size(); i++)
 	{
@@ -3073,7 +4550,13 @@ void LNLib::NurbsCurve::ConstraintBasedModification(const LN_NurbsCurve& curve,
 		}
 	}
 
-	auto dP = MathUtils::MatrixMultiply(A, dD);
+	std::vector<std::vector<double>> BBtdD = MathUtils::SolveLinearSystem(BoptBt, dD);
+	if (BBtdD.size() == 0)
+	{
+		result = curve;
+		return;
+	}
+	auto dP = MathUtils::MatrixMultiply(Bt, BBtdD);
 	std::vector<XYZW> updatedControlPoints = controlPoints;
 	for (int i = 0; i < map.size(); i++)
 	{
@@ -3110,9 +4593,7 @@ void LNLib::NurbsCurve::ToClampCurve(const LN_NurbsCurve& curve, LN_NurbsCurve&
 	
 	LN_NurbsCurve tc;
 	int t1 = InsertKnot(curve, up, degree + 1 - upMulti, tc);
-	LN_NurbsCurve temp;
-	temp = tc;
-	int t2 = InsertKnot(temp, ump, degree + 1 - umpMulti, tc);
+	int t2 = InsertKnot(tc, ump, degree + 1 - umpMulti);
 
 	std::vector<double> kv = tc.KnotVector;
 	std::vector<XYZW> cps = tc.ControlPoints;
@@ -3143,8 +4624,8 @@ void LNLib::NurbsCurve::ToClampCurve(const LN_NurbsCurve& curve, LN_NurbsCurve&
 bool LNLib::NurbsCurve::IsPeriodic(const LN_NurbsCurve& curve)
 {
 	int degree = curve.Degree;
-	std::vector<double> knotVector = curve.KnotVector;
-	std::vector<XYZW> controlPoints = curve.ControlPoints;
+	const std::vector<double>& knotVector = curve.KnotVector;
+	const std::vector<XYZW>& controlPoints = curve.ControlPoints;
 	int size = controlPoints.size();
 
 	bool isClamp = IsClamp(curve);
@@ -3247,7 +4728,7 @@ void LNLib::NurbsCurve::ToUnclampCurve(const LN_NurbsCurve& curve, LN_NurbsCurve
 bool LNLib::NurbsCurve::IsClamp(const LN_NurbsCurve& curve)
 {
 	int degree = curve.Degree;
-	std::vector<double> knotVector = curve.KnotVector;
+	const std::vector<double>& knotVector = curve.KnotVector;
 	double first = knotVector[0];
 	double end = knotVector[knotVector.size() - 1];
 
@@ -3262,9 +4743,7 @@ bool LNLib::NurbsCurve::IsClamp(const LN_NurbsCurve& curve)
 
 bool LNLib::NurbsCurve::IsLinear(const LN_NurbsCurve& curve)
 {
-	int degree = curve.Degree;
-	std::vector<double> knotVector = curve.KnotVector;
-	std::vector<XYZW> controlPoints = curve.ControlPoints;
+	const std::vector<XYZW>& controlPoints = curve.ControlPoints;
 
 	int size = controlPoints.size();
 	if (size == 2)
@@ -3273,25 +4752,35 @@ bool LNLib::NurbsCurve::IsLinear(const LN_NurbsCurve& curve)
 	XYZ end =  controlPoints[size - 1].ToXYZ(true);
 	if ((end - start).IsAlmostEqualTo(XYZ()))
 		return false;
+	double length = start.Distance(end);
 	XYZ dir = (end - start).Normalize();
 
-	auto map = KnotVectorUtils::GetInternalKnotMultiplicityMap(knotVector);
-	for (auto it = map.begin(); it != map.end(); it++)
+	// The curve lies on the line exactly when all control points do (the basis functions are independent),
+	// monotonic control points keep it from running back by the variation diminishing property.
+	double previous = 0.0;
+	for (int i = 1; i < size - 1; i++)
 	{
-		double u = it->first;
-		XYZ cp = GetPointOnCurve(curve, u);
-		XYZ cp2s = (cp - start).Normalize();
-		XYZ cp2e = (cp - end).Normalize();
-
-		if (!cp2s.IsAlmostEqualTo(dir))
+		XYZ vector = controlPoints[i].ToXYZ(true) - start;
+		double projection = vector.DotProduct(dir);
+		if (!(vector - dir * projection).IsAlmostEqualTo(XYZ()))
 			return false;
-		if (!cp2e.IsAlmostEqualTo(dir.Negative()))
+		if (projection < previous - Constants::DoubleEpsilon || projection > length + Constants::DoubleEpsilon)
 			return false;
+		previous = std::max(previous, projection);
 	}
 	return true;
 }
 
 bool LNLib::NurbsCurve::IsArc(const LN_NurbsCurve& curve)
+{
+	XYZ center;
+	XYZ normal;
+	double radius = 0.0;
+	double sweepAngle = 0.0;
+	return IsArc(curve, center, normal, radius, sweepAngle);
+}
+
+bool LNLib::NurbsCurve::IsArc(const LN_NurbsCurve& curve, XYZ& center, XYZ& normal, double& radius, double& sweepAngle)
 {
 	if (IsLinear(curve))
 	{
@@ -3299,14 +4788,15 @@ bool LNLib::NurbsCurve::IsArc(const LN_NurbsCurve& curve)
 	}
 
 	int degree = curve.Degree;
-	std::vector<double> knotVector = curve.KnotVector;
+	const std::vector<double>& knotVector = curve.KnotVector;
 	std::vector<XYZW> controlPoints = curve.ControlPoints;
 
 	double first = knotVector[0];
 	double end = knotVector[knotVector.size() - 1];
 
 	XYZ P0 = GetPointOnCurve(curve, first);
-	double param = IsClosed(curve)?0.5 * first + 0.5 * end : end;
+	bool isClosed = IsClosed(curve);
+	double param = isClosed?0.5 * first + 0.5 * end : end;
 	XYZ P1 = GetPointOnCurve(curve,0.5 * first + 0.5 * param);
 	XYZ P2 = GetPointOnCurve(curve, param);
 
@@ -3320,29 +4810,46 @@ bool LNLib::NurbsCurve::IsArc(const LN_NurbsCurve& curve)
 	double base = 0.5 / (v1v1 * v2v2 - v1v2 * v1v2);
 	double k1 = base * v2v2 * (v1v1 - v1v2);
 	double k2 = base * v1v1 * (v2v2 - v1v2);
-	XYZ center = P0 + v1 * k1 + v2 * k2;
-	double radius = center.Distance(P0);
+	center = P0 + v1 * k1 + v2 * k2;
+	radius = center.Distance(P0);
+	normal = v1.CrossProduct(v2);
+	if (normal.IsZero())
+	{
+		return false;
+	}
+	normal = normal.Normalize();
 
 	std::vector<XYZ> tessellatedPoints;
 	std::vector<double> correspondingKnots;
 	EquallyTessellate(curve, tessellatedPoints, correspondingKnots);
+	sweepAngle = 0.0;
 	for (int i = 0; i < tessellatedPoints.size(); i++)
 	{
 		XYZ point = tessellatedPoints[i];
 		double d = point.Distance(center);
-		if (!MathUtils::IsAlmostEqualTo(d, radius))
+		if (!MathUtils::IsAlmostEqualTo(d, radius) ||
+			!MathUtils::IsAlmostEqualTo((point - center).DotProduct(normal), 0.0))
 		{
 			return false;
 		}
+		if (i > 0)
+		{
+			sweepAngle += (tessellatedPoints[i - 1] - center).AngleTo(point - center);
+		}
+	}
+	if (isClosed)
+	{
+		sweepAngle = 2 * Constants::Pi;
 	}
 	return true;
 }
 
 double LNLib::NurbsCurve::ApproximateLength(const LN_NurbsCurve& curve, IntegratorType type)
 {
+	LNLIB_SCOPED_TIMER("NurbsCurve::ApproximateLength");
 	if (IsLinear(curve))
 	{
-		std::vector<XYZW> controlPoints = curve.ControlPoints;
+		const std::vector<XYZW>& controlPoints = curve.ControlPoints;
 		XYZ startPoint = controlPoints[0].ToXYZ(true);
 		XYZ endPoint = controlPoints[controlPoints.size() - 1].ToXYZ(true);
 		return startPoint.Distance(endPoint);
@@ -3362,7 +4869,7 @@ double LNLib::NurbsCurve::ApproximateLength(const LN_NurbsCurve& curve, Integrat
 		{
 			double start = knotVector[0];
 			double end = knotVector[knotVector.size() - 1];
-			FirstDerivativeLengthFunction function;
+			FirstDerivativeLengthFunction function(Check(reCurve));
 			double simpson = Integrator::Simpson(function, (void*)&reCurve, start, end);
 			length = CalculateLengthBySimpson(function, reCurve, start, end, simpson, Constants::DistanceEpsilon);
 			break;
@@ -3372,101 +4879,233 @@ double LNLib::NurbsCurve::ApproximateLength(const LN_NurbsCurve& curve, Integrat
 			// Strongly recommend read this blog:
 			// https://raphlinus.github.io/curves/2018/12/28/bezier-arclength.html
 
-			std::vector<LN_NurbsCurve> bezierCurves =  DecomposeToBeziers(reCurve);
-			for (int i = 0; i < bezierCurves.size(); i++)
+			LN_DerivativeWorkspace workspace;
+			std::vector<double> uniqueKnots = knotVector;
+			uniqueKnots.erase(std::unique(uniqueKnots.begin(), uniqueKnots.end()), uniqueKnots.end());
+			std::vector<LN_NurbsCurve> bezierCurves = DecomposeToBeziers(reCurve);
+			for (int i = 0; i < uniqueKnots.size() - 1; i++)
 			{
-				LN_NurbsCurve bezierCurve = bezierCurves[i];
-
-				std::vector<double> bKnots = bezierCurve.KnotVector;
-				double a = bKnots[0];
-				double b = bKnots[bKnots.size() - 1];
-				double coefficient = (b - a) / 2.0;
-
-				double bLength = 0.0;
-				std::vector<double> abscissae = Integrator::GaussLegendreAbscissae;
-				int size = abscissae.size();
-				for (int i = 0; i < size; i++)
-				{
-					double t = coefficient * abscissae[i] + (a + b)/2.0;
-					double derLength = ComputeRationalCurveDerivatives(bezierCurve, 1, t)[1].Length();
-					if (std::isnan(derLength))
-						derLength = 0.0;
-					bLength += Integrator::GaussLegendreWeights[i] * derLength;
-				}
-				bLength = coefficient * bLength;
-				length += bLength;
+				length += GetBezierLengthByGaussLegendre(bezierCurves[i], workspace);
 			}
 			break;
 		}
 		case IntegratorType::Chebyshev:
 		{
 			std::vector<double> series = Integrator::ChebyshevSeries();
+			FirstDerivativeLengthFunction function(Check(reCurve));
 			for (int i = degree; i < controlPoints.size(); i++) 
 			{
 				double a = knotVector[i];
 				double b = knotVector[i + 1];
-				FirstDerivativeLengthFunction function;
 				length += Integrator::ClenshawCurtisQuadrature(function, (void*)&reCurve, a, b, series);
 			}
 			break;
 		}
+		case IntegratorType::GaussKronrod:
+		{
+			length = ApproximateLength(reCurve, Constants::DistanceEpsilon);
+			break;
+		}
 		default:
 			 break;
 	}
 	return length;
 }
 
-double LNLib::NurbsCurve::GetParamOnCurve(const LN_NurbsCurve& curve, double givenLength, IntegratorType type)
+double LNLib::NurbsCurve::ApproximateLength(const LN_NurbsCurve& curve, double tolerance, int maxEvaluations, double* error)
 {
-	std::vector<double> knotVector = curve.KnotVector;
-	double start = knotVector[0];
-	double end = knotVector[knotVector.size() - 1];
+	LNLIB_SCOPED_TIMER("NurbsCurve::ApproximateLength");
+	VALIDATE_ARGUMENT(tolerance > 0, "tolerance", "Tolerance must greater than zero.");
+	LN_CheckedNurbsCurve checkedCurve = Check(curve);
+
+	std::vector<double> uniqueKv = curve.KnotVector;
+	uniqueKv.erase(unique(uniqueKv.begin(), uniqueKv.end()), uniqueKv.end());
 
-	double totalLength = ApproximateLength(curve, type);
-	if (MathUtils::IsLessThan(totalLength, givenLength, Constants::DistanceEpsilon))
+	FirstDerivativeLengthFunction function(checkedCurve);
+	double estimate = 0.0;
+	int evaluations = 0;
+	double length = Integrator::GaussKronrod(function, (void*)&curve, uniqueKv, tolerance, maxEvaluations, estimate, evaluations);
+	if (error != nullptr)
 	{
-		return end;
+		*error = estimate;
 	}
+	return length;
+}
 
-	for (int i = 0; i < knotVector.size(); i++)
+double LNLib::NurbsCurve::ApproximateLength(const PreparedCurve& curve)
+{
+	if (curve.IsLinear())
+	{
+		const std::vector<double>& knotVector = curve.Curve().KnotVector;
+		return curve.GetPointOnCurve(knotVector[0]).Distance(curve.GetPointOnCurve(knotVector[knotVector.size() - 1]));
+	}
+	XYZ center;
+	XYZ normal;
+	double radius = 0.0;
+	double sweepAngle = 0.0;
+	if (curve.IsArc(center, normal, radius, sweepAngle))
+	{
+		return radius * sweepAngle;
+	}
+
+	LN_DerivativeWorkspace workspace;
+	const std::vector<LN_NurbsCurve>& bezierCurves = curve.GetBeziers();
+	double length = 0.0;
+	for (int i = 0; i < bezierCurves.size(); i++)
+	{
+		length += GetBezierLengthByGaussLegendre(bezierCurves[i], workspace);
+	}
+	return length;
+}
+
+std::vector<double> LNLib::NurbsCurve::ApproximateLength(const std::vector<LN_NurbsCurve>& curves, IntegratorType type, ParallelExecutor* executor)
+{
+	CurveLengthBatchFunction function(type, curves.size());
+	Parallel::ForEach(curves, function, executor);
+	return function.Lengths;
+}
+
+double LNLib::NurbsCurve::GetParamOnCurve(const LN_NurbsCurve& curve, double givenLength, IntegratorType type)
+{
+	LN_ArcLengthTable table;
+	CreateArcLengthTable(curve, table, type);
+	return GetParamOnCurve(table, givenLength);
+}
+
+std::vector<double> LNLib::NurbsCurve::GetParamsOnCurve(const LN_NurbsCurve& curve, double givenLength, IntegratorType type)
+{
+	LN_ArcLengthTable table;
+	CreateArcLengthTable(curve, table, type);
+	return GetParamsOnCurve(table, givenLength);
+}
+
+void LNLib::NurbsCurve::CreateArcLengthTable(const LN_NurbsCurve& curve, LN_ArcLengthTable& table, IntegratorType type, int intervals)
+{
+	LNLIB_SCOPED_TIMER("NurbsCurve::CreateArcLengthTable");
+	VALIDATE_ARGUMENT(intervals > 0, "intervals", "Intervals must greater than zero.");
+	LN_CheckedNurbsCurve checkedCurve = Check(curve);
+
+	std::vector<double> uniqueKv = curve.KnotVector;
+	uniqueKv.erase(unique(uniqueKv.begin(), uniqueKv.end()), uniqueKv.end());
+	int size = uniqueKv.size();
+
+	table.Params.clear();
+	table.Lengths.clear();
+	table.Params.emplace_back(uniqueKv[0]);
+	table.Lengths.emplace_back(0.0);
+
+	FirstDerivativeLengthFunction function(checkedCurve);
+	LN_DerivativeWorkspace workspace;
+	XYZ derivatives[2];
+	std::vector<double> series;
+	if (type == IntegratorType::Chebyshev)
 	{
-		LN_NurbsCurve left;
-		LN_NurbsCurve right;
-		double knot = knotVector[i];
-		bool isSplited = SplitAt(curve, knot, left, right);
-		if (!isSplited) continue;
-		double length = ApproximateLength(left, type);
-		if (MathUtils::IsAlmostEqualTo(length, givenLength))
+		series = Integrator::ChebyshevSeries();
+	}
+	for (int i = 0; i < size - 1; i++)
+	{
+		double step = (uniqueKv[i + 1] - uniqueKv[i]) / intervals;
+		for (int j = 0; j < intervals; j++)
 		{
-			return knot;
+			double a = uniqueKv[i] + step * j;
+			double b = j == intervals - 1 ? uniqueKv[i + 1] : a + step;
+
+			double length = 0.0;
+			switch (type)
+			{
+				case IntegratorType::Simpson:
+				{
+					double simpson = Integrator::Simpson(function, (void*)&curve, a, b);
+					length = CalculateLengthBySimpson(function, curve, a, b, simpson, Constants::DistanceEpsilon / (intervals * (size - 1)));
+					break;
+				}
+				case IntegratorType::Chebyshev:
+				{
+					length = Integrator::ClenshawCurtisQuadrature(function, (void*)&curve, a, b, series);
+					break;
+				}
+				case IntegratorType::GaussKronrod:
+				{
+					length = Integrator::GaussKronrod(function, (void*)&curve, a, b, Constants::DistanceEpsilon / (intervals * (size - 1)));
+					break;
+				}
+				default:
+				{
+					double coefficient = (b - a) / 2.0;
+					const std::vector<double>& abscissae = Integrator::GaussLegendreAbscissae;
+					for (int k = 0; k < abscissae.size(); k++)
+					{
+						double t = coefficient * abscissae[k] + (a + b) / 2.0;
+						ComputeRationalCurveDerivatives(checkedCurve, 1, t, workspace, derivatives);
+						double derLength = derivatives[1].Length();
+						if (std::isnan(derLength))
+							derLength = 0.0;
+						length += Integrator::GaussLegendreWeights[k] * derLength;
+					}
+					length = coefficient * length;
+					break;
+				}
+			}
+			table.Params.emplace_back(b);
+			table.Lengths.emplace_back(table.Lengths.back() + std::abs(length));
 		}
-		if (MathUtils::IsGreaterThan(length, givenLength))
+	}
+
+	int count = table.Params.size();
+	std::vector<double> secants(count - 1);
+	for (int i = 0; i < count - 1; i++)
+	{
+		double h = table.Lengths[i + 1] - table.Lengths[i];
+		secants[i] = MathUtils::IsAlmostEqualTo(h, 0.0) ? 0.0 : (table.Params[i + 1] - table.Params[i]) / h;
+	}
+
+	// Both ends of an interval are evaluated on the span of its start, so the slopes at a C0 knot are its one-sided limits.
+	table.Derivatives.resize(2 * (count - 1));
+	for (int i = 0; i < count - 1; i++)
+	{
+		int spanIndex = Polynomials::GetKnotSpanIndex(curve.Degree, curve.KnotVector, table.Params[i]);
+		for (int k = 0; k < 2; k++)
 		{
-			end = knot;
-			break;
+			ComputeSpanCurveDerivatives(curve, spanIndex, 1, table.Params[i + k], workspace, derivatives);
+			double speed = derivatives[1].Length();
+			double derivative = MathUtils::IsAlmostEqualTo(speed, 0.0) ? Constants::MaxDistance : 1.0 / speed;
+			table.Derivatives[2 * i + k] = std::min(derivative, 3 * secants[i]);
 		}
 	}
-	double param = GetParamByLength(curve, start, end, givenLength, type);
-	return param;
 }
 
-std::vector<double> LNLib::NurbsCurve::GetParamsOnCurve(const LN_NurbsCurve& curve, double givenLength, IntegratorType type)
+double LNLib::NurbsCurve::GetParamOnCurve(const LN_ArcLengthTable& table, double givenLength)
 {
-	std::vector<double> result;
+	VALIDATE_ARGUMENT(table.Params.size() > 1 && table.Params.size() == table.Lengths.size() && table.Derivatives.size() == 2 * (table.Params.size() - 1), "table", "Table must be created by CreateArcLengthTable.");
 
-	std::vector<double> knotVector = curve.KnotVector;
-	double end = knotVector[knotVector.size() - 1];
-	
-	double param = GetParamOnCurve(curve, givenLength, type);
-	while (!MathUtils::IsAlmostEqualTo(param, end))
+	if (givenLength <= 0.0)
+	{
+		return table.Params[0];
+	}
+	if (givenLength >= table.Lengths.back())
 	{
-		result.emplace_back(param);
+		return table.Params.back();
+	}
+	return InterpolateArcLength(table, FindArcLengthInterval(table, givenLength), givenLength);
+}
+
+std::vector<double> LNLib::NurbsCurve::GetParamsOnCurve(const LN_ArcLengthTable& table, double givenLength)
+{
+	VALIDATE_ARGUMENT(table.Params.size() > 1 && table.Params.size() == table.Lengths.size() && table.Derivatives.size() == 2 * (table.Params.size() - 1), "table", "Table must be created by CreateArcLengthTable.");
+	VALIDATE_ARGUMENT(givenLength > 0, "givenLength", "GivenLength must greater than zero.");
 
-		LN_NurbsCurve left;
-		LN_NurbsCurve right;
-		bool isSplited = SplitAt(curve, param, left, right);
-		if (!isSplited) continue;
-		param = GetParamOnCurve(right, givenLength, type);
+	std::vector<double> result;
+	double totalLength = table.Lengths.back();
+	int last = table.Lengths.size() - 1;
+	int index = 0;
+	for (int k = 1; MathUtils::IsLessThan(k * givenLength, totalLength, Constants::DistanceEpsilon); k++)
+	{
+		double length = k * givenLength;
+		while (index < last - 1 && table.Lengths[index + 1] <= length)
+		{
+			index++;
+		}
+		result.emplace_back(InterpolateArcLength(table, index, length));
 	}
 	return result;
 }
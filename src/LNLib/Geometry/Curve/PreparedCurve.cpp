@@ -0,0 +1,571 @@
+/*
+ * Author:
+ * 2024/10/14 - Yuqing Liang (BIMCoder Liang)
+ * bim.frankliang@foxmail.com
+ * 微信公众号：BIMCoder梁老师
+ *
+ * Use of this source code is governed by a GPL-3.0 license that can be found in
+ * the LICENSE file.
+ */
+
+#include "PreparedCurve.h"
+#include "NurbsCurve.h"
+#include "BsplineCurve.h"
+#include "Polynomials.h"
+#include "ControlPointsUtils.h"
+#include "XYZ.h"
+#include "XYZW.h"
+#include "Constants.h"
+#include "MathUtils.h"
+#include "LNLibExceptions.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace LNLib
+{
+	/// <summary>
+	/// Horner's rule on homogeneous coefficients, the four coordinates advance together.
+	/// </summary>
+	XYZW EvaluatePowerBasis(const std::vector<XYZW>& coefficients, double s)
+	{
+		int degree = coefficients.size() - 1;
+		const XYZW& last = coefficients[degree];
+		double wx = last[0];
+		double wy = last[1];
+		double wz = last[2];
+		double w = last[3];
+		for (int i = degree - 1; i >= 0; i--)
+		{
+			const XYZW& coefficient = coefficients[i];
+			wx = wx * s + coefficient[0];
+			wy = wy * s + coefficient[1];
+			wz = wz * s + coefficient[2];
+			w = w * s + coefficient[3];
+		}
+		return XYZW(wx, wy, wz, w);
+	}
+
+	/// <summary>
+	/// The NURBS Book 2nd Edition Page127
+	/// Equation (4.8), C derivatives from Cw derivatives. With unit weights the xyz part already is the result.
+	/// </summary>
+	void HodographsToDerivatives(const XYZW* ders, int derivative, bool isRational, XYZ* derivatives)
+	{
+		if (!isRational)
+		{
+			for (int k = 0; k <= derivative; k++)
+			{
+				derivatives[k] = ders[k].ToXYZ(false);
+			}
+			return;
+		}
+		for (int k = 0; k <= derivative; k++)
+		{
+			XYZ v = ders[k].ToXYZ(false);
+			for (int i = 1; i <= k; i++)
+			{
+				v = v - MathUtils::Binomial(k, i) * ders[i].GetW() * derivatives[k - i];
+			}
+			derivatives[k] = v / ders[0].GetW();
+		}
+	}
+
+	/// <summary>
+	/// The NURBS Book 2nd Edition Page144
+	/// Bezier points of span [u_spanIndex, u_spanIndex+1] as blossoms b_j = Cw(u_spanIndex (p-j times), u_spanIndex+1 (j times)),
+	/// each a de Boor triangle over the p+1 control points acting on the span.
+	/// </summary>
+	void ComputeSpanBezierPoints(int degree, const std::vector<double>& knotVector, const std::vector<XYZW>& controlPoints, int spanIndex, std::vector<XYZW>& bezierPoints)
+	{
+		std::vector<XYZW> temp(degree + 1);
+		bezierPoints.resize(degree + 1);
+		for (int j = 0; j <= degree; j++)
+		{
+			for (int i = 0; i <= degree; i++)
+			{
+				temp[i] = controlPoints[spanIndex - degree + i];
+			}
+			for (int r = 1; r <= degree; r++)
+			{
+				double t = r <= degree - j ? knotVector[spanIndex] : knotVector[spanIndex + 1];
+				for (int i = degree; i >= r; i--)
+				{
+					int k = spanIndex - degree + i;
+					double alpha = (t - knotVector[k]) / (knotVector[k + degree + 1 - r] - knotVector[k]);
+					temp[i] = (1.0 - alpha) * temp[i - 1] + alpha * temp[i];
+				}
+			}
+			bezierPoints[j] = temp[degree];
+		}
+	}
+
+	const int MaxCurveLevelsOfDetail = 8;
+
+	/// <summary>
+	/// Distance from point to the segment [start, end].
+	/// </summary>
+	double GetDistanceToChord(const XYZ& point, const XYZ& start, const XYZ& end)
+	{
+		XYZ chord = end - start;
+		double sqrLength = chord.SqrLength();
+		double t = sqrLength > 0.0 ? std::max(0.0, std::min(1.0, (point - start).DotProduct(chord) / sqrLength)) : 0.0;
+		return point.Distance(start + t * chord);
+	}
+
+	/// <summary>
+	/// The NURBS Book 2nd Edition Page24
+	/// de Casteljau subdivision at s = 1/2, first receives the Bezier points of [0, 1/2] and points are replaced by those of [1/2, 1].
+	/// </summary>
+	void SplitBezierInHalf(std::vector<XYZW>& points, std::vector<XYZW>& first)
+	{
+		int degree = points.size() - 1;
+		first.resize(degree + 1);
+		first[0] = points[0];
+		for (int r = 1; r <= degree; r++)
+		{
+			for (int i = 0; i <= degree - r; i++)
+			{
+				points[i] = 0.5 * (points[i] + points[i + 1]);
+			}
+			first[r] = points[0];
+		}
+	}
+}
+
+LNLib::PreparedCurve::PreparedCurve(const LN_NurbsCurve& curve)
+	: _curve(curve), _checked(NurbsCurve::Check(_curve)), _isLevelsComplete(false), _isPowerBasisReady(false), _isClosed(false), _isLinear(false), _isArc(false), _arcRadius(0.0), _arcSweepAngle(0.0)
+{
+	_spanKnots = _curve.KnotVector;
+	_spanKnots.erase(std::unique(_spanKnots.begin(), _spanKnots.end()), _spanKnots.end());
+}
+
+LNLib::PreparedCurve::PreparedCurve(const PreparedCurve& previous, const LN_NurbsCurve& curve, const LN_DirtyRange& dirty)
+	: _curve(curve), _checked(NurbsCurve::Check(_curve)), _spanKnots(previous._spanKnots), _isLevelsComplete(false), _isPowerBasisReady(false), _isClosed(false), _isLinear(false), _isArc(false), _arcRadius(0.0), _arcSweepAngle(0.0)
+{
+	VALIDATE_ARGUMENT(_curve.Degree == previous._curve.Degree && _curve.KnotVector == previous._curve.KnotVector, "curve", "Curve must keep the degree and knot vector of previous.");
+	VALIDATE_ARGUMENT_RANGE(dirty.FirstSpan, 0, static_cast<int>(_spanKnots.size()) - 2);
+	VALIDATE_ARGUMENT_RANGE(dirty.LastSpan, dirty.FirstSpan, static_cast<int>(_spanKnots.size()) - 2);
+
+	UpdateSpans(previous, dirty);
+}
+
+const LNLib::LN_NurbsCurve& LNLib::PreparedCurve::Curve() const
+{
+	return _curve;
+}
+
+const LNLib::LN_CheckedNurbsCurve& LNLib::PreparedCurve::Checked() const
+{
+	return _checked;
+}
+
+const std::vector<double>& LNLib::PreparedCurve::GetSpanKnots() const
+{
+	return _spanKnots;
+}
+
+const std::vector<LNLib::LN_NurbsCurve>& LNLib::PreparedCurve::GetBeziers() const
+{
+	std::call_once(_beziersFlag, &PreparedCurve::ComputeBeziers, this);
+	return _beziers;
+}
+
+const std::vector<LNLib::LN_BoundingBox>& LNLib::PreparedCurve::GetSpanBoundingBoxes() const
+{
+	std::call_once(_boxesFlag, &PreparedCurve::ComputeSpanBoundingBoxes, this);
+	return _boxes;
+}
+
+const std::vector<std::vector<LNLib::XYZW>>& LNLib::PreparedCurve::GetPowerBasisCoefficients() const
+{
+	// Point evaluation reads this on every call, skip std::call_once once the coefficients exist.
+	if (!_isPowerBasisReady.load(std::memory_order_acquire))
+	{
+		std::call_once(_powerBasisFlag, &PreparedCurve::ComputePowerBasisCoefficients, this);
+	}
+	return _powerBasis;
+}
+
+bool LNLib::PreparedCurve::IsClosed() const
+{
+	std::call_once(_closedFlag, &PreparedCurve::ComputeIsClosed, this);
+	return _isClosed;
+}
+
+bool LNLib::PreparedCurve::IsLinear() const
+{
+	std::call_once(_classificationFlag, &PreparedCurve::ComputeClassification, this);
+	return _isLinear;
+}
+
+bool LNLib::PreparedCurve::IsArc() const
+{
+	std::call_once(_classificationFlag, &PreparedCurve::ComputeClassification, this);
+	return _isArc;
+}
+
+bool LNLib::PreparedCurve::IsArc(XYZ& center, XYZ& normal, double& radius, double& sweepAngle) const
+{
+	std::call_once(_classificationFlag, &PreparedCurve::ComputeClassification, this);
+	if (_isArc)
+	{
+		center = _arcCenter;
+		normal = _arcNormal;
+		radius = _arcRadius;
+		sweepAngle = _arcSweepAngle;
+	}
+	return _isArc;
+}
+
+const std::vector<LNLib::LN_BsplineCurve<LNLib::XYZW>>& LNLib::PreparedCurve::GetHodographs() const
+{
+	std::call_once(_hodographsFlag, &PreparedCurve::ComputeHodographs, this);
+	return _hodographs;
+}
+
+void LNLib::PreparedCurve::ComputeBeziers() const
+{
+	_beziers = NurbsCurve::DecomposeToBeziers(_curve);
+	_beziers.resize(_spanKnots.size() - 1);
+}
+
+void LNLib::PreparedCurve::ComputeSpanBoundingBoxes() const
+{
+	const std::vector<LN_NurbsCurve>& beziers = GetBeziers();
+	_boxes.resize(beziers.size());
+	for (int i = 0; i < beziers.size(); i++)
+	{
+		_boxes[i] = ControlPointsUtils::ComputeBoundingBox(beziers[i].ControlPoints);
+	}
+}
+
+void LNLib::PreparedCurve::ComputePowerBasisCoefficients() const
+{
+	const std::vector<LN_NurbsCurve>& beziers = GetBeziers();
+	int degree = _curve.Degree;
+	std::vector<std::vector<double>> matrix = Polynomials::BezierToPowerMatrix(degree);
+
+	_powerBasis.resize(beziers.size());
+	for (int s = 0; s < beziers.size(); s++)
+	{
+		const std::vector<XYZW>& controlPoints = beziers[s].ControlPoints;
+		std::vector<XYZW>& coefficients = _powerBasis[s];
+		coefficients.resize(degree + 1);
+		for (int i = 0; i <= degree; i++)
+		{
+			XYZW coefficient = XYZW(0, 0, 0, 0);
+			for (int j = 0; j <= i; j++)
+			{
+				coefficient += matrix[i][j] * controlPoints[j];
+			}
+			coefficients[i] = coefficient;
+		}
+	}
+	_isPowerBasisReady.store(true, std::memory_order_release);
+}
+
+void LNLib::PreparedCurve::UpdateSpans(const PreparedCurve& previous, const LN_DirtyRange& dirty) const
+{
+	int degree = _curve.Degree;
+	const std::vector<double>& knotVector = _curve.KnotVector;
+	bool hasPowerBasis = degree <= Constants::MaxPowerBasisDegree;
+
+	_beziers = previous.GetBeziers();
+	_boxes = previous.GetSpanBoundingBoxes();
+	if (hasPowerBasis)
+	{
+		_powerBasis = previous.GetPowerBasisCoefficients();
+	}
+
+	std::vector<std::vector<double>> matrix;
+	if (hasPowerBasis)
+	{
+		matrix = Polynomials::BezierToPowerMatrix(degree);
+	}
+	for (int s = dirty.FirstSpan; s <= dirty.LastSpan; s++)
+	{
+		int spanIndex = std::upper_bound(knotVector.begin(), knotVector.end(), _spanKnots[s]) - knotVector.begin() - 1;
+		std::vector<XYZW>& controlPoints = _beziers[s].ControlPoints;
+		ComputeSpanBezierPoints(degree, knotVector, _curve.ControlPoints, spanIndex, controlPoints);
+		_boxes[s] = ControlPointsUtils::ComputeBoundingBox(controlPoints);
+		if (!hasPowerBasis)
+		{
+			continue;
+		}
+		std::vector<XYZW>& coefficients = _powerBasis[s];
+		for (int i = 0; i <= degree; i++)
+		{
+			XYZW coefficient = XYZW(0, 0, 0, 0);
+			for (int j = 0; j <= i; j++)
+			{
+				coefficient += matrix[i][j] * controlPoints[j];
+			}
+			coefficients[i] = coefficient;
+		}
+	}
+
+	std::call_once(_beziersFlag, &PreparedCurve::MarkComputed, this);
+	std::call_once(_boxesFlag, &PreparedCurve::MarkComputed, this);
+	if (hasPowerBasis)
+	{
+		std::call_once(_powerBasisFlag, &PreparedCurve::MarkComputed, this);
+		_isPowerBasisReady.store(true, std::memory_order_release);
+	}
+}
+
+void LNLib::PreparedCurve::MarkComputed() const
+{
+}
+
+void LNLib::PreparedCurve::ComputeIsClosed() const
+{
+	_isClosed = NurbsCurve::IsClosed(_curve);
+}
+
+void LNLib::PreparedCurve::ComputeClassification() const
+{
+	_isLinear = NurbsCurve::IsLinear(_curve);
+	_isArc = !_isLinear && NurbsCurve::IsArc(_curve, _arcCenter, _arcNormal, _arcRadius, _arcSweepAngle);
+}
+
+void LNLib::PreparedCurve::ComputeHodographs() const
+{
+	int degree = _curve.Degree;
+	const std::vector<double>& knotVector = _curve.KnotVector;
+	int n = _curve.ControlPoints.size() - 1;
+
+	LN_BsplineCurve<XYZW> curve;
+	curve.Degree = degree;
+	curve.KnotVector = knotVector;
+	curve.ControlPoints = _curve.ControlPoints;
+	std::vector<std::vector<XYZW>> PK = BsplineCurve::ComputeControlPointsOfDerivatives(curve, degree, 0, n);
+
+	_hodographs.resize(degree + 1);
+	for (int k = 0; k <= degree; k++)
+	{
+		LN_BsplineCurve<XYZW>& hodograph = _hodographs[k];
+		hodograph.Degree = degree - k;
+		hodograph.KnotVector.assign(knotVector.begin() + k, knotVector.end() - k);
+		hodograph.ControlPoints.assign(PK[k].begin(), PK[k].begin() + n - k + 1);
+	}
+}
+
+LNLib::XYZ LNLib::PreparedCurve::GetPointOnCurve(double paramT) const
+{
+	VALIDATE_ARGUMENT_RANGE(paramT, _spanKnots[0], _spanKnots[_spanKnots.size() - 1]);
+
+	if (_curve.Degree > Constants::MaxPowerBasisDegree)
+	{
+		return NurbsCurve::GetPointOnCurve(_checked, paramT);
+	}
+
+	const std::vector<std::vector<XYZW>>& powerBasis = GetPowerBasisCoefficients();
+	int segment = FindSegment(paramT);
+	double s = (paramT - _spanKnots[segment]) / (_spanKnots[segment + 1] - _spanKnots[segment]);
+	return EvaluatePowerBasis(powerBasis[segment], s).ToXYZ(true);
+}
+
+void LNLib::PreparedCurve::GetPointsOnCurve(const double* params, int count, XYZ* points) const
+{
+	double first = _spanKnots[0];
+	double last = _spanKnots[_spanKnots.size() - 1];
+	for (int i = 0; i < count; i++)
+	{
+		VALIDATE_ARGUMENT_RANGE(params[i], first, last);
+	}
+
+	if (_curve.Degree > Constants::MaxPowerBasisDegree)
+	{
+		NurbsCurve::GetPointsOnCurve(_checked, params, count, points);
+		return;
+	}
+
+	const std::vector<std::vector<XYZW>>& powerBasis = GetPowerBasisCoefficients();
+	int lastSegment = _spanKnots.size() - 2;
+	int segment = 0;
+	for (int i = 0; i < count; i++)
+	{
+		double paramT = params[i];
+		if (paramT < _spanKnots[segment] || (paramT >= _spanKnots[segment + 1] && segment < lastSegment))
+		{
+			segment = FindSegment(paramT);
+		}
+		double s = (paramT - _spanKnots[segment]) / (_spanKnots[segment + 1] - _spanKnots[segment]);
+		points[i] = EvaluatePowerBasis(powerBasis[segment], s).ToXYZ(true);
+	}
+}
+
+int LNLib::PreparedCurve::FindSegment(double paramT) const
+{
+	int index = std::upper_bound(_spanKnots.begin(), _spanKnots.end(), paramT) - _spanKnots.begin() - 1;
+	return std::max(0, std::min(static_cast<int>(_spanKnots.size()) - 2, index));
+}
+
+std::vector<LNLib::XYZ> LNLib::PreparedCurve::ComputeDerivatives(int derivative, double paramT) const
+{
+	std::vector<XYZ> derivatives(derivative + 1);
+	ComputeDerivatives(derivative, &paramT, 1, derivatives.data());
+	return derivatives;
+}
+
+void LNLib::PreparedCurve::ComputeDerivatives(int derivative, const double* params, int count, XYZ* derivatives) const
+{
+	VALIDATE_ARGUMENT(derivative > 0, "derivative", "derivative must greater than zero.");
+	double first = _spanKnots[0];
+	double last = _spanKnots[_spanKnots.size() - 1];
+	for (int i = 0; i < count; i++)
+	{
+		VALIDATE_ARGUMENT_RANGE(params[i], first, last);
+	}
+
+	const std::vector<LN_BsplineCurve<XYZW>>& hodographs = GetHodographs();
+	int degree = _curve.Degree;
+	int du = std::min(derivative, degree);
+	bool isRational = _checked.IsRational();
+
+	// Hodograph k has knots u_k..u_m-k, so its span is the span of Cw shifted by k and one cursor serves every order.
+	double stackN[Constants::MaxStackBasisSize];
+	XYZW stackDers[Constants::MaxStackBasisSize];
+	std::vector<double> heapN;
+	std::vector<XYZW> heapDers;
+	double* N = stackN;
+	XYZW* ders = stackDers;
+	if (degree >= Constants::MaxStackBasisSize)
+	{
+		heapN.resize(degree + 1);
+		N = heapN.data();
+	}
+	if (derivative >= Constants::MaxStackBasisSize)
+	{
+		heapDers.resize(derivative + 1);
+		ders = heapDers.data();
+	}
+
+	KnotSpanCursor cursor(degree, _curve.KnotVector);
+	for (int i = 0; i < count; i++)
+	{
+		double paramT = params[i];
+		int curveSpanIndex = cursor.Find(paramT);
+		for (int k = 0; k <= du; k++)
+		{
+			const LN_BsplineCurve<XYZW>& hodograph = hodographs[k];
+			int p = hodograph.Degree;
+			int spanIndex = curveSpanIndex - k;
+			Polynomials::BasisFunctions(spanIndex, p, hodograph.KnotVector, paramT, N);
+
+			const XYZW* points = &hodograph.ControlPoints[spanIndex - p];
+			double wx = 0.0;
+			double wy = 0.0;
+			double wz = 0.0;
+			double w = 0.0;
+			for (int j = 0; j <= p; j++)
+			{
+				wx += N[j] * points[j].GetWX();
+				wy += N[j] * points[j].GetWY();
+				wz += N[j] * points[j].GetWZ();
+				w += N[j] * points[j].GetW();
+			}
+			ders[k] = XYZW(wx, wy, wz, w);
+		}
+		HodographsToDerivatives(ders, derivative, isRational, derivatives + i * (derivative + 1));
+	}
+}
+
+const std::vector<LNLib::LN_CurveLevelOfDetail>& LNLib::PreparedCurve::GetLevelsOfDetail() const
+{
+	std::lock_guard<std::mutex> lock(_levelsMutex);
+	while (!_isLevelsComplete)
+	{
+		ComputeNextLevelOfDetail();
+	}
+	return _levels;
+}
+
+const LNLib::LN_CurveLevelOfDetail& LNLib::PreparedCurve::GetLevelOfDetail(double maxError) const
+{
+	VALIDATE_ARGUMENT(maxError >= 0, "maxError", "MaxError must not be negative.");
+
+	std::lock_guard<std::mutex> lock(_levelsMutex);
+	for (int k = 0; ; k++)
+	{
+		if (k == _levels.size())
+		{
+			if (_isLevelsComplete)
+			{
+				return _levels[k - 1];
+			}
+			ComputeNextLevelOfDetail();
+		}
+		if (_levels[k].Error <= maxError)
+		{
+			return _levels[k];
+		}
+	}
+}
+
+void LNLib::PreparedCurve::ComputeNextLevelOfDetail() const
+{
+	const std::vector<LN_NurbsCurve>& beziers = GetBeziers();
+	int spans = beziers.size();
+	int degree = _curve.Degree;
+
+	// Pieces of span s are pieces[s * count] to pieces[s * count + count - 1], halving piece i gives pieces 2i and 2i + 1 of the next level.
+	std::vector<std::vector<XYZW>>& pieces = _levelPieces;
+	if (_levels.empty())
+	{
+		// Capacity for every level keeps references returned by GetLevelOfDetail valid while levels are added.
+		_levels.reserve(MaxCurveLevelsOfDetail);
+		pieces.resize(spans);
+		for (int s = 0; s < spans; s++)
+		{
+			pieces[s] = beziers[s].ControlPoints;
+		}
+	}
+	else
+	{
+		std::vector<std::vector<XYZW>> halves(2 * pieces.size());
+		for (int i = 0; i < pieces.size(); i++)
+		{
+			SplitBezierInHalf(pieces[i], halves[2 * i]);
+			halves[2 * i + 1].swap(pieces[i]);
+		}
+		pieces.swap(halves);
+	}
+	int count = pieces.size() / spans;
+	std::vector<XYZ> projected(degree + 1);
+
+	LN_CurveLevelOfDetail lod;
+	lod.Error = 0.0;
+	lod.Points.reserve(spans * count + 1);
+	lod.Knots.reserve(spans * count + 1);
+	for (int s = 0; s < spans; s++)
+	{
+		double start = _spanKnots[s];
+		double length = _spanKnots[s + 1] - start;
+		for (int t = 0; t < count; t++)
+		{
+			const std::vector<XYZW>& piece = pieces[s * count + t];
+			for (int i = 0; i <= degree; i++)
+			{
+				projected[i] = piece[i].ToXYZ(true);
+			}
+			// Positive weights keep the piece in the convex hull of its points, the distance to the chord is convex.
+			for (int i = 1; i < degree; i++)
+			{
+				lod.Error = std::max(lod.Error, GetDistanceToChord(projected[i], projected[0], projected[degree]));
+			}
+			lod.Points.emplace_back(projected[0]);
+			lod.Knots.emplace_back(start + length * t / count);
+		}
+	}
+	lod.Points.emplace_back(pieces[spans * count - 1][degree].ToXYZ(true));
+	lod.Knots.emplace_back(_spanKnots[spans]);
+	_levels.emplace_back(std::move(lod));
+
+	if (_levels.back().Error <= Constants::DistanceEpsilon || _levels.size() == MaxCurveLevelsOfDetail)
+	{
+		_isLevelsComplete = true;
+		std::vector<std::vector<XYZW>>().swap(pieces);
+	}
+}
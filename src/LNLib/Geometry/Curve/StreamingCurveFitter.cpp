@@ -0,0 +1,334 @@
+/*
+ * Author:
+ * 2024/10/14 - Yuqing Liang (BIMCoder Liang)
+ * bim.frankliang@foxmail.com
+ * 微信公众号：BIMCoder梁老师
+ *
+ * Use of this source code is governed by a GPL-3.0 license that can be found in
+ * the LICENSE file.
+ */
+
+#include "StreamingCurveFitter.h"
+#include "NurbsCurve.h"
+#include "MathUtils.h"
+#include "XYZW.h"
+#include "LNLibExceptions.h"
+#include <algorithm>
+
+namespace LNLib
+{
+	/// <summary>
+	/// coefficients[i][a] is the coefficient of t^a in Bernstein polynomial B(i,degree)(t).
+	/// </summary>
+	std::vector<std::vector<double>> GetBernsteinPowerCoefficients(int degree)
+	{
+		std::vector<std::vector<double>> coefficients(degree + 1, std::vector<double>(degree + 1, 0.0));
+		for (int i = 0; i <= degree; i++)
+		{
+			for (int a = i; a <= degree; a++)
+			{
+				double sign = (a - i) % 2 == 0 ? 1.0 : -1.0;
+				coefficients[i][a] = sign * MathUtils::Binomial(degree, i) * MathUtils::Binomial(degree - i, a - i);
+			}
+		}
+		return coefficients;
+	}
+
+	/// <summary>
+	/// Point, first and second derivative of a Bezier curve at t by de Casteljau.
+	/// </summary>
+	XYZ GetStreamingBezierDerivatives(const std::vector<XYZ>& controlPoints, double t, XYZ& first, XYZ& second)
+	{
+		int degree = controlPoints.size() - 1;
+		std::vector<XYZ> temp = controlPoints;
+		first = XYZ(0, 0, 0);
+		second = XYZ(0, 0, 0);
+		for (int k = 1; k <= degree; k++)
+		{
+			if (k == degree - 1)
+			{
+				second = degree * (degree - 1) * (temp[2] - 2.0 * temp[1] + temp[0]);
+			}
+			if (k == degree)
+			{
+				first = degree * (temp[1] - temp[0]);
+			}
+			for (int i = 0; i <= degree - k; i++)
+			{
+				temp[i] = (1.0 - t) * temp[i] + t * temp[i + 1];
+			}
+		}
+		return temp[0];
+	}
+}
+
+LNLib::StreamingCurveFitter::StreamingCurveFitter(int degree, double maxError, int continuity, int maxWindowPoints)
+	: _degree(degree), _maxError(maxError), _continuity(continuity), _maxWindowPoints(maxWindowPoints),
+	_isStarted(false), _hasPrevious(false), _startParam(0.0), _length(0.0),
+	_powerSums(2 * degree + 1, 0.0), _momentSums(degree + 1)
+{
+	VALIDATE_ARGUMENT(degree > 0, "degree", "Degree must greater than zero.");
+	VALIDATE_ARGUMENT(MathUtils::IsGreaterThan(maxError, 0.0), "maxError", "MaxError must greater than zero.");
+	VALIDATE_ARGUMENT_RANGE(continuity, 0, 2);
+	VALIDATE_ARGUMENT(continuity < degree, "continuity", "Continuity must less than degree.");
+	VALIDATE_ARGUMENT(maxWindowPoints > degree, "maxWindowPoints", "MaxWindowPoints must greater than degree.");
+}
+
+void LNLib::StreamingCurveFitter::AddPoint(const XYZ& point)
+{
+	if (!_isStarted)
+	{
+		_isStarted = true;
+		_start = point;
+		_last = point;
+		return;
+	}
+
+	double step = point.Distance(_last);
+	if (MathUtils::IsAlmostEqualTo(step, 0.0))
+	{
+		return;
+	}
+	double length = _length + step;
+
+	std::vector<double> powerSums = _powerSums;
+	std::vector<XYZ> momentSums = _momentSums;
+	Accumulate(length, point, powerSums, momentSums);
+	_points.emplace_back(point);
+	_params.emplace_back(length);
+
+	int count = _points.size();
+	int continuity = _hasPrevious ? _continuity : 0;
+	// Fewer points than free control points leave the fit undetermined, nothing to check yet.
+	bool isAccepted = count < _degree - continuity;
+	if (!isAccepted && count <= _maxWindowPoints)
+	{
+		std::vector<XYZ> controlPoints = Fit(_degree, length, powerSums, momentSums);
+		isAccepted = MathUtils::IsLessThanOrEqual(GetMaxError(controlPoints, length), _maxError);
+	}
+	if (isAccepted)
+	{
+		_powerSums.swap(powerSums);
+		_momentSums.swap(momentSums);
+		_length = length;
+		_last = point;
+		return;
+	}
+
+	_points.pop_back();
+	_params.pop_back();
+	if (_points.empty())
+	{
+		// The only free control point can not follow the joint, keep this fit to move on.
+		_points.emplace_back(point);
+		_params.emplace_back(length);
+		Emit(Fit(_degree, length, powerSums, momentSums), length);
+		return;
+	}
+
+	count = _points.size();
+	int degree = std::min(_degree, continuity + count);
+	std::vector<XYZ> controlPoints = Fit(degree, _length, _powerSums, _momentSums);
+	if (degree < _degree)
+	{
+		Emit(controlPoints, _length);
+		AddPoint(point);
+		return;
+	}
+
+	// The end of a least squares fit is least reliable, only the part up to two thirds of the window is finalized
+	// so the next joint takes its derivatives from inside the fit. The rest of the window is fitted again.
+	int consumed = std::max(1, 2 * count / 3);
+	double splitLength = _params[consumed - 1];
+	std::vector<XYZ> left(degree + 1);
+	std::vector<XYZ> temp = controlPoints;
+	double t = splitLength / _length;
+	left[0] = temp[0];
+	for (int k = 1; k <= degree; k++)
+	{
+		for (int i = 0; i <= degree - k; i++)
+		{
+			temp[i] = (1.0 - t) * temp[i] + t * temp[i + 1];
+		}
+		left[k] = temp[0];
+	}
+	std::vector<XYZ> pending(_points.begin() + consumed, _points.end());
+	Emit(left, splitLength);
+	for (int i = 0; i < static_cast<int>(pending.size()); i++)
+	{
+		AddPoint(pending[i]);
+	}
+	AddPoint(point);
+}
+
+void LNLib::StreamingCurveFitter::AddPoints(const std::vector<XYZ>& points)
+{
+	for (int i = 0; i < static_cast<int>(points.size()); i++)
+	{
+		AddPoint(points[i]);
+	}
+}
+
+void LNLib::StreamingCurveFitter::Finish()
+{
+	if (_points.empty())
+	{
+		return;
+	}
+	int continuity = _hasPrevious ? _continuity : 0;
+	int degree = std::min(_degree, continuity + (int)_points.size());
+	Emit(Fit(degree, _length, _powerSums, _momentSums), _length);
+}
+
+std::vector<LNLib::LN_NurbsCurve> LNLib::StreamingCurveFitter::TakeSegments()
+{
+	std::vector<LN_NurbsCurve> segments;
+	segments.swap(_segments);
+	return segments;
+}
+
+int LNLib::StreamingCurveFitter::GetWindowSize() const
+{
+	return _points.size();
+}
+
+void LNLib::StreamingCurveFitter::Accumulate(double length, const XYZ& point, std::vector<double>& powerSums, std::vector<XYZ>& momentSums) const
+{
+	double power = 1.0;
+	for (int a = 0; a < static_cast<int>(powerSums.size()); a++)
+	{
+		powerSums[a] += power;
+		if (a < static_cast<int>(momentSums.size()))
+		{
+			momentSums[a] += power * point;
+		}
+		power *= length;
+	}
+}
+
+std::vector<LNLib::XYZ> LNLib::StreamingCurveFitter::Fit(int degree, double length, const std::vector<double>& powerSums, const std::vector<XYZ>& momentSums) const
+{
+	int continuity = _hasPrevious ? std::min(_continuity, degree - 1) : 0;
+	std::vector<XYZ> controlPoints(degree + 1);
+	controlPoints[0] = _start;
+	if (continuity >= 1)
+	{
+		controlPoints[1] = _start + (length / degree) * _firstDerivative;
+	}
+	if (continuity >= 2)
+	{
+		controlPoints[2] = 2.0 * controlPoints[1] - _start + (length * length / (degree * (degree - 1))) * _secondDerivative;
+	}
+
+	// Moments of t = s / length from the running moments of s.
+	std::vector<double> scales(2 * degree + 1);
+	std::vector<double> scaledPowerSums(2 * degree + 1);
+	double scale = 1.0;
+	for (int a = 0; a <= 2 * degree; a++)
+	{
+		scales[a] = scale;
+		scaledPowerSums[a] = powerSums[a] * scale;
+		scale /= length;
+	}
+	std::vector<std::vector<double>> coefficients = GetBernsteinPowerCoefficients(degree);
+
+	int free = degree - continuity;
+	std::vector<std::vector<double>> normal(free, std::vector<double>(free, 0.0));
+	std::vector<std::vector<double>> right(free, std::vector<double>(3, 0.0));
+	for (int r = 0; r < free; r++)
+	{
+		int i = continuity + 1 + r;
+		XYZ rhs(0, 0, 0);
+		for (int a = i; a <= degree; a++)
+		{
+			rhs += (coefficients[i][a] * scales[a]) * momentSums[a];
+		}
+		for (int j = 0; j <= degree; j++)
+		{
+			double gram = 0.0;
+			for (int a = i; a <= degree; a++)
+			{
+				for (int b = j; b <= degree; b++)
+				{
+					gram += coefficients[i][a] * coefficients[j][b] * scaledPowerSums[a + b];
+				}
+			}
+			if (j > continuity)
+			{
+				normal[r][j - continuity - 1] = gram;
+			}
+			else
+			{
+				rhs -= gram * controlPoints[j];
+			}
+		}
+		for (int c = 0; c < 3; c++)
+		{
+			right[r][c] = rhs[c];
+		}
+	}
+
+	std::vector<std::vector<double>> solved = MathUtils::SolveLinearSystem(normal, right);
+	for (int r = 0; r < free; r++)
+	{
+		controlPoints[continuity + 1 + r] = XYZ(solved[r][0], solved[r][1], solved[r][2]);
+	}
+	return controlPoints;
+}
+
+double LNLib::StreamingCurveFitter::GetMaxError(const std::vector<XYZ>& controlPoints, double length) const
+{
+	double maxError = 0.0;
+	for (int i = 0; i < static_cast<int>(_points.size()); i++)
+	{
+		// Chord length is only an estimate of the parameter, a few Newton steps find the foot point.
+		const XYZ& point = _points[i];
+		double t = std::min(1.0, _params[i] / length);
+		XYZ first;
+		XYZ second;
+		XYZ current = GetStreamingBezierDerivatives(controlPoints, t, first, second);
+		for (int k = 0; k < 3; k++)
+		{
+			XYZ difference = current - point;
+			double denominator = second.DotProduct(difference) + first.DotProduct(first);
+			if (MathUtils::IsAlmostEqualTo(denominator, 0.0)) break;
+			t = std::max(0.0, std::min(1.0, t - first.DotProduct(difference) / denominator));
+			current = GetStreamingBezierDerivatives(controlPoints, t, first, second);
+		}
+		maxError = std::max(maxError, current.Distance(point));
+	}
+	return maxError;
+}
+
+void LNLib::StreamingCurveFitter::Emit(const std::vector<XYZ>& controlPoints, double length)
+{
+	int degree = controlPoints.size() - 1;
+	LN_NurbsCurve segment;
+	segment.Degree = degree;
+	segment.KnotVector.assign(degree + 1, _startParam);
+	segment.KnotVector.insert(segment.KnotVector.end(), degree + 1, _startParam + length);
+	segment.ControlPoints.reserve(degree + 1);
+	for (int i = 0; i <= degree; i++)
+	{
+		segment.ControlPoints.emplace_back(XYZW(controlPoints[i], 1.0));
+	}
+	if (degree < _degree)
+	{
+		segment = NurbsCurve::ElevateDegree(segment, _degree - degree);
+	}
+	_segments.emplace_back(std::move(segment));
+
+	const XYZ& end = controlPoints[degree];
+	_firstDerivative = (degree / length) * (end - controlPoints[degree - 1]);
+	_secondDerivative = degree >= 2 ? (degree * (degree - 1) / (length * length)) * (end - 2.0 * controlPoints[degree - 1] + controlPoints[degree - 2]) : XYZ(0, 0, 0);
+	_hasPrevious = true;
+
+	_start = end;
+	_last = end;
+	_startParam += length;
+	_length = 0.0;
+	_points.clear();
+	_params.clear();
+	std::fill(_powerSums.begin(), _powerSums.end(), 0.0);
+	std::fill(_momentSums.begin(), _momentSums.end(), XYZ(0, 0, 0));
+}
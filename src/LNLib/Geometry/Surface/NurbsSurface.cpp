@@ -9,6 +9,7 @@
  */
 
 #include "NurbsSurface.h"
+#include "Constants.h"
 #include "Polynomials.h"
 #include "UV.h"
 #include "XYZ.h"
@@ -24,12 +25,743 @@
 #include "KnotVectorUtils.h"
 #include "ControlPointsUtils.h"
 #include "Integrator.h"
+#include "Parallel.h"
+#include "Instrumentation.h"
+#include "MonotonicArena.h"
+#include "Cancellation.h"
+#include "TrimLoopClassifier.h"
 #include "LNLibExceptions.h"
 #include "LNObject.h"
 #include <algorithm>
+#include <map>
 
 namespace LNLib
 {
+	/// <summary>
+	/// Control point index of the iso row of the net, rows of the U direction are columns of the net so they are read with stride.
+	/// </summary>
+	const XYZW& GetIsoRowPoint(const std::vector<std::vector<XYZW>>& controlPoints, bool isUDirection, int row, int index)
+	{
+		return isUDirection ? controlPoints[index][row] : controlPoints[row][index];
+	}
+
+	XYZ EvaluateIsoRow(const std::vector<std::vector<XYZW>>& controlPoints, bool isUDirection, int row, int spanIndex, const std::vector<double>& basis)
+	{
+		int degree = basis.size() - 1;
+		XYZW point = XYZW(0, 0, 0, 0);
+		for (int k = 0; k <= degree; k++)
+		{
+			point += basis[k] * GetIsoRowPoint(controlPoints, isUDirection, row, spanIndex - degree + k);
+		}
+		return point.ToXYZ(true);
+	}
+
+	/// <summary>
+	/// Same test as NurbsCurve::IsClosed on one iso row, the basis functions at both ends are shared by all rows.
+	/// </summary>
+	bool IsIsoRowClosed(const std::vector<std::vector<XYZW>>& controlPoints, bool isUDirection, int row, int n, int startSpan, const std::vector<double>& startBasis, int endSpan, const std::vector<double>& endBasis)
+	{
+		XYZ startPoint = EvaluateIsoRow(controlPoints, isUDirection, row, startSpan, startBasis);
+		XYZ endPoint = EvaluateIsoRow(controlPoints, isUDirection, row, endSpan, endBasis);
+		if (MathUtils::IsAlmostEqualTo(startPoint.Distance(endPoint), 0.0))
+		{
+			return true;
+		}
+
+		XYZ last = GetIsoRowPoint(controlPoints, isUDirection, row, n).ToXYZ(true);
+		int index = -1;
+		for (int i = 0; i < n; i++)
+		{
+			if (last.IsAlmostEqualTo(GetIsoRowPoint(controlPoints, isUDirection, row, i).ToXYZ(true)))
+			{
+				index = i;
+				break;
+			}
+		}
+		if (index < 0) return false;
+		for (int i = index; i >= 0; i--)
+		{
+			XYZ current = GetIsoRowPoint(controlPoints, isUDirection, row, i).ToXYZ(true);
+			XYZ another = GetIsoRowPoint(controlPoints, isUDirection, row, n - index + i).ToXYZ(true);
+			if (!another.IsAlmostEqualTo(current))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/// <summary>
+	/// Convert Sw(u,v) derivatives to S(u,v) derivatives.
+	/// </summary>
+	std::vector<std::vector<XYZ>> ToRationalSurfaceDerivatives(const std::vector<std::vector<XYZW>>& ders)
+	{
+		int derivative = ders.size() - 1;
+		std::vector<std::vector<XYZ>> derivatives(derivative + 1, std::vector<XYZ>(derivative + 1));
+
+		std::vector<std::vector<XYZ>> Aders(derivative + 1, std::vector<XYZ>(derivative + 1));
+		std::vector<std::vector<double>> wders(derivative + 1, std::vector<double>(derivative + 1));
+		for (int i = 0; i < ders.size(); i++)
+		{
+			for (int j = 0; j < ders[0].size(); j++)
+			{
+				Aders[i][j] = ders[i][j].ToXYZ(false);
+				wders[i][j] = ders[i][j].GetW();
+			}
+		}
+
+		for (int k = 0; k <= derivative; k++)
+		{
+			for (int l = 0; l <= derivative - k; l++)
+			{
+				XYZ v = Aders[k][l];
+				for (int j = 1; j <= l; j++)
+				{
+					v = v - MathUtils::Binomial(l, j) * wders[0][j] * derivatives[k][l - j];
+				}
+
+				for (int i = 1; i <= k; i++)
+				{
+					v = v - MathUtils::Binomial(k, i) * wders[i][0] * derivatives[k - i][l];
+
+					XYZ v2 = XYZ(0, 0, 0);
+					for (int j = 1; j <= l; j++)
+					{
+						v2 = v2 + MathUtils::Binomial(l, j) * wders[i][j] * derivatives[k - i][l - j];
+					}
+					v = v - MathUtils::Binomial(k, i) * v2;
+				}
+				derivatives[k][l] = v / wders[0][0];
+			}
+		}
+		return derivatives;
+	}
+
+	/// <summary>
+	/// All weights exactly one make the surface a polynomial tensor product B-spline.
+	/// </summary>
+	bool HasUnitSurfaceWeights(const std::vector<std::vector<XYZW>>& controlPoints)
+	{
+		for (int i = 0; i < controlPoints.size(); i++)
+		{
+			const std::vector<XYZW>& row = controlPoints[i];
+			for (int j = 0; j < row.size(); j++)
+			{
+				if (row[j].GetW() != 1.0) return false;
+			}
+		}
+		return true;
+	}
+
+	/// <summary>
+	/// Only the (degreeU + 1) x (degreeV + 1) weights of the span matter for one evaluation,
+	/// unchecked per-point calls look at these instead of scanning the whole net.
+	/// </summary>
+	bool HasUnitSpanSurfaceWeights(const LN_NurbsSurface& surface, int uSpanIndex, int vSpanIndex)
+	{
+		const std::vector<std::vector<XYZW>>& controlPoints = surface.ControlPoints;
+		for (int k = uSpanIndex - surface.DegreeU; k <= uSpanIndex; k++)
+		{
+			for (int l = vSpanIndex - surface.DegreeV; l <= vSpanIndex; l++)
+			{
+				if (controlPoints[k][l].GetW() != 1.0) return false;
+			}
+		}
+		return true;
+	}
+
+	/// <summary>
+	/// Evaluate S(u,v) at known spans, the polynomial sum skips the weights and the division.
+	/// </summary>
+	XYZ GetPointOnSurfaceAtSpan(const LN_NurbsSurface& surface, int uSpanIndex, int vSpanIndex, UV uv, bool isRational)
+	{
+		int degreeU = surface.DegreeU;
+		int degreeV = surface.DegreeV;
+		const std::vector<double>& knotVectorU = surface.KnotVectorU;
+		const std::vector<double>& knotVectorV = surface.KnotVectorV;
+		const std::vector<std::vector<XYZW>>& controlPoints = surface.ControlPoints;
+
+		double stackNu[Constants::MaxStackBasisSize];
+		double stackNv[Constants::MaxStackBasisSize];
+		std::vector<double> heapNu;
+		std::vector<double> heapNv;
+		double* Nu = stackNu;
+		double* Nv = stackNv;
+		if (degreeU >= Constants::MaxStackBasisSize)
+		{
+			heapNu.resize(degreeU + 1);
+			Nu = heapNu.data();
+		}
+		if (degreeV >= Constants::MaxStackBasisSize)
+		{
+			heapNv.resize(degreeV + 1);
+			Nv = heapNv.data();
+		}
+
+		Polynomials::BasisFunctions(uSpanIndex, degreeU, knotVectorU, uv.GetU(), Nu);
+		Polynomials::BasisFunctions(vSpanIndex, degreeV, knotVectorV, uv.GetV(), Nv);
+
+		int uind = uSpanIndex - degreeU;
+		if (!isRational)
+		{
+			XYZ point(0, 0, 0);
+			for (int l = 0; l <= degreeV; l++)
+			{
+				double x = 0.0;
+				double y = 0.0;
+				double z = 0.0;
+				int vind = vSpanIndex - degreeV + l;
+				for (int k = 0; k <= degreeU; k++)
+				{
+					const XYZW& controlPoint = controlPoints[uind + k][vind];
+					x += Nu[k] * controlPoint.GetWX();
+					y += Nu[k] * controlPoint.GetWY();
+					z += Nu[k] * controlPoint.GetWZ();
+				}
+				point += Nv[l] * XYZ(x, y, z);
+			}
+			return point;
+		}
+
+		XYZW point;
+		for (int l = 0; l <= degreeV; l++)
+		{
+			XYZW temp;
+			int vind = vSpanIndex - degreeV + l;
+			for (int k = 0; k <= degreeU; k++)
+			{
+				temp += Nu[k] * controlPoints[uind + k][vind];
+			}
+			point += Nv[l] * temp;
+		}
+		return point.ToXYZ(true);
+	}
+
+	/// <summary>
+	/// Compute S(u,v) derivatives at known spans, without weights the derivatives of Sw(u,v) are the result.
+	/// </summary>
+	std::vector<std::vector<XYZ>> ComputeSurfaceDerivativesAtSpan(const LN_NurbsSurface& surface, int derivative, int uSpanIndex, int vSpanIndex, UV uv, bool isRational)
+	{
+		int degreeU = surface.DegreeU;
+		int degreeV = surface.DegreeV;
+		const std::vector<double>& knotVectorU = surface.KnotVectorU;
+		const std::vector<double>& knotVectorV = surface.KnotVectorV;
+		const std::vector<std::vector<XYZW>>& controlPoints = surface.ControlPoints;
+
+		int du = std::min(derivative, degreeU);
+		int dv = std::min(derivative, degreeV);
+
+		std::vector<double> Nu((du + 1) * (degreeU + 1));
+		Polynomials::BasisFunctionsDerivatives(uSpanIndex, degreeU, du, knotVectorU, uv.GetU(), Nu.data());
+
+		std::vector<double> Nv((dv + 1) * (degreeV + 1));
+		Polynomials::BasisFunctionsDerivatives(vSpanIndex, degreeV, dv, knotVectorV, uv.GetV(), Nv.data());
+
+		if (!isRational)
+		{
+			std::vector<std::vector<XYZ>> derivatives(derivative + 1, std::vector<XYZ>(derivative + 1, XYZ(0, 0, 0)));
+			std::vector<XYZ> temp(degreeV + 1);
+			for (int k = 0; k <= du; k++)
+			{
+				for (int s = 0; s <= degreeV; s++)
+				{
+					double x = 0.0;
+					double y = 0.0;
+					double z = 0.0;
+					for (int r = 0; r <= degreeU; r++)
+					{
+						double n = Nu[k * (degreeU + 1) + r];
+						const XYZW& controlPoint = controlPoints[uSpanIndex - degreeU + r][vSpanIndex - degreeV + s];
+						x += n * controlPoint.GetWX();
+						y += n * controlPoint.GetWY();
+						z += n * controlPoint.GetWZ();
+					}
+					temp[s] = XYZ(x, y, z);
+				}
+				int dd = std::min(derivative - k, dv);
+				for (int l = 0; l <= dd; l++)
+				{
+					for (int s = 0; s <= degreeV; s++)
+					{
+						derivatives[k][l] += Nv[l * (degreeV + 1) + s] * temp[s];
+					}
+				}
+			}
+			return derivatives;
+		}
+
+		std::vector<std::vector<XYZW>> ders(derivative + 1, std::vector<XYZW>(derivative + 1));
+		std::vector<XYZW> temp(degreeV + 1);
+		for (int k = 0; k <= du; k++)
+		{
+			for (int s = 0; s <= degreeV; s++)
+			{
+				temp[s] = XYZW();
+				for (int r = 0; r <= degreeU; r++)
+				{
+					temp[s] += Nu[k * (degreeU + 1) + r] * controlPoints[uSpanIndex - degreeU + r][vSpanIndex - degreeV + s];
+				}
+			}
+			int dd = std::min(derivative - k, dv);
+			for (int l = 0; l <= dd; l++)
+			{
+				for (int s = 0; s <= degreeV; s++)
+				{
+					ders[k][l] += Nv[l * (degreeV + 1) + s] * temp[s];
+				}
+			}
+		}
+		return ToRationalSurfaceDerivatives(ders);
+	}
+
+	void ValidateGridParams(const LN_NurbsSurface& surface, const std::vector<double>& uParams, const std::vector<double>& vParams)
+	{
+		const std::vector<double>& knotVectorU = surface.KnotVectorU;
+		const std::vector<double>& knotVectorV = surface.KnotVectorV;
+		for (int i = 0; i < uParams.size(); i++)
+		{
+			VALIDATE_ARGUMENT_RANGE(uParams[i], knotVectorU[0], knotVectorU[knotVectorU.size() - 1]);
+		}
+		for (int j = 0; j < vParams.size(); j++)
+		{
+			VALIDATE_ARGUMENT_RANGE(vParams[j], knotVectorV[0], knotVectorV[knotVectorV.size() - 1]);
+		}
+	}
+
+	/// <summary>
+	/// Span and basis functions up to derivative of every param, found with one cursor walk.
+	/// The kth derivative of param i starts at basis[(i * (derivative + 1) + k) * (degree + 1)].
+	/// </summary>
+	void ComputeGridBasis(int degree, const std::vector<double>& knotVector, const std::vector<double>& params, int derivative, std::vector<int>& spans, std::vector<double>& basis)
+	{
+		int size = (derivative + 1) * (degree + 1);
+		spans.resize(params.size());
+		basis.resize(params.size() * size);
+		KnotSpanCursor cursor(degree, knotVector);
+		for (int i = 0; i < params.size(); i++)
+		{
+			int spanIndex = cursor.Find(params[i]);
+			spans[i] = spanIndex;
+			if (derivative == 0)
+			{
+				Polynomials::BasisFunctions(spanIndex, degree, knotVector, params[i], &basis[i * size]);
+			}
+			else
+			{
+				Polynomials::BasisFunctionsDerivatives(spanIndex, degree, derivative, knotVector, params[i], &basis[i * size]);
+			}
+		}
+	}
+
+	/// <summary>
+	/// EvaluateGrid on control point arrays built once by the caller, so tiles of one grid share them.
+	/// </summary>
+	void EvaluateGridOnArrays(const LN_CheckedNurbsSurface& surface, const LN_ControlPointArrays& arrays, const std::vector<double>& uParams, const std::vector<double>& vParams, std::vector<std::vector<XYZ>>& points)
+	{
+		LNLIB_COUNT(Evaluations, uParams.size() * vParams.size());
+		const LN_NurbsSurface& nurbsSurface = surface.Surface();
+		int degreeU = nurbsSurface.DegreeU;
+		int degreeV = nurbsSurface.DegreeV;
+		const std::vector<double>& knotVectorU = nurbsSurface.KnotVectorU;
+		const std::vector<double>& knotVectorV = nurbsSurface.KnotVectorV;
+		const std::vector<std::vector<XYZW>>& controlPoints = nurbsSurface.ControlPoints;
+
+		int rows = uParams.size();
+		int columns = vParams.size();
+
+		std::vector<int> spansU;
+		std::vector<int> spansV;
+		std::vector<double> Nu;
+		std::vector<double> Nv;
+		ComputeGridBasis(degreeU, knotVectorU, uParams, 0, spansU, Nu);
+		ComputeGridBasis(degreeV, knotVectorV, vParams, 0, spansV, Nv);
+
+		int netColumns = controlPoints[0].size();
+		bool isRational = surface.IsRational();
+
+		// Contract U basis once per row into an isoparametric curve Cw(v), then evaluate it at every vParams.
+		std::vector<double> cx(netColumns);
+		std::vector<double> cy(netColumns);
+		std::vector<double> cz(netColumns);
+		std::vector<double> cw(netColumns);
+
+		points.resize(rows);
+		for (int i = 0; i < rows; i++)
+		{
+			points[i].resize(columns);
+			int uind = spansU[i] - degreeU;
+			const double* nu = &Nu[i * (degreeU + 1)];
+
+			std::fill(cx.begin(), cx.end(), 0.0);
+			std::fill(cy.begin(), cy.end(), 0.0);
+			std::fill(cz.begin(), cz.end(), 0.0);
+			std::fill(cw.begin(), cw.end(), 0.0);
+			for (int k = 0; k <= degreeU; k++)
+			{
+				double n = nu[k];
+				int offset = (uind + k) * netColumns;
+				const double* wx = &arrays.WX[offset];
+				const double* wy = &arrays.WY[offset];
+				const double* wz = &arrays.WZ[offset];
+				for (int c = 0; c < netColumns; c++)
+				{
+					cx[c] += n * wx[c];
+					cy[c] += n * wy[c];
+					cz[c] += n * wz[c];
+				}
+				if (isRational)
+				{
+					const double* w = &arrays.W[offset];
+					for (int c = 0; c < netColumns; c++)
+					{
+						cw[c] += n * w[c];
+					}
+				}
+			}
+
+			for (int j = 0; j < columns; j++)
+			{
+				int vind = spansV[j] - degreeV;
+				const double* nv = &Nv[j * (degreeV + 1)];
+
+				double x = 0.0;
+				double y = 0.0;
+				double z = 0.0;
+				for (int l = 0; l <= degreeV; l++)
+				{
+					double n = nv[l];
+					x += n * cx[vind + l];
+					y += n * cy[vind + l];
+					z += n * cz[vind + l];
+				}
+				if (!isRational)
+				{
+					points[i][j] = XYZ(x, y, z);
+					continue;
+				}
+				double h = 0.0;
+				for (int l = 0; l <= degreeV; l++)
+				{
+					h += nv[l] * cw[vind + l];
+				}
+				points[i][j] = XYZW(x, y, z, h).ToXYZ(true);
+			}
+		}
+	}
+
+	const int TessellationTileSize = 32;
+
+	std::vector<double> GetEquallySpacedParameters(const std::vector<double>& knotVector, int intervals)
+	{
+		std::vector<double> uniqueKv = knotVector;
+		uniqueKv.erase(unique(uniqueKv.begin(), uniqueKv.end()), uniqueKv.end());
+		int size = uniqueKv.size();
+
+		std::vector<double> params;
+		params.reserve((size - 1) * intervals);
+		for (int i = 0; i < size - 1; i++)
+		{
+			double current = uniqueKv[i];
+			double next = uniqueKv[i + 1];
+			double step = (next - current) / intervals;
+			for (int j = 0; j < intervals; j++)
+			{
+				params.emplace_back(current + step * j);
+			}
+		}
+		return params;
+	}
+
+	/// <summary>
+	/// Tiles share the surface checked once and its control point arrays built once.
+	/// </summary>
+	struct TessellationTileTask : public ParallelTask
+	{
+		const LN_CheckedNurbsSurface& Surface;
+		const LN_ControlPointArrays& Arrays;
+		const std::vector<double>& ParamsU;
+		const std::vector<double>& ParamsV;
+		int TileColumns;
+		XYZ* Points;
+		UV* Knots;
+
+		TessellationTileTask(const LN_CheckedNurbsSurface& surface, const LN_ControlPointArrays& arrays, const std::vector<double>& paramsU, const std::vector<double>& paramsV, XYZ* points, UV* knots)
+			: Surface(surface), Arrays(arrays), ParamsU(paramsU), ParamsV(paramsV), Points(points), Knots(knots)
+		{
+			TileColumns = (paramsV.size() + TessellationTileSize - 1) / TessellationTileSize;
+		}
+
+		void operator()(int taskIndex) override
+		{
+			int startU = (taskIndex / TileColumns) * TessellationTileSize;
+			int startV = (taskIndex % TileColumns) * TessellationTileSize;
+			int endU = std::min(startU + TessellationTileSize, static_cast<int>(ParamsU.size()));
+			int endV = std::min(startV + TessellationTileSize, static_cast<int>(ParamsV.size()));
+
+			std::vector<double> tileU(ParamsU.begin() + startU, ParamsU.begin() + endU);
+			std::vector<double> tileV(ParamsV.begin() + startV, ParamsV.begin() + endV);
+			std::vector<std::vector<XYZ>> grid;
+			EvaluateGridOnArrays(Surface, Arrays, tileU, tileV, grid);
+
+			int columns = ParamsV.size();
+			for (int i = startU; i < endU; i++)
+			{
+				for (int j = startV; j < endV; j++)
+				{
+					Points[i * columns + j] = grid[i - startU][j - startV];
+					Knots[i * columns + j] = UV(ParamsU[i], ParamsV[j]);
+				}
+			}
+		}
+	};
+
+	const int MaxTessellationDepth = 8;
+
+	struct MeshCell
+	{
+		int I;
+		int J;
+		int Size;
+		bool IsTrimmed;
+	};
+
+	class AdaptiveMesher
+	{
+	public:
+		AdaptiveMesher(const LN_NurbsSurface& surface, double chordTolerance, double normalTolerance, LN_Mesh& mesh, const TrimLoopClassifier* trim = nullptr)
+			: _surface(surface), _chordTolerance(chordTolerance), _normalTolerance(normalTolerance), _mesh(mesh), _trim(trim), _firstVertex(mesh.Vertices.size())
+		{
+			_uniqueU = surface.KnotVectorU;
+			_uniqueU.erase(unique(_uniqueU.begin(), _uniqueU.end()), _uniqueU.end());
+			_uniqueV = surface.KnotVectorV;
+			_uniqueV.erase(unique(_uniqueV.begin(), _uniqueV.end()), _uniqueV.end());
+		}
+
+		void Run()
+		{
+			int rootSize = 1 << MaxTessellationDepth;
+			for (int i = 0; i < _uniqueU.size() - 1; i++)
+			{
+				for (int j = 0; j < _uniqueV.size() - 1; j++)
+				{
+					Subdivide(i * rootSize, j * rootSize, rootSize);
+				}
+			}
+			for (int k = 0; k < _leaves.size(); k++)
+			{
+				Triangulate(_leaves[k]);
+			}
+			if (_trim != nullptr)
+			{
+				RemoveUnusedVertices();
+			}
+		}
+
+	private:
+		const LN_NurbsSurface& _surface;
+		double _chordTolerance;
+		double _normalTolerance;
+		LN_Mesh& _mesh;
+		const TrimLoopClassifier* _trim;
+		int _firstVertex;
+		std::vector<double> _uniqueU;
+		std::vector<double> _uniqueV;
+		std::map<std::pair<int, int>, int> _vertices;
+		std::vector<MeshCell> _leaves;
+
+		double ToParameter(const std::vector<double>& uniqueKv, int grid) const
+		{
+			int rootSize = 1 << MaxTessellationDepth;
+			int span = std::min(grid / rootSize, static_cast<int>(uniqueKv.size()) - 2);
+			double ratio = static_cast<double>(grid - span * rootSize) / rootSize;
+			return uniqueKv[span] + (uniqueKv[span + 1] - uniqueKv[span]) * ratio;
+		}
+
+		int GetVertex(int i, int j)
+		{
+			std::pair<int, int> key(i, j);
+			auto it = _vertices.find(key);
+			if (it != _vertices.end())
+			{
+				return it->second;
+			}
+			UV uv(ToParameter(_uniqueU, i), ToParameter(_uniqueV, j));
+			std::vector<std::vector<XYZ>> derivatives = NurbsSurface::ComputeRationalSurfaceDerivatives(_surface, 1, uv);
+			int index = _mesh.Vertices.size();
+			_mesh.Vertices.emplace_back(derivatives[0][0]);
+			_mesh.Normals.emplace_back(derivatives[1][0].Normalize().CrossProduct(derivatives[0][1]).Normalize());
+			_mesh.UVs.emplace_back(uv);
+			_vertices[key] = index;
+			return index;
+		}
+
+		void Subdivide(int i, int j, int size)
+		{
+			int half = size / 2;
+			bool isTrimmed = false;
+			if (_trim != nullptr)
+			{
+				UV min(ToParameter(_uniqueU, i), ToParameter(_uniqueV, j));
+				UV max(ToParameter(_uniqueU, i + size), ToParameter(_uniqueV, j + size));
+				TrimRegion region = _trim->Classify(min, max);
+				if (region == TrimRegion::Outside)
+				{
+					return;
+				}
+				// Cells crossed by a loop are refined to the trim tolerance whatever their flatness.
+				isTrimmed = region == TrimRegion::Boundary;
+				double tolerance = _trim->GetTolerance();
+				if (isTrimmed && half > 0 && (max.GetU() - min.GetU() > tolerance || max.GetV() - min.GetV() > tolerance))
+				{
+					Subdivide(i, j, half);
+					Subdivide(i + half, j, half);
+					Subdivide(i, j + half, half);
+					Subdivide(i + half, j + half, half);
+					return;
+				}
+			}
+
+			bool isFlat = true;
+			if (half > 0)
+			{
+				int corners[4] = { GetVertex(i, j), GetVertex(i + size, j), GetVertex(i, j + size), GetVertex(i + size, j + size) };
+				XYZ p00 = _mesh.Vertices[corners[0]];
+				XYZ p10 = _mesh.Vertices[corners[1]];
+				XYZ p01 = _mesh.Vertices[corners[2]];
+				XYZ p11 = _mesh.Vertices[corners[3]];
+
+				UV center(ToParameter(_uniqueU, i + half), ToParameter(_uniqueV, j + half));
+				std::vector<std::vector<XYZ>> derivatives = NurbsSurface::ComputeRationalSurfaceDerivatives(_surface, 1, center);
+				XYZ centerNormal = derivatives[1][0].Normalize().CrossProduct(derivatives[0][1]).Normalize();
+
+				isFlat = derivatives[0][0].Distance((p00 + p10 + p01 + p11) / 4.0) <= _chordTolerance &&
+					IsFlatEdge(i, j, i + size, j, p00, p10) &&
+					IsFlatEdge(i, j + size, i + size, j + size, p01, p11) &&
+					IsFlatEdge(i, j, i, j + size, p00, p01) &&
+					IsFlatEdge(i + size, j, i + size, j + size, p10, p11);
+
+				for (int k = 0; k < 4 && isFlat; k++)
+				{
+					isFlat = centerNormal.AngleTo(_mesh.Normals[corners[k]]) <= _normalTolerance;
+				}
+			}
+			if (isFlat)
+			{
+				GetVertex(i, j);
+				GetVertex(i + size, j);
+				GetVertex(i, j + size);
+				GetVertex(i + size, j + size);
+				_leaves.emplace_back(MeshCell{ i, j, size, isTrimmed });
+				return;
+			}
+			Subdivide(i, j, half);
+			Subdivide(i + half, j, half);
+			Subdivide(i, j + half, half);
+			Subdivide(i + half, j + half, half);
+		}
+
+		bool IsFlatEdge(int i0, int j0, int i1, int j1, const XYZ& start, const XYZ& end)
+		{
+			UV middle(ToParameter(_uniqueU, (i0 + i1) / 2), ToParameter(_uniqueV, (j0 + j1) / 2));
+			XYZ point = NurbsSurface::GetPointOnSurface(_surface, middle);
+			return point.Distance((start + end) / 2.0) <= _chordTolerance;
+		}
+
+		void CollectEdge(int i0, int j0, int i1, int j1, std::vector<int>& loop)
+		{
+			int mi = (i0 + i1) / 2;
+			int mj = (j0 + j1) / 2;
+			bool isSplit = (std::abs(i1 - i0) > 1 || std::abs(j1 - j0) > 1) && _vertices.find(std::make_pair(mi, mj)) != _vertices.end();
+			if (!isSplit)
+			{
+				loop.emplace_back(_vertices[std::make_pair(i0, j0)]);
+				return;
+			}
+			CollectEdge(i0, j0, mi, mj, loop);
+			CollectEdge(mi, mj, i1, j1, loop);
+		}
+
+		void Triangulate(const MeshCell& cell)
+		{
+			int i = cell.I;
+			int j = cell.J;
+			int size = cell.Size;
+
+			std::vector<int> loop;
+			CollectEdge(i, j, i + size, j, loop);
+			CollectEdge(i + size, j, i + size, j + size, loop);
+			CollectEdge(i + size, j + size, i, j + size, loop);
+			CollectEdge(i, j + size, i, j, loop);
+
+			if (loop.size() == 4)
+			{
+				AddTriangle(loop[0], loop[1], loop[2], cell.IsTrimmed);
+				AddTriangle(loop[0], loop[2], loop[3], cell.IsTrimmed);
+				return;
+			}
+			int center = GetVertex(i + size / 2, j + size / 2);
+			for (int k = 0; k < loop.size(); k++)
+			{
+				AddTriangle(center, loop[k], loop[(k + 1) % loop.size()], cell.IsTrimmed);
+			}
+		}
+
+		/// <summary>
+		/// Triangles of cells crossed by a loop are kept when their parameter centroid is inside.
+		/// </summary>
+		void AddTriangle(int first, int second, int third, bool isTrimmed)
+		{
+			if (isTrimmed)
+			{
+				const std::vector<UV>& uvs = _mesh.UVs;
+				if (!_trim->IsInside((uvs[first] + uvs[second] + uvs[third]) / 3.0))
+				{
+					return;
+				}
+			}
+			_mesh.Indices.insert(_mesh.Indices.end(), { first, second, third });
+		}
+
+		/// <summary>
+		/// Drops the vertices of this run that only served cells outside the loops, earlier vertices of mesh are kept.
+		/// </summary>
+		void RemoveUnusedVertices()
+		{
+			int count = _mesh.Vertices.size();
+			std::vector<int>& indices = _mesh.Indices;
+			std::vector<bool> isUsed(count, false);
+			for (int k = 0; k < indices.size(); k++)
+			{
+				isUsed[indices[k]] = true;
+			}
+
+			std::vector<int> remap(count);
+			int next = _firstVertex;
+			for (int k = 0; k < count; k++)
+			{
+				if (k < _firstVertex)
+				{
+					remap[k] = k;
+					continue;
+				}
+				if (isUsed[k])
+				{
+					_mesh.Vertices[next] = _mesh.Vertices[k];
+					_mesh.Normals[next] = _mesh.Normals[k];
+					_mesh.UVs[next] = _mesh.UVs[k];
+					remap[k] = next++;
+				}
+			}
+			for (int k = 0; k < indices.size(); k++)
+			{
+				indices[k] = remap[indices[k]];
+			}
+			_mesh.Vertices.resize(next);
+			_mesh.Normals.resize(next);
+			_mesh.UVs.resize(next);
+		}
+	};
+
 	struct AreaData
 	{
 		const LN_NurbsSurface& Surface;
@@ -62,7 +794,6 @@ namespace LNLib
 	{
 		double operator()(double parameter, void* customData)
 		{
-			static std::vector<double> series;
 			AreaCoreFunction areaCoreFunction;
 			AreaData* data = (AreaData*)customData;
 			data->ParameterV = parameter;
@@ -70,7 +801,270 @@ namespace LNLib
 		}
 	};
 
-	std::vector<int> GetIndex(int size)
+	const int AreaQuadratureOrder = 8;
+	const int MaxAreaDepth = 6;
+	const int MaxKronrodAreaEvaluationsPerPatch = 64 * 225;
+
+	void ComputeFirstPartials(const LN_NurbsSurface& surface, const std::vector<double>& uParams, const std::vector<double>& vParams, std::vector<XYZ>& Su, std::vector<XYZ>& Sv)
+	{
+		LNLIB_COUNT(Evaluations, uParams.size() * vParams.size());
+		int degreeU = surface.DegreeU;
+		int degreeV = surface.DegreeV;
+		const std::vector<double>& knotVectorU = surface.KnotVectorU;
+		const std::vector<double>& knotVectorV = surface.KnotVectorV;
+		const std::vector<std::vector<XYZW>>& controlPoints = surface.ControlPoints;
+
+		int rows = uParams.size();
+		int columns = vParams.size();
+		std::vector<int> spansU(rows);
+		std::vector<double> dersU(rows * 2 * (degreeU + 1));
+		KnotSpanCursor cursorU(degreeU, knotVectorU);
+		for (int i = 0; i < rows; i++)
+		{
+			int span = cursorU.Find(uParams[i]);
+			spansU[i] = span;
+			Polynomials::BasisFunctionsDerivatives(span, degreeU, 1, knotVectorU, uParams[i], &dersU[i * 2 * (degreeU + 1)]);
+		}
+		std::vector<int> spansV(columns);
+		std::vector<double> dersV(columns * 2 * (degreeV + 1));
+		KnotSpanCursor cursorV(degreeV, knotVectorV);
+		for (int j = 0; j < columns; j++)
+		{
+			int span = cursorV.Find(vParams[j]);
+			spansV[j] = span;
+			Polynomials::BasisFunctionsDerivatives(span, degreeV, 1, knotVectorV, vParams[j], &dersV[j * 2 * (degreeV + 1)]);
+		}
+
+		Su.resize(rows * columns);
+		Sv.resize(rows * columns);
+		for (int i = 0; i < rows; i++)
+		{
+			const double* Nu = &dersU[i * 2 * (degreeU + 1)];
+			const double* dNu = Nu + degreeU + 1;
+			for (int j = 0; j < columns; j++)
+			{
+				const double* Nv = &dersV[j * 2 * (degreeV + 1)];
+				const double* dNv = Nv + degreeV + 1;
+
+				XYZW A;
+				XYZW Au;
+				XYZW Av;
+				for (int k = 0; k <= degreeU; k++)
+				{
+					const std::vector<XYZW>& row = controlPoints[spansU[i] - degreeU + k];
+					XYZW temp;
+					XYZW tempV;
+					for (int l = 0; l <= degreeV; l++)
+					{
+						const XYZW& point = row[spansV[j] - degreeV + l];
+						temp += Nv[l] * point;
+						tempV += dNv[l] * point;
+					}
+					A += Nu[k] * temp;
+					Au += dNu[k] * temp;
+					Av += Nu[k] * tempV;
+				}
+
+				double w = A.GetW();
+				XYZ S = XYZ(A.GetWX(), A.GetWY(), A.GetWZ()) / w;
+				Su[i * columns + j] = (XYZ(Au.GetWX(), Au.GetWY(), Au.GetWZ()) - Au.GetW() * S) / w;
+				Sv[i * columns + j] = (XYZ(Av.GetWX(), Av.GetWY(), Av.GetWZ()) - Av.GetW() * S) / w;
+			}
+		}
+	}
+
+	double IntegrateCellArea(const LN_NurbsSurface& surface, double a, double b, double c, double d, const std::vector<double>& abscissae, const std::vector<double>& weights)
+	{
+		int order = abscissae.size();
+		double coefficient1 = (b - a) / 2.0;
+		double coefficient2 = (d - c) / 2.0;
+		std::vector<double> uParams(order);
+		std::vector<double> vParams(order);
+		for (int i = 0; i < order; i++)
+		{
+			uParams[i] = coefficient1 * abscissae[i] + (a + b) / 2.0;
+			vParams[i] = coefficient2 * abscissae[i] + (c + d) / 2.0;
+		}
+
+		std::vector<XYZ> Su;
+		std::vector<XYZ> Sv;
+		ComputeFirstPartials(surface, uParams, vParams, Su, Sv);
+
+		double area = 0.0;
+		for (int i = 0; i < order; i++)
+		{
+			for (int j = 0; j < order; j++)
+			{
+				area += weights[i] * weights[j] * Su[i * order + j].CrossProduct(Sv[i * order + j]).Length();
+			}
+		}
+		return coefficient1 * coefficient2 * area;
+	}
+
+	double IntegrateCellAreaAdaptively(const LN_NurbsSurface& surface, double a, double b, double c, double d, double whole, double tolerance, int depth, const std::vector<double>& abscissae, const std::vector<double>& weights, const CancellationToken* cancellation)
+	{
+		CancellationToken::ThrowIfCancelled(cancellation);
+		double m = (a + b) / 2.0;
+		double n = (c + d) / 2.0;
+		double q00 = IntegrateCellArea(surface, a, m, c, n, abscissae, weights);
+		double q10 = IntegrateCellArea(surface, m, b, c, n, abscissae, weights);
+		double q01 = IntegrateCellArea(surface, a, m, n, d, abscissae, weights);
+		double q11 = IntegrateCellArea(surface, m, b, n, d, abscissae, weights);
+		double split = q00 + q10 + q01 + q11;
+		if (std::abs(split - whole) <= tolerance * split || depth >= MaxAreaDepth)
+		{
+			return split;
+		}
+		return IntegrateCellAreaAdaptively(surface, a, m, c, n, q00, tolerance, depth + 1, abscissae, weights, cancellation) +
+			IntegrateCellAreaAdaptively(surface, m, b, c, n, q10, tolerance, depth + 1, abscissae, weights, cancellation) +
+			IntegrateCellAreaAdaptively(surface, a, m, n, d, q01, tolerance, depth + 1, abscissae, weights, cancellation) +
+			IntegrateCellAreaAdaptively(surface, m, b, n, d, q11, tolerance, depth + 1, abscissae, weights, cancellation);
+	}
+
+	struct KronrodAreaCell
+	{
+		double StartU;
+		double EndU;
+		double StartV;
+		double EndV;
+		double Value;
+		double ErrorU;
+		double ErrorV;
+		double Error;
+	};
+
+	struct KronrodAreaCellLess
+	{
+		bool operator()(const KronrodAreaCell& left, const KronrodAreaCell& right) const
+		{
+			return left.Error < right.Error;
+		}
+	};
+
+	void EvaluateKronrodAreaCell(const LN_NurbsSurface& surface, KronrodAreaCell& cell)
+	{
+		const std::vector<double>& abscissae = Integrator::GaussKronrodAbscissae;
+		const std::vector<double>& kronrodWeights = Integrator::GaussKronrodWeights;
+		const std::vector<double>& gaussWeights = Integrator::GaussKronrodGaussWeights;
+		int order = abscissae.size();
+		double coefficient1 = (cell.EndU - cell.StartU) / 2.0;
+		double coefficient2 = (cell.EndV - cell.StartV) / 2.0;
+		std::vector<double> uParams(order);
+		std::vector<double> vParams(order);
+		for (int i = 0; i < order; i++)
+		{
+			uParams[i] = coefficient1 * abscissae[i] + (cell.StartU + cell.EndU) / 2.0;
+			vParams[i] = coefficient2 * abscissae[i] + (cell.StartV + cell.EndV) / 2.0;
+		}
+
+		std::vector<XYZ> Su;
+		std::vector<XYZ> Sv;
+		ComputeFirstPartials(surface, uParams, vParams, Su, Sv);
+
+		// K x K is the estimate, G x K and K x G tell the error left in u and in v.
+		double kk = 0.0;
+		double gk = 0.0;
+		double kg = 0.0;
+		for (int i = 0; i < order; i++)
+		{
+			for (int j = 0; j < order; j++)
+			{
+				double ds = Su[i * order + j].CrossProduct(Sv[i * order + j]).Length();
+				kk += kronrodWeights[i] * kronrodWeights[j] * ds;
+				gk += gaussWeights[i] * kronrodWeights[j] * ds;
+				kg += kronrodWeights[i] * gaussWeights[j] * ds;
+			}
+		}
+		double coefficient = coefficient1 * coefficient2;
+		cell.Value = coefficient * kk;
+		cell.ErrorU = std::abs(coefficient * (kk - gk));
+		cell.ErrorV = std::abs(coefficient * (kk - kg));
+		cell.Error = cell.ErrorU + cell.ErrorV;
+	}
+
+	struct PatchAreaTask : public ParallelTask
+	{
+		const LN_NurbsSurface& Surface;
+		const std::vector<double>& UniqueKvU;
+		const std::vector<double>& UniqueKvV;
+		double Tolerance;
+		const CancellationToken* Cancellation;
+		std::vector<double> Abscissae;
+		std::vector<double> Weights;
+		std::vector<double> Areas;
+
+		PatchAreaTask(const LN_NurbsSurface& surface, const std::vector<double>& uniqueKvU, const std::vector<double>& uniqueKvV, double tolerance, const CancellationToken* cancellation)
+			: Surface(surface), UniqueKvU(uniqueKvU), UniqueKvV(uniqueKvV), Tolerance(tolerance), Cancellation(cancellation)
+		{
+			Integrator::GaussLegendreRule(AreaQuadratureOrder, Abscissae, Weights);
+			Areas.resize((uniqueKvU.size() - 1) * (uniqueKvV.size() - 1));
+		}
+
+		void operator()(int taskIndex) override
+		{
+			int patchesV = UniqueKvV.size() - 1;
+			int i = taskIndex / patchesV;
+			int j = taskIndex % patchesV;
+			double a = UniqueKvU[i];
+			double b = UniqueKvU[i + 1];
+			double c = UniqueKvV[j];
+			double d = UniqueKvV[j + 1];
+			double whole = IntegrateCellArea(Surface, a, b, c, d, Abscissae, Weights);
+			Areas[taskIndex] = IntegrateCellAreaAdaptively(Surface, a, b, c, d, whole, Tolerance, 0, Abscissae, Weights, Cancellation);
+		}
+	};
+
+	struct SurfaceAreaJob
+	{
+		LN_NurbsSurface Surface;
+		double Tolerance;
+		ParallelExecutor* Executor;
+		const CancellationToken* Cancellation;
+
+		double operator()() const
+		{
+			return NurbsSurface::ApproximateArea(Surface, Tolerance, Executor, Cancellation);
+		}
+	};
+
+	struct SurfaceApproximationJob
+	{
+		std::vector<std::vector<XYZ>> ThroughPoints;
+		int DegreeU;
+		int DegreeV;
+		int ControlPointsRows;
+		int ControlPointsColumns;
+		ParallelExecutor* Executor;
+		const CancellationToken* Cancellation;
+
+		LN_NurbsSurface operator()() const
+		{
+			LN_NurbsSurface surface;
+			if (!NurbsSurface::GlobalApproximation(ThroughPoints, DegreeU, DegreeV, ControlPointsRows, ControlPointsColumns, surface, Executor, Cancellation))
+			{
+				throw std::runtime_error("Global surface approximation failed.");
+			}
+			return surface;
+		}
+	};
+
+	struct GordonSurfaceJob
+	{
+		std::vector<LN_NurbsCurve> UCurves;
+		std::vector<LN_NurbsCurve> VCurves;
+		std::vector<std::vector<XYZ>> IntersectionPoints;
+		ParallelExecutor* Executor;
+		const CancellationToken* Cancellation;
+
+		LN_NurbsSurface operator()() const
+		{
+			LN_NurbsSurface surface;
+			NurbsSurface::CreateGordonSurface(UCurves, VCurves, IntersectionPoints, surface, Executor, Cancellation);
+			return surface;
+		}
+	};
+
+	std::vector<int> GetIndex(int size)
 	{
 		std::vector<int> ind(2 * (size - 1) + 2);
 		ind[0] = 0;
@@ -79,22 +1073,837 @@ namespace LNLib
 		int jj = 1;
 		for (int i = 0; i < size - 1; i++)
 		{
-			ind[ii] = jj;
-			ind[ii + 1] = jj + 1;
-			ii = ii + 2;
-			jj = jj + 3;
+			ind[ii] = jj;
+			ind[ii + 1] = jj + 1;
+			ii = ii + 2;
+			jj = jj + 3;
+		}
+		return ind;
+	}
+
+	void ReverseSurfaceKnotVector(std::vector<double>& knotVector)
+	{
+		int size = knotVector.size();
+		double min = knotVector[0];
+		double max = knotVector[size - 1];
+		std::reverse(knotVector.begin(), knotVector.end());
+		for (int i = 0; i < size; i++)
+		{
+			knotVector[i] = min + max - knotVector[i];
+		}
+	}
+
+	void BlendControlPointRow(std::vector<XYZW>& target, const std::vector<XYZW>& next, double alpha)
+	{
+		for (int c = 0; c < target.size(); c++)
+		{
+			target[c] = alpha * target[c] + (1.0 - alpha) * next[c];
+		}
+	}
+
+	/// <summary>
+	/// Algorithm A5.4 applied to whole rows of control points,
+	/// so U direction refinement runs in place without transposing the net.
+	/// </summary>
+	void RefineControlPointRows(int degree, std::vector<double>& knotVector, std::vector<std::vector<XYZW>>& rows, const std::vector<double>& insertKnotElements)
+	{
+		int n = rows.size() - 1;
+		int m = n + degree + 1;
+		int r = insertKnotElements.size() - 1;
+
+		int a = Polynomials::GetKnotSpanIndex(degree, knotVector, insertKnotElements[0]);
+		int b = Polynomials::GetKnotSpanIndex(degree, knotVector, insertKnotElements[r]) + 1;
+
+		knotVector.resize(m + r + 2);
+		for (int j = m; j >= b + degree; j--)
+		{
+			knotVector[j + r + 1] = knotVector[j];
+		}
+		rows.resize(n + r + 2);
+		for (int j = n; j >= b - 1; j--)
+		{
+			rows[j + r + 1].swap(rows[j]);
+		}
+
+		int i = b + degree - 1;
+		int k = b + degree + r;
+		for (int j = r; j >= 0; j--)
+		{
+			while (insertKnotElements[j] <= knotVector[i] && i > a)
+			{
+				rows[k - degree - 1] = rows[i - degree - 1];
+				knotVector[k] = knotVector[i];
+				k = k - 1;
+				i = i - 1;
+			}
+
+			rows[k - degree - 1] = rows[k - degree];
+			for (int l = 1; l <= degree; l++)
+			{
+				int ind = k - degree + l;
+				double alpha = knotVector[k + l] - insertKnotElements[j];
+				if (MathUtils::IsAlmostEqualTo(abs(alpha), 0.0))
+				{
+					rows[ind - 1] = rows[ind];
+				}
+				else
+				{
+					alpha = alpha / (knotVector[k + l] - knotVector[i - degree + l]);
+					BlendControlPointRow(rows[ind - 1], rows[ind], alpha);
+				}
+			}
+			knotVector[k] = insertKnotElements[j];
+			k = k - 1;
+		}
+	}
+
+	struct SurfaceDecompositionBatchFunction
+	{
+		std::vector<std::vector<LN_NurbsSurface>> Patches;
+
+		void operator()(const LN_NurbsSurface& surface, int index)
+		{
+			Patches[index] = NurbsSurface::DecomposeToBeziers(surface);
+		}
+	};
+
+	struct SurfaceTransformTask : public ParallelTask
+	{
+		std::vector<LN_NurbsSurface>& Surfaces;
+		const Matrix4d& Matrix;
+
+		SurfaceTransformTask(std::vector<LN_NurbsSurface>& surfaces, const Matrix4d& matrix) : Surfaces(surfaces), Matrix(matrix)
+		{
+		}
+
+		void operator()(int taskIndex) override
+		{
+			NurbsSurface::Transform(Surfaces[taskIndex], Matrix);
+		}
+	};
+
+	/// <summary>
+	/// Fundamental forms to principal curvatures and directions, same formulas as NurbsSurface::Curvature.
+	/// </summary>
+	LN_SurfaceCurvature GetSurfaceCurvature(const XYZ& Su, const XYZ& Sv, const XYZ& Suu, const XYZ& Suv, const XYZ& Svv)
+	{
+		LN_SurfaceCurvature result = { 0.0, 0.0, 0.0, 0.0, XYZ(0, 0, 0), XYZ(0, 0, 0) };
+
+		double E = Su.DotProduct(Su);
+		double F = Su.DotProduct(Sv);
+		double G = Sv.DotProduct(Sv);
+		double denominator = E * G - F * F;
+		if (MathUtils::IsAlmostEqualTo(denominator, 0.0))
+		{
+			return result;
+		}
+
+		XYZ normal = Su.CrossProduct(Sv).Normalize();
+		double L = Suu.DotProduct(normal);
+		double M = Suv.DotProduct(normal);
+		double N = Svv.DotProduct(normal);
+
+		double K = (L * N - M * M) / denominator;
+		double H = (E * N + G * L - 2 * F * M) / (2 * denominator);
+		double root = sqrt(abs(H * H - K));
+		result.Gauss = K;
+		result.Mean = H;
+		result.Maximum = H + root;
+		result.Minimum = H - root;
+
+		// (L - kE) du + (M - kF) dv = 0 and (M - kF) du + (N - kG) dv = 0, the better conditioned row gives (du, dv).
+		double k = result.Maximum;
+		double a = L - k * E;
+		double b = M - k * F;
+		double c = N - k * G;
+		XYZ direction = Su;
+		if (abs(a) + abs(b) >= abs(b) + abs(c))
+		{
+			if (!MathUtils::IsAlmostEqualTo(abs(a) + abs(b), 0.0))
+			{
+				direction = -b * Su + a * Sv;
+			}
+		}
+		else
+		{
+			direction = c * Su - b * Sv;
+		}
+		result.MaximumDirection = direction.Normalize();
+		result.MinimumDirection = normal.CrossProduct(result.MaximumDirection);
+		return result;
+	}
+
+	const int CurvatureRowsPerTask = 8;
+
+	/// <summary>
+	/// Curvatures of CurvatureRowsPerTask grid rows, basis functions of the columns are shared by all tasks.
+	/// </summary>
+	struct CurvatureGridTask : public ParallelTask
+	{
+		const LN_NurbsSurface& Surface;
+		const std::vector<double>& UParams;
+		int ColumnCount;
+		std::vector<int> SpansV;
+		std::vector<double> Nv;
+		std::vector<std::vector<LN_SurfaceCurvature>>& Curvatures;
+
+		CurvatureGridTask(const LN_NurbsSurface& surface, const std::vector<double>& uParams, const std::vector<double>& vParams, std::vector<std::vector<LN_SurfaceCurvature>>& curvatures)
+			: Surface(surface), UParams(uParams), ColumnCount(vParams.size()), Curvatures(curvatures)
+		{
+			int degreeV = surface.DegreeV;
+			SpansV.resize(ColumnCount);
+			Nv.resize(3 * ColumnCount * (degreeV + 1));
+			KnotSpanCursor cursorV(degreeV, surface.KnotVectorV);
+			for (int j = 0; j < ColumnCount; j++)
+			{
+				SpansV[j] = cursorV.Find(vParams[j]);
+				Polynomials::BasisFunctionsDerivatives(SpansV[j], degreeV, 2, surface.KnotVectorV, vParams[j], &Nv[3 * j * (degreeV + 1)]);
+			}
+		}
+
+		int GetTaskCount() const
+		{
+			return (UParams.size() + CurvatureRowsPerTask - 1) / CurvatureRowsPerTask;
+		}
+
+		void operator()(int taskIndex) override
+		{
+			int degreeU = Surface.DegreeU;
+			int degreeV = Surface.DegreeV;
+			const std::vector<std::vector<XYZW>>& controlPoints = Surface.ControlPoints;
+			int netColumns = controlPoints[0].size();
+
+			// Isoparametric curves of the homogeneous surface and its first and second u derivatives.
+			std::vector<double> Nu(3 * (degreeU + 1));
+			std::vector<XYZW> curves[3];
+			for (int d = 0; d < 3; d++)
+			{
+				curves[d].resize(netColumns);
+			}
+			KnotSpanCursor cursorU(degreeU, Surface.KnotVectorU);
+
+			int startRow = taskIndex * CurvatureRowsPerTask;
+			int endRow = std::min(startRow + CurvatureRowsPerTask, static_cast<int>(UParams.size()));
+			for (int i = startRow; i < endRow; i++)
+			{
+				int spanU = cursorU.Find(UParams[i]);
+				Polynomials::BasisFunctionsDerivatives(spanU, degreeU, 2, Surface.KnotVectorU, UParams[i], Nu.data());
+				for (int d = 0; d < 3; d++)
+				{
+					std::fill(curves[d].begin(), curves[d].end(), XYZW(0, 0, 0, 0));
+					const double* nu = &Nu[d * (degreeU + 1)];
+					for (int k = 0; k <= degreeU; k++)
+					{
+						const std::vector<XYZW>& row = controlPoints[spanU - degreeU + k];
+						for (int c = 0; c < netColumns; c++)
+						{
+							curves[d][c] += nu[k] * row[c];
+						}
+					}
+				}
+
+				Curvatures[i].resize(ColumnCount);
+				for (int j = 0; j < ColumnCount; j++)
+				{
+					int vind = SpansV[j] - degreeV;
+					const double* nv = &Nv[3 * j * (degreeV + 1)];
+					const double* dv = nv + degreeV + 1;
+					const double* ddv = dv + degreeV + 1;
+
+					XYZW A(0, 0, 0, 0);
+					XYZW Au(0, 0, 0, 0);
+					XYZW Av(0, 0, 0, 0);
+					XYZW Auu(0, 0, 0, 0);
+					XYZW Auv(0, 0, 0, 0);
+					XYZW Avv(0, 0, 0, 0);
+					for (int l = 0; l <= degreeV; l++)
+					{
+						A += nv[l] * curves[0][vind + l];
+						Au += nv[l] * curves[1][vind + l];
+						Auu += nv[l] * curves[2][vind + l];
+						Av += dv[l] * curves[0][vind + l];
+						Auv += dv[l] * curves[1][vind + l];
+						Avv += ddv[l] * curves[0][vind + l];
+					}
+
+					double w = A.GetW();
+					XYZ S = A.ToXYZ(true);
+					XYZ Su = (Au.ToXYZ(false) - Au.GetW() * S) / w;
+					XYZ Sv = (Av.ToXYZ(false) - Av.GetW() * S) / w;
+					XYZ Suu = (Auu.ToXYZ(false) - 2 * Au.GetW() * Su - Auu.GetW() * S) / w;
+					XYZ Suv = (Auv.ToXYZ(false) - Au.GetW() * Sv - Av.GetW() * Su - Auv.GetW() * S) / w;
+					XYZ Svv = (Avv.ToXYZ(false) - 2 * Av.GetW() * Sv - Avv.GetW() * S) / w;
+					Curvatures[i][j] = GetSurfaceCurvature(Su, Sv, Suu, Suv, Svv);
+				}
+			}
+		}
+	};
+
+	const int OffsetSurfaceDegree = 3;
+	const int OffsetSurfaceSamplesPerControlPoint = 4;
+	const int OffsetSurfaceMaxRefinements = 5;
+
+	/// <summary>
+	/// Offset samples of one knot span patch, samplesPerSpan uniform samples in each direction.
+	/// A patch owns its samples up to but without the next span start except along the last span.
+	/// </summary>
+	struct OffsetSurfacePatchTask : public ParallelTask
+	{
+		const LN_CheckedNurbsSurface& Surface;
+		double Offset;
+		const std::vector<double>& UniqueKvU;
+		const std::vector<double>& UniqueKvV;
+		int SamplesPerSpan;
+		std::vector<std::vector<XYZ>> Points;
+
+		OffsetSurfacePatchTask(const LN_CheckedNurbsSurface& surface, double offset, const std::vector<double>& uniqueKvU, const std::vector<double>& uniqueKvV, int samplesPerSpan)
+			: Surface(surface), Offset(offset), UniqueKvU(uniqueKvU), UniqueKvV(uniqueKvV), SamplesPerSpan(samplesPerSpan)
+		{
+			int rows = (uniqueKvU.size() - 1) * samplesPerSpan + 1;
+			int columns = (uniqueKvV.size() - 1) * samplesPerSpan + 1;
+			Points.resize(rows, std::vector<XYZ>(columns));
+		}
+
+		void operator()(int taskIndex) override
+		{
+			int spansV = UniqueKvV.size() - 1;
+			int spanU = taskIndex / spansV;
+			int spanV = taskIndex % spansV;
+			std::vector<double> uParams = GetParams(UniqueKvU, spanU);
+			std::vector<double> vParams = GetParams(UniqueKvV, spanV);
+
+			std::vector<std::vector<XYZ>> points;
+			std::vector<std::vector<XYZ>> normals;
+			NurbsSurface::EvaluateNormalGrid(Surface, uParams, vParams, points, normals);
+			for (int i = 0; i < uParams.size(); i++)
+			{
+				for (int j = 0; j < vParams.size(); j++)
+				{
+					Points[spanU * SamplesPerSpan + i][spanV * SamplesPerSpan + j] = points[i][j] + Offset * normals[i][j];
+				}
+			}
+		}
+
+		std::vector<double> GetParams(const std::vector<double>& uniqueKv, int span) const
+		{
+			bool isLast = span == uniqueKv.size() - 2;
+			double start = uniqueKv[span];
+			double step = (uniqueKv[span + 1] - start) / SamplesPerSpan;
+			std::vector<double> params;
+			for (int k = 0; k < SamplesPerSpan; k++)
+			{
+				params.emplace_back(start + k * step);
+			}
+			if (isLast)
+			{
+				params.emplace_back(uniqueKv[span + 1]);
+			}
+			return params;
+		}
+	};
+
+	const int InterpolationSystemsPerTask = 16;
+
+	/// <summary>
+	/// Solves the same collocation system for a chunk of right hand sides.
+	/// System s takes Right[k][s] (or Right[s][k] along the second index) for k in [0, Band.size())
+	/// and writes its solution to the same positions of Result.
+	/// </summary>
+	struct CollocationSolveTask : public ParallelTask
+	{
+		const std::vector<std::vector<double>>& Band;
+		int LowerBandwidth;
+		int UpperBandwidth;
+		bool IsDecomposed;
+		bool IsAlongSecondIndex;
+		int SystemCount;
+		const std::vector<std::vector<XYZ>>& Right;
+		std::vector<std::vector<XYZ>>& Result;
+		const CancellationToken* Cancellation;
+
+		CollocationSolveTask(const std::vector<std::vector<double>>& band, int lowerBandwidth, int upperBandwidth, bool isDecomposed, bool isAlongSecondIndex, int systemCount, const std::vector<std::vector<XYZ>>& right, std::vector<std::vector<XYZ>>& result, const CancellationToken* cancellation)
+			: Band(band), LowerBandwidth(lowerBandwidth), UpperBandwidth(upperBandwidth), IsDecomposed(isDecomposed), IsAlongSecondIndex(isAlongSecondIndex), SystemCount(systemCount), Right(right), Result(result), Cancellation(cancellation)
+		{
+		}
+
+		int GetTaskCount() const
+		{
+			return (SystemCount + InterpolationSystemsPerTask - 1) / InterpolationSystemsPerTask;
+		}
+
+		void operator()(int taskIndex) override
+		{
+			CancellationToken::ThrowIfCancelled(Cancellation);
+			int first = taskIndex * InterpolationSystemsPerTask;
+			int last = std::min(SystemCount, first + InterpolationSystemsPerTask);
+			int size = Band.size();
+
+			std::vector<std::vector<double>> right(size, std::vector<double>(3 * (last - first)));
+			for (int k = 0; k < size; k++)
+			{
+				for (int s = first; s < last; s++)
+				{
+					const XYZ& point = IsAlongSecondIndex ? Right[s][k] : Right[k][s];
+					for (int c = 0; c < 3; c++)
+					{
+						right[k][3 * (s - first) + c] = point[c];
+					}
+				}
+			}
+
+			std::vector<std::vector<double>> solved = IsDecomposed ?
+				MathUtils::BandedForwardAndBackwardSubstitution(Band, LowerBandwidth, UpperBandwidth, right) :
+				MathUtils::SolveBandedLinearSystem(Band, LowerBandwidth, UpperBandwidth, right);
+			for (int k = 0; k < size; k++)
+			{
+				for (int s = first; s < last; s++)
+				{
+					XYZ& point = IsAlongSecondIndex ? Result[s][k] : Result[k][s];
+					point = XYZ(solved[k][3 * (s - first)], solved[k][3 * (s - first) + 1], solved[k][3 * (s - first) + 2]);
+				}
+			}
+		}
+	};
+
+	/// <summary>
+	/// Least squares fits a chunk of point lines with the same parameters, knot vector and decomposed normal matrix.
+	/// Line s is Points[k][s] (or Points[s][k] along the second index) and its control points go to the same positions of Result.
+	/// </summary>
+	struct LeastSquaresSolveTask : public ParallelTask
+	{
+		int Degree;
+		int ControlPointsCount;
+		const std::vector<int>& SpanIndices;
+		const std::vector<std::vector<double>>& Basis;
+		const std::vector<std::vector<double>>& Normal;
+		bool IsAlongSecondIndex;
+		int SystemCount;
+		const std::vector<std::vector<XYZ>>& Points;
+		std::vector<std::vector<XYZ>>& Result;
+		const CancellationToken* Cancellation;
+
+		LeastSquaresSolveTask(int degree, int controlPointsCount, const std::vector<int>& spanIndices, const std::vector<std::vector<double>>& basis, const std::vector<std::vector<double>>& normal, bool isAlongSecondIndex, int systemCount, const std::vector<std::vector<XYZ>>& points, std::vector<std::vector<XYZ>>& result, const CancellationToken* cancellation)
+			: Degree(degree), ControlPointsCount(controlPointsCount), SpanIndices(spanIndices), Basis(basis), Normal(normal), IsAlongSecondIndex(isAlongSecondIndex), SystemCount(systemCount), Points(points), Result(result), Cancellation(cancellation)
+		{
+		}
+
+		int GetTaskCount() const
+		{
+			return (SystemCount + InterpolationSystemsPerTask - 1) / InterpolationSystemsPerTask;
+		}
+
+		void operator()(int taskIndex) override
+		{
+			CancellationToken::ThrowIfCancelled(Cancellation);
+			int first = taskIndex * InterpolationSystemsPerTask;
+			int last = std::min(SystemCount, first + InterpolationSystemsPerTask);
+			int inner = ControlPointsCount - 2;
+			int size = SpanIndices.size();
+
+			std::vector<std::vector<double>> right(inner, std::vector<double>(3 * (last - first)));
+			std::vector<XYZ> line(size);
+			for (int s = first; s < last; s++)
+			{
+				for (int k = 0; k < size; k++)
+				{
+					line[k] = IsAlongSecondIndex ? Points[s][k] : Points[k][s];
+				}
+				XYZ& start = IsAlongSecondIndex ? Result[s][0] : Result[0][s];
+				XYZ& end = IsAlongSecondIndex ? Result[s][ControlPointsCount - 1] : Result[ControlPointsCount - 1][s];
+				start = line[0];
+				end = line[size - 1];
+
+				std::vector<XYZ> R = Interpolation::GetLeastSquaresRight(Degree, ControlPointsCount, SpanIndices, Basis, line);
+				for (int k = 0; k < inner; k++)
+				{
+					for (int c = 0; c < 3; c++)
+					{
+						right[k][3 * (s - first) + c] = R[k][c];
+					}
+				}
+			}
+			if (inner <= 0) return;
+
+			std::vector<std::vector<double>> solved = MathUtils::SymmetricBandedForwardAndBackwardSubstitution(Normal, Degree, right);
+			for (int k = 0; k < inner; k++)
+			{
+				for (int s = first; s < last; s++)
+				{
+					XYZ& point = IsAlongSecondIndex ? Result[s][k + 1] : Result[k + 1][s];
+					point = XYZ(solved[k][3 * (s - first)], solved[k][3 * (s - first) + 1], solved[k][3 * (s - first) + 2]);
+				}
+			}
+		}
+	};
+
+	/// <summary>
+	/// Elevates section k to Degree, reparametrized to [0, 1] first when IsReparametrized.
+	/// </summary>
+	struct SectionElevationTask : public ParallelTask
+	{
+		const std::vector<LN_NurbsCurve>& Sections;
+		int Degree;
+		bool IsReparametrized;
+		std::vector<LN_NurbsCurve>& Result;
+		const CancellationToken* Cancellation;
+
+		SectionElevationTask(const std::vector<LN_NurbsCurve>& sections, int degree, bool isReparametrized, std::vector<LN_NurbsCurve>& result, const CancellationToken* cancellation)
+			: Sections(sections), Degree(degree), IsReparametrized(isReparametrized), Result(result), Cancellation(cancellation)
+		{
+		}
+
+		void operator()(int taskIndex) override
+		{
+			CancellationToken::ThrowIfCancelled(Cancellation);
+			LN_NurbsCurve current = IsReparametrized ? NurbsCurve::Reparametrize(Sections[taskIndex], 0, 1) : Sections[taskIndex];
+			if (Degree > current.Degree)
+			{
+				Result[taskIndex] = NurbsCurve::ElevateDegree(current, Degree - current.Degree);
+			}
+			else
+			{
+				Result[taskIndex] = std::move(current);
+			}
+		}
+	};
+
+	/// <summary>
+	/// Inserts InsertElements[k] into section k.
+	/// </summary>
+	struct SectionRefinementTask : public ParallelTask
+	{
+		const std::vector<std::vector<double>>& InsertElements;
+		std::vector<LN_NurbsCurve>& Sections;
+		const CancellationToken* Cancellation;
+
+		SectionRefinementTask(const std::vector<std::vector<double>>& insertElements, std::vector<LN_NurbsCurve>& sections, const CancellationToken* cancellation)
+			: InsertElements(insertElements), Sections(sections), Cancellation(cancellation)
+		{
+		}
+
+		void operator()(int taskIndex) override
+		{
+			CancellationToken::ThrowIfCancelled(Cancellation);
+			if (InsertElements[taskIndex].size() > 0)
+			{
+				NurbsCurve::RefineKnotVector(Sections[taskIndex], InsertElements[taskIndex]);
+			}
+		}
+	};
+
+	const int ElevationLaneBlockSize = 16;
+
+	/// <summary>
+	/// The NURBS Book 2nd Edition Page206
+	/// Knot vector of Algorithm A5.9, every distinct knot gains times multiplicity.
+	/// </summary>
+	std::vector<double> GetElevatedKnotVector(int degree, const std::vector<double>& knotVector, int times)
+	{
+		int m = knotVector.size() - 1;
+		int ph = degree + times;
+		std::vector<double> result(ph + 1, knotVector[0]);
+
+		int r = -1;
+		int a = degree;
+		int b = degree + 1;
+		double ua = knotVector[0];
+		while (b < m)
+		{
+			int i = b;
+			while (b < m && MathUtils::IsAlmostEqualTo(knotVector[b], knotVector[b + 1]))
+			{
+				b = b + 1;
+			}
+			int mul = b - i + 1;
+			double ub = knotVector[b];
+			int oldr = r;
+			r = degree - mul;
+			if (a != degree)
+			{
+				result.insert(result.end(), ph - oldr, ua);
+			}
+			if (b < m)
+			{
+				a = b;
+				b = b + 1;
+				ua = ub;
+			}
+			else
+			{
+				result.insert(result.end(), ph + 1, ub);
+			}
+		}
+		return result;
+	}
+
+	/// <summary>
+	/// The NURBS Book 2nd Edition Page206
+	/// Algorithm A5.9 on lanes control polygons sharing degree and knotVector, as NurbsCurve::ElevateDegree does on one.
+	/// Point i of lane l is controlPoints[i * pointStride + l * laneStride], elevated points are written to result with the result strides.
+	/// bezalfs and updatedKnotVector are computed once for all lanes, the working Bezier points keep the lanes of a point together.
+	/// </summary>
+	void ElevateDegreeOfLanes(int degree, const std::vector<double>& knotVector, int times, const std::vector<std::vector<double>>& bezalfs, const std::vector<double>& updatedKnotVector,
+		const XYZW* controlPoints, int pointStride, int laneStride, int lanes, XYZW* result, int resultPointStride, int resultLaneStride)
+	{
+		int m = knotVector.size() - 1;
+		int ph = degree + times;
+		int kind = ph + 1;
+		int r = -1;
+		int a = degree;
+		int b = degree + 1;
+		int cind = 1;
+		double ua = knotVector[0];
+
+		std::vector<XYZW> bpts((degree + 1) * lanes);
+		std::vector<XYZW> nextbpts(std::max(degree - 1, 0) * lanes);
+		std::vector<XYZW> ebpts((ph + 1) * lanes);
+		std::vector<double> alfs(std::max(degree - 1, 0));
+		for (int l = 0; l < lanes; l++)
+		{
+			result[l * resultLaneStride] = controlPoints[l * laneStride];
+			for (int i = 0; i <= degree; i++)
+			{
+				bpts[i * lanes + l] = controlPoints[i * pointStride + l * laneStride];
+			}
+		}
+
+		while (b < m)
+		{
+			int i = b;
+			while (b < m && MathUtils::IsAlmostEqualTo(knotVector[b], knotVector[b + 1]))
+			{
+				b = b + 1;
+			}
+			int mul = b - i + 1;
+			double ub = knotVector[b];
+
+			int oldr = r;
+			r = degree - mul;
+
+			int lbz = oldr > 0 ? (oldr + 2) / 2 : 1;
+			int rbz = r > 0 ? ph - (r + 1) / 2 : ph;
+
+			if (r > 0)
+			{
+				double numer = ub - ua;
+				for (int k = degree; k > mul; k--)
+				{
+					alfs[k - mul - 1] = numer / (knotVector[a + k] - ua);
+				}
+				for (int j = 1; j <= r; j++)
+				{
+					int save = r - j;
+					int s = mul + j;
+					for (int k = degree; k >= s; k--)
+					{
+						double alpha = alfs[k - s];
+						for (int l = 0; l < lanes; l++)
+						{
+							bpts[k * lanes + l] = alpha * bpts[k * lanes + l] + (1.0 - alpha) * bpts[(k - 1) * lanes + l];
+						}
+					}
+					for (int l = 0; l < lanes; l++)
+					{
+						nextbpts[save * lanes + l] = bpts[degree * lanes + l];
+					}
+				}
+			}
+
+			std::fill(ebpts.begin(), ebpts.end(), XYZW(0.0, 0.0, 0.0, 0.0));
+			for (int i = lbz; i <= ph; i++)
+			{
+				int mpi = std::min(degree, i);
+				for (int j = std::max(0, i - times); j <= mpi; j++)
+				{
+					double coefficient = bezalfs[i][j];
+					for (int l = 0; l < lanes; l++)
+					{
+						ebpts[i * lanes + l] += coefficient * bpts[j * lanes + l];
+					}
+				}
+			}
+
+			if (oldr > 1)
+			{
+				int first = kind - 2;
+				int last = kind;
+				double den = ub - ua;
+				double bet = (ub - updatedKnotVector[kind - 1]) / den;
+
+				for (int tr = 1; tr < oldr; tr++)
+				{
+					int i = first;
+					int j = last;
+					int kj = j - kind + 1;
+
+					while (j - i > tr)
+					{
+						if (i < cind)
+						{
+							double alf = (ub - updatedKnotVector[i]) / (ua - updatedKnotVector[i]);
+							for (int l = 0; l < lanes; l++)
+							{
+								XYZW& point = result[i * resultPointStride + l * resultLaneStride];
+								point = alf * point + (1.0 - alf) * result[(i - 1) * resultPointStride + l * resultLaneStride];
+							}
+						}
+						if (j >= lbz)
+						{
+							double gam = j - tr <= kind - ph + oldr ? (ub - updatedKnotVector[j - tr]) / den : bet;
+							for (int l = 0; l < lanes; l++)
+							{
+								ebpts[kj * lanes + l] = gam * ebpts[kj * lanes + l] + (1.0 - gam) * ebpts[(kj + 1) * lanes + l];
+							}
+						}
+
+						i = i + 1;
+						j = j - 1;
+						kj = kj - 1;
+					}
+
+					first -= 1;
+					last += 1;
+				}
+			}
+
+			if (a != degree)
+			{
+				kind += ph - oldr;
+			}
+
+			for (int j = lbz; j <= rbz; j++)
+			{
+				for (int l = 0; l < lanes; l++)
+				{
+					result[cind * resultPointStride + l * resultLaneStride] = ebpts[j * lanes + l];
+				}
+				cind++;
+			}
+
+			if (b < m)
+			{
+				for (int l = 0; l < lanes; l++)
+				{
+					for (int j = 0; j < r; j++)
+					{
+						bpts[j * lanes + l] = nextbpts[j * lanes + l];
+					}
+					for (int j = r; j <= degree; j++)
+					{
+						bpts[j * lanes + l] = controlPoints[(b - degree + j) * pointStride + l * laneStride];
+					}
+				}
+				a = b;
+				b = b + 1;
+				ua = ub;
+			}
+		}
+	}
+
+	/// <summary>
+	/// Elevates the lanes of block taskIndex, blocks of lanes are independent.
+	/// </summary>
+	struct LaneElevationTask : public ParallelTask
+	{
+		int Degree;
+		const std::vector<double>& KnotVector;
+		int Times;
+		const std::vector<std::vector<double>>& Bezalfs;
+		const std::vector<double>& UpdatedKnotVector;
+		const XYZW* ControlPoints;
+		int PointStride;
+		int LaneStride;
+		int Lanes;
+		XYZW* Result;
+		int ResultPointStride;
+		int ResultLaneStride;
+
+		LaneElevationTask(int degree, const std::vector<double>& knotVector, int times, const std::vector<std::vector<double>>& bezalfs, const std::vector<double>& updatedKnotVector,
+			const XYZW* controlPoints, int pointStride, int laneStride, int lanes, XYZW* result, int resultPointStride, int resultLaneStride)
+			: Degree(degree), KnotVector(knotVector), Times(times), Bezalfs(bezalfs), UpdatedKnotVector(updatedKnotVector),
+			ControlPoints(controlPoints), PointStride(pointStride), LaneStride(laneStride), Lanes(lanes), Result(result), ResultPointStride(resultPointStride), ResultLaneStride(resultLaneStride)
+		{
+		}
+
+		void operator()(int taskIndex) override
+		{
+			int first = taskIndex * ElevationLaneBlockSize;
+			int count = std::min(ElevationLaneBlockSize, Lanes - first);
+			ElevateDegreeOfLanes(Degree, KnotVector, Times, Bezalfs, UpdatedKnotVector, ControlPoints + first * LaneStride, PointStride, LaneStride, count, Result + first * ResultLaneStride, ResultPointStride, ResultLaneStride);
+		}
+	};
+
+	/// <summary>
+	/// Brings sections to their maximum degree and the union of their knot vectors, one task per section.
+	/// The inserted knots of every section are computed up front, so both batches only write their own section.
+	/// </summary>
+	int MakeSectionsCompatible(const std::vector<LN_NurbsCurve>& sections, bool isReparametrized, std::vector<LN_NurbsCurve>& result, ParallelExecutor* executor, const CancellationToken* cancellation)
+	{
+		int size = sections.size();
+		int degree = 0;
+		for (int k = 0; k < size; k++)
+		{
+			degree = std::max(degree, sections[k].Degree);
+		}
+
+		result.resize(size);
+		SectionElevationTask elevation(sections, degree, isReparametrized, result, cancellation);
+		Parallel::For(size, elevation, executor);
+
+		std::vector<std::vector<double>> knotVectors(size);
+		for (int k = 0; k < size; k++)
+		{
+			knotVectors[k] = result[k].KnotVector;
+		}
+		std::vector<std::vector<double>> insertElements = KnotVectorUtils::GetInsertedKnotElements(knotVectors);
+		SectionRefinementTask refinement(insertElements, result, cancellation);
+		Parallel::For(size, refinement, executor);
+		return degree;
+	}
+
+	/// <summary>
+	/// Moves profile k to the path point of its evenly spaced parameter, as CreateSweepSurface places it.
+	/// </summary>
+	struct SweepSectionTask : public ParallelTask
+	{
+		const LN_NurbsCurve& Path;
+		const std::vector<LN_NurbsCurve>& Profiles;
+		double PathMin;
+		double Delta;
+		std::vector<LN_NurbsCurve>& Sections;
+
+		SweepSectionTask(const LN_NurbsCurve& path, const std::vector<LN_NurbsCurve>& profiles, double pathMin, double delta, std::vector<LN_NurbsCurve>& sections)
+			: Path(path), Profiles(profiles), PathMin(pathMin), Delta(delta), Sections(sections)
+		{
+		}
+
+		void operator()(int taskIndex) override
+		{
+			const LN_NurbsCurve& profile = Profiles[taskIndex];
+			double param = PathMin + taskIndex * Delta;
+			XYZ point = NurbsCurve::GetPointOnCurve(Path, param);
+			std::vector<XYZ> ders = NurbsCurve::ComputeRationalCurveDerivatives(profile, 1, param);
+			XYZ tangent = ders[1];
+			Matrix4d transform = Matrix4d::CreateTranslation(point);
+			if (!tangent.IsZero())
+			{
+				XYZ binormal = NurbsCurve::Normal(profile, CurveNormal::Binormal, param);
+				double rad = binormal.AngleTo(tangent);
+				Matrix4d rotation = Matrix4d::CreateRotationAtPoint(point, binormal, rad);
+				transform = transform.Multiply(rotation);
+			}
+			Sections[taskIndex] = NurbsCurve::CreateTransformed(profile, transform);
 		}
-		return ind;
-	}
+	};
 }
 
-void  LNLib::NurbsSurface::Check(const LN_NurbsSurface& surface)
+LNLib::LN_CheckedNurbsSurface LNLib::NurbsSurface::Check(const LN_NurbsSurface& surface)
 {
 	int degreeU = surface.DegreeU;
 	int degreeV = surface.DegreeV;
-	std::vector<double> knotVectorU = surface.KnotVectorU;
-	std::vector<double> knotVectorV = surface.KnotVectorV;
-	std::vector<std::vector<XYZW>> controlPoints = surface.ControlPoints;
+	const std::vector<double>& knotVectorU = surface.KnotVectorU;
+	const std::vector<double>& knotVectorV = surface.KnotVectorV;
+	const std::vector<std::vector<XYZW>>& controlPoints = surface.ControlPoints;
 
 	VALIDATE_ARGUMENT(degreeU > 0, "degreeU", "Degree must greater than zero.");
 	VALIDATE_ARGUMENT(degreeV > 0, "degreeU", "Degree must greater than zero.");
@@ -105,98 +1914,357 @@ void  LNLib::NurbsSurface::Check(const LN_NurbsSurface& surface)
 	VALIDATE_ARGUMENT(controlPoints.size() > 0, "controlPoints", "ControlPoints must contains one point at least.");
 	VALIDATE_ARGUMENT(ValidationUtils::IsValidNurbs(degreeU, knotVectorU.size(), controlPoints.size()), "controlPoints", "Arguments must fit: m = n + p + 1");
 	VALIDATE_ARGUMENT(ValidationUtils::IsValidNurbs(degreeV, knotVectorV.size(), controlPoints[0].size()), "controlPoints", "Arguments must fit: m = n + p + 1");
+
+	return LN_CheckedNurbsSurface(surface, !HasUnitSurfaceWeights(controlPoints));
+}
+
+void LNLib::NurbsSurface::Check(const LN_FlatNurbsSurface& surface)
+{
+	VALIDATE_ARGUMENT(surface.DegreeU > 0, "degreeU", "Degree must greater than zero.");
+	VALIDATE_ARGUMENT(surface.DegreeV > 0, "degreeV", "Degree must greater than zero.");
+	VALIDATE_ARGUMENT(surface.KnotVectorU.size() > 0, "knotVectorU", "KnotVector size must greater than zero.");
+	VALIDATE_ARGUMENT(ValidationUtils::IsValidKnotVector(surface.KnotVectorU), "knotVectorU", "KnotVector must be a nondecreasing sequence of real numbers.");
+	VALIDATE_ARGUMENT(surface.KnotVectorV.size() > 0, "knotVectorV", "KnotVector size must greater than zero.");
+	VALIDATE_ARGUMENT(ValidationUtils::IsValidKnotVector(surface.KnotVectorV), "knotVectorV", "KnotVector must be a nondecreasing sequence of real numbers.");
+	VALIDATE_ARGUMENT(surface.ControlPoints.size() > 0, "controlPoints", "ControlPoints must contains one point at least.");
+	VALIDATE_ARGUMENT(surface.ControlPoints.size() == surface.RowCount * surface.ColumnCount, "controlPoints", "ControlPoints size must equal RowCount * ColumnCount.");
+	VALIDATE_ARGUMENT(ValidationUtils::IsValidNurbs(surface.DegreeU, surface.KnotVectorU.size(), surface.RowCount), "controlPoints", "Arguments must fit: m = n + p + 1");
+	VALIDATE_ARGUMENT(ValidationUtils::IsValidNurbs(surface.DegreeV, surface.KnotVectorV.size(), surface.ColumnCount), "controlPoints", "Arguments must fit: m = n + p + 1");
+}
+
+void LNLib::NurbsSurface::ToFlatSurface(const LN_NurbsSurface& surface, LN_FlatNurbsSurface& result)
+{
+	const std::vector<std::vector<XYZW>>& controlPoints = surface.ControlPoints;
+	int rows = controlPoints.size();
+	int columns = rows > 0 ? controlPoints[0].size() : 0;
+
+	result.DegreeU = surface.DegreeU;
+	result.DegreeV = surface.DegreeV;
+	result.KnotVectorU = surface.KnotVectorU;
+	result.KnotVectorV = surface.KnotVectorV;
+	result.RowCount = rows;
+	result.ColumnCount = columns;
+	result.ControlPoints.resize(rows * columns);
+	for (int i = 0; i < rows; i++)
+	{
+		VALIDATE_ARGUMENT(controlPoints[i].size() == columns, "controlPoints", "ControlPoints rows must have the same size.");
+		std::copy(controlPoints[i].begin(), controlPoints[i].end(), result.ControlPoints.begin() + i * columns);
+	}
+}
+
+void LNLib::NurbsSurface::ToNestedSurface(const LN_FlatNurbsSurface& surface, LN_NurbsSurface& result)
+{
+	int rows = surface.RowCount;
+	int columns = surface.ColumnCount;
+	VALIDATE_ARGUMENT(surface.ControlPoints.size() == rows * columns, "controlPoints", "ControlPoints size must equal RowCount * ColumnCount.");
+
+	result.DegreeU = surface.DegreeU;
+	result.DegreeV = surface.DegreeV;
+	result.KnotVectorU = surface.KnotVectorU;
+	result.KnotVectorV = surface.KnotVectorV;
+	result.ControlPoints.resize(rows);
+	for (int i = 0; i < rows; i++)
+	{
+		std::vector<XYZW>::const_iterator first = surface.ControlPoints.begin() + i * columns;
+		result.ControlPoints[i].assign(first, first + columns);
+	}
 }
 
 LNLib::XYZ LNLib::NurbsSurface::GetPointOnSurface(const LN_NurbsSurface& surface, UV uv)
 {
-	int degreeU = surface.DegreeU;
-	int degreeV = surface.DegreeV;
-	std::vector<double> knotVectorU = surface.KnotVectorU;
-	std::vector<double> knotVectorV = surface.KnotVectorV;
-	std::vector<std::vector<XYZW>> controlPoints = surface.ControlPoints;
+	LNLIB_COUNT(Evaluations, 1);
+	const std::vector<double>& knotVectorU = surface.KnotVectorU;
+	const std::vector<double>& knotVectorV = surface.KnotVectorV;
 
 	VALIDATE_ARGUMENT_RANGE(uv.GetU(), knotVectorU[0], knotVectorU[knotVectorU.size() - 1]);
 	VALIDATE_ARGUMENT_RANGE(uv.GetV(), knotVectorV[0], knotVectorV[knotVectorV.size() - 1]);
 
-	LN_BsplineSurface<XYZW> bsplineSurface;
-	bsplineSurface.DegreeU = degreeU;
-	bsplineSurface.DegreeV = degreeV;
-	bsplineSurface.KnotVectorU = knotVectorU;
-	bsplineSurface.KnotVectorV = knotVectorV;
-	bsplineSurface.ControlPoints = controlPoints;
+	int uSpanIndex = Polynomials::GetKnotSpanIndex(surface.DegreeU, knotVectorU, uv.GetU());
+	int vSpanIndex = Polynomials::GetKnotSpanIndex(surface.DegreeV, knotVectorV, uv.GetV());
+	bool isRational = !HasUnitSpanSurfaceWeights(surface, uSpanIndex, vSpanIndex);
+	return GetPointOnSurfaceAtSpan(surface, uSpanIndex, vSpanIndex, uv, isRational);
+}
 
-	XYZW result = BsplineSurface::GetPointOnSurface(bsplineSurface, uv);
-	return result.ToXYZ(true);
+LNLib::XYZ LNLib::NurbsSurface::GetPointOnSurface(const LN_CheckedNurbsSurface& surface, UV uv)
+{
+	LNLIB_COUNT(Evaluations, 1);
+	const LN_NurbsSurface& nurbsSurface = surface.Surface();
+	int uSpanIndex = Polynomials::GetKnotSpanIndex(nurbsSurface.DegreeU, nurbsSurface.KnotVectorU, uv.GetU(), nurbsSurface.ControlPoints.size() - 1);
+	int vSpanIndex = Polynomials::GetKnotSpanIndex(nurbsSurface.DegreeV, nurbsSurface.KnotVectorV, uv.GetV(), nurbsSurface.ControlPoints[0].size() - 1);
+	return GetPointOnSurfaceAtSpan(nurbsSurface, uSpanIndex, vSpanIndex, uv, surface.IsRational());
 }
 
 
-std::vector<std::vector<LNLib::XYZ>> LNLib::NurbsSurface::ComputeRationalSurfaceDerivatives(const LN_NurbsSurface& surface, int derivative, UV uv)
+LNLib::XYZ LNLib::NurbsSurface::GetPointOnSurface(const LN_FlatNurbsSurface& surface, UV uv)
 {
 	int degreeU = surface.DegreeU;
 	int degreeV = surface.DegreeV;
-	std::vector<double> knotVectorU = surface.KnotVectorU;
-	std::vector<double> knotVectorV = surface.KnotVectorV;
-	std::vector<std::vector<XYZW>> controlPoints = surface.ControlPoints;
+	const std::vector<double>& knotVectorU = surface.KnotVectorU;
+	const std::vector<double>& knotVectorV = surface.KnotVectorV;
+	int columns = surface.ColumnCount;
 
-	VALIDATE_ARGUMENT(derivative > 0, "derivative", "derivative must greater than zero.");
 	VALIDATE_ARGUMENT_RANGE(uv.GetU(), knotVectorU[0], knotVectorU[knotVectorU.size() - 1]);
 	VALIDATE_ARGUMENT_RANGE(uv.GetV(), knotVectorV[0], knotVectorV[knotVectorV.size() - 1]);
 
-	std::vector<std::vector<XYZ>> derivatives(derivative + 1, std::vector<XYZ>(derivative + 1));
+	double stackNu[Constants::MaxStackBasisSize];
+	double stackNv[Constants::MaxStackBasisSize];
+	std::vector<double> heapNu;
+	std::vector<double> heapNv;
+	double* Nu = stackNu;
+	double* Nv = stackNv;
+	if (degreeU >= Constants::MaxStackBasisSize)
+	{
+		heapNu.resize(degreeU + 1);
+		Nu = heapNu.data();
+	}
+	if (degreeV >= Constants::MaxStackBasisSize)
+	{
+		heapNv.resize(degreeV + 1);
+		Nv = heapNv.data();
+	}
+
+	int uSpanIndex = Polynomials::GetKnotSpanIndex(degreeU, knotVectorU, uv.GetU());
+	Polynomials::BasisFunctions(uSpanIndex, degreeU, knotVectorU, uv.GetU(), Nu);
+	int vSpanIndex = Polynomials::GetKnotSpanIndex(degreeV, knotVectorV, uv.GetV());
+	Polynomials::BasisFunctions(vSpanIndex, degreeV, knotVectorV, uv.GetV(), Nv);
+
+	const XYZW* first = &surface.ControlPoints[(uSpanIndex - degreeU) * columns + vSpanIndex - degreeV];
+	XYZW point;
+	for (int k = 0; k <= degreeU; k++)
+	{
+		const XYZW* row = first + k * columns;
+		XYZW temp;
+		for (int l = 0; l <= degreeV; l++)
+		{
+			temp += Nv[l] * row[l];
+		}
+		point += Nu[k] * temp;
+	}
+	return point.ToXYZ(true);
+}
+
+LNLib::XYZ LNLib::NurbsSurface::GetPointOnSurface(const LN_StoredNurbsSurface& surface, UV uv)
+{
+	int degreeU = surface.DegreeU;
+	int degreeV = surface.DegreeV;
+	const double* knotVectorU = surface.KnotVectorU;
+	const double* knotVectorV = surface.KnotVectorV;
+	int columns = surface.Columns;
+
+	VALIDATE_ARGUMENT_RANGE(uv.GetU(), knotVectorU[0], knotVectorU[surface.KnotCountU - 1]);
+	VALIDATE_ARGUMENT_RANGE(uv.GetV(), knotVectorV[0], knotVectorV[surface.KnotCountV - 1]);
+
+	double stackNu[Constants::MaxStackBasisSize];
+	double stackNv[Constants::MaxStackBasisSize];
+	std::vector<double> heapNu;
+	std::vector<double> heapNv;
+	double* Nu = stackNu;
+	double* Nv = stackNv;
+	if (degreeU >= Constants::MaxStackBasisSize)
+	{
+		heapNu.resize(degreeU + 1);
+		Nu = heapNu.data();
+	}
+	if (degreeV >= Constants::MaxStackBasisSize)
+	{
+		heapNv.resize(degreeV + 1);
+		Nv = heapNv.data();
+	}
 
-	LN_BsplineSurface<XYZW> bsplineSurface;
-	bsplineSurface.DegreeU = degreeU;
-	bsplineSurface.DegreeV = degreeV;
-	bsplineSurface.KnotVectorU = knotVectorU;
-	bsplineSurface.KnotVectorV = knotVectorV;
-	bsplineSurface.ControlPoints = controlPoints;
+	int uSpanIndex = Polynomials::GetKnotSpanIndex(degreeU, knotVectorU, surface.KnotCountU, uv.GetU());
+	Polynomials::BasisFunctions(uSpanIndex, degreeU, knotVectorU, uv.GetU(), Nu);
+	int vSpanIndex = Polynomials::GetKnotSpanIndex(degreeV, knotVectorV, surface.KnotCountV, uv.GetV());
+	Polynomials::BasisFunctions(vSpanIndex, degreeV, knotVectorV, uv.GetV(), Nv);
 
-	std::vector<std::vector<XYZW>> ders = BsplineSurface::ComputeDerivatives(bsplineSurface, derivative, uv);
-	std::vector<std::vector<XYZ>> Aders(derivative + 1, std::vector<XYZ>(derivative + 1));
-	std::vector<std::vector<double>> wders(derivative + 1, std::vector<double>(derivative + 1));
-	for (int i = 0; i < ders.size(); i++)
+	const XYZW* first = surface.ControlPoints + (uSpanIndex - degreeU) * columns + vSpanIndex - degreeV;
+	XYZW point;
+	for (int k = 0; k <= degreeU; k++)
 	{
-		for (int j = 0; j < ders[0].size(); j++)
+		const XYZW* row = first + k * columns;
+		XYZW temp;
+		for (int l = 0; l <= degreeV; l++)
 		{
-			Aders[i][j] = ders[i][j].ToXYZ(false);
-			wders[i][j] = ders[i][j].GetW();
+			temp += Nv[l] * row[l];
 		}
+		point += Nu[k] * temp;
 	}
+	return point.ToXYZ(true);
+}
+
+void LNLib::NurbsSurface::EvaluateGrid(const LN_NurbsSurface& surface, const std::vector<double>& uParams, const std::vector<double>& vParams, std::vector<std::vector<XYZ>>& points)
+{
+	LN_CheckedNurbsSurface checkedSurface = Check(surface);
+	ValidateGridParams(surface, uParams, vParams);
+	EvaluateGrid(checkedSurface, uParams, vParams, points);
+}
+
+void LNLib::NurbsSurface::EvaluateGrid(const LN_CheckedNurbsSurface& surface, const std::vector<double>& uParams, const std::vector<double>& vParams, std::vector<std::vector<XYZ>>& points)
+{
+	LN_ControlPointArrays arrays;
+	ControlPointsUtils::ToArrays(surface.Surface().ControlPoints, arrays);
+	EvaluateGridOnArrays(surface, arrays, uParams, vParams, points);
+}
+
+void LNLib::NurbsSurface::EvaluateNormalGrid(const LN_NurbsSurface& surface, const std::vector<double>& uParams, const std::vector<double>& vParams, std::vector<std::vector<XYZ>>& points, std::vector<std::vector<XYZ>>& normals)
+{
+	LN_CheckedNurbsSurface checkedSurface = Check(surface);
+	ValidateGridParams(surface, uParams, vParams);
+	EvaluateNormalGrid(checkedSurface, uParams, vParams, points, normals);
+}
 
-	for (int k = 0; k <= derivative; k++)
+void LNLib::NurbsSurface::EvaluateNormalGrid(const LN_CheckedNurbsSurface& surface, const std::vector<double>& uParams, const std::vector<double>& vParams, std::vector<std::vector<XYZ>>& points, std::vector<std::vector<XYZ>>& normals)
+{
+	LNLIB_COUNT(Evaluations, uParams.size() * vParams.size());
+	const LN_NurbsSurface& nurbsSurface = surface.Surface();
+	int degreeU = nurbsSurface.DegreeU;
+	int degreeV = nurbsSurface.DegreeV;
+	const std::vector<double>& knotVectorU = nurbsSurface.KnotVectorU;
+	const std::vector<double>& knotVectorV = nurbsSurface.KnotVectorV;
+	const std::vector<std::vector<XYZW>>& controlPoints = nurbsSurface.ControlPoints;
+
+	int rows = uParams.size();
+	int columns = vParams.size();
+
+	// Basis functions and first derivatives, kth derivative of row i at Nu[(2 * i + k) * (degreeU + 1)].
+	std::vector<int> spansU;
+	std::vector<int> spansV;
+	std::vector<double> Nu;
+	std::vector<double> Nv;
+	ComputeGridBasis(degreeU, knotVectorU, uParams, 1, spansU, Nu);
+	ComputeGridBasis(degreeV, knotVectorV, vParams, 1, spansV, Nv);
+
+	// Contract U basis and its derivative once per row into isoparametric curves Cw(v) and Cw_u(v).
+	int netColumns = controlPoints[0].size();
+	std::vector<XYZW> curve(netColumns);
+	std::vector<XYZW> curveU(netColumns);
+	bool isRational = surface.IsRational();
+
+	points.resize(rows);
+	normals.resize(rows);
+	for (int i = 0; i < rows; i++)
 	{
-		for (int l = 0; l <= derivative - k; l++)
+		points[i].resize(columns);
+		normals[i].resize(columns);
+		int uind = spansU[i] - degreeU;
+		const double* nu = &Nu[2 * i * (degreeU + 1)];
+		const double* du = nu + degreeU + 1;
+
+		std::fill(curve.begin(), curve.end(), XYZW(0, 0, 0, 0));
+		std::fill(curveU.begin(), curveU.end(), XYZW(0, 0, 0, 0));
+		for (int k = 0; k <= degreeU; k++)
 		{
-			XYZ v = Aders[k][l];
-			for (int j = 1; j <= l; j++)
+			const std::vector<XYZW>& row = controlPoints[uind + k];
+			for (int c = 0; c < netColumns; c++)
 			{
-				v = v - MathUtils::Binomial(l, j) * wders[0][j] * derivatives[k][l - j];
+				curve[c] += nu[k] * row[c];
+				curveU[c] += du[k] * row[c];
 			}
+		}
 
-			for (int i = 1; i <= k; i++)
+		for (int j = 0; j < columns; j++)
+		{
+			int vind = spansV[j] - degreeV;
+			const double* nv = &Nv[2 * j * (degreeV + 1)];
+			const double* dv = nv + degreeV + 1;
+
+			XYZW sw(0, 0, 0, 0);
+			XYZW swu(0, 0, 0, 0);
+			XYZW swv(0, 0, 0, 0);
+			for (int l = 0; l <= degreeV; l++)
 			{
-				v = v - MathUtils::Binomial(k, i) * wders[i][0] * derivatives[k - i][l];
+				sw += nv[l] * curve[vind + l];
+				swu += nv[l] * curveU[vind + l];
+				swv += dv[l] * curve[vind + l];
+			}
 
-				XYZ v2 = XYZ(0, 0, 0);
-				for (int j = 1; j <= l; j++)
-				{
-					v2 = v2 + MathUtils::Binomial(l, j) * wders[i][j] * derivatives[k - i][l - j];
-				}
-				v = v - MathUtils::Binomial(k, i) * v2;
+			if (!isRational)
+			{
+				points[i][j] = sw.ToXYZ(false);
+				normals[i][j] = swu.ToXYZ(false).CrossProduct(swv.ToXYZ(false)).Normalize();
+				continue;
 			}
-			derivatives[k][l] = v / wders[0][0];
+
+			double w = sw.GetW();
+			XYZ point = sw.ToXYZ(true);
+			XYZ su = (XYZ(swu.GetWX(), swu.GetWY(), swu.GetWZ()) - swu.GetW() * point) / w;
+			XYZ sv = (XYZ(swv.GetWX(), swv.GetWY(), swv.GetWZ()) - swv.GetW() * point) / w;
+			points[i][j] = point;
+			normals[i][j] = su.CrossProduct(sv).Normalize();
 		}
 	}
-	return derivatives;
+}
+
+std::vector<std::vector<LNLib::XYZ>> LNLib::NurbsSurface::ComputeRationalSurfaceDerivatives(const LN_NurbsSurface& surface, int derivative, UV uv)
+{
+	LNLIB_COUNT(Evaluations, 1);
+	const std::vector<double>& knotVectorU = surface.KnotVectorU;
+	const std::vector<double>& knotVectorV = surface.KnotVectorV;
+
+	VALIDATE_ARGUMENT(derivative > 0, "derivative", "derivative must greater than zero.");
+	VALIDATE_ARGUMENT_RANGE(uv.GetU(), knotVectorU[0], knotVectorU[knotVectorU.size() - 1]);
+	VALIDATE_ARGUMENT_RANGE(uv.GetV(), knotVectorV[0], knotVectorV[knotVectorV.size() - 1]);
+
+	int uSpanIndex = Polynomials::GetKnotSpanIndex(surface.DegreeU, knotVectorU, uv.GetU());
+	int vSpanIndex = Polynomials::GetKnotSpanIndex(surface.DegreeV, knotVectorV, uv.GetV());
+	bool isRational = !HasUnitSpanSurfaceWeights(surface, uSpanIndex, vSpanIndex);
+	return ComputeSurfaceDerivativesAtSpan(surface, derivative, uSpanIndex, vSpanIndex, uv, isRational);
+}
+
+std::vector<std::vector<LNLib::XYZ>> LNLib::NurbsSurface::ComputeRationalSurfaceDerivatives(const LN_CheckedNurbsSurface& surface, int derivative, UV uv)
+{
+	LNLIB_COUNT(Evaluations, 1);
+	const LN_NurbsSurface& nurbsSurface = surface.Surface();
+	int uSpanIndex = Polynomials::GetKnotSpanIndex(nurbsSurface.DegreeU, nurbsSurface.KnotVectorU, uv.GetU(), nurbsSurface.ControlPoints.size() - 1);
+	int vSpanIndex = Polynomials::GetKnotSpanIndex(nurbsSurface.DegreeV, nurbsSurface.KnotVectorV, uv.GetV(), nurbsSurface.ControlPoints[0].size() - 1);
+	return ComputeSurfaceDerivativesAtSpan(nurbsSurface, derivative, uSpanIndex, vSpanIndex, uv, surface.IsRational());
+}
+
+LNLib::EvaluationStatus LNLib::NurbsSurface::TryGetPointOnSurface(const LN_CheckedNurbsSurface& surface, UV uv, XYZ& point, ParameterRangePolicy policy) noexcept
+{
+	const std::vector<double>& knotVectorU = surface.Surface().KnotVectorU;
+	const std::vector<double>& knotVectorV = surface.Surface().KnotVectorV;
+	double u = uv.GetU();
+	double v = uv.GetV();
+	EvaluationStatus status = ValidationUtils::ResolveParameter(u, knotVectorU[0], knotVectorU[knotVectorU.size() - 1], policy);
+	if (status == EvaluationStatus::Success)
+	{
+		status = ValidationUtils::ResolveParameter(v, knotVectorV[0], knotVectorV[knotVectorV.size() - 1], policy);
+	}
+	if (status != EvaluationStatus::Success)
+	{
+		return status;
+	}
+	point = GetPointOnSurface(surface, UV(u, v));
+	return EvaluationStatus::Success;
+}
+
+LNLib::EvaluationStatus LNLib::NurbsSurface::TryComputeRationalSurfaceDerivatives(const LN_CheckedNurbsSurface& surface, int derivative, UV uv, std::vector<std::vector<XYZ>>& derivatives, ParameterRangePolicy policy) noexcept
+{
+	if (derivative <= 0)
+	{
+		return EvaluationStatus::InvalidArgument;
+	}
+	const std::vector<double>& knotVectorU = surface.Surface().KnotVectorU;
+	const std::vector<double>& knotVectorV = surface.Surface().KnotVectorV;
+	double u = uv.GetU();
+	double v = uv.GetV();
+	EvaluationStatus status = ValidationUtils::ResolveParameter(u, knotVectorU[0], knotVectorU[knotVectorU.size() - 1], policy);
+	if (status == EvaluationStatus::Success)
+	{
+		status = ValidationUtils::ResolveParameter(v, knotVectorV[0], knotVectorV[knotVectorV.size() - 1], policy);
+	}
+	if (status != EvaluationStatus::Success)
+	{
+		return status;
+	}
+	derivatives = ComputeRationalSurfaceDerivatives(surface, derivative, UV(u, v));
+	return EvaluationStatus::Success;
 }
 
 double LNLib::NurbsSurface::Curvature(const LN_NurbsSurface& surface, SurfaceCurvature curvature, UV uv)
 {
-	int degreeU = surface.DegreeU;
-	int degreeV = surface.DegreeV;
-	std::vector<double> knotVectorU = surface.KnotVectorU;
-	std::vector<double> knotVectorV = surface.KnotVectorV;
-	std::vector<std::vector<XYZW>> controlPoints = surface.ControlPoints;
+	const std::vector<double>& knotVectorU = surface.KnotVectorU;
+	const std::vector<double>& knotVectorV = surface.KnotVectorV;
 
 	VALIDATE_ARGUMENT_RANGE(uv.GetU(), knotVectorU[0], knotVectorU[knotVectorU.size() - 1]);
 	VALIDATE_ARGUMENT_RANGE(uv.GetV(), knotVectorV[0], knotVectorV[knotVectorV.size() - 1]);
@@ -256,13 +2324,30 @@ double LNLib::NurbsSurface::Curvature(const LN_NurbsSurface& surface, SurfaceCur
 	return 0.0;
 }
 
+void LNLib::NurbsSurface::EvaluateCurvatureGrid(const LN_NurbsSurface& surface, const std::vector<double>& uParams, const std::vector<double>& vParams, std::vector<std::vector<LN_SurfaceCurvature>>& curvatures, ParallelExecutor* executor)
+{
+	Check(surface);
+
+	const std::vector<double>& knotVectorU = surface.KnotVectorU;
+	const std::vector<double>& knotVectorV = surface.KnotVectorV;
+	for (int i = 0; i < uParams.size(); i++)
+	{
+		VALIDATE_ARGUMENT_RANGE(uParams[i], knotVectorU[0], knotVectorU[knotVectorU.size() - 1]);
+	}
+	for (int j = 0; j < vParams.size(); j++)
+	{
+		VALIDATE_ARGUMENT_RANGE(vParams[j], knotVectorV[0], knotVectorV[knotVectorV.size() - 1]);
+	}
+
+	curvatures.resize(uParams.size());
+	CurvatureGridTask task(surface, uParams, vParams, curvatures);
+	Parallel::For(task.GetTaskCount(), task, executor);
+}
+
 LNLib::XYZ LNLib::NurbsSurface::Normal(const LN_NurbsSurface& surface, UV uv)
 {
-	int degreeU = surface.DegreeU;
-	int degreeV = surface.DegreeV;
-	std::vector<double> knotVectorU = surface.KnotVectorU;
-	std::vector<double> knotVectorV = surface.KnotVectorV;
-	std::vector<std::vector<XYZW>> controlPoints = surface.ControlPoints;
+	const std::vector<double>& knotVectorU = surface.KnotVectorU;
+	const std::vector<double>& knotVectorV = surface.KnotVectorV;
 
 	VALIDATE_ARGUMENT_RANGE(uv.GetU(), knotVectorU[0], knotVectorU[knotVectorU.size() - 1]);
 	VALIDATE_ARGUMENT_RANGE(uv.GetV(), knotVectorV[0], knotVectorV[knotVectorV.size() - 1]);
@@ -288,105 +2373,76 @@ void LNLib::NurbsSurface::Swap(const LN_NurbsSurface& surface, LN_NurbsSurface&
 	result.ControlPoints = transposedControlPoints;
 }
 
+LNLib::LN_NurbsSurface LNLib::NurbsSurface::Swap(const LN_NurbsSurface& surface)
+{
+	LN_NurbsSurface result;
+	Swap(surface, result);
+	return result;
+}
+
 void LNLib::NurbsSurface::Reverse(const LN_NurbsSurface& surface, SurfaceDirection direction, LN_NurbsSurface& result)
 {
-	int degreeU = surface.DegreeU;
-	int degreeV = surface.DegreeV;
-	std::vector<double> knotVectorU = surface.KnotVectorU;
-	std::vector<double> knotVectorV = surface.KnotVectorV;
-	std::vector<std::vector<XYZW>> controlPoints = surface.ControlPoints;
+	result = surface;
+	result = Reverse(std::move(result), direction);
+}
 
-	result.DegreeU = degreeU;
-	result.DegreeV = degreeV;
+LNLib::LN_NurbsSurface LNLib::NurbsSurface::Reverse(const LN_NurbsSurface& surface, SurfaceDirection direction)
+{
+	return Reverse(LN_NurbsSurface(surface), direction);
+}
 
+LNLib::LN_NurbsSurface LNLib::NurbsSurface::Reverse(LN_NurbsSurface&& surface, SurfaceDirection direction)
+{
+	std::vector<std::vector<XYZW>>& controlPoints = surface.ControlPoints;
 	if (direction == SurfaceDirection::All || direction == SurfaceDirection::UDirection)
 	{
-		int size = knotVectorU.size();
-		std::vector<double> reversedKnotVectorU(size);
-		double min = knotVectorU[0];
-		double max = knotVectorU[size - 1];
-		reversedKnotVectorU[0] = min;
-		for (int i = 1; i < size; i++)
-		{
-			reversedKnotVectorU[i] = reversedKnotVectorU[i - 1] + (knotVectorU[size - i] - knotVectorU[size - i - 1]);
-		}
-		result.KnotVectorU = reversedKnotVectorU;
+		ReverseSurfaceKnotVector(surface.KnotVectorU);
+		std::reverse(controlPoints.begin(), controlPoints.end());
 	}
-
 	if (direction == SurfaceDirection::All || direction == SurfaceDirection::VDirection)
 	{
-		int size = knotVectorV.size();
-		std::vector<double> reversedKnotVectorV(size);
-		double min = knotVectorV[0];
-		double max = knotVectorV[size - 1];
-		reversedKnotVectorV[0] = min;
-		for (int i = 1; i < size; i++)
-		{
-			reversedKnotVectorV[i] = reversedKnotVectorV[i - 1] + (knotVectorV[size - i] - knotVectorV[size - i - 1]);
-		}
-		result.KnotVectorV = reversedKnotVectorV;
-	}
-
-	if (direction == SurfaceDirection::UDirection)
-	{
-		int row = controlPoints.size();
-		int column = controlPoints[0].size();
-
-		for (int i = 0; i < column; i++) {
-			int start = 0;
-			int end = row - 1;
-			while (start < end) {
-				std::swap(controlPoints[start][i], controlPoints[end][i]);
-				start++;
-				end--;
-			}
-		}
-		result.ControlPoints = controlPoints;
-	}
-	else if (direction == SurfaceDirection::VDirection)
-	{
-		int size = controlPoints.size();
-		std::vector<std::vector<XYZW>> newControlPoints(size);
-		for (int i = 0; i < size; i++)
+		ReverseSurfaceKnotVector(surface.KnotVectorV);
+		for (int i = 0; i < controlPoints.size(); i++)
 		{
 			std::reverse(controlPoints[i].begin(), controlPoints[i].end());
-			newControlPoints.emplace_back(controlPoints[i]);
 		}
-		result.ControlPoints = newControlPoints;
-	}
-	else
-	{
-		std::reverse(controlPoints.begin(), controlPoints.end());
-		result.ControlPoints = controlPoints;
 	}
-
+	return std::move(surface);
 }
 
 void LNLib::NurbsSurface::InsertKnot(const LN_NurbsSurface& surface, double insertKnot, int times, bool isUDirection, LN_NurbsSurface& result)
 {
-	int degreeU = surface.DegreeU;
-	int degreeV = surface.DegreeV;
-	std::vector<double> knotVectorU = surface.KnotVectorU;
-	std::vector<double> knotVectorV = surface.KnotVectorV;
-	std::vector<std::vector<XYZW>> controlPoints = surface.ControlPoints;
+	result = surface;
+	InsertKnot(result, insertKnot, times, isUDirection);
+}
 
+void LNLib::NurbsSurface::InsertKnot(LN_NurbsSurface&& surface, double insertKnot, int times, bool isUDirection, LN_NurbsSurface& result)
+{
+	result = std::move(surface);
+	InsertKnot(result, insertKnot, times, isUDirection);
+}
+
+void LNLib::NurbsSurface::InsertKnot(LN_NurbsSurface& surface, double insertKnot, int times, bool isUDirection)
+{
+	std::vector<std::vector<XYZW>>& controlPoints = surface.ControlPoints;
+
+	VALIDATE_ARGUMENT(controlPoints.size() > 0, "controlPoints", "ControlPoints must contain one point at least.");
 	if (isUDirection)
 	{
-		VALIDATE_ARGUMENT(ValidationUtils::IsValidNurbs(degreeU, knotVectorU.size(), controlPoints.size()), "controlPoints", "Arguments must fit: m = n + p + 1");
+		VALIDATE_ARGUMENT(ValidationUtils::IsValidNurbs(surface.DegreeU, surface.KnotVectorU.size(), controlPoints.size()), "controlPoints", "Arguments must fit: m = n + p + 1");
 	}
 	else
 	{
-		VALIDATE_ARGUMENT(ValidationUtils::IsValidNurbs(degreeV, knotVectorV.size(), controlPoints[0].size()), "controlPoints", "Arguments must fit: m = n + p + 1");
+		VALIDATE_ARGUMENT(ValidationUtils::IsValidNurbs(surface.DegreeV, surface.KnotVectorV.size(), controlPoints[0].size()), "controlPoints", "Arguments must fit: m = n + p + 1");
 	}
 
 	int degree = isUDirection ? surface.DegreeU : surface.DegreeV;
-	std::vector<double> knotVector = isUDirection ? surface.KnotVectorU : surface.KnotVectorV;
+	std::vector<double>& knotVector = isUDirection ? surface.KnotVectorU : surface.KnotVectorV;
 	int knotSpanIndex = Polynomials::GetKnotSpanIndex(degree, knotVector, insertKnot);
 	int multiplicity = Polynomials::GetKnotMultiplicity(knotVector, insertKnot);
 
 	if (multiplicity == degree)
 	{
-		result = surface;
 		return;
 	}
 
@@ -395,22 +2451,6 @@ void LNLib::NurbsSurface::InsertKnot(const LN_NurbsSurface& surface, double inse
 		times = degree - multiplicity;
 	}
 
-	std::vector<double> insertedKnotVector(knotVector.size() + times);
-	for (int i = 0; i <= knotSpanIndex; i++)
-	{
-		insertedKnotVector[i] = knotVector[i];
-	}
-
-	for (int i = 1; i <= times; i++)
-	{
-		insertedKnotVector[knotSpanIndex + i] = insertKnot;
-	}
-
-	for (int i = knotSpanIndex + 1; i < knotVector.size(); i++)
-	{
-		insertedKnotVector[i + times] = knotVector[i];
-	}
-
 	std::vector<std::vector<double>> alpha(degree - multiplicity, std::vector<double>(times + 1));
 	for (int j = 1; j <= times; j++)
 	{
@@ -421,33 +2461,44 @@ void LNLib::NurbsSurface::InsertKnot(const LN_NurbsSurface& surface, double inse
 		}
 	}
 
-	std::vector<XYZW> temp(degree + 1);
-
-	int rows = controlPoints.size();
-	int columns = controlPoints[0].size();
-
-	result = surface;
-
-	std::vector<std::vector<XYZW>> updatedControlPoints;
 	if (isUDirection)
 	{
-		updatedControlPoints.resize(rows + times, std::vector<XYZW>(columns));
-		for (int col = 0; col < columns; col++)
+		// Rows are shifted as whole vectors, only degree - multiplicity + 1 rows are copied.
+		std::vector<std::vector<XYZW>> temp(degree - multiplicity + 1);
+		for (int i = 0; i < degree - multiplicity + 1; i++)
 		{
-			for (int i = 0; i <= knotSpanIndex - degree; i++)
-			{
-				updatedControlPoints[i][col] = controlPoints[i][col];
-			}
+			temp[i] = controlPoints[knotSpanIndex - degree + i];
+		}
+		controlPoints.insert(controlPoints.begin() + (knotSpanIndex - multiplicity), times, std::vector<XYZW>());
 
-			for (int i = knotSpanIndex - multiplicity; i < rows; i++)
+		int L = 0;
+		for (int j = 1; j <= times; j++)
+		{
+			L = knotSpanIndex - degree + j;
+			for (int i = 0; i <= degree - j - multiplicity; i++)
 			{
-				updatedControlPoints[i + times][col] = controlPoints[i][col];
+				BlendControlPointRow(temp[i], temp[i + 1], 1.0 - alpha[i][j]);
 			}
+			controlPoints[L] = temp[0];
+			controlPoints[knotSpanIndex + times - j - multiplicity] = temp[degree - j - multiplicity];
+		}
 
+		for (int i = L + 1; i < knotSpanIndex - multiplicity; i++)
+		{
+			controlPoints[i] = temp[i - L];
+		}
+	}
+	else
+	{
+		std::vector<XYZW> temp(degree + 1);
+		for (int row = 0; row < controlPoints.size(); row++)
+		{
+			std::vector<XYZW>& points = controlPoints[row];
 			for (int i = 0; i < degree - multiplicity + 1; i++)
 			{
-				temp[i] = controlPoints[knotSpanIndex - degree + i][col];
+				temp[i] = points[knotSpanIndex - degree + i];
 			}
+			points.insert(points.begin() + (knotSpanIndex - multiplicity), times, XYZW());
 
 			int L = 0;
 			for (int j = 1; j <= times; j++)
@@ -458,126 +2509,230 @@ void LNLib::NurbsSurface::InsertKnot(const LN_NurbsSurface& surface, double inse
 					double a = alpha[i][j];
 					temp[i] = a * temp[i + 1] + (1.0 - a) * temp[i];
 				}
-				updatedControlPoints[L][col] = temp[0];
-				updatedControlPoints[knotSpanIndex + times - j - multiplicity][col] = temp[degree - j - multiplicity];
+				points[L] = temp[0];
+				points[knotSpanIndex + times - j - multiplicity] = temp[degree - j - multiplicity];
 			}
 
 			for (int i = L + 1; i < knotSpanIndex - multiplicity; i++)
 			{
-				updatedControlPoints[i][col] = temp[i - L];
+				points[i] = temp[i - L];
 			}
 		}
-		result.KnotVectorU = insertedKnotVector;
-		result.ControlPoints = updatedControlPoints;
 	}
-	else
+
+	knotVector.insert(knotVector.begin() + knotSpanIndex + 1, times, insertKnot);
+}
+
+void LNLib::NurbsSurface::InsertKnot(const LN_FlatNurbsSurface& surface, double insertKnot, int times, bool isUDirection, LN_FlatNurbsSurface& result)
+{
+	int rows = surface.RowCount;
+	int columns = surface.ColumnCount;
+	const std::vector<XYZW>& controlPoints = surface.ControlPoints;
+
+	VALIDATE_ARGUMENT(controlPoints.size() == rows * columns, "controlPoints", "ControlPoints size must equal RowCount * ColumnCount.");
+	if (isUDirection)
+	{
+		VALIDATE_ARGUMENT(ValidationUtils::IsValidNurbs(surface.DegreeU, surface.KnotVectorU.size(), rows), "controlPoints", "Arguments must fit: m = n + p + 1");
+	}
+	else
+	{
+		VALIDATE_ARGUMENT(ValidationUtils::IsValidNurbs(surface.DegreeV, surface.KnotVectorV.size(), columns), "controlPoints", "Arguments must fit: m = n + p + 1");
+	}
+
+	int degree = isUDirection ? surface.DegreeU : surface.DegreeV;
+	const std::vector<double>& knotVector = isUDirection ? surface.KnotVectorU : surface.KnotVectorV;
+	int knotSpanIndex = Polynomials::GetKnotSpanIndex(degree, knotVector, insertKnot);
+	int multiplicity = Polynomials::GetKnotMultiplicity(knotVector, insertKnot);
+
+	if (multiplicity == degree)
+	{
+		result = surface;
+		return;
+	}
+
+	if ((times + multiplicity) > degree)
+	{
+		times = degree - multiplicity;
+	}
+
+	std::vector<double> insertedKnotVector(knotVector.size() + times);
+	for (int i = 0; i <= knotSpanIndex; i++)
+	{
+		insertedKnotVector[i] = knotVector[i];
+	}
+
+	for (int i = 1; i <= times; i++)
+	{
+		insertedKnotVector[knotSpanIndex + i] = insertKnot;
+	}
+
+	for (int i = knotSpanIndex + 1; i < knotVector.size(); i++)
+	{
+		insertedKnotVector[i + times] = knotVector[i];
+	}
+
+	std::vector<std::vector<double>> alpha(degree - multiplicity, std::vector<double>(times + 1));
+	for (int j = 1; j <= times; j++)
+	{
+		int L = knotSpanIndex - degree + j;
+		for (int i = 0; i <= degree - j - multiplicity; i++)
+		{
+			alpha[i][j] = (insertKnot - knotVector[L + i]) / (knotVector[i + knotSpanIndex + 1] - knotVector[L + i]);
+		}
+	}
+
+	int newRows = isUDirection ? rows + times : rows;
+	int newColumns = isUDirection ? columns : columns + times;
+
+	// Every U column (or V row) is one curve of lineSize points, addressed by strides.
+	int lineCount = isUDirection ? columns : rows;
+	int lineSize = isUDirection ? rows : columns;
+	int lineStride = isUDirection ? 1 : columns;
+	int pointStride = isUDirection ? columns : 1;
+	int newLineStride = isUDirection ? 1 : newColumns;
+	int newPointStride = isUDirection ? newColumns : 1;
+
+	std::vector<XYZW> updatedControlPoints(newRows * newColumns);
+	std::vector<XYZW> temp(degree + 1);
+	for (int line = 0; line < lineCount; line++)
 	{
-		updatedControlPoints.resize(rows, std::vector<XYZW>(columns + times));
-		for (int row = 0; row < rows; row++)
+		const XYZW* source = &controlPoints[line * lineStride];
+		XYZW* target = &updatedControlPoints[line * newLineStride];
+
+		for (int i = 0; i <= knotSpanIndex - degree; i++)
 		{
-			for (int i = 0; i <= knotSpanIndex - degree; i++)
-			{
-				updatedControlPoints[row][i] = controlPoints[row][i];
-			}
+			target[i * newPointStride] = source[i * pointStride];
+		}
 
-			for (int i = knotSpanIndex - multiplicity; i < columns; i++)
-			{
-				updatedControlPoints[row][i + times] = controlPoints[row][i];
-			}
+		for (int i = knotSpanIndex - multiplicity; i < lineSize; i++)
+		{
+			target[(i + times) * newPointStride] = source[i * pointStride];
+		}
 
-			for (int i = 0; i < degree - multiplicity + 1; i++)
-			{
-				temp[i] = controlPoints[row][knotSpanIndex - degree + i];
-			}
+		for (int i = 0; i < degree - multiplicity + 1; i++)
+		{
+			temp[i] = source[(knotSpanIndex - degree + i) * pointStride];
+		}
 
-			int L = 0;
-			for (int j = 1; j <= times; j++)
+		int L = 0;
+		for (int j = 1; j <= times; j++)
+		{
+			L = knotSpanIndex - degree + j;
+			for (int i = 0; i <= degree - j - multiplicity; i++)
 			{
-				L = knotSpanIndex - degree + j;
-				for (int i = 0; i <= degree - j - multiplicity; i++)
-				{
-					double a = alpha[i][j];
-					temp[i] = a * temp[i + 1] + (1.0 - a) * temp[i];
-				}
-				updatedControlPoints[row][L] = temp[0];
-				updatedControlPoints[row][knotSpanIndex + times - j - multiplicity] = temp[degree - j - multiplicity];
+				double a = alpha[i][j];
+				temp[i] = a * temp[i + 1] + (1.0 - a) * temp[i];
 			}
+			target[L * newPointStride] = temp[0];
+			target[(knotSpanIndex + times - j - multiplicity) * newPointStride] = temp[degree - j - multiplicity];
+		}
 
-			for (int i = L + 1; i < knotSpanIndex - multiplicity; i++)
-			{
-				updatedControlPoints[row][i] = temp[i - L];
-			}
+		for (int i = L + 1; i < knotSpanIndex - multiplicity; i++)
+		{
+			target[i * newPointStride] = temp[i - L];
 		}
-		result.KnotVectorV = insertedKnotVector;
-		result.ControlPoints = updatedControlPoints;
 	}
+
+	result.DegreeU = surface.DegreeU;
+	result.DegreeV = surface.DegreeV;
+	result.KnotVectorU = isUDirection ? insertedKnotVector : surface.KnotVectorU;
+	result.KnotVectorV = isUDirection ? surface.KnotVectorV : insertedKnotVector;
+	result.RowCount = newRows;
+	result.ColumnCount = newColumns;
+	result.ControlPoints.swap(updatedControlPoints);
 }
 
 void LNLib::NurbsSurface::RefineKnotVector(const LN_NurbsSurface& surface, std::vector<double>& insertKnotElements, bool isUDirection, LN_NurbsSurface& result)
 {
-	int degreeU = surface.DegreeU;
-	int degreeV = surface.DegreeV;
-	std::vector<double> knotVectorU = surface.KnotVectorU;
-	std::vector<double> knotVectorV = surface.KnotVectorV;
-	std::vector<std::vector<XYZW>> controlPoints = surface.ControlPoints;
-
-	VALIDATE_ARGUMENT(insertKnotElements.size() > 0, "insertKnotElements", "insertKnotElements size must greater than zero.");
+	result = surface;
+	RefineKnotVector(result, insertKnotElements, isUDirection);
+}
 
-	std::vector<double> tempKnotVector;
-	std::vector<std::vector<XYZW>> tempControlPoints;
+void LNLib::NurbsSurface::RefineKnotVector(LN_NurbsSurface&& surface, std::vector<double>& insertKnotElements, bool isUDirection, LN_NurbsSurface& result)
+{
+	result = std::move(surface);
+	RefineKnotVector(result, insertKnotElements, isUDirection);
+}
 
-	result = surface;
+void LNLib::NurbsSurface::RefineKnotVector(LN_NurbsSurface& surface, const std::vector<double>& insertKnotElements, bool isUDirection)
+{
+	VALIDATE_ARGUMENT(insertKnotElements.size() > 0, "insertKnotElements", "insertKnotElements size must greater than zero.");
 
+	std::vector<std::vector<XYZW>>& controlPoints = surface.ControlPoints;
 	if (isUDirection)
 	{
-		std::vector<std::vector<XYZW>> transposedControlPoints;
-		MathUtils::Transpose(controlPoints, transposedControlPoints);
-
-		for (int i = 0; i < transposedControlPoints.size(); i++)
-		{
-			LN_NurbsCurve tc;
-			tc.Degree = degreeU;
-			tc.KnotVector = knotVectorU;
-			tc.ControlPoints = transposedControlPoints[i];
-
-			LN_NurbsCurve newtc;
-			NurbsCurve::RefineKnotVector(tc, insertKnotElements, newtc);
-			tempControlPoints.emplace_back(newtc.ControlPoints);
-			tempKnotVector = newtc.KnotVector;
-		}
-		result.KnotVectorU = tempKnotVector;
-		result.KnotVectorV = knotVectorV;
-		std::vector<std::vector<XYZW>> updatedControlPoints;
-		MathUtils::Transpose(tempControlPoints, updatedControlPoints);
-		result.ControlPoints = updatedControlPoints;
+		RefineControlPointRows(surface.DegreeU, surface.KnotVectorU, controlPoints, insertKnotElements);
 	}
 	else
 	{
+		// Each row is a V curve, swapped in and out so its buffer is refined in place.
+		LN_NurbsCurve tc;
+		tc.Degree = surface.DegreeV;
 		for (int i = 0; i < controlPoints.size(); i++)
 		{
-			LN_NurbsCurve tc;
-			tc.Degree = degreeU;
-			tc.KnotVector = knotVectorU;
-			tc.ControlPoints = controlPoints[i];
+			tc.KnotVector = surface.KnotVectorV;
+			tc.ControlPoints.swap(controlPoints[i]);
+			NurbsCurve::RefineKnotVector(tc, insertKnotElements);
+			tc.ControlPoints.swap(controlPoints[i]);
+		}
+		surface.KnotVectorV = tc.KnotVector;
+	}
+}
 
-			LN_NurbsCurve newtc;
-			NurbsCurve::RefineKnotVector(tc, insertKnotElements, newtc);
-			tempControlPoints.emplace_back(newtc.ControlPoints);
-			tempKnotVector = newtc.KnotVector;
+std::vector<LNLib::LN_NurbsSurface> LNLib::NurbsSurface::SplitAt(const LN_NurbsSurface& surface, const std::vector<double>& parameters, bool isUDirection)
+{
+	Check(surface);
+	int degree = isUDirection ? surface.DegreeU : surface.DegreeV;
+	const std::vector<double>& knotVector = isUDirection ? surface.KnotVectorU : surface.KnotVectorV;
+
+	std::vector<double> splitParameters;
+	std::vector<double> insert = KnotVectorUtils::GetSplitKnotElements(degree, knotVector, parameters, splitParameters);
+	LN_NurbsSurface refined = surface;
+	if (insert.size() > 0)
+	{
+		RefineKnotVector(refined, insert, isUDirection);
+	}
+	const std::vector<double>& refinedKnotVector = isUDirection ? refined.KnotVectorU : refined.KnotVectorV;
+	const std::vector<std::vector<XYZW>>& controlPoints = refined.ControlPoints;
+	int rows = controlPoints.size();
+
+	int count = splitParameters.size() + 1;
+	std::vector<LN_NurbsSurface> result(count);
+	int start = 0;
+	for (int i = 0; i < count; i++)
+	{
+		int end = i < count - 1 ? Polynomials::GetKnotSpanIndex(degree, refinedKnotVector, splitParameters[i]) - degree : (isUDirection ? rows : controlPoints[0].size());
+		LN_NurbsSurface& piece = result[i];
+		piece.DegreeU = refined.DegreeU;
+		piece.DegreeV = refined.DegreeV;
+		if (isUDirection)
+		{
+			piece.KnotVectorU.assign(refinedKnotVector.begin() + start, refinedKnotVector.begin() + end + degree + 1);
+			piece.KnotVectorV = refined.KnotVectorV;
+			piece.ControlPoints.assign(controlPoints.begin() + start, controlPoints.begin() + end);
 		}
-		result.KnotVectorU = knotVectorU;
-		result.KnotVectorV = tempKnotVector;
-		result.ControlPoints = tempControlPoints;
+		else
+		{
+			piece.KnotVectorU = refined.KnotVectorU;
+			piece.KnotVectorV.assign(refinedKnotVector.begin() + start, refinedKnotVector.begin() + end + degree + 1);
+			piece.ControlPoints.resize(rows);
+			for (int r = 0; r < rows; r++)
+			{
+				piece.ControlPoints[r].assign(controlPoints[r].begin() + start, controlPoints[r].begin() + end);
+			}
+		}
+		start = end;
 	}
+	return result;
 }
 
 std::vector<LNLib::LN_NurbsSurface> LNLib::NurbsSurface::DecomposeToBeziers(const LN_NurbsSurface& surface)
 {
 	int degreeU = surface.DegreeU;
 	int degreeV = surface.DegreeV;
-	std::vector<double> knotVectorU = surface.KnotVectorU;
-	std::vector<double> knotVectorV = surface.KnotVectorV;
-	std::vector<std::vector<XYZW>> controlPoints = surface.ControlPoints;
+	const std::vector<double>& knotVectorU = surface.KnotVectorU;
+	const std::vector<double>& knotVectorV = surface.KnotVectorV;
+	const std::vector<std::vector<XYZW>>& controlPoints = surface.ControlPoints;
 
 	int rows = controlPoints.size();
 	int columns = controlPoints[0].size();
@@ -603,7 +2758,7 @@ std::vector<LNLib::LN_NurbsSurface> LNLib::NurbsSurface::DecomposeToBeziers(cons
 		bezierKnotsV[i] = 1;
 	}
 
-	std::vector<LNLib::LN_NurbsSurface> tempBezierPatches(rows - degreeU);
+	std::vector<LNLib::LN_NurbsSurface> tempBezierPatches(KnotVectorUtils::GetBezierCount(degreeU, knotVectorU));
 	for (int i = 0; i < tempBezierPatches.size(); i++)
 	{
 		tempBezierPatches[i].DegreeU = degreeU;
@@ -680,7 +2835,7 @@ std::vector<LNLib::LN_NurbsSurface> LNLib::NurbsSurface::DecomposeToBeziers(cons
 		}
 	}
 
-	std::vector<LNLib::LN_NurbsSurface> bezierPatches(tempBezierPatches.size() * (columns - degreeV));
+	std::vector<LNLib::LN_NurbsSurface> bezierPatches(tempBezierPatches.size() * KnotVectorUtils::GetBezierCount(degreeV, knotVectorV));
 	for (int i = 0; i < bezierPatches.size(); i++)
 	{
 		bezierPatches[i].DegreeU = degreeU;
@@ -761,74 +2916,185 @@ std::vector<LNLib::LN_NurbsSurface> LNLib::NurbsSurface::DecomposeToBeziers(cons
 	return bezierPatches;
 }
 
-void LNLib::NurbsSurface::RemoveKnot(const LN_NurbsSurface& surface, double removeKnot, int times, bool isUDirection, LN_NurbsSurface& result)
+std::vector<std::vector<LNLib::LN_NurbsSurface>> LNLib::NurbsSurface::DecomposeToBeziers(const std::vector<LN_NurbsSurface>& surfaces, ParallelExecutor* executor)
+{
+	SurfaceDecompositionBatchFunction function;
+	function.Patches.resize(surfaces.size());
+	Parallel::ForEach(surfaces, function, executor);
+	return function.Patches;
+}
+
+void LNLib::NurbsSurface::DecomposeToBeziers(const LN_NurbsSurface& surface, LN_BezierPatchArray& patches)
 {
+	Check(surface);
 	int degreeU = surface.DegreeU;
 	int degreeV = surface.DegreeV;
-	std::vector<double> knotVectorU = surface.KnotVectorU;
-	std::vector<double> knotVectorV = surface.KnotVectorV;
-	std::vector<std::vector<XYZW>> controlPoints = surface.ControlPoints;
+	const std::vector<std::vector<XYZW>>& controlPoints = surface.ControlPoints;
+	int rows = controlPoints.size();
+	int columns = controlPoints[0].size();
+	int countU = KnotVectorUtils::GetBezierCount(degreeU, surface.KnotVectorU);
+	int countV = KnotVectorUtils::GetBezierCount(degreeV, surface.KnotVectorV);
 
-	if (isUDirection)
+	// Along U every column of the net is one lane, every row of the resulting strips is then decomposed along V.
+	std::vector<XYZW> net(rows * columns);
+	for (int i = 0; i < rows; i++)
 	{
-		VALIDATE_ARGUMENT_RANGE(removeKnot, knotVectorU[0], knotVectorU[knotVectorU.size() - 1]);
+		std::copy(controlPoints[i].begin(), controlPoints[i].end(), net.begin() + i * columns);
 	}
-	else
-	{
-		VALIDATE_ARGUMENT_RANGE(removeKnot, knotVectorV[0], knotVectorV[knotVectorV.size() - 1]);
+	std::vector<XYZW> strips(countU * (degreeU + 1) * columns);
+	std::vector<double> domainsU(2 * countU);
+	ControlPointsUtils::DecomposeToBeziers(degreeU, surface.KnotVectorU, net.data(), columns, strips.data(), domainsU.data());
+
+	int patchSize = (degreeU + 1) * (degreeV + 1);
+	patches.DegreeU = degreeU;
+	patches.DegreeV = degreeV;
+	patches.CountU = countU;
+	patches.CountV = countV;
+	patches.Domains.resize(4 * countU * countV);
+	patches.ControlPoints.resize(countU * countV * patchSize);
+
+	std::vector<XYZW> line(countV * (degreeV + 1));
+	std::vector<double> domainsV(2 * countV);
+	for (int su = 0; su < countU; su++)
+	{
+		for (int k = 0; k <= degreeU; k++)
+		{
+			ControlPointsUtils::DecomposeToBeziers(degreeV, surface.KnotVectorV, &strips[(su * (degreeU + 1) + k) * columns], 1, line.data(), domainsV.data());
+			for (int sv = 0; sv < countV; sv++)
+			{
+				std::copy(line.begin() + sv * (degreeV + 1), line.begin() + (sv + 1) * (degreeV + 1), patches.ControlPoints.begin() + (su * countV + sv) * patchSize + k * (degreeV + 1));
+			}
+		}
 	}
-	VALIDATE_ARGUMENT(times > 0, "times", "Times must greater than zero.");
 
-	std::vector<double> tempKnotVector;
-	std::vector<std::vector<XYZW>> tempControlPoints;
+	for (int su = 0; su < countU; su++)
+	{
+		for (int sv = 0; sv < countV; sv++)
+		{
+			double* domain = &patches.Domains[4 * (su * countV + sv)];
+			domain[0] = domainsU[2 * su];
+			domain[1] = domainsU[2 * su + 1];
+			domain[2] = domainsV[2 * sv];
+			domain[3] = domainsV[2 * sv + 1];
+		}
+	}
+}
 
-	result = surface;
+bool LNLib::NurbsSurface::Offset(const LN_NurbsSurface& surface, double offset, double tolerance, LN_NurbsSurface& result, ParallelExecutor* executor)
+{
+	VALIDATE_ARGUMENT(MathUtils::IsGreaterThan(tolerance, 0.0), "tolerance", "Tolerance must greater than zero.");
 
-	if (isUDirection)
+	if (MathUtils::IsAlmostEqualTo(offset, 0.0))
 	{
-		std::vector<std::vector<XYZW>> transposedControlPoints;
-		MathUtils::Transpose(controlPoints, transposedControlPoints);
+		result = surface;
+		return true;
+	}
 
-		for (int i = 0; i < transposedControlPoints.size(); i++)
+	LN_CheckedNurbsSurface checkedSurface = Check(surface);
+	std::vector<double> uniqueKvU = surface.KnotVectorU;
+	uniqueKvU.erase(std::unique(uniqueKvU.begin(), uniqueKvU.end()), uniqueKvU.end());
+	std::vector<double> uniqueKvV = surface.KnotVectorV;
+	uniqueKvV.erase(std::unique(uniqueKvV.begin(), uniqueKvV.end()), uniqueKvV.end());
+	int spansU = uniqueKvU.size() - 1;
+	int spansV = uniqueKvV.size() - 1;
+
+	// Control points per span double with the samples per span until the fit is within tolerance.
+	int controlPointsPerSpan = 1;
+	for (int iteration = 0; iteration < OffsetSurfaceMaxRefinements; iteration++)
+	{
+		OffsetSurfacePatchTask task(checkedSurface, offset, uniqueKvU, uniqueKvV, OffsetSurfaceSamplesPerControlPoint * controlPointsPerSpan);
+		Parallel::For(spansU * spansV, task, executor);
+
+		int rows = spansU * controlPointsPerSpan + OffsetSurfaceDegree;
+		int columns = spansV * controlPointsPerSpan + OffsetSurfaceDegree;
+		LN_NurbsSurface fit;
+		if (!GlobalApproximation(task.Points, OffsetSurfaceDegree, OffsetSurfaceDegree, rows, columns, fit, executor))
 		{
-			LN_NurbsCurve tc;
-			tc.Degree = degreeU;
-			tc.KnotVector = knotVectorU;
-			tc.ControlPoints = transposedControlPoints[i];
-
-			LN_NurbsCurve newtc;
-
-			NurbsCurve::RemoveKnot(tc, removeKnot, times, newtc);
-			tempControlPoints.emplace_back(newtc.ControlPoints);
-			tempKnotVector = newtc.KnotVector;
+			return false;
 		}
-		result.KnotVectorU = tempKnotVector;
-		result.KnotVectorV = knotVectorV;
-		std::vector<std::vector<XYZW>> updatedControlPoints;
-		MathUtils::Transpose(tempControlPoints, updatedControlPoints);
-		result.ControlPoints = updatedControlPoints;
+		result = fit;
+
+		std::vector<double> uk;
+		std::vector<double> vl;
+		Interpolation::GetSurfaceMeshParameterization(task.Points, uk, vl);
+		std::vector<std::vector<XYZ>> fitted;
+		EvaluateGrid(result, uk, vl, fitted);
+		double maxError = 0.0;
+		for (int i = 0; i < uk.size(); i++)
+		{
+			for (int j = 0; j < vl.size(); j++)
+			{
+				maxError = std::max(maxError, fitted[i][j].Distance(task.Points[i][j]));
+			}
+		}
+		if (MathUtils::IsLessThanOrEqual(maxError, tolerance))
+		{
+			return true;
+		}
+		controlPointsPerSpan *= 2;
 	}
-	else
+	return false;
+}
+
+LNLib::LN_NurbsSurface LNLib::NurbsSurface::CreateTransformed(const LN_NurbsSurface& surface, const Matrix4d& matrix)
+{
+	return CreateTransformed(LN_NurbsSurface(surface), matrix);
+}
+
+LNLib::LN_NurbsSurface LNLib::NurbsSurface::CreateTransformed(LN_NurbsSurface&& surface, const Matrix4d& matrix)
+{
+	Transform(surface, matrix);
+	return std::move(surface);
+}
+
+std::vector<LNLib::LN_NurbsSurface> LNLib::NurbsSurface::CreateTransformed(const std::vector<LN_NurbsSurface>& surfaces, const Matrix4d& matrix, ParallelExecutor* executor)
+{
+	std::vector<LN_NurbsSurface> result = surfaces;
+	Transform(result, matrix, executor);
+	return result;
+}
+
+void LNLib::NurbsSurface::Transform(LN_NurbsSurface& surface, const Matrix4d& matrix)
+{
+	std::vector<std::vector<XYZW>>& controlPoints = surface.ControlPoints;
+	for (int i = 0; i < controlPoints.size(); i++)
 	{
-		for (int i = 0; i < controlPoints.size(); i++)
-		{
-			LN_NurbsCurve tc;
-			tc.Degree = degreeU;
-			tc.KnotVector = knotVectorU;
-			tc.ControlPoints = controlPoints[i];
+		std::vector<XYZW>& row = controlPoints[i];
+		matrix.OfWeightedPoints(row.data(), row.size(), row.data());
+	}
+}
 
-			LN_NurbsCurve newtc;
-			NurbsCurve::RemoveKnot(tc, removeKnot, times, newtc);
-			tempControlPoints.emplace_back(newtc.ControlPoints);
-			tempKnotVector = newtc.KnotVector;
-		}
-		result.KnotVectorU = knotVectorU;
-		result.KnotVectorV = tempKnotVector;
-		result.ControlPoints = tempControlPoints;
+void LNLib::NurbsSurface::Transform(std::vector<LN_NurbsSurface>& surfaces, const Matrix4d& matrix, ParallelExecutor* executor)
+{
+	SurfaceTransformTask task(surfaces, matrix);
+	Parallel::For(surfaces.size(), task, executor);
+}
+
+LNLib::LN_BoundingBox LNLib::NurbsSurface::GetBoundingBox(const LN_NurbsSurface& surface)
+{
+	Check(surface);
+	return ControlPointsUtils::ComputeBoundingBox(surface.ControlPoints);
+}
+
+std::vector<LNLib::LN_BoundingBox> LNLib::NurbsSurface::GetSpanBoundingBoxes(const LN_NurbsSurface& surface)
+{
+	Check(surface);
+
+	std::vector<double> uniqueKnotsU = surface.KnotVectorU;
+	uniqueKnotsU.erase(std::unique(uniqueKnotsU.begin(), uniqueKnotsU.end()), uniqueKnotsU.end());
+	std::vector<double> uniqueKnotsV = surface.KnotVectorV;
+	uniqueKnotsV.erase(std::unique(uniqueKnotsV.begin(), uniqueKnotsV.end()), uniqueKnotsV.end());
+	std::vector<LN_NurbsSurface> patches = DecomposeToBeziers(surface);
+
+	std::vector<LN_BoundingBox> boxes((uniqueKnotsU.size() - 1) * (uniqueKnotsV.size() - 1));
+	for (int p = 0; p < boxes.size(); p++)
+	{
+		boxes[p] = ControlPointsUtils::ComputeBoundingBox(patches[p].ControlPoints);
 	}
+	return boxes;
 }
 
-void LNLib::NurbsSurface::ElevateDegree(const LN_NurbsSurface& surface, int times, bool isUDirection, LN_NurbsSurface& result)
+void LNLib::NurbsSurface::RemoveKnot(const LN_NurbsSurface& surface, double removeKnot, int times, bool isUDirection, LN_NurbsSurface& result)
 {
 	int degreeU = surface.DegreeU;
 	int degreeV = surface.DegreeV;
@@ -836,11 +3102,21 @@ void LNLib::NurbsSurface::ElevateDegree(const LN_NurbsSurface& surface, int time
 	std::vector<double> knotVectorV = surface.KnotVectorV;
 	std::vector<std::vector<XYZW>> controlPoints = surface.ControlPoints;
 
+	if (isUDirection)
+	{
+		VALIDATE_ARGUMENT_RANGE(removeKnot, knotVectorU[0], knotVectorU[knotVectorU.size() - 1]);
+	}
+	else
+	{
+		VALIDATE_ARGUMENT_RANGE(removeKnot, knotVectorV[0], knotVectorV[knotVectorV.size() - 1]);
+	}
 	VALIDATE_ARGUMENT(times > 0, "times", "Times must greater than zero.");
 
 	std::vector<double> tempKnotVector;
 	std::vector<std::vector<XYZW>> tempControlPoints;
 
+	result = surface;
+
 	if (isUDirection)
 	{
 		std::vector<std::vector<XYZW>> transposedControlPoints;
@@ -855,12 +3131,10 @@ void LNLib::NurbsSurface::ElevateDegree(const LN_NurbsSurface& surface, int time
 
 			LN_NurbsCurve newtc;
 
-			NurbsCurve::ElevateDegree(tc, times, newtc);
+			NurbsCurve::RemoveKnot(tc, removeKnot, times, newtc);
 			tempControlPoints.emplace_back(newtc.ControlPoints);
 			tempKnotVector = newtc.KnotVector;
 		}
-		result.DegreeU = degreeU + times;
-		result.DegreeV = degreeV;
 		result.KnotVectorU = tempKnotVector;
 		result.KnotVectorV = knotVectorV;
 		std::vector<std::vector<XYZW>> updatedControlPoints;
@@ -877,19 +3151,57 @@ void LNLib::NurbsSurface::ElevateDegree(const LN_NurbsSurface& surface, int time
 			tc.ControlPoints = controlPoints[i];
 
 			LN_NurbsCurve newtc;
-
-			NurbsCurve::ElevateDegree(tc, times, newtc);
+			NurbsCurve::RemoveKnot(tc, removeKnot, times, newtc);
 			tempControlPoints.emplace_back(newtc.ControlPoints);
 			tempKnotVector = newtc.KnotVector;
 		}
-		result.DegreeU = degreeU;
-		result.DegreeV = degreeV + times;
 		result.KnotVectorU = knotVectorU;
 		result.KnotVectorV = tempKnotVector;
 		result.ControlPoints = tempControlPoints;
 	}
 }
 
+LNLib::LN_NurbsSurface LNLib::NurbsSurface::ElevateDegree(const LN_NurbsSurface& surface, int times, bool isUDirection, ParallelExecutor* executor)
+{
+	LN_NurbsSurface result;
+	ElevateDegree(surface, times, isUDirection, result, executor);
+	return result;
+}
+
+void LNLib::NurbsSurface::ElevateDegree(const LN_NurbsSurface& surface, int times, bool isUDirection, LN_NurbsSurface& result, ParallelExecutor* executor)
+{
+	VALIDATE_ARGUMENT(times > 0, "times", "Times must greater than zero.");
+
+	LN_FlatNurbsSurface flat;
+	ToFlatSurface(surface, flat);
+	int rows = flat.RowCount;
+	int columns = flat.ColumnCount;
+
+	int degree = isUDirection ? surface.DegreeU : surface.DegreeV;
+	const std::vector<double>& knotVector = isUDirection ? surface.KnotVectorU : surface.KnotVectorV;
+	std::vector<std::vector<double>> bezalfs = Polynomials::BezierDegreeElevationMatrix(degree, times);
+	std::vector<double> updatedKnotVector = GetElevatedKnotVector(degree, knotVector, times);
+	int count = updatedKnotVector.size() - degree - times - 1;
+
+	LN_FlatNurbsSurface elevated;
+	elevated.DegreeU = isUDirection ? surface.DegreeU + times : surface.DegreeU;
+	elevated.DegreeV = isUDirection ? surface.DegreeV : surface.DegreeV + times;
+	elevated.KnotVectorU = isUDirection ? updatedKnotVector : surface.KnotVectorU;
+	elevated.KnotVectorV = isUDirection ? surface.KnotVectorV : updatedKnotVector;
+	elevated.RowCount = isUDirection ? count : rows;
+	elevated.ColumnCount = isUDirection ? columns : count;
+	elevated.ControlPoints.resize(elevated.RowCount * elevated.ColumnCount);
+
+	// Columns of the net are the lanes of U direction and rows those of V direction, both are read in place with strides.
+	int lanes = isUDirection ? columns : rows;
+	LaneElevationTask task(degree, knotVector, times, bezalfs, updatedKnotVector,
+		flat.ControlPoints.data(), isUDirection ? columns : 1, isUDirection ? 1 : columns, lanes,
+		elevated.ControlPoints.data(), isUDirection ? columns : 1, isUDirection ? 1 : count);
+	Parallel::For((lanes + ElevationLaneBlockSize - 1) / ElevationLaneBlockSize, task, executor);
+
+	ToNestedSurface(elevated, result);
+}
+
 bool LNLib::NurbsSurface::ReduceDegree(const LN_NurbsSurface& surface, bool isUDirection, LN_NurbsSurface& result)
 {
 	int degreeU = surface.DegreeU;
@@ -964,112 +3276,128 @@ void LNLib::NurbsSurface::EquallyTessellate(const LN_NurbsSurface& surface, std:
 {
 	int degreeU = surface.DegreeU;
 	int degreeV = surface.DegreeV;
-	std::vector<double> knotVectorU = surface.KnotVectorU;
-	std::vector<double> knotVectorV = surface.KnotVectorV;
-	std::vector<std::vector<XYZW>> controlPoints = surface.ControlPoints;
-
-	std::vector<double> uniqueKvU = knotVectorU;
-	uniqueKvU.erase(unique(uniqueKvU.begin(), uniqueKvU.end()), uniqueKvU.end());
-	int sizeU = uniqueKvU.size();
-
-	std::vector<double> uniqueKvV = knotVectorV;
-	uniqueKvV.erase(unique(uniqueKvV.begin(), uniqueKvV.end()), uniqueKvV.end());
-	int sizeV = uniqueKvV.size();
+	const std::vector<double>& knotVectorU = surface.KnotVectorU;
+	const std::vector<double>& knotVectorV = surface.KnotVectorV;
+	const std::vector<std::vector<XYZW>>& controlPoints = surface.ControlPoints;
 
-	std::vector<double> tessellatedU;
 	int intervals = 100;
-	for (int i = 0; i < sizeU - 1; i++)
-	{
-		double currentU = uniqueKvU[i];
-		double nextU = uniqueKvU[i + 1];
-		double stepU = (nextU - currentU) / intervals;
-		for (int j = 0; j < intervals; j++)
-		{
-			double u = currentU + stepU * j;
-			tessellatedU.emplace_back(u);
-		}
-	}
-	std::vector<double> tessellatedV;
-	for (int i = 0; i < sizeV - 1; i++)
+	std::vector<double> tessellatedU = GetEquallySpacedParameters(knotVectorU, intervals);
+	std::vector<double> tessellatedV = GetEquallySpacedParameters(knotVectorV, intervals);
+
+	std::vector<std::vector<XYZ>> grid;
+	EvaluateGrid(surface, tessellatedU, tessellatedV, grid);
+	for (int i = 0; i < tessellatedU.size(); i++)
 	{
-		double currentV = uniqueKvV[i];
-		double nextV = uniqueKvV[i + 1];
-		double stepV = (nextV - currentV) / intervals;
-		for (int j = 0; j < intervals; j++)
+		for (int j = 0; j < tessellatedV.size(); j++)
 		{
-			double v = currentV + stepV * j;
-			tessellatedV.emplace_back(v);
+			correspondingKnots.emplace_back(UV(tessellatedU[i], tessellatedV[j]));
+			tessellatedPoints.emplace_back(grid[i][j]);
 		}
 	}
 
-	for (int i = 0; i < tessellatedU.size(); i++)
-	{
-		for (int j = 0; j < tessellatedV.size(); j++)
-		{
-			UV uv = UV(tessellatedU[i], tessellatedV[j]);
-			correspondingKnots.emplace_back(uv);
-			tessellatedPoints.emplace_back(GetPointOnSurface(surface, uv));
-		}
-	}
+	correspondingKnots.emplace_back(UV(knotVectorU[knotVectorU.size() - 1], knotVectorV[knotVectorV.size() - 1]));
+	tessellatedPoints.emplace_back(controlPoints[controlPoints.size() - 1][controlPoints[0].size() - 1].ToXYZ(true));
+}
+
+void LNLib::NurbsSurface::EquallyTessellate(const LN_NurbsSurface& surface, int intervals, std::vector<XYZ>& tessellatedPoints, std::vector<UV>& correspondingKnots, ParallelExecutor* executor)
+{
+	VALIDATE_ARGUMENT(intervals > 0, "intervals", "Intervals must greater than zero.");
+	LN_CheckedNurbsSurface checkedSurface = Check(surface);
+
+	const std::vector<double>& knotVectorU = surface.KnotVectorU;
+	const std::vector<double>& knotVectorV = surface.KnotVectorV;
+	const std::vector<std::vector<XYZW>>& controlPoints = surface.ControlPoints;
+
+	std::vector<double> tessellatedU = GetEquallySpacedParameters(knotVectorU, intervals);
+	std::vector<double> tessellatedV = GetEquallySpacedParameters(knotVectorV, intervals);
+	int rows = tessellatedU.size();
+	int columns = tessellatedV.size();
+
+	tessellatedPoints.resize(rows * columns + 1);
+	correspondingKnots.resize(rows * columns + 1);
+
+	LN_ControlPointArrays arrays;
+	ControlPointsUtils::ToArrays(controlPoints, arrays);
+	TessellationTileTask task(checkedSurface, arrays, tessellatedU, tessellatedV, tessellatedPoints.data(), correspondingKnots.data());
+	int tileRows = (rows + TessellationTileSize - 1) / TessellationTileSize;
+	Parallel::For(tileRows * task.TileColumns, task, executor);
+
+	correspondingKnots[rows * columns] = UV(knotVectorU[knotVectorU.size() - 1], knotVectorV[knotVectorV.size() - 1]);
+	tessellatedPoints[rows * columns] = controlPoints[controlPoints.size() - 1][controlPoints[0].size() - 1].ToXYZ(true);
+}
+
+void LNLib::NurbsSurface::Tessellate(const LN_NurbsSurface& surface, double chordTolerance, double normalTolerance, LN_Mesh& mesh)
+{
+	LNLIB_SCOPED_TIMER("NurbsSurface::Tessellate");
+	VALIDATE_ARGUMENT(chordTolerance > 0, "chordTolerance", "ChordTolerance must greater than zero.");
+	VALIDATE_ARGUMENT(normalTolerance > 0, "normalTolerance", "NormalTolerance must greater than zero.");
+	Check(surface);
 
-	correspondingKnots.emplace_back(UV(knotVectorU[knotVectorU.size() - 1], knotVectorV[knotVectorV.size() - 1]));
-	tessellatedPoints.emplace_back(const_cast<XYZW&>(controlPoints[controlPoints.size() - 1][controlPoints[0].size() - 1]).ToXYZ(true));
+	AdaptiveMesher mesher(surface, chordTolerance, normalTolerance, mesh);
+	mesher.Run();
 }
 
-bool LNLib::NurbsSurface::IsClosed(const LN_NurbsSurface& surface, bool isUDirection)
+void LNLib::NurbsSurface::Tessellate(const LN_NurbsSurface& surface, const TrimLoopClassifier& trim, double chordTolerance, double normalTolerance, LN_Mesh& mesh)
 {
-	if (isUDirection)
+	LNLIB_SCOPED_TIMER("NurbsSurface::Tessellate");
+	VALIDATE_ARGUMENT(chordTolerance > 0, "chordTolerance", "ChordTolerance must greater than zero.");
+	VALIDATE_ARGUMENT(normalTolerance > 0, "normalTolerance", "NormalTolerance must greater than zero.");
+	Check(surface);
+
+	AdaptiveMesher mesher(surface, chordTolerance, normalTolerance, mesh, &trim);
+	mesher.Run();
+}
+
+void LNLib::NurbsSurface::Tessellate(const LN_TrimmedSurface& surface, double chordTolerance, double normalTolerance, double trimTolerance, LN_Mesh& mesh)
+{
+	if (surface.Loops.size() == 0)
 	{
-		std::vector<std::vector<XYZW>> transposed;
-		MathUtils::Transpose(surface.ControlPoints, transposed);
+		Tessellate(surface.Surface, chordTolerance, normalTolerance, mesh);
+		return;
+	}
+	TrimLoopClassifier trim(surface.Loops, trimTolerance);
+	Tessellate(surface.Surface, trim, chordTolerance, normalTolerance, mesh);
+}
 
-		for (int i = 0; i < transposed.size(); i++)
-		{
-			LN_NurbsCurve curve;
-			curve.Degree = surface.DegreeU;
-			curve.KnotVector = surface.KnotVectorU;
-			curve.ControlPoints = transposed[i];
+bool LNLib::NurbsSurface::IsClosed(const LN_NurbsSurface& surface, bool isUDirection)
+{
+	const std::vector<std::vector<XYZW>>& controlPoints = surface.ControlPoints;
+	int degree = isUDirection ? surface.DegreeU : surface.DegreeV;
+	const std::vector<double>& knotVector = isUDirection ? surface.KnotVectorU : surface.KnotVectorV;
+	int n = (isUDirection ? controlPoints.size() : controlPoints[0].size()) - 1;
+	int rows = isUDirection ? controlPoints[0].size() : controlPoints.size();
 
-			bool rowResult = NurbsCurve::IsClosed(curve);
+	double first = knotVector[0];
+	double end = knotVector[knotVector.size() - 1];
+	int startSpan = Polynomials::GetKnotSpanIndex(degree, knotVector, first);
+	int endSpan = Polynomials::GetKnotSpanIndex(degree, knotVector, end);
+	std::vector<double> startBasis = Polynomials::BasisFunctions(startSpan, degree, knotVector, first);
+	std::vector<double> endBasis = Polynomials::BasisFunctions(endSpan, degree, knotVector, end);
 
-			if (!rowResult)
-			{
-				return false;
-			}
-		}
-		return true;
-	}
-	else
+	for (int i = 0; i < rows; i++)
 	{
-		for (int i = 0; i < surface.ControlPoints.size(); i++)
+		if (!IsIsoRowClosed(controlPoints, isUDirection, i, n, startSpan, startBasis, endSpan, endBasis))
 		{
-			LN_NurbsCurve curve;
-			curve.Degree = surface.DegreeV;
-			curve.KnotVector = surface.KnotVectorV;
-			curve.ControlPoints = surface.ControlPoints[i];
-
-			bool rowResult = NurbsCurve::IsClosed(curve);
-			if (!rowResult)
-			{
-				return false;
-			}
+			return false;
 		}
-		return true;
 	}
-	return false;
+	return true;
 }
 
 LNLib::UV LNLib::NurbsSurface::GetParamOnSurface(const LN_NurbsSurface& surface, const XYZ& givenPoint)
 {
-	int degreeU = surface.DegreeU;
-	int degreeV = surface.DegreeV;
-	std::vector<double> knotVectorU = surface.KnotVectorU;
-	std::vector<double> knotVectorV = surface.KnotVectorV;
-	std::vector<std::vector<XYZW>> controlPoints = surface.ControlPoints;
+	return GetParamOnSurface(surface, givenPoint, LN_ProjectionOptions());
+}
+
+LNLib::UV LNLib::NurbsSurface::GetParamOnSurface(const LN_NurbsSurface& surface, const XYZ& givenPoint, const LN_ProjectionOptions& options)
+{
+	LNLIB_SCOPED_TIMER("NurbsSurface::GetParamOnSurface");
+	const std::vector<double>& knotVectorU = surface.KnotVectorU;
+	const std::vector<double>& knotVectorV = surface.KnotVectorV;
 
 	double minValue = Constants::MaxDistance;
 
-	int maxIterations = 10;
+	int maxIterations = options.MaxIterations;
 	UV param = UV(Constants::DoubleEpsilon, Constants::DoubleEpsilon);
 
 	double minUParam = knotVectorU[0];
@@ -1139,9 +3467,9 @@ LNLib::UV LNLib::NurbsSurface::GetParamOnSurface(const LN_NurbsSurface& surface,
 		double condition2a = std::abs(fa / (derivatives[1][0].Length() * condition1));
 		double condition2b = std::abs(fb / (derivatives[0][1].Length() * condition1));
 
-		if (condition1 < Constants::DistanceEpsilon &&
-			condition2a < Constants::DistanceEpsilon &&
-			condition2b < Constants::DistanceEpsilon)
+		if (condition1 < options.DistanceTolerance &&
+			condition2a < options.CosineTolerance &&
+			condition2b < options.CosineTolerance)
 		{
 			return param;
 		}
@@ -1165,6 +3493,7 @@ LNLib::UV LNLib::NurbsSurface::GetParamOnSurface(const LN_NurbsSurface& surface,
 		if (MathUtils::IsAlmostEqualTo(fu * gv, fv * gu))
 		{
 			counters++;
+			LNLIB_COUNT(NewtonIterations, 1);
 			continue;
 		}
 
@@ -1221,7 +3550,7 @@ LNLib::UV LNLib::NurbsSurface::GetParamOnSurface(const LN_NurbsSurface& surface,
 
 		double condition4a = ((temp[0] - param[0]) * derivatives[1][0]).Length();
 		double condition4b = ((temp[1] - param[1]) * derivatives[0][1]).Length();
-		if (condition4a + condition4b < Constants::DistanceEpsilon) {
+		if (condition4a + condition4b < options.DistanceTolerance) {
 			return param;
 		}
 
@@ -1247,28 +3576,35 @@ LNLib::UV LNLib::NurbsSurface::GetParamOnSurface(const LN_NurbsSurface& surface,
 			param = UV(param.GetU(), maxUParam);
 		}
 		counters++;
+		LNLIB_COUNT(NewtonIterations, 1);
 	}
 	return param;
 }
 
 void LNLib::NurbsSurface::Reparametrize(const LN_NurbsSurface& surface, double minU, double maxU, double minV, double maxV, LN_NurbsSurface& result)
 {
-	std::vector<double> knotVectorU = surface.KnotVectorU;
-	std::vector<double> knotVectorV = surface.KnotVectorV;
+	result = surface;
+	result = Reparametrize(std::move(result), minU, maxU, minV, maxV);
+}
+
+LNLib::LN_NurbsSurface LNLib::NurbsSurface::Reparametrize(const LN_NurbsSurface& surface, double minU, double maxU, double minV, double maxV)
+{
+	return Reparametrize(LN_NurbsSurface(surface), minU, maxU, minV, maxV);
+}
 
-	if ((MathUtils::IsAlmostEqualTo(minU, knotVectorU[0]) && MathUtils::IsAlmostEqualTo(maxU, knotVectorU[knotVectorU.size() - 1])) ||
-		(MathUtils::IsAlmostEqualTo(minV, knotVectorV[0]) && MathUtils::IsAlmostEqualTo(maxV, knotVectorV[knotVectorV.size() - 1])))
+LNLib::LN_NurbsSurface LNLib::NurbsSurface::Reparametrize(LN_NurbsSurface&& surface, double minU, double maxU, double minV, double maxV)
+{
+	std::vector<double>& knotVectorU = surface.KnotVectorU;
+	std::vector<double>& knotVectorV = surface.KnotVectorV;
+	if (!MathUtils::IsAlmostEqualTo(minU, knotVectorU[0]) || !MathUtils::IsAlmostEqualTo(maxU, knotVectorU[knotVectorU.size() - 1]))
 	{
-		result = surface;
-		return;
+		knotVectorU = KnotVectorUtils::Rescale(knotVectorU, minU, maxU);
 	}
-
-	std::vector<double> newKnotVectorU = KnotVectorUtils::Rescale(knotVectorU, minU, maxU);
-	std::vector<double> newKnotVectorV = KnotVectorUtils::Rescale(knotVectorV, minV, maxV);
-	
-	result = surface;
-	result.KnotVectorU = newKnotVectorU;
-	result.KnotVectorV = newKnotVectorV;
+	if (!MathUtils::IsAlmostEqualTo(minV, knotVectorV[0]) || !MathUtils::IsAlmostEqualTo(maxV, knotVectorV[knotVectorV.size() - 1]))
+	{
+		knotVectorV = KnotVectorUtils::Rescale(knotVectorV, minV, maxV);
+	}
+	return std::move(surface);
 }
 
 bool LNLib::NurbsSurface::GetUVTangent(const LN_NurbsSurface& surface, const UV param, const XYZ& tangent, UV& uvTangent)
@@ -1380,12 +3716,12 @@ bool LNLib::NurbsSurface::CreateCylindricalSurface(const XYZ& origin, const XYZ&
 void LNLib::NurbsSurface::CreateRuledSurface(const LN_NurbsCurve& curve0, const LN_NurbsCurve& curve1, LN_NurbsSurface& surface)
 {
 	int degree0 = curve0.Degree;
-	std::vector<double> knotVector0 = curve0.KnotVector;
-	std::vector<XYZW> controlPoints0 = curve0.ControlPoints;
+	const std::vector<double>& knotVector0 = curve0.KnotVector;
+	const std::vector<XYZW>& controlPoints0 = curve0.ControlPoints;
 
 	int degree1 = curve1.Degree;
-	std::vector<double> knotVector1 = curve1.KnotVector;
-	std::vector<XYZW> controlPoints1 = curve1.ControlPoints;
+	const std::vector<double>& knotVector1 = curve1.KnotVector;
+	const std::vector<XYZW>& controlPoints1 = curve1.ControlPoints;
 
 	int k0Size = knotVector0.size();
 	int k1Size = knotVector1.size();
@@ -1759,12 +4095,15 @@ void LNLib::NurbsSurface::MakeCornerFilletSurface(const LN_NurbsCurve& arc, LN_N
 	surface.ControlPoints = controlPoints;
 }
 
-void LNLib::NurbsSurface::GlobalInterpolation(const std::vector<std::vector<XYZ>>& throughPoints, int degreeU, int degreeV, LN_NurbsSurface& surface)
+void LNLib::NurbsSurface::GlobalInterpolation(const std::vector<std::vector<XYZ>>& throughPoints, int degreeU, int degreeV, LN_NurbsSurface& surface, ParallelExecutor* executor, const CancellationToken* cancellation)
 {
+	LNLIB_SCOPED_TIMER("NurbsSurface::GlobalInterpolation");
 	VALIDATE_ARGUMENT(throughPoints.size() > 0, "throughPoints", "ThroughPoints row size must greater than zero.");
 	VALIDATE_ARGUMENT(throughPoints[0].size() > 0, "throughPoints", "ThroughPoints column size must greater than zero.");
 	VALIDATE_ARGUMENT(degreeU > 0, "degreeU", "DegreeU must greater than zero.");
 	VALIDATE_ARGUMENT(degreeV > 0, "degreeV", "DegreeV must greater than zero.");
+	VALIDATE_ARGUMENT(throughPoints.size() > degreeU, "throughPoints", "ThroughPoints row size must greater than degreeU.");
+	VALIDATE_ARGUMENT(throughPoints[0].size() > degreeV, "throughPoints", "ThroughPoints column size must greater than degreeV.");
 
 	std::vector<double> uk;
 	std::vector<double> vl;
@@ -1774,44 +4113,49 @@ void LNLib::NurbsSurface::GlobalInterpolation(const std::vector<std::vector<XYZ>
 	int rows = throughPoints.size();
 	int cols = throughPoints[0].size();
 
-	std::vector<std::vector<XYZW>> controlPoints(rows, std::vector<XYZW>(cols));
 	std::vector<double> knotVectorU = Interpolation::AverageKnotVector(degreeU, uk);
 	std::vector<double> knotVectorV = Interpolation::AverageKnotVector(degreeV, vl);
 
-	for (int j = 0; j < cols; j++)
+	int lowerBandwidthU = 0;
+	int upperBandwidthU = 0;
+	std::vector<std::vector<double>> bandU = Interpolation::CreateCollocationMatrix(degreeU, knotVectorU, uk, lowerBandwidthU, upperBandwidthU);
+	bool isDecomposedU = MathUtils::BandedLUDecomposition(bandU, lowerBandwidthU, upperBandwidthU);
+	if (!isDecomposedU)
 	{
-		std::vector<XYZ> temp(rows);
-		for (int i = 0; i < rows; i++)
-		{
-			temp[i] = throughPoints[i][j];
-		}
-		LN_NurbsCurve tc;
-		NurbsCurve::GlobalInterpolation(degreeU, temp, tc);
-		for (int i = 0; i < rows; i++)
-		{
-			controlPoints[i][j] = tc.ControlPoints[i];
-		}
+		bandU = Interpolation::CreateCollocationMatrix(degreeU, knotVectorU, uk, lowerBandwidthU, upperBandwidthU);
+	}
+
+	int lowerBandwidthV = 0;
+	int upperBandwidthV = 0;
+	std::vector<std::vector<double>> bandV = Interpolation::CreateCollocationMatrix(degreeV, knotVectorV, vl, lowerBandwidthV, upperBandwidthV);
+	bool isDecomposedV = MathUtils::BandedLUDecomposition(bandV, lowerBandwidthV, upperBandwidthV);
+	if (!isDecomposedV)
+	{
+		bandV = Interpolation::CreateCollocationMatrix(degreeV, knotVectorV, vl, lowerBandwidthV, upperBandwidthV);
 	}
 
+	// The NURBS Book A9.4: interpolate every column along u, then every row of the result along v.
+	std::vector<std::vector<XYZ>> R(rows, std::vector<XYZ>(cols));
+	CollocationSolveTask taskU(bandU, lowerBandwidthU, upperBandwidthU, isDecomposedU, false, cols, throughPoints, R, cancellation);
+	Parallel::For(taskU.GetTaskCount(), taskU, executor);
+
+	std::vector<std::vector<XYZ>> P(rows, std::vector<XYZ>(cols));
+	CollocationSolveTask taskV(bandV, lowerBandwidthV, upperBandwidthV, isDecomposedV, true, rows, R, P, cancellation);
+	Parallel::For(taskV.GetTaskCount(), taskV, executor);
+
+	std::vector<std::vector<XYZW>> controlPoints(rows, std::vector<XYZW>(cols));
 	for (int i = 0; i < rows; i++)
 	{
-		std::vector<XYZ> temp(cols);
-		for (int j = 0; j < cols; j++)
-		{
-			temp[j] = throughPoints[i][j];
-		}
-		LN_NurbsCurve tc;
-		NurbsCurve::GlobalInterpolation(degreeV, temp, tc);
 		for (int j = 0; j < cols; j++)
 		{
-			controlPoints[i][j] = tc.ControlPoints[j];
+			controlPoints[i][j] = XYZW(P[i][j], 1.0);
 		}
 	}
 	surface.DegreeU = degreeU;
 	surface.DegreeV = degreeV;
-	surface.KnotVectorU = knotVectorU;
-	surface.KnotVectorV = knotVectorV;
-	surface.ControlPoints = controlPoints;
+	surface.KnotVectorU = std::move(knotVectorU);
+	surface.KnotVectorV = std::move(knotVectorV);
+	surface.ControlPoints = std::move(controlPoints);
 }
 
 bool LNLib::NurbsSurface::BicubicLocalInterpolation(const std::vector<std::vector<XYZ>>& throughPoints, LN_NurbsSurface& surface)
@@ -2025,65 +4369,68 @@ bool LNLib::NurbsSurface::BicubicLocalInterpolation(const std::vector<std::vecto
 	return true;
 }
 
-bool LNLib::NurbsSurface::GlobalApproximation(const std::vector<std::vector<XYZ>>& throughPoints, int degreeU, int degreeV, int controlPointsRows, int controlPointsColumns, LN_NurbsSurface& surface)
+bool LNLib::NurbsSurface::GlobalApproximation(const std::vector<std::vector<XYZ>>& throughPoints, int degreeU, int degreeV, int controlPointsRows, int controlPointsColumns, LN_NurbsSurface& surface, ParallelExecutor* executor, const CancellationToken* cancellation)
 {
+	LNLIB_SCOPED_TIMER("NurbsSurface::GlobalApproximation");
 	VALIDATE_ARGUMENT(throughPoints.size() > 0, "throughPoints", "ThroughPoints row size must greater than zero.");
 	VALIDATE_ARGUMENT(throughPoints[0].size() > 0, "throughPoints", "ThroughPoints column size must greater than zero.");
 	VALIDATE_ARGUMENT(degreeU > 0, "degreeU", "DegreeU must greater than zero.");
 	VALIDATE_ARGUMENT(degreeV > 0, "degreeV", "DegreeV must greater than zero.");
+	VALIDATE_ARGUMENT(controlPointsRows > degreeU && controlPointsRows <= throughPoints.size(), "controlPointsRows", "ControlPointsRows must greater than degreeU and not greater than throughPoints row size.");
+	VALIDATE_ARGUMENT(controlPointsColumns > degreeV && controlPointsColumns <= throughPoints[0].size(), "controlPointsColumns", "ControlPointsColumns must greater than degreeV and not greater than throughPoints column size.");
 
-	int rows = controlPointsRows;
-	int n = rows - 1;
-	int columns = controlPointsColumns;
-	int m = columns - 1;
+	int rows = throughPoints.size();
+	int columns = throughPoints[0].size();
 
-	std::vector<double> knotVectorU;
-	std::vector<double> knotVectorV;
-	std::vector<std::vector<XYZW>> controlPoints;
+	std::vector<double> uk;
+	std::vector<double> vl;
+	if (!Interpolation::GetSurfaceMeshParameterization(throughPoints, uk, vl)) return false;
 
-	std::vector<std::vector<XYZ>> tempControlPoints;
-	for (int i = 0; i < rows; i++)
-	{
-		LN_NurbsCurve tc;
-		bool result = NurbsCurve::LeastSquaresApproximation(degreeU, throughPoints[i], rows, tc);
-		if (!result) return false;
-		std::vector<XYZ> points = ControlPointsUtils::ToXYZ(tc.ControlPoints);
-		tempControlPoints.emplace_back(points);
-		knotVectorU = tc.KnotVector;
-	}
+	std::vector<double> knotVectorU = Interpolation::ComputeKnotVector(degreeU, rows, controlPointsRows, uk);
+	std::vector<double> knotVectorV = Interpolation::ComputeKnotVector(degreeV, columns, controlPointsColumns, vl);
 
-	std::vector<std::vector<XYZ>> preControlPoints;
-	std::vector<std::vector<XYZ>> tPoints;
-	for (int i = 0; i < columns; i++)
-	{
-		std::vector<XYZ> c = MathUtils::GetColumn(tempControlPoints, i);
-		LN_NurbsCurve tc;
-		bool result = NurbsCurve::LeastSquaresApproximation(degreeV, c, columns, tc);
-		if (!result) return false;
-		std::vector<XYZ> points = ControlPointsUtils::ToXYZ(tc.ControlPoints);
-		tPoints.emplace_back(points);
-		knotVectorV = tc.KnotVector;
-	}
-	MathUtils::Transpose(tPoints, preControlPoints);
-	controlPoints = ControlPointsUtils::ToXYZW(preControlPoints);
+	std::vector<int> spanIndicesU;
+	std::vector<std::vector<double>> basisU;
+	std::vector<std::vector<double>> normalU = Interpolation::CreateLeastSquaresNormalMatrix(degreeU, knotVectorU, uk, controlPointsRows, spanIndicesU, basisU);
+	if (!MathUtils::SymmetricBandedCholeskyDecomposition(normalU, degreeU)) return false;
+
+	std::vector<int> spanIndicesV;
+	std::vector<std::vector<double>> basisV;
+	std::vector<std::vector<double>> normalV = Interpolation::CreateLeastSquaresNormalMatrix(degreeV, knotVectorV, vl, controlPointsColumns, spanIndicesV, basisV);
+	if (!MathUtils::SymmetricBandedCholeskyDecomposition(normalV, degreeV)) return false;
+
+	// Fit every column of data along u, then every row of the result along v, each normal matrix is factored once.
+	std::vector<std::vector<XYZ>> R(controlPointsRows, std::vector<XYZ>(columns));
+	LeastSquaresSolveTask taskU(degreeU, controlPointsRows, spanIndicesU, basisU, normalU, false, columns, throughPoints, R, cancellation);
+	Parallel::For(taskU.GetTaskCount(), taskU, executor);
+
+	std::vector<std::vector<XYZ>> P(controlPointsRows, std::vector<XYZ>(controlPointsColumns));
+	LeastSquaresSolveTask taskV(degreeV, controlPointsColumns, spanIndicesV, basisV, normalV, true, controlPointsRows, R, P, cancellation);
+	Parallel::For(taskV.GetTaskCount(), taskV, executor);
 
 	surface.DegreeU = degreeU;
 	surface.DegreeV = degreeV;
-	surface.KnotVectorU = knotVectorU;
-	surface.KnotVectorV = knotVectorV;
-	surface.ControlPoints = controlPoints;
+	surface.KnotVectorU = std::move(knotVectorU);
+	surface.KnotVectorV = std::move(knotVectorV);
+	surface.ControlPoints = ControlPointsUtils::ToXYZW(P);
 	return true;
 }
 
+std::future<LNLib::LN_NurbsSurface> LNLib::NurbsSurface::GlobalApproximationAsync(const std::vector<std::vector<XYZ>>& throughPoints, int degreeU, int degreeV, int controlPointsRows, int controlPointsColumns, ParallelExecutor* executor, const CancellationToken* cancellation)
+{
+	SurfaceApproximationJob job = { throughPoints, degreeU, degreeV, controlPointsRows, controlPointsColumns, executor, cancellation };
+	return std::async(std::launch::async, job);
+}
+
 bool LNLib::NurbsSurface::CreateSwungSurface(const LN_NurbsCurve& profile, const LN_NurbsCurve& trajectory, double scale, LN_NurbsSurface& surface)
 {
 	int pDegree = profile.Degree;
-	std::vector<double> pKnotVector = profile.KnotVector;
-	std::vector<XYZW> pControlPoints = profile.ControlPoints;
+	const std::vector<double>& pKnotVector = profile.KnotVector;
+	const std::vector<XYZW>& pControlPoints = profile.ControlPoints;
 
 	int tDegree = trajectory.Degree;
-	std::vector<double> tKnotVector = trajectory.KnotVector;
-	std::vector<XYZW> tControlPoints = trajectory.ControlPoints;
+	const std::vector<double>& tKnotVector = trajectory.KnotVector;
+	const std::vector<XYZW>& tControlPoints = trajectory.ControlPoints;
 
 	int size = tControlPoints.size();
 	int degreeU = pDegree;
@@ -2175,231 +4522,131 @@ bool LNLib::NurbsSurface::CreateSwungSurface(const LN_NurbsCurve& profile, const
 	return true;
 }
 
-void LNLib::NurbsSurface::CreateLoftSurface(const std::vector<LN_NurbsCurve>& sections, LN_NurbsSurface& surface)
+void LNLib::NurbsSurface::CreateLoftSurface(const std::vector<LN_NurbsCurve>& sections, LN_NurbsSurface& surface, ParallelExecutor* executor, const CancellationToken* cancellation)
 {
-	int degree_max = 0;
-	for (int k = 0; k < sections.size(); k++)
+	LNLIB_SCOPED_TIMER("NurbsSurface::CreateLoftSurface");
+	int size = sections.size();
+	VALIDATE_ARGUMENT(size > 1, "sections", "Sections size must greater than one.");
+
+	std::vector<LN_NurbsCurve> internals;
+	int degree_max = MakeSectionsCompatible(sections, false, internals, executor, cancellation);
+
+	int degreeU = degree_max;
+	int degreeV = std::min(degree_max, size - 1);
+	int column = internals[0].ControlPoints.size();
+	for (int k = 1; k < size; k++)
 	{
-		LN_NurbsCurve current = sections[k];
-		if (degree_max < current.Degree)
-		{
-			degree_max = current.Degree;
-		}
+		VALIDATE_ARGUMENT(internals[k].ControlPoints.size() == column, "sections", "Sections must have the same control points count.");
 	}
 
-	int size = sections.size();
-	std::vector<LN_NurbsCurve> internals(size);
-	std::vector<std::vector<XYZW>> curvesControlPoints(size);
+	// Unweighted section points are also the right hand sides of the column interpolation, column chord lengths are scratch.
+	std::vector<std::vector<XYZ>> points(size, std::vector<XYZ>(column));
+	MonotonicArena arena;
+	ArenaVector<double> columnLengths(column, 0.0, ArenaAllocator<double>(arena));
 	for (int k = 0; k < size; k++)
 	{
-		LN_NurbsCurve current = sections[k];
-		if (degree_max > current.Degree)
+		for (int i = 0; i < column; i++)
 		{
-			int times = degree_max - current.Degree;
-			LN_NurbsCurve tc;
-			NurbsCurve::ElevateDegree(current, times, tc);
-			current.Degree = degree_max;
-			current.KnotVector = tc.KnotVector;
-			current.ControlPoints = tc.ControlPoints;
+			points[k][i] = internals[k].ControlPoints[i].ToXYZ(true);
+			if (k > 0)
+			{
+				columnLengths[i] += points[k][i].Distance(points[k - 1][i]);
+			}
 		}
-		curvesControlPoints.emplace_back(current.ControlPoints);
-		internals.emplace_back(current);
 	}
 
-	int degreeU = degree_max;
-	int degreeV = degree_max;
-
 	std::vector<double> vl(size);
 	vl[0] = 0;
 	vl[size - 1] = 1;
 	for (int k = 1; k <= size - 2; k++)
 	{
-		std::vector<XYZW> current = curvesControlPoints[k];
-
-		int tsize = current.size();
-		std::vector<XYZ> cps(tsize);
-		for (int i = 0; i <= tsize; i++)
-		{
-			cps[i] = current[i].ToXYZ(true);
-		}
-
 		double average = 0.0;
-		double length = Interpolation::GetTotalChordLength(cps);
-		for (int i = 0; i <= tsize; i++)
+		for (int i = 0; i < column; i++)
 		{
-			double distance = curvesControlPoints[k][i].Distance(curvesControlPoints[k - 1][i]);
-			average += distance / length;
+			if (!MathUtils::IsAlmostEqualTo(columnLengths[i], 0.0))
+			{
+				average += points[k][i].Distance(points[k - 1][i]) / columnLengths[i];
+			}
+			else
+			{
+				average += 1.0 / (size - 1);
+			}
 		}
-		vl[k] = vl[k - 1] + 1.0 / (tsize + 1) * average;
+		vl[k] = vl[k - 1] + average / column;
 	}
+
+	// Every column is interpolated at the same parameters, so the collocation matrix is factored once for all of them.
 	std::vector<double> knotVectorV = Interpolation::AverageKnotVector(degreeV, vl);
+	int lowerBandwidth = 0;
+	int upperBandwidth = 0;
+	std::vector<std::vector<double>> band = Interpolation::CreateCollocationMatrix(degreeV, knotVectorV, vl, lowerBandwidth, upperBandwidth);
+	bool isDecomposed = MathUtils::BandedLUDecomposition(band, lowerBandwidth, upperBandwidth);
+	if (!isDecomposed)
+	{
+		band = Interpolation::CreateCollocationMatrix(degreeV, knotVectorV, vl, lowerBandwidth, upperBandwidth);
+	}
 
-	std::vector<std::vector<XYZW>> controlPoints;
-	int column = curvesControlPoints[0].size();
+	std::vector<std::vector<XYZ>> solved(size, std::vector<XYZ>(column));
+	CollocationSolveTask task(band, lowerBandwidth, upperBandwidth, isDecomposed, false, column, points, solved, cancellation);
+	Parallel::For(task.GetTaskCount(), task, executor);
+
+	std::vector<std::vector<XYZW>> controlPoints(column, std::vector<XYZW>(size));
 	for (int c = 0; c < column; c++)
 	{
-		std::vector<XYZ> temp(size);
 		for (int k = 0; k < size; k++)
 		{
-			temp[k] = curvesControlPoints[k][c].ToXYZ(true);
+			controlPoints[c][k] = XYZW(solved[k][c], 1.0);
 		}
-		LN_NurbsCurve tc;
-		NurbsCurve::GlobalInterpolation(degreeV, temp, tc, vl);
-		controlPoints.emplace_back(tc.ControlPoints);
 	}
 
 	surface.DegreeU = degreeU;
 	surface.DegreeV = degreeV;
 	surface.KnotVectorU = internals[0].KnotVector;
-	surface.KnotVectorV = knotVectorV;
-	surface.ControlPoints = controlPoints;
+	surface.KnotVectorV = std::move(knotVectorV);
+	surface.ControlPoints = std::move(controlPoints);
 }
 
-void LNLib::NurbsSurface::CreateSweepSurface(const LN_NurbsCurve& path, const std::vector<LN_NurbsCurve>& profiles, LN_NurbsSurface& surface)
+void LNLib::NurbsSurface::CreateSweepSurface(const LN_NurbsCurve& path, const std::vector<LN_NurbsCurve>& profiles, LN_NurbsSurface& surface, ParallelExecutor* executor)
 {
+	LNLIB_SCOPED_TIMER("NurbsSurface::CreateSweepSurface");
 	int profilesSize = profiles.size();
 	double path_min = path.KnotVector[0];
 	double path_max = path.KnotVector[path.KnotVector.size() - 1];
-	double delta = (path_max - path_min) / profilesSize;
+	double delta = profilesSize > 1 ? (path_max - path_min) / (profilesSize - 1) : 0.0;
 
 	std::vector<LN_NurbsCurve> sections(profilesSize);
-	for (int i = 0; i < profilesSize; i++)
-	{
-		double param = path_min + i * delta;
-		XYZ point = NurbsCurve::GetPointOnCurve(path, param);
-		std::vector<XYZ> ders = NurbsCurve::ComputeRationalCurveDerivatives(profiles[i], 1, param);
-		XYZ tangent = ders[1];
-		Matrix4d transform = Matrix4d::CreateTranslation(point);
-		if (!tangent.IsZero())
-		{
-			XYZ binormal = NurbsCurve::Normal(profiles[i], CurveNormal::Binormal, param);
-			double rad = binormal.AngleTo(tangent);
-			Matrix4d rotation = Matrix4d::CreateRotationAtPoint(point, binormal, rad);
-			transform = transform.Multiply(rotation);
-		}
-		LN_NurbsCurve newProfile;
-		NurbsCurve::CreateTransformed(profiles[i], transform, newProfile);
-		sections.emplace_back(newProfile);
-	}
+	SweepSectionTask task(path, profiles, path_min, delta, sections);
+	Parallel::For(profilesSize, task, executor);
 
-	CreateLoftSurface(sections, surface);
+	CreateLoftSurface(sections, surface, executor);
 }
 
-void LNLib::NurbsSurface::CreateGordonSurface(const std::vector<LN_NurbsCurve>& uCurves, const std::vector<LN_NurbsCurve>& vCurves, const std::vector<std::vector<XYZ>>& intersectionPoints, LN_NurbsSurface& surface)
+void LNLib::NurbsSurface::CreateGordonSurface(const std::vector<LN_NurbsCurve>& uCurves, const std::vector<LN_NurbsCurve>& vCurves, const std::vector<std::vector<XYZ>>& intersectionPoints, LN_NurbsSurface& surface, ParallelExecutor* executor, const CancellationToken* cancellation)
 {
-	int degree_u_max = 0;
-	for (int i = 0; i < uCurves.size(); i++)
-	{
-		LN_NurbsCurve current = uCurves[i];
-		if (current.Degree > degree_u_max)
-		{
-			degree_u_max = current.Degree;
-		}
-	}
-
+	LNLIB_SCOPED_TIMER("NurbsSurface::CreateGordonSurface");
 	std::vector<LN_NurbsCurve> uInternals;
-	for (int i = 0; i < uCurves.size(); i++)
-	{
-		LN_NurbsCurve current;
-		NurbsCurve::Reparametrize(uCurves[i], 0, 1, current);
-
-		if (degree_u_max > current.Degree)
-		{
-			int times = degree_u_max - current.Degree;
-			LN_NurbsCurve tc;
-			NurbsCurve::ElevateDegree(current, times, tc);
-			uInternals.emplace_back(tc);
-		}
-		else
-		{
-			uInternals.emplace_back(current);
-		}
-	}
-
-	std::vector<std::vector<double>> knotVectorsU;
-	for (int i = 0; i < uInternals.size(); i++)
-	{
-		knotVectorsU.emplace_back(uInternals[i].KnotVector);
-	}
-	auto insertElements = KnotVectorUtils::GetInsertedKnotElements(knotVectorsU);
-	for (int i = 0; i < uInternals.size(); i++)
-	{
-		auto insertElement = insertElements[i];
-		if (insertElement.size() > 0)
-		{
-			LN_NurbsCurve tc;
-			NurbsCurve::RefineKnotVector(uInternals[i], insertElement, tc);
-			uInternals[i] = tc;
-		}
-	}
-
-	int degree_v_max = 0;
-	for (int i = 0; i < vCurves.size(); i++)
-	{
-		LN_NurbsCurve current = vCurves[i];
-		if (current.Degree > degree_v_max)
-		{
-			degree_v_max = current.Degree;
-		}
-	}
-
+	int degree_u_max = MakeSectionsCompatible(uCurves, true, uInternals, executor, cancellation);
+	CancellationToken::ThrowIfCancelled(cancellation);
 	std::vector<LN_NurbsCurve> vInternals;
-	for (int i = 0; i < vCurves.size(); i++)
-	{
-		LN_NurbsCurve current;
-		NurbsCurve::Reparametrize(vCurves[i], 0, 1, current);
-		if (degree_v_max > current.Degree)
-		{
-			int times = degree_v_max - current.Degree;
-			LN_NurbsCurve tc;
-			NurbsCurve::ElevateDegree(current, times, tc);
-			vInternals.emplace_back(tc);
-		}
-		else
-		{
-			vInternals.emplace_back(current);
-		}
-	}
-
-	std::vector<std::vector<double>> knotVectorsV;
-	for (int i = 0; i < vInternals.size(); i++)
-	{
-		knotVectorsV.emplace_back(vInternals[i].KnotVector);
-	}
-	insertElements = KnotVectorUtils::GetInsertedKnotElements(knotVectorsV);
-	for (int i = 0; i < vInternals.size(); i++)
-	{
-		auto insertElement = insertElements[i];
-		if (insertElement.size() > 0)
-		{
-			LN_NurbsCurve tc;
-			NurbsCurve::RefineKnotVector(vInternals[i], insertElement, tc);
-			vInternals[i] = tc;
-		}
-	}
+	int degree_v_max = MakeSectionsCompatible(vCurves, true, vInternals, executor, cancellation);
+	CancellationToken::ThrowIfCancelled(cancellation);
 
 	int rows = intersectionPoints.size();
 	int columns = intersectionPoints[0].size();
 
 	LN_NurbsSurface loftSurfaceV;
-	CreateLoftSurface(uInternals, loftSurfaceV);
+	CreateLoftSurface(uInternals, loftSurfaceV, executor, cancellation);
+	CancellationToken::ThrowIfCancelled(cancellation);
 	LN_NurbsSurface ts;
-	CreateLoftSurface(vInternals, ts);
-	std::vector<std::vector<XYZW>> transposedControlPoints;
-	MathUtils::Transpose(ts.ControlPoints, transposedControlPoints);
-	LN_NurbsSurface loftSurfaceU;
-	loftSurfaceU.DegreeU = ts.DegreeV;
-	loftSurfaceU.DegreeV = ts.DegreeU;
-	loftSurfaceU.KnotVectorU = ts.KnotVectorV;
-	loftSurfaceU.KnotVectorV = ts.KnotVectorU;
-	loftSurfaceU.ControlPoints = transposedControlPoints;
+	CreateLoftSurface(vInternals, ts, executor, cancellation);
+	CancellationToken::ThrowIfCancelled(cancellation);
+	LN_NurbsSurface loftSurfaceU = Swap(ts);
 
 	int degreeU = std::min(columns - 1, degree_u_max);
 	int degreeV = std::min(rows - 1, degree_v_max);
-	GlobalInterpolation(intersectionPoints, degreeU, degreeV, ts);
-	MathUtils::Transpose(ts.ControlPoints, transposedControlPoints);
-	LN_NurbsSurface interpolatedSurface;
-	Swap(ts, interpolatedSurface);
+	GlobalInterpolation(intersectionPoints, degreeU, degreeV, ts, executor, cancellation);
+	CancellationToken::ThrowIfCancelled(cancellation);
+	LN_NurbsSurface interpolatedSurface = Swap(ts);
 
 	{
 		int lsu_degreeU = loftSurfaceU.DegreeU;
@@ -2410,25 +4657,19 @@ void LNLib::NurbsSurface::CreateGordonSurface(const std::vector<LN_NurbsCurve>&
 		if (degreeU > lsu_degreeU)
 		{
 			int times = degreeU - lsu_degreeU;
-			LN_NurbsSurface temp;
-			ElevateDegree(loftSurfaceU, times, true, temp);
-			loftSurfaceU = temp;
+			loftSurfaceU = ElevateDegree(loftSurfaceU, times, true);
 		}
 
 		if (degreeU > lsv_degreeU)
 		{
 			int times = degreeU - lsv_degreeU;
-			LN_NurbsSurface temp;
-			ElevateDegree(loftSurfaceV, times, true, temp);
-			loftSurfaceV = temp;
+			loftSurfaceV = ElevateDegree(loftSurfaceV, times, true);
 		}
 
 		if (degreeU > inp_degreeU)
 		{
 			int times = degreeU - inp_degreeU;
-			LN_NurbsSurface temp;
-			ElevateDegree(interpolatedSurface, times, true, temp);
-			interpolatedSurface = temp;
+			interpolatedSurface = ElevateDegree(interpolatedSurface, times, true);
 		}
 
 		int lsu_degreeV = loftSurfaceU.DegreeV;
@@ -2439,27 +4680,22 @@ void LNLib::NurbsSurface::CreateGordonSurface(const std::vector<LN_NurbsCurve>&
 		if (degreeV > lsu_degreeV)
 		{
 			int times = degreeV - lsu_degreeV;
-			LN_NurbsSurface temp;
-			ElevateDegree(loftSurfaceU, times, false, temp);
-			loftSurfaceU = temp;
+			loftSurfaceU = ElevateDegree(loftSurfaceU, times, false);
 		}
 
 		if (degreeV > lsv_degreeV)
 		{
 			int times = degreeV - lsv_degreeV;
-			LN_NurbsSurface temp;
-			ElevateDegree(loftSurfaceV, times, false, temp);
-			loftSurfaceV = temp;
+			loftSurfaceV = ElevateDegree(loftSurfaceV, times, false);
 		}
 
 		if (degreeV > inp_degreeV)
 		{
 			int times = degreeV - inp_degreeV;
-			LN_NurbsSurface temp;
-			ElevateDegree(interpolatedSurface, times, false, temp);
-			interpolatedSurface = temp;
+			interpolatedSurface = ElevateDegree(interpolatedSurface, times, false);
 		}
 	}
+	CancellationToken::ThrowIfCancelled(cancellation);
 
 	{
 		std::vector<std::vector<double>> knotVectorsU;
@@ -2470,21 +4706,15 @@ void LNLib::NurbsSurface::CreateGordonSurface(const std::vector<LN_NurbsCurve>&
 		auto insertElements = KnotVectorUtils::GetInsertedKnotElements(knotVectorsU);
 		if (insertElements[0].size() > 0)
 		{
-			LN_NurbsSurface temp;
-			RefineKnotVector(loftSurfaceU, insertElements[0], true, temp);
-			loftSurfaceU = temp;
+			RefineKnotVector(loftSurfaceU, insertElements[0], true);
 		}
 		if (insertElements[1].size() > 0)
 		{
-			LN_NurbsSurface temp;
-			RefineKnotVector(loftSurfaceV, insertElements[1], true, temp);
-			loftSurfaceV = temp;
+			RefineKnotVector(loftSurfaceV, insertElements[1], true);
 		}
 		if (insertElements[2].size() > 0)
 		{
-			LN_NurbsSurface temp;
-			RefineKnotVector(interpolatedSurface, insertElements[2], true, temp);
-			interpolatedSurface = temp;
+			RefineKnotVector(interpolatedSurface, insertElements[2], true);
 		}
 	}
 
@@ -2497,23 +4727,18 @@ void LNLib::NurbsSurface::CreateGordonSurface(const std::vector<LN_NurbsCurve>&
 		auto insertElements = KnotVectorUtils::GetInsertedKnotElements(knotVectorsV);
 		if (insertElements[0].size() > 0)
 		{
-			LN_NurbsSurface temp;
-			RefineKnotVector(loftSurfaceU, insertElements[0], false, temp);
-			loftSurfaceU = temp;
+			RefineKnotVector(loftSurfaceU, insertElements[0], false);
 		}
 		if (insertElements[1].size() > 0)
 		{
-			LN_NurbsSurface temp;
-			RefineKnotVector(loftSurfaceV, insertElements[1], false, temp);
-			loftSurfaceV = temp;
+			RefineKnotVector(loftSurfaceV, insertElements[1], false);
 		}
 		if (insertElements[2].size() > 0)
 		{
-			LN_NurbsSurface temp;
-			RefineKnotVector(interpolatedSurface, insertElements[2], false, temp);
-			interpolatedSurface = temp;
+			RefineKnotVector(interpolatedSurface, insertElements[2], false);
 		}
 	}
+	CancellationToken::ThrowIfCancelled(cancellation);
 
 	surface.DegreeU = interpolatedSurface.DegreeU;
 	surface.DegreeV = interpolatedSurface.DegreeV;
@@ -2534,8 +4759,15 @@ void LNLib::NurbsSurface::CreateGordonSurface(const std::vector<LN_NurbsCurve>&
 	surface.ControlPoints = controlPoints;
 }
 
+std::future<LNLib::LN_NurbsSurface> LNLib::NurbsSurface::CreateGordonSurfaceAsync(const std::vector<LN_NurbsCurve>& uCurves, const std::vector<LN_NurbsCurve>& vCurves, const std::vector<std::vector<XYZ>>& intersectionPoints, ParallelExecutor* executor, const CancellationToken* cancellation)
+{
+	GordonSurfaceJob job = { uCurves, vCurves, intersectionPoints, executor, cancellation };
+	return std::async(std::launch::async, job);
+}
+
 void LNLib::NurbsSurface::CreateCoonsSurface(const LN_NurbsCurve& curve0, const LN_NurbsCurve& curve1, const LN_NurbsCurve& curve2, const LN_NurbsCurve& curve3, LN_NurbsSurface& surface)
 {
+	LNLIB_SCOPED_TIMER("NurbsSurface::CreateCoonsSurface");
 	std::vector<LN_NurbsCurve> nurbs(4);
 	nurbs.emplace_back(curve0);
 	nurbs.emplace_back(curve1);
@@ -2732,21 +4964,15 @@ void LNLib::NurbsSurface::CreateCoonsSurface(const LN_NurbsCurve& curve0, const
 		auto insertElements = KnotVectorUtils::GetInsertedKnotElements(knotVectorsU);
 		if (insertElements[0].size() > 0)
 		{
-			LN_NurbsSurface temp;
-			RefineKnotVector(ruledSurface0, insertElements[0], true, temp);
-			ruledSurface0 = temp;
+			RefineKnotVector(ruledSurface0, insertElements[0], true);
 		}
 		if (insertElements[1].size() > 0)
 		{
-			LN_NurbsSurface temp;
-			RefineKnotVector(ruledSurface1, insertElements[1], true, temp);
-			ruledSurface1 = temp;
+			RefineKnotVector(ruledSurface1, insertElements[1], true);
 		}
 		if (insertElements[2].size() > 0)
 		{
-			LN_NurbsSurface temp;
-			RefineKnotVector(bilinearSurface, insertElements[2], true, temp);
-			bilinearSurface = temp;
+			RefineKnotVector(bilinearSurface, insertElements[2], true);
 		}
 	}
 
@@ -2759,21 +4985,15 @@ void LNLib::NurbsSurface::CreateCoonsSurface(const LN_NurbsCurve& curve0, const
 		auto insertElements = KnotVectorUtils::GetInsertedKnotElements(knotVectorsV);
 		if (insertElements[0].size() > 0)
 		{
-			LN_NurbsSurface temp;
-			RefineKnotVector(ruledSurface0, insertElements[0], false, temp);
-			ruledSurface0 = temp;
+			RefineKnotVector(ruledSurface0, insertElements[0], false);
 		}
 		if (insertElements[1].size() > 0)
 		{
-			LN_NurbsSurface temp;
-			RefineKnotVector(ruledSurface1, insertElements[1], false, temp);
-			ruledSurface1 = temp;
+			RefineKnotVector(ruledSurface1, insertElements[1], false);
 		}
 		if (insertElements[2].size() > 0)
 		{
-			LN_NurbsSurface temp;
-			RefineKnotVector(bilinearSurface, insertElements[2], false, temp);
-			bilinearSurface = temp;
+			RefineKnotVector(bilinearSurface, insertElements[2], false);
 		}
 	}
 
@@ -2796,8 +5016,118 @@ void LNLib::NurbsSurface::CreateCoonsSurface(const LN_NurbsCurve& curve0, const
 	surface.ControlPoints = controlPoints;
 }
 
+double LNLib::NurbsSurface::ApproximateArea(const LN_NurbsSurface& surface, double tolerance, ParallelExecutor* executor, const CancellationToken* cancellation)
+{
+	LNLIB_SCOPED_TIMER("NurbsSurface::ApproximateArea");
+	VALIDATE_ARGUMENT(tolerance > 0, "tolerance", "Tolerance must greater than zero.");
+	Check(surface);
+
+	std::vector<double> uniqueKvU = surface.KnotVectorU;
+	uniqueKvU.erase(unique(uniqueKvU.begin(), uniqueKvU.end()), uniqueKvU.end());
+	std::vector<double> uniqueKvV = surface.KnotVectorV;
+	uniqueKvV.erase(unique(uniqueKvV.begin(), uniqueKvV.end()), uniqueKvV.end());
+
+	PatchAreaTask task(surface, uniqueKvU, uniqueKvV, tolerance, cancellation);
+	Parallel::For(task.Areas.size(), task, executor);
+
+	double area = 0.0;
+	for (int i = 0; i < task.Areas.size(); i++)
+	{
+		area += task.Areas[i];
+	}
+	return area;
+}
+
+std::future<double> LNLib::NurbsSurface::ApproximateAreaAsync(const LN_NurbsSurface& surface, double tolerance, ParallelExecutor* executor, const CancellationToken* cancellation)
+{
+	SurfaceAreaJob job = { surface, tolerance, executor, cancellation };
+	return std::async(std::launch::async, job);
+}
+
+double LNLib::NurbsSurface::ApproximateArea(const LN_NurbsSurface& surface, double tolerance, int maxEvaluations, double* error, const CancellationToken* cancellation)
+{
+	LNLIB_SCOPED_TIMER("NurbsSurface::ApproximateArea");
+	VALIDATE_ARGUMENT(tolerance > 0, "tolerance", "Tolerance must greater than zero.");
+	Check(surface);
+
+	std::vector<double> uniqueKvU = surface.KnotVectorU;
+	uniqueKvU.erase(unique(uniqueKvU.begin(), uniqueKvU.end()), uniqueKvU.end());
+	std::vector<double> uniqueKvV = surface.KnotVectorV;
+	uniqueKvV.erase(unique(uniqueKvV.begin(), uniqueKvV.end()), uniqueKvV.end());
+
+	int cellEvaluations = Integrator::GaussKronrodAbscissae.size() * Integrator::GaussKronrodAbscissae.size();
+	std::vector<KronrodAreaCell> cells;
+	cells.reserve((uniqueKvU.size() - 1) * (uniqueKvV.size() - 1));
+	int evaluations = 0;
+	double totalError = 0.0;
+	for (int i = 0; i < uniqueKvU.size() - 1; i++)
+	{
+		for (int j = 0; j < uniqueKvV.size() - 1; j++)
+		{
+			KronrodAreaCell cell = { uniqueKvU[i], uniqueKvU[i + 1], uniqueKvV[j], uniqueKvV[j + 1], 0.0, 0.0, 0.0, 0.0 };
+			EvaluateKronrodAreaCell(surface, cell);
+			evaluations += cellEvaluations;
+			totalError += cell.Error;
+			cells.emplace_back(cell);
+		}
+	}
+	std::make_heap(cells.begin(), cells.end(), KronrodAreaCellLess());
+
+	while (!cells.empty() && totalError > tolerance && evaluations + 2 * cellEvaluations <= maxEvaluations)
+	{
+		CancellationToken::ThrowIfCancelled(cancellation);
+		KronrodAreaCell worst = cells.front();
+		bool isU = worst.ErrorU >= worst.ErrorV;
+		double start = isU ? worst.StartU : worst.StartV;
+		double end = isU ? worst.EndU : worst.EndV;
+		double middle = (start + end) / 2.0;
+		if (middle <= start || middle >= end)
+		{
+			break;
+		}
+		std::pop_heap(cells.begin(), cells.end(), KronrodAreaCellLess());
+		cells.pop_back();
+
+		KronrodAreaCell first = worst;
+		KronrodAreaCell second = worst;
+		if (isU)
+		{
+			first.EndU = middle;
+			second.StartU = middle;
+		}
+		else
+		{
+			first.EndV = middle;
+			second.StartV = middle;
+		}
+		EvaluateKronrodAreaCell(surface, first);
+		EvaluateKronrodAreaCell(surface, second);
+		evaluations += 2 * cellEvaluations;
+		totalError += first.Error + second.Error - worst.Error;
+
+		cells.emplace_back(first);
+		std::push_heap(cells.begin(), cells.end(), KronrodAreaCellLess());
+		cells.emplace_back(second);
+		std::push_heap(cells.begin(), cells.end(), KronrodAreaCellLess());
+	}
+
+	double area = 0.0;
+	double estimate = 0.0;
+	for (int i = 0; i < cells.size(); i++)
+	{
+		area += cells[i].Value;
+		estimate += cells[i].Error;
+	}
+	if (error != nullptr)
+	{
+		*error = estimate;
+	}
+	return area;
+}
+
 double LNLib::NurbsSurface::ApproximateArea(const LN_NurbsSurface& surface, IntegratorType type)
 {
+	LNLIB_SCOPED_TIMER("NurbsSurface::ApproximateArea");
 	LN_NurbsSurface reSurface;
 	Reparametrize(surface, 0.0, 1.0, 0.0, 1.0, reSurface);
 
@@ -2921,6 +5251,12 @@ double LNLib::NurbsSurface::ApproximateArea(const LN_NurbsSurface& surface, Inte
 			}
 			break;
 		}
+		case IntegratorType::GaussKronrod:
+		{
+			int patches = (controlPoints.size() - degreeU) * (controlPoints[0].size() - degreeV);
+			area = ApproximateArea(reSurface, Constants::DistanceEpsilon, patches * MaxKronrodAreaEvaluationsPerPatch);
+			break;
+		}
 		default:
 			break;
 	}
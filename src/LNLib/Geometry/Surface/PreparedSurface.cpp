@@ -0,0 +1,535 @@
+/*
+ * Author:
+ * 2024/10/14 - Yuqing Liang (BIMCoder Liang)
+ * bim.frankliang@foxmail.com
+ * 微信公众号：BIMCoder梁老师
+ *
+ * Use of this source code is governed by a GPL-3.0 license that can be found in
+ * the LICENSE file.
+ */
+
+#include "PreparedSurface.h"
+#include "NurbsSurface.h"
+#include "BsplineCurve.h"
+#include "Polynomials.h"
+#include "ControlPointsUtils.h"
+#include "MathUtils.h"
+#include "UV.h"
+#include "XYZ.h"
+#include "XYZW.h"
+#include "Constants.h"
+#include "LNLibExceptions.h"
+#include <algorithm>
+#include <utility>
+
+namespace LNLib
+{
+	/// <summary>
+	/// The NURBS Book 2nd Edition Page137
+	/// Equation (4.20), S derivatives from Sw derivatives stored with the given row stride.
+	/// With unit weights the xyz part already is the result.
+	/// </summary>
+	void SurfaceHodographsToDerivatives(const XYZW* ders, int derivative, bool isRational, XYZ* derivatives)
+	{
+		int stride = derivative + 1;
+		for (int k = 0; k <= derivative; k++)
+		{
+			for (int l = 0; l <= derivative; l++)
+			{
+				if (k + l > derivative)
+				{
+					derivatives[k * stride + l] = XYZ(0, 0, 0);
+					continue;
+				}
+				XYZ v = ders[k * stride + l].ToXYZ(false);
+				if (isRational)
+				{
+					for (int j = 1; j <= l; j++)
+					{
+						v = v - MathUtils::Binomial(l, j) * ders[j].GetW() * derivatives[k * stride + l - j];
+					}
+					for (int i = 1; i <= k; i++)
+					{
+						v = v - MathUtils::Binomial(k, i) * ders[i * stride].GetW() * derivatives[(k - i) * stride + l];
+						XYZ v2 = XYZ(0, 0, 0);
+						for (int j = 1; j <= l; j++)
+						{
+							v2 = v2 + MathUtils::Binomial(l, j) * ders[i * stride + j].GetW() * derivatives[(k - i) * stride + l - j];
+						}
+						v = v - MathUtils::Binomial(k, i) * v2;
+					}
+					v = v / ders[0].GetW();
+				}
+				derivatives[k * stride + l] = v;
+			}
+		}
+	}
+
+	const int MaxSurfaceLevelsOfDetail = 6;
+
+	/// <summary>
+	/// The NURBS Book 2nd Edition Page24
+	/// de Casteljau subdivision of every row (u) or column (v) at 1/2,
+	/// first receives the net of the first half and net is replaced by the net of the second half.
+	/// </summary>
+	void SplitBezierPatchInHalf(std::vector<std::vector<XYZW>>& net, bool isUDirection, std::vector<std::vector<XYZW>>& first)
+	{
+		int rows = net.size();
+		int columns = net[0].size();
+		first = net;
+		if (isUDirection)
+		{
+			for (int j = 0; j < columns; j++)
+			{
+				for (int r = 1; r < rows; r++)
+				{
+					for (int i = 0; i < rows - r; i++)
+					{
+						net[i][j] = 0.5 * (net[i][j] + net[i + 1][j]);
+					}
+					first[r][j] = net[0][j];
+				}
+			}
+		}
+		else
+		{
+			for (int i = 0; i < rows; i++)
+			{
+				for (int r = 1; r < columns; r++)
+				{
+					for (int j = 0; j < columns - r; j++)
+					{
+						net[i][j] = 0.5 * (net[i][j] + net[i][j + 1]);
+					}
+					first[i][r] = net[i][0];
+				}
+			}
+		}
+	}
+
+	/// <summary>
+	/// Bound of the distance from a Bezier patch to the two triangles of its corners split along c00-c11.
+	/// The bilinear patch B of the corners has control points B(i/p, j/q), a polynomial patch differs from B by at most max |P_ij - B(i/p, j/q)|
+	/// and B from the triangles by a quarter of the twist c00 - c10 - c01 + c11.
+	/// The rational weights move the parameters of B by up to another quarter twist.
+	/// </summary>
+	double GetPatchTriangleDeviation(const std::vector<std::vector<XYZW>>& net, bool isRational)
+	{
+		int p = net.size() - 1;
+		int q = net[0].size() - 1;
+		XYZ c00 = net[0][0].ToXYZ(true);
+		XYZ c10 = net[p][0].ToXYZ(true);
+		XYZ c01 = net[0][q].ToXYZ(true);
+		XYZ c11 = net[p][q].ToXYZ(true);
+		double deviation = 0.0;
+		for (int i = 0; i <= p; i++)
+		{
+			double s = static_cast<double>(i) / p;
+			for (int j = 0; j <= q; j++)
+			{
+				double t = static_cast<double>(j) / q;
+				XYZ bilinear = (1 - s) * (1 - t) * c00 + s * (1 - t) * c10 + (1 - s) * t * c01 + s * t * c11;
+				deviation = std::max(deviation, net[i][j].ToXYZ(true).Distance(bilinear));
+			}
+		}
+		double twist = (c00 - c10 - c01 + c11).Length();
+		return deviation + (isRational ? 0.5 : 0.25) * twist;
+	}
+}
+
+LNLib::PreparedSurface::PreparedSurface(const LN_NurbsSurface& surface)
+	: _surface(surface), _checked(NurbsSurface::Check(_surface)), _isLevelsComplete(false), _isClosedU(false), _isClosedV(false)
+{
+	_spanKnotsU = _surface.KnotVectorU;
+	_spanKnotsU.erase(std::unique(_spanKnotsU.begin(), _spanKnotsU.end()), _spanKnotsU.end());
+	_spanKnotsV = _surface.KnotVectorV;
+	_spanKnotsV.erase(std::unique(_spanKnotsV.begin(), _spanKnotsV.end()), _spanKnotsV.end());
+}
+
+const LNLib::LN_NurbsSurface& LNLib::PreparedSurface::Surface() const
+{
+	return _surface;
+}
+
+const LNLib::LN_CheckedNurbsSurface& LNLib::PreparedSurface::Checked() const
+{
+	return _checked;
+}
+
+const std::vector<double>& LNLib::PreparedSurface::GetSpanKnotsU() const
+{
+	return _spanKnotsU;
+}
+
+const std::vector<double>& LNLib::PreparedSurface::GetSpanKnotsV() const
+{
+	return _spanKnotsV;
+}
+
+const std::vector<LNLib::LN_NurbsSurface>& LNLib::PreparedSurface::GetBeziers() const
+{
+	std::call_once(_beziersFlag, &PreparedSurface::ComputeBeziers, this);
+	return _beziers;
+}
+
+const std::vector<LNLib::LN_BoundingBox>& LNLib::PreparedSurface::GetSpanBoundingBoxes() const
+{
+	std::call_once(_boxesFlag, &PreparedSurface::ComputeSpanBoundingBoxes, this);
+	return _boxes;
+}
+
+const std::vector<std::vector<std::vector<LNLib::XYZW>>>& LNLib::PreparedSurface::GetPowerBasisCoefficients() const
+{
+	std::call_once(_powerBasisFlag, &PreparedSurface::ComputePowerBasisCoefficients, this);
+	return _powerBasis;
+}
+
+bool LNLib::PreparedSurface::IsClosed(bool isUDirection) const
+{
+	std::call_once(_closedFlag, &PreparedSurface::ComputeIsClosed, this);
+	return isUDirection ? _isClosedU : _isClosedV;
+}
+
+const std::vector<std::vector<LNLib::LN_BsplineSurface<LNLib::XYZW>>>& LNLib::PreparedSurface::GetHodographs() const
+{
+	std::call_once(_hodographsFlag, &PreparedSurface::ComputeHodographs, this);
+	return _hodographs;
+}
+
+void LNLib::PreparedSurface::ComputeBeziers() const
+{
+	_beziers = NurbsSurface::DecomposeToBeziers(_surface);
+	_beziers.resize((_spanKnotsU.size() - 1) * (_spanKnotsV.size() - 1));
+}
+
+void LNLib::PreparedSurface::ComputeSpanBoundingBoxes() const
+{
+	const std::vector<LN_NurbsSurface>& beziers = GetBeziers();
+	_boxes.resize(beziers.size());
+	for (int p = 0; p < static_cast<int>(beziers.size()); p++)
+	{
+		_boxes[p] = ControlPointsUtils::ComputeBoundingBox(beziers[p].ControlPoints);
+	}
+}
+
+void LNLib::PreparedSurface::ComputePowerBasisCoefficients() const
+{
+	const std::vector<LN_NurbsSurface>& beziers = GetBeziers();
+	std::vector<std::vector<double>> matrixU = Polynomials::BezierToPowerMatrix(_surface.DegreeU);
+	std::vector<std::vector<double>> matrixV = Polynomials::BezierToPowerMatrix(_surface.DegreeV);
+	std::vector<std::vector<double>> transposedV;
+	MathUtils::Transpose(matrixV, transposedV);
+
+	_powerBasis.resize(beziers.size());
+	for (int p = 0; p < static_cast<int>(beziers.size()); p++)
+	{
+		std::vector<std::vector<XYZW>> temp = ControlPointsUtils::Multiply(matrixU, beziers[p].ControlPoints);
+		_powerBasis[p] = ControlPointsUtils::Multiply(temp, transposedV);
+	}
+}
+
+void LNLib::PreparedSurface::ComputeIsClosed() const
+{
+	_isClosedU = NurbsSurface::IsClosed(_surface, true);
+	_isClosedV = NurbsSurface::IsClosed(_surface, false);
+}
+
+void LNLib::PreparedSurface::ComputeHodographs() const
+{
+	int degreeU = _surface.DegreeU;
+	int degreeV = _surface.DegreeV;
+	const std::vector<double>& knotVectorU = _surface.KnotVectorU;
+	const std::vector<double>& knotVectorV = _surface.KnotVectorV;
+	const std::vector<std::vector<XYZW>>& controlPoints = _surface.ControlPoints;
+	int n = controlPoints.size() - 1;
+	int m = controlPoints[0].size() - 1;
+
+	// Differentiate every column in u, the nets of order k have n - k + 1 rows.
+	std::vector<std::vector<std::vector<XYZW>>> netsU(degreeU + 1, std::vector<std::vector<XYZW>>(n + 1, std::vector<XYZW>(m + 1)));
+	LN_BsplineCurve<XYZW> column;
+	column.Degree = degreeU;
+	column.KnotVector = knotVectorU;
+	column.ControlPoints.resize(n + 1);
+	for (int j = 0; j <= m; j++)
+	{
+		for (int i = 0; i <= n; i++)
+		{
+			column.ControlPoints[i] = controlPoints[i][j];
+		}
+		std::vector<std::vector<XYZW>> PK = BsplineCurve::ComputeControlPointsOfDerivatives(column, degreeU, 0, n);
+		for (int k = 0; k <= degreeU; k++)
+		{
+			for (int i = 0; i <= n - k; i++)
+			{
+				netsU[k][i][j] = PK[k][i];
+			}
+		}
+	}
+
+	_hodographs.assign(degreeU + 1, std::vector<LN_BsplineSurface<XYZW>>(degreeV + 1));
+	LN_BsplineCurve<XYZW> row;
+	row.Degree = degreeV;
+	row.KnotVector = knotVectorV;
+	for (int k = 0; k <= degreeU; k++)
+	{
+		for (int l = 0; l <= degreeV; l++)
+		{
+			LN_BsplineSurface<XYZW>& hodograph = _hodographs[k][l];
+			hodograph.DegreeU = degreeU - k;
+			hodograph.DegreeV = degreeV - l;
+			hodograph.KnotVectorU.assign(knotVectorU.begin() + k, knotVectorU.end() - k);
+			hodograph.KnotVectorV.assign(knotVectorV.begin() + l, knotVectorV.end() - l);
+			hodograph.ControlPoints.resize(n - k + 1);
+		}
+		for (int i = 0; i <= n - k; i++)
+		{
+			row.ControlPoints = netsU[k][i];
+			std::vector<std::vector<XYZW>> PL = BsplineCurve::ComputeControlPointsOfDerivatives(row, degreeV, 0, m);
+			for (int l = 0; l <= degreeV; l++)
+			{
+				_hodographs[k][l].ControlPoints[i].assign(PL[l].begin(), PL[l].begin() + m - l + 1);
+			}
+		}
+	}
+}
+
+std::vector<std::vector<LNLib::XYZ>> LNLib::PreparedSurface::ComputeDerivatives(int derivative, UV uv) const
+{
+	std::vector<XYZ> flat((derivative + 1) * (derivative + 1));
+	ComputeDerivatives(derivative, &uv, 1, flat.data());
+
+	std::vector<std::vector<XYZ>> derivatives(derivative + 1);
+	for (int k = 0; k <= derivative; k++)
+	{
+		derivatives[k].assign(flat.begin() + k * (derivative + 1), flat.begin() + (k + 1) * (derivative + 1));
+	}
+	return derivatives;
+}
+
+void LNLib::PreparedSurface::ComputeDerivatives(int derivative, const UV* uvs, int count, XYZ* derivatives) const
+{
+	VALIDATE_ARGUMENT(derivative > 0, "derivative", "derivative must greater than zero.");
+	for (int i = 0; i < count; i++)
+	{
+		VALIDATE_ARGUMENT_RANGE(uvs[i].GetU(), _spanKnotsU[0], _spanKnotsU[_spanKnotsU.size() - 1]);
+		VALIDATE_ARGUMENT_RANGE(uvs[i].GetV(), _spanKnotsV[0], _spanKnotsV[_spanKnotsV.size() - 1]);
+	}
+
+	const std::vector<std::vector<LN_BsplineSurface<XYZW>>>& hodographs = GetHodographs();
+	int degreeU = _surface.DegreeU;
+	int degreeV = _surface.DegreeV;
+	int du = std::min(derivative, degreeU);
+	int dv = std::min(derivative, degreeV);
+	int stride = derivative + 1;
+	bool isRational = _checked.IsRational();
+
+	// Hodographs [k][l] have knots u_k..u_r-k and v_l..v_s-l, so their spans are the spans of Sw shifted by k and l,
+	// one cursor per direction serves every order and the basis of [k][0] in u and [0][l] in v is shared.
+	int sizeNu = (du + 1) * (degreeU + 1);
+	int sizeNv = (dv + 1) * (degreeV + 1);
+	double stackNu[Constants::MaxStackBasisSize];
+	double stackNv[Constants::MaxStackBasisSize];
+	XYZW stackDers[Constants::MaxStackBasisSize];
+	std::vector<double> heapNu;
+	std::vector<double> heapNv;
+	std::vector<XYZW> heapDers;
+	double* Nu = stackNu;
+	double* Nv = stackNv;
+	XYZW* ders = stackDers;
+	if (sizeNu > Constants::MaxStackBasisSize)
+	{
+		heapNu.resize(sizeNu);
+		Nu = heapNu.data();
+	}
+	if (sizeNv > Constants::MaxStackBasisSize)
+	{
+		heapNv.resize(sizeNv);
+		Nv = heapNv.data();
+	}
+	if (stride * stride > Constants::MaxStackBasisSize)
+	{
+		heapDers.resize(stride * stride);
+		ders = heapDers.data();
+	}
+
+	KnotSpanCursor cursorU(degreeU, _surface.KnotVectorU);
+	KnotSpanCursor cursorV(degreeV, _surface.KnotVectorV);
+	for (int i = 0; i < count; i++)
+	{
+		double u = uvs[i].GetU();
+		double v = uvs[i].GetV();
+		int spanU = cursorU.Find(u);
+		int spanV = cursorV.Find(v);
+		for (int k = 0; k <= du; k++)
+		{
+			Polynomials::BasisFunctions(spanU - k, degreeU - k, hodographs[k][0].KnotVectorU, u, &Nu[k * (degreeU + 1)]);
+		}
+		for (int l = 0; l <= dv; l++)
+		{
+			Polynomials::BasisFunctions(spanV - l, degreeV - l, hodographs[0][l].KnotVectorV, v, &Nv[l * (degreeV + 1)]);
+		}
+
+		std::fill(ders, ders + stride * stride, XYZW(0, 0, 0, 0));
+		for (int k = 0; k <= du; k++)
+		{
+			int p = degreeU - k;
+			const double* nu = &Nu[k * (degreeU + 1)];
+			int dd = std::min(derivative - k, dv);
+			for (int l = 0; l <= dd; l++)
+			{
+				int q = degreeV - l;
+				const double* nv = &Nv[l * (degreeV + 1)];
+				const std::vector<std::vector<XYZW>>& net = hodographs[k][l].ControlPoints;
+				int vind = spanV - l - q;
+				XYZW point(0, 0, 0, 0);
+				for (int r = 0; r <= p; r++)
+				{
+					const XYZW* points = &net[spanU - k - p + r][vind];
+					XYZW temp(0, 0, 0, 0);
+					for (int s = 0; s <= q; s++)
+					{
+						temp += nv[s] * points[s];
+					}
+					point += nu[r] * temp;
+				}
+				ders[k * stride + l] = point;
+			}
+		}
+		SurfaceHodographsToDerivatives(ders, derivative, isRational, derivatives + i * stride * stride);
+	}
+}
+
+const std::vector<LNLib::LN_SurfaceLevelOfDetail>& LNLib::PreparedSurface::GetLevelsOfDetail() const
+{
+	std::lock_guard<std::mutex> lock(_levelsMutex);
+	while (!_isLevelsComplete)
+	{
+		ComputeNextLevelOfDetail();
+	}
+	return _levels;
+}
+
+const LNLib::LN_SurfaceLevelOfDetail& LNLib::PreparedSurface::GetLevelOfDetail(double maxError) const
+{
+	VALIDATE_ARGUMENT(maxError >= 0, "maxError", "MaxError must not be negative.");
+
+	std::lock_guard<std::mutex> lock(_levelsMutex);
+	for (int k = 0; ; k++)
+	{
+		if (k == static_cast<int>(_levels.size()))
+		{
+			if (_isLevelsComplete)
+			{
+				return _levels[k - 1];
+			}
+			ComputeNextLevelOfDetail();
+		}
+		if (_levels[k].Error <= maxError)
+		{
+			return _levels[k];
+		}
+	}
+}
+
+void LNLib::PreparedSurface::ComputeNextLevelOfDetail() const
+{
+	const std::vector<LN_NurbsSurface>& beziers = GetBeziers();
+	int patchesU = _spanKnotsU.size() - 1;
+	int patchesV = _spanKnotsV.size() - 1;
+	bool isRational = _checked.IsRational();
+
+	// Cell (i, j) of a level with count cells per patch side is cells[i * patchesV * count + j], its halves are cells (2i + a, 2j + b) of the next level.
+	std::vector<std::vector<std::vector<XYZW>>>& cells = _levelCells;
+	int count = 1;
+	if (_levels.empty())
+	{
+		// Capacity for every level keeps references returned by GetLevelOfDetail valid while levels are added.
+		_levels.reserve(MaxSurfaceLevelsOfDetail);
+		cells.resize(beziers.size());
+		for (int p = 0; p < static_cast<int>(beziers.size()); p++)
+		{
+			cells[p] = beziers[p].ControlPoints;
+		}
+	}
+	else
+	{
+		count = 1 << (_levels.size() - 1);
+		int cellsU = patchesU * count;
+		int cellsV = patchesV * count;
+		std::vector<std::vector<std::vector<XYZW>>> halves(4 * cells.size());
+		std::vector<std::vector<XYZW>> firstU;
+		std::vector<std::vector<XYZW>> firstV;
+		for (int i = 0; i < cellsU; i++)
+		{
+			for (int j = 0; j < cellsV; j++)
+			{
+				std::vector<std::vector<XYZW>>& cell = cells[i * cellsV + j];
+				SplitBezierPatchInHalf(cell, true, firstU);
+				SplitBezierPatchInHalf(firstU, false, halves[(2 * i) * 2 * cellsV + 2 * j]);
+				halves[(2 * i) * 2 * cellsV + 2 * j + 1].swap(firstU);
+				SplitBezierPatchInHalf(cell, false, firstV);
+				halves[(2 * i + 1) * 2 * cellsV + 2 * j].swap(firstV);
+				halves[(2 * i + 1) * 2 * cellsV + 2 * j + 1].swap(cell);
+			}
+		}
+		cells.swap(halves);
+		count *= 2;
+	}
+
+	int cellsU = patchesU * count;
+	int cellsV = patchesV * count;
+	LN_SurfaceLevelOfDetail lod;
+	lod.Error = 0.0;
+	for (int c = 0; c < static_cast<int>(cells.size()); c++)
+	{
+		lod.Error = std::max(lod.Error, GetPatchTriangleDeviation(cells[c], isRational));
+	}
+
+	// Vertex (i, j) is i * (cellsV + 1) + j, a grid uniform inside every span.
+	std::vector<UV> uvs((cellsU + 1) * (cellsV + 1));
+	for (int i = 0; i <= cellsU; i++)
+	{
+		int spanU = std::min(i / count, patchesU - 1);
+		double u = _spanKnotsU[spanU] + (_spanKnotsU[spanU + 1] - _spanKnotsU[spanU]) * (i - spanU * count) / count;
+		for (int j = 0; j <= cellsV; j++)
+		{
+			int spanV = std::min(j / count, patchesV - 1);
+			double v = _spanKnotsV[spanV] + (_spanKnotsV[spanV + 1] - _spanKnotsV[spanV]) * (j - spanV * count) / count;
+			uvs[i * (cellsV + 1) + j] = UV(u, v);
+		}
+	}
+	std::vector<XYZ> derivatives(4 * uvs.size());
+	ComputeDerivatives(1, uvs.data(), uvs.size(), derivatives.data());
+
+	LN_Mesh& mesh = lod.Mesh;
+	mesh.UVs = uvs;
+	mesh.Vertices.resize(uvs.size());
+	mesh.Normals.resize(uvs.size());
+	for (int k = 0; k < static_cast<int>(uvs.size()); k++)
+	{
+		mesh.Vertices[k] = derivatives[4 * k];
+		mesh.Normals[k] = derivatives[4 * k + 2].Normalize().CrossProduct(derivatives[4 * k + 1]).Normalize();
+	}
+	mesh.Indices.reserve(6 * cellsU * cellsV);
+	for (int i = 0; i < cellsU; i++)
+	{
+		for (int j = 0; j < cellsV; j++)
+		{
+			int a = i * (cellsV + 1) + j;
+			int b = a + cellsV + 1;
+			mesh.Indices.emplace_back(a);
+			mesh.Indices.emplace_back(b);
+			mesh.Indices.emplace_back(b + 1);
+			mesh.Indices.emplace_back(a);
+			mesh.Indices.emplace_back(b + 1);
+			mesh.Indices.emplace_back(a + 1);
+		}
+	}
+	_levels.emplace_back(std::move(lod));
+
+	if (_levels.back().Error <= Constants::DistanceEpsilon || _levels.size() == MaxSurfaceLevelsOfDetail)
+	{
+		_isLevelsComplete = true;
+		std::vector<std::vector<std::vector<XYZW>>>().swap(cells);
+	}
+}
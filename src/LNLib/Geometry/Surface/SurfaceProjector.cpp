@@ -0,0 +1,420 @@
+/*
+ * Author:
+ * 2024/10/14 - Yuqing Liang (BIMCoder Liang)
+ * bim.frankliang@foxmail.com
+ * 微信公众号：BIMCoder梁老师
+ *
+ * Use of this source code is governed by a GPL-3.0 license that can be found in
+ * the LICENSE file.
+ */
+
+#include "SurfaceProjector.h"
+#include "NurbsSurface.h"
+#include "Constants.h"
+#include "MathUtils.h"
+#include "ValidationUtils.h"
+#include "UV.h"
+#include "XYZ.h"
+#include "XYZW.h"
+#include "LNLibExceptions.h"
+#include "Instrumentation.h"
+#include <algorithm>
+
+namespace LNLib
+{
+	const int PatchSampleCount = 5;
+	const int SurfaceProjectionBlockSize = 256;
+
+	class PatchDistanceFunction : public ItemDistanceFunction
+	{
+	public:
+		PatchDistanceFunction(const std::vector<XYZ>& samples) : _samples(samples), BestSample(-1), BestDistance(Constants::MaxDistance) {}
+
+		double operator()(int itemIndex, const XYZ& point) override
+		{
+			int sampleSize = PatchSampleCount * PatchSampleCount;
+			double minDistance = Constants::MaxDistance;
+			for (int i = itemIndex * sampleSize; i < (itemIndex + 1) * sampleSize; i++)
+			{
+				double distance = point.Distance(_samples[i]);
+				if (distance < minDistance)
+				{
+					minDistance = distance;
+					if (distance < BestDistance)
+					{
+						BestDistance = distance;
+						BestSample = i;
+					}
+				}
+			}
+			return minDistance;
+		}
+
+	private:
+		const std::vector<XYZ>& _samples;
+
+	public:
+		int BestSample;
+		double BestDistance;
+	};
+
+	class SurfaceProjectionTask : public ParallelTask
+	{
+	public:
+		SurfaceProjectionTask(const SurfaceProjector& projector, const std::vector<XYZ>& points, std::vector<UV>& params)
+			: _projector(projector), _points(points), _params(params) {}
+
+		void operator()(int taskIndex) override
+		{
+			int start = taskIndex * SurfaceProjectionBlockSize;
+			int end = std::min(start + SurfaceProjectionBlockSize, static_cast<int>(_points.size()));
+			for (int i = start; i < end; i++)
+			{
+				_params[i] = _projector.GetParamOnSurface(_points[i]);
+			}
+		}
+
+	private:
+		const SurfaceProjector& _projector;
+		const std::vector<XYZ>& _points;
+		std::vector<UV>& _params;
+	};
+
+	class SurfaceDeviationTask : public ParallelTask
+	{
+	public:
+		SurfaceDeviationTask(const SurfaceProjector& projector, const LN_NurbsSurface& surface, const XYZ* points, int count, const LN_ProjectionOptions& options, LN_PointDeviation* deviations)
+			: _projector(projector), _surface(NurbsSurface::Check(surface)), _points(points), _count(count), _options(options), _deviations(deviations) {}
+
+		void operator()(int taskIndex) override
+		{
+			int start = taskIndex * SurfaceProjectionBlockSize;
+			int end = std::min(start + SurfaceProjectionBlockSize, _count);
+			for (int i = start; i < end; i++)
+			{
+				const XYZ& point = _points[i];
+				UV param = i == start ? _projector.GetParamOnSurface(point, _options) : _projector.GetParamOnSurface(point, _deviations[i - 1].Param, _options);
+
+				std::vector<std::vector<XYZ>> derivatives = NurbsSurface::ComputeRationalSurfaceDerivatives(_surface, 1, param);
+				const XYZ& foot = derivatives[0][0];
+				XYZ normal = derivatives[1][0].CrossProduct(derivatives[0][1]);
+				double distance = point.Distance(foot);
+
+				LN_PointDeviation& deviation = _deviations[i];
+				deviation.Param = param;
+				deviation.FootPoint = foot;
+				deviation.Distance = normal.DotProduct(point - foot) < 0.0 ? -distance : distance;
+			}
+		}
+
+	private:
+		const SurfaceProjector& _projector;
+		LN_CheckedNurbsSurface _surface;
+		const XYZ* _points;
+		int _count;
+		const LN_ProjectionOptions& _options;
+		LN_PointDeviation* _deviations;
+	};
+
+	double ClampOrWrap(double value, double min, double max, bool isClosed)
+	{
+		if (!isClosed)
+		{
+			return std::max(min, std::min(max, value));
+		}
+		if (value < min)
+		{
+			return max - (min - value);
+		}
+		if (value > max)
+		{
+			return min + (value - max);
+		}
+		return value;
+	}
+
+	/// <summary>
+	/// Span range of a local search window, clipped at the ends of an open direction and covering every span when it would wrap onto itself.
+	/// </summary>
+	void GetSearchWindow(int center, int range, int spanCount, bool isClosed, int& first, int& last, bool& isWhole)
+	{
+		isWhole = 2 * range + 1 >= spanCount;
+		first = isWhole ? 0 : center - range;
+		last = isWhole ? spanCount - 1 : center + range;
+		if (!isClosed)
+		{
+			first = std::max(0, first);
+			last = std::min(spanCount - 1, last);
+		}
+	}
+
+	bool IsOnSearchWindowBorder(int position, int first, int last, int spanCount, bool isClosed, bool isWhole)
+	{
+		return !isWhole && ((position == first && (isClosed || first > 0)) || (position == last && (isClosed || last < spanCount - 1)));
+	}
+
+	int FindSearchSpan(const std::vector<double>& spanKnots, double param)
+	{
+		int index = std::upper_bound(spanKnots.begin(), spanKnots.end(), param) - spanKnots.begin() - 1;
+		return std::max(0, std::min(static_cast<int>(spanKnots.size()) - 2, index));
+	}
+}
+
+LNLib::SurfaceProjector::SurfaceProjector(const LN_NurbsSurface& surface)
+{
+	NurbsSurface::Check(surface);
+	_surface = surface;
+	_isClosedU = NurbsSurface::IsClosed(surface, true);
+	_isClosedV = NurbsSurface::IsClosed(surface, false);
+
+	_spanKnotsU = surface.KnotVectorU;
+	_spanKnotsU.erase(std::unique(_spanKnotsU.begin(), _spanKnotsU.end()), _spanKnotsU.end());
+	_spanKnotsV = surface.KnotVectorV;
+	_spanKnotsV.erase(std::unique(_spanKnotsV.begin(), _spanKnotsV.end()), _spanKnotsV.end());
+	const std::vector<double>& uniqueKvU = _spanKnotsU;
+	const std::vector<double>& uniqueKvV = _spanKnotsV;
+	int patchesV = uniqueKvV.size() - 1;
+
+	std::vector<LN_BoundingBox> boxes = NurbsSurface::GetSpanBoundingBoxes(surface);
+	for (int p = 0; p < boxes.size(); p++)
+	{
+		int spanU = p / patchesV;
+		int spanV = p % patchesV;
+		std::vector<double> uParams(PatchSampleCount);
+		std::vector<double> vParams(PatchSampleCount);
+		for (int i = 0; i < PatchSampleCount; i++)
+		{
+			double ratio = static_cast<double>(i) / (PatchSampleCount - 1);
+			uParams[i] = uniqueKvU[spanU] + (uniqueKvU[spanU + 1] - uniqueKvU[spanU]) * ratio;
+			vParams[i] = uniqueKvV[spanV] + (uniqueKvV[spanV + 1] - uniqueKvV[spanV]) * ratio;
+		}
+		std::vector<std::vector<XYZ>> grid;
+		NurbsSurface::EvaluateGrid(surface, uParams, vParams, grid);
+		for (int i = 0; i < PatchSampleCount; i++)
+		{
+			for (int j = 0; j < PatchSampleCount; j++)
+			{
+				_samples.emplace_back(grid[i][j]);
+				_sampleParams.emplace_back(UV(uParams[i], vParams[j]));
+			}
+		}
+	}
+	_hierarchy.Build(boxes);
+}
+
+LNLib::UV LNLib::SurfaceProjector::GetParamOnSurface(const XYZ& givenPoint) const
+{
+	return GetParamOnSurface(givenPoint, LN_ProjectionOptions());
+}
+
+LNLib::UV LNLib::SurfaceProjector::GetParamOnSurface(const XYZ& givenPoint, const LN_ProjectionOptions& options) const
+{
+	bool isConverged = false;
+	return Project(givenPoint, options, isConverged);
+}
+
+LNLib::UV LNLib::SurfaceProjector::GetParamOnSurface(const XYZ& givenPoint, UV previousParam, const LN_ProjectionOptions& options) const
+{
+	VALIDATE_ARGUMENT_RANGE(previousParam.GetU(), _spanKnotsU[0], _spanKnotsU[_spanKnotsU.size() - 1]);
+	VALIDATE_ARGUMENT_RANGE(previousParam.GetV(), _spanKnotsV[0], _spanKnotsV[_spanKnotsV.size() - 1]);
+	VALIDATE_ARGUMENT(options.LocalSearchRange >= 0, "options", "LocalSearchRange must greater than or equals zero.");
+
+	bool isConverged = false;
+	return Project(givenPoint, previousParam, options, isConverged);
+}
+
+LNLib::EvaluationStatus LNLib::SurfaceProjector::TryGetParamOnSurface(const XYZ& givenPoint, UV& param, const LN_ProjectionOptions& options) const noexcept
+{
+	if (MathUtils::IsNaN(givenPoint.Length()) || options.MaxIterations < 0)
+	{
+		return EvaluationStatus::InvalidArgument;
+	}
+	try
+	{
+		bool isConverged = false;
+		param = Project(givenPoint, options, isConverged);
+		return isConverged ? EvaluationStatus::Success : EvaluationStatus::NotConverged;
+	}
+	catch (...)
+	{
+		return EvaluationStatus::Failed;
+	}
+}
+
+LNLib::EvaluationStatus LNLib::SurfaceProjector::TryGetParamOnSurface(const XYZ& givenPoint, UV previousParam, UV& param, const LN_ProjectionOptions& options, ParameterRangePolicy policy) const noexcept
+{
+	if (MathUtils::IsNaN(givenPoint.Length()) || options.MaxIterations < 0 || options.LocalSearchRange < 0)
+	{
+		return EvaluationStatus::InvalidArgument;
+	}
+	double u = previousParam.GetU();
+	double v = previousParam.GetV();
+	EvaluationStatus status = ValidationUtils::ResolveParameter(u, _spanKnotsU[0], _spanKnotsU[_spanKnotsU.size() - 1], policy);
+	if (status == EvaluationStatus::Success)
+	{
+		status = ValidationUtils::ResolveParameter(v, _spanKnotsV[0], _spanKnotsV[_spanKnotsV.size() - 1], policy);
+	}
+	if (status != EvaluationStatus::Success)
+	{
+		return status;
+	}
+	try
+	{
+		bool isConverged = false;
+		param = Project(givenPoint, UV(u, v), options, isConverged);
+		return isConverged ? EvaluationStatus::Success : EvaluationStatus::NotConverged;
+	}
+	catch (...)
+	{
+		return EvaluationStatus::Failed;
+	}
+}
+
+LNLib::UV LNLib::SurfaceProjector::Project(const XYZ& givenPoint, const LN_ProjectionOptions& options, bool& isConverged) const
+{
+	PatchDistanceFunction function(_samples);
+	double minDistance = Constants::MaxDistance;
+	_hierarchy.FindNearest(givenPoint, function, minDistance);
+	UV param = function.BestSample < 0 ? UV(_surface.KnotVectorU[0], _surface.KnotVectorV[0]) : _sampleParams[function.BestSample];
+	return Refine(givenPoint, param, options, isConverged);
+}
+
+LNLib::UV LNLib::SurfaceProjector::Project(const XYZ& givenPoint, UV previousParam, const LN_ProjectionOptions& options, bool& isConverged) const
+{
+	UV param = Refine(givenPoint, previousParam, options, isConverged);
+	double distance = NurbsSurface::GetPointOnSurface(_surface, param).Distance(givenPoint);
+
+	int patchesU = _spanKnotsU.size() - 1;
+	int patchesV = _spanKnotsV.size() - 1;
+	int firstU, lastU, firstV, lastV;
+	bool isWholeU, isWholeV;
+	GetSearchWindow(FindSearchSpan(_spanKnotsU, previousParam.GetU()), options.LocalSearchRange, patchesU, _isClosedU, firstU, lastU, isWholeU);
+	GetSearchWindow(FindSearchSpan(_spanKnotsV, previousParam.GetV()), options.LocalSearchRange, patchesV, _isClosedV, firstV, lastV, isWholeV);
+
+	PatchDistanceFunction function(_samples);
+	double localDistance = Constants::MaxDistance;
+	int positionU = firstU;
+	int positionV = firstV;
+	for (int i = firstU; i <= lastU; i++)
+	{
+		for (int j = firstV; j <= lastV; j++)
+		{
+			int patch = ((i + patchesU) % patchesU) * patchesV + (j + patchesV) % patchesV;
+			double patchDistance = function(patch, givenPoint);
+			if (patchDistance < localDistance)
+			{
+				localDistance = patchDistance;
+				positionU = i;
+				positionV = j;
+			}
+		}
+	}
+
+	if (IsOnSearchWindowBorder(positionU, firstU, lastU, patchesU, _isClosedU, isWholeU) ||
+		IsOnSearchWindowBorder(positionV, firstV, lastV, patchesV, _isClosedV, isWholeV))
+	{
+		return Project(givenPoint, options, isConverged);
+	}
+	// Samples lie on the surface, a converged result not farther than every nearby sample is the local foot point.
+	if (isConverged && distance <= localDistance + options.DistanceTolerance)
+	{
+		return param;
+	}
+
+	bool isPreviousConverged = isConverged;
+	UV restarted = Refine(givenPoint, _sampleParams[function.BestSample], options, isConverged);
+	double restartedDistance = NurbsSurface::GetPointOnSurface(_surface, restarted).Distance(givenPoint);
+	if (restartedDistance < distance)
+	{
+		return restarted;
+	}
+	isConverged = isPreviousConverged;
+	return param;
+}
+
+LNLib::UV LNLib::SurfaceProjector::Refine(const XYZ& givenPoint, UV param, const LN_ProjectionOptions& options, bool& isConverged) const
+{
+	const std::vector<double>& knotVectorU = _surface.KnotVectorU;
+	const std::vector<double>& knotVectorV = _surface.KnotVectorV;
+	double a = knotVectorU[0];
+	double b = knotVectorU[knotVectorU.size() - 1];
+	double c = knotVectorV[0];
+	double d = knotVectorV[knotVectorV.size() - 1];
+
+	isConverged = false;
+	int counters = 0;
+	while (counters < options.MaxIterations)
+	{
+		std::vector<std::vector<XYZ>> derivatives = NurbsSurface::ComputeRationalSurfaceDerivatives(_surface, 2, param);
+		XYZ difference = derivatives[0][0] - givenPoint;
+		XYZ Su = derivatives[1][0];
+		XYZ Sv = derivatives[0][1];
+		XYZ Suu = derivatives[2][0];
+		XYZ Svv = derivatives[0][2];
+		XYZ Suv = derivatives[1][1];
+
+		double condition1 = difference.Length();
+		double condition2a = std::abs(Su.DotProduct(difference) / (Su.Length() * condition1));
+		double condition2b = std::abs(Sv.DotProduct(difference) / (Sv.Length() * condition1));
+		if (condition1 < options.DistanceTolerance ||
+			(condition2a < options.CosineTolerance && condition2b < options.CosineTolerance))
+		{
+			isConverged = true;
+			return param;
+		}
+
+		double f = Su.DotProduct(difference);
+		double g = Sv.DotProduct(difference);
+		double fu = Su.DotProduct(Su) + difference.DotProduct(Suu);
+		double fv = Su.DotProduct(Sv) + difference.DotProduct(Suv);
+		double gv = Sv.DotProduct(Sv) + difference.DotProduct(Svv);
+
+		double determinant = fu * gv - fv * fv;
+		if (MathUtils::IsAlmostEqualTo(determinant, 0.0))
+		{
+			return param;
+		}
+
+		double deltaU = (-f * gv + fv * g) / determinant;
+		double deltaV = (-fu * g + fv * f) / determinant;
+		UV temp = UV(ClampOrWrap(param[0] + deltaU, a, b, _isClosedU), ClampOrWrap(param[1] + deltaV, c, d, _isClosedV));
+
+		double condition4 = ((temp[0] - param[0]) * Su + (temp[1] - param[1]) * Sv).Length();
+		if (condition4 < options.DistanceTolerance)
+		{
+			isConverged = true;
+			return temp;
+		}
+
+		param = temp;
+		counters++;
+		LNLIB_COUNT(NewtonIterations, 1);
+	}
+	return param;
+}
+
+std::vector<LNLib::UV> LNLib::SurfaceProjector::GetParamsOnSurface(const std::vector<XYZ>& givenPoints, ParallelExecutor* executor) const
+{
+	std::vector<UV> params(givenPoints.size());
+	SurfaceProjectionTask task(*this, givenPoints, params);
+	int blocks = (givenPoints.size() + SurfaceProjectionBlockSize - 1) / SurfaceProjectionBlockSize;
+	Parallel::For(blocks, task, executor);
+	return params;
+}
+
+void LNLib::SurfaceProjector::ComputeDeviations(const XYZ* points, int count, LN_PointDeviation* deviations, const LN_ProjectionOptions& options, ParallelExecutor* executor) const
+{
+	LNLIB_SCOPED_TIMER("SurfaceProjector::ComputeDeviations");
+	VALIDATE_ARGUMENT(count >= 0, "count", "Count must not be negative.");
+
+	SurfaceDeviationTask task(*this, _surface, points, count, options, deviations);
+	int blocks = (count + SurfaceProjectionBlockSize - 1) / SurfaceProjectionBlockSize;
+	Parallel::For(blocks, task, executor);
+}
+
+std::vector<LNLib::LN_PointDeviation> LNLib::SurfaceProjector::ComputeDeviations(const std::vector<XYZ>& points, const LN_ProjectionOptions& options, ParallelExecutor* executor) const
+{
+	std::vector<LN_PointDeviation> deviations(points.size());
+	ComputeDeviations(points.data(), points.size(), deviations.data(), options, executor);
+	return deviations;
+}
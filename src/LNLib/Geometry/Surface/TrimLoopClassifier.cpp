@@ -0,0 +1,281 @@
+/*
+ * Author:
+ * 2024/10/14 - Yuqing Liang (BIMCoder Liang)
+ * bim.frankliang@foxmail.com
+ * 微信公众号：BIMCoder梁老师
+ *
+ * Use of this source code is governed by a GPL-3.0 license that can be found in
+ * the LICENSE file.
+ */
+
+#include "TrimLoopClassifier.h"
+#include "NurbsCurve.h"
+#include "Constants.h"
+#include "UV.h"
+#include "XYZ.h"
+#include "LNLibExceptions.h"
+#include <algorithm>
+#include <cmath>
+
+namespace LNLib
+{
+	const double TrimFlatteningAngle = 0.2;
+	const int MaxTrimGridSize = 512;
+
+	/// <summary>
+	/// Crossing of segment ab with the line v = const, half open in v so a vertex on the line is counted once.
+	/// Precomputed cell states and queries must share this rule and its arithmetic.
+	/// </summary>
+	bool GetTrimHorizontalCrossing(const UV& a, const UV& b, double v, double& u)
+	{
+		if ((a.GetV() > v) == (b.GetV() > v))
+		{
+			return false;
+		}
+		u = a.GetU() + (v - a.GetV()) * (b.GetU() - a.GetU()) / (b.GetV() - a.GetV());
+		return true;
+	}
+
+	/// <summary>
+	/// Crossing of segment ab with the line u = const, half open in u.
+	/// </summary>
+	bool GetTrimVerticalCrossing(const UV& a, const UV& b, double u, double& v)
+	{
+		if ((a.GetU() > u) == (b.GetU() > u))
+		{
+			return false;
+		}
+		v = a.GetV() + (u - a.GetU()) * (b.GetV() - a.GetV()) / (b.GetU() - a.GetU());
+		return true;
+	}
+
+	/// <summary>
+	/// Separating axis test of segment ab against box [min, max], touching counts as intersecting.
+	/// </summary>
+	bool IsTrimSegmentTouchingBox(const UV& a, const UV& b, const UV& min, const UV& max)
+	{
+		if (std::max(a.GetU(), b.GetU()) < min.GetU() || std::min(a.GetU(), b.GetU()) > max.GetU() ||
+			std::max(a.GetV(), b.GetV()) < min.GetV() || std::min(a.GetV(), b.GetV()) > max.GetV())
+		{
+			return false;
+		}
+		UV direction = b - a;
+		double corners[4] =
+		{
+			direction.CrossProduct(min - a),
+			direction.CrossProduct(UV(max.GetU(), min.GetV()) - a),
+			direction.CrossProduct(UV(min.GetU(), max.GetV()) - a),
+			direction.CrossProduct(max - a),
+		};
+		bool hasPositive = false;
+		bool hasNegative = false;
+		for (int k = 0; k < 4; k++)
+		{
+			hasPositive = hasPositive || corners[k] >= 0.0;
+			hasNegative = hasNegative || corners[k] <= 0.0;
+		}
+		return hasPositive && hasNegative;
+	}
+}
+
+LNLib::TrimLoopClassifier::TrimLoopClassifier(const std::vector<std::vector<LN_NurbsCurve>>& loops, double tolerance) : _tolerance(tolerance)
+{
+	VALIDATE_ARGUMENT(tolerance > 0, "tolerance", "Tolerance must greater than zero.");
+	VALIDATE_ARGUMENT(loops.size() > 0, "loops", "Loops must contains one loop at least.");
+
+	for (int i = 0; i < loops.size(); i++)
+	{
+		VALIDATE_ARGUMENT(loops[i].size() > 0, "loops", "Each loop must contains one curve at least.");
+		for (int j = 0; j < loops[i].size(); j++)
+		{
+			std::vector<XYZ> points;
+			std::vector<double> knots;
+			NurbsCurve::Tessellate(loops[i][j], tolerance, TrimFlatteningAngle, points, knots);
+			for (int k = 0; k < static_cast<int>(points.size()) - 1; k++)
+			{
+				_starts.emplace_back(UV(points[k].GetX(), points[k].GetY()));
+				_ends.emplace_back(UV(points[k + 1].GetX(), points[k + 1].GetY()));
+			}
+		}
+	}
+
+	int count = _starts.size();
+	_minU = Constants::MaxDistance;
+	_minV = Constants::MaxDistance;
+	_maxU = -Constants::MaxDistance;
+	_maxV = -Constants::MaxDistance;
+	for (int k = 0; k < count; k++)
+	{
+		_minU = std::min(_minU, std::min(_starts[k].GetU(), _ends[k].GetU()));
+		_minV = std::min(_minV, std::min(_starts[k].GetV(), _ends[k].GetV()));
+		_maxU = std::max(_maxU, std::max(_starts[k].GetU(), _ends[k].GetU()));
+		_maxV = std::max(_maxV, std::max(_starts[k].GetV(), _ends[k].GetV()));
+	}
+
+	// About one segment per cell, degenerate extents still get cells of positive size.
+	int size = std::max(1, std::min(MaxTrimGridSize, static_cast<int>(std::ceil(std::sqrt(static_cast<double>(count))))));
+	_columns = size;
+	_rows = size;
+	_cellWidth = std::max(_maxU - _minU, tolerance) / _columns;
+	_cellHeight = std::max(_maxV - _minV, tolerance) / _rows;
+
+	// Bucket by segment bounding box, padded so crossings on a cell border are seen from both sides.
+	double padU = _cellWidth * Constants::DoubleEpsilon;
+	double padV = _cellHeight * Constants::DoubleEpsilon;
+	std::vector<int> counts(_columns * _rows + 1, 0);
+	for (int pass = 0; pass < 2; pass++)
+	{
+		if (pass == 1)
+		{
+			_cellStarts.assign(_columns * _rows + 1, 0);
+			for (int c = 0; c < _columns * _rows; c++)
+			{
+				_cellStarts[c + 1] = _cellStarts[c] + counts[c];
+				counts[c] = _cellStarts[c];
+			}
+			_cellSegments.resize(_cellStarts[_columns * _rows]);
+		}
+		for (int k = 0; k < count; k++)
+		{
+			int firstColumn = GetColumn(std::min(_starts[k].GetU(), _ends[k].GetU()) - padU);
+			int lastColumn = GetColumn(std::max(_starts[k].GetU(), _ends[k].GetU()) + padU);
+			int firstRow = GetRow(std::min(_starts[k].GetV(), _ends[k].GetV()) - padV);
+			int lastRow = GetRow(std::max(_starts[k].GetV(), _ends[k].GetV()) + padV);
+			for (int r = firstRow; r <= lastRow; r++)
+			{
+				for (int c = firstColumn; c <= lastColumn; c++)
+				{
+					int cell = r * _columns + c;
+					if (pass == 0)
+					{
+						counts[cell]++;
+					}
+					else
+					{
+						_cellSegments[counts[cell]++] = k;
+					}
+				}
+			}
+		}
+	}
+
+	// Segments crossing the center line of a row lie in the cells of that row.
+	_isCenterInside.assign(_columns * _rows, false);
+	std::vector<int> rowSegments;
+	std::vector<double> crossings;
+	for (int r = 0; r < _rows; r++)
+	{
+		rowSegments.assign(_cellSegments.begin() + _cellStarts[r * _columns], _cellSegments.begin() + _cellStarts[(r + 1) * _columns]);
+		std::sort(rowSegments.begin(), rowSegments.end());
+		rowSegments.erase(std::unique(rowSegments.begin(), rowSegments.end()), rowSegments.end());
+
+		double centerV = _minV + (r + 0.5) * _cellHeight;
+		crossings.clear();
+		for (int k = 0; k < rowSegments.size(); k++)
+		{
+			double u = 0.0;
+			if (GetTrimHorizontalCrossing(_starts[rowSegments[k]], _ends[rowSegments[k]], centerV, u))
+			{
+				crossings.emplace_back(u);
+			}
+		}
+		std::sort(crossings.begin(), crossings.end());
+		for (int c = 0; c < _columns; c++)
+		{
+			double centerU = _minU + (c + 0.5) * _cellWidth;
+			int right = crossings.end() - std::upper_bound(crossings.begin(), crossings.end(), centerU);
+			_isCenterInside[r * _columns + c] = right % 2 == 1;
+		}
+	}
+}
+
+int LNLib::TrimLoopClassifier::GetColumn(double u) const
+{
+	double column = std::floor((u - _minU) / _cellWidth);
+	return static_cast<int>(std::max(0.0, std::min(_columns - 1.0, column)));
+}
+
+int LNLib::TrimLoopClassifier::GetRow(double v) const
+{
+	double row = std::floor((v - _minV) / _cellHeight);
+	return static_cast<int>(std::max(0.0, std::min(_rows - 1.0, row)));
+}
+
+bool LNLib::TrimLoopClassifier::IsInside(const UV& uv) const
+{
+	double u = uv.GetU();
+	double v = uv.GetV();
+	if (u < _minU || u > _maxU || v < _minV || v > _maxV)
+	{
+		return false;
+	}
+
+	int column = GetColumn(u);
+	int row = GetRow(v);
+	int cell = row * _columns + column;
+	bool isInside = _isCenterInside[cell];
+	double centerU = _minU + (column + 0.5) * _cellWidth;
+	double centerV = _minV + (row + 0.5) * _cellHeight;
+
+	// Walk from the cell center along v = centerV to u, then along u to v, both legs stay inside the cell.
+	for (int k = _cellStarts[cell]; k < _cellStarts[cell + 1]; k++)
+	{
+		const UV& a = _starts[_cellSegments[k]];
+		const UV& b = _ends[_cellSegments[k]];
+		double crossing = 0.0;
+		if (GetTrimHorizontalCrossing(a, b, centerV, crossing) && (crossing > centerU) != (crossing > u))
+		{
+			isInside = !isInside;
+		}
+		if (GetTrimVerticalCrossing(a, b, u, crossing) && (crossing > centerV) != (crossing > v))
+		{
+			isInside = !isInside;
+		}
+	}
+	return isInside;
+}
+
+LNLib::TrimRegion LNLib::TrimLoopClassifier::Classify(const UV& min, const UV& max) const
+{
+	if (max.GetU() < _minU || min.GetU() > _maxU || max.GetV() < _minV || min.GetV() > _maxV)
+	{
+		return TrimRegion::Outside;
+	}
+
+	int firstColumn = GetColumn(min.GetU());
+	int lastColumn = GetColumn(max.GetU());
+	int firstRow = GetRow(min.GetV());
+	int lastRow = GetRow(max.GetV());
+	for (int r = firstRow; r <= lastRow; r++)
+	{
+		for (int c = firstColumn; c <= lastColumn; c++)
+		{
+			int cell = r * _columns + c;
+			for (int k = _cellStarts[cell]; k < _cellStarts[cell + 1]; k++)
+			{
+				int segment = _cellSegments[k];
+				if (IsTrimSegmentTouchingBox(_starts[segment], _ends[segment], min, max))
+				{
+					return TrimRegion::Boundary;
+				}
+			}
+		}
+	}
+	UV center = (min + max) / 2.0;
+	return IsInside(center) ? TrimRegion::Inside : TrimRegion::Outside;
+}
+
+double LNLib::TrimLoopClassifier::GetTolerance() const
+{
+	return _tolerance;
+}
+
+const std::vector<LNLib::UV>& LNLib::TrimLoopClassifier::GetSegmentStarts() const
+{
+	return _starts;
+}
+
+const std::vector<LNLib::UV>& LNLib::TrimLoopClassifier::GetSegmentEnds() const
+{
+	return _ends;
+}
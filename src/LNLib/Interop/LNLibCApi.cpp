@@ -0,0 +1,352 @@
+/*
+ * Author:
+ * 2024/10/14 - Yuqing Liang (BIMCoder Liang)
+ * bim.frankliang@foxmail.com
+ * 微信公众号：BIMCoder梁老师
+ *
+ * Use of this source code is governed by a GPL-3.0 license that can be found in
+ * the LICENSE file.
+ */
+
+#include "LNLibCApi.h"
+#include "PreparedCurve.h"
+#include "PreparedSurface.h"
+#include "LNObject.h"
+#include "XYZ.h"
+#include "XYZW.h"
+#include "UV.h"
+#include "Constants.h"
+#include "LNLibExceptions.h"
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+struct LNLib_PreparedCurve
+{
+	LNLib::PreparedCurve Prepared;
+
+	LNLib_PreparedCurve(const LNLib::LN_NurbsCurve& curve) : Prepared(curve) {}
+};
+
+struct LNLib_PreparedSurface
+{
+	LNLib::PreparedSurface Prepared;
+
+	LNLib_PreparedSurface(const LNLib::LN_NurbsSurface& surface) : Prepared(surface) {}
+};
+
+namespace LNLib
+{
+	/// <summary>
+	/// Params or points handled per batch call, converted through stack buffers of this size.
+	/// </summary>
+	const int CApiChunkSize = 32;
+
+	thread_local std::string CApiLastError;
+
+	LNLib_Status SetCApiError(LNLib_Status status, const char* message)
+	{
+		CApiLastError = message;
+		return status;
+	}
+
+	void WriteCApiVector(const XYZ& vector, double* target)
+	{
+		target[0] = vector.GetX();
+		target[1] = vector.GetY();
+		target[2] = vector.GetZ();
+	}
+
+	double ReadCApiWeight(const double* weights, int stride, size_t index)
+	{
+		return weights == nullptr ? 1.0 : weights[index * stride];
+	}
+}
+
+// Exceptions of any type must not cross the C boundary, logic errors come from argument validation.
+#define LNLIB_CAPI_CATCH\
+	catch (const std::logic_error& e)\
+	{\
+		return LNLib::SetCApiError(LNLIB_STATUS_INVALID_ARGUMENT, e.what());\
+	}\
+	catch (const std::exception& e)\
+	{\
+		return LNLib::SetCApiError(LNLIB_STATUS_ERROR, e.what());\
+	}\
+	catch (...)\
+	{\
+		return LNLib::SetCApiError(LNLIB_STATUS_ERROR, "Unknown exception.");\
+	}
+
+using namespace LNLib;
+
+const char* LNLib_GetLastErrorMessage(void)
+{
+	return CApiLastError.c_str();
+}
+
+LNLib_Status LNLib_CreatePreparedCurve(const LNLib_CurveDesc* desc, LNLib_PreparedCurve** curve)
+{
+	try
+	{
+		VALIDATE_ARGUMENT(curve != nullptr, "curve", "Curve must not be null.");
+		*curve = nullptr;
+		VALIDATE_ARGUMENT(desc != nullptr, "desc", "Desc must not be null.");
+		VALIDATE_ARGUMENT(desc->Degree > 0, "Degree", "Degree must greater than zero.");
+		VALIDATE_ARGUMENT(desc->ControlPointCount > desc->Degree, "ControlPointCount", "ControlPointCount must greater than degree.");
+		VALIDATE_ARGUMENT(desc->Knots != nullptr && desc->ControlPoints != nullptr, "desc", "Knots and control points must not be null.");
+		VALIDATE_ARGUMENT(desc->ControlPointStride >= 3, "ControlPointStride", "ControlPointStride must greater than or equals three.");
+		VALIDATE_ARGUMENT(desc->Weights == nullptr || desc->WeightStride > 0, "WeightStride", "WeightStride must greater than zero.");
+
+		LN_NurbsCurve nurbs;
+		nurbs.Degree = desc->Degree;
+		nurbs.KnotVector.assign(desc->Knots, desc->Knots + desc->ControlPointCount + desc->Degree + 1);
+		nurbs.ControlPoints.resize(desc->ControlPointCount);
+		for (int i = 0; i < desc->ControlPointCount; i++)
+		{
+			const double* point = desc->ControlPoints + static_cast<size_t>(i) * desc->ControlPointStride;
+			nurbs.ControlPoints[i] = XYZW(XYZ(point[0], point[1], point[2]), ReadCApiWeight(desc->Weights, desc->WeightStride, i));
+		}
+		*curve = new LNLib_PreparedCurve(nurbs);
+		return LNLIB_STATUS_OK;
+	}
+	LNLIB_CAPI_CATCH
+}
+
+void LNLib_DestroyPreparedCurve(LNLib_PreparedCurve* curve)
+{
+	delete curve;
+}
+
+LNLib_Status LNLib_GetPointsOnCurve(const LNLib_PreparedCurve* curve, const double* params, int paramStride, int count, double* points, int pointStride)
+{
+	try
+	{
+		VALIDATE_ARGUMENT(curve != nullptr, "curve", "Curve must not be null.");
+		VALIDATE_ARGUMENT(count >= 0, "count", "Count must not be negative.");
+		VALIDATE_ARGUMENT(count == 0 || (params != nullptr && points != nullptr), "params", "Params and points must not be null.");
+		VALIDATE_ARGUMENT(paramStride > 0 && pointStride >= 3, "pointStride", "Strides must hold one param and three coordinates.");
+
+		double chunkParams[CApiChunkSize];
+		XYZ chunkPoints[CApiChunkSize];
+		for (int first = 0; first < count; first += CApiChunkSize)
+		{
+			int size = std::min(CApiChunkSize, count - first);
+			const double* source = params + static_cast<size_t>(first) * paramStride;
+			if (paramStride != 1)
+			{
+				for (int i = 0; i < size; i++)
+				{
+					chunkParams[i] = source[static_cast<size_t>(i) * paramStride];
+				}
+				source = chunkParams;
+			}
+			curve->Prepared.GetPointsOnCurve(source, size, chunkPoints);
+			for (int i = 0; i < size; i++)
+			{
+				WriteCApiVector(chunkPoints[i], points + static_cast<size_t>(first + i) * pointStride);
+			}
+		}
+		return LNLIB_STATUS_OK;
+	}
+	LNLIB_CAPI_CATCH
+}
+
+LNLib_Status LNLib_ComputeCurveDerivatives(const LNLib_PreparedCurve* curve, int derivative, const double* params, int paramStride, int count, double* derivatives, int stride)
+{
+	try
+	{
+		VALIDATE_ARGUMENT(curve != nullptr, "curve", "Curve must not be null.");
+		VALIDATE_ARGUMENT(derivative > 0, "derivative", "Derivative must greater than zero.");
+		VALIDATE_ARGUMENT(count >= 0, "count", "Count must not be negative.");
+		VALIDATE_ARGUMENT(count == 0 || (params != nullptr && derivatives != nullptr), "params", "Params and derivatives must not be null.");
+		VALIDATE_ARGUMENT(paramStride > 0 && stride >= 3 * (derivative + 1), "stride", "Strides must hold one param and all derivatives.");
+
+		int orders = derivative + 1;
+		int chunk = std::max(1, CApiChunkSize / orders);
+		double chunkParams[CApiChunkSize];
+		XYZ stackDerivatives[CApiChunkSize];
+		std::vector<XYZ> heapDerivatives;
+		XYZ* chunkDerivatives = stackDerivatives;
+		if (chunk * orders > CApiChunkSize)
+		{
+			heapDerivatives.resize(chunk * orders);
+			chunkDerivatives = heapDerivatives.data();
+		}
+		for (int first = 0; first < count; first += chunk)
+		{
+			int size = std::min(chunk, count - first);
+			for (int i = 0; i < size; i++)
+			{
+				chunkParams[i] = params[static_cast<size_t>(first + i) * paramStride];
+			}
+			curve->Prepared.ComputeDerivatives(derivative, chunkParams, size, chunkDerivatives);
+			for (int i = 0; i < size; i++)
+			{
+				double* target = derivatives + static_cast<size_t>(first + i) * stride;
+				for (int k = 0; k < orders; k++)
+				{
+					WriteCApiVector(chunkDerivatives[i * orders + k], target + 3 * k);
+				}
+			}
+		}
+		return LNLIB_STATUS_OK;
+	}
+	LNLIB_CAPI_CATCH
+}
+
+LNLib_Status LNLib_GetCurveLevelOfDetail(const LNLib_PreparedCurve* curve, double maxError, double* points, int pointStride, double* knots, int capacity, int* count, double* error)
+{
+	try
+	{
+		VALIDATE_ARGUMENT(curve != nullptr, "curve", "Curve must not be null.");
+		VALIDATE_ARGUMENT(count != nullptr, "count", "Count must not be null.");
+
+		const LN_CurveLevelOfDetail& level = curve->Prepared.GetLevelOfDetail(maxError);
+		int size = level.Points.size();
+		*count = size;
+		if (error != nullptr)
+		{
+			*error = level.Error;
+		}
+		if (capacity < size)
+		{
+			return SetCApiError(LNLIB_STATUS_BUFFER_TOO_SMALL, "Buffer capacity is smaller than the level point count.");
+		}
+		VALIDATE_ARGUMENT(points != nullptr && pointStride >= 3, "points", "Points must not be null and hold three coordinates.");
+		for (int k = 0; k < size; k++)
+		{
+			WriteCApiVector(level.Points[k], points + static_cast<size_t>(k) * pointStride);
+		}
+		if (knots != nullptr)
+		{
+			std::copy(level.Knots.begin(), level.Knots.end(), knots);
+		}
+		return LNLIB_STATUS_OK;
+	}
+	LNLIB_CAPI_CATCH
+}
+
+LNLib_Status LNLib_CreatePreparedSurface(const LNLib_SurfaceDesc* desc, LNLib_PreparedSurface** surface)
+{
+	try
+	{
+		VALIDATE_ARGUMENT(surface != nullptr, "surface", "Surface must not be null.");
+		*surface = nullptr;
+		VALIDATE_ARGUMENT(desc != nullptr, "desc", "Desc must not be null.");
+		VALIDATE_ARGUMENT(desc->DegreeU > 0 && desc->DegreeV > 0, "Degree", "Degrees must greater than zero.");
+		VALIDATE_ARGUMENT(desc->ControlPointCountU > desc->DegreeU && desc->ControlPointCountV > desc->DegreeV, "ControlPointCount", "ControlPointCounts must greater than degrees.");
+		VALIDATE_ARGUMENT(desc->KnotsU != nullptr && desc->KnotsV != nullptr && desc->ControlPoints != nullptr, "desc", "Knots and control points must not be null.");
+		VALIDATE_ARGUMENT(desc->RowStride > 0 && desc->ColumnStride > 0, "RowStride", "RowStride and ColumnStride must greater than zero.");
+		VALIDATE_ARGUMENT(desc->Weights == nullptr || (desc->WeightRowStride > 0 && desc->WeightColumnStride > 0), "WeightRowStride", "WeightRowStride and WeightColumnStride must greater than zero.");
+
+		LN_NurbsSurface nurbs;
+		nurbs.DegreeU = desc->DegreeU;
+		nurbs.DegreeV = desc->DegreeV;
+		nurbs.KnotVectorU.assign(desc->KnotsU, desc->KnotsU + desc->ControlPointCountU + desc->DegreeU + 1);
+		nurbs.KnotVectorV.assign(desc->KnotsV, desc->KnotsV + desc->ControlPointCountV + desc->DegreeV + 1);
+		nurbs.ControlPoints.resize(desc->ControlPointCountU, std::vector<XYZW>(desc->ControlPointCountV));
+		for (int i = 0; i < desc->ControlPointCountU; i++)
+		{
+			for (int j = 0; j < desc->ControlPointCountV; j++)
+			{
+				const double* point = desc->ControlPoints + static_cast<size_t>(i) * desc->RowStride + static_cast<size_t>(j) * desc->ColumnStride;
+				double weight = desc->Weights == nullptr ? 1.0 : desc->Weights[static_cast<size_t>(i) * desc->WeightRowStride + static_cast<size_t>(j) * desc->WeightColumnStride];
+				nurbs.ControlPoints[i][j] = XYZW(XYZ(point[0], point[1], point[2]), weight);
+			}
+		}
+		*surface = new LNLib_PreparedSurface(nurbs);
+		return LNLIB_STATUS_OK;
+	}
+	LNLIB_CAPI_CATCH
+}
+
+void LNLib_DestroyPreparedSurface(LNLib_PreparedSurface* surface)
+{
+	delete surface;
+}
+
+LNLib_Status LNLib_EvaluateSurface(const LNLib_PreparedSurface* surface, const double* uvs, int uvStride, int count, double* points, int pointStride, double* normals, int normalStride)
+{
+	try
+	{
+		VALIDATE_ARGUMENT(surface != nullptr, "surface", "Surface must not be null.");
+		VALIDATE_ARGUMENT(count >= 0, "count", "Count must not be negative.");
+		VALIDATE_ARGUMENT(count == 0 || (uvs != nullptr && points != nullptr), "uvs", "Uvs and points must not be null.");
+		VALIDATE_ARGUMENT(uvStride >= 2 && pointStride >= 3 && (normals == nullptr || normalStride >= 3), "pointStride", "Strides must hold two params and three coordinates.");
+
+		// Point and first derivatives in the layout of PreparedSurface::ComputeDerivatives, four vectors per uv.
+		const int chunk = CApiChunkSize / 4;
+		UV chunkUVs[CApiChunkSize / 4];
+		XYZ chunkDerivatives[CApiChunkSize];
+		for (int first = 0; first < count; first += chunk)
+		{
+			int size = std::min(chunk, count - first);
+			for (int i = 0; i < size; i++)
+			{
+				const double* uv = uvs + static_cast<size_t>(first + i) * uvStride;
+				chunkUVs[i] = UV(uv[0], uv[1]);
+			}
+			surface->Prepared.ComputeDerivatives(1, chunkUVs, size, chunkDerivatives);
+			for (int i = 0; i < size; i++)
+			{
+				XYZ* ders = chunkDerivatives + 4 * i;
+				WriteCApiVector(ders[0], points + static_cast<size_t>(first + i) * pointStride);
+				if (normals != nullptr)
+				{
+					WriteCApiVector(ders[2].Normalize().CrossProduct(ders[1]).Normalize(), normals + static_cast<size_t>(first + i) * normalStride);
+				}
+			}
+		}
+		return LNLIB_STATUS_OK;
+	}
+	LNLIB_CAPI_CATCH
+}
+
+LNLib_Status LNLib_GetSurfaceLevelOfDetail(const LNLib_PreparedSurface* surface, double maxError, LNLib_MeshBuffers* mesh, double* error)
+{
+	try
+	{
+		VALIDATE_ARGUMENT(surface != nullptr, "surface", "Surface must not be null.");
+		VALIDATE_ARGUMENT(mesh != nullptr, "mesh", "Mesh must not be null.");
+
+		const LN_SurfaceLevelOfDetail& level = surface->Prepared.GetLevelOfDetail(maxError);
+		const LN_Mesh& source = level.Mesh;
+		int vertexCount = source.Vertices.size();
+		int indexCount = source.Indices.size();
+		mesh->VertexCount = vertexCount;
+		mesh->IndexCount = indexCount;
+		if (error != nullptr)
+		{
+			*error = level.Error;
+		}
+		if (mesh->VertexCapacity < vertexCount || mesh->IndexCapacity < indexCount)
+		{
+			return SetCApiError(LNLIB_STATUS_BUFFER_TOO_SMALL, "Buffer capacity is smaller than the level vertex or index count.");
+		}
+		VALIDATE_ARGUMENT(mesh->Vertices != nullptr && mesh->VertexStride >= 3, "Vertices", "Vertices must not be null and hold three coordinates.");
+		VALIDATE_ARGUMENT(mesh->Normals == nullptr || mesh->NormalStride >= 3, "NormalStride", "Normals must hold three coordinates.");
+		VALIDATE_ARGUMENT(mesh->UVs == nullptr || mesh->UVStride >= 2, "UVStride", "UVs must hold two params.");
+		VALIDATE_ARGUMENT(mesh->Indices != nullptr, "Indices", "Indices must not be null.");
+
+		for (int k = 0; k < vertexCount; k++)
+		{
+			WriteCApiVector(source.Vertices[k], mesh->Vertices + static_cast<size_t>(k) * mesh->VertexStride);
+			if (mesh->Normals != nullptr)
+			{
+				WriteCApiVector(source.Normals[k], mesh->Normals + static_cast<size_t>(k) * mesh->NormalStride);
+			}
+			if (mesh->UVs != nullptr)
+			{
+				double* uv = mesh->UVs + static_cast<size_t>(k) * mesh->UVStride;
+				uv[0] = source.UVs[k].GetU();
+				uv[1] = source.UVs[k].GetV();
+			}
+		}
+		std::copy(source.Indices.begin(), source.Indices.end(), mesh->Indices);
+		return LNLIB_STATUS_OK;
+	}
+	LNLIB_CAPI_CATCH
+}
@@ -14,6 +14,11 @@
 #include "MathUtils.h"
 #include <algorithm>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LNLIB_MATRIX4D_SSE2
+#include <emmintrin.h>
+#endif
+
 using namespace LNLib;
 
 LNLib::Matrix4d::Matrix4d()
@@ -270,7 +275,58 @@ XYZW LNLib::Matrix4d::OfWeightedPoint(const XYZW& point)
 
 	double w = m_matrix4d[3][0] * point[0] + m_matrix4d[3][1] * point[1] + m_matrix4d[3][2] * point[2] + m_matrix4d[3][3] * point[3];
 
-	return XYZW(XYZ(x,y,z),w);
+	return XYZW(x, y, z, w);
+}
+
+void LNLib::Matrix4d::OfWeightedPoints(const XYZW* points, int count, XYZW* result) const
+{
+	const double (*m)[4] = m_matrix4d;
+	bool isAffine = IsAffine();
+#ifdef LNLIB_MATRIX4D_SSE2
+	// Columns split into (x, y) and (z, w) lanes, result = sum of column * coordinate.
+	__m128d c0xy = _mm_set_pd(m[1][0], m[0][0]);
+	__m128d c1xy = _mm_set_pd(m[1][1], m[0][1]);
+	__m128d c2xy = _mm_set_pd(m[1][2], m[0][2]);
+	__m128d c3xy = _mm_set_pd(m[1][3], m[0][3]);
+	__m128d c0zw = _mm_set_pd(m[3][0], m[2][0]);
+	__m128d c1zw = _mm_set_pd(m[3][1], m[2][1]);
+	__m128d c2zw = _mm_set_pd(m[3][2], m[2][2]);
+	__m128d c3zw = _mm_set_pd(m[3][3], m[2][3]);
+	for (int i = 0; i < count; i++)
+	{
+		const XYZW& point = points[i];
+		__m128d x = _mm_set1_pd(point[0]);
+		__m128d y = _mm_set1_pd(point[1]);
+		__m128d z = _mm_set1_pd(point[2]);
+		__m128d w = _mm_set1_pd(point[3]);
+
+		__m128d xy = _mm_add_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(c0xy, x), _mm_mul_pd(c1xy, y)), _mm_mul_pd(c2xy, z)), _mm_mul_pd(c3xy, w));
+		if (isAffine)
+		{
+			double weight = point[3];
+			double tz = m[2][0] * point[0] + m[2][1] * point[1] + m[2][2] * point[2] + m[2][3] * weight;
+			_mm_storeu_pd(&result[i][0], xy);
+			result[i][2] = tz;
+			result[i][3] = weight;
+		}
+		else
+		{
+			__m128d zw = _mm_add_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(c0zw, x), _mm_mul_pd(c1zw, y)), _mm_mul_pd(c2zw, z)), _mm_mul_pd(c3zw, w));
+			_mm_storeu_pd(&result[i][0], xy);
+			_mm_storeu_pd(&result[i][2], zw);
+		}
+	}
+#else
+	for (int i = 0; i < count; i++)
+	{
+		const XYZW& point = points[i];
+		double x = m[0][0] * point[0] + m[0][1] * point[1] + m[0][2] * point[2] + m[0][3] * point[3];
+		double y = m[1][0] * point[0] + m[1][1] * point[1] + m[1][2] * point[2] + m[1][3] * point[3];
+		double z = m[2][0] * point[0] + m[2][1] * point[1] + m[2][2] * point[2] + m[2][3] * point[3];
+		double w = isAffine ? point[3] : m[3][0] * point[0] + m[3][1] * point[1] + m[3][2] * point[2] + m[3][3] * point[3];
+		result[i] = XYZW(x, y, z, w);
+	}
+#endif
 }
 
 XYZ LNLib::Matrix4d::OfVector(const XYZ& vector)
@@ -372,6 +428,11 @@ bool LNLib::Matrix4d::HasReflection()
 	return MathUtils::IsLessThan(dot, 0.0);
 }
 
+bool LNLib::Matrix4d::IsAffine() const
+{
+	return m_matrix4d[3][0] == 0.0 && m_matrix4d[3][1] == 0.0 && m_matrix4d[3][2] == 0.0 && m_matrix4d[3][3] == 1.0;
+}
+
 bool LNLib::Matrix4d::IsTranslation()
 {
 	bool c1 = MathUtils::IsAlmostEqualTo(m_matrix4d[0][0], 1);
@@ -9,44 +9,51 @@
  */
 
 #include "MathUtils.h"
+#include "Instrumentation.h"
+#include "LNObject.h"
+#include "LNLibExceptions.h"
 #include <limits>
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LNLIB_MATHUTILS_SSE2
+#include <emmintrin.h>
+#endif
 
 namespace LNLib
 {
-    void GetCoFactor(const std::vector<std::vector<double>>& matrix, std::vector<std::vector<double>>& temp, int row, int column, int n)
-    {
-        int i = 0, j = 0;
-        for (int r = 0; r < n; r++) {
-            for (int col = 0; col < n; col++) {
-                if (r != row && col != column) {
-                    temp[i][j++] = matrix[r][col];
-                    if (j == n - 1) {
-                        j = 0;
-                        i++;
-                    }
-                }
-            }
-        }
-    }
-
-    void GetAdjointMatrix(const std::vector<std::vector<double>>& matrix, std::vector<std::vector<double>>& adjointMatrix)
+    /// <summary>
+    /// Rows and columns of one block, three blocks of doubles stay within a typical L1 and L2 cache.
+    /// </summary>
+    const int MatrixBlockSize = 64;
+
+    /// <summary>
+    /// result block += left block * right block, the inner loop runs along a row of right and result.
+    /// </summary>
+    void MultiplyMatrixBlock(const double* left, int leftStride, const double* right, int rightStride, double* result, int resultStride, int rows, int depth, int columns)
     {
-        int n = matrix.size();
-        if (n == 1) 
-        {
-            adjointMatrix[0][0] = 1;
-            return;
-        }
-
-        int sign = 1; 
-        std::vector<std::vector<double>> temp(n, std::vector<double>(n));
-        for (int i = 0; i < n; i++) 
+        for (int i = 0; i < rows; i++)
         {
-            for (int j = 0; j < n; j++) 
+            double* resultRow = result + i * resultStride;
+            const double* leftRow = left + i * leftStride;
+            for (int k = 0; k < depth; k++)
             {
-                GetCoFactor(matrix, temp, i, j, n);
-                sign = ((i + j) % 2 == 0) ? 1 : -1;
-                adjointMatrix[j][i] = (sign) * (LNLib::MathUtils::GetDeterminant(temp, n - 1));
+                double factor = leftRow[k];
+                const double* rightRow = right + k * rightStride;
+                int j = 0;
+#ifdef LNLIB_MATHUTILS_SSE2
+                __m128d lanes = _mm_set1_pd(factor);
+                for (; j + 1 < columns; j += 2)
+                {
+                    __m128d sum = _mm_add_pd(_mm_loadu_pd(resultRow + j), _mm_mul_pd(lanes, _mm_loadu_pd(rightRow + j)));
+                    _mm_storeu_pd(resultRow + j, sum);
+                }
+#endif
+                for (; j < columns; j++)
+                {
+                    resultRow[j] += factor * rightRow[j];
+                }
             }
         }
     }
@@ -121,7 +128,12 @@ int LNLib::MathUtils::Factorial(int number)
 
 double LNLib::MathUtils::Binomial(int number, int i)
 {
-    return Factorial(number) / (Factorial(i) * Factorial(number - 1));
+    double result = 1.0;
+    for (int k = 1; k <= i; k++)
+    {
+        result = result * (number - i + k) / k;
+    }
+    return result;
 }
 
 double LNLib::MathUtils::ComputerCubicEquationsWithOneVariable(double cubic, double quadratic, double linear, double constant)
@@ -139,21 +151,63 @@ double LNLib::MathUtils::ComputerCubicEquationsWithOneVariable(double cubic, dou
 
 std::vector<std::vector<double>> LNLib::MathUtils::MatrixMultiply(const std::vector<std::vector<double>>& left, const std::vector<std::vector<double>>& right)
 {
-    int m = left.size();
-    int n = left[0].size();
-    int p = right[0].size();
+    LN_Matrix flatLeft;
+    LN_Matrix flatRight;
+    ToFlatMatrix(left, flatLeft);
+    ToFlatMatrix(right, flatRight);
+
+    LN_Matrix result;
+    MatrixMultiply(flatLeft, flatRight, result);
+    return ToNestedMatrix(result);
+}
+
+void LNLib::MathUtils::MatrixMultiply(const LN_Matrix& left, const LN_Matrix& right, LN_Matrix& result)
+{
+    VALIDATE_ARGUMENT(left.ColumnCount == right.RowCount, "right", "Right matrix row count must equal left matrix column count.");
+
+    result.RowCount = left.RowCount;
+    result.ColumnCount = right.ColumnCount;
+    result.Elements.resize(left.RowCount * right.ColumnCount);
+    MatrixMultiply(left.Elements.data(), right.Elements.data(), left.RowCount, left.ColumnCount, right.ColumnCount, result.Elements.data());
+}
 
-    std::vector<std::vector<double>> result(m, std::vector<double>(p,0.0));
-    for (int i = 0; i < m; i++)
+void LNLib::MathUtils::MatrixMultiply(const double* left, const double* right, int rows, int depth, int columns, double* result)
+{
+    std::fill(result, result + rows * columns, 0.0);
+    for (int ii = 0; ii < rows; ii += MatrixBlockSize)
     {
-        for (int j = 0; j < p; j++)
+        int blockRows = std::min(MatrixBlockSize, rows - ii);
+        for (int kk = 0; kk < depth; kk += MatrixBlockSize)
         {
-            for (int k = 0; k < n; k++)
+            int blockDepth = std::min(MatrixBlockSize, depth - kk);
+            for (int jj = 0; jj < columns; jj += MatrixBlockSize)
             {
-                result[i][j] += left[i][k] * right[k][j];
+                int blockColumns = std::min(MatrixBlockSize, columns - jj);
+                MultiplyMatrixBlock(left + ii * depth + kk, depth, right + kk * columns + jj, columns, result + ii * columns + jj, columns, blockRows, blockDepth, blockColumns);
             }
         }
     }
+}
+
+void LNLib::MathUtils::ToFlatMatrix(const std::vector<std::vector<double>>& matrix, LN_Matrix& result)
+{
+    result.RowCount = matrix.size();
+    result.ColumnCount = matrix.empty() ? 0 : matrix[0].size();
+    result.Elements.resize(result.RowCount * result.ColumnCount);
+    for (int i = 0; i < result.RowCount; i++)
+    {
+        std::copy(matrix[i].begin(), matrix[i].begin() + result.ColumnCount, result.Elements.begin() + i * result.ColumnCount);
+    }
+}
+
+std::vector<std::vector<double>> LNLib::MathUtils::ToNestedMatrix(const LN_Matrix& matrix)
+{
+    std::vector<std::vector<double>> result(matrix.RowCount);
+    for (int i = 0; i < matrix.RowCount; i++)
+    {
+        std::vector<double>::const_iterator row = matrix.Elements.begin() + i * matrix.ColumnCount;
+        result[i].assign(row, row + matrix.ColumnCount);
+    }
     return result;
 }
 
@@ -200,168 +254,60 @@ bool LNLib::MathUtils::IsSquareMatrix(const std::vector<std::vector<double>>& ma
 
 double LNLib::MathUtils::GetDeterminant(const std::vector<std::vector<double>>& matrix, int dimension)
 {
-    if (!IsSquareMatrix(matrix))
+    if (!IsSquareMatrix(matrix) || dimension <= 0 || dimension > matrix.size())
     {
         return 0.0;
     }
-   
-    std::vector<std::vector<double>> temp = matrix;
-    double result = 0.0;
-    if (dimension == 1)
-    {
-        return matrix[0][0];
-    }
-       
-    int sign = 1; 
-    for (int f = 0; f < dimension; f++) 
+
+    std::vector<std::vector<double>> leading(dimension, std::vector<double>(dimension));
+    for (int i = 0; i < dimension; i++)
     {
-        GetCoFactor(matrix, temp, 0, f, dimension);
-        result += sign * matrix[0][f] * GetDeterminant(temp, dimension - 1);
-        sign = -sign;
+        for (int j = 0; j < dimension; j++)
+        {
+            leading[i][j] = matrix[i][j];
+        }
     }
 
-    return result;
-}
-
-bool LNLib::MathUtils::MakeInverse(const std::vector<std::vector<double>>& matrix, std::vector<std::vector<double>>& inverse)
-{
-    if (!IsSquareMatrix(matrix))
+    std::vector<std::vector<double>> decomposed;
+    std::vector<int> pivot;
+    if (!LUPDecomposition(leading, decomposed, pivot))
     {
-        return false;
+        return 0.0;
     }
 
-    int n = matrix.size();
-    double det = GetDeterminant(matrix, n);
-    if (IsAlmostEqualTo(det, 0.0))
+    double result = 1.0;
+    for (int i = 0; i < dimension; i++)
     {
-        if (n == 1 && !IsAlmostEqualTo(matrix[0][0],0.0))
-        {
-            inverse = { { 1.0/(double)matrix[0][0]} };
-            return true;
-        }
-        else
-        {
-            return false;
-        }
+        result *= decomposed[i][i];
     }
 
-    std::vector<std::vector<double>> lower;
-    std::vector<std::vector<double>> upper;
-    if (LUDecomposition(matrix, lower, upper))
+    std::vector<int> permutation = pivot;
+    for (int i = 0; i < dimension; i++)
     {
-        std::vector<std::vector<double>> inverseLower(n, std::vector<double>(n));
-        std::vector<std::vector<double>> inverseUpper(n, std::vector<double>(n));
-
-        for (int i = 0; i < n; i++)
+        while (permutation[i] != i)
         {
-            inverseUpper[i][i] = 1 / upper[i][i];
-            for (int k = i - 1; k >= 0; k--)
-            {
-                double s = 0;
-                for (int j = k + 1; j <= i; j++)
-                {
-                    s = s + upper[k][j] * inverseUpper[j][i];
-                }
-                if (IsAlmostEqualTo(abs(s), 0.0))
-                {
-                    inverseUpper[k][i] = 0.0;
-                }
-                else
-                {
-                    inverseUpper[k][i] = -s / upper[k][k];
-                }
-            }
+            std::swap(permutation[i], permutation[permutation[i]]);
+            result = -result;
         }
-
-        for (int i = 0; i < n; i++)
-        {
-            inverseLower[i][i] = 1;
-            for (int k = i + 1; k < n; k++)
-            {
-                for (int j = i; j <= k - 1; j++)
-                {
-                    double temp = inverseLower[k][i] - lower[k][j] * inverseLower[j][i];
-                    if (IsAlmostEqualTo(temp, 0.0))
-                    {
-                        inverseLower[k][i] = 0.0;
-                    }
-                    else
-                    {
-                        inverseLower[k][i] = temp;
-                    }
-                }
-            }
-        }
-
-        inverse = MatrixMultiply(inverseUpper, inverseLower);
-        return true;
     }
-    else
-    {
-        bool rs = false;
-        inverse.resize(n);
-        for (int k = 0; k < n; k++)
-        {
-            inverse[k].resize(n);
-        }
-        for (int k = 0; k < n; k++)
-        {
-            std::vector<double> b(n, 0.0);
-            b[k] = 1;
-            std::vector<double> pivot;
-            if (!LUPDecomposition(matrix, lower, upper, pivot))
-            {
-                rs = false;
-                break;
-            }
-            std::vector<double> x(n);
-            std::vector<double> y(n);
+    return result;
+}
 
-            for (int i = 0; i < n; i++)
-            {
-                y[i] = b[static_cast<int>(pivot[i])];
-                for (int j = 0; j < i; j++)
-                {
-                    y[i] = y[i] - lower[i][j] * y[j];
-                }
-            }
-            for (int i = n - 1; i >= 0; i--)
-            {
-                x[i] = y[i];
-                for (int j = n - 1; j > i; j--)
-                {
-                    x[i] = x[i] - upper[i][j] * x[j];
-                }
-                x[i] /= upper[i][i];
-            }
-            
-            for (int i = 0; i < n; i++)
-            {
-                inverse[i][k] = x[i];
-            }
-        }
-        if (rs)
-        {
-            return true;
-        }
-        else
-        {
-            std::vector<std::vector<double>> adjoint(n, std::vector<double>(n));
-            GetAdjointMatrix(matrix, adjoint);
-            for (int i = 0; i < n; i++)
-            {
-                for (int j = 0; j < n; j++)
-                {
-                    inverse[i][j] = adjoint[i][j] / float(det);
-                }
-            }       
-            return true;
-        }
+bool LNLib::MathUtils::MakeInverse(const std::vector<std::vector<double>>& matrix, std::vector<std::vector<double>>& inverse)
+{
+    std::vector<std::vector<double>> decomposed;
+    std::vector<int> pivot;
+    if (!LUPDecomposition(matrix, decomposed, pivot))
+    {
+        return false;
     }
+    inverse = ForwardAndBackwardSubstitution(decomposed, pivot, MakeDiagonal(matrix.size()));
+    return true;
 }
 
 bool LNLib::MathUtils::LUDecomposition(const std::vector<std::vector<double>>& matrix, std::vector<std::vector<double>>& lowerTriMatrix, std::vector<std::vector<double>>& upperTriMatrix)
 {
+    LNLIB_COUNT(LinearSolves, 1);
     if (!IsSquareMatrix(matrix))
     {
         return false;
@@ -429,101 +375,369 @@ bool LNLib::MathUtils::LUDecomposition(const std::vector<std::vector<double>>& m
 
 bool LNLib::MathUtils::LUPDecomposition(const std::vector<std::vector<double>>& matrix, std::vector<std::vector<double>>& lowerTriMatrix, std::vector<std::vector<double>>& upperTriMatrix, std::vector<double>& pivot)
 {
-    if (!IsSquareMatrix(matrix))
+    std::vector<std::vector<double>> decomposed;
+    std::vector<int> rowPivot;
+    if (!LUPDecomposition(matrix, decomposed, rowPivot))
     {
         return false;
     }
 
     int n = matrix.size();
-    std::vector<std::vector<double>> copy(n, std::vector<double>(n));
+    lowerTriMatrix.assign(n, std::vector<double>(n, 0.0));
+    upperTriMatrix.assign(n, std::vector<double>(n, 0.0));
+    pivot.resize(n);
     for (int i = 0; i < n; i++)
     {
-        for (int j = 0; j < n; j++)
+        pivot[i] = rowPivot[i];
+        for (int j = 0; j < i; j++)
+        {
+            lowerTriMatrix[i][j] = decomposed[i][j];
+        }
+        lowerTriMatrix[i][i] = 1.0;
+        for (int k = i; k < n; k++)
         {
-            copy[i][j] = matrix[i][j];
-            lowerTriMatrix[i][j] = 0.0;
-            upperTriMatrix[i][j] = 0.0;
+            upperTriMatrix[i][k] = decomposed[i][k];
         }
     }
+    return true;
+}
+
+bool LNLib::MathUtils::LUPDecomposition(const std::vector<std::vector<double>>& matrix, std::vector<std::vector<double>>& decomposedMatrix, std::vector<int>& pivot)
+{
+    LNLIB_COUNT(LinearSolves, 1);
+    if (!IsSquareMatrix(matrix))
+    {
+        return false;
+    }
+
+    int n = matrix.size();
+    decomposedMatrix = matrix;
     pivot.resize(n);
+    double scale = 0.0;
     for (int i = 0; i < n; i++)
     {
         pivot[i] = i;
+        for (int j = 0; j < n; j++)
+        {
+            scale = std::max(scale, std::abs(matrix[i][j]));
+        }
     }
 
-    int row = 0;
-    for (int i = 0; i < n - 1; i++)
+    for (int i = 0; i < n; i++)
     {
+        int row = i;
         double p = 0.0;
         for (int j = i; j < n; j++)
         {
-            if (IsGreaterThan(abs(copy[j][i]),p))
+            double current = std::abs(decomposedMatrix[j][i]);
+            if (current > p)
             {
-                p = abs(copy[j][i]);
+                p = current;
                 row = j;
             }
         }
-        if (IsAlmostEqualTo(p,0.0))
+        // Inclusive so that a zero matrix, whose relative tolerance is zero, is rejected too.
+        if (p <= Constants::DoubleEpsilon * scale)
         {
             return false;
         }
 
-        int tmp = pivot[i];
-        pivot[i] = pivot[row];
-        pivot[row] = tmp;
-
-        double tmp2 = 0.0;
-        for (int j = 0; j < n; j++)
+        if (row != i)
         {
-            tmp2 = copy[i][j];
-            copy[i][j] = copy[row][j];
-            copy[row][j] = tmp2;
+            std::swap(pivot[i], pivot[row]);
+            decomposedMatrix[i].swap(decomposedMatrix[row]);
         }
 
-        double u = copy[i][i];
-        double l = 0.0;
+        const std::vector<double>& pivotRow = decomposedMatrix[i];
+        double u = pivotRow[i];
         for (int j = i + 1; j < n; j++)
         {
-            l = copy[j][i] / u;
-            copy[j][i] = l;
+            std::vector<double>& currentRow = decomposedMatrix[j];
+            double l = currentRow[i] / u;
+            currentRow[i] = l;
+            if (l == 0.0) continue;
             for (int k = i + 1; k < n; k++)
             {
-                copy[j][k] = copy[j][k] - copy[i][k] * l;
+                currentRow[k] -= pivotRow[k] * l;
             }
         }
     }
+    return true;
+}
+
+std::vector<std::vector<double>> LNLib::MathUtils::ForwardAndBackwardSubstitution(const std::vector<std::vector<double>>& decomposedMatrix, const std::vector<int>& pivot, const std::vector<std::vector<double>>& right)
+{
+    int n = decomposedMatrix.size();
+    int m = right.size() > 0 ? right[0].size() : 0;
 
+    std::vector<std::vector<double>> result(n, std::vector<double>(m));
     for (int i = 0; i < n; i++)
     {
-        for (int j = 0; j <= i; j++)
+        std::vector<double>& current = result[i];
+        current = right[pivot[i]];
+        const std::vector<double>& row = decomposedMatrix[i];
+        for (int j = 0; j < i; j++)
         {
-            if (i != j)
+            double l = row[j];
+            if (l == 0.0) continue;
+            const std::vector<double>& solved = result[j];
+            for (int k = 0; k < m; k++)
             {
-                lowerTriMatrix[i][j] = copy[i][j];
+                current[k] -= l * solved[k];
             }
-            else
+        }
+    }
+    for (int i = n - 1; i >= 0; i--)
+    {
+        std::vector<double>& current = result[i];
+        const std::vector<double>& row = decomposedMatrix[i];
+        for (int j = i + 1; j < n; j++)
+        {
+            double u = row[j];
+            if (u == 0.0) continue;
+            const std::vector<double>& solved = result[j];
+            for (int k = 0; k < m; k++)
             {
-                lowerTriMatrix[i][j] = 1;
+                current[k] -= u * solved[k];
             }
         }
-        for (int k = i; k < n; k++)
+        double diagonal = row[i];
+        for (int k = 0; k < m; k++)
         {
-            upperTriMatrix[i][k] = copy[i][k];
+            current[k] /= diagonal;
         }
     }
-    return true;
+    return result;
 }
 
 std::vector<std::vector<double>> LNLib::MathUtils::SolveLinearSystem(const std::vector<std::vector<double>>& matrix, const std::vector<std::vector<double>>& right)
 {
     std::vector<std::vector<double>> result;
-    std::vector<std::vector<double>> inverse;
-    bool canInverse = MakeInverse(matrix, inverse);
-    if (canInverse)
+    std::vector<std::vector<double>> decomposed;
+    std::vector<int> pivot;
+    if (LUPDecomposition(matrix, decomposed, pivot))
     {
-        result = MatrixMultiply(inverse, right);
+        result = ForwardAndBackwardSubstitution(decomposed, pivot, right);
     }
     return result;
 }
 
+std::vector<std::vector<double>> LNLib::MathUtils::CreateBandedMatrix(int size, int lowerBandwidth, int upperBandwidth)
+{
+    return std::vector<std::vector<double>>(size, std::vector<double>(lowerBandwidth + upperBandwidth + 1, 0.0));
+}
+
+bool LNLib::MathUtils::BandedLUDecomposition(std::vector<std::vector<double>>& band, int lowerBandwidth, int upperBandwidth)
+{
+    LNLIB_COUNT(LinearSolves, 1);
+    int n = band.size();
+    double scale = 0.0;
+    for (int i = 0; i < n; i++)
+    {
+        for (int j = 0; j < band[i].size(); j++)
+        {
+            scale = std::max(scale, std::abs(band[i][j]));
+        }
+    }
+
+    for (int i = 0; i < n; i++)
+    {
+        std::vector<double>& pivotRow = band[i];
+        double u = pivotRow[lowerBandwidth];
+        if (std::abs(u) <= Constants::DoubleEpsilon * scale)
+        {
+            return false;
+        }
 
+        int lastRow = std::min(n - 1, i + lowerBandwidth);
+        int lastColumn = std::min(n - 1, i + upperBandwidth);
+        for (int j = i + 1; j <= lastRow; j++)
+        {
+            std::vector<double>& currentRow = band[j];
+            int offset = lowerBandwidth - j;
+            double l = currentRow[i + offset] / u;
+            currentRow[i + offset] = l;
+            if (l == 0.0) continue;
+            for (int k = i + 1; k <= lastColumn; k++)
+            {
+                currentRow[k + offset] -= l * pivotRow[k - i + lowerBandwidth];
+            }
+        }
+    }
+    return true;
+}
+
+std::vector<std::vector<double>> LNLib::MathUtils::BandedForwardAndBackwardSubstitution(const std::vector<std::vector<double>>& band, int lowerBandwidth, int upperBandwidth, const std::vector<std::vector<double>>& right)
+{
+    int n = band.size();
+    int m = right.size() > 0 ? right[0].size() : 0;
+
+    std::vector<std::vector<double>> result = right;
+    for (int i = 0; i < n; i++)
+    {
+        std::vector<double>& current = result[i];
+        const std::vector<double>& row = band[i];
+        for (int j = std::max(0, i - lowerBandwidth); j < i; j++)
+        {
+            double l = row[j - i + lowerBandwidth];
+            if (l == 0.0) continue;
+            const std::vector<double>& solved = result[j];
+            for (int k = 0; k < m; k++)
+            {
+                current[k] -= l * solved[k];
+            }
+        }
+    }
+    for (int i = n - 1; i >= 0; i--)
+    {
+        std::vector<double>& current = result[i];
+        const std::vector<double>& row = band[i];
+        int lastColumn = std::min(n - 1, i + upperBandwidth);
+        for (int j = i + 1; j <= lastColumn; j++)
+        {
+            double u = row[j - i + lowerBandwidth];
+            if (u == 0.0) continue;
+            const std::vector<double>& solved = result[j];
+            for (int k = 0; k < m; k++)
+            {
+                current[k] -= u * solved[k];
+            }
+        }
+        double diagonal = row[lowerBandwidth];
+        for (int k = 0; k < m; k++)
+        {
+            current[k] /= diagonal;
+        }
+    }
+    return result;
+}
+
+std::vector<std::vector<double>> LNLib::MathUtils::SolveBandedLinearSystem(const std::vector<std::vector<double>>& band, int lowerBandwidth, int upperBandwidth, const std::vector<std::vector<double>>& right)
+{
+    std::vector<std::vector<double>> decomposed = band;
+    if (BandedLUDecomposition(decomposed, lowerBandwidth, upperBandwidth))
+    {
+        return BandedForwardAndBackwardSubstitution(decomposed, lowerBandwidth, upperBandwidth, right);
+    }
+
+    int n = band.size();
+    std::vector<std::vector<double>> dense(n, std::vector<double>(n, 0.0));
+    for (int i = 0; i < n; i++)
+    {
+        int firstColumn = std::max(0, i - lowerBandwidth);
+        int lastColumn = std::min(n - 1, i + upperBandwidth);
+        for (int j = firstColumn; j <= lastColumn; j++)
+        {
+            dense[i][j] = band[i][j - i + lowerBandwidth];
+        }
+    }
+    return SolveLinearSystem(dense, right);
+}
+
+bool LNLib::MathUtils::SymmetricBandedCholeskyDecomposition(std::vector<std::vector<double>>& band, int bandwidth)
+{
+    LNLIB_COUNT(LinearSolves, 1);
+    int n = band.size();
+    double scale = 0.0;
+    for (int i = 0; i < n; i++)
+    {
+        scale = std::max(scale, std::abs(band[i][bandwidth]));
+    }
+
+    for (int i = 0; i < n; i++)
+    {
+        std::vector<double>& currentRow = band[i];
+        int firstColumn = std::max(0, i - bandwidth);
+        for (int j = firstColumn; j <= i; j++)
+        {
+            const std::vector<double>& pivotRow = band[j];
+            double sum = currentRow[j - i + bandwidth];
+            for (int k = std::max(firstColumn, j - bandwidth); k < j; k++)
+            {
+                sum -= currentRow[k - i + bandwidth] * pivotRow[k - j + bandwidth];
+            }
+            if (j < i)
+            {
+                currentRow[j - i + bandwidth] = sum / pivotRow[bandwidth];
+                continue;
+            }
+            if (sum <= Constants::DoubleEpsilon * scale)
+            {
+                return false;
+            }
+            currentRow[bandwidth] = std::sqrt(sum);
+        }
+    }
+    return true;
+}
+
+std::vector<std::vector<double>> LNLib::MathUtils::SymmetricBandedForwardAndBackwardSubstitution(const std::vector<std::vector<double>>& band, int bandwidth, const std::vector<std::vector<double>>& right)
+{
+    int n = band.size();
+    int m = right.size() > 0 ? right[0].size() : 0;
+
+    std::vector<std::vector<double>> result = right;
+    for (int i = 0; i < n; i++)
+    {
+        std::vector<double>& current = result[i];
+        const std::vector<double>& row = band[i];
+        for (int j = std::max(0, i - bandwidth); j < i; j++)
+        {
+            double l = row[j - i + bandwidth];
+            if (l == 0.0) continue;
+            const std::vector<double>& solved = result[j];
+            for (int k = 0; k < m; k++)
+            {
+                current[k] -= l * solved[k];
+            }
+        }
+        double diagonal = row[bandwidth];
+        for (int k = 0; k < m; k++)
+        {
+            current[k] /= diagonal;
+        }
+    }
+    for (int i = n - 1; i >= 0; i--)
+    {
+        std::vector<double>& current = result[i];
+        int lastRow = std::min(n - 1, i + bandwidth);
+        for (int j = i + 1; j <= lastRow; j++)
+        {
+            double l = band[j][i - j + bandwidth];
+            if (l == 0.0) continue;
+            const std::vector<double>& solved = result[j];
+            for (int k = 0; k < m; k++)
+            {
+                current[k] -= l * solved[k];
+            }
+        }
+        double diagonal = band[i][bandwidth];
+        for (int k = 0; k < m; k++)
+        {
+            current[k] /= diagonal;
+        }
+    }
+    return result;
+}
+
+std::vector<std::vector<double>> LNLib::MathUtils::SolveSymmetricBandedLinearSystem(const std::vector<std::vector<double>>& band, int bandwidth, const std::vector<std::vector<double>>& right)
+{
+    std::vector<std::vector<double>> decomposed = band;
+    if (SymmetricBandedCholeskyDecomposition(decomposed, bandwidth))
+    {
+        return SymmetricBandedForwardAndBackwardSubstitution(decomposed, bandwidth, right);
+    }
+
+    int n = band.size();
+    std::vector<std::vector<double>> full = CreateBandedMatrix(n, bandwidth, bandwidth);
+    for (int i = 0; i < n; i++)
+    {
+        for (int j = std::max(0, i - bandwidth); j <= i; j++)
+        {
+            double value = band[i][j - i + bandwidth];
+            full[i][j - i + bandwidth] = value;
+            full[j][i - j + bandwidth] = value;
+        }
+    }
+    return SolveBandedLinearSystem(full, bandwidth, bandwidth, right);
+}
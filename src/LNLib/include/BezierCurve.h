@@ -11,11 +11,13 @@
 #pragma once
 
 #include "Polynomials.h"
+#include "Constants.h"
 #include "ValidationUtils.h"
 #include "LNLibDefinitions.h"
 #include "LNLibExceptions.h"
 #include "LNObject.h"
 #include <vector>
+#include <algorithm>
 
 namespace LNLib
 {
@@ -29,7 +31,7 @@ namespace LNLib
 		static void Check(const LN_BezierCurve<T>& curve)
 		{
 			int degree = curve.Degree;
-			std::vector<T> controlPoints = curve.ControlPoints;
+			const std::vector<T>& controlPoints = curve.ControlPoints;
 
 			VALIDATE_ARGUMENT(degree > 0, "degree", "Degree must greater than zero.");
 			VALIDATE_ARGUMENT(controlPoints.size() > 0, "controlPoints", "ControlPoints must contains one point at least.");
@@ -49,9 +51,17 @@ namespace LNLib
 			VALIDATE_ARGUMENT_RANGE(paramT, 0.0, 1.0);
 
 			int degree = curve.Degree;
-			std::vector<T> controlPoints = curve.ControlPoints;
+			const std::vector<T>& controlPoints = curve.ControlPoints;
 
-			std::vector<double> bernsteinArray = Polynomials::AllBernstein(degree, paramT);
+			double stackBernstein[Constants::MaxStackBasisSize];
+			std::vector<double> heapBernstein;
+			double* bernsteinArray = stackBernstein;
+			if (degree + 1 > Constants::MaxStackBasisSize)
+			{
+				heapBernstein.resize(degree + 1);
+				bernsteinArray = heapBernstein.data();
+			}
+			Polynomials::AllBernstein(degree, paramT, bernsteinArray);
 			T temp;
 			for (int k = 0; k <= degree; k++)
 			{
@@ -73,7 +83,15 @@ namespace LNLib
 			VALIDATE_ARGUMENT_RANGE(paramT, 0.0, 1.0);
 
 			int degree = curve.Degree;
-			std::vector<T> temp = curve.ControlPoints;
+			T stackTemp[Constants::MaxStackBasisSize];
+			std::vector<T> heapTemp;
+			T* temp = stackTemp;
+			if (degree + 1 > Constants::MaxStackBasisSize)
+			{
+				heapTemp.resize(degree + 1);
+				temp = heapTemp.data();
+			}
+			std::copy(curve.ControlPoints.begin(), curve.ControlPoints.begin() + degree + 1, temp);
 			for (int k = 1; k <= degree; k++)
 			{
 				for (int i = 0; i <= degree - k; i++)
@@ -84,6 +102,43 @@ namespace LNLib
 			return temp[0];
 		}
 
+		/// <summary>
+		/// Bernstein polynomials of degree at every param, computed once for a fixed sampling pattern.
+		/// </summary>
+		static void CreateBernsteinTable(int degree, const std::vector<double>& params, LN_BernsteinTable& table);
+
+		/// <summary>
+		/// The NURBS Book 2nd Edition Page22
+		/// Equation (1.7) at every param of table, points[i] = C(table.Params[i]).
+		/// Each control point is accumulated over all params by one contiguous row of the table, so no buffer is allocated.
+		/// 
+		/// Rational Bezier Curve:Use XYZW 
+		/// </summary>
+		template <typename T>
+		static void GetPointsOnCurve(const LN_BezierCurve<T>& curve, const LN_BernsteinTable& table, T* points)
+		{
+			int degree = curve.Degree;
+			const std::vector<T>& controlPoints = curve.ControlPoints;
+			VALIDATE_ARGUMENT(degree == table.Degree, "table", "Table degree must equal curve degree.");
+			VALIDATE_ARGUMENT(ValidationUtils::IsValidBezier(degree, controlPoints.size()), "controlPoints", "ControlPoints count equals degree plus one.");
+
+			int count = table.Params.size();
+			const double* values = table.Values.data();
+			for (int i = 0; i < count; i++)
+			{
+				points[i] = values[i] * controlPoints[0];
+			}
+			for (int k = 1; k <= degree; k++)
+			{
+				const double* row = values + k * count;
+				const T& controlPoint = controlPoints[k];
+				for (int i = 0; i < count; i++)
+				{
+					points[i] += row[i] * controlPoint;
+				}
+			}
+		}
+
 		/// <summary>
 		/// The NURBS Book 2nd Edition Page291
 		/// The quadratic rational Bezier arc.
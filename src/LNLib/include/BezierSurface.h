@@ -14,7 +14,9 @@
 #include "BezierCurve.h"
 #include "LNLibDefinitions.h"
 #include "LNObject.h"
+#include "Constants.h"
 #include <vector>
+#include <algorithm>
 
 namespace LNLib {
 
@@ -30,7 +32,7 @@ namespace LNLib {
 		{
 			int degreeU = surface.DegreeU;
 			int degreeV = surface.DegreeV;
-			std::vector<T> controlPoints = surface.ControlPoints;
+			const std::vector<std::vector<T>>& controlPoints = surface.ControlPoints;
 
 			VALIDATE_ARGUMENT(degreeU > 0, "degreeU", "Degree must greater than zero.");
 			VALIDATE_ARGUMENT(degreeV > 0, "degreeV", "Degree must greater than zero.");
@@ -63,25 +65,104 @@ namespace LNLib {
 
 			int degreeU = surface.DegreeU;
 			int degreeV = surface.DegreeV;
-			std::vector<std::vector<T>> controlPoints = surface.ControlPoints;
+			const std::vector<std::vector<T>>& controlPoints = surface.ControlPoints;
+			double u = uv.GetU();
+			double v = uv.GetV();
 
-			T point;
-			std::vector<T> temp(degreeU + 1);
+			// Rows are reduced in v one after another into row, their points in u into column.
+			T stackRow[Constants::MaxStackBasisSize];
+			T stackColumn[Constants::MaxStackBasisSize];
+			std::vector<T> heapRow;
+			std::vector<T> heapColumn;
+			T* row = stackRow;
+			T* column = stackColumn;
+			if (degreeV + 1 > Constants::MaxStackBasisSize)
+			{
+				heapRow.resize(degreeV + 1);
+				row = heapRow.data();
+			}
+			if (degreeU + 1 > Constants::MaxStackBasisSize)
+			{
+				heapColumn.resize(degreeU + 1);
+				column = heapColumn.data();
+			}
 			for (int i = 0; i <= degreeU; i++)
 			{
-				LN_BezierCurve<T> b;
-				b.Degree = degreeV;
-				b.ControlPoints = controlPoints[i];
-
-				temp[i] = BezierCurve::GetPointOnCurveByDeCasteljau(b, uv.GetV());
+				std::copy(controlPoints[i].begin(), controlPoints[i].begin() + degreeV + 1, row);
+				for (int k = 1; k <= degreeV; k++)
+				{
+					for (int j = 0; j <= degreeV - k; j++)
+					{
+						row[j] = (1.0 - v) * row[j] + v * row[j + 1];
+					}
+				}
+				column[i] = row[0];
 			}
+			for (int k = 1; k <= degreeU; k++)
+			{
+				for (int i = 0; i <= degreeU - k; i++)
+				{
+					column[i] = (1.0 - u) * column[i] + u * column[i + 1];
+				}
+			}
+			return column[0];
+		}
 
-			LN_BezierCurve<T> bezierCurve;
-			bezierCurve.Degree = degreeU;
-			bezierCurve.ControlPoints = temp;
+		/// <summary>
+		/// The NURBS Book 2nd Edition Page37
+		/// Equation (1.11) on the grid of tableU and tableV params, points[i * tableV.Params.size() + j] = S(tableU.Params[i], tableV.Params[j]).
+		/// Each grid row first reduces the net in u to one row of degreeV + 1 points, which then streams over the rows of tableV.
+		/// 
+		/// Rational Bezier Surface:Use XYZW
+		/// </summary>
+		template <typename T>
+		static void GetPointsOnSurface(const LN_BezierSurface<T>& surface, const LN_BernsteinTable& tableU, const LN_BernsteinTable& tableV, T* points)
+		{
+			Check(surface);
+			int degreeU = surface.DegreeU;
+			int degreeV = surface.DegreeV;
+			const std::vector<std::vector<T>>& controlPoints = surface.ControlPoints;
+			VALIDATE_ARGUMENT(degreeU == tableU.Degree, "tableU", "TableU degree must equal surface degreeU.");
+			VALIDATE_ARGUMENT(degreeV == tableV.Degree, "tableV", "TableV degree must equal surface degreeV.");
 
-			point = BezierCurve::GetPointOnCurveByDeCasteljau(bezierCurve, uv.GetU());
-			return point;
+			int countU = tableU.Params.size();
+			int countV = tableV.Params.size();
+			const double* valuesU = tableU.Values.data();
+			const double* valuesV = tableV.Values.data();
+
+			T stackRow[Constants::MaxStackBasisSize];
+			std::vector<T> heapRow;
+			T* row = stackRow;
+			if (degreeV + 1 > Constants::MaxStackBasisSize)
+			{
+				heapRow.resize(degreeV + 1);
+				row = heapRow.data();
+			}
+			for (int i = 0; i < countU; i++)
+			{
+				for (int l = 0; l <= degreeV; l++)
+				{
+					row[l] = valuesU[i] * controlPoints[0][l];
+					for (int k = 1; k <= degreeU; k++)
+					{
+						row[l] += valuesU[k * countU + i] * controlPoints[k][l];
+					}
+				}
+				T* gridRow = points + i * countV;
+				for (int j = 0; j < countV; j++)
+				{
+					gridRow[j] = valuesV[j] * row[0];
+				}
+				for (int l = 1; l <= degreeV; l++)
+				{
+					const double* basis = valuesV + l * countV;
+					const T& point = row[l];
+					for (int j = 0; j < countV; j++)
+					{
+						gridRow[j] += basis[j] * point;
+					}
+				}
+			}
 		}
 	};
 }
@@ -0,0 +1,96 @@
+/*
+ * Author:
+ * 2024/10/14 - Yuqing Liang (BIMCoder Liang)
+ * bim.frankliang@foxmail.com
+ * 微信公众号：BIMCoder梁老师
+ *
+ * Use of this source code is governed by a GPL-3.0 license that can be found in
+ * the LICENSE file.
+ */
+
+#pragma once
+#include "LNLibDefinitions.h"
+#include "LNObject.h"
+#include <vector>
+
+namespace LNLib
+{
+	class XYZ;
+
+	/// <summary>
+	/// Exact distance from the query point to one item of the hierarchy.
+	/// </summary>
+	class LNLIB_EXPORT ItemDistanceFunction
+	{
+	public:
+		virtual double operator()(int itemIndex, const XYZ& point) = 0;
+	};
+
+	/// <summary>
+	/// Exact first hit of the ray origin + t * direction with one item of the hierarchy.
+	/// Returns false when the item is not hit at a t in [0, maxParam), otherwise param receives t.
+	/// </summary>
+	class LNLIB_EXPORT ItemRayFunction
+	{
+	public:
+		virtual bool operator()(int itemIndex, const XYZ& origin, const XYZ& direction, double maxParam, double& param) = 0;
+	};
+
+	/// <summary>
+	/// Binary AABB tree over item boxes, split at the median of the longest axis.
+	/// The tree is read-only after Build, so queries can run concurrently.
+	/// </summary>
+	class LNLIB_EXPORT BoundingVolumeHierarchy
+	{
+	public:
+
+		void Build(const std::vector<LN_BoundingBox>& boxes);
+
+		bool IsEmpty() const;
+
+		static double SqrDistance(const LN_BoundingBox& box, const XYZ& point);
+
+		static bool IsOverlapped(const LN_BoundingBox& first, const LN_BoundingBox& second, double tolerance);
+
+		/// <summary>
+		/// Slab test of the ray origin + t * direction, t >= 0, against box enlarged by tolerance.
+		/// entryParam and exitParam receive the t range inside the box, entryParam is not less than zero.
+		/// </summary>
+		static bool IntersectRay(const LN_BoundingBox& box, const XYZ& origin, const XYZ& direction, double tolerance, double& entryParam, double& exitParam);
+
+		/// <summary>
+		/// Best-first search for the item closest to point.
+		/// Nodes whose box is farther than the best distance found so far are culled.
+		/// Returns item index, or -1 when the tree is empty.
+		/// </summary>
+		int FindNearest(const XYZ& point, ItemDistanceFunction& function, double& minDistance) const;
+
+		/// <summary>
+		/// Front-to-back search for the item first hit by the ray origin + t * direction, t >= 0.
+		/// Nodes whose box, enlarged by tolerance, is missed or entered after the best hit found so far are culled.
+		/// Returns item index and its hitParam, or -1 when nothing is hit.
+		/// </summary>
+		int FindFirstHit(const XYZ& origin, const XYZ& direction, double tolerance, ItemRayFunction& function, double& hitParam) const;
+
+		/// <summary>
+		/// Collect items whose box overlaps box enlarged by tolerance, subtrees with disjoint boxes are culled.
+		/// </summary>
+		void FindOverlaps(const LN_BoundingBox& box, double tolerance, std::vector<int>& items) const;
+
+	private:
+
+		struct Node
+		{
+			LN_BoundingBox Box;
+			int Left;
+			int Right;
+			int Start;
+			int Count;
+		};
+
+		int BuildNode(const std::vector<LN_BoundingBox>& boxes, int start, int end);
+
+		std::vector<Node> _nodes;
+		std::vector<int> _items;
+	};
+}
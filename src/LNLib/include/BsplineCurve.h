@@ -11,6 +11,7 @@
 #pragma once
 
 #include "LNLibDefinitions.h"
+#include "Constants.h"
 #include "Polynomials.h"
 #include "ValidationUtils.h"
 #include "LNLibExceptions.h"
@@ -29,8 +30,8 @@ namespace LNLib
 		static void Check(const LN_BsplineCurve<T>& curve)
 		{
 			int degree = curve.Degree;
-			std::vector<double> knotVectors = curve.KnotVector;
-			std::vector<T> controlPoints = curve.ControlPoints;
+			const std::vector<double>& knotVector = curve.KnotVector;
+			const std::vector<T>& controlPoints = curve.ControlPoints;
 
 			VALIDATE_ARGUMENT(degree > 0, "degree", "Degree must greater than zero.");
 			VALIDATE_ARGUMENT(knotVector.size() > 0, "knotVector", "KnotVector size must greater than zero.");
@@ -46,16 +47,36 @@ namespace LNLib
 		/// </summary>
 		template <typename T>
 		static T GetPointOnCurve(const LN_BsplineCurve<T>& curve, double paramT)
+		{
+			return GetPointOnCurve(LN_BsplineCurveView<T>(curve), paramT);
+		}
+
+		/// <summary>
+		/// The NURBS Book 2nd Edition Page82
+		/// Algorithm A3.1
+		/// Compute Bspline curve point without copying curve data.
+		/// </summary>
+		template <typename T>
+		static T GetPointOnCurve(const LN_BsplineCurveView<T>& curve, double paramT)
 		{
 			int degree = curve.Degree;
-			std::vector<double> knotVector = curve.KnotVector;
-			std::vector<T> controlPoints = curve.ControlPoints;
+			const std::vector<double>& knotVector = curve.KnotVector;
+			const std::vector<T>& controlPoints = curve.ControlPoints;
 
 			VALIDATE_ARGUMENT_RANGE(paramT, knotVector[0], knotVector[knotVector.size() - 1]);
 
+			double stackN[Constants::MaxStackBasisSize];
+			std::vector<double> heapN;
+			double* N = stackN;
+			if (degree >= Constants::MaxStackBasisSize)
+			{
+				heapN.resize(degree + 1);
+				N = heapN.data();
+			}
+
 			T point;
 			int spanIndex = Polynomials::GetKnotSpanIndex(degree, knotVector, paramT);
-			std::vector<double> N = Polynomials::BasisFunctions(spanIndex, degree, knotVector, paramT);
+			Polynomials::BasisFunctions(spanIndex, degree, knotVector, paramT, N);
 
 			for (int i = 0; i <= degree; i++)
 			{
@@ -71,29 +92,69 @@ namespace LNLib
 		/// </summary>
 		template<typename T>
 		static std::vector<T> ComputeDerivatives(const LN_BsplineCurve<T>& curve, int derivative, double paramT)
+		{
+			return ComputeDerivatives(LN_BsplineCurveView<T>(curve), derivative, paramT);
+		}
+
+		/// <summary>
+		/// The NURBS Book 2nd Edition Page93
+		/// Algorithm A3.2
+		/// Compute curve derivatives without copying curve data.
+		/// </summary>
+		template<typename T>
+		static std::vector<T> ComputeDerivatives(const LN_BsplineCurveView<T>& curve, int derivative, double paramT)
+		{
+			LN_DerivativeWorkspace workspace;
+			std::vector<T> derivatives(derivative + 1);
+			ComputeDerivatives(curve, derivative, paramT, workspace, derivatives.data());
+			return derivatives;
+		}
+
+		/// <summary>
+		/// The NURBS Book 2nd Edition Page93
+		/// Algorithm A3.2
+		/// Compute curve derivatives into caller owned buffer with (derivative + 1) values.
+		/// Basis derivatives are kept in workspace, so repeated calls do not allocate.
+		/// </summary>
+		template<typename T>
+		static void ComputeDerivatives(const LN_BsplineCurve<T>& curve, int derivative, double paramT, LN_DerivativeWorkspace& workspace, T* derivatives)
+		{
+			ComputeDerivatives(LN_BsplineCurveView<T>(curve), derivative, paramT, workspace, derivatives);
+		}
+
+		/// <summary>
+		/// The NURBS Book 2nd Edition Page93
+		/// Algorithm A3.2
+		/// Compute curve derivatives into caller owned buffer without copying curve data.
+		/// </summary>
+		template<typename T>
+		static void ComputeDerivatives(const LN_BsplineCurveView<T>& curve, int derivative, double paramT, LN_DerivativeWorkspace& workspace, T* derivatives)
 		{
 			int degree = curve.Degree;
-			std::vector<double> knotVector = curve.KnotVector;
-			std::vector<T> controlPoints = curve.ControlPoints;
+			const std::vector<double>& knotVector = curve.KnotVector;
+			const std::vector<T>& controlPoints = curve.ControlPoints;
 
 			VALIDATE_ARGUMENT(derivative > 0, "derivative", "derivative must greater than zero.");
-			VALIDATE_ARGUMENT_RANGE(paramT, knotVector[0], knotVector[knotVector.size() - 1]);				
-			
-			std::vector<T> derivatives(derivative + 1);
+			VALIDATE_ARGUMENT_RANGE(paramT, knotVector[0], knotVector[knotVector.size() - 1]);
 
 			int du = std::min(derivative, degree);
 			int spanIndex = Polynomials::GetKnotSpanIndex(degree, knotVector, paramT);
-			std::vector<std::vector<double>> nders = 
-				Polynomials::BasisFunctionsDerivatives(spanIndex, degree, du, knotVector, paramT);
+			workspace.BasisDerivatives.resize((du + 1) * (degree + 1));
+			double* nders = workspace.BasisDerivatives.data();
+			Polynomials::BasisFunctionsDerivatives(spanIndex, degree, du, knotVector, paramT, nders);
 
-			for (int k = 0; k <= du; k++)
+			for (int k = 0; k <= derivative; k++)
 			{
-				for (int j = 0; j <= degree; j++)
+				T der = T();
+				if (k <= du)
 				{
-					derivatives[k] += nders[k][j] * controlPoints[spanIndex - degree + j];
+					for (int j = 0; j <= degree; j++)
+					{
+						der += nders[k * (degree + 1) + j] * controlPoints[spanIndex - degree + j];
+					}
 				}
+				derivatives[k] = der;
 			}
-			return derivatives;
 		}
 
 		/// <summary>
@@ -108,8 +169,8 @@ namespace LNLib
 			VALIDATE_ARGUMENT_RANGE(minSpanIndex, 0, maxSpanIndex);
 
 			int degree = curve.Degree;
-			std::vector<double> knotVector = curve.KnotVector;
-			std::vector<T> controlPoints = curve.ControlPoints;
+			const std::vector<double>& knotVector = curve.KnotVector;
+			const std::vector<T>& controlPoints = curve.ControlPoints;
 
 			int range = maxSpanIndex - minSpanIndex;
 			std::vector<std::vector<T>> PK(derivative + 1, std::vector<T>(range + 1));
@@ -123,7 +184,9 @@ namespace LNLib
 				int temp = degree - k + 1;
 				for (int i = 0; i <= range - k; i++)
 				{
-					PK[k][i] = temp * (PK[k - 1][i + 1] - PK[k - 1][i]) / (knotVector[minSpanIndex + i + degree + 1] - knotVector[minSpanIndex + i + k]);
+					// A knot of multiplicity above degree - k + 1 empties the support of this basis function, its control point is left zero.
+					double denominator = knotVector[minSpanIndex + i + degree + 1] - knotVector[minSpanIndex + i + k];
+					PK[k][i] = denominator == 0.0 ? T() : temp * (PK[k - 1][i + 1] - PK[k - 1][i]) / denominator;
 				}
 			}
 			return PK;
@@ -138,8 +201,7 @@ namespace LNLib
 		static std::vector<T> ComputeDerivativesByAllBasisFunctions(const LN_BsplineCurve<T>& curve, int derivative, double paramT)
 		{
 			int degree = curve.Degree;
-			std::vector<double> knotVector = curve.KnotVector;
-			std::vector<T> controlPoints = curve.ControlPoints;
+			const std::vector<double>& knotVector = curve.KnotVector;
 
 			VALIDATE_ARGUMENT(derivative > 0, "derivative", "derivative must greater than zero.");
 			VALIDATE_ARGUMENT_RANGE(paramT, knotVector[0], knotVector[knotVector.size() - 1]);
@@ -150,12 +212,7 @@ namespace LNLib
 
 			int du = std::min(derivative, degree);
 
-			LN_BsplineCurve<T> bsplineCurve;
-			bsplineCurve.Degree = degree;
-			bsplineCurve.KnotVector = knotVector;
-			bsplineCurve.ControlPoints = controlPoints;
-
-			std::vector<std::vector<T>> PK = ComputeControlPointsOfDerivatives(bsplineCurve, du, spanIndex - degree, spanIndex);
+			std::vector<std::vector<T>> PK = ComputeControlPointsOfDerivatives(curve, du, spanIndex - degree, spanIndex);
 
 			for (int k = 0; k <= du; k++)
 			{
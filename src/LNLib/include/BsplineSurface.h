@@ -10,6 +10,7 @@
 
 #pragma once
 #include "LNLibDefinitions.h"
+#include "Constants.h"
 #include "Polynomials.h"
 #include "UV.h"
 #include "BsplineCurve.h"
@@ -31,9 +32,9 @@ namespace LNLib
 		{
 			int degreeU = surface.DegreeU;
 			int degreeV = surface.DegreeV;
-			std::vector<double> knotVectorU = surface.KnotVectorU;
-			std::vector<double> knotVectorV = surface.KnotVectorV;
-			std::vector<std::vector<T>> controlPoints = surface.ControlPoints;
+			const std::vector<double>& knotVectorU = surface.KnotVectorU;
+			const std::vector<double>& knotVectorV = surface.KnotVectorV;
+			const std::vector<std::vector<T>>& controlPoints = surface.ControlPoints;
 
 			VALIDATE_ARGUMENT(degreeU > 0, "degreeU", "Degree must greater than zero.");
 			VALIDATE_ARGUMENT(degreeV > 0, "degreeV", "Degree must greater than zero.");
@@ -53,21 +54,49 @@ namespace LNLib
 		/// </summary>
 		template <typename T>
 		static T GetPointOnSurface(const LN_BsplineSurface<T>& surface, UV uv)
+		{
+			return GetPointOnSurface(LN_BsplineSurfaceView<T>(surface), uv);
+		}
+
+		/// <summary>
+		/// The NURBS Book 2nd Edition Page103
+		/// Algorithm A3.5
+		/// Compute surface point without copying surface data.
+		/// </summary>
+		template <typename T>
+		static T GetPointOnSurface(const LN_BsplineSurfaceView<T>& surface, UV uv)
 		{
 			int degreeU = surface.DegreeU;
 			int degreeV = surface.DegreeV;
-			std::vector<double> knotVectorU = surface.KnotVectorU;
-			std::vector<double> knotVectorV = surface.KnotVectorV;
-			std::vector<std::vector<T>> controlPoints = surface.ControlPoints;
+			const std::vector<double>& knotVectorU = surface.KnotVectorU;
+			const std::vector<double>& knotVectorV = surface.KnotVectorV;
+			const std::vector<std::vector<T>>& controlPoints = surface.ControlPoints;
 
 			VALIDATE_ARGUMENT_RANGE(uv.GetU(), knotVectorU[0], knotVectorU[knotVectorU.size() - 1]);
 			VALIDATE_ARGUMENT_RANGE(uv.GetV(), knotVectorV[0], knotVectorV[knotVectorV.size() - 1]);			
 
+			double stackNu[Constants::MaxStackBasisSize];
+			double stackNv[Constants::MaxStackBasisSize];
+			std::vector<double> heapNu;
+			std::vector<double> heapNv;
+			double* Nu = stackNu;
+			double* Nv = stackNv;
+			if (degreeU >= Constants::MaxStackBasisSize)
+			{
+				heapNu.resize(degreeU + 1);
+				Nu = heapNu.data();
+			}
+			if (degreeV >= Constants::MaxStackBasisSize)
+			{
+				heapNv.resize(degreeV + 1);
+				Nv = heapNv.data();
+			}
+
 			int uSpanIndex = Polynomials::GetKnotSpanIndex(degreeU, knotVectorU, uv.GetU());
-			std::vector<double> Nu = Polynomials::BasisFunctions(uSpanIndex, degreeU, knotVectorU, uv.GetU());
+			Polynomials::BasisFunctions(uSpanIndex, degreeU, knotVectorU, uv.GetU(), Nu);
 
 			int vSpanIndex = Polynomials::GetKnotSpanIndex(degreeV, knotVectorV, uv.GetV());
-			std::vector<double> Nv = Polynomials::BasisFunctions(vSpanIndex, degreeV, knotVectorV, uv.GetV());
+			Polynomials::BasisFunctions(vSpanIndex, degreeV, knotVectorV, uv.GetV(), Nv);
 
 			int uind = uSpanIndex - degreeU;
 			T point;
@@ -91,12 +120,23 @@ namespace LNLib
 		/// </summary>
 		template <typename T>
 		static std::vector<std::vector<T>> ComputeDerivatives(const LN_BsplineSurface<T>& surface, int derivative, UV uv)
+		{
+			return ComputeDerivatives(LN_BsplineSurfaceView<T>(surface), derivative, uv);
+		}
+
+		/// <summary>
+		/// The NURBS Book 2nd Edition Page111
+		/// Algorithm A3.6
+		/// Compute surface derivatives without copying surface data.
+		/// </summary>
+		template <typename T>
+		static std::vector<std::vector<T>> ComputeDerivatives(const LN_BsplineSurfaceView<T>& surface, int derivative, UV uv)
 		{
 			int degreeU = surface.DegreeU;
 			int degreeV = surface.DegreeV;
-			std::vector<double> knotVectorU = surface.KnotVectorU;
-			std::vector<double> knotVectorV = surface.KnotVectorV;
-			std::vector<std::vector<T>> controlPoints = surface.ControlPoints;
+			const std::vector<double>& knotVectorU = surface.KnotVectorU;
+			const std::vector<double>& knotVectorV = surface.KnotVectorV;
+			const std::vector<std::vector<T>>& controlPoints = surface.ControlPoints;
 
 			VALIDATE_ARGUMENT(derivative > 0, "derivative", "derivative must greater than zero.");	
 			VALIDATE_ARGUMENT_RANGE(uv.GetU(), knotVectorU[0], knotVectorU[knotVectorU.size() - 1]);
@@ -147,9 +187,9 @@ namespace LNLib
 		{
 			int degreeU = surface.DegreeU;
 			int degreeV = surface.DegreeV;
-			std::vector<double> knotVectorU = surface.KnotVectorU;
-			std::vector<double> knotVectorV = surface.KnotVectorV;
-			std::vector<std::vector<T>> controlPoints = surface.ControlPoints;
+			const std::vector<double>& knotVectorU = surface.KnotVectorU;
+			const std::vector<double>& knotVectorV = surface.KnotVectorV;
+			const std::vector<std::vector<T>>& controlPoints = surface.ControlPoints;
 
 			VALIDATE_ARGUMENT(derivative > 0, "derivative", "derivative must greater than zero.");
 			VALIDATE_ARGUMENT_RANGE(minSpanIndexU, 0, maxSpanIndexU);
@@ -223,9 +263,8 @@ namespace LNLib
 		{
 			int degreeU = surface.DegreeU;
 			int degreeV = surface.DegreeV;
-			std::vector<double> knotVectorU = surface.KnotVectorU;
-			std::vector<double> knotVectorV = surface.KnotVectorV;
-			std::vector<std::vector<T>> controlPoints = surface.ControlPoints;
+			const std::vector<double>& knotVectorU = surface.KnotVectorU;
+			const std::vector<double>& knotVectorV = surface.KnotVectorV;
 
 			VALIDATE_ARGUMENT(derivative > 0, "derivative", "derivative must greater than zero.");
 			VALIDATE_ARGUMENT_RANGE(uv.GetU(), knotVectorU[0], knotVectorU[knotVectorU.size() - 1]);
@@ -238,14 +277,7 @@ namespace LNLib
 			std::vector<std::vector<double>> Nu = Polynomials::AllBasisFunctions(uSpanIndex, degreeU, knotVectorU, uv.GetU());
 			std::vector<std::vector<double>> Nv = Polynomials::AllBasisFunctions(vSpanIndex, degreeV, knotVectorV, uv.GetV());
 
-			LN_BsplineSurface<T> bsplineSurface;
-			bsplineSurface.DegreeU = degreeU;
-			bsplineSurface.DegreeV = degreeV;
-			bsplineSurface.KnotVectorU = knotVectorU;
-			bsplineSurface.KnotVectorV = knotVectorV;
-			bsplineSurface.ControlPoints = controlPoints;
-
-			std::vector<std::vector<std::vector<std::vector<T>>>> PKL = ComputeControlPointsOfDerivatives(bsplineSurface, derivative, uSpanIndex - degreeU, uSpanIndex, vSpanIndex - degreeV, vSpanIndex, uv);
+			std::vector<std::vector<std::vector<std::vector<T>>>> PKL = ComputeControlPointsOfDerivatives(surface, derivative, uSpanIndex - degreeU, uSpanIndex, vSpanIndex - degreeV, vSpanIndex, uv);
 
 			int du = std::min(derivative, degreeU);
 			int dv = std::min(derivative, degreeV);
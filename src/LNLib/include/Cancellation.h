@@ -0,0 +1,68 @@
+/*
+ * Author:
+ * 2024/10/14 - Yuqing Liang (BIMCoder Liang)
+ * bim.frankliang@foxmail.com
+ * 微信公众号：BIMCoder梁老师
+ *
+ * Use of this source code is governed by a GPL-3.0 license that can be found in
+ * the LICENSE file.
+ */
+
+#pragma once
+#include "LNLibDefinitions.h"
+#include <atomic>
+#include <stdexcept>
+
+namespace LNLib
+{
+	/// <summary>
+	/// Thrown out of a long running construction whose CancellationToken was cancelled or ran out of time.
+	/// Output arguments are left in an unspecified but valid state.
+	/// </summary>
+	class LNLIB_EXPORT OperationCancelledException : public std::runtime_error
+	{
+	public:
+		OperationCancelledException();
+	};
+
+	/// <summary>
+	/// Cooperative cancellation of long running constructions, checked inside their iterative loops and parallel tasks.
+	/// The requester keeps the token and may cancel it, or give it a time budget, from any thread while the construction runs.
+	/// The token must outlive every construction using it.
+	/// </summary>
+	class LNLIB_EXPORT CancellationToken
+	{
+	public:
+
+		CancellationToken();
+
+		CancellationToken(const CancellationToken&) = delete;
+		CancellationToken& operator=(const CancellationToken&) = delete;
+
+		/// <summary>
+		/// Requests cancellation, constructions stop at their next check.
+		/// </summary>
+		void Cancel();
+
+		/// <summary>
+		/// Cancels automatically once milliseconds elapsed from now, replacing an earlier budget.
+		/// Budgets not greater than zero expire at once.
+		/// </summary>
+		void SetTimeBudget(long long milliseconds);
+
+		/// <summary>
+		/// True after Cancel or once the time budget elapsed.
+		/// </summary>
+		bool IsCancelled() const;
+
+		/// <summary>
+		/// Throws OperationCancelledException when token is cancelled, a null token never is.
+		/// </summary>
+		static void ThrowIfCancelled(const CancellationToken* token);
+
+	private:
+
+		std::atomic<bool> _isCancelled;
+		std::atomic<long long> _deadline;
+	};
+}
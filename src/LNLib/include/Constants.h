@@ -25,6 +25,21 @@ namespace LNLib
 		static const double MaxDistance;
 		static const double Pi;
 
+		/// <summary>
+		/// Basis functions of degree below this bound are evaluated in stack buffers.
+		/// </summary>
+		static const int MaxStackBasisSize = 32;
+
+		/// <summary>
+		/// Parameters evaluated together by batch kernels, one SIMD register of doubles.
+		/// </summary>
+		static const int BatchLaneCount = 4;
+
+		/// <summary>
+		/// Bezier segments up to this degree may be evaluated in power basis, the monomial form is ill conditioned beyond it.
+		/// </summary>
+		static const int MaxPowerBasisDegree = 10;
+
 	};
 }
 
@@ -11,6 +11,7 @@
 #pragma once
 
 #include "LNLibDefinitions.h"
+#include "LNObject.h"
 #include <vector>
 #include <unordered_map>
 
@@ -27,9 +28,65 @@ namespace LNLib
 
 		static std::vector<std::vector<XYZW>> ToXYZW(const std::vector<std::vector<XYZ>>& points);
 
+		/// <summary>
+		/// Axis aligned bounding box of points.
+		/// </summary>
+		static LN_BoundingBox ComputeBoundingBox(const std::vector<XYZ>& points);
+
+		/// <summary>
+		/// Axis aligned bounding box of the projected control points.
+		/// By the convex hull property it contains the curve when all weights are positive.
+		/// </summary>
+		static LN_BoundingBox ComputeBoundingBox(const std::vector<XYZW>& weightedControlPoints);
+
+		/// <summary>
+		/// Axis aligned bounding box of the projected control net.
+		/// By the convex hull property it contains the surface when all weights are positive.
+		/// </summary>
+		static LN_BoundingBox ComputeBoundingBox(const std::vector<std::vector<XYZW>>& weightedControlPoints);
+
+		/// <summary>
+		/// Split weighted control points into coordinate arrays.
+		/// </summary>
+		static void ToArrays(const std::vector<XYZW>& points, LN_ControlPointArrays& arrays);
+
+		/// <summary>
+		/// Split weighted control net into row-major coordinate arrays, point (i, j) at i * columns + j.
+		/// </summary>
+		static void ToArrays(const std::vector<std::vector<XYZW>>& points, LN_ControlPointArrays& arrays);
+
+		/// <summary>
+		/// The NURBS Book 2nd Edition Page173
+		/// Algorithm A5.6 on lanes control polygons sharing degree and clamped knotVector.
+		/// Knots whose multiplicity reaches the degree, which is every interior knot of degree 1, need no insertion and only start the next segment.
+		/// Point i of lane l is controlPoints[i * lanes + l], point k of segment s of lane l is written to beziers[(s * (degree + 1) + k) * lanes + l].
+		/// beziers must hold KnotVectorUtils::GetBezierCount segments, domains (may be null) receives the start and end knot of every segment.
+		/// Returns the number of segments.
+		/// </summary>
+		static int DecomposeToBeziers(int degree, const std::vector<double>& knotVector, const XYZW* controlPoints, int lanes, XYZW* beziers, double* domains);
+
+		/// <summary>
+		/// Flattens the net through Multiply of row-major points.
+		/// </summary>
 		static std::vector<std::vector<XYZW>> Multiply(const std::vector<std::vector<XYZW>>& points, const std::vector<std::vector<double>>& coefficient);
 
+		/// <summary>
+		/// Flattens the net through Multiply of row-major points.
+		/// </summary>
 		static std::vector<std::vector<XYZW>> Multiply(const std::vector<std::vector<double>>& coefficient, const std::vector<std::vector<XYZW>>& points);
+
+		/// <summary>
+		/// result = coefficient * points, points is a row-major net of coefficient.ColumnCount rows and columnCount columns,
+		/// result has coefficient.RowCount rows.
+		/// A row of points is one contiguous row of doubles, so the product runs through the blocked MathUtils::MatrixMultiply.
+		/// </summary>
+		static void Multiply(const LN_Matrix& coefficient, const std::vector<XYZW>& points, int columnCount, std::vector<XYZW>& result);
+
+		/// <summary>
+		/// result = points * coefficient, points is a row-major net of coefficient.RowCount columns,
+		/// result has the same rows and coefficient.ColumnCount columns. Blocked like MathUtils::MatrixMultiply, a point is two SSE2 lanes.
+		/// </summary>
+		static void Multiply(const std::vector<XYZW>& points, const LN_Matrix& coefficient, std::vector<XYZW>& result);
 	};
 
 }
@@ -0,0 +1,93 @@
+/*
+ * Author:
+ * 2024/10/14 - Yuqing Liang (BIMCoder Liang)
+ * bim.frankliang@foxmail.com
+ * 微信公众号：BIMCoder梁老师
+ *
+ * Use of this source code is governed by a GPL-3.0 license that can be found in
+ * the LICENSE file.
+ */
+
+#pragma once
+#include "LNLibDefinitions.h"
+#include "LNObject.h"
+#include "LNEnums.h"
+#include "BoundingVolumeHierarchy.h"
+#include "Parallel.h"
+#include "XYZ.h"
+#include <vector>
+
+namespace LNLib
+{
+	/// <summary>
+	/// Point inversion accelerator built once per curve.
+	/// The curve is tessellated adaptively and the polyline segments are stored in a bounding volume hierarchy,
+	/// each query takes its seed from the nearest segment and refines it with Newton iteration.
+	/// Lines and arcs are classified once, their foot points are computed exactly and only inverted on the curve.
+	/// Queries do not modify the projector and can run concurrently.
+	/// </summary>
+	class LNLIB_EXPORT CurveProjector
+	{
+	public:
+
+		CurveProjector(const LN_NurbsCurve& curve);
+
+		/// <summary>
+		/// The NURBS Book 2nd Edition Page230
+		/// Point inversion: finding the corresponding parameter make C(u) = P.
+		/// </summary>
+		double GetParamOnCurve(const XYZ& givenPoint) const;
+
+		/// <summary>
+		/// Point inversion with the given tolerances and iteration cap, seeded from the nearest polyline segment.
+		/// </summary>
+		double GetParamOnCurve(const XYZ& givenPoint, const LN_ProjectionOptions& options) const;
+
+		/// <summary>
+		/// Point inversion of a point near the previous query, as when tracking a moving point.
+		/// Newton iteration starts at previousParam, its result is kept when no polyline segment within options.LocalSearchRange
+		/// segments around previousParam is closer, otherwise iteration restarts from that segment.
+		/// When the nearest of those segments lies on the border of the window the query falls back to the global search,
+		/// which lines and arcs always take as their foot point is exact.
+		/// </summary>
+		double GetParamOnCurve(const XYZ& givenPoint, double previousParam, const LN_ProjectionOptions& options = LN_ProjectionOptions()) const;
+
+		/// <summary>
+		/// Point inversion of every given point, blocks of points are projected in parallel.
+		/// </summary>
+		std::vector<double> GetParamsOnCurve(const std::vector<XYZ>& givenPoints, ParallelExecutor* executor = nullptr) const;
+
+		/// <summary>
+		/// Non-throwing point inversion, NotConverged still writes the best parameter reached.
+		/// </summary>
+		EvaluationStatus TryGetParamOnCurve(const XYZ& givenPoint, double& paramT, const LN_ProjectionOptions& options = LN_ProjectionOptions()) const noexcept;
+
+		/// <summary>
+		/// Non-throwing warm started point inversion, previousParam outside the domain fails or is clamped by policy.
+		/// </summary>
+		EvaluationStatus TryGetParamOnCurve(const XYZ& givenPoint, double previousParam, double& paramT, const LN_ProjectionOptions& options = LN_ProjectionOptions(), ParameterRangePolicy policy = ParameterRangePolicy::Fail) const noexcept;
+
+	private:
+
+		double Project(const XYZ& givenPoint, const LN_ProjectionOptions& options, bool& isConverged) const;
+		double Project(const XYZ& givenPoint, double previousParam, const LN_ProjectionOptions& options, bool& isConverged) const;
+		double GetSeed(int segmentIndex, const XYZ& givenPoint) const;
+		double Refine(const XYZ& givenPoint, double paramT, const LN_ProjectionOptions& options, bool& isConverged) const;
+		bool GetExactFootPoint(const XYZ& givenPoint, XYZ& footPoint) const;
+
+		LN_NurbsCurve _curve;
+		bool _isClosed;
+		bool _isLinear;
+		bool _isArc;
+		XYZ _startPoint;
+		XYZ _endPoint;
+		XYZ _arcCenter;
+		XYZ _arcNormal;
+		double _arcRadius;
+		double _arcSweepAngle;
+		double _chordTolerance;
+		std::vector<XYZ> _points;
+		std::vector<double> _knots;
+		BoundingVolumeHierarchy _hierarchy;
+	};
+}
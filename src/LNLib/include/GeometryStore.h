@@ -0,0 +1,89 @@
+/*
+ * Author:
+ * 2024/10/14 - Yuqing Liang (BIMCoder Liang)
+ * bim.frankliang@foxmail.com
+ * 微信公众号：BIMCoder梁老师
+ *
+ * Use of this source code is governed by a GPL-3.0 license that can be found in
+ * the LICENSE file.
+ */
+
+#pragma once
+#include "LNLibDefinitions.h"
+#include "LNObject.h"
+#include <vector>
+#include <string>
+#include <cstddef>
+
+namespace LNLib
+{
+	/// <summary>
+	/// Versioned little-endian binary format of curves and surfaces, opened without parsing or copying.
+	/// Layout: a 32 byte header (magic "LNLB", version, flags, curve count, surface count), a table of fixed size records
+	/// and 8 byte aligned double arrays of knots, weighted control points (wx, wy, wz, w) and optional bounds.
+	/// Views returned by an open store point into its memory, which is either supplied by the caller or a read-only file mapping.
+	/// Zero-copy access needs a little-endian host and 8 byte aligned memory, Open fails otherwise.
+	/// Views are evaluated in place by NurbsCurve::GetPointOnCurve and NurbsSurface::GetPointOnSurface,
+	/// GetCurve and GetSurface copy only for modeling operations.
+	/// </summary>
+	class LNLIB_EXPORT GeometryStore
+	{
+	public:
+
+		static const unsigned int Version = 1;
+
+		/// <summary>
+		/// Serializes curves and surfaces, control point bounding boxes are stored when includeBounds.
+		/// </summary>
+		static void Write(const std::vector<LN_NurbsCurve>& curves, const std::vector<LN_NurbsSurface>& surfaces, bool includeBounds, std::vector<unsigned char>& buffer);
+
+		static bool WriteFile(const std::string& path, const std::vector<LN_NurbsCurve>& curves, const std::vector<LN_NurbsSurface>& surfaces, bool includeBounds);
+
+		GeometryStore();
+		~GeometryStore();
+
+		GeometryStore(const GeometryStore&) = delete;
+		GeometryStore& operator=(const GeometryStore&) = delete;
+
+		/// <summary>
+		/// Opens caller memory holding a serialized store, the memory must outlive the store. Returns false when the data is not a valid store.
+		/// </summary>
+		bool Open(const void* data, size_t size);
+
+		/// <summary>
+		/// Memory maps the file read-only and opens it.
+		/// </summary>
+		bool OpenFile(const std::string& path);
+
+		void Close();
+
+		bool IsOpen() const;
+
+		int GetCurveCount() const;
+
+		int GetSurfaceCount() const;
+
+		LN_StoredNurbsCurve GetCurveView(int index) const;
+
+		LN_StoredNurbsSurface GetSurfaceView(int index) const;
+
+		/// <summary>
+		/// Copies stored curve into an owning curve for modeling.
+		/// </summary>
+		void GetCurve(int index, LN_NurbsCurve& curve) const;
+
+		/// <summary>
+		/// Copies stored surface into an owning surface for modeling.
+		/// </summary>
+		void GetSurface(int index, LN_NurbsSurface& surface) const;
+
+	private:
+
+		const unsigned char* _data;
+		size_t _size;
+		int _curveCount;
+		int _surfaceCount;
+		void* _mapping;
+		void* _file;
+	};
+}
@@ -0,0 +1,59 @@
+/*
+ * Author:
+ * 2024/10/14 - Yuqing Liang (BIMCoder Liang)
+ * bim.frankliang@foxmail.com
+ * 微信公众号：BIMCoder梁老师
+ *
+ * Use of this source code is governed by a GPL-3.0 license that can be found in
+ * the LICENSE file.
+ */
+
+#pragma once
+#include "LNLibDefinitions.h"
+#include "LNObject.h"
+#include <vector>
+
+namespace LNLib
+{
+	/// <summary>
+	/// Export of curves and surfaces for evaluation on the GPU.
+	/// Pack decomposes into Bezier segments or patches, so a shader only needs a binary search in the break tables
+	/// and one Bernstein evaluation per parameter.
+	/// The shader sources are GLSL 4.30 compute shaders with one invocation per parameter, their bindings are listed in the sources.
+	/// EvaluateCurve and EvaluateSurface run the same steps on the CPU in single precision, as reference for ports of the kernels.
+	/// Outputs are vec4 per parameter as in std430 storage buffers, points have w = 1 and normals w = 0.
+	/// </summary>
+	class LNLIB_EXPORT GpuExport
+	{
+	public:
+
+		/// <summary>
+		/// Highest degree supported by the shaders, their basis arrays are sized by it.
+		/// </summary>
+		static const int MaxDegree = 15;
+
+		static void Pack(const LN_NurbsCurve& curve, LN_GpuCurveBuffer& buffer);
+
+		static void Pack(const LN_NurbsSurface& surface, LN_GpuSurfaceBuffer& buffer);
+
+		/// <summary>
+		/// Compute shader writing the point of params[i] to points[i].
+		/// </summary>
+		static const char* GetCurveShaderSource();
+
+		/// <summary>
+		/// Compute shader writing point and unit normal of uvs[i] to points[i] and normals[i], normals of degenerate points are zero.
+		/// </summary>
+		static const char* GetSurfaceShaderSource();
+
+		/// <summary>
+		/// CPU reference of the curve shader, params outside the breaks are clamped.
+		/// </summary>
+		static void EvaluateCurve(const LN_GpuCurveBuffer& buffer, const std::vector<float>& params, std::vector<float>& points);
+
+		/// <summary>
+		/// CPU reference of the surface shader, uvs holds two floats per parameter, parameters outside the breaks are clamped.
+		/// </summary>
+		static void EvaluateSurface(const LN_GpuSurfaceBuffer& buffer, const std::vector<float>& uvs, std::vector<float>& points, std::vector<float>& normals);
+	};
+}
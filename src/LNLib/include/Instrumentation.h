@@ -0,0 +1,114 @@
+/*
+ * Author:
+ * 2024/10/14 - Yuqing Liang (BIMCoder Liang)
+ * bim.frankliang@foxmail.com
+ * 微信公众号：BIMCoder梁老师
+ *
+ * Use of this source code is governed by a GPL-3.0 license that can be found in
+ * the LICENSE file.
+ */
+
+#pragma once
+#include "LNLibDefinitions.h"
+#include "LNEnums.h"
+#include <string>
+
+namespace LNLib
+{
+	/// <summary>
+	/// One finished scope, Counters are indexed by InstrumentationCounter and include nested scopes of the same thread.
+	/// Times are microseconds from the first instrumented scope of the process.
+	/// </summary>
+	struct LNLIB_EXPORT LN_InstrumentationRecord
+	{
+		static const int CounterCount = 5;
+
+		const char* Name;
+		int ThreadId;
+		int Depth;
+		long long StartTime;
+		long long Duration;
+		long long Counters[CounterCount];
+	};
+
+	/// <summary>
+	/// User supplied receiver of finished scopes, called on the thread that ran the scope.
+	/// Scopes of different threads may report concurrently.
+	/// </summary>
+	class LNLIB_EXPORT InstrumentationCallback
+	{
+	public:
+		virtual void operator()(const LN_InstrumentationRecord& record) = 0;
+	};
+
+	/// <summary>
+	/// Scoped timers and counters of the top level NurbsCurve, NurbsSurface and Integrator entry points.
+	/// The library only records when built with LNLIB_INSTRUMENTATION (CMake option ENABLE_INSTRUMENTATION),
+	/// otherwise LNLIB_SCOPED_TIMER and LNLIB_COUNT expand to nothing and this class only sees user scopes.
+	/// Nothing is recorded while neither a callback is registered nor a Chrome trace is active.
+	/// </summary>
+	class LNLIB_EXPORT Instrumentation
+	{
+	public:
+
+		/// <summary>
+		/// Registers the receiver of finished scopes, null unregisters. The callback must outlive its registration.
+		/// </summary>
+		static void SetCallback(InstrumentationCallback* callback);
+
+		/// <summary>
+		/// Starts collecting finished scopes for a Chrome trace, previous events are dropped.
+		/// </summary>
+		static void BeginChromeTrace();
+
+		/// <summary>
+		/// Stops collecting and returns the events since BeginChromeTrace in the Chrome trace event JSON format,
+		/// loadable by chrome://tracing or Perfetto.
+		/// </summary>
+		static std::string EndChromeTrace();
+
+		/// <summary>
+		/// True while a callback is registered or a Chrome trace is active.
+		/// </summary>
+		static bool IsEnabled();
+
+		/// <summary>
+		/// Adds amount to counter of the innermost active scope of the calling thread, ignored outside scopes.
+		/// </summary>
+		static void Count(InstrumentationCounter counter, long long amount = 1);
+	};
+
+	/// <summary>
+	/// Times the enclosing block and collects its counters, name must outlive the reports (a string literal).
+	/// Inactive when instrumentation is not enabled at construction.
+	/// </summary>
+	class LNLIB_EXPORT ScopedTimer
+	{
+	public:
+
+		explicit ScopedTimer(const char* name);
+		~ScopedTimer();
+
+		ScopedTimer(const ScopedTimer&) = delete;
+		ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+	private:
+
+		bool _isActive;
+		LN_InstrumentationRecord _record;
+		ScopedTimer* _parent;
+
+		friend class Instrumentation;
+	};
+}
+
+#define LNLIB_INSTRUMENTATION_CONCAT_INNER(left, right) left##right
+#define LNLIB_INSTRUMENTATION_CONCAT(left, right) LNLIB_INSTRUMENTATION_CONCAT_INNER(left, right)
+
+#ifdef LNLIB_INSTRUMENTATION
+#define LNLIB_SCOPED_TIMER(name) LNLib::ScopedTimer LNLIB_INSTRUMENTATION_CONCAT(lnlibScopedTimer, __LINE__)(name)
+#define LNLIB_COUNT(counter, amount) LNLib::Instrumentation::Count(LNLib::InstrumentationCounter::counter, amount)
+#else
+#define LNLIB_SCOPED_TIMER(name)
+#define LNLIB_COUNT(counter, amount)
+#endif
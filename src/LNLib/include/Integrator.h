@@ -26,7 +26,7 @@ namespace LNLib
 
 	public:
 		static double Simpson(IntegrationFunction& function, void* customData, double start, double end);
-		static double Simpson(double start, double end, std::vector<double> odds, std::vector<double> evens, double delta);
+		static double Simpson(double start, double end, const std::vector<double>& odds, const std::vector<double>& evens, double delta);
 
 		/// <summary>
 		/// According to https://github.com/Pomax/bezierjs
@@ -39,8 +39,36 @@ namespace LNLib
 		/// According to https://github.com/chrisidefix/nurbs
 		/// </summary>
 		static std::vector<double> ChebyshevSeries(int size = 100);
+
+		/// <summary>
+		/// Gauss-Legendre abscissae and weights of given order on [-1, 1],
+		/// roots of Legendre polynomial are found by Newton iteration.
+		/// </summary>
+		static void GaussLegendreRule(int order, std::vector<double>& abscissae, std::vector<double>& weights);
+
+		/// <summary>
+		/// 15 point Gauss-Kronrod abscissae on [-1, 1] with their Kronrod weights,
+		/// GaussKronrodGaussWeights are the weights of the embedded 7 point Gauss rule and zero at the Kronrod only nodes.
+		/// </summary>
+		static const std::vector<double> GaussKronrodAbscissae;
+		static const std::vector<double> GaussKronrodWeights;
+		static const std::vector<double> GaussKronrodGaussWeights;
+
+		/// <summary>
+		/// Adaptive Gauss-Kronrod (G7/K15) quadrature over the intervals between consecutive breakpoints.
+		/// |K15 - G7| estimates the error of every interval, the interval of largest estimate is bisected
+		/// until the summed estimate falls below tolerance or one more bisection would exceed maxEvaluations integrand evaluations.
+		/// The initial intervals are always evaluated. error receives the summed estimate and evaluations the evaluations spent.
+		/// </summary>
+		static double GaussKronrod(IntegrationFunction& function, void* customData, const std::vector<double>& breakpoints, double tolerance, int maxEvaluations, double& error, int& evaluations);
+		static double GaussKronrod(IntegrationFunction& function, void* customData, double start, double end, double tolerance = Constants::DistanceEpsilon, int maxEvaluations = 1500);
+
+		/// <summary>
+		/// The leading entries of series are overwritten as workspace, so one series must not be shared between threads.
+		/// ClenshawCurtisQuadrature2 only reads series.
+		/// </summary>
 		static double ClenshawCurtisQuadrature(IntegrationFunction& function, void* customData, double start, double end, std::vector<double>& series, double epsilon = Constants::DistanceEpsilon);
-		static double ClenshawCurtisQuadrature2(IntegrationFunction& function, void* customData, double start, double end, std::vector<double> series, double epsilon = Constants::DistanceEpsilon);
+		static double ClenshawCurtisQuadrature2(IntegrationFunction& function, void* customData, double start, double end, const std::vector<double>& series, double epsilon = Constants::DistanceEpsilon);
 	};
 }
 
@@ -79,5 +79,25 @@ namespace LNLib
 		/// Computes a knot vector ensuring that every knot span has at least one.
 		/// </summary>
 		static std::vector<double> ComputeKnotVector(int degree, int pointsCount, int controlPointsCount, const std::vector<double> params);	
+
+		/// <summary>
+		/// The NURBS Book 2nd Edition Page369
+		/// Collocation matrix N(i,p)(params[k]) in banded storage of MathUtils::CreateBandedMatrix.
+		/// </summary>
+		static std::vector<std::vector<double>> CreateCollocationMatrix(int degree, const std::vector<double>& knotVector, const std::vector<double>& params, int& lowerBandwidth, int& upperBandwidth);
+
+		/// <summary>
+		/// The NURBS Book 2nd Edition Page411
+		/// Normal matrix N^T * N of least squares approximation with both end points interpolated,
+		/// for the controlPointsCount - 2 inner control points in MathUtils symmetric banded storage of bandwidth degree.
+		/// spanIndices and basis keep the degree + 1 nonzeros of every row of N.
+		/// </summary>
+		static std::vector<std::vector<double>> CreateLeastSquaresNormalMatrix(int degree, const std::vector<double>& knotVector, const std::vector<double>& params, int controlPointsCount, std::vector<int>& spanIndices, std::vector<std::vector<double>>& basis);
+
+		/// <summary>
+		/// The NURBS Book 2nd Edition Page411
+		/// Right hand side N^T * R of the inner control points for throughPoints, N given by CreateLeastSquaresNormalMatrix.
+		/// </summary>
+		static std::vector<XYZ> GetLeastSquaresRight(int degree, int controlPointsCount, const std::vector<int>& spanIndices, const std::vector<std::vector<double>>& basis, const std::vector<XYZ>& throughPoints);
 	};
 }
\ No newline at end of file
@@ -12,10 +12,14 @@
 
 #include "LNEnums.h"
 #include "LNLibDefinitions.h"
+#include "LNObject.h"
+#include <vector>
 
 namespace LNLib
 {
 	class XYZ;
+	class PreparedCurve;
+	class PreparedSurface;
 	class LNLIB_EXPORT Intersection
 	{
 
@@ -24,6 +28,52 @@ namespace LNLib
 
 		static LinePlaneIntersectionType ComputeLineAndPlane(const XYZ& normal, const XYZ& pointOnPlane, const XYZ& pointOnLine, const XYZ& lineDirection, XYZ& intersectPoint);
 
+		/// <summary>
+		/// Find all intersections of two NURBS curves.
+		/// Both curves are decomposed to Bezier segments, a hierarchy over the control point boxes of curve1 culls disjoint segment pairs,
+		/// the rest are subdivided until flat and every candidate is refined by Newton iteration.
+		/// Candidates joined by a stretch where the curves stay within tolerance are reported once, a tangent contact at its closest point
+		/// and a coincident stretch as one IsOverlap interval, sorted by Param0.
+		/// </summary>
+		static std::vector<LN_CurveCurveIntersection> ComputeCurveCurve(const LN_NurbsCurve& curve0, const LN_NurbsCurve& curve1, double tolerance);
+
+		/// <summary>
+		/// Find all transversal intersections of a NURBS curve and a NURBS surface.
+		/// The curve is decomposed to Bezier segments and the surface to Bezier patches, a hierarchy over the patch boxes culls disjoint pairs,
+		/// the rest are subdivided until flat and every candidate is refined by Newton iteration on C(t) - S(u,v) = 0.
+		/// Results closer than tolerance are reported once, sorted by CurveParam.
+		/// </summary>
+		static std::vector<LN_CurveSurfaceIntersection> ComputeCurveSurface(const LN_NurbsCurve& curve, const LN_NurbsSurface& surface, double tolerance);
+
+		/// <summary>
+		/// Find all hits of the ray origin + t * direction, t >= 0, on a NURBS surface.
+		/// Bezier patches whose control point box the ray misses are culled, the rest are subdivided until flat,
+		/// every candidate is seeded by ComputeLineAndPlane on the plane of the patch corners and refined by Newton iteration on S(u,v) - R(t) = 0.
+		/// Results closer than tolerance are reported once, sorted by RayParam.
+		/// </summary>
+		static std::vector<LN_RaySurfaceIntersection> ComputeRaySurface(const XYZ& origin, const XYZ& direction, const LN_NurbsSurface& surface, double tolerance);
+
+		/// <summary>
+		/// First hit of the ray on a prepared surface with RayParam in [0, maxParam).
+		/// Uses the cached Bezier patches and their boxes, patches are visited front to back and those entered after the best hit are culled.
+		/// </summary>
+		static bool ComputeRaySurface(const XYZ& origin, const XYZ& direction, const PreparedSurface& surface, double tolerance, double maxParam, LN_RaySurfaceIntersection& nearest);
+
+		/// <summary>
+		/// The point of a prepared curve passing within tolerance of the ray with least RayParam in [0, maxParam).
+		/// Bezier segments whose box enlarged by tolerance the ray misses are culled, the rest are subdivided until flat,
+		/// the closest points of chord and ray seed Newton iteration on the distance between curve and ray line.
+		/// </summary>
+		static bool ComputeRayCurve(const XYZ& origin, const XYZ& direction, const PreparedCurve& curve, double tolerance, double maxParam, LN_RayCurveIntersection& nearest);
+
+		/// <summary>
+		/// Trace the intersection curves of two NURBS surfaces.
+		/// Seeds come from subdividing Bezier patch pairs found by a bounding volume hierarchy over the patches of surface1,
+		/// every seed not lying on an already traced branch is marched in both directions along N0 x N1 with a step adapted to the turning angle,
+		/// until a surface boundary is reached or the branch closes. Each branch is fitted by global interpolation.
+		/// </summary>
+		static std::vector<LN_SurfaceSurfaceIntersection> ComputeSurfaceSurface(const LN_NurbsSurface& surface0, const LN_NurbsSurface& surface1, double tolerance);
+
 	};
 }
 
@@ -0,0 +1,69 @@
+/*
+ * Author:
+ * 2024/10/14 - Yuqing Liang (BIMCoder Liang)
+ * bim.frankliang@foxmail.com
+ * 微信公众号：BIMCoder梁老师
+ *
+ * Use of this source code is governed by a GPL-3.0 license that can be found in
+ * the LICENSE file.
+ */
+
+#pragma once
+#include "LNLibDefinitions.h"
+#include "LNObject.h"
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+
+namespace LNLib
+{
+	/// <summary>
+	/// Interning table of knot vectors, equal knot vectors are returned as the same shared buffer.
+	/// The pool only keeps weak references, a buffer is released when the last object using it goes away.
+	/// All methods are thread safe.
+	/// </summary>
+	class LNLIB_EXPORT KnotVectorPool
+	{
+	public:
+
+		/// <summary>
+		/// Returns the shared buffer equal to knotVector, adding it when the pool holds none.
+		/// </summary>
+		LN_SharedKnotVector Intern(const std::vector<double>& knotVector);
+
+		void Share(const LN_NurbsCurve& curve, LN_SharedNurbsCurve& result);
+
+		void Share(const LN_NurbsSurface& surface, LN_SharedNurbsSurface& result);
+
+		std::vector<LN_SharedNurbsCurve> Share(const std::vector<LN_NurbsCurve>& curves);
+
+		std::vector<LN_SharedNurbsSurface> Share(const std::vector<LN_NurbsSurface>& surfaces);
+
+		/// <summary>
+		/// Number of buffers still in use.
+		/// </summary>
+		int GetCount() const;
+
+		/// <summary>
+		/// Drops the entries of released buffers.
+		/// </summary>
+		void Purge();
+
+		/// <summary>
+		/// Copies shared curve into an owning curve for modeling.
+		/// </summary>
+		static void ToCurve(const LN_SharedNurbsCurve& curve, LN_NurbsCurve& result);
+
+		/// <summary>
+		/// Copies shared surface into an owning surface for modeling.
+		/// </summary>
+		static void ToSurface(const LN_SharedNurbsSurface& surface, LN_NurbsSurface& result);
+
+	private:
+
+		typedef std::weak_ptr<const std::vector<double>> WeakKnotVector;
+
+		mutable std::mutex _mutex;
+		std::unordered_map<size_t, std::vector<WeakKnotVector>> _entries;
+	};
+}
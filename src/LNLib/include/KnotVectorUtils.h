@@ -68,6 +68,17 @@ namespace LNLib
 		/// </summary>
 		static std::vector<std::vector<double>> GetInsertedKnotElements(const std::vector<std::vector<double>>& knotVectors);
 
+		/// <summary>
+		/// Number of Bezier segments of a clamped knot vector, one per distinct knot span.
+		/// </summary>
+		static int GetBezierCount(int degree, const std::vector<double>& knotVector);
+
+		/// <summary>
+		/// Get insert elements raising every parameter inside the knot vector domain to multiplicity degree + 1 for splitting.
+		/// splitParameters receives these parameters sorted and without duplicates.
+		/// </summary>
+		static std::vector<double> GetSplitKnotElements(int degree, const std::vector<double>& knotVector, const std::vector<double>& parameters, std::vector<double>& splitParameters);
+
 		/// <summary>
 		/// The NURBS Book 2nd Edition Page572
 		/// </summary>
@@ -55,6 +55,51 @@ namespace LNLib
 		Simpson = 0,
 		GaussLegendre = 1,
 		Chebyshev = 2,
+		GaussKronrod = 3,
+	};
+
+	/// <summary>
+	/// Result of the non-throwing Try variants. Failed reports an exception raised inside a projection.
+	/// </summary>
+	enum class EvaluationStatus : int
+	{
+		Success = 0,
+		InvalidArgument = 1,
+		OutOfRange = 2,
+		NotConverged = 3,
+		Failed = 4,
+	};
+
+	/// <summary>
+	/// How the Try variants treat parameters outside the domain: fail with OutOfRange, or clamp to the nearest end.
+	/// </summary>
+	enum class ParameterRangePolicy : int
+	{
+		Fail = 0,
+		Clamp = 1,
+	};
+
+	/// <summary>
+	/// Position of a parameter region relative to the trim loops, Boundary regions are crossed by a loop.
+	/// </summary>
+	enum class TrimRegion : int
+	{
+		Outside = 0,
+		Inside = 1,
+		Boundary = 2,
+	};
+
+	/// <summary>
+	/// Evaluations counts points or derivative sets of curves and surfaces, LinearSolves counts matrix factorizations,
+	/// Allocations counts MonotonicArena blocks.
+	/// </summary>
+	enum class InstrumentationCounter : int
+	{
+		Evaluations = 0,
+		SpanSearches = 1,
+		LinearSolves = 2,
+		Allocations = 3,
+		NewtonIterations = 4,
 	};
 
 }
@@ -0,0 +1,151 @@
+/*
+ * Author:
+ * 2024/10/14 - Yuqing Liang (BIMCoder Liang)
+ * bim.frankliang@foxmail.com
+ * 微信公众号：BIMCoder梁老师
+ *
+ * Use of this source code is governed by a GPL-3.0 license that can be found in
+ * the LICENSE file.
+ */
+
+#pragma once
+#include "LNLibDefinitions.h"
+
+/// <summary>
+/// Flat C interface for language bindings (C#, Python ctypes or cffi), which only exchanges plain pointers.
+/// Inputs are read in place through pointer + stride, so interleaved or struct of arrays layouts need no repacking.
+/// Outputs are written into caller owned buffers with their own strides, such as NumPy or pinned managed arrays.
+/// Strides count doubles (or ints) between consecutive elements.
+/// Prepared geometry lives behind opaque handles, so its caches persist across calls. A handle is immutable once created
+/// and can be queried from several threads, every handle must be released by its destroy function.
+/// Functions never throw, failures return a status and LNLib_GetLastErrorMessage describes the last failure of the calling thread.
+/// </summary>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+	typedef enum LNLib_Status
+	{
+		LNLIB_STATUS_OK = 0,
+		LNLIB_STATUS_INVALID_ARGUMENT = 1,
+		/// <summary>
+		/// A caller buffer was smaller than the result, the required counts are still written.
+		/// </summary>
+		LNLIB_STATUS_BUFFER_TOO_SMALL = 2,
+		LNLIB_STATUS_ERROR = 3
+	} LNLib_Status;
+
+	/// <summary>
+	/// NURBS curve read in place. Knots has ControlPointCount + Degree + 1 values,
+	/// control point i is (x, y, z) at ControlPoints + i * ControlPointStride with weight Weights[i * WeightStride].
+	/// Weights may be null for a non rational curve. Cartesian points and weights of an xyzw array are
+	/// ControlPoints = data, Weights = data + 3 and both strides 4.
+	/// </summary>
+	typedef struct LNLib_CurveDesc
+	{
+		int Degree;
+		int ControlPointCount;
+		const double* Knots;
+		const double* ControlPoints;
+		int ControlPointStride;
+		const double* Weights;
+		int WeightStride;
+	} LNLib_CurveDesc;
+
+	/// <summary>
+	/// NURBS surface read in place, control point (i, j) with i along u is at ControlPoints + i * RowStride + j * ColumnStride,
+	/// its weight at Weights + i * WeightRowStride + j * WeightColumnStride. Weights may be null for a non rational surface.
+	/// </summary>
+	typedef struct LNLib_SurfaceDesc
+	{
+		int DegreeU;
+		int DegreeV;
+		int ControlPointCountU;
+		int ControlPointCountV;
+		const double* KnotsU;
+		const double* KnotsV;
+		const double* ControlPoints;
+		int RowStride;
+		int ColumnStride;
+		const double* Weights;
+		int WeightRowStride;
+		int WeightColumnStride;
+	} LNLib_SurfaceDesc;
+
+	/// <summary>
+	/// Caller buffers of a triangle mesh. Vertex k is written to Vertices + k * VertexStride,
+	/// Normals and UVs likewise and both may be null. Indices receives three vertex indices per triangle.
+	/// VertexCount and IndexCount are written by the call, LNLIB_STATUS_BUFFER_TOO_SMALL leaves the buffers unwritten,
+	/// so a buffer can be sized by a first call with zero capacities.
+	/// </summary>
+	typedef struct LNLib_MeshBuffers
+	{
+		double* Vertices;
+		int VertexStride;
+		double* Normals;
+		int NormalStride;
+		double* UVs;
+		int UVStride;
+		int VertexCapacity;
+		int* Indices;
+		int IndexCapacity;
+		int VertexCount;
+		int IndexCount;
+	} LNLib_MeshBuffers;
+
+	typedef struct LNLib_PreparedCurve LNLib_PreparedCurve;
+	typedef struct LNLib_PreparedSurface LNLib_PreparedSurface;
+
+	/// <summary>
+	/// Message of the last failed call on this thread, empty when none failed. Valid until the next failed call on this thread.
+	/// </summary>
+	LNLIB_EXPORT const char* LNLib_GetLastErrorMessage(void);
+
+	/// <summary>
+	/// Copies and validates desc into a new handle written to curve, curve is null on failure.
+	/// </summary>
+	LNLIB_EXPORT LNLib_Status LNLib_CreatePreparedCurve(const LNLib_CurveDesc* desc, LNLib_PreparedCurve** curve);
+
+	LNLIB_EXPORT void LNLib_DestroyPreparedCurve(LNLib_PreparedCurve* curve);
+
+	/// <summary>
+	/// C(params[i * paramStride]) to points + i * pointStride for i in [0, count).
+	/// </summary>
+	LNLIB_EXPORT LNLib_Status LNLib_GetPointsOnCurve(const LNLib_PreparedCurve* curve, const double* params, int paramStride, int count, double* points, int pointStride);
+
+	/// <summary>
+	/// Derivatives up to derivative > 0 at every param, the kth derivative at param i goes to derivatives + i * stride + 3 * k,
+	/// so k = 0 is the point and stride is at least 3 * (derivative + 1).
+	/// </summary>
+	LNLIB_EXPORT LNLib_Status LNLib_ComputeCurveDerivatives(const LNLib_PreparedCurve* curve, int derivative, const double* params, int paramStride, int count, double* derivatives, int stride);
+
+	/// <summary>
+	/// Cached level of detail of PreparedCurve::GetLevelOfDetail, polyline point k to points + k * pointStride and its param to knots[k].
+	/// knots may be null. count receives the point count, a capacity below it returns LNLIB_STATUS_BUFFER_TOO_SMALL with the buffers unwritten.
+	/// error receives the bound of the level and may be null.
+	/// </summary>
+	LNLIB_EXPORT LNLib_Status LNLib_GetCurveLevelOfDetail(const LNLib_PreparedCurve* curve, double maxError, double* points, int pointStride, double* knots, int capacity, int* count, double* error);
+
+	/// <summary>
+	/// Copies and validates desc into a new handle written to surface, surface is null on failure.
+	/// </summary>
+	LNLIB_EXPORT LNLib_Status LNLib_CreatePreparedSurface(const LNLib_SurfaceDesc* desc, LNLib_PreparedSurface** surface);
+
+	LNLIB_EXPORT void LNLib_DestroyPreparedSurface(LNLib_PreparedSurface* surface);
+
+	/// <summary>
+	/// S(u, v) with (u, v) at uvs + i * uvStride to points + i * pointStride, its unit normal to normals + i * normalStride.
+	/// normals may be null.
+	/// </summary>
+	LNLIB_EXPORT LNLib_Status LNLib_EvaluateSurface(const LNLib_PreparedSurface* surface, const double* uvs, int uvStride, int count, double* points, int pointStride, double* normals, int normalStride);
+
+	/// <summary>
+	/// Cached level of detail of PreparedSurface::GetLevelOfDetail into mesh, error receives the bound of the level and may be null.
+	/// </summary>
+	LNLIB_EXPORT LNLib_Status LNLib_GetSurfaceLevelOfDetail(const LNLib_PreparedSurface* surface, double maxError, LNLib_MeshBuffers* mesh, double* error);
+
+#ifdef __cplusplus
+}
+#endif
@@ -10,9 +10,12 @@
 
 #pragma once
 #include "LNLibDefinitions.h"
+#include "Constants.h"
 #include "XYZ.h"
 #include "XYZW.h"
+#include "UV.h"
 #include <vector>
+#include <memory>
 
 namespace LNLib
 {
@@ -49,6 +52,80 @@ namespace LNLib
 		std::vector<std::vector<T>> ControlPoints;
 	};
 
+	/// <summary>
+	/// Non-owning view of bspline curve data.
+	/// Referenced knot vector and control points must outlive the view.
+	/// </summary>
+	template <typename T>
+	struct LN_BsplineCurveView
+	{
+		int Degree;
+		const std::vector<double>& KnotVector;
+		const std::vector<T>& ControlPoints;
+
+		LN_BsplineCurveView(int degree, const std::vector<double>& knotVector, const std::vector<T>& controlPoints) :
+			Degree(degree), KnotVector(knotVector), ControlPoints(controlPoints) {}
+
+		LN_BsplineCurveView(const LN_BsplineCurve<T>& curve) :
+			Degree(curve.Degree), KnotVector(curve.KnotVector), ControlPoints(curve.ControlPoints) {}
+	};
+
+	/// <summary>
+	/// Non-owning view of bspline surface data.
+	/// Referenced knot vectors and control points must outlive the view.
+	/// </summary>
+	template <typename T>
+	struct LN_BsplineSurfaceView
+	{
+		int DegreeU;
+		int DegreeV;
+		const std::vector<double>& KnotVectorU;
+		const std::vector<double>& KnotVectorV;
+		const std::vector<std::vector<T>>& ControlPoints;
+
+		LN_BsplineSurfaceView(int degreeU, int degreeV, const std::vector<double>& knotVectorU, const std::vector<double>& knotVectorV, const std::vector<std::vector<T>>& controlPoints) :
+			DegreeU(degreeU), DegreeV(degreeV), KnotVectorU(knotVectorU), KnotVectorV(knotVectorV), ControlPoints(controlPoints) {}
+
+		LN_BsplineSurfaceView(const LN_BsplineSurface<T>& surface) :
+			DegreeU(surface.DegreeU), DegreeV(surface.DegreeV), KnotVectorU(surface.KnotVectorU), KnotVectorV(surface.KnotVectorV), ControlPoints(surface.ControlPoints) {}
+	};
+
+	/// <summary>
+	/// Evaluation only copy of a NURBS curve in scalar type T, weighted control points split into coordinate arrays.
+	/// Built by ScalarEvaluation::Convert, modeling operations stay on LN_NurbsCurve in double.
+	/// </summary>
+	template <typename T>
+	struct LN_ScalarNurbsCurve
+	{
+		int Degree;
+		bool IsRational;
+		std::vector<T> KnotVector;
+		std::vector<T> WX;
+		std::vector<T> WY;
+		std::vector<T> WZ;
+		std::vector<T> W;
+	};
+
+	/// <summary>
+	/// Evaluation only copy of a NURBS surface in scalar type T, weighted control net in row-major coordinate arrays,
+	/// point (i, j) at i * Columns + j.
+	/// </summary>
+	template <typename T>
+	struct LN_ScalarNurbsSurface
+	{
+		int DegreeU;
+		int DegreeV;
+		bool IsRational;
+		int Rows;
+		int Columns;
+		std::vector<T> KnotVectorU;
+		std::vector<T> KnotVectorV;
+		std::vector<T> WX;
+		std::vector<T> WY;
+		std::vector<T> WZ;
+		std::vector<T> W;
+	};
+
 	struct LNLIB_EXPORT LN_NurbsCurve
 	{
 		int Degree;
@@ -64,7 +141,430 @@ namespace LNLib
 		std::vector<double> KnotVectorV;
 		std::vector<std::vector<XYZW>> ControlPoints;
 	};
-}
 
+	/// <summary>
+	/// Surface bounded by trim loops in its parameter domain, as the faces of B-rep models.
+	/// Each loop is a closed chain of curves whose control points hold u in x and v in y, z is ignored.
+	/// Parameters enclosed by an odd number of loops are kept, so loop orientation and order do not matter.
+	/// </summary>
+	struct LNLIB_EXPORT LN_TrimmedSurface
+	{
+		LN_NurbsSurface Surface;
+		std::vector<std::vector<LN_NurbsCurve>> Loops;
+	};
+
+	/// <summary>
+	/// Immutable knot vector shared between objects, usually interned by KnotVectorPool.
+	/// </summary>
+	typedef std::shared_ptr<const std::vector<double>> LN_SharedKnotVector;
+
+	/// <summary>
+	/// NURBS curve whose knot vector is a shared immutable buffer, copies share it instead of copying the knots.
+	/// LN_BsplineCurveView<XYZW>(curve.Degree, *curve.KnotVector, curve.ControlPoints) evaluates it without conversion.
+	/// </summary>
+	struct LNLIB_EXPORT LN_SharedNurbsCurve
+	{
+		int Degree;
+		LN_SharedKnotVector KnotVector;
+		std::vector<XYZW> ControlPoints;
+	};
+
+	/// <summary>
+	/// NURBS surface whose knot vectors are shared immutable buffers.
+	/// </summary>
+	struct LNLIB_EXPORT LN_SharedNurbsSurface
+	{
+		int DegreeU;
+		int DegreeV;
+		LN_SharedKnotVector KnotVectorU;
+		LN_SharedKnotVector KnotVectorV;
+		std::vector<std::vector<XYZW>> ControlPoints;
+	};
+
+	class NurbsCurve;
+	class NurbsSurface;
+
+	/// <summary>
+	/// Handle of a curve which passed NurbsCurve::Check.
+	/// Evaluations taking the handle skip argument validation,
+	/// the referenced curve must outlive the handle and stay unchanged.
+	/// Whether any weight differs from one is detected once by Check,
+	/// evaluations of a non-rational curve take the polynomial B-spline path without the quotient rule.
+	/// Unchecked per-point evaluations never scan all weights, they decide from the weights of the evaluated span.
+	/// </summary>
+	class LNLIB_EXPORT LN_CheckedNurbsCurve
+	{
+	public:
+		const LN_NurbsCurve& Curve() const { return *_curve; }
+		bool IsRational() const { return _isRational; }
+
+	private:
+		friend class NurbsCurve;
+		LN_CheckedNurbsCurve(const LN_NurbsCurve& curve, bool isRational) : _curve(&curve), _isRational(isRational) {}
+
+		const LN_NurbsCurve* _curve;
+		bool _isRational;
+	};
+
+	/// <summary>
+	/// Handle of a surface which passed NurbsSurface::Check.
+	/// Evaluations taking the handle skip argument validation,
+	/// the referenced surface must outlive the handle and stay unchanged.
+	/// Whether any weight differs from one is detected once by Check,
+	/// evaluations of a non-rational surface take the polynomial B-spline path without the quotient rule.
+	/// Unchecked per-point evaluations never scan all weights, they decide from the weights of the evaluated span.
+	/// </summary>
+	class LNLIB_EXPORT LN_CheckedNurbsSurface
+	{
+	public:
+		const LN_NurbsSurface& Surface() const { return *_surface; }
+		bool IsRational() const { return _isRational; }
+
+	private:
+		friend class NurbsSurface;
+		LN_CheckedNurbsSurface(const LN_NurbsSurface& surface, bool isRational) : _surface(&surface), _isRational(isRational) {}
+
+		const LN_NurbsSurface* _surface;
+		bool _isRational;
+	};
+
+	/// <summary>
+	/// Scratch buffers reused by derivative evaluation.
+	/// Buffers grow to fit degree and derivative order on first use, later calls with the same sizes do not allocate.
+	/// </summary>
+	struct LNLIB_EXPORT LN_DerivativeWorkspace
+	{
+		std::vector<double> BasisDerivatives;
+		std::vector<XYZW> WeightedDerivatives;
+	};
+
+	/// <summary>
+	/// NURBS surface with control points stored in one row-major buffer.
+	/// ColumnCount is the row stride: point (i, j) is ControlPoints[i * ColumnCount + j],
+	/// i along U direction and j along V direction.
+	/// </summary>
+	struct LNLIB_EXPORT LN_FlatNurbsSurface
+	{
+		int DegreeU;
+		int DegreeV;
+		std::vector<double> KnotVectorU;
+		std::vector<double> KnotVectorV;
+		int RowCount;
+		int ColumnCount;
+		std::vector<XYZW> ControlPoints;
+	};
+
+	/// <summary>
+	/// Bernstein polynomials B_k,Degree at a fixed set of params, B_k(Params[i]) is Values[k * Params.size() + i].
+	/// Each polynomial is contiguous over the params, so batch evaluators stream one row per control point.
+	/// </summary>
+	struct LNLIB_EXPORT LN_BernsteinTable
+	{
+		int Degree;
+		std::vector<double> Params;
+		std::vector<double> Values;
+	};
+
+	/// <summary>
+	/// Bezier segments of a curve in one buffer.
+	/// Segment s has control points [s * (Degree + 1), (s + 1) * (Degree + 1)) and covers [Domains[2 * s], Domains[2 * s + 1]] of the decomposed curve.
+	/// </summary>
+	struct LNLIB_EXPORT LN_BezierSegmentArray
+	{
+		int Degree;
+		int Count;
+		std::vector<double> Domains;
+		std::vector<XYZW> ControlPoints;
+	};
+
+	/// <summary>
+	/// Bezier patches of a surface in one buffer, patch s = i * CountV + j is the i-th along U direction and j-th along V direction.
+	/// Control point (k, l) of patch s is ControlPoints[(s * (DegreeU + 1) + k) * (DegreeV + 1) + l],
+	/// the patch covers [Domains[4 * s], Domains[4 * s + 1]] x [Domains[4 * s + 2], Domains[4 * s + 3]] of the decomposed surface.
+	/// </summary>
+	struct LNLIB_EXPORT LN_BezierPatchArray
+	{
+		int DegreeU;
+		int DegreeV;
+		int CountU;
+		int CountV;
+		std::vector<double> Domains;
+		std::vector<XYZW> ControlPoints;
+	};
+
+	/// <summary>
+	/// Single precision std430 layout of a curve for GPU evaluation, built by GpuExport::Pack.
+	/// Breaks holds Count + 1 ascending segment bounds, segment s covers [Breaks[s], Breaks[s + 1]],
+	/// ControlPoints holds (Degree + 1) weighted vec4 (wx, wy, wz, w) per segment in segment order.
+	/// </summary>
+	struct LNLIB_EXPORT LN_GpuCurveBuffer
+	{
+		int Degree;
+		int Count;
+		std::vector<float> Breaks;
+		std::vector<float> ControlPoints;
+	};
+
+	/// <summary>
+	/// Single precision std430 layout of a surface for GPU evaluation, built by GpuExport::Pack.
+	/// BreaksU and BreaksV hold CountU + 1 and CountV + 1 ascending patch bounds,
+	/// patch s = i * CountV + j covers [BreaksU[i], BreaksU[i + 1]] x [BreaksV[j], BreaksV[j + 1]].
+	/// ControlPoints holds (DegreeU + 1) * (DegreeV + 1) weighted vec4 per patch, control point (k, l) of patch s
+	/// starts at 4 * ((s * (DegreeU + 1) + k) * (DegreeV + 1) + l).
+	/// </summary>
+	struct LNLIB_EXPORT LN_GpuSurfaceBuffer
+	{
+		int DegreeU;
+		int DegreeV;
+		int CountU;
+		int CountV;
+		std::vector<float> BreaksU;
+		std::vector<float> BreaksV;
+		std::vector<float> ControlPoints;
+	};
+
+	/// <summary>
+	/// Zero-copy view of a curve in a GeometryStore, pointers reference the store memory and stay valid while it is open.
+	/// Bounds is null or Min x, y, z followed by Max x, y, z of the control point bounding box.
+	/// </summary>
+	struct LNLIB_EXPORT LN_StoredNurbsCurve
+	{
+		int Degree;
+		int KnotCount;
+		int ControlPointCount;
+		const double* KnotVector;
+		const XYZW* ControlPoints;
+		const double* Bounds;
+	};
+
+	/// <summary>
+	/// Zero-copy view of a surface in a GeometryStore, control point (i, j) is ControlPoints[i * Columns + j].
+	/// </summary>
+	struct LNLIB_EXPORT LN_StoredNurbsSurface
+	{
+		int DegreeU;
+		int DegreeV;
+		int KnotCountU;
+		int KnotCountV;
+		int Rows;
+		int Columns;
+		const double* KnotVectorU;
+		const double* KnotVectorV;
+		const XYZW* ControlPoints;
+		const double* Bounds;
+	};
+
+	/// <summary>
+	/// Dense matrix in one row-major buffer, element (i, j) is Elements[i * ColumnCount + j].
+	/// </summary>
+	struct LNLIB_EXPORT LN_Matrix
+	{
+		int RowCount;
+		int ColumnCount;
+		std::vector<double> Elements;
+	};
+
+	/// <summary>
+	/// Weighted control points split into one array per coordinate (structure of arrays).
+	/// Batch evaluation kernels read these arrays lane by lane so the compiler can vectorize.
+	/// </summary>
+	struct LNLIB_EXPORT LN_ControlPointArrays
+	{
+		std::vector<double> WX;
+		std::vector<double> WY;
+		std::vector<double> WZ;
+		std::vector<double> W;
+	};
 
+	/// <summary>
+	/// Cumulative arc length Lengths[i] from curve start to Params[i].
+	/// Derivatives[2 * i] and Derivatives[2 * i + 1] are dt/ds at the start and end of interval i, one-sided at knots,
+	/// limited so the inverse Hermite interpolant is monotone.
+	/// </summary>
+	struct LNLIB_EXPORT LN_ArcLengthTable
+	{
+		std::vector<double> Params;
+		std::vector<double> Lengths;
+		std::vector<double> Derivatives;
+	};
+
+	/// <summary>
+	/// Axis aligned bounding box.
+	/// </summary>
+	struct LNLIB_EXPORT LN_BoundingBox
+	{
+		XYZ Min;
+		XYZ Max;
+	};
+
+	/// <summary>
+	/// Local support of the edited control points FirstIndex..LastIndex, the curve only changed on [Start, End],
+	/// which are the distinct knot spans (Bezier segments) FirstSpan..LastSpan.
+	/// </summary>
+	struct LNLIB_EXPORT LN_DirtyRange
+	{
+		int FirstIndex;
+		int LastIndex;
+		int FirstSpan;
+		int LastSpan;
+		double Start;
+		double End;
+	};
+
+	/// <summary>
+	/// Intersection of two curves at C0(Param0) and C1(Param1), Point is the middle of both.
+	/// When IsOverlap the curves coincide from there up to C0(EndParam0) and C1(EndParam1), otherwise the end params equal Param0 and Param1.
+	/// </summary>
+	struct LNLIB_EXPORT LN_CurveCurveIntersection
+	{
+		double Param0;
+		double Param1;
+		XYZ Point;
+		bool IsOverlap;
+		double EndParam0;
+		double EndParam1;
+	};
 
+	/// <summary>
+	/// Closest approach of two curves, Point0 = C0(Param0) and Point1 = C1(Param1) are Distance apart.
+	/// </summary>
+	struct LNLIB_EXPORT LN_CurveCurveDistance
+	{
+		double Param0;
+		double Param1;
+		XYZ Point0;
+		XYZ Point1;
+		double Distance;
+	};
+
+	/// <summary>
+	/// Intersection of a curve and a surface at C(CurveParam) and S(SurfaceParam), Point is the middle of both.
+	/// </summary>
+	struct LNLIB_EXPORT LN_CurveSurfaceIntersection
+	{
+		double CurveParam;
+		UV SurfaceParam;
+		XYZ Point;
+	};
+
+	/// <summary>
+	/// Hit of the ray origin + RayParam * direction on a surface at S(SurfaceParam) = Point.
+	/// </summary>
+	struct LNLIB_EXPORT LN_RaySurfaceIntersection
+	{
+		double RayParam;
+		UV SurfaceParam;
+		XYZ Point;
+	};
+
+	/// <summary>
+	/// Point C(CurveParam) of a curve passing Distance from the ray point origin + RayParam * direction.
+	/// </summary>
+	struct LNLIB_EXPORT LN_RayCurveIntersection
+	{
+		double RayParam;
+		double CurveParam;
+		XYZ Point;
+		double Distance;
+	};
+
+	/// <summary>
+	/// Nearest hit of a pick ray in a scene, exactly one of SurfaceIndex and CurveIndex is not -1.
+	/// SurfaceParam is set for surface hits and CurveParam for curve hits.
+	/// </summary>
+	struct LNLIB_EXPORT LN_PickResult
+	{
+		int SurfaceIndex;
+		int CurveIndex;
+		double RayParam;
+		UV SurfaceParam;
+		double CurveParam;
+		XYZ Point;
+	};
+
+	/// <summary>
+	/// One branch of the intersection of two surfaces traced by marching.
+	/// Points, Params0 and Params1 are parallel, Curve interpolates Points and has no control points when fewer than two points were traced.
+	/// </summary>
+	struct LNLIB_EXPORT LN_SurfaceSurfaceIntersection
+	{
+		std::vector<XYZ> Points;
+		std::vector<UV> Params0;
+		std::vector<UV> Params1;
+		LN_NurbsCurve Curve;
+	};
+
+	/// <summary>
+	/// Curvatures of a surface point, Maximum and Minimum are the principal curvatures
+	/// with unit principal directions in model space.
+	/// Signs follow the normal Su x Sv, all values are zero where the surface is degenerate.
+	/// </summary>
+	struct LNLIB_EXPORT LN_SurfaceCurvature
+	{
+		double Maximum;
+		double Minimum;
+		double Gauss;
+		double Mean;
+		XYZ MaximumDirection;
+		XYZ MinimumDirection;
+	};
+
+	/// <summary>
+	/// Stopping criteria of Newton point inversion, The NURBS Book 2nd Edition Page230.
+	/// DistanceTolerance measures point coincidence and the model space length of a step, CosineTolerance the zero cosine.
+	/// Warm started projector queries search LocalSearchRange seed segments or patch spans on each side of the previous parameter
+	/// and fall back to the global search when the nearest seed lies on the border of that window.
+	/// </summary>
+	struct LNLIB_EXPORT LN_ProjectionOptions
+	{
+		int MaxIterations;
+		double DistanceTolerance;
+		double CosineTolerance;
+		int LocalSearchRange;
+
+		LN_ProjectionOptions() : MaxIterations(10), DistanceTolerance(Constants::DistanceEpsilon), CosineTolerance(Constants::DistanceEpsilon), LocalSearchRange(4) {}
+	};
+
+	/// <summary>
+	/// Deviation of a point P from a surface, FootPoint = S(Param) is its point inversion.
+	/// Distance is |P - FootPoint|, positive when P lies on the side of the normal Su x Sv.
+	/// </summary>
+	struct LNLIB_EXPORT LN_PointDeviation
+	{
+		UV Param;
+		XYZ FootPoint;
+		double Distance;
+	};
+
+	/// <summary>
+	/// Indexed triangle mesh, Indices holds three vertex indices per triangle.
+	/// Normals and UVs are parallel to Vertices.
+	/// </summary>
+	struct LNLIB_EXPORT LN_Mesh
+	{
+		std::vector<XYZ> Vertices;
+		std::vector<XYZ> Normals;
+		std::vector<UV> UVs;
+		std::vector<int> Indices;
+	};
+
+	/// <summary>
+	/// One level of a curve tessellation hierarchy, Points[i] = C(Knots[i]).
+	/// Every point of the curve lies within Error of the polyline through Points.
+	/// </summary>
+	struct LNLIB_EXPORT LN_CurveLevelOfDetail
+	{
+		double Error;
+		std::vector<XYZ> Points;
+		std::vector<double> Knots;
+	};
+
+	/// <summary>
+	/// One level of a surface tessellation hierarchy, every point of the surface lies within Error of Mesh.
+	/// </summary>
+	struct LNLIB_EXPORT LN_SurfaceLevelOfDetail
+	{
+		double Error;
+		LN_Mesh Mesh;
+	};
+}
@@ -16,6 +16,8 @@
 
 namespace LNLib
 {
+	struct LN_Matrix;
+
 	class LNLIB_EXPORT MathUtils
 	{
 
@@ -77,7 +79,27 @@ namespace LNLib
 			return result;
 		}
 
+		/// <summary>
+		/// Flattens the matrix through MatrixMultiply of LN_Matrix.
+		/// </summary>
 		static std::vector<std::vector<double>> MatrixMultiply(const std::vector<std::vector<double>>& left, const std::vector<std::vector<double>>& right);
+
+		/// <summary>
+		/// result = left * right, result is resized.
+		/// </summary>
+		static void MatrixMultiply(const LN_Matrix& left, const LN_Matrix& right, LN_Matrix& result);
+
+		/// <summary>
+		/// result = left * right on row-major buffers, left is rows x depth, right depth x columns and result rows x columns.
+		/// The product is accumulated in cache sized blocks with rows of right and result walked contiguously (two lanes with SSE2),
+		/// every element keeps the summation order of the plain triple loop.
+		/// result must not overlap the operands.
+		/// </summary>
+		static void MatrixMultiply(const double* left, const double* right, int rows, int depth, int columns, double* result);
+
+		static void ToFlatMatrix(const std::vector<std::vector<double>>& matrix, LN_Matrix& result);
+
+		static std::vector<std::vector<double>> ToNestedMatrix(const LN_Matrix& matrix);
 	
 		static std::vector<std::vector<double>> MakeDiagonal(int size);
 		
@@ -93,10 +115,67 @@ namespace LNLib
 		
 		static bool LUPDecomposition(const std::vector<std::vector<double>>& matrix, std::vector<std::vector<double>>& lowerTriMatrix, std::vector<std::vector<double>>& upperTriMatrix, std::vector<double>& pivot);
 
+		/// <summary>
+		/// LU decomposition with partial pivoting, P * matrix = L * U.
+		/// decomposedMatrix holds L (unit diagonal omitted) below the diagonal and U on and above it.
+		/// pivot[i] is the original row placed at row i.
+		/// </summary>
+		static bool LUPDecomposition(const std::vector<std::vector<double>>& matrix, std::vector<std::vector<double>>& decomposedMatrix, std::vector<int>& pivot);
+
+		/// <summary>
+		/// matrix * result = right, matrix decomposed by LUPDecomposition.
+		/// Each column of right is solved, so one decomposition serves many right-hand sides.
+		/// </summary>
+		static std::vector<std::vector<double>> ForwardAndBackwardSubstitution(const std::vector<std::vector<double>>& decomposedMatrix, const std::vector<int>& pivot, const std::vector<std::vector<double>>& right);
+
 		/// <summary>
 		/// matrix * result = right.
 		/// </summary>
 		static std::vector<std::vector<double>> SolveLinearSystem(const std::vector<std::vector<double>>& matrix, const std::vector<std::vector<double>>& right);
+
+		/// <summary>
+		/// Banded matrix storage: element (i, j) is band[i][j - i + lowerBandwidth], 
+		/// row size is lowerBandwidth + upperBandwidth + 1.
+		/// </summary>
+		static std::vector<std::vector<double>> CreateBandedMatrix(int size, int lowerBandwidth, int upperBandwidth);
+
+		/// <summary>
+		/// The NURBS Book 2nd Edition Page370
+		/// LU decomposition of banded matrix in place without pivoting.
+		/// Collocation matrices of B-spline interpolation are totally positive and normal matrices are positive definite,
+		/// so Gaussian elimination without pivoting is stable and keeps the band.
+		/// Returns false if a zero pivot is met.
+		/// </summary>
+		static bool BandedLUDecomposition(std::vector<std::vector<double>>& band, int lowerBandwidth, int upperBandwidth);
+
+		/// <summary>
+		/// matrix * result = right, matrix decomposed by BandedLUDecomposition.
+		/// </summary>
+		static std::vector<std::vector<double>> BandedForwardAndBackwardSubstitution(const std::vector<std::vector<double>>& band, int lowerBandwidth, int upperBandwidth, const std::vector<std::vector<double>>& right);
+
+		/// <summary>
+		/// matrix * result = right, matrix in banded storage.
+		/// Falls back to dense LUP solution if elimination without pivoting breaks down.
+		/// </summary>
+		static std::vector<std::vector<double>> SolveBandedLinearSystem(const std::vector<std::vector<double>>& band, int lowerBandwidth, int upperBandwidth, const std::vector<std::vector<double>>& right);
+
+		/// <summary>
+		/// Cholesky decomposition matrix = L * L^T of symmetric positive definite banded matrix in place.
+		/// Only the lower triangle is stored, CreateBandedMatrix(size, bandwidth, 0) layout, and replaced by L.
+		/// Returns false if matrix is not positive definite.
+		/// </summary>
+		static bool SymmetricBandedCholeskyDecomposition(std::vector<std::vector<double>>& band, int bandwidth);
+
+		/// <summary>
+		/// matrix * result = right, matrix decomposed by SymmetricBandedCholeskyDecomposition.
+		/// </summary>
+		static std::vector<std::vector<double>> SymmetricBandedForwardAndBackwardSubstitution(const std::vector<std::vector<double>>& band, int bandwidth, const std::vector<std::vector<double>>& right);
+
+		/// <summary>
+		/// matrix * result = right, symmetric matrix in lower banded storage.
+		/// Falls back to SolveBandedLinearSystem if matrix is not positive definite.
+		/// </summary>
+		static std::vector<std::vector<double>> SolveSymmetricBandedLinearSystem(const std::vector<std::vector<double>>& band, int bandwidth, const std::vector<std::vector<double>>& right);
 	};
 }
 
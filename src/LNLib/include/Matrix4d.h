@@ -57,6 +57,12 @@ namespace LNLib
 		XYZW OfWeightedPoint(const XYZW& point);
 		XYZ OfVector(const XYZ& vector);
 
+		/// <summary>
+		/// Transforms count contiguous weighted points, result may be the same array as points for in place.
+		/// Uses SSE2 when available, affine matrices skip the weight row.
+		/// </summary>
+		void OfWeightedPoints(const XYZW* points, int count, XYZW* result) const;
+
 	public:
 		bool GetInverse(Matrix4d& inverse);
 		Matrix4d GetTranspose();
@@ -66,6 +72,11 @@ namespace LNLib
 		bool HasReflection();
 		bool IsTranslation();
 
+		/// <summary>
+		/// Last row is exactly [0 0 0 1], weights are kept by the transform.
+		/// </summary>
+		bool IsAffine() const;
+
 	public:
 		Matrix4d& operator =(const Matrix4d & another);
 
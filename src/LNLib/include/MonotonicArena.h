@@ -0,0 +1,117 @@
+/*
+ * Author:
+ * 2024/10/14 - Yuqing Liang (BIMCoder Liang)
+ * bim.frankliang@foxmail.com
+ * 微信公众号：BIMCoder梁老师
+ *
+ * Use of this source code is governed by a GPL-3.0 license that can be found in
+ * the LICENSE file.
+ */
+
+#pragma once
+#include "LNLibDefinitions.h"
+#include <cstddef>
+#include <vector>
+
+namespace LNLib
+{
+	/// <summary>
+	/// Bump allocator for temporary geometry of one construction.
+	/// Memory is taken from large blocks and only returned all at once by Release or the destructor,
+	/// so the many small scratch buffers of a construction cost a handful of heap calls.
+	/// Not thread safe, use one arena per call or per thread.
+	/// </summary>
+	class LNLIB_EXPORT MonotonicArena
+	{
+	public:
+
+		explicit MonotonicArena(size_t blockSize = 16384);
+		~MonotonicArena();
+
+		MonotonicArena(const MonotonicArena&) = delete;
+		MonotonicArena& operator=(const MonotonicArena&) = delete;
+
+		/// <summary>
+		/// Returns bytes aligned to alignment, which must be a power of two.
+		/// </summary>
+		void* Allocate(size_t bytes, size_t alignment);
+
+		/// <summary>
+		/// Frees every block at once, all memory handed out before becomes invalid.
+		/// </summary>
+		void Release();
+
+		/// <summary>
+		/// Bytes handed out since construction or the last Release.
+		/// </summary>
+		size_t GetAllocatedBytes() const;
+
+		/// <summary>
+		/// Number of blocks currently held from the heap.
+		/// </summary>
+		size_t GetBlockCount() const;
+
+	private:
+
+		struct Block;
+
+		Block* _blocks;
+		char* _current;
+		char* _end;
+		size_t _blockSize;
+		size_t _allocatedBytes;
+		size_t _blockCount;
+	};
+
+	/// <summary>
+	/// Standard allocator over MonotonicArena, deallocate does nothing.
+	/// Containers using it must not outlive the arena.
+	/// </summary>
+	template <typename T>
+	class ArenaAllocator
+	{
+	public:
+		typedef T value_type;
+
+		explicit ArenaAllocator(MonotonicArena& arena) : _arena(&arena)
+		{
+		}
+
+		template <typename U>
+		ArenaAllocator(const ArenaAllocator<U>& other) : _arena(other.GetArena())
+		{
+		}
+
+		T* allocate(size_t n)
+		{
+			return static_cast<T*>(_arena->Allocate(n * sizeof(T), alignof(T)));
+		}
+
+		void deallocate(T*, size_t)
+		{
+		}
+
+		MonotonicArena* GetArena() const
+		{
+			return _arena;
+		}
+
+	private:
+		MonotonicArena* _arena;
+	};
+
+	template <typename T, typename U>
+	bool operator==(const ArenaAllocator<T>& first, const ArenaAllocator<U>& second)
+	{
+		return first.GetArena() == second.GetArena();
+	}
+
+	template <typename T, typename U>
+	bool operator!=(const ArenaAllocator<T>& first, const ArenaAllocator<U>& second)
+	{
+		return first.GetArena() != second.GetArena();
+	}
+
+	template <typename T>
+	using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+}
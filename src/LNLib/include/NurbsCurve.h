@@ -14,21 +14,26 @@
 #include "LNLibDefinitions.h"
 #include "LNObject.h"
 #include "LNEnums.h"
+#include "Parallel.h"
 #include <vector>
+#include <future>
 
 namespace LNLib
 {
 	class XYZ;
 	class XYZW;
 	class Matrix4d;
+	class PreparedCurve;
+	class CancellationToken;
 	class LNLIB_EXPORT NurbsCurve
 	{
 	public:
 
 		/// <summary>
 		/// Check curve whether fits NURBS.
+		/// Returned handle lets hot evaluations skip repeated validation.
 		/// </summary>
-		static void Check(const LN_NurbsCurve& curve);
+		static LN_CheckedNurbsCurve Check(const LN_NurbsCurve& curve);
 
 		/// <summary>
 		/// The NURBS Book 2nd Edition Page124
@@ -37,6 +42,43 @@ namespace LNLib
 		/// </summary>
 		static XYZ GetPointOnCurve(const LN_NurbsCurve& curve, double paramT);
 
+		/// <summary>
+		/// The NURBS Book 2nd Edition Page124
+		/// Algorithm A4.1
+		/// Compute point on checked rational B-spline curve without argument validation.
+		/// paramT must lie in the knot vector range.
+		/// </summary>
+		static XYZ GetPointOnCurve(const LN_CheckedNurbsCurve& curve, double paramT);
+
+		/// <summary>
+		/// The NURBS Book 2nd Edition Page124
+		/// Algorithm A4.1
+		/// Compute point on a curve in GeometryStore memory, knots and control points are read in place.
+		/// </summary>
+		static XYZ GetPointOnCurve(const LN_StoredNurbsCurve& curve, double paramT);
+
+		/// <summary>
+		/// The NURBS Book 2nd Edition Page124
+		/// Algorithm A4.1
+		/// Compute points on rational B-spline curve for count parameters.
+		/// Curve is validated once, knot spans are walked incrementally for ascending params.
+		/// </summary>
+		static void GetPointsOnCurve(const LN_NurbsCurve& curve, const double* params, int count, XYZ* points);
+
+		/// <summary>
+		/// The NURBS Book 2nd Edition Page124
+		/// Algorithm A4.1
+		/// Compute points on checked rational B-spline curve without argument validation.
+		/// </summary>
+		static void GetPointsOnCurve(const LN_CheckedNurbsCurve& curve, const double* params, int count, XYZ* points);
+
+		/// <summary>
+		/// The NURBS Book 2nd Edition Page124
+		/// Algorithm A4.1
+		/// Compute points on rational B-spline curve.
+		/// </summary>
+		static std::vector<XYZ> GetPointsOnCurve(const LN_NurbsCurve& curve, const std::vector<double>& params);
+
 		/// <summary>
 		/// The NURBS Book 2nd Edition Page127
 		/// Algorithm A4.2
@@ -44,6 +86,43 @@ namespace LNLib
 		/// </summary>
 		static std::vector<XYZ> ComputeRationalCurveDerivatives(const LN_NurbsCurve& curve, int derivative, double paramT);
 
+		/// <summary>
+		/// The NURBS Book 2nd Edition Page127
+		/// Algorithm A4.2
+		/// Compute derivatives of checked curve without argument validation.
+		/// derivative must greater than zero and paramT must lie in the knot vector range.
+		/// </summary>
+		static std::vector<XYZ> ComputeRationalCurveDerivatives(const LN_CheckedNurbsCurve& curve, int derivative, double paramT);
+
+		/// <summary>
+		/// The NURBS Book 2nd Edition Page127
+		/// Algorithm A4.2
+		/// Compute derivatives of checked curve into caller owned buffer with (derivative + 1) values.
+		/// Scratch memory comes from workspace, so repeated calls do not allocate.
+		/// </summary>
+		static void ComputeRationalCurveDerivatives(const LN_CheckedNurbsCurve& curve, int derivative, double paramT, LN_DerivativeWorkspace& workspace, XYZ* derivatives);
+
+		/// <summary>
+		/// The NURBS Book 2nd Edition Page127
+		/// Algorithm A4.2
+		/// Compute derivatives of checked curve for count parameters,
+		/// kth derivative at params[i] is written to derivatives[i * (derivative + 1) + k].
+		/// Knot spans are walked incrementally for ascending params.
+		/// </summary>
+		static void ComputeRationalCurveDerivatives(const LN_CheckedNurbsCurve& curve, int derivative, const double* params, int count, XYZ* derivatives);
+
+		/// <summary>
+		/// Non-throwing point evaluation of checked curve, paramT outside the domain fails or is clamped by policy.
+		/// point is only written on Success.
+		/// </summary>
+		static EvaluationStatus TryGetPointOnCurve(const LN_CheckedNurbsCurve& curve, double paramT, XYZ& point, ParameterRangePolicy policy = ParameterRangePolicy::Fail) noexcept;
+
+		/// <summary>
+		/// Non-throwing form of the workspace derivatives, derivative must greater than zero.
+		/// derivatives is only written on Success.
+		/// </summary>
+		static EvaluationStatus TryComputeRationalCurveDerivatives(const LN_CheckedNurbsCurve& curve, int derivative, double paramT, LN_DerivativeWorkspace& workspace, XYZ* derivatives, ParameterRangePolicy policy = ParameterRangePolicy::Fail) noexcept;
+
 		/// <summary>
 		/// Calculate curve curvature.
 		/// </summary>
@@ -59,6 +138,24 @@ namespace LNLib
 		/// </summary>
 		static double Torsion(const LN_NurbsCurve& curve, double paramT);
 
+		/// <summary>
+		/// Calculate curvature of checked curve, derivatives reuse workspace so repeated calls neither check nor allocate.
+		/// paramT must lie in the knot vector range.
+		/// </summary>
+		static double Curvature(const LN_CheckedNurbsCurve& curve, double paramT, LN_DerivativeWorkspace& workspace);
+
+		/// <summary>
+		/// Calculate normal direction of checked curve, derivatives reuse workspace so repeated calls neither check nor allocate.
+		/// paramT must lie in the knot vector range.
+		/// </summary>
+		static XYZ Normal(const LN_CheckedNurbsCurve& curve, CurveNormal normalType, double paramT, LN_DerivativeWorkspace& workspace);
+
+		/// <summary>
+		/// Calculate torsion of checked curve, derivatives reuse workspace so repeated calls neither check nor allocate.
+		/// paramT must lie in the knot vector range.
+		/// </summary>
+		static double Torsion(const LN_CheckedNurbsCurve& curve, double paramT, LN_DerivativeWorkspace& workspace);
+
 		/// <summary>
 		/// The NURBS Book 2nd Edition Page151
 		/// Algorithm A5.1
@@ -67,6 +164,18 @@ namespace LNLib
 		/// </summary>
 		static int InsertKnot(const LN_NurbsCurve& curve, double insertKnot, int times, LN_NurbsCurve& result);
 
+		/// <summary>
+		/// Moves the curve into result before inserting, so the input buffers are reused.
+		/// </summary>
+		static int InsertKnot(LN_NurbsCurve&& curve, double insertKnot, int times, LN_NurbsCurve& result);
+
+		/// <summary>
+		/// In-place knot insertion.
+		/// Grows the existing knot vector and control points and shifts the unaffected tail.
+		/// Returns the actual inserted times.
+		/// </summary>
+		static int InsertKnot(LN_NurbsCurve& curve, double insertKnot, int times);
+
 		/// <summary>
 		/// The NURBS Book 2nd Edition Page155
 		/// Algorithm A5.2
@@ -81,6 +190,17 @@ namespace LNLib
 		/// </summary>
 		static void RefineKnotVector(const LN_NurbsCurve& curve, std::vector<double>& insertKnotElements, LN_NurbsCurve& result);
 
+		/// <summary>
+		/// Moves the curve into result before refining, so the input buffers are reused.
+		/// </summary>
+		static void RefineKnotVector(LN_NurbsCurve&& curve, std::vector<double>& insertKnotElements, LN_NurbsCurve& result);
+
+		/// <summary>
+		/// In-place knot refinement.
+		/// Grows the existing knot vector and control points and runs A5.4 from the back.
+		/// </summary>
+		static void RefineKnotVector(LN_NurbsCurve& curve, const std::vector<double>& insertKnotElements);
+
 		/// <summary>
 		/// The NURBS Book 2nd Edition Page173
 		/// Algorithm A5.6
@@ -88,6 +208,31 @@ namespace LNLib
 		/// </summary>
 		static std::vector<LN_NurbsCurve> DecomposeToBeziers(const LN_NurbsCurve& curve);
 
+		/// <summary>
+		/// Decompose every curve into Bezier segments, curves are processed in parallel.
+		/// </summary>
+		static std::vector<std::vector<LN_NurbsCurve>> DecomposeToBeziers(const std::vector<LN_NurbsCurve>& curves, ParallelExecutor* executor = nullptr);
+
+		/// <summary>
+		/// Decompose curve into Bezier segments stored in one control point buffer with a domain table.
+		/// </summary>
+		static void DecomposeToBeziers(const LN_NurbsCurve& curve, LN_BezierSegmentArray& segments);
+
+		/// <summary>
+		/// Conservative bounding box of the control points.
+		/// </summary>
+		static LN_BoundingBox GetBoundingBox(const LN_NurbsCurve& curve);
+
+		/// <summary>
+		/// Tight bounding box from the ends of every Bezier segment and the roots of each coordinate derivative on it.
+		/// </summary>
+		static LN_BoundingBox GetTightBoundingBox(const LN_NurbsCurve& curve);
+
+		/// <summary>
+		/// Conservative bounding box of every Bezier segment, box i covers [u_i, u_i+1] of the distinct knots.
+		/// </summary>
+		static std::vector<LN_BoundingBox> GetSpanBoundingBoxes(const LN_NurbsCurve& curve);
+
 		/// <summary>
 		/// The NURBS Book 2nd Edition Page185
 		/// Algorithm A5.8
@@ -102,6 +247,11 @@ namespace LNLib
 		/// </summary>
 		static void ElevateDegree(const LN_NurbsCurve& curve, int times, LN_NurbsCurve& result);
 
+		/// <summary>
+		/// Returns the degree elevated curve by value.
+		/// </summary>
+		static LN_NurbsCurve ElevateDegree(const LN_NurbsCurve& curve, int times);
+
 		/// <summary>
 		/// The NURBS Book 2nd Edition Page223
 		/// Algorithm A5.11
@@ -115,6 +265,30 @@ namespace LNLib
 		/// </summary>
 		static void EquallyTessellate(const LN_NurbsCurve& curve, std::vector<XYZ>& tessellatedPoints, std::vector<double>& correspondingKnots);
 
+		/// <summary>
+		/// Equally tessellate every curve, curves are processed in parallel.
+		/// </summary>
+		static void EquallyTessellate(const std::vector<LN_NurbsCurve>& curves, std::vector<std::vector<XYZ>>& tessellatedPoints, std::vector<std::vector<double>>& correspondingKnots, ParallelExecutor* executor = nullptr);
+
+		/// <summary>
+		/// Adaptive tessellation on each candidate span.
+		/// An interval is split at its middle until the points at 1/4, 1/2 and 3/4 are within chordTolerance of the chord
+		/// and the end segments turn less than angleTolerance (radians) from it.
+		/// </summary>
+		static void Tessellate(const LN_NurbsCurve& curve, double chordTolerance, double angleTolerance, std::vector<XYZ>& tessellatedPoints, std::vector<double>& correspondingKnots);
+
+		/// <summary>
+		/// Update the EquallyTessellate output of the curve before an edit to the edited curve, which has to keep the knot vector.
+		/// Only the points on [dirty.Start, dirty.End] are evaluated again.
+		/// </summary>
+		static void UpdateEqualTessellation(const LN_NurbsCurve& curve, const LN_DirtyRange& dirty, std::vector<XYZ>& tessellatedPoints, const std::vector<double>& correspondingKnots);
+
+		/// <summary>
+		/// Update the Tessellate output of the curve before an edit to the edited curve, which has to keep the knot vector.
+		/// The dirty spans are tessellated again with the same tolerances and replace their old points, the others are kept.
+		/// </summary>
+		static void UpdateTessellation(const LN_NurbsCurve& curve, const LN_DirtyRange& dirty, double chordTolerance, double angleTolerance, std::vector<XYZ>& tessellatedPoints, std::vector<double>& correspondingKnots);
+
 		/// <summary>
 		/// Detemine curve is closed.
 		/// Close means end point equals start point or points overlap.
@@ -127,18 +301,81 @@ namespace LNLib
 		/// </summary>
 		static double GetParamOnCurve(const LN_NurbsCurve& curve, const XYZ& givenPoint);
 
+		/// <summary>
+		/// The NURBS Book 2nd Edition Page230
+		/// Point inversion with the given tolerances and iteration cap.
+		/// </summary>
+		static double GetParamOnCurve(const LN_NurbsCurve& curve, const XYZ& givenPoint, const LN_ProjectionOptions& options);
+
+		/// <summary>
+		/// Closest approach of two curves by branch and bound over pairs of Bezier segments.
+		/// Pairs are visited by increasing distance of their control point boxes, the exact end points of every pair tighten the best distance
+		/// and pairs whose box distance (or chord distance less both flatnesses) can not beat it by more than tolerance are dropped.
+		/// Flat pairs seed Newton iteration on the gradient of |C0(s) - C1(t)|^2 from the closest points of their chords.
+		/// Pieces are split once and shared by all their pairs, a budget on pieces and visited pairs bounds memory and time
+		/// when the curves stay close over long stretches (concentric or offset curves).
+		/// The returned Distance exceeds the true minimum by at most tolerance unless that budget runs out, it is always attained by the returned points.
+		/// </summary>
+		static LN_CurveCurveDistance MinimumDistance(const LN_NurbsCurve& curve0, const LN_NurbsCurve& curve1, double tolerance = Constants::DistanceEpsilon);
+
+		/// <summary>
+		/// MinimumDistance on the cached Bezier segments, boxes and hodographs of prepared curves.
+		/// </summary>
+		static LN_CurveCurveDistance MinimumDistance(const PreparedCurve& curve0, const PreparedCurve& curve1, double tolerance = Constants::DistanceEpsilon);
+
+		/// <summary>
+		/// MinimumDistance of curve to every other curve, result i has Param0 on curve and Param1 on others[i].
+		/// curve is decomposed once and shared by all tasks, others are processed in parallel.
+		/// </summary>
+		static std::vector<LN_CurveCurveDistance> MinimumDistance(const PreparedCurve& curve, const std::vector<LN_NurbsCurve>& others, double tolerance = Constants::DistanceEpsilon, ParallelExecutor* executor = nullptr);
+
 		/// <summary>
 		/// The NURBS Book 2nd Edition Page236
 		/// Curve make Transform.
 		/// </summary>
 		static void CreateTransformed(const LN_NurbsCurve& curve, const Matrix4d& matrix, LN_NurbsCurve& result);
 
+		/// <summary>
+		/// Returns the transformed curve by value.
+		/// </summary>
+		static LN_NurbsCurve CreateTransformed(const LN_NurbsCurve& curve, const Matrix4d& matrix);
+
+		/// <summary>
+		/// Consumes the curve and transforms its control points in place.
+		/// </summary>
+		static LN_NurbsCurve CreateTransformed(LN_NurbsCurve&& curve, const Matrix4d& matrix);
+
+		/// <summary>
+		/// Returns every curve transformed by the same matrix, curves are processed in parallel.
+		/// </summary>
+		static std::vector<LN_NurbsCurve> CreateTransformed(const std::vector<LN_NurbsCurve>& curves, const Matrix4d& matrix, ParallelExecutor* executor = nullptr);
+
+		/// <summary>
+		/// Transforms the control points of the curve in place.
+		/// </summary>
+		static void Transform(LN_NurbsCurve& curve, const Matrix4d& matrix);
+
+		/// <summary>
+		/// Transforms every curve in place by the same matrix, curves are processed in parallel.
+		/// </summary>
+		static void Transform(std::vector<LN_NurbsCurve>& curves, const Matrix4d& matrix, ParallelExecutor* executor = nullptr);
+
 		/// <summary>
 		/// The NURBS Book 2nd Edition Page241
 		/// Reparameterization of curve.
 		/// </summary>
 		static void Reparametrize(const LN_NurbsCurve& curve, double min, double max, LN_NurbsCurve& result);
 
+		/// <summary>
+		/// Returns the reparameterized curve by value.
+		/// </summary>
+		static LN_NurbsCurve Reparametrize(const LN_NurbsCurve& curve, double min, double max);
+
+		/// <summary>
+		/// Consumes the curve and rescales its knot vector in place.
+		/// </summary>
+		static LN_NurbsCurve Reparametrize(LN_NurbsCurve&& curve, double min, double max);
+
 		/// <summary>
 		/// The NURBS Book 2nd Edition Page255
 		/// Reparameterization using a linear rational function : (alpha * u + beta)/(gamma * u + delta)
@@ -151,21 +388,54 @@ namespace LNLib
 		/// </summary>
 		static void Reverse(const LN_NurbsCurve& curve, LN_NurbsCurve& result);
 
+		/// <summary>
+		/// Returns the reversed curve by value.
+		/// </summary>
+		static LN_NurbsCurve Reverse(const LN_NurbsCurve& curve);
+
+		/// <summary>
+		/// Consumes the curve and reverses its knot vector and control points in place.
+		/// </summary>
+		static LN_NurbsCurve Reverse(LN_NurbsCurve&& curve);
+
 		/// <summary>
 		/// Split curve at certain parameter.
 		/// </summary>
 		static bool SplitAt(const LN_NurbsCurve& curve, double parameter, LN_NurbsCurve& left, LN_NurbsCurve& right);
 
+		/// <summary>
+		/// Split curve at several parameters with one knot refinement.
+		/// Parameters outside the open domain and repeated ones are skipped, returns the pieces in parameter order.
+		/// </summary>
+		static std::vector<LN_NurbsCurve> SplitAt(const LN_NurbsCurve& curve, const std::vector<double>& parameters);
+
 		/// <summary>
 		/// Merge two connected curves to one curve.
 		/// </summary>
 		static bool Merge(const LN_NurbsCurve& left, const LN_NurbsCurve& right, LN_NurbsCurve& result);
 
+		/// <summary>
+		/// Merge a chain of connected curves to one curve, lower degree curves are elevated to the maximum degree.
+		/// Every curve must be clamped and start at the end point of the previous one, its knots are shifted to continue the previous domain.
+		/// </summary>
+		static bool Merge(const std::vector<LN_NurbsCurve>& curves, LN_NurbsCurve& result);
+
 		/// <summary>
 		/// Offset curve makes bigger or smaller.
 		/// </summary>
 		static void Offset(const LN_NurbsCurve& curve, double offset, LN_NurbsCurve& result);
 
+		/// <summary>
+		/// Offset curve fitted to within maxError.
+		/// Offset points are sampled adaptively until the polygon deviates less than maxError between samples,
+		/// then a cubic is fitted by least squares on the knots of the curve, spans exceeding maxError are halved and refitted.
+		/// The result keeps the parameterization of the curve and stays compact.
+		/// Straight sections have no principal normal, they are offset perpendicular to the plane normal of the control polygon,
+		/// or to a fixed direction across the curve when it is a line.
+		/// Returns false when sampling or the last refinement is still outside maxError, result then holds that closest fit.
+		/// </summary>
+		static bool Offset(const LN_NurbsCurve& curve, double offset, double maxError, LN_NurbsCurve& result);
+
 		/// <summary>
 		/// Create line represented by NURBS.
 		/// </summary>
@@ -241,15 +511,26 @@ namespace LNLib
 		/// The NURBS Book 2nd Edition Page429
 		/// Algorithm A9.9
 		/// Remove knots from curve by given bound.
+		/// Candidates are taken from a priority queue of removal bounds, after each removal the curve is edited in place
+		/// and only the bounds of neighbouring knots are recomputed.
+		/// maxRemovals greater than zero stops after that many removals. Returns the number of removed knots.
+		/// cancellation is checked before every removal, see CancellationToken.
 		/// </summary>
-		static void RemoveKnotsByGivenBound(const LN_NurbsCurve& curve, const std::vector<double> params, std::vector<double>& errors, double maxError, LN_NurbsCurve& result);
+		static int RemoveKnotsByGivenBound(const LN_NurbsCurve& curve, const std::vector<double>& params, std::vector<double>& errors, double maxError, LN_NurbsCurve& result, int maxRemovals = 0, const CancellationToken* cancellation = nullptr);
 
 		/// <summary>
 		/// The NURBS Book 2nd Edition Page431
 		/// Algorithm A9.10
 		/// Global curve approximation to within bound maxError.
+		/// cancellation is checked before every knot removal, see CancellationToken.
+		/// </summary>
+		static void GlobalApproximationByErrorBound(int degree, const std::vector<XYZ>& throughPoints, double maxError, LN_NurbsCurve& result, int maxRemovals = 0, const CancellationToken* cancellation = nullptr);
+
+		/// <summary>
+		/// GlobalApproximationByErrorBound on a new thread, throughPoints are copied.
+		/// A cancelled run makes the future rethrow OperationCancelledException.
 		/// </summary>
-		static void GlobalApproximationByErrorBound(int degree, const std::vector<XYZ>& throughPoints, double maxError, LN_NurbsCurve& result);
+		static std::future<LN_NurbsCurve> GlobalApproximationByErrorBoundAsync(int degree, const std::vector<XYZ>& throughPoints, double maxError, int maxRemovals = 0, const CancellationToken* cancellation = nullptr);
 
 		/// <summary>
 		/// The NURBS Book 2nd Edition Page440
@@ -271,18 +552,39 @@ namespace LNLib
 		/// </summary>
 		static bool ControlPointReposition(const LN_NurbsCurve& curve, double parameter, int moveIndex, XYZ moveDirection, double moveDistance, LN_NurbsCurve& result);
 
+		/// <summary>
+		/// Reposition an arbitrary control point and report the part of the curve that changed.
+		/// </summary>
+		static bool ControlPointReposition(const LN_NurbsCurve& curve, double parameter, int moveIndex, XYZ moveDirection, double moveDistance, LN_NurbsCurve& result, LN_DirtyRange& dirty);
+
 		/// <summary>
 		/// The NURBS Book 2nd Edition Page520
 		/// Modify one curve weight.
 		/// </summary>
 		static void WeightModification(const LN_NurbsCurve& curve, double parameter, int moveIndex, double moveDistance, LN_NurbsCurve& result);
 
+		/// <summary>
+		/// Modify one curve weight and report the part of the curve that changed.
+		/// </summary>
+		static void WeightModification(const LN_NurbsCurve& curve, double parameter, int moveIndex, double moveDistance, LN_NurbsCurve& result, LN_DirtyRange& dirty);
+
 		/// <summary>
 		/// The NURBS Book 2nd Edition Page526
 		/// Modify two neighboring curve weights. (moveIndex and moveIndex + 1)
 		/// </summary>
 		static bool NeighborWeightsModification(const LN_NurbsCurve& curve, double parameter, int moveIndex, double moveDistance, double scale, LN_NurbsCurve& result);
 
+		/// <summary>
+		/// Modify two neighboring curve weights and report the part of the curve that changed.
+		/// </summary>
+		static bool NeighborWeightsModification(const LN_NurbsCurve& curve, double parameter, int moveIndex, double moveDistance, double scale, LN_NurbsCurve& result, LN_DirtyRange& dirty);
+
+		/// <summary>
+		/// The NURBS Book 2nd Edition Page84
+		/// Control point i only acts on [u_i, u_i+p+1), so editing firstIndex..lastIndex changes the curve on [u_firstIndex, u_lastIndex+p+1].
+		/// </summary>
+		static LN_DirtyRange GetDirtyRange(const LN_NurbsCurve& curve, int firstIndex, int lastIndex);
+
 		/// <summary>
 		/// The NURBS Book 2nd Edition Page533
 		/// </summary>
@@ -329,7 +631,7 @@ namespace LNLib
 		static void ToUnclampCurve(const LN_NurbsCurve& curve, LN_NurbsCurve& result);
 
 		/// <summary>
-		/// Detemine curve whether is linear.
+		/// Detemine curve whether is linear, all control points on the segment between the end points in order.
 		/// </summary>
 		static bool IsLinear(const LN_NurbsCurve& curve);
 
@@ -338,15 +640,40 @@ namespace LNLib
 		/// </summary>
 		static bool IsArc(const LN_NurbsCurve& curve);
 
+		/// <summary>
+		/// Detemine curve whether is a planar arc, and if so its circle.
+		/// The arc starts at the curve start and sweeps sweepAngle counterclockwise around normal, closed curves sweep 2 * Pi.
+		/// </summary>
+		static bool IsArc(const LN_NurbsCurve& curve, XYZ& center, XYZ& normal, double& radius, double& sweepAngle);
+
 		/// <summary>
 		/// Calculate curve arc length.
 		/// 
 		/// Use Simpson integration for low accuracy.
 		/// Use Gauss-Legendre integration for medium accuracy.
 		/// Use Chebyshev integration for high accuracy.
+		/// Use Gauss-Kronrod integration for adaptive accuracy within Constants::DistanceEpsilon.
 		/// </summary>
 		static double ApproximateLength(const LN_NurbsCurve& curve, IntegratorType type = IntegratorType::Chebyshev);
 
+		/// <summary>
+		/// Calculate curve arc length by adaptive Gauss-Kronrod (G7/K15) quadrature started on every Bezier segment (nonzero knot span),
+		/// segments of largest error estimate are bisected until the estimate is below tolerance or maxEvaluations is spent.
+		/// error receives the estimate when not null.
+		/// </summary>
+		static double ApproximateLength(const LN_NurbsCurve& curve, double tolerance, int maxEvaluations = 1500, double* error = nullptr);
+
+		/// <summary>
+		/// Gauss-Legendre arc length over the cached Bezier segments of a prepared curve.
+		/// Lines and arcs classified by the prepared curve take their exact length.
+		/// </summary>
+		static double ApproximateLength(const PreparedCurve& curve);
+
+		/// <summary>
+		/// Approximate length of every curve, curves are processed in parallel.
+		/// </summary>
+		static std::vector<double> ApproximateLength(const std::vector<LN_NurbsCurve>& curves, IntegratorType type = IntegratorType::Chebyshev, ParallelExecutor* executor = nullptr);
+
 		/// <summary>
 		/// Calculate parameter makes first segment length equals to given length.
 		/// </summary>
@@ -356,6 +683,22 @@ namespace LNLib
 		/// Calculate parameters makes every segments length equal to given length.
 		/// </summary>
 		static std::vector<double> GetParamsOnCurve(const LN_NurbsCurve& curve, double givenLength, IntegratorType type = IntegratorType::Chebyshev);
+
+		/// <summary>
+		/// Integrate segment lengths on intervals equal parts of every knot span, accumulate them from curve start
+		/// and store the monotone inverse s -> t.
+		/// </summary>
+		static void CreateArcLengthTable(const LN_NurbsCurve& curve, LN_ArcLengthTable& table, IntegratorType type = IntegratorType::GaussLegendre, int intervals = 16);
+
+		/// <summary>
+		/// Calculate parameter at given length from curve start by binary search and monotone cubic Hermite interpolation.
+		/// </summary>
+		static double GetParamOnCurve(const LN_ArcLengthTable& table, double givenLength);
+
+		/// <summary>
+		/// Calculate parameters makes every segments length equal to given length, table is walked once.
+		/// </summary>
+		static std::vector<double> GetParamsOnCurve(const LN_ArcLengthTable& table, double givenLength);
 	};
 }
 
@@ -12,18 +12,39 @@
 #include "LNLibDefinitions.h"
 #include "LNObject.h"
 #include "LNEnums.h"
+#include "Parallel.h"
 #include <vector>
+#include <future>
 
 namespace LNLib
 {
 	class UV;
 	class XYZ;
 	class XYZW;
+	class Matrix4d;
+	class CancellationToken;
+	class TrimLoopClassifier;
 	class LNLIB_EXPORT NurbsSurface
 	{
 	public:
 
-		static void Check(const LN_NurbsSurface& surface);
+		/// <summary>
+		/// Check surface whether fits NURBS.
+		/// Returned handle lets hot evaluations skip repeated validation.
+		/// </summary>
+		static LN_CheckedNurbsSurface Check(const LN_NurbsSurface& surface);
+
+		static void Check(const LN_FlatNurbsSurface& surface);
+
+		/// <summary>
+		/// Convert nested control points to one row-major buffer.
+		/// </summary>
+		static void ToFlatSurface(const LN_NurbsSurface& surface, LN_FlatNurbsSurface& result);
+
+		/// <summary>
+		/// Convert row-major control points back to nested rows.
+		/// </summary>
+		static void ToNestedSurface(const LN_FlatNurbsSurface& surface, LN_NurbsSurface& result);
 
 		/// <summary>
 		/// The NURBS Book 2nd Edition Page134
@@ -32,6 +53,55 @@ namespace LNLib
 		/// </summary>
 		static XYZ GetPointOnSurface(const LN_NurbsSurface& surface, UV uv);
 
+		/// <summary>
+		/// The NURBS Book 2nd Edition Page134
+		/// Algorithm A4.3
+		/// Compute point on checked rational B-spline surface without argument validation.
+		/// uv must lie in the knot vector ranges.
+		/// </summary>
+		static XYZ GetPointOnSurface(const LN_CheckedNurbsSurface& surface, UV uv);
+
+		/// <summary>
+		/// The NURBS Book 2nd Edition Page134
+		/// Algorithm A4.3
+		/// Compute point on rational B-spline surface with row-major control points.
+		/// </summary>
+		static XYZ GetPointOnSurface(const LN_FlatNurbsSurface& surface, UV uv);
+
+		/// <summary>
+		/// The NURBS Book 2nd Edition Page134
+		/// Algorithm A4.3
+		/// Compute point on a surface in GeometryStore memory, knots and control points are read in place.
+		/// </summary>
+		static XYZ GetPointOnSurface(const LN_StoredNurbsSurface& surface, UV uv);
+
+		/// <summary>
+		/// The NURBS Book 2nd Edition Page134
+		/// Algorithm A4.3
+		/// Compute points on rational B-spline surface at every (uParams[i], vParams[j]).
+		/// Basis functions of each row and column are computed once, points[i][j] is S(uParams[i], vParams[j]).
+		/// </summary>
+		static void EvaluateGrid(const LN_NurbsSurface& surface, const std::vector<double>& uParams, const std::vector<double>& vParams, std::vector<std::vector<XYZ>>& points);
+
+		/// <summary>
+		/// The NURBS Book 2nd Edition Page134
+		/// Algorithm A4.3
+		/// Compute points on checked rational B-spline surface at every (uParams[i], vParams[j]) without argument validation.
+		/// </summary>
+		static void EvaluateGrid(const LN_CheckedNurbsSurface& surface, const std::vector<double>& uParams, const std::vector<double>& vParams, std::vector<std::vector<XYZ>>& points);
+
+		/// <summary>
+		/// The NURBS Book 2nd Edition Page137
+		/// Compute points and unit normals at every (uParams[i], vParams[j]).
+		/// Basis functions and their first derivatives of each row and column are computed once like EvaluateGrid.
+		/// </summary>
+		static void EvaluateNormalGrid(const LN_NurbsSurface& surface, const std::vector<double>& uParams, const std::vector<double>& vParams, std::vector<std::vector<XYZ>>& points, std::vector<std::vector<XYZ>>& normals);
+
+		/// <summary>
+		/// Compute points and unit normals of checked surface at every (uParams[i], vParams[j]) without argument validation.
+		/// </summary>
+		static void EvaluateNormalGrid(const LN_CheckedNurbsSurface& surface, const std::vector<double>& uParams, const std::vector<double>& vParams, std::vector<std::vector<XYZ>>& points, std::vector<std::vector<XYZ>>& normals);
+
 		/// <summary>
 		/// The NURBS Book 2nd Edition Page137
 		/// Algorithm A4.4
@@ -39,8 +109,35 @@ namespace LNLib
 		/// </summary>
 		static std::vector<std::vector<XYZ>> ComputeRationalSurfaceDerivatives(const LN_NurbsSurface& surface, int derivative, UV uv);
 
+		/// <summary>
+		/// The NURBS Book 2nd Edition Page137
+		/// Algorithm A4.4
+		/// Compute derivatives of checked surface without argument validation.
+		/// derivative must greater than zero and uv must lie in the knot vector ranges.
+		/// </summary>
+		static std::vector<std::vector<XYZ>> ComputeRationalSurfaceDerivatives(const LN_CheckedNurbsSurface& surface, int derivative, UV uv);
+
+		/// <summary>
+		/// Non-throwing point evaluation of checked surface, uv outside the domain fails or is clamped by policy.
+		/// point is only written on Success.
+		/// </summary>
+		static EvaluationStatus TryGetPointOnSurface(const LN_CheckedNurbsSurface& surface, UV uv, XYZ& point, ParameterRangePolicy policy = ParameterRangePolicy::Fail) noexcept;
+
+		/// <summary>
+		/// Non-throwing form of the checked derivatives, derivative must greater than zero.
+		/// derivatives is only written on Success.
+		/// </summary>
+		static EvaluationStatus TryComputeRationalSurfaceDerivatives(const LN_CheckedNurbsSurface& surface, int derivative, UV uv, std::vector<std::vector<XYZ>>& derivatives, ParameterRangePolicy policy = ParameterRangePolicy::Fail) noexcept;
+
 		static double Curvature(const LN_NurbsSurface& surface, SurfaceCurvature curvature, UV uv);
 
+		/// <summary>
+		/// The NURBS Book 2nd Edition Page137
+		/// Compute all curvatures at every (uParams[i], vParams[j]) from one set of second derivatives per point.
+		/// Basis functions are computed once per row and column, rows are processed in parallel.
+		/// </summary>
+		static void EvaluateCurvatureGrid(const LN_NurbsSurface& surface, const std::vector<double>& uParams, const std::vector<double>& vParams, std::vector<std::vector<LN_SurfaceCurvature>>& curvatures, ParallelExecutor* executor = nullptr);
+
 		static XYZ Normal(const LN_NurbsSurface& surface, UV uv);
 
 		/// <summary>
@@ -48,11 +145,26 @@ namespace LNLib
 		/// </summary>
 		static void Swap(const LN_NurbsSurface& surface, LN_NurbsSurface& result);
 
+		/// <summary>
+		/// Returns the UV swapped surface by value.
+		/// </summary>
+		static LN_NurbsSurface Swap(const LN_NurbsSurface& surface);
+
 		/// <summary>
 		/// Reverse surface U or V direction.
 		/// </summary>
 		static void Reverse(const LN_NurbsSurface& surface, SurfaceDirection direction,  LN_NurbsSurface& result);
 
+		/// <summary>
+		/// Returns the reversed surface by value.
+		/// </summary>
+		static LN_NurbsSurface Reverse(const LN_NurbsSurface& surface, SurfaceDirection direction);
+
+		/// <summary>
+		/// Consumes the surface and reverses its knot vectors and control points in place.
+		/// </summary>
+		static LN_NurbsSurface Reverse(LN_NurbsSurface&& surface, SurfaceDirection direction);
+
 		/// <summary>
 		/// The NURBS Book 2nd Edition Page137
 		/// Algorithm A5.3
@@ -60,6 +172,24 @@ namespace LNLib
 		/// </summary>
 		static void InsertKnot(const LN_NurbsSurface& surface, double insertKnot, int times, bool isUDirection, LN_NurbsSurface& result);
 
+		/// <summary>
+		/// Moves the surface into result before inserting, so the input buffers are reused.
+		/// </summary>
+		static void InsertKnot(LN_NurbsSurface&& surface, double insertKnot, int times, bool isUDirection, LN_NurbsSurface& result);
+
+		/// <summary>
+		/// In-place surface knot insertion along U or V direction.
+		/// Grows the existing rows (U) or every row (V) and shifts the unaffected tail.
+		/// </summary>
+		static void InsertKnot(LN_NurbsSurface& surface, double insertKnot, int times, bool isUDirection);
+
+		/// <summary>
+		/// The NURBS Book 2nd Edition Page137
+		/// Algorithm A5.3
+		/// Surface knot insertion along U or V direction on row-major control points.
+		/// </summary>
+		static void InsertKnot(const LN_FlatNurbsSurface& surface, double insertKnot, int times, bool isUDirection, LN_FlatNurbsSurface& result);
+
 		/// <summary>
 		/// The NURBS Book 2nd Edition Page167
 		/// Algorithm A5.5
@@ -67,6 +197,22 @@ namespace LNLib
 		/// </summary>
 		static void RefineKnotVector(const LN_NurbsSurface& surface, std::vector<double>& insertKnotElements, bool isUDirection, LN_NurbsSurface& result);
 
+		/// <summary>
+		/// Moves the surface into result before refining, so the input buffers are reused.
+		/// </summary>
+		static void RefineKnotVector(LN_NurbsSurface&& surface, std::vector<double>& insertKnotElements, bool isUDirection, LN_NurbsSurface& result);
+
+		/// <summary>
+		/// In-place surface knot refinement along U or V direction, without transposing the control points.
+		/// </summary>
+		static void RefineKnotVector(LN_NurbsSurface& surface, const std::vector<double>& insertKnotElements, bool isUDirection);
+
+		/// <summary>
+		/// Split surface at several parameters along U or V direction with one knot refinement.
+		/// Parameters outside the open domain and repeated ones are skipped, returns the pieces in parameter order.
+		/// </summary>
+		static std::vector<LN_NurbsSurface> SplitAt(const LN_NurbsSurface& surface, const std::vector<double>& parameters, bool isUDirection);
+
 		/// <summary>
 		/// The NURBS Book 2nd Edition Page177
 		/// Algorithm A5.7
@@ -74,6 +220,61 @@ namespace LNLib
 		/// </summary>
 		static std::vector<LN_NurbsSurface> DecomposeToBeziers(const LN_NurbsSurface& surface);
 
+		/// <summary>
+		/// Decompose every surface into Bezier patches, surfaces are processed in parallel.
+		/// </summary>
+		static std::vector<std::vector<LN_NurbsSurface>> DecomposeToBeziers(const std::vector<LN_NurbsSurface>& surfaces, ParallelExecutor* executor = nullptr);
+
+		/// <summary>
+		/// Decompose surface into Bezier patches stored in one control point buffer with a domain table.
+		/// </summary>
+		static void DecomposeToBeziers(const LN_NurbsSurface& surface, LN_BezierPatchArray& patches);
+
+		/// <summary>
+		/// Offset surface along Normal approximated to within tolerance at the samples.
+		/// Offset points are evaluated per knot span patch in parallel and fitted by a bicubic GlobalApproximation,
+		/// control points and samples per span are doubled until the fit is within tolerance.
+		/// Surface normals must be defined everywhere.
+		/// Returns false when the approximation fails or the last refinement is still outside tolerance,
+		/// result then holds the last successful fit or is left unchanged when there is none.
+		/// </summary>
+		static bool Offset(const LN_NurbsSurface& surface, double offset, double tolerance, LN_NurbsSurface& result, ParallelExecutor* executor = nullptr);
+
+		/// <summary>
+		/// Surface make Transform.
+		/// </summary>
+		static LN_NurbsSurface CreateTransformed(const LN_NurbsSurface& surface, const Matrix4d& matrix);
+
+		/// <summary>
+		/// Consumes the surface and transforms its control points in place.
+		/// </summary>
+		static LN_NurbsSurface CreateTransformed(LN_NurbsSurface&& surface, const Matrix4d& matrix);
+
+		/// <summary>
+		/// Returns every surface transformed by the same matrix, surfaces are processed in parallel.
+		/// </summary>
+		static std::vector<LN_NurbsSurface> CreateTransformed(const std::vector<LN_NurbsSurface>& surfaces, const Matrix4d& matrix, ParallelExecutor* executor = nullptr);
+
+		/// <summary>
+		/// Transforms the control points of the surface in place.
+		/// </summary>
+		static void Transform(LN_NurbsSurface& surface, const Matrix4d& matrix);
+
+		/// <summary>
+		/// Transforms every surface in place by the same matrix, surfaces are processed in parallel.
+		/// </summary>
+		static void Transform(std::vector<LN_NurbsSurface>& surfaces, const Matrix4d& matrix, ParallelExecutor* executor = nullptr);
+
+		/// <summary>
+		/// Conservative bounding box of the control net.
+		/// </summary>
+		static LN_BoundingBox GetBoundingBox(const LN_NurbsSurface& surface);
+
+		/// <summary>
+		/// Conservative bounding box of every Bezier patch, box p covers span (p / patchesV, p % patchesV) of the distinct knots.
+		/// </summary>
+		static std::vector<LN_BoundingBox> GetSpanBoundingBoxes(const LN_NurbsSurface& surface);
+
 		/// <summary>
 		/// The NURBS Book 2nd Edition Page186
 		/// Surface knot removal.
@@ -84,8 +285,15 @@ namespace LNLib
 		/// The NURBS Book 2nd Edition Page209
 		/// Algorithm A5.10
 		/// Degree elevate a surface t times.
+		/// The elevation coefficients and knot vector are computed once and applied to all rows (or columns) of the net in place,
+		/// blocks of rows are elevated in parallel.
+		/// </summary>
+		static void ElevateDegree(const LN_NurbsSurface& surface, int times, bool isUDirection, LN_NurbsSurface& result, ParallelExecutor* executor = nullptr);
+
+		/// <summary>
+		/// Returns the degree elevated surface by value.
 		/// </summary>
-		static void ElevateDegree(const LN_NurbsSurface& surface, int times, bool isUDirection, LN_NurbsSurface& result);
+		static LN_NurbsSurface ElevateDegree(const LN_NurbsSurface& surface, int times, bool isUDirection, ParallelExecutor* executor = nullptr);
 
 		/// <summary>
 		/// The NURBS Book 2nd Edition Page227
@@ -99,6 +307,38 @@ namespace LNLib
 		/// </summary>
 		static void EquallyTessellate(const LN_NurbsSurface& surface, std::vector<XYZ>& tessellatedPoints, std::vector<UV>& correspondingKnots);
 
+		/// <summary>
+		/// The NURBS Book 2nd Edition Page232
+		/// Equally spaced parameter values on each candidate span, intervals samples per span.
+		/// The sample grid is split into tiles evaluated in parallel by executor (internal worker threads when null).
+		/// Outputs are resized once and every tile writes its own range, grid point (i,j) at i * columns + j, last point is S(1,1).
+		/// </summary>
+		static void EquallyTessellate(const LN_NurbsSurface& surface, int intervals, std::vector<XYZ>& tessellatedPoints, std::vector<UV>& correspondingKnots, ParallelExecutor* executor = nullptr);
+
+		/// <summary>
+		/// Adaptive quadtree tessellation on each Bezier patch (nonzero knot span cell).
+		/// A cell is split into four while its edge middles or center deviate from the bilinear corners more than chordTolerance,
+		/// or corner normals turn more than normalTolerance (radians) from the center normal.
+		/// Vertices on shared edges are welded and cells take the vertices of finer neighbors on their edges, so the mesh is crack-free.
+		/// Triangles are appended to mesh, indices start after its existing vertices.
+		/// </summary>
+		static void Tessellate(const LN_NurbsSurface& surface, double chordTolerance, double normalTolerance, LN_Mesh& mesh);
+
+		/// <summary>
+		/// Adaptive quadtree tessellation of the part of surface inside the loops of trim.
+		/// Cells are classified against the loops before any flatness test: cells outside are dropped with their vertices,
+		/// cells inside are meshed as by the untrimmed Tessellate and only cells crossed by a loop are refined,
+		/// down to the trim tolerance in parameter space, where triangles are kept when their parameter centroid is inside.
+		/// The mesh stays crack-free, its border follows the loops within the size of the finest boundary cells.
+		/// </summary>
+		static void Tessellate(const LN_NurbsSurface& surface, const TrimLoopClassifier& trim, double chordTolerance, double normalTolerance, LN_Mesh& mesh);
+
+		/// <summary>
+		/// Tessellation of the trimmed surface with a TrimLoopClassifier built from its loops with trimTolerance.
+		/// A surface without loops is tessellated whole.
+		/// </summary>
+		static void Tessellate(const LN_TrimmedSurface& surface, double chordTolerance, double normalTolerance, double trimTolerance, LN_Mesh& mesh);
+
 		///  [0][0]  [0][1] ... ...  [0][m]     ------- v direction
 		///  [1][0]  [1][1] ... ...  [1][m]    |
 		///    .                               |
@@ -113,8 +353,24 @@ namespace LNLib
 		/// </summary>
 		static UV GetParamOnSurface(const LN_NurbsSurface& surface, const XYZ& givenPoint);
 
+		/// <summary>
+		/// The NURBS Book 2nd Edition Page232
+		/// Point inversion with the given tolerances and iteration cap.
+		/// </summary>
+		static UV GetParamOnSurface(const LN_NurbsSurface& surface, const XYZ& givenPoint, const LN_ProjectionOptions& options);
+
 		static void Reparametrize(const LN_NurbsSurface& surface, double minU, double maxU, double minV, double maxV, LN_NurbsSurface& result);
 
+		/// <summary>
+		/// Returns the reparameterized surface by value.
+		/// </summary>
+		static LN_NurbsSurface Reparametrize(const LN_NurbsSurface& surface, double minU, double maxU, double minV, double maxV);
+
+		/// <summary>
+		/// Consumes the surface and rescales its knot vectors in place.
+		/// </summary>
+		static LN_NurbsSurface Reparametrize(LN_NurbsSurface&& surface, double minU, double maxU, double minV, double maxV);
+
 		/// <summary>
 		/// The NURBS Book 2nd Edition Page235
 		/// Surface Tangent Vector Inversion: finding the corresponding UV tangent [du dv] make T = Su*du+Sv*dv.
@@ -167,8 +423,10 @@ namespace LNLib
 		/// The NURBS Book 2nd Edition Page380
 		/// Algorithm A9.4
 		/// Global surface interpolation.
+		/// Both collocation matrices are factored once, columns and then rows are back substituted in parallel chunks.
+		/// cancellation is checked by every parallel task, see CancellationToken.
 		/// </summary>
-		static void GlobalInterpolation(const std::vector<std::vector<XYZ>>& throughPoints, int degreeU, int degreeV, LN_NurbsSurface& surface);
+		static void GlobalInterpolation(const std::vector<std::vector<XYZ>>& throughPoints, int degreeU, int degreeV, LN_NurbsSurface& surface, ParallelExecutor* executor = nullptr, const CancellationToken* cancellation = nullptr);
 
 		/// <summary>
 		/// The NURBS Book 2nd Edition Page404
@@ -181,8 +439,17 @@ namespace LNLib
 		/// The NURBS Book 2nd Edition Page422
 		/// Algorithm A9.7
 		/// Global surface approximation with fixed number of control points.
+		/// Normal matrices are assembled banded and Cholesky factored once for all columns and rows.
+		/// cancellation is checked by every parallel task, see CancellationToken.
+		/// </summary>
+		static bool GlobalApproximation(const std::vector<std::vector<XYZ>>& throughPoints, int degreeU, int degreeV, int controlPointsRows, int controlPointsColumns, LN_NurbsSurface& surface, ParallelExecutor* executor = nullptr, const CancellationToken* cancellation = nullptr);
+
+		/// <summary>
+		/// GlobalApproximation on a new thread, throughPoints are copied and executor must accept calls from that thread.
+		/// A failed approximation makes the future throw std::runtime_error,
+		/// a cancelled run makes it rethrow OperationCancelledException.
 		/// </summary>
-		static bool GlobalApproximation(const std::vector<std::vector<XYZ>>& throughPoints, int degreeU, int degreeV, int controlPointsRows, int controlPointsColumns, LN_NurbsSurface& surface);
+		static std::future<LN_NurbsSurface> GlobalApproximationAsync(const std::vector<std::vector<XYZ>>& throughPoints, int degreeU, int degreeV, int controlPointsRows, int controlPointsColumns, ParallelExecutor* executor = nullptr, const CancellationToken* cancellation = nullptr);
 
 		/// <summary>
 		/// The NURBS Book 2nd Edition Page456
@@ -195,15 +462,19 @@ namespace LNLib
 		/// <summary>
 		/// The NURBS Book 2nd Edition Page457
 		/// Create Loft Surface (called Skinned Surfaces in The NURBS Book).
+		/// Sections are elevated to their maximum degree and refined to the union of their knot vectors in parallel,
+		/// the columns are interpolated with one factored collocation matrix.
+		/// cancellation is checked by every parallel task, see CancellationToken.
 		/// </summary>
-		static void CreateLoftSurface(const std::vector<LN_NurbsCurve>& sections, LN_NurbsSurface& surface);
+		static void CreateLoftSurface(const std::vector<LN_NurbsCurve>& sections, LN_NurbsSurface& surface, ParallelExecutor* executor = nullptr, const CancellationToken* cancellation = nullptr);
 
 		/// <summary>
 		/// The NURBS Book 2nd Edition Page472
 		/// Algorithm A10.2
 		/// Create Sweep Surface.
+		/// Profiles are placed along path in parallel.
 		/// </summary>
-		static void CreateSweepSurface(const LN_NurbsCurve& path, const std::vector<LN_NurbsCurve>& profiles, LN_NurbsSurface& surface);
+		static void CreateSweepSurface(const LN_NurbsCurve& path, const std::vector<LN_NurbsCurve>& profiles, LN_NurbsSurface& surface, ParallelExecutor* executor = nullptr);
 
 		/// <summary>
 		/// The NURBS Book 2nd Edition Page494
@@ -215,8 +486,15 @@ namespace LNLib
 		/// 3. There must be N curves along one direction, and M curves along another direction, which must exactly intersect at N x M points.
 		/// 4. Intersection points must be located evenly in parameter spaces of curves. 
 		/// 5. U-curves must be ordered along direction of V-curves, and vice versa. 
+		/// cancellation is checked by the parallel tasks of the section, loft and interpolation stages and between all stages, see CancellationToken.
+		/// </summary>
+		static void CreateGordonSurface(const std::vector<LN_NurbsCurve>& uCurves, const std::vector<LN_NurbsCurve>& vCurves, const std::vector<std::vector<XYZ>>& intersectionPoints, LN_NurbsSurface& surface, ParallelExecutor* executor = nullptr, const CancellationToken* cancellation = nullptr);
+
+		/// <summary>
+		/// CreateGordonSurface on a new thread, the inputs are copied and executor must accept calls from that thread.
+		/// A cancelled run makes the future rethrow OperationCancelledException.
 		/// </summary>
-		static void CreateGordonSurface(const std::vector<LN_NurbsCurve>& uCurves, const std::vector<LN_NurbsCurve>& vCurves, const std::vector<std::vector<XYZ>>& intersectionPoints, LN_NurbsSurface& surface);
+		static std::future<LN_NurbsSurface> CreateGordonSurfaceAsync(const std::vector<LN_NurbsCurve>& uCurves, const std::vector<LN_NurbsCurve>& vCurves, const std::vector<std::vector<XYZ>>& intersectionPoints, ParallelExecutor* executor = nullptr, const CancellationToken* cancellation = nullptr);
 
 		/// <summary>
 		/// The NURBS Book 2nd Edition Page502
@@ -237,7 +515,31 @@ namespace LNLib
 		/// Use Simpson integration for low accuracy.
 		/// Use Gauss-Legendre integration for medium accuracy.
 		/// Use Chebyshev integration for high accuracy.
+		/// Use Gauss-Kronrod integration for adaptive accuracy within Constants::DistanceEpsilon.
 		/// </summary>
 		static double ApproximateArea(const LN_NurbsSurface& surface, IntegratorType type = IntegratorType::Chebyshev);
+
+		/// <summary>
+		/// Calculate surface area by adaptive tensor product Gauss-Kronrod (G7/K15) quadrature started on every Bezier patch.
+		/// The error of a cell is estimated by the embedded Gauss rule in each direction, the cell of largest estimate is
+		/// bisected in its worse direction until the summed estimate is below tolerance or one more bisection exceeds maxEvaluations.
+		/// error receives the estimate when not null, cancellation is checked before every bisection.
+		/// </summary>
+		static double ApproximateArea(const LN_NurbsSurface& surface, double tolerance, int maxEvaluations, double* error = nullptr, const CancellationToken* cancellation = nullptr);
+
+		/// <summary>
+		/// Calculate surface area by tensor product Gauss-Legendre quadrature on every Bezier patch (nonzero knot span cell),
+		/// first partial derivatives of each quadrature grid are evaluated with shared basis functions.
+		/// A patch is split into four while the split result differs from the whole one more than tolerance times its area.
+		/// Patches are integrated in parallel by executor (internal worker threads when null).
+		/// cancellation is checked before every split, see CancellationToken.
+		/// </summary>
+		static double ApproximateArea(const LN_NurbsSurface& surface, double tolerance, ParallelExecutor* executor = nullptr, const CancellationToken* cancellation = nullptr);
+
+		/// <summary>
+		/// The parallel ApproximateArea on a new thread, surface is copied and executor must accept calls from that thread.
+		/// A cancelled run makes the future rethrow OperationCancelledException.
+		/// </summary>
+		static std::future<double> ApproximateAreaAsync(const LN_NurbsSurface& surface, double tolerance, ParallelExecutor* executor = nullptr, const CancellationToken* cancellation = nullptr);
 	};
 }
@@ -0,0 +1,100 @@
+/*
+ * Author:
+ * 2024/10/14 - Yuqing Liang (BIMCoder Liang)
+ * bim.frankliang@foxmail.com
+ * 微信公众号：BIMCoder梁老师
+ *
+ * Use of this source code is governed by a GPL-3.0 license that can be found in
+ * the LICENSE file.
+ */
+
+#pragma once
+#include "LNLibDefinitions.h"
+#include <vector>
+
+namespace LNLib
+{
+	/// <summary>
+	/// One unit of work, called once for every task index.
+	/// Different task indices may run concurrently.
+	/// </summary>
+	class LNLIB_EXPORT ParallelTask
+	{
+	public:
+		virtual ~ParallelTask() = default;
+		virtual void operator()(int taskIndex) = 0;
+	};
+
+	/// <summary>
+	/// User supplied scheduler, must call task(i) exactly once for each i in [0, taskCount)
+	/// and return after all of them finished.
+	/// </summary>
+	class LNLIB_EXPORT ParallelExecutor
+	{
+	public:
+		virtual ~ParallelExecutor() = default;
+		virtual void Execute(int taskCount, ParallelTask& task) = 0;
+	};
+
+	/// <summary>
+	/// Every static method of LNLib is reentrant: none keeps mutable state shared between calls,
+	/// so calls from different threads are safe as long as no thread modifies an input another thread reads.
+	/// Objects queried through const methods (PreparedCurve, PreparedSurface, CurveProjector, SurfaceProjector)
+	/// may be shared, prepared objects fill their lazy caches thread safely.
+	/// MonotonicArena, output arguments and the series workspace of Integrator::ClenshawCurtisQuadrature must not be shared.
+	/// </summary>
+	class LNLIB_EXPORT Parallel
+	{
+	public:
+
+		/// <summary>
+		/// Number of hardware threads, at least one.
+		/// </summary>
+		static int GetThreadCount();
+
+		/// <summary>
+		/// Run task(0) to task(taskCount - 1) on internal worker threads.
+		/// Every worker starts on its own contiguous slice of indices and steals half of the largest
+		/// remaining slice of another worker when it runs dry, so uneven tasks still balance.
+		/// threadCount not greater than zero means GetThreadCount().
+		/// The first exception thrown by a task is rethrown after all workers joined.
+		/// </summary>
+		static void For(int taskCount, ParallelTask& task, int threadCount = 0);
+
+		/// <summary>
+		/// Run with executor when it is not null, otherwise with internal worker threads.
+		/// </summary>
+		static void For(int taskCount, ParallelTask& task, ParallelExecutor* executor);
+
+		/// <summary>
+		/// Call function(items[i], i) for every item, scheduled like For.
+		/// function must only write to state owned by index i.
+		/// </summary>
+		template <typename T, typename Function>
+		static void ForEach(const std::vector<T>& items, Function& function, ParallelExecutor* executor = nullptr)
+		{
+			ForEachTask<T, Function> task(items, function);
+			For(static_cast<int>(items.size()), task, executor);
+		}
+
+	private:
+
+		template <typename T, typename Function>
+		class ForEachTask : public ParallelTask
+		{
+		public:
+			ForEachTask(const std::vector<T>& items, Function& function) : _items(items), _function(function)
+			{
+			}
+
+			void operator()(int taskIndex) override
+			{
+				_function(_items[taskIndex], taskIndex);
+			}
+
+		private:
+			const std::vector<T>& _items;
+			Function& _function;
+		};
+	};
+}
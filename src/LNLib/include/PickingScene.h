@@ -0,0 +1,58 @@
+/*
+ * Author:
+ * 2024/10/14 - Yuqing Liang (BIMCoder Liang)
+ * bim.frankliang@foxmail.com
+ * 微信公众号：BIMCoder梁老师
+ *
+ * Use of this source code is governed by a GPL-3.0 license that can be found in
+ * the LICENSE file.
+ */
+
+#pragma once
+#include "LNLibDefinitions.h"
+#include "LNObject.h"
+#include "BoundingVolumeHierarchy.h"
+#include <vector>
+#include <memory>
+
+namespace LNLib
+{
+	class XYZ;
+	class PreparedCurve;
+	class PreparedSurface;
+
+	/// <summary>
+	/// Ray picking over many surfaces and curves.
+	/// Every object is prepared once and a bounding volume hierarchy is built over the control net boxes,
+	/// a pick walks it front to back and only intersects objects whose box is entered before the nearest hit so far,
+	/// using the cached Bezier decomposition of each object.
+	/// The scene is read-only after construction, so picks can run concurrently.
+	/// </summary>
+	class LNLIB_EXPORT PickingScene
+	{
+	public:
+
+		PickingScene(const std::vector<LN_NurbsSurface>& surfaces, const std::vector<LN_NurbsCurve>& curves);
+		~PickingScene();
+
+		PickingScene(const PickingScene&) = delete;
+		PickingScene& operator=(const PickingScene&) = delete;
+
+		int GetSurfaceCount() const;
+
+		int GetCurveCount() const;
+
+		/// <summary>
+		/// Nearest hit of the ray origin + t * direction, t >= 0.
+		/// Surfaces are hit within tolerance, curves when the ray passes within tolerance of them.
+		/// Returns false when nothing is hit.
+		/// </summary>
+		bool Pick(const XYZ& origin, const XYZ& direction, double tolerance, LN_PickResult& result) const;
+
+	private:
+
+		std::vector<std::unique_ptr<PreparedSurface>> _surfaces;
+		std::vector<std::unique_ptr<PreparedCurve>> _curves;
+		BoundingVolumeHierarchy _hierarchy;
+	};
+}
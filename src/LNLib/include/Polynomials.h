@@ -12,6 +12,7 @@
 
 #include "LNLibDefinitions.h"
 #include <vector>
+#include <array>
 #include <unordered_map>
 
 namespace LNLib
@@ -42,6 +43,11 @@ namespace LNLib
 		/// </summary>
 		static std::vector<double> AllBernstein(int degree, double paramT);
 
+		/// <summary>
+		/// AllBernstein writing degree + 1 values into bernsteinArray.
+		/// </summary>
+		static void AllBernstein(int degree, double paramT, double* bernsteinArray);
+
 		/// <summary>
 		/// The NURBS Book 2nd Edition Page36
 		/// Algorithm A1.6
@@ -71,6 +77,22 @@ namespace LNLib
 		/// </summary>
 		static int GetKnotSpanIndex(int degree, const std::vector<double>& knotVector, double paramT);
 
+		/// <summary>
+		/// The NURBS Book 2nd Edition Page68
+		/// Algorithm A2.1
+		/// Determine the knot span index in knotCount knots read in place, such as stored geometry.
+		/// knotVector is not validated.
+		/// </summary>
+		static int GetKnotSpanIndex(int degree, const double* knotVector, int knotCount, double paramT);
+
+		/// <summary>
+		/// The NURBS Book 2nd Edition Page68
+		/// Algorithm A2.1
+		/// Determine the knot span index by walking from a previously found span.
+		/// Suited to monotone parameter sequences, knotVector is not validated.
+		/// </summary>
+		static int GetKnotSpanIndex(int degree, const std::vector<double>& knotVector, double paramT, int startSpanIndex);
+
 		/// <summary>
 		/// The NURBS Book 2nd Edition Page70
 		/// Algorithm A2.2
@@ -78,6 +100,22 @@ namespace LNLib
 		/// </summary>
 		static std::vector<double> BasisFunctions(int spanIndex, int degree, const std::vector<double>& knotVector, double paramT);
 
+		/// <summary>
+		/// The NURBS Book 2nd Edition Page70
+		/// Algorithm A2.2
+		/// Compute the nonvanishing basis functions into caller owned buffer with (degree + 1) values.
+		/// Degree 1 to 3 dispatch to the fixed degree kernels.
+		/// Arguments are not validated, callers check the knot vector once.
+		/// </summary>
+		static void BasisFunctions(int spanIndex, int degree, const std::vector<double>& knotVector, double paramT, double* basisFunctions);
+
+		/// <summary>
+		/// The NURBS Book 2nd Edition Page70
+		/// Algorithm A2.2
+		/// BasisFunctions on knots read in place, arguments are not validated.
+		/// </summary>
+		static void BasisFunctions(int spanIndex, int degree, const double* knotVector, double paramT, double* basisFunctions);
+
 		/// <summary>
 		/// The NURBS Book 2nd Edition Page72
 		/// Algorithm A2.3
@@ -85,6 +123,130 @@ namespace LNLib
 		/// </summary>
 		static std::vector<std::vector<double>> BasisFunctionsDerivatives(int spanIndex, int degree, int derivative, const std::vector<double>& knotVector, double paramT);
 
+		/// <summary>
+		/// The NURBS Book 2nd Edition Page72
+		/// Algorithm A2.3
+		/// Compute nonzero basis functions and their derivative into caller owned buffer,
+		/// kth derivative of jth function at derivatives[k * (degree + 1) + j].
+		/// Degree 1 to 3 dispatch to the fixed degree kernels.
+		/// Arguments are not validated, callers check the knot vector once.
+		/// </summary>
+		static void BasisFunctionsDerivatives(int spanIndex, int degree, int derivative, const std::vector<double>& knotVector, double paramT, double* derivatives);
+
+		/// <summary>
+		/// The NURBS Book 2nd Edition Page70
+		/// Algorithm A2.2
+		/// Fixed degree version with loops bounded at compile time, knotVector is a std::vector or a pointer to knots.
+		/// </summary>
+		template <int Degree, typename KnotArray>
+		static void BasisFunctions(int spanIndex, const KnotArray& knotVector, double paramT, double* basisFunctions)
+		{
+			std::array<double, Degree + 1> left;
+			std::array<double, Degree + 1> right;
+
+			basisFunctions[0] = 1.0;
+			for (int j = 1; j <= Degree; j++)
+			{
+				left[j] = paramT - knotVector[spanIndex + 1 - j];
+				right[j] = knotVector[spanIndex + j] - paramT;
+
+				double saved = 0.0;
+				for (int r = 0; r < j; r++)
+				{
+					double temp = basisFunctions[r] / (right[r + 1] + left[j - r]);
+					basisFunctions[r] = saved + right[r + 1] * temp;
+					saved = left[j - r] * temp;
+				}
+				basisFunctions[j] = saved;
+			}
+		}
+
+		/// <summary>
+		/// The NURBS Book 2nd Edition Page72
+		/// Algorithm A2.3
+		/// Fixed degree version with std::array storage, derivative must not greater than Degree.
+		/// </summary>
+		template <int Degree>
+		static void BasisFunctionsDerivatives(int spanIndex, int derivative, const std::vector<double>& knotVector, double paramT, double* derivatives)
+		{
+			std::array<std::array<double, Degree + 1>, Degree + 1> ndu;
+			std::array<double, Degree + 1> left;
+			std::array<double, Degree + 1> right;
+
+			ndu[0][0] = 1.0;
+			for (int j = 1; j <= Degree; j++)
+			{
+				left[j] = paramT - knotVector[spanIndex + 1 - j];
+				right[j] = knotVector[spanIndex + j] - paramT;
+
+				double saved = 0.0;
+				for (int r = 0; r < j; r++)
+				{
+					ndu[j][r] = right[r + 1] + left[j - r];
+					double temp = ndu[r][j - 1] / ndu[j][r];
+
+					ndu[r][j] = saved + right[r + 1] * temp;
+					saved = left[j - r] * temp;
+				}
+				ndu[j][j] = saved;
+			}
+
+			for (int j = 0; j <= Degree; j++)
+			{
+				derivatives[j] = ndu[j][Degree];
+			}
+
+			std::array<std::array<double, Degree + 1>, 2> a;
+			for (int r = 0; r <= Degree; r++)
+			{
+				int s1 = 0;
+				int s2 = 1;
+				a[0][0] = 1.0;
+
+				for (int k = 1; k <= derivative; k++)
+				{
+					double d = 0.0;
+					int rk = r - k;
+					int pk = Degree - k;
+
+					if (r >= k)
+					{
+						a[s2][0] = a[s1][0] / ndu[pk + 1][rk];
+						d = a[s2][0] * ndu[rk][pk];
+					}
+
+					int j1 = rk >= -1 ? 1 : -rk;
+					int j2 = (r - 1 <= pk) ? k - 1 : Degree - r;
+
+					for (int j = j1; j <= j2; j++)
+					{
+						a[s2][j] = (a[s1][j] - a[s1][j - 1]) / ndu[pk + 1][rk + j];
+						d += a[s2][j] * ndu[rk + j][pk];
+					}
+					if (r <= pk)
+					{
+						a[s2][k] = -a[s1][k - 1] / ndu[pk + 1][r];
+						d += a[s2][k] * ndu[r][pk];
+					}
+					derivatives[k * (Degree + 1) + r] = d;
+
+					int temp = s1;
+					s1 = s2;
+					s2 = temp;
+				}
+			}
+
+			int factor = Degree;
+			for (int k = 1; k <= derivative; k++)
+			{
+				for (int j = 0; j <= Degree; j++)
+				{
+					derivatives[k * (Degree + 1) + j] *= factor;
+				}
+				factor *= Degree - k;
+			}
+		}
+
 		/// <summary>
 		/// The NURBS Book 2nd Edition Page74
 		/// Algorithm A2.4
@@ -118,9 +280,35 @@ namespace LNLib
 		/// Compute inverse of pth-degree Bezier matrix.
 		/// </summary>
 		static std::vector<std::vector<double>> PowerToBezierMatrix(int degree, const std::vector<std::vector<double>>& matrix);
+
+		/// <summary>
+		/// The NURBS Book 2nd Edition Page206
+		/// Coefficients bezalfs of Algorithm A5.9, the Bezier points of degree + times are sum of bezalfs[i][j] * P[j].
+		/// </summary>
+		static std::vector<std::vector<double>> BezierDegreeElevationMatrix(int degree, int times);
 	};
 
-}
+	/// <summary>
+	/// Remembers the last found knot span of one knot vector.
+	/// Monotone parameter sequences advance in amortized O(1), knotVector is not validated.
+	/// </summary>
+	class LNLIB_EXPORT KnotSpanCursor
+	{
+	public:
+
+		KnotSpanCursor(int degree, const std::vector<double>& knotVector);
 
+		/// <summary>
+		/// Find the knot span index of paramT starting from the last found span.
+		/// </summary>
+		int Find(double paramT);
 
+		int GetSpanIndex() const;
 
+	private:
+
+		int _degree;
+		const std::vector<double>& _knotVector;
+		int _spanIndex;
+	};
+}
@@ -0,0 +1,172 @@
+/*
+ * Author:
+ * 2024/10/14 - Yuqing Liang (BIMCoder Liang)
+ * bim.frankliang@foxmail.com
+ * 微信公众号：BIMCoder梁老师
+ *
+ * Use of this source code is governed by a GPL-3.0 license that can be found in
+ * the LICENSE file.
+ */
+
+#pragma once
+#include "LNLibDefinitions.h"
+#include "LNObject.h"
+#include <vector>
+#include <mutex>
+#include <atomic>
+
+namespace LNLib
+{
+	/// <summary>
+	/// Immutable curve validated once, whose derived data is computed on first use and cached.
+	/// Caches are filled under std::call_once, so queries can run concurrently.
+	/// The curve is owned by the object, which therefore can not be copied.
+	/// </summary>
+	class LNLIB_EXPORT PreparedCurve
+	{
+	public:
+
+		PreparedCurve(const LN_NurbsCurve& curve);
+
+		/// <summary>
+		/// Prepares curve after an edit of previous.Curve() that kept degree and knot vector and only changed dirty.
+		/// Beziers, span boxes and power basis coefficients of the clean spans are copied from previous (computing them there if needed),
+		/// only the dirty spans are derived again. The other caches are computed on first use as usual.
+		/// </summary>
+		PreparedCurve(const PreparedCurve& previous, const LN_NurbsCurve& curve, const LN_DirtyRange& dirty);
+
+		PreparedCurve(const PreparedCurve&) = delete;
+		PreparedCurve& operator=(const PreparedCurve&) = delete;
+
+		const LN_NurbsCurve& Curve() const;
+
+		const LN_CheckedNurbsCurve& Checked() const;
+
+		/// <summary>
+		/// Distinct knots, Bezier segment i covers [u_i, u_i+1].
+		/// </summary>
+		const std::vector<double>& GetSpanKnots() const;
+
+		/// <summary>
+		/// Bezier segments on [0,1], one per span.
+		/// </summary>
+		const std::vector<LN_NurbsCurve>& GetBeziers() const;
+
+		/// <summary>
+		/// Control point box of every Bezier segment.
+		/// </summary>
+		const std::vector<LN_BoundingBox>& GetSpanBoundingBoxes() const;
+
+		/// <summary>
+		/// Homogeneous power basis coefficients of every Bezier segment, Cw(s) = sum a_i * s^i for local s in [0,1].
+		/// </summary>
+		const std::vector<std::vector<XYZW>>& GetPowerBasisCoefficients() const;
+
+		bool IsClosed() const;
+
+		/// <summary>
+		/// NurbsCurve::IsLinear computed once.
+		/// </summary>
+		bool IsLinear() const;
+
+		/// <summary>
+		/// NurbsCurve::IsArc computed once.
+		/// </summary>
+		bool IsArc() const;
+
+		/// <summary>
+		/// NurbsCurve::IsArc computed once, the circle is only written for arcs.
+		/// </summary>
+		bool IsArc(XYZ& center, XYZ& normal, double& radius, double& sweepAngle) const;
+
+		/// <summary>
+		/// The NURBS Book 2nd Edition Page97
+		/// Derivative curves of Cw computed once by Algorithm A3.3,
+		/// entry k is the kth derivative of degree p-k on knots u_k..u_m-k, entry 0 is Cw itself.
+		/// Derivatives of order above the degree vanish and are not stored.
+		/// </summary>
+		const std::vector<LN_BsplineCurve<XYZW>>& GetHodographs() const;
+
+		/// <summary>
+		/// Compute C(paramT) derivatives up to derivative, derivatives[k] is the kth derivative.
+		/// Each order is a plain evaluation of its cached hodograph, rational curves apply the quotient rule of equation (4.8).
+		/// </summary>
+		std::vector<XYZ> ComputeDerivatives(int derivative, double paramT) const;
+
+		/// <summary>
+		/// Compute C derivatives at count params into derivatives, derivative + 1 entries per param.
+		/// Consecutive params in one span reuse its lookup.
+		/// </summary>
+		void ComputeDerivatives(int derivative, const double* params, int count, XYZ* derivatives) const;
+
+		/// <summary>
+		/// The NURBS Book 2nd Edition Page20
+		/// Algorithm A1.1
+		/// Compute C(paramT) by Horner's rule on the power basis coefficients of its Bezier segment.
+		/// Curves of degree above Constants::MaxPowerBasisDegree fall back to Cox-de Boor evaluation.
+		/// </summary>
+		XYZ GetPointOnCurve(double paramT) const;
+
+		/// <summary>
+		/// Compute C at count params, consecutive params in one segment reuse its lookup.
+		/// </summary>
+		void GetPointsOnCurve(const double* params, int count, XYZ* points) const;
+
+		/// <summary>
+		/// Tessellation hierarchy, level k splits every Bezier segment into 2^k equal parameter intervals.
+		/// The Error of a level bounds the distance of every interval to its chord by the control points of the subdivided segment,
+		/// refinement stops at the first level within Constants::DistanceEpsilon.
+		/// Builds every level not yet built by GetLevelOfDetail.
+		/// </summary>
+		const std::vector<LN_CurveLevelOfDetail>& GetLevelsOfDetail() const;
+
+		/// <summary>
+		/// Coarsest level whose Error is within maxError, the finest level when none is.
+		/// maxError is in model units, such as a screen space tolerance in pixels times the model size of one pixel at the curve.
+		/// Levels are built on demand only up to the first one within maxError, only the subdivided segments of the finest built level are kept.
+		/// Returned levels stay valid while finer ones are added.
+		/// </summary>
+		const LN_CurveLevelOfDetail& GetLevelOfDetail(double maxError) const;
+
+	private:
+
+		int FindSegment(double paramT) const;
+
+		void ComputeBeziers() const;
+		void ComputeSpanBoundingBoxes() const;
+		void ComputePowerBasisCoefficients() const;
+		void ComputeIsClosed() const;
+		void ComputeClassification() const;
+		void ComputeHodographs() const;
+		void ComputeNextLevelOfDetail() const;
+		void UpdateSpans(const PreparedCurve& previous, const LN_DirtyRange& dirty) const;
+		void MarkComputed() const;
+
+		LN_NurbsCurve _curve;
+		LN_CheckedNurbsCurve _checked;
+		std::vector<double> _spanKnots;
+
+		mutable std::once_flag _beziersFlag;
+		mutable std::once_flag _boxesFlag;
+		mutable std::once_flag _powerBasisFlag;
+		mutable std::once_flag _closedFlag;
+		mutable std::once_flag _classificationFlag;
+		mutable std::once_flag _hodographsFlag;
+		mutable std::mutex _levelsMutex;
+		mutable std::vector<LN_NurbsCurve> _beziers;
+		mutable std::vector<LN_BoundingBox> _boxes;
+		mutable std::vector<std::vector<XYZW>> _powerBasis;
+		mutable std::vector<LN_BsplineCurve<XYZW>> _hodographs;
+		mutable std::vector<LN_CurveLevelOfDetail> _levels;
+		mutable std::vector<std::vector<XYZW>> _levelPieces;
+		mutable bool _isLevelsComplete;
+		mutable std::atomic<bool> _isPowerBasisReady;
+		mutable bool _isClosed;
+		mutable bool _isLinear;
+		mutable bool _isArc;
+		mutable XYZ _arcCenter;
+		mutable XYZ _arcNormal;
+		mutable double _arcRadius;
+		mutable double _arcSweepAngle;
+	};
+}
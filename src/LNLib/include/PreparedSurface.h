@@ -0,0 +1,131 @@
+/*
+ * Author:
+ * 2024/10/14 - Yuqing Liang (BIMCoder Liang)
+ * bim.frankliang@foxmail.com
+ * 微信公众号：BIMCoder梁老师
+ *
+ * Use of this source code is governed by a GPL-3.0 license that can be found in
+ * the LICENSE file.
+ */
+
+#pragma once
+#include "LNLibDefinitions.h"
+#include "LNObject.h"
+#include <vector>
+#include <mutex>
+
+namespace LNLib
+{
+	/// <summary>
+	/// Immutable surface validated once, whose derived data is computed on first use and cached.
+	/// Caches are filled under std::call_once, so queries can run concurrently.
+	/// The surface is owned by the object, which therefore can not be copied.
+	/// </summary>
+	class LNLIB_EXPORT PreparedSurface
+	{
+	public:
+
+		PreparedSurface(const LN_NurbsSurface& surface);
+
+		PreparedSurface(const PreparedSurface&) = delete;
+		PreparedSurface& operator=(const PreparedSurface&) = delete;
+
+		const LN_NurbsSurface& Surface() const;
+
+		const LN_CheckedNurbsSurface& Checked() const;
+
+		/// <summary>
+		/// Distinct knots in u direction, patch row i covers [u_i, u_i+1].
+		/// </summary>
+		const std::vector<double>& GetSpanKnotsU() const;
+
+		/// <summary>
+		/// Distinct knots in v direction, patch column j covers [v_j, v_j+1].
+		/// </summary>
+		const std::vector<double>& GetSpanKnotsV() const;
+
+		/// <summary>
+		/// Bezier patches on [0,1] x [0,1], patch p covers span (p / patchesV, p % patchesV).
+		/// </summary>
+		const std::vector<LN_NurbsSurface>& GetBeziers() const;
+
+		/// <summary>
+		/// Control net box of every Bezier patch.
+		/// </summary>
+		const std::vector<LN_BoundingBox>& GetSpanBoundingBoxes() const;
+
+		/// <summary>
+		/// Homogeneous power basis coefficients of every Bezier patch, Sw(s,t) = sum a_ij * s^i * t^j for local s, t in [0,1].
+		/// </summary>
+		const std::vector<std::vector<std::vector<XYZW>>>& GetPowerBasisCoefficients() const;
+
+		bool IsClosed(bool isUDirection) const;
+
+		/// <summary>
+		/// The NURBS Book 2nd Edition Page111
+		/// Derivative surfaces of Sw computed once by applying Algorithm A3.3 along both directions,
+		/// entry [k][l] is the derivative k times in u and l times in v, of degree (p-k, q-l) on knots u_k..u_r-k and v_l..v_s-l.
+		/// Entry [0][0] is Sw itself, derivatives of order above a degree vanish and are not stored.
+		/// </summary>
+		const std::vector<std::vector<LN_BsplineSurface<XYZW>>>& GetHodographs() const;
+
+		/// <summary>
+		/// Compute S(u,v) derivatives with k + l up to derivative, derivatives[k][l] is the derivative k times in u and l times in v.
+		/// Each order is a plain evaluation of its cached hodograph, rational surfaces apply the quotient rule of equation (4.20).
+		/// </summary>
+		std::vector<std::vector<XYZ>> ComputeDerivatives(int derivative, UV uv) const;
+
+		/// <summary>
+		/// Compute S derivatives at count uvs into derivatives,
+		/// (derivative + 1) * (derivative + 1) entries per uv with [k][l] at k * (derivative + 1) + l and zero for k + l above derivative.
+		/// </summary>
+		void ComputeDerivatives(int derivative, const UV* uvs, int count, XYZ* derivatives) const;
+
+		/// <summary>
+		/// Tessellation hierarchy, level k splits every Bezier patch into 2^k x 2^k equal parameter cells of two triangles.
+		/// The Error of a level bounds the distance of every cell to its triangles by the control net of the subdivided patch
+		/// against the bilinear patch of its corners plus the twist of the corners, which rational cells count twice.
+		/// Refinement stops at the first level within Constants::DistanceEpsilon.
+		/// Builds every level not yet built by GetLevelOfDetail.
+		/// </summary>
+		const std::vector<LN_SurfaceLevelOfDetail>& GetLevelsOfDetail() const;
+
+		/// <summary>
+		/// Coarsest level whose Error is within maxError, the finest level when none is.
+		/// maxError is in model units, such as a screen space tolerance in pixels times the model size of one pixel at the surface.
+		/// Levels are built on demand only up to the first one within maxError, only the subdivided nets of the finest built level are kept.
+		/// Returned levels stay valid while finer ones are added.
+		/// </summary>
+		const LN_SurfaceLevelOfDetail& GetLevelOfDetail(double maxError) const;
+
+	private:
+
+		void ComputeBeziers() const;
+		void ComputeSpanBoundingBoxes() const;
+		void ComputePowerBasisCoefficients() const;
+		void ComputeIsClosed() const;
+		void ComputeHodographs() const;
+		void ComputeNextLevelOfDetail() const;
+
+		LN_NurbsSurface _surface;
+		LN_CheckedNurbsSurface _checked;
+		std::vector<double> _spanKnotsU;
+		std::vector<double> _spanKnotsV;
+
+		mutable std::once_flag _beziersFlag;
+		mutable std::once_flag _boxesFlag;
+		mutable std::once_flag _powerBasisFlag;
+		mutable std::once_flag _closedFlag;
+		mutable std::once_flag _hodographsFlag;
+		mutable std::mutex _levelsMutex;
+		mutable std::vector<LN_NurbsSurface> _beziers;
+		mutable std::vector<LN_BoundingBox> _boxes;
+		mutable std::vector<std::vector<std::vector<XYZW>>> _powerBasis;
+		mutable std::vector<std::vector<LN_BsplineSurface<XYZW>>> _hodographs;
+		mutable std::vector<LN_SurfaceLevelOfDetail> _levels;
+		mutable std::vector<std::vector<std::vector<XYZW>>> _levelCells;
+		mutable bool _isLevelsComplete;
+		mutable bool _isClosedU;
+		mutable bool _isClosedV;
+	};
+}
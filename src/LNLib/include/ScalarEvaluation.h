@@ -0,0 +1,408 @@
+/*
+ * Author:
+ * 2024/10/14 - Yuqing Liang (BIMCoder Liang)
+ * bim.frankliang@foxmail.com
+ * 微信公众号：BIMCoder梁老师
+ *
+ * Use of this source code is governed by a GPL-3.0 license that can be found in
+ * the LICENSE file.
+ */
+
+#pragma once
+
+#include "LNLibDefinitions.h"
+#include "Constants.h"
+#include "NurbsCurve.h"
+#include "NurbsSurface.h"
+#include "LNLibExceptions.h"
+#include "LNObject.h"
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+namespace LNLib
+{
+	/// <summary>
+	/// Batch evaluation templated on the scalar type, float halves the memory traffic and doubles the lanes of every block
+	/// for viewport tessellation while modeling operations stay on the double precision objects.
+	/// Points and normals are written interleaved, three values per point, parameters are clamped to the knot vector range.
+	/// </summary>
+	class LNLIB_EXPORT ScalarEvaluation
+	{
+	public:
+
+		/// <summary>
+		/// Validate curve and copy it into scalar type T.
+		/// </summary>
+		template <typename T>
+		static void Convert(const LN_NurbsCurve& curve, LN_ScalarNurbsCurve<T>& result)
+		{
+			LN_CheckedNurbsCurve checkedCurve = NurbsCurve::Check(curve);
+			result.Degree = curve.Degree;
+			result.IsRational = checkedCurve.IsRational();
+			result.KnotVector.assign(curve.KnotVector.begin(), curve.KnotVector.end());
+
+			int count = curve.ControlPoints.size();
+			result.WX.resize(count);
+			result.WY.resize(count);
+			result.WZ.resize(count);
+			result.W.resize(count);
+			for (int i = 0; i < count; i++)
+			{
+				const XYZW& point = curve.ControlPoints[i];
+				result.WX[i] = static_cast<T>(point.GetWX());
+				result.WY[i] = static_cast<T>(point.GetWY());
+				result.WZ[i] = static_cast<T>(point.GetWZ());
+				result.W[i] = static_cast<T>(point.GetW());
+			}
+		}
+
+		/// <summary>
+		/// Validate surface and copy it into scalar type T.
+		/// </summary>
+		template <typename T>
+		static void Convert(const LN_NurbsSurface& surface, LN_ScalarNurbsSurface<T>& result)
+		{
+			LN_CheckedNurbsSurface checkedSurface = NurbsSurface::Check(surface);
+			result.DegreeU = surface.DegreeU;
+			result.DegreeV = surface.DegreeV;
+			result.IsRational = checkedSurface.IsRational();
+			result.Rows = surface.ControlPoints.size();
+			result.Columns = surface.ControlPoints[0].size();
+			result.KnotVectorU.assign(surface.KnotVectorU.begin(), surface.KnotVectorU.end());
+			result.KnotVectorV.assign(surface.KnotVectorV.begin(), surface.KnotVectorV.end());
+
+			int count = result.Rows * result.Columns;
+			result.WX.resize(count);
+			result.WY.resize(count);
+			result.WZ.resize(count);
+			result.W.resize(count);
+			for (int i = 0; i < result.Rows; i++)
+			{
+				for (int j = 0; j < result.Columns; j++)
+				{
+					const XYZW& point = surface.ControlPoints[i][j];
+					int index = i * result.Columns + j;
+					result.WX[index] = static_cast<T>(point.GetWX());
+					result.WY[index] = static_cast<T>(point.GetWY());
+					result.WZ[index] = static_cast<T>(point.GetWZ());
+					result.W[index] = static_cast<T>(point.GetW());
+				}
+			}
+		}
+
+		/// <summary>
+		/// Evaluate count curve points, point i is written to points[3 * i] to points[3 * i + 2].
+		/// Knot spans are walked incrementally for ascending params.
+		/// </summary>
+		template <typename T>
+		static void GetPointsOnCurve(const LN_ScalarNurbsCurve<T>& curve, const T* params, int count, T* points)
+		{
+			VALIDATE_ARGUMENT(count >= 0, "count", "Count must greater than or equals zero.");
+			if (count == 0) return;
+			VALIDATE_ARGUMENT(params != nullptr, "params", "Params must not be null.");
+			VALIDATE_ARGUMENT(points != nullptr, "points", "Points must not be null.");
+
+			int degree = curve.Degree;
+			const std::vector<T>& knotVector = curve.KnotVector;
+			const T* wx = curve.WX.data();
+			const T* wy = curve.WY.data();
+			const T* wz = curve.WZ.data();
+			const T* w = curve.W.data();
+
+			const int lanes = LaneCount<T>::Value;
+			int basisSize = degree + 1;
+			std::vector<T> N(lanes * basisSize);
+			std::vector<T> left(basisSize);
+			std::vector<T> right(basisSize);
+			int spanIndex = degree;
+			for (int start = 0; start < count; start += lanes)
+			{
+				int block = std::min(lanes, count - start);
+
+				int firstIndices[LaneCount<T>::Value] = { 0 };
+				for (int lane = 0; lane < block; lane++)
+				{
+					T paramT = Clamp(params[start + lane], knotVector);
+					spanIndex = FindSpan(degree, knotVector, paramT, spanIndex);
+					BasisFunctions(spanIndex, degree, knotVector, paramT, &N[lane * basisSize], left.data(), right.data());
+					firstIndices[lane] = spanIndex - degree;
+				}
+
+				T x[LaneCount<T>::Value] = { 0 };
+				T y[LaneCount<T>::Value] = { 0 };
+				T z[LaneCount<T>::Value] = { 0 };
+				T h[LaneCount<T>::Value] = { 0 };
+				for (int j = 0; j <= degree; j++)
+				{
+					for (int lane = 0; lane < lanes; lane++)
+					{
+						T n = N[lane * basisSize + j];
+						int index = firstIndices[lane] + j;
+						x[lane] += n * wx[index];
+						y[lane] += n * wy[index];
+						z[lane] += n * wz[index];
+						h[lane] += n * w[index];
+					}
+				}
+
+				for (int lane = 0; lane < block; lane++)
+				{
+					T scale = curve.IsRational ? T(1) / h[lane] : T(1);
+					T* point = points + 3 * (start + lane);
+					point[0] = x[lane] * scale;
+					point[1] = y[lane] * scale;
+					point[2] = z[lane] * scale;
+				}
+			}
+		}
+
+		/// <summary>
+		/// Evaluate surface on the tensor grid uParams x vParams, point (i, j) is written from points[3 * (i * columns + j)].
+		/// Basis functions are computed once per row and once per column.
+		/// </summary>
+		template <typename T>
+		static void EvaluateGrid(const LN_ScalarNurbsSurface<T>& surface, const T* uParams, int rows, const T* vParams, int columns, T* points)
+		{
+			EvaluateGrid(surface, uParams, rows, vParams, columns, points, static_cast<T*>(nullptr));
+		}
+
+		/// <summary>
+		/// Evaluate surface points and unit normals on the tensor grid, normals of degenerate points are zero.
+		/// </summary>
+		template <typename T>
+		static void EvaluateNormalGrid(const LN_ScalarNurbsSurface<T>& surface, const T* uParams, int rows, const T* vParams, int columns, T* points, T* normals)
+		{
+			VALIDATE_ARGUMENT(normals != nullptr, "normals", "Normals must not be null.");
+			EvaluateGrid(surface, uParams, rows, vParams, columns, points, normals);
+		}
+
+	private:
+
+		template <typename T>
+		struct LaneCount
+		{
+			static const int Value = Constants::BatchLaneCount * sizeof(double) / sizeof(T);
+		};
+
+		template <typename T>
+		static T Clamp(T paramT, const std::vector<T>& knotVector)
+		{
+			return std::max(knotVector[0], std::min(knotVector[knotVector.size() - 1], paramT));
+		}
+
+		/// <summary>
+		/// The NURBS Book 2nd Edition Page68
+		/// Algorithm A2.1, starting from the span of the previous parameter.
+		/// </summary>
+		template <typename T>
+		static int FindSpan(int degree, const std::vector<T>& knotVector, T paramT, int startSpanIndex)
+		{
+			int n = knotVector.size() - degree - 2;
+			if (paramT >= knotVector[n + 1])
+			{
+				return n;
+			}
+			if (paramT <= knotVector[degree])
+			{
+				return degree;
+			}
+			int span = std::max(degree, std::min(n, startSpanIndex));
+			if (knotVector[span] <= paramT && paramT < knotVector[span + 1])
+			{
+				return span;
+			}
+
+			int low = degree;
+			int high = n + 1;
+			int mid = (low + high) / 2;
+			while (paramT < knotVector[mid] || paramT >= knotVector[mid + 1])
+			{
+				if (paramT < knotVector[mid])
+				{
+					high = mid;
+				}
+				else
+				{
+					low = mid;
+				}
+				mid = (low + high) / 2;
+			}
+			return mid;
+		}
+
+		/// <summary>
+		/// The NURBS Book 2nd Edition Page70
+		/// Algorithm A2.2 with caller owned left and right buffers of degree + 1 values.
+		/// </summary>
+		template <typename T>
+		static void BasisFunctions(int spanIndex, int degree, const std::vector<T>& knotVector, T paramT, T* basisFunctions, T* left, T* right)
+		{
+			basisFunctions[0] = T(1);
+			for (int j = 1; j <= degree; j++)
+			{
+				left[j] = paramT - knotVector[spanIndex + 1 - j];
+				right[j] = knotVector[spanIndex + j] - paramT;
+				T saved = T(0);
+				for (int r = 0; r < j; r++)
+				{
+					T temp = basisFunctions[r] / (right[r + 1] + left[j - r]);
+					basisFunctions[r] = saved + right[r + 1] * temp;
+					saved = left[j - r] * temp;
+				}
+				basisFunctions[j] = saved;
+			}
+		}
+
+		/// <summary>
+		/// Basis functions and their first derivatives from the basis functions of degree - 1 (The NURBS Book 2nd Edition Page61, Eq.2.7).
+		/// </summary>
+		template <typename T>
+		static void BasisFunctionsFirstDerivatives(int spanIndex, int degree, const std::vector<T>& knotVector, T paramT, T* basisFunctions, T* derivatives, T* lower, T* left, T* right)
+		{
+			BasisFunctions(spanIndex, degree, knotVector, paramT, basisFunctions, left, right);
+			if (degree == 0)
+			{
+				derivatives[0] = T(0);
+				return;
+			}
+			BasisFunctions(spanIndex, degree - 1, knotVector, paramT, lower, left, right);
+			for (int k = 0; k <= degree; k++)
+			{
+				int index = spanIndex - degree + k;
+				T derivative = T(0);
+				if (k > 0)
+				{
+					T denominator = knotVector[index + degree] - knotVector[index];
+					if (denominator != T(0)) derivative += lower[k - 1] / denominator;
+				}
+				if (k < degree)
+				{
+					T denominator = knotVector[index + degree + 1] - knotVector[index + 1];
+					if (denominator != T(0)) derivative -= lower[k] / denominator;
+				}
+				derivatives[k] = degree * derivative;
+			}
+		}
+
+		template <typename T>
+		static void EvaluateGrid(const LN_ScalarNurbsSurface<T>& surface, const T* uParams, int rows, const T* vParams, int columns, T* points, T* normals)
+		{
+			VALIDATE_ARGUMENT(rows >= 0 && columns >= 0, "rows", "Rows and columns must greater than or equals zero.");
+			if (rows == 0 || columns == 0) return;
+			VALIDATE_ARGUMENT(uParams != nullptr && vParams != nullptr, "uParams", "Params must not be null.");
+			VALIDATE_ARGUMENT(points != nullptr, "points", "Points must not be null.");
+
+			int degreeU = surface.DegreeU;
+			int degreeV = surface.DegreeV;
+			const std::vector<T>& knotVectorU = surface.KnotVectorU;
+			const std::vector<T>& knotVectorV = surface.KnotVectorV;
+			bool hasNormals = normals != nullptr;
+
+			int sizeU = degreeU + 1;
+			int sizeV = degreeV + 1;
+			int maxSize = std::max(sizeU, sizeV);
+			std::vector<T> lower(maxSize);
+			std::vector<T> left(maxSize);
+			std::vector<T> right(maxSize);
+
+			std::vector<int> firstRows(rows);
+			std::vector<T> Nu(rows * sizeU);
+			std::vector<T> dNu(hasNormals ? rows * sizeU : 0);
+			int spanIndex = degreeU;
+			for (int i = 0; i < rows; i++)
+			{
+				T u = Clamp(uParams[i], knotVectorU);
+				spanIndex = FindSpan(degreeU, knotVectorU, u, spanIndex);
+				if (hasNormals)
+				{
+					BasisFunctionsFirstDerivatives(spanIndex, degreeU, knotVectorU, u, &Nu[i * sizeU], &dNu[i * sizeU], lower.data(), left.data(), right.data());
+				}
+				else
+				{
+					BasisFunctions(spanIndex, degreeU, knotVectorU, u, &Nu[i * sizeU], left.data(), right.data());
+				}
+				firstRows[i] = spanIndex - degreeU;
+			}
+
+			std::vector<int> firstColumns(columns);
+			std::vector<T> Nv(columns * sizeV);
+			std::vector<T> dNv(hasNormals ? columns * sizeV : 0);
+			spanIndex = degreeV;
+			for (int j = 0; j < columns; j++)
+			{
+				T v = Clamp(vParams[j], knotVectorV);
+				spanIndex = FindSpan(degreeV, knotVectorV, v, spanIndex);
+				if (hasNormals)
+				{
+					BasisFunctionsFirstDerivatives(spanIndex, degreeV, knotVectorV, v, &Nv[j * sizeV], &dNv[j * sizeV], lower.data(), left.data(), right.data());
+				}
+				else
+				{
+					BasisFunctions(spanIndex, degreeV, knotVectorV, v, &Nv[j * sizeV], left.data(), right.data());
+				}
+				firstColumns[j] = spanIndex - degreeV;
+			}
+
+			const std::vector<T>* arrays[4] = { &surface.WX, &surface.WY, &surface.WZ, &surface.W };
+			for (int i = 0; i < rows; i++)
+			{
+				const T* nu = &Nu[i * sizeU];
+				for (int j = 0; j < columns; j++)
+				{
+					const T* nv = &Nv[j * sizeV];
+					// A is the weighted point, Au and Av its partial derivatives, one value per coordinate.
+					T A[4] = { 0 };
+					T Au[4] = { 0 };
+					T Av[4] = { 0 };
+					for (int k = 0; k <= degreeU; k++)
+					{
+						int first = (firstRows[i] + k) * surface.Columns + firstColumns[j];
+						for (int c = 0; c < 4; c++)
+						{
+							const T* values = arrays[c]->data() + first;
+							T temp = T(0);
+							T tempV = T(0);
+							for (int l = 0; l <= degreeV; l++)
+							{
+								temp += nv[l] * values[l];
+								if (hasNormals) tempV += dNv[j * sizeV + l] * values[l];
+							}
+							A[c] += nu[k] * temp;
+							if (hasNormals)
+							{
+								Au[c] += dNu[i * sizeU + k] * temp;
+								Av[c] += nu[k] * tempV;
+							}
+						}
+					}
+
+					T weight = surface.IsRational ? A[3] : T(1);
+					T* point = points + 3 * (i * columns + j);
+					for (int c = 0; c < 3; c++)
+					{
+						point[c] = A[c] / weight;
+					}
+					if (!hasNormals) continue;
+
+					T Su[3];
+					T Sv[3];
+					for (int c = 0; c < 3; c++)
+					{
+						Su[c] = surface.IsRational ? (Au[c] - Au[3] * point[c]) / weight : Au[c];
+						Sv[c] = surface.IsRational ? (Av[c] - Av[3] * point[c]) / weight : Av[c];
+					}
+					T nx = Su[1] * Sv[2] - Su[2] * Sv[1];
+					T ny = Su[2] * Sv[0] - Su[0] * Sv[2];
+					T nz = Su[0] * Sv[1] - Su[1] * Sv[0];
+					T length = std::sqrt(nx * nx + ny * ny + nz * nz);
+					T scale = length > T(0) ? T(1) / length : T(0);
+					T* normal = normals + 3 * (i * columns + j);
+					normal[0] = nx * scale;
+					normal[1] = ny * scale;
+					normal[2] = nz * scale;
+				}
+			}
+		}
+	};
+}
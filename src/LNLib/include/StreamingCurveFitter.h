@@ -0,0 +1,89 @@
+/*
+ * Author:
+ * 2024/10/14 - Yuqing Liang (BIMCoder Liang)
+ * bim.frankliang@foxmail.com
+ * 微信公众号：BIMCoder梁老师
+ *
+ * Use of this source code is governed by a GPL-3.0 license that can be found in
+ * the LICENSE file.
+ */
+
+#pragma once
+#include "LNLibDefinitions.h"
+#include "LNObject.h"
+#include "XYZ.h"
+#include <vector>
+
+namespace LNLib
+{
+	/// <summary>
+	/// Incremental least squares fitting of an unbounded point stream.
+	/// Points of the active window are parameterized by chord length from the window start,
+	/// the normal equations are kept as running power moments of that length, so each new point costs O(degree^2)
+	/// and a fit O(degree^3) plus the error check over the window.
+	/// When a point can not be fitted within maxError, or the window holds maxWindowPoints, the current fit is split at
+	/// two thirds of the window and its first part emitted as a Bezier segment, the next window starts at its end point
+	/// with C^continuity in arc length and refits the remaining points.
+	/// Segments are defined on consecutive chord length intervals, memory is bounded by maxWindowPoints.
+	/// </summary>
+	class LNLIB_EXPORT StreamingCurveFitter
+	{
+	public:
+
+		/// <summary>
+		/// continuity must be in [0, 2] and less than degree, maxWindowPoints must be greater than degree.
+		/// </summary>
+		StreamingCurveFitter(int degree, double maxError, int continuity = 1, int maxWindowPoints = 256);
+
+		/// <summary>
+		/// Appends one point of the stream, points equal to the previous one are skipped.
+		/// </summary>
+		void AddPoint(const XYZ& point);
+
+		/// <summary>
+		/// Appends a chunk of the stream.
+		/// </summary>
+		void AddPoints(const std::vector<XYZ>& points);
+
+		/// <summary>
+		/// Emits the fit of the remaining window, the stream may continue afterwards from its end.
+		/// </summary>
+		void Finish();
+
+		/// <summary>
+		/// Moves out the segments finalized since the last call.
+		/// </summary>
+		std::vector<LN_NurbsCurve> TakeSegments();
+
+		/// <summary>
+		/// Number of points of the active window without its start point.
+		/// </summary>
+		int GetWindowSize() const;
+
+	private:
+
+		void Accumulate(double length, const XYZ& point, std::vector<double>& powerSums, std::vector<XYZ>& momentSums) const;
+		std::vector<XYZ> Fit(int degree, double length, const std::vector<double>& powerSums, const std::vector<XYZ>& momentSums) const;
+		double GetMaxError(const std::vector<XYZ>& controlPoints, double length) const;
+		void Emit(const std::vector<XYZ>& controlPoints, double length);
+
+		int _degree;
+		double _maxError;
+		int _continuity;
+		int _maxWindowPoints;
+
+		bool _isStarted;
+		bool _hasPrevious;
+		XYZ _start;
+		XYZ _last;
+		double _startParam;
+		double _length;
+		XYZ _firstDerivative;
+		XYZ _secondDerivative;
+		std::vector<XYZ> _points;
+		std::vector<double> _params;
+		std::vector<double> _powerSums;
+		std::vector<XYZ> _momentSums;
+		std::vector<LN_NurbsCurve> _segments;
+	};
+}
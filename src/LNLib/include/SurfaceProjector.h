@@ -0,0 +1,100 @@
+/*
+ * Author:
+ * 2024/10/14 - Yuqing Liang (BIMCoder Liang)
+ * bim.frankliang@foxmail.com
+ * 微信公众号：BIMCoder梁老师
+ *
+ * Use of this source code is governed by a GPL-3.0 license that can be found in
+ * the LICENSE file.
+ */
+
+#pragma once
+#include "LNLibDefinitions.h"
+#include "LNObject.h"
+#include "LNEnums.h"
+#include "BoundingVolumeHierarchy.h"
+#include "Parallel.h"
+#include <vector>
+
+namespace LNLib
+{
+	class UV;
+	class XYZ;
+
+	/// <summary>
+	/// Point inversion accelerator built once per surface.
+	/// Bezier patches from NurbsSurface::DecomposeToBeziers are bounded by the boxes of their control points
+	/// (convex hull property) and stored in a bounding volume hierarchy together with a few samples per patch.
+	/// Each query culls patches farther than the best sample found so far and runs Newton iteration from that sample.
+	/// Queries do not modify the projector and can run concurrently.
+	/// </summary>
+	class LNLIB_EXPORT SurfaceProjector
+	{
+	public:
+
+		SurfaceProjector(const LN_NurbsSurface& surface);
+
+		/// <summary>
+		/// The NURBS Book 2nd Edition Page232
+		/// Point inversion: finding the corresponding parameter make S(u,v) = P.
+		/// </summary>
+		UV GetParamOnSurface(const XYZ& givenPoint) const;
+
+		/// <summary>
+		/// Point inversion with the given tolerances and iteration cap, seeded from the nearest patch sample.
+		/// </summary>
+		UV GetParamOnSurface(const XYZ& givenPoint, const LN_ProjectionOptions& options) const;
+
+		/// <summary>
+		/// Point inversion of a point near the previous query, as when tracking a moving point.
+		/// Newton iteration starts at previousParam, its result is kept when no sample of the patches within options.LocalSearchRange
+		/// spans around previousParam is closer, otherwise iteration restarts from that sample.
+		/// When the nearest of those samples lies in a patch on the border of the window the query falls back to the global search.
+		/// </summary>
+		UV GetParamOnSurface(const XYZ& givenPoint, UV previousParam, const LN_ProjectionOptions& options = LN_ProjectionOptions()) const;
+
+		/// <summary>
+		/// Point inversion of every given point, blocks of points are projected in parallel.
+		/// </summary>
+		std::vector<UV> GetParamsOnSurface(const std::vector<XYZ>& givenPoints, ParallelExecutor* executor = nullptr) const;
+
+		/// <summary>
+		/// Deviation of count points from the surface into deviations.
+		/// Blocks of consecutive points are processed in parallel, inside a block every point is warm started from
+		/// the previous one, so clouds in scan order mostly skip the global search.
+		/// The accuracy of parameters and distances follows the tolerances of options.
+		/// </summary>
+		void ComputeDeviations(const XYZ* points, int count, LN_PointDeviation* deviations, const LN_ProjectionOptions& options = LN_ProjectionOptions(), ParallelExecutor* executor = nullptr) const;
+
+		/// <summary>
+		/// Deviation of every given point from the surface.
+		/// </summary>
+		std::vector<LN_PointDeviation> ComputeDeviations(const std::vector<XYZ>& points, const LN_ProjectionOptions& options = LN_ProjectionOptions(), ParallelExecutor* executor = nullptr) const;
+
+		/// <summary>
+		/// Non-throwing point inversion, NotConverged still writes the best parameter reached.
+		/// </summary>
+		EvaluationStatus TryGetParamOnSurface(const XYZ& givenPoint, UV& param, const LN_ProjectionOptions& options = LN_ProjectionOptions()) const noexcept;
+
+		/// <summary>
+		/// Non-throwing warm started point inversion, previousParam outside the domain fails or is clamped by policy.
+		/// </summary>
+		EvaluationStatus TryGetParamOnSurface(const XYZ& givenPoint, UV previousParam, UV& param, const LN_ProjectionOptions& options = LN_ProjectionOptions(), ParameterRangePolicy policy = ParameterRangePolicy::Fail) const noexcept;
+
+	private:
+
+		UV Project(const XYZ& givenPoint, const LN_ProjectionOptions& options, bool& isConverged) const;
+		UV Project(const XYZ& givenPoint, UV previousParam, const LN_ProjectionOptions& options, bool& isConverged) const;
+
+		UV Refine(const XYZ& givenPoint, UV param, const LN_ProjectionOptions& options, bool& isConverged) const;
+
+		LN_NurbsSurface _surface;
+		bool _isClosedU;
+		bool _isClosedV;
+		std::vector<double> _spanKnotsU;
+		std::vector<double> _spanKnotsV;
+		std::vector<XYZ> _samples;
+		std::vector<UV> _sampleParams;
+		BoundingVolumeHierarchy _hierarchy;
+	};
+}
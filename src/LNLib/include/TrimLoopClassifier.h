@@ -0,0 +1,79 @@
+/*
+ * Author:
+ * 2024/10/14 - Yuqing Liang (BIMCoder Liang)
+ * bim.frankliang@foxmail.com
+ * 微信公众号：BIMCoder梁老师
+ *
+ * Use of this source code is governed by a GPL-3.0 license that can be found in
+ * the LICENSE file.
+ */
+
+#pragma once
+#include "LNLibDefinitions.h"
+#include "LNObject.h"
+#include "LNEnums.h"
+#include <vector>
+
+namespace LNLib
+{
+	class UV;
+
+	/// <summary>
+	/// Point in loop accelerator built once per set of trim loops.
+	/// Loop curves are flattened to segments within tolerance and bucketed into a uniform grid over their bounding box,
+	/// the even-odd state of every cell center is computed once by casting one ray per grid row.
+	/// A query starts from the state of its cell center and only tests the segments of that cell,
+	/// cells without segments answer without any test.
+	/// Queries do not modify the classifier and can run concurrently.
+	/// </summary>
+	class LNLIB_EXPORT TrimLoopClassifier
+	{
+	public:
+
+		/// <summary>
+		/// loops as in LN_TrimmedSurface, tolerance is the largest distance in parameter space between a curve and its segments.
+		/// </summary>
+		TrimLoopClassifier(const std::vector<std::vector<LN_NurbsCurve>>& loops, double tolerance);
+
+		/// <summary>
+		/// True when uv is enclosed by an odd number of loops.
+		/// </summary>
+		bool IsInside(const UV& uv) const;
+
+		/// <summary>
+		/// Boundary when a loop segment touches the parameter box [min, max], otherwise the state shared by all its points.
+		/// </summary>
+		TrimRegion Classify(const UV& min, const UV& max) const;
+
+		double GetTolerance() const;
+
+		/// <summary>
+		/// Flattened loop segments, segment k runs from GetSegmentStarts()[k] to GetSegmentEnds()[k].
+		/// </summary>
+		const std::vector<UV>& GetSegmentStarts() const;
+		const std::vector<UV>& GetSegmentEnds() const;
+
+	private:
+
+		int GetColumn(double u) const;
+		int GetRow(double v) const;
+
+		double _tolerance;
+		std::vector<UV> _starts;
+		std::vector<UV> _ends;
+
+		double _minU;
+		double _minV;
+		double _maxU;
+		double _maxV;
+		double _cellWidth;
+		double _cellHeight;
+		int _columns;
+		int _rows;
+
+		// Segments of cell (row, column) are _cellSegments[_cellStarts[c]] to _cellSegments[_cellStarts[c + 1] - 1], c = row * _columns + column.
+		std::vector<int> _cellStarts;
+		std::vector<int> _cellSegments;
+		std::vector<bool> _isCenterInside;
+	};
+}
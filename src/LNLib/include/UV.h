@@ -12,6 +12,7 @@
 
 #include "Constants.h"
 #include "LNLibDefinitions.h"
+#include <math.h>
 
 namespace LNLib
 {
@@ -77,7 +78,202 @@ namespace LNLib
 	LNLIB_EXPORT UV operator *(const double& d, const UV& source);
 	LNLIB_EXPORT double operator ^(const UV& uv1, const UV& uv2);
 	LNLIB_EXPORT UV operator /(const UV& source, double d);
-}
 
+	// Arithmetic core is inline so evaluation code in client translation units compiles to straight-line floating point code.
+
+	inline UV::UV()
+	{
+		m_uv[0] = 0;
+		m_uv[1] = 0;
+	}
+
+	inline UV::UV(double u, double v)
+	{
+		m_uv[0] = u;
+		m_uv[1] = v;
+	}
+
+	inline void UV::SetU(const double x)
+	{
+		m_uv[0] = x;
+	}
+
+	inline double UV::GetU() const { return m_uv[0]; }
+
+	inline void UV::SetV(const double y)
+	{
+		m_uv[1] = y;
+	}
+
+	inline double UV::GetV() const { return m_uv[1]; }
+
+	inline double UV::U() const
+	{
+		return m_uv[0];
+	}
+
+	inline double& UV::U()
+	{
+		return m_uv[0];
+	}
+
+	inline double UV::V() const
+	{
+		return m_uv[1];
+	}
+
+	inline double& UV::V()
+	{
+		return m_uv[1];
+	}
+
+	inline bool UV::IsZero(const double epsilon) const
+	{
+		return SqrLength() <= epsilon * epsilon;
+	}
+
+	inline bool UV::IsUnit(const double epsilon) const
+	{
+		return fabs(SqrLength() - 1) < epsilon * epsilon;
+	}
+
+	inline double UV::Length() const
+	{
+		return sqrt(m_uv[0] * m_uv[0] + m_uv[1] * m_uv[1]);
+	}
+
+	inline double UV::SqrLength() const
+	{
+		return m_uv[0] * m_uv[0] + m_uv[1] * m_uv[1];
+	}
+
+	inline UV UV::Normalize()
+	{
+		double length = Length();
+		UV newUV = *this;
+		if (length > 0)
+		{
+			double invLength = (double)(1.0 / length);
+			newUV.m_uv[0] *= invLength;
+			newUV.m_uv[1] *= invLength;
+		}
+		return newUV;
+	}
+
+	inline UV UV::Add(const UV& another) const
+	{
+		return *this + another;
+	}
+
+	inline UV UV::Substract(const UV& another) const
+	{
+		return *this - another;
+	}
+
+	inline UV UV::Negative() const
+	{
+		return UV(-m_uv[0], -m_uv[1]);
+	}
+
+	inline double UV::DotProduct(const UV& another) const
+	{
+		return m_uv[0] * another.m_uv[0] + m_uv[1] * another.m_uv[1];
+	}
+
+	inline double UV::CrossProduct(const UV& another) const
+	{
+		return m_uv[0] * another[1] - another.m_uv[0] * m_uv[1];
+	}
+
+	inline double UV::Distance(const UV& another) const
+	{
+		double du = another.m_uv[0] - m_uv[0];
+		double dv = another.m_uv[1] - m_uv[1];
+		return sqrt(du * du + dv * dv);
+	}
+
+	inline UV& UV::operator=(const UV& uv)
+	{
+		m_uv[0] = uv.m_uv[0];
+		m_uv[1] = uv.m_uv[1];
+		return *this;
+	}
+
+	inline double& UV::operator[](int index)
+	{
+		return m_uv[index];
+	}
 
+	inline const double& UV::operator[](int index) const
+	{
+		return m_uv[index];
+	}
 
+	inline UV UV::operator+(const UV& uv) const
+	{
+		return UV(m_uv[0] + uv.m_uv[0], m_uv[1] + uv.m_uv[1]);
+	}
+
+	inline UV UV::operator-(const UV& uv) const
+	{
+		return UV(m_uv[0] - uv.m_uv[0], m_uv[1] - uv.m_uv[1]);
+	}
+
+	inline double UV::operator*(const UV& uv) const
+	{
+		return DotProduct(uv);
+	}
+
+	inline UV& UV::operator*=(const double& d)
+	{
+		m_uv[0] *= d;
+		m_uv[1] *= d;
+		return *this;
+	}
+
+	inline UV& UV::operator/=(const double& d)
+	{
+		m_uv[0] /= d;
+		m_uv[1] /= d;
+		return *this;
+	}
+
+	inline UV& UV::operator+=(const UV& uv)
+	{
+		m_uv[0] += uv.m_uv[0];
+		m_uv[1] += uv.m_uv[1];
+		return *this;
+	}
+
+	inline UV& UV::operator-=(const UV& uv)
+	{
+		m_uv[0] -= uv.m_uv[0];
+		m_uv[1] -= uv.m_uv[1];
+		return *this;
+	}
+
+	inline UV UV::operator-() const
+	{
+		return UV(-m_uv[0], -m_uv[1]);
+	}
+
+	inline UV operator*(const UV& source, const double d)
+	{
+		return UV(source.GetU() * d, source.GetV() * d);
+	}
+
+	inline UV operator*(const double& d, const UV& source)
+	{
+		return UV(source.GetU() * d, source.GetV() * d);
+	}
+
+	inline double operator^(const UV& uv1, const UV& uv2)
+	{
+		return uv1.CrossProduct(uv2);
+	}
+
+	inline UV operator/(const UV& source, double d)
+	{
+		return UV(source.GetU() / d, source.GetV() / d);
+	}
+}
@@ -11,6 +11,7 @@
 #pragma once
 
 #include "LNLibDefinitions.h"
+#include "LNEnums.h"
 #include "MathUtils.h"
 #include <vector>
 
@@ -41,6 +42,12 @@ namespace LNLib
 		/// TOL = dWmin / (1+abs(Pmax))
 		/// </summary>
 		static double ComputeCurveModifyTolerance(const std::vector<XYZW>& controlPoints);
+
+		/// <summary>
+		/// Status form of VALIDATE_ARGUMENT_RANGE: parameters within Constants::DoubleEpsilon of [min, max] are snapped to it,
+		/// others fail with OutOfRange or are clamped by policy. NaN is an InvalidArgument.
+		/// </summary>
+		static EvaluationStatus ResolveParameter(double& parameter, double min, double max, ParameterRangePolicy policy) noexcept;
 	};
 }
 
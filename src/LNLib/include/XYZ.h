@@ -11,6 +11,7 @@
 #pragma once
 #include "Constants.h"
 #include "LNLibDefinitions.h"
+#include <math.h>
 
 namespace LNLib
 {
@@ -81,6 +82,230 @@ namespace LNLib
 	LNLIB_EXPORT XYZ operator *(const double& d, const XYZ& source);
 	LNLIB_EXPORT XYZ operator ^(const XYZ& xyz1, const XYZ& xyz2);
 	LNLIB_EXPORT XYZ operator /(const XYZ& source, double d);
-}
 
+	// Arithmetic core is inline so evaluation code in client translation units compiles to straight-line floating point code.
+
+	inline XYZ::XYZ()
+	{
+		m_xyz[0] = 0;
+		m_xyz[1] = 0;
+		m_xyz[2] = 0;
+	}
+
+	inline XYZ::XYZ(double x, double y, double z)
+	{
+		m_xyz[0] = x;
+		m_xyz[1] = y;
+		m_xyz[2] = z;
+	}
+
+	inline void XYZ::SetX(const double x)
+	{
+		m_xyz[0] = x;
+	}
+
+	inline double XYZ::GetX() const { return m_xyz[0]; }
+
+	inline void XYZ::SetY(const double y)
+	{
+		m_xyz[1] = y;
+	}
+
+	inline double XYZ::GetY() const { return m_xyz[1]; }
+
+	inline void XYZ::SetZ(const double z)
+	{
+		m_xyz[2] = z;
+	}
+
+	inline double XYZ::GetZ() const { return m_xyz[2]; }
+
+	inline double XYZ::X() const
+	{
+		return m_xyz[0];
+	}
+
+	inline double& XYZ::X()
+	{
+		return m_xyz[0];
+	}
+
+	inline double XYZ::Y() const
+	{
+		return m_xyz[1];
+	}
+
+	inline double& XYZ::Y()
+	{
+		return m_xyz[1];
+	}
+
+	inline double XYZ::Z() const
+	{
+		return m_xyz[2];
+	}
+
+	inline double& XYZ::Z()
+	{
+		return m_xyz[2];
+	}
+
+	inline bool XYZ::IsZero(const double epsilon) const
+	{
+		return SqrLength() <= epsilon * epsilon;
+	}
+
+	inline bool XYZ::IsUnit(const double epsilon) const
+	{
+		return fabs(SqrLength() - 1) < epsilon * epsilon;
+	}
+
+	inline double XYZ::Length() const
+	{
+		return sqrt(m_xyz[0]* m_xyz[0] + m_xyz[1] * m_xyz[1] + m_xyz[2] * m_xyz[2]);
+	}
+
+	inline double XYZ::SqrLength() const
+	{
+		return m_xyz[0] * m_xyz[0] + m_xyz[1] * m_xyz[1] + m_xyz[2] * m_xyz[2];
+	}
+
+	inline XYZ XYZ::Normalize()
+	{
+		double length = Length();
+		XYZ newXYZ = *this;
+		if (length > 0)
+		{
+			double invLength = (double)(1.0 / length);
+			newXYZ.m_xyz[0] *= invLength;
+			newXYZ.m_xyz[1] *= invLength;
+			newXYZ.m_xyz[2] *= invLength;
+		}
+		return newXYZ;
+	}
+
+	inline XYZ XYZ::Add(const XYZ& another) const
+	{
+		return *this + another;
+	}
+
+	inline XYZ XYZ::Substract(const XYZ& another) const
+	{
+		return *this - another;
+	}
+
+	inline XYZ XYZ::Negative() const
+	{
+		return XYZ(-m_xyz[0], -m_xyz[1], -m_xyz[2]);
+	}
+
+	inline double XYZ::DotProduct(const XYZ& another) const
+	{
+		return m_xyz[0] * another.m_xyz[0] + m_xyz[1] * another.m_xyz[1] + m_xyz[2] * another.m_xyz[2];
+	}
+
+	inline XYZ XYZ::CrossProduct(const XYZ& another) const
+	{
+		return XYZ(m_xyz[1] * another.m_xyz[2] - another.m_xyz[1] * m_xyz[2],
+					m_xyz[2] * another.m_xyz[0] - another.m_xyz[2] * m_xyz[0],
+					m_xyz[0] * another[1] - another.m_xyz[0] * m_xyz[1]);
+	}
+
+	inline double XYZ::Distance(const XYZ& another) const
+	{
+		double dx = another.m_xyz[0] - m_xyz[0];
+		double dy = another.m_xyz[1] - m_xyz[1];
+		double dz = another.m_xyz[2] - m_xyz[2];
+		return sqrt(dx * dx + dy * dy + dz * dz);
+	}
+
+	inline XYZ& XYZ::operator=(const XYZ& xyz)
+	{
+		m_xyz[0] = xyz.m_xyz[0];
+		m_xyz[1] = xyz.m_xyz[1];
+		m_xyz[2] = xyz.m_xyz[2];
+		return *this;
+	}
+
+	inline double& XYZ::operator[](int index)
+	{
+		return m_xyz[index];
+	}
+
+	inline const double& XYZ::operator[](int index) const
+	{
+		return m_xyz[index];
+	}
 
+	inline XYZ XYZ::operator+(const XYZ& xyz) const
+	{
+		return XYZ(m_xyz[0] + xyz.m_xyz[0], m_xyz[1] + xyz.m_xyz[1], m_xyz[2] + xyz.m_xyz[2]);
+	}
+
+	inline XYZ XYZ::operator-(const XYZ& xyz) const
+	{
+		return XYZ(m_xyz[0] - xyz.m_xyz[0], m_xyz[1] - xyz.m_xyz[1], m_xyz[2] - xyz.m_xyz[2]);
+	}
+
+	inline double XYZ::operator*(const XYZ& xyz) const
+	{
+		return DotProduct(xyz);
+	}
+
+	inline XYZ& XYZ::operator*=(const double& d)
+	{
+		m_xyz[0] *= d;
+		m_xyz[1] *= d;
+		m_xyz[2] *= d;
+		return *this;
+	}
+
+	inline XYZ& XYZ::operator/=(const double& d)
+	{
+		m_xyz[0] /= d;
+		m_xyz[1] /= d;
+		m_xyz[2] /= d;
+		return *this;
+	}
+
+	inline XYZ& XYZ::operator+=(const XYZ& xyz)
+	{
+		m_xyz[0] += xyz.m_xyz[0];
+		m_xyz[1] += xyz.m_xyz[1];
+		m_xyz[2] += xyz.m_xyz[2];
+		return *this;
+	}
+
+	inline XYZ& XYZ::operator-=(const XYZ& xyz)
+	{
+		m_xyz[0] -= xyz.m_xyz[0];
+		m_xyz[1] -= xyz.m_xyz[1];
+		m_xyz[2] -= xyz.m_xyz[2];
+		return *this;
+	}
+
+	inline XYZ XYZ::operator-() const
+	{
+		return XYZ(-m_xyz[0],-m_xyz[1],-m_xyz[2]);
+	}
+
+	inline XYZ operator*(const XYZ& source, const double d)
+	{
+		return XYZ(source.GetX()*d, source.GetY()*d, source.GetZ()*d);
+	}
+
+	inline XYZ operator*(const double& d, const XYZ& source)
+	{
+		return XYZ(source.GetX() * d, source.GetY() * d, source.GetZ() * d);
+	}
+
+	inline XYZ operator^(const XYZ& xyz1, const XYZ& xyz2)
+	{
+		return xyz1.CrossProduct(xyz2);
+	}
+
+	inline XYZ operator/(const XYZ& source, double d)
+	{
+		return XYZ(source.GetX() / d, source.GetY() / d, source.GetZ() / d);
+	}
+}
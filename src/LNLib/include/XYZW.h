@@ -47,7 +47,7 @@ namespace LNLib
 
 	public:
 
-		XYZ ToXYZ(bool divideWeight);
+		XYZ ToXYZ(bool divideWeight) const;
 		bool IsAlmostEqualTo(const XYZW& another) const;
 		double Distance(const XYZW& another) const;
 
@@ -67,5 +67,159 @@ namespace LNLib
 	LNLIB_EXPORT XYZW operator *(const XYZW& source, const double d);
 	LNLIB_EXPORT XYZW operator *(const double& d, const XYZW& source);
 	LNLIB_EXPORT XYZW operator /(const XYZW& source, double d);
-}
 
+	// Arithmetic core is inline so evaluation code in client translation units compiles to straight-line floating point code.
+
+	inline XYZW::XYZW()
+	{
+		m_xyzw[0] = 0;
+		m_xyzw[1] = 0;
+		m_xyzw[2] = 0;
+		m_xyzw[3] = 0;
+	}
+
+	inline XYZW::XYZW(XYZ xyz, double w)
+	{
+		m_xyzw[0] = xyz.GetX() * w;
+		m_xyzw[1] = xyz.GetY() * w;
+		m_xyzw[2] = xyz.GetZ() * w;
+		m_xyzw[3] = w;
+	}
+
+	inline XYZW::XYZW(double wx, double wy, double wz, double w)
+	{
+		m_xyzw[0] = wx;
+		m_xyzw[1] = wy;
+		m_xyzw[2] = wz;
+		m_xyzw[3] = w;
+	}
+
+	inline double XYZW::GetWX() const { return m_xyzw[0]; }
+
+	inline double XYZW::GetWY() const { return m_xyzw[1]; }
+
+	inline double XYZW::GetWZ() const { return m_xyzw[2]; }
+
+	inline void XYZW::SetW(const double w)
+	{
+		XYZ origin = this->ToXYZ(true);
+		*this = XYZW(origin, w);
+	}
+
+	inline double XYZW::GetW() const { return m_xyzw[3]; }
+
+	inline double XYZW::WX() const
+	{
+		return m_xyzw[0];
+	}
+
+	inline double& XYZW::WX()
+	{
+		return m_xyzw[0];
+	}
+
+	inline double XYZW::WY() const
+	{
+		return m_xyzw[1];
+	}
+
+	inline double& XYZW::WY()
+	{
+		return m_xyzw[1];
+	}
+
+	inline double XYZW::WZ() const
+	{
+		return m_xyzw[2];
+	}
+
+	inline double& XYZW::WZ()
+	{
+		return m_xyzw[2];
+	}
+
+	inline double XYZW::W() const
+	{
+		return m_xyzw[3];
+	}
+
+	inline double& XYZW::W()
+	{
+		return m_xyzw[3];
+	}
+
+	inline XYZ XYZW::ToXYZ(bool divideWeight) const
+	{
+		if (divideWeight)
+		{
+			// Same zero test as MathUtils::IsAlmostEqualTo(w, 0.0).
+			double w = m_xyzw[3];
+			double eps = (fabs(w) + 10) * Constants::DoubleEpsilon;
+			if (-eps < w && w < eps)
+			{
+				return XYZ(m_xyzw[0], m_xyzw[1], m_xyzw[2]);
+			}
+			else
+			{
+				return XYZ(m_xyzw[0] / w, m_xyzw[1] / w, m_xyzw[2] / w);
+			}
+		}
+		else
+		{
+			return XYZ(m_xyzw[0], m_xyzw[1], m_xyzw[2]);
+		}
+	}
+
+	inline double XYZW::Distance(const XYZW& another) const
+	{
+		double dx = another.m_xyzw[0] - m_xyzw[0];
+		double dy = another.m_xyzw[1] - m_xyzw[1];
+		double dz = another.m_xyzw[2] - m_xyzw[2];
+		double dw = another.m_xyzw[3] - m_xyzw[3];
+		return sqrt(dx * dx + dy * dy + dz * dz + dw * dw);
+	}
+
+	inline double& XYZW::operator[](int index)
+	{
+		return m_xyzw[index];
+	}
+
+	inline const double& XYZW::operator[](int index) const
+	{
+		return m_xyzw[index];
+	}
+
+	inline XYZW XYZW::operator+(const XYZW& xyzw) const
+	{
+		return XYZW(m_xyzw[0] + xyzw.m_xyzw[0], m_xyzw[1] + xyzw.m_xyzw[1], m_xyzw[2] + xyzw.m_xyzw[2], m_xyzw[3] + xyzw.m_xyzw[3]);
+	}
+
+	inline XYZW XYZW::operator-(const XYZW& xyzw) const
+	{
+		return XYZW(m_xyzw[0] - xyzw.m_xyzw[0], m_xyzw[1] - xyzw.m_xyzw[1], m_xyzw[2] - xyzw.m_xyzw[2], m_xyzw[3] - xyzw.m_xyzw[3]);
+	}
+
+	inline XYZW& XYZW::operator+=(const XYZW& xyzw)
+	{
+		m_xyzw[0] += xyzw.m_xyzw[0];
+		m_xyzw[1] += xyzw.m_xyzw[1];
+		m_xyzw[2] += xyzw.m_xyzw[2];
+		m_xyzw[3] += xyzw.m_xyzw[3];
+		return *this;
+	}
+
+	inline XYZW operator*(const XYZW& source, const double d)
+	{
+		return XYZW(source.GetWX() * d, source.GetWY() * d, source.GetWZ() * d, source.GetW() * d);
+	}
+
+	inline XYZW operator*(const double& d, const XYZW& source)
+	{
+		return XYZW(source.GetWX() * d, source.GetWY() * d, source.GetWZ() * d, source.GetW() * d);
+	}
+
+	inline XYZW operator/(const XYZW& source, double d)
+	{
+		return XYZW(source.GetWX() / d, source.GetWY() / d, source.GetWZ() / d, source.GetW() / d);
+	}
+}
@@ -1,13 +1,76 @@
 ﻿#include "gtest/gtest.h"
 #include "NurbsCurve.h"
 #include "NurbsSurface.h"
+#include "Intersection.h"
+#include "MonotonicArena.h"
+#include "Parallel.h"
+#include "Matrix4d.h"
 #include "XYZ.h"
 #include "XYZW.h"
 #include "MathUtils.h"
+#include "Integrator.h"
+#include "Instrumentation.h"
+#include "GpuExport.h"
+#include "GeometryStore.h"
+#include "KnotVectorPool.h"
+#include "Cancellation.h"
+#include "PickingScene.h"
+#include "BsplineCurve.h"
 #include "LNObject.h"
+#include <mutex>
+#include <cstdio>
+#include <cstring>
 
 using namespace LNLib;
 
+namespace
+{
+	bool IsYLess(const XYZ& left, const XYZ& right)
+	{
+		return left.GetY() < right.GetY();
+	}
+
+	class SquareRootFunction : public IntegrationFunction
+	{
+	public:
+		double operator()(double parameter, void* customData)
+		{
+			return sqrt(parameter);
+		}
+	};
+
+	class RecordingCallback : public InstrumentationCallback
+	{
+	public:
+		void operator()(const LN_InstrumentationRecord& record) override
+		{
+			std::lock_guard<std::mutex> lock(Mutex);
+			Records.emplace_back(record);
+		}
+
+		std::mutex Mutex;
+		std::vector<LN_InstrumentationRecord> Records;
+	};
+
+	struct UnevenCountTask : public ParallelTask
+	{
+		std::vector<int> Counts;
+		std::vector<double> Sums;
+
+		void operator()(int taskIndex) override
+		{
+			double sum = 0.0;
+			int work = taskIndex % 7 == 0 ? 200000 : 10;
+			for (int k = 0; k < work; k++)
+			{
+				sum += 1.0 / (k + 1);
+			}
+			Sums[taskIndex] = sum;
+			Counts[taskIndex]++;
+		}
+	};
+}
+
 TEST(Test_Additional, All)
 {
 	LN_NurbsCurve result;
@@ -56,6 +119,261 @@ TEST(Test_Additional, All)
 	EXPECT_TRUE(MathUtils::IsAlmostEqualTo(arcParameters[0], 0.25));
 	EXPECT_TRUE(MathUtils::IsAlmostEqualTo(arcParameters[1], 0.5));
 	EXPECT_TRUE(MathUtils::IsAlmostEqualTo(arcParameters[2], 0.75));
+
+	LN_ArcLengthTable table;
+	NurbsCurve::CreateArcLengthTable(curve, table);
+	EXPECT_TRUE(MathUtils::IsAlmostEqualTo(table.Lengths.back(), 2 * Constants::Pi * radius));
+	EXPECT_TRUE(MathUtils::IsAlmostEqualTo(NurbsCurve::GetParamOnCurve(table, 0.5 * Constants::Pi * radius), 0.25));
+	double tableParam = NurbsCurve::GetParamOnCurve(table, 0.3 * Constants::Pi * radius);
+	LN_ArcLengthTable chebyshevTable;
+	NurbsCurve::CreateArcLengthTable(curve, chebyshevTable, IntegratorType::Chebyshev, 64);
+	EXPECT_TRUE(MathUtils::IsAlmostEqualTo(NurbsCurve::GetParamOnCurve(chebyshevTable, 0.3 * Constants::Pi * radius), tableParam, 1E-5));
+	arcParameters = NurbsCurve::GetParamsOnCurve(table, 0.1 * Constants::Pi * radius);
+	EXPECT_TRUE(arcParameters.size() == 19);
+	EXPECT_TRUE(MathUtils::IsAlmostEqualTo(arcParameters[9], 0.5));
+
+	// The speed jumps at the double knot, both sides of it keep their own slope.
+	LN_NurbsCurve kinked;
+	kinked.Degree = 2;
+	kinked.KnotVector = { 0, 0, 0, 0.2656, 0.2656, 1, 1, 1 };
+	kinked.ControlPoints = { XYZW(XYZ(0, 0, 0), 1), XYZW(XYZ(1, 4, 0), 3), XYZW(XYZ(4, 4, 0), 1), XYZW(XYZ(12, 0, 0), 0.5), XYZW(XYZ(20, 6, 0), 1) };
+	LN_ArcLengthTable kinkedTable;
+	NurbsCurve::CreateArcLengthTable(kinked, kinkedTable);
+	double kinkedLength = kinkedTable.Lengths.back();
+	EXPECT_NEAR(kinkedLength, NurbsCurve::ApproximateLength(kinked, IntegratorType::GaussKronrod), Constants::DistanceEpsilon);
+	for (int i = 1; i < 10; i++)
+	{
+		double givenLength = (i / 10.0 + 0.07) * kinkedLength;
+		LN_NurbsCurve left;
+		LN_NurbsCurve right;
+		ASSERT_TRUE(NurbsCurve::SplitAt(kinked, NurbsCurve::GetParamOnCurve(kinkedTable, givenLength), left, right));
+		EXPECT_NEAR(NurbsCurve::ApproximateLength(left, IntegratorType::GaussKronrod), givenLength, 1E-4 * kinkedLength);
+	}
+}
+
+TEST(Test_Additional, CurveCurveIntersection)
+{
+	double radius = 100;
+	LN_NurbsCurve circle;
+	NurbsCurve::CreateArc(XYZ(0, 0, 0), XYZ(1, 0, 0), XYZ(0, 1, 0), 0, 2 * Constants::Pi, radius, radius, circle);
+	LN_NurbsCurve line;
+	NurbsCurve::CreateLine(XYZ(-200, 10, 0), XYZ(200, 10, 0), line);
+
+	std::vector<LN_CurveCurveIntersection> intersections = Intersection::ComputeCurveCurve(line, circle, Constants::DistanceEpsilon);
+	EXPECT_TRUE(intersections.size() == 2);
+	double x = sqrt(radius * radius - 100.0);
+	EXPECT_TRUE(intersections[0].Point.IsAlmostEqualTo(XYZ(-x, 10, 0)));
+	EXPECT_TRUE(intersections[1].Point.IsAlmostEqualTo(XYZ(x, 10, 0)));
+	EXPECT_TRUE(NurbsCurve::GetPointOnCurve(circle, intersections[0].Param1).IsAlmostEqualTo(XYZ(-x, 10, 0)));
+
+	LN_NurbsCurve shifted;
+	NurbsCurve::CreateArc(XYZ(radius, 0, 0), XYZ(1, 0, 0), XYZ(0, 1, 0), 0, 2 * Constants::Pi, radius, radius, shifted);
+	intersections = Intersection::ComputeCurveCurve(circle, shifted, Constants::DistanceEpsilon);
+	EXPECT_TRUE(intersections.size() == 2);
+	EXPECT_TRUE(intersections[0].Point.IsAlmostEqualTo(XYZ(radius / 2, radius * sqrt(3.0) / 2, 0)));
+	EXPECT_TRUE(intersections[1].Point.IsAlmostEqualTo(XYZ(radius / 2, -radius * sqrt(3.0) / 2, 0)));
+
+	std::vector<XYZ> wavePoints;
+	for (int i = 0; i <= 200; i++)
+	{
+		double t = 10 * Constants::Pi * i / 200;
+		wavePoints.emplace_back(XYZ(t, sin(t), 0));
+	}
+	LN_NurbsCurve wave;
+	NurbsCurve::GlobalInterpolation(3, wavePoints, wave);
+	NurbsCurve::CreateLine(XYZ(-1, 0, 0), XYZ(40, 0, 0), line);
+	intersections = Intersection::ComputeCurveCurve(wave, line, Constants::DistanceEpsilon);
+	EXPECT_TRUE(intersections.size() == 11);
+	for (int i = 0; i < intersections.size(); i++)
+	{
+		EXPECT_TRUE(MathUtils::IsAlmostEqualTo(intersections[i].Point.GetX(), i * Constants::Pi, 1E-3));
+	}
+
+	// The wave spans go into the hierarchy, a short line only meets the few spans it crosses.
+	NurbsCurve::CreateLine(XYZ(2 * Constants::Pi - 1, -0.5, 0), XYZ(2 * Constants::Pi + 1, 0.5, 0), line);
+	intersections = Intersection::ComputeCurveCurve(line, wave, Constants::DistanceEpsilon);
+	EXPECT_TRUE(intersections.size() == 1);
+	EXPECT_TRUE(MathUtils::IsAlmostEqualTo(intersections[0].Point.GetX(), 2 * Constants::Pi, 1E-3));
+	EXPECT_TRUE(NurbsCurve::GetPointOnCurve(wave, intersections[0].Param1).IsAlmostEqualTo(intersections[0].Point));
+	EXPECT_FALSE(intersections[0].IsOverlap);
+
+	// A tangent contact is reported once at its closest point.
+	LN_NurbsCurve parabola;
+	parabola.Degree = 2;
+	parabola.KnotVector = { 0, 0, 0, 1, 1, 1 };
+	parabola.ControlPoints = { XYZW(XYZ(0, 1, 0), 1), XYZW(XYZ(1, -1, 0), 1), XYZW(XYZ(2, 1, 0), 1) };
+	NurbsCurve::CreateLine(XYZ(0, 0, 0), XYZ(2, 0, 0), line);
+	intersections = Intersection::ComputeCurveCurve(line, parabola, 1E-6);
+	ASSERT_EQ(intersections.size(), 1);
+	EXPECT_FALSE(intersections[0].IsOverlap);
+	EXPECT_NEAR(intersections[0].Param0, 0.5, 1E-3);
+	EXPECT_NEAR(intersections[0].Param1, 0.5, 1E-3);
+
+	// Touching circles meet on the seam of the first one, the contact is still reported once.
+	LN_NurbsCurve touching;
+	NurbsCurve::CreateArc(XYZ(2 * radius, 0, 0), XYZ(1, 0, 0), XYZ(0, 1, 0), 0, 2 * Constants::Pi, radius, radius, touching);
+	intersections = Intersection::ComputeCurveCurve(circle, touching, 1E-6);
+	ASSERT_EQ(intersections.size(), 1);
+	EXPECT_TRUE(intersections[0].Point.IsAlmostEqualTo(XYZ(radius, 0, 0)));
+
+	// A curve against itself overlaps over its whole domain.
+	intersections = Intersection::ComputeCurveCurve(wave, wave, Constants::DistanceEpsilon);
+	ASSERT_EQ(intersections.size(), 1);
+	EXPECT_TRUE(intersections[0].IsOverlap);
+	EXPECT_NEAR(intersections[0].Param0, wave.KnotVector.front(), Constants::DistanceEpsilon);
+	EXPECT_NEAR(intersections[0].EndParam0, wave.KnotVector.back(), Constants::DistanceEpsilon);
+	EXPECT_NEAR(intersections[0].EndParam1, wave.KnotVector.back(), Constants::DistanceEpsilon);
+
+	// Polylines decompose to one segment per edge.
+	LN_NurbsCurve polyline;
+	polyline.Degree = 1;
+	polyline.KnotVector = { 0, 0, 1, 2, 3, 3 };
+	polyline.ControlPoints = { XYZW(XYZ(0, -1, 0), 1), XYZW(XYZ(1, 1, 0), 1), XYZW(XYZ(2, -1, 0), 1), XYZW(XYZ(3, 1, 0), 1) };
+	NurbsCurve::CreateLine(XYZ(0, 0, 0), XYZ(3, 0, 0), line);
+	intersections = Intersection::ComputeCurveCurve(polyline, line, Constants::DistanceEpsilon);
+	ASSERT_EQ(intersections.size(), 3);
+	for (int i = 0; i < intersections.size(); i++)
+	{
+		EXPECT_NEAR(intersections[i].Param0, i + 0.5, Constants::DistanceEpsilon);
+	}
+}
+
+TEST(Test_Additional, CurveSurfaceIntersection)
+{
+	LN_NurbsSurface plane;
+	NurbsSurface::CreateBilinearSurface(XYZ(0, 0, 0), XYZ(10, 0, 0), XYZ(10, 10, 0), XYZ(0, 10, 0), plane);
+
+	LN_NurbsCurve line;
+	NurbsCurve::CreateLine(XYZ(2, 3, -5), XYZ(4, 6, 5), line);
+	std::vector<LN_CurveSurfaceIntersection> lineResults = Intersection::ComputeCurveSurface(line, plane, Constants::DistanceEpsilon);
+	EXPECT_EQ(lineResults.size(), 1);
+	EXPECT_NEAR(lineResults[0].CurveParam, 0.5, Constants::DistanceEpsilon);
+	EXPECT_TRUE(lineResults[0].Point.IsAlmostEqualTo(XYZ(3, 4.5, 0)));
+	EXPECT_NEAR(lineResults[0].SurfaceParam.GetU(), 0.3, Constants::DistanceEpsilon);
+	EXPECT_NEAR(lineResults[0].SurfaceParam.GetV(), 0.45, Constants::DistanceEpsilon);
+
+	LN_NurbsCurve circle;
+	NurbsCurve::CreateArc(XYZ(5, 5, 0), XYZ(1, 0, 0), XYZ(0, 0, 1), -Constants::Pi / 2, 3 * Constants::Pi / 2, 2, 2, circle);
+	std::vector<LN_CurveSurfaceIntersection> circleResults = Intersection::ComputeCurveSurface(circle, plane, Constants::DistanceEpsilon);
+	EXPECT_EQ(circleResults.size(), 2);
+	for (int i = 0; i < circleResults.size(); i++)
+	{
+		EXPECT_NEAR(circleResults[i].Point.GetZ(), 0.0, Constants::DistanceEpsilon);
+		EXPECT_NEAR(std::abs(circleResults[i].Point.GetX() - 5), 2.0, Constants::DistanceEpsilon);
+	}
+
+	// A polyline decomposes to one segment per edge, each edge crosses the plane at its middle.
+	LN_NurbsCurve polyline;
+	polyline.Degree = 1;
+	polyline.KnotVector = { 0, 0, 1, 2, 3, 3 };
+	polyline.ControlPoints = { XYZW(XYZ(1, 1, -1), 1), XYZW(XYZ(3, 2, 1), 1), XYZW(XYZ(5, 4, -1), 1), XYZW(XYZ(7, 5, 1), 1) };
+	std::vector<LN_CurveSurfaceIntersection> polylineResults = Intersection::ComputeCurveSurface(polyline, plane, Constants::DistanceEpsilon);
+	ASSERT_EQ(polylineResults.size(), 3);
+	for (int i = 0; i < polylineResults.size(); i++)
+	{
+		EXPECT_NEAR(polylineResults[i].CurveParam, i + 0.5, Constants::DistanceEpsilon);
+		EXPECT_NEAR(polylineResults[i].Point.GetZ(), 0.0, Constants::DistanceEpsilon);
+	}
+}
+
+TEST(Test_Additional, SurfaceSurfaceIntersection)
+{
+	LN_NurbsSurface plane;
+	NurbsSurface::CreateBilinearSurface(XYZ(0, 0, 0), XYZ(10, 0, 0), XYZ(10, 10, 0), XYZ(0, 10, 0), plane);
+
+	LN_NurbsSurface wall;
+	NurbsSurface::CreateBilinearSurface(XYZ(5, -1, -1), XYZ(5, 11, -1), XYZ(5, 11, 1), XYZ(5, -1, 1), wall);
+	std::vector<LN_SurfaceSurfaceIntersection> lineResults = Intersection::ComputeSurfaceSurface(plane, wall, Constants::DistanceEpsilon);
+	EXPECT_EQ(lineResults.size(), 1);
+	const std::vector<XYZ>& linePoints = lineResults[0].Points;
+	EXPECT_TRUE(std::min(linePoints.front(), linePoints.back(), IsYLess).IsAlmostEqualTo(XYZ(5, 0, 0)));
+	EXPECT_TRUE(std::max(linePoints.front(), linePoints.back(), IsYLess).IsAlmostEqualTo(XYZ(5, 10, 0)));
+	EXPECT_TRUE(NurbsCurve::GetPointOnCurve(lineResults[0].Curve, 0.5).IsAlmostEqualTo(XYZ(5, 5, 0)));
+
+	LN_NurbsSurface cylinder;
+	NurbsSurface::CreateCylindricalSurface(XYZ(5, 5, -2), XYZ(1, 0, 0), XYZ(0, 1, 0), 0, 2 * Constants::Pi, 2, 4, cylinder);
+	std::vector<LN_SurfaceSurfaceIntersection> circleResults = Intersection::ComputeSurfaceSurface(plane, cylinder, Constants::DistanceEpsilon);
+	EXPECT_EQ(circleResults.size(), 1);
+	const std::vector<XYZ>& circlePoints = circleResults[0].Points;
+	EXPECT_GT(circlePoints.size(), 10);
+	for (int i = 0; i < circlePoints.size(); i++)
+	{
+		EXPECT_NEAR(circlePoints[i].GetZ(), 0.0, Constants::DistanceEpsilon);
+		EXPECT_NEAR(circlePoints[i].Distance(XYZ(5, 5, 0)), 2.0, Constants::DistanceEpsilon);
+	}
+	EXPECT_TRUE(circlePoints.front().IsAlmostEqualTo(circlePoints.back()));
+}
+
+TEST(Test_Additional, RaySurfaceIntersection)
+{
+	LN_NurbsSurface plane;
+	NurbsSurface::CreateBilinearSurface(XYZ(0, 0, 0), XYZ(10, 0, 0), XYZ(10, 10, 0), XYZ(0, 10, 0), plane);
+	std::vector<LN_RaySurfaceIntersection> planeResults = Intersection::ComputeRaySurface(XYZ(3, 4, 5), XYZ(0, 0, -2), plane, Constants::DistanceEpsilon);
+	ASSERT_EQ(planeResults.size(), 1);
+	EXPECT_NEAR(planeResults[0].RayParam, 2.5, Constants::DistanceEpsilon);
+	EXPECT_TRUE(planeResults[0].Point.IsAlmostEqualTo(XYZ(3, 4, 0)));
+	EXPECT_NEAR(planeResults[0].SurfaceParam.GetU(), 0.3, Constants::DistanceEpsilon);
+	EXPECT_NEAR(planeResults[0].SurfaceParam.GetV(), 0.4, Constants::DistanceEpsilon);
+	EXPECT_TRUE(Intersection::ComputeRaySurface(XYZ(3, 4, 5), XYZ(0, 0, 1), plane, Constants::DistanceEpsilon).empty());
+
+	LN_NurbsSurface cylinder;
+	NurbsSurface::CreateCylindricalSurface(XYZ(5, 5, -2), XYZ(1, 0, 0), XYZ(0, 1, 0), 0, 2 * Constants::Pi, 2, 4, cylinder);
+	std::vector<LN_RaySurfaceIntersection> cylinderResults = Intersection::ComputeRaySurface(XYZ(-5, 5, 0.5), XYZ(1, 0, 0), cylinder, Constants::DistanceEpsilon);
+	ASSERT_EQ(cylinderResults.size(), 2);
+	EXPECT_NEAR(cylinderResults[0].RayParam, 8.0, Constants::DistanceEpsilon);
+	EXPECT_NEAR(cylinderResults[1].RayParam, 12.0, Constants::DistanceEpsilon);
+	EXPECT_TRUE(NurbsSurface::GetPointOnSurface(cylinder, cylinderResults[0].SurfaceParam).IsAlmostEqualTo(XYZ(3, 5, 0.5)));
+
+	std::vector<LN_NurbsSurface> surfaces;
+	for (int i = 0; i < 10; i++)
+	{
+		for (int j = 0; j < 10; j++)
+		{
+			double z = 0.1 * ((i * 7 + j * 3) % 10);
+			LN_NurbsSurface tile;
+			NurbsSurface::CreateBilinearSurface(XYZ(i, j, z), XYZ(i + 1, j, z), XYZ(i + 1, j + 1, z + 0.5), XYZ(i, j + 1, z + 0.5), tile);
+			surfaces.emplace_back(tile);
+		}
+	}
+	surfaces.emplace_back(cylinder);
+	LN_NurbsCurve line;
+	NurbsCurve::CreateLine(XYZ(0, 0, 5), XYZ(10, 0, 5), line);
+	PickingScene scene(surfaces, std::vector<LN_NurbsCurve>(1, line));
+	EXPECT_EQ(scene.GetSurfaceCount(), 101);
+	EXPECT_EQ(scene.GetCurveCount(), 1);
+
+	for (int k = 0; k < 20; k++)
+	{
+		XYZ origin(0.37 + 0.45 * k, 9.3 - 0.41 * k, 10.0);
+		XYZ direction(0.02, 0.01, -1.0);
+		double expected = Constants::MaxDistance;
+		int expectedIndex = -1;
+		for (int i = 0; i < surfaces.size(); i++)
+		{
+			std::vector<LN_RaySurfaceIntersection> hits = Intersection::ComputeRaySurface(origin, direction, surfaces[i], Constants::DistanceEpsilon);
+			if (!hits.empty() && hits[0].RayParam < expected)
+			{
+				expected = hits[0].RayParam;
+				expectedIndex = i;
+			}
+		}
+		LN_PickResult pick;
+		ASSERT_EQ(scene.Pick(origin, direction, Constants::DistanceEpsilon, pick), expectedIndex >= 0);
+		if (expectedIndex >= 0)
+		{
+			EXPECT_EQ(pick.SurfaceIndex, expectedIndex);
+			EXPECT_EQ(pick.CurveIndex, -1);
+			EXPECT_NEAR(pick.RayParam, expected, Constants::DistanceEpsilon);
+		}
+	}
+
+	LN_PickResult curvePick;
+	ASSERT_TRUE(scene.Pick(XYZ(4, -5, 5.001), XYZ(0, 1, 0), 0.01, curvePick));
+	EXPECT_EQ(curvePick.CurveIndex, 0);
+	EXPECT_EQ(curvePick.SurfaceIndex, -1);
+	EXPECT_NEAR(curvePick.RayParam, 5.0, Constants::DistanceEpsilon);
+	EXPECT_NEAR(curvePick.CurveParam, 0.4, Constants::DistanceEpsilon);
+	EXPECT_FALSE(scene.Pick(XYZ(4, -5, 6), XYZ(0, 1, 0), 0.01, curvePick));
 }
 
 TEST(Test_Additional, Area)
@@ -123,4 +441,473 @@ TEST(Test_Additional, Area)
 	EXPECT_FALSE(MathUtils::IsAlmostEqualTo(simpson, standardArea)); // not accuracy when use Simpson
 	EXPECT_TRUE(MathUtils::IsAlmostEqualTo(gaussLegendre, standardArea));
 	EXPECT_TRUE(MathUtils::IsAlmostEqualTo(chebyshev, standardArea));
-}
\ No newline at end of file
+
+	double patchArea = NurbsSurface::ApproximateArea(surface, 1E-10);
+	EXPECT_TRUE(MathUtils::IsAlmostEqualTo(patchArea, standardArea));
+
+	double error = 0.0;
+	double kronrodArea = NurbsSurface::ApproximateArea(surface, 1E-8, 100000, &error);
+	EXPECT_TRUE(MathUtils::IsAlmostEqualTo(kronrodArea, standardArea));
+	EXPECT_TRUE(error <= 1E-8);
+	EXPECT_TRUE(MathUtils::IsAlmostEqualTo(NurbsSurface::ApproximateArea(surface, IntegratorType::GaussKronrod), standardArea));
+}
+
+TEST(Test_Additional, GaussKronrod)
+{
+	SquareRootFunction function;
+	std::vector<double> breakpoints = { 0.0, 0.5, 1.0 };
+	double error = 0.0;
+	int evaluations = 0;
+
+	// The budget only covers the initial intervals.
+	double coarse = Integrator::GaussKronrod(function, nullptr, breakpoints, 1E-12, 30, error, evaluations);
+	EXPECT_EQ(evaluations, 30);
+	EXPECT_TRUE(error > 1E-12);
+	EXPECT_NEAR(coarse, 2.0 / 3.0, 1E-3);
+
+	double fine = Integrator::GaussKronrod(function, nullptr, breakpoints, 1E-12, 3000, error, evaluations);
+	EXPECT_TRUE(error <= 1E-12);
+	EXPECT_TRUE(evaluations <= 3000);
+	EXPECT_NEAR(fine, 2.0 / 3.0, 1E-11);
+	EXPECT_THROW(Integrator::GaussKronrod(function, nullptr, breakpoints, 0.0, 3000, error, evaluations), std::invalid_argument);
+
+	XYZ center = XYZ(0, 0, 0);
+	double radius = 100;
+	LN_NurbsCurve curve;
+	NurbsCurve::CreateArc(center, XYZ(1, 0, 0), XYZ(0, 1, 0), 0, 2 * Constants::Pi, radius, radius, curve);
+	double length = NurbsCurve::ApproximateLength(curve, 1E-9, 1500, &error);
+	EXPECT_NEAR(length, 2 * Constants::Pi * radius, 1E-8);
+	EXPECT_TRUE(error <= 1E-9);
+	EXPECT_TRUE(MathUtils::IsAlmostEqualTo(NurbsCurve::ApproximateLength(curve, IntegratorType::GaussKronrod), 2 * Constants::Pi * radius));
+	EXPECT_TRUE(MathUtils::IsAlmostEqualTo(NurbsCurve::GetParamOnCurve(curve, 0.5 * Constants::Pi * radius, IntegratorType::GaussKronrod), 0.25));
+}
+
+TEST(Test_Additional, MonotonicArena)
+{
+	MonotonicArena arena(256);
+	ArenaVector<XYZ> points((ArenaAllocator<XYZ>(arena)));
+	for (int i = 0; i < 100; i++)
+	{
+		points.emplace_back(XYZ(i, 0, 0));
+	}
+	EXPECT_TRUE(points[99].IsAlmostEqualTo(XYZ(99, 0, 0)));
+	EXPECT_TRUE(arena.GetBlockCount() > 1);
+
+	void* aligned = arena.Allocate(3, 64);
+	EXPECT_EQ(reinterpret_cast<uintptr_t>(aligned) % 64, 0);
+
+	points.clear();
+	points.shrink_to_fit();
+	arena.Release();
+	EXPECT_EQ(arena.GetBlockCount(), 0);
+	EXPECT_EQ(arena.GetAllocatedBytes(), 0);
+}
+
+TEST(Test_Additional, Parallel)
+{
+	UnevenCountTask task;
+	task.Counts.resize(203);
+	task.Sums.resize(203);
+	Parallel::For(task.Counts.size(), task, 4);
+	for (int i = 0; i < task.Counts.size(); i++)
+	{
+		EXPECT_EQ(task.Counts[i], 1);
+	}
+
+	std::vector<LN_NurbsCurve> curves;
+	std::vector<double> kv = { 0,0,0,1,2,3,3,3 };
+	for (int i = 0; i < 17; i++)
+	{
+		std::vector<XYZW> cps = { XYZW(XYZ(0,0,0),1), XYZW(XYZ(1,1 + i,0),4), XYZW(XYZ(3,2,0),1), XYZW(XYZ(4,1,i),1), XYZW(XYZ(5,-1,0),1) };
+		LN_NurbsCurve curve;
+		curve.Degree = 2;
+		curve.KnotVector = kv;
+		curve.ControlPoints = cps;
+		curves.emplace_back(curve);
+	}
+	std::vector<double> lengths = NurbsCurve::ApproximateLength(curves, IntegratorType::GaussLegendre);
+	Matrix4d matrix = Matrix4d::CreateTranslation(XYZ(1, 2, 3));
+	std::vector<LN_NurbsCurve> transformed = NurbsCurve::CreateTransformed(curves, matrix);
+	std::vector<std::vector<LN_NurbsCurve>> beziers = NurbsCurve::DecomposeToBeziers(curves);
+	std::vector<std::vector<XYZ>> points;
+	std::vector<std::vector<double>> knots;
+	NurbsCurve::EquallyTessellate(curves, points, knots);
+	ASSERT_EQ(lengths.size(), curves.size());
+	ASSERT_EQ(points.size(), curves.size());
+	for (int i = 0; i < curves.size(); i++)
+	{
+		EXPECT_TRUE(MathUtils::IsAlmostEqualTo(lengths[i], NurbsCurve::ApproximateLength(curves[i], IntegratorType::GaussLegendre)));
+		XYZ expected = NurbsCurve::GetPointOnCurve(curves[i], 1.5) + XYZ(1, 2, 3);
+		EXPECT_TRUE(NurbsCurve::GetPointOnCurve(transformed[i], 1.5).IsAlmostEqualTo(expected));
+		EXPECT_EQ(beziers[i].size(), NurbsCurve::DecomposeToBeziers(curves[i]).size());
+		std::vector<XYZ> serialPoints;
+		std::vector<double> serialKnots;
+		NurbsCurve::EquallyTessellate(curves[i], serialPoints, serialKnots);
+		EXPECT_EQ(points[i].size(), serialPoints.size());
+		EXPECT_EQ(knots[i].size(), serialKnots.size());
+	}
+}
+
+TEST(Test_Additional, Instrumentation)
+{
+	EXPECT_FALSE(Instrumentation::IsEnabled());
+	{
+		ScopedTimer ignored("Ignored");
+		Instrumentation::Count(InstrumentationCounter::Evaluations, 1);
+	}
+
+	RecordingCallback callback;
+	Instrumentation::SetCallback(&callback);
+	EXPECT_TRUE(Instrumentation::IsEnabled());
+	{
+		ScopedTimer outer("Outer");
+		Instrumentation::Count(InstrumentationCounter::Evaluations, 3);
+		{
+			ScopedTimer inner("Inner");
+			Instrumentation::Count(InstrumentationCounter::NewtonIterations, 2);
+		}
+	}
+	Instrumentation::SetCallback(nullptr);
+
+	ASSERT_EQ(callback.Records.size(), 2);
+	const LN_InstrumentationRecord& inner = callback.Records[0];
+	const LN_InstrumentationRecord& outer = callback.Records[1];
+	EXPECT_STREQ(inner.Name, "Inner");
+	EXPECT_EQ(inner.Depth, 1);
+	EXPECT_EQ(inner.Counters[(int)InstrumentationCounter::Evaluations], 0);
+	EXPECT_EQ(inner.Counters[(int)InstrumentationCounter::NewtonIterations], 2);
+	EXPECT_STREQ(outer.Name, "Outer");
+	EXPECT_EQ(outer.Depth, 0);
+	EXPECT_EQ(outer.Counters[(int)InstrumentationCounter::Evaluations], 3);
+	EXPECT_EQ(outer.Counters[(int)InstrumentationCounter::NewtonIterations], 2);
+	EXPECT_TRUE(outer.Duration >= inner.Duration);
+	EXPECT_EQ(outer.ThreadId, inner.ThreadId);
+
+	Instrumentation::BeginChromeTrace();
+	{
+		ScopedTimer traced("Traced");
+	}
+	std::string trace = Instrumentation::EndChromeTrace();
+	EXPECT_FALSE(Instrumentation::IsEnabled());
+	EXPECT_NE(trace.find("\"traceEvents\""), std::string::npos);
+	EXPECT_NE(trace.find("\"name\":\"Traced\""), std::string::npos);
+	EXPECT_NE(trace.find("\"ph\":\"X\""), std::string::npos);
+	EXPECT_NE(trace.find("\"NewtonIterations\":0"), std::string::npos);
+	EXPECT_EQ(trace.find("Outer"), std::string::npos);
+
+#ifdef LNLIB_INSTRUMENTATION
+	LN_NurbsCurve curve;
+	NurbsCurve::CreateArc(XYZ(0, 0, 0), XYZ(1, 0, 0), XYZ(0, 1, 0), 0, 2 * Constants::Pi, 10, 10, curve);
+	RecordingCallback libraryCallback;
+	Instrumentation::SetCallback(&libraryCallback);
+	NurbsCurve::ApproximateLength(curve, 1E-9, 1500);
+	Instrumentation::SetCallback(nullptr);
+	ASSERT_FALSE(libraryCallback.Records.empty());
+	const LN_InstrumentationRecord& length = libraryCallback.Records.back();
+	EXPECT_STREQ(length.Name, "NurbsCurve::ApproximateLength");
+	EXPECT_TRUE(length.Counters[(int)InstrumentationCounter::Evaluations] >= 15);
+	EXPECT_TRUE(length.Counters[(int)InstrumentationCounter::SpanSearches] >= 15);
+#endif
+}
+
+TEST(Test_Additional, GpuExport)
+{
+	LN_NurbsSurface surface;
+	surface.DegreeU = 2;
+	surface.DegreeV = 3;
+	surface.KnotVectorU = { 0,0,0,0.25,0.5,0.5,1,1,1 };
+	surface.KnotVectorV = { 0,0,0,0,0.2,0.4,0.6,0.8,1,1,1,1 };
+	surface.ControlPoints.resize(6);
+	for (int i = 0; i < 6; i++)
+	{
+		for (int j = 0; j < 8; j++)
+		{
+			surface.ControlPoints[i].emplace_back(XYZW(XYZ(i, j, 0.5 * sin(i + 0.7 * j)), 1.0 + 0.25 * ((i + j) % 2)));
+		}
+	}
+
+	LN_GpuSurfaceBuffer surfaceBuffer;
+	GpuExport::Pack(surface, surfaceBuffer);
+	EXPECT_EQ(surfaceBuffer.BreaksU.size(), 4);
+	EXPECT_EQ(surfaceBuffer.BreaksV.size(), 6);
+	EXPECT_EQ(surfaceBuffer.ControlPoints.size(), 4 * 3 * 5 * 12);
+
+	std::vector<double> uParams = { 0, 0.1, 0.25, 0.4, 0.5, 0.77, 1 };
+	std::vector<double> vParams = { 0, 0.15, 0.2, 0.5, 0.93, 1 };
+	std::vector<float> uvs;
+	for (int i = 0; i < uParams.size(); i++)
+	{
+		for (int j = 0; j < vParams.size(); j++)
+		{
+			uvs.emplace_back(static_cast<float>(uParams[i]));
+			uvs.emplace_back(static_cast<float>(vParams[j]));
+		}
+	}
+	std::vector<float> points;
+	std::vector<float> normals;
+	GpuExport::EvaluateSurface(surfaceBuffer, uvs, points, normals);
+	std::vector<std::vector<XYZ>> expectedPoints;
+	std::vector<std::vector<XYZ>> expectedNormals;
+	NurbsSurface::EvaluateNormalGrid(surface, uParams, vParams, expectedPoints, expectedNormals);
+	for (int i = 0; i < uParams.size(); i++)
+	{
+		for (int j = 0; j < vParams.size(); j++)
+		{
+			int index = 4 * (i * vParams.size() + j);
+			EXPECT_LT(XYZ(points[index], points[index + 1], points[index + 2]).Distance(expectedPoints[i][j]), 1E-4);
+			EXPECT_LT(XYZ(normals[index], normals[index + 1], normals[index + 2]).Distance(expectedNormals[i][j].Normalize()), 1E-4);
+			EXPECT_EQ(points[index + 3], 1.0f);
+		}
+	}
+
+	LN_NurbsCurve curve;
+	curve.Degree = 3;
+	curve.KnotVector = { 0,0,0,0,0.3,0.5,0.5,1,1,1,1 };
+	curve.ControlPoints = { XYZW(XYZ(0,0,0),1), XYZW(XYZ(1,2,1),2), XYZW(XYZ(3,2,0),0.5), XYZW(XYZ(4,0,-1),1), XYZW(XYZ(5,-1,2),3), XYZW(XYZ(6,1,0),1), XYZW(XYZ(8,0,1),1) };
+	LN_GpuCurveBuffer curveBuffer;
+	GpuExport::Pack(curve, curveBuffer);
+	EXPECT_EQ(curveBuffer.Count, 3);
+	std::vector<float> params = { -0.5f, 0.0f, 0.2f, 0.3f, 0.45f, 0.5f, 0.8f, 1.0f };
+	std::vector<float> curvePoints;
+	GpuExport::EvaluateCurve(curveBuffer, params, curvePoints);
+	for (int i = 0; i < params.size(); i++)
+	{
+		XYZ expected = NurbsCurve::GetPointOnCurve(curve, std::max(0.0, (double)params[i]));
+		EXPECT_LT(XYZ(curvePoints[4 * i], curvePoints[4 * i + 1], curvePoints[4 * i + 2]).Distance(expected), 1E-4);
+	}
+
+	EXPECT_EQ(std::string(GpuExport::GetCurveShaderSource()).compare(0, 12, "#version 430"), 0);
+	EXPECT_NE(std::string(GpuExport::GetSurfaceShaderSource()).find("cross(su, sv)"), std::string::npos);
+}
+
+TEST(Test_Additional, GeometryStore)
+{
+	LN_NurbsCurve curve;
+	curve.Degree = 3;
+	curve.KnotVector = { 0,0,0,0,0.3,0.5,0.5,1,1,1,1 };
+	curve.ControlPoints = { XYZW(XYZ(0,0,0),1), XYZW(XYZ(1,2,1),2), XYZW(XYZ(3,2,0),0.5), XYZW(XYZ(4,0,-1),1), XYZW(XYZ(5,-1,2),3), XYZW(XYZ(6,1,0),1), XYZW(XYZ(8,0,1),1) };
+	LN_NurbsCurve line;
+	line.Degree = 1;
+	line.KnotVector = { 0,0,1,1 };
+	line.ControlPoints = { XYZW(0,0,0,1), XYZW(2,0,0,1) };
+
+	LN_NurbsSurface surface;
+	surface.DegreeU = 2;
+	surface.DegreeV = 1;
+	surface.KnotVectorU = { 0,0,0,1,1,1 };
+	surface.KnotVectorV = { 0,0,1,1 };
+	surface.ControlPoints = { { XYZW(0,0,0,1), XYZW(0,1,0,1) }, { XYZW(1,0,1,2), XYZW(1,1,1,2) }, { XYZW(2,0,0,1), XYZW(2,1,0,1) } };
+
+	std::vector<LN_NurbsCurve> curves = { curve, line };
+	std::vector<LN_NurbsSurface> surfaces = { surface };
+	std::vector<unsigned char> buffer;
+	GeometryStore::Write(curves, surfaces, true, buffer);
+
+	GeometryStore store;
+	ASSERT_TRUE(store.Open(buffer.data(), buffer.size()));
+	EXPECT_EQ(store.GetCurveCount(), 2);
+	EXPECT_EQ(store.GetSurfaceCount(), 1);
+
+	LN_StoredNurbsCurve view = store.GetCurveView(0);
+	EXPECT_EQ(view.Degree, 3);
+	EXPECT_EQ(view.ControlPointCount, 7);
+	EXPECT_TRUE(reinterpret_cast<const unsigned char*>(view.KnotVector) >= buffer.data());
+	EXPECT_TRUE(view.ControlPoints[4].IsAlmostEqualTo(curve.ControlPoints[4]));
+	ASSERT_TRUE(view.Bounds != nullptr);
+	EXPECT_DOUBLE_EQ(view.Bounds[0], 0.0);
+	EXPECT_DOUBLE_EQ(view.Bounds[3], 8.0);
+
+	LN_NurbsCurve restored;
+	store.GetCurve(0, restored);
+	EXPECT_EQ(restored.KnotVector, curve.KnotVector);
+	EXPECT_TRUE(NurbsCurve::GetPointOnCurve(restored, 0.4).IsAlmostEqualTo(NurbsCurve::GetPointOnCurve(curve, 0.4)));
+
+	LN_StoredNurbsSurface surfaceView = store.GetSurfaceView(0);
+	EXPECT_EQ(surfaceView.Rows, 3);
+	EXPECT_EQ(surfaceView.Columns, 2);
+	EXPECT_TRUE(surfaceView.ControlPoints[2 * 1 + 1].IsAlmostEqualTo(XYZW(1,1,1,2)));
+	LN_NurbsSurface restoredSurface;
+	store.GetSurface(0, restoredSurface);
+	EXPECT_TRUE(NurbsSurface::GetPointOnSurface(restoredSurface, UV(0.3, 0.6)).IsAlmostEqualTo(NurbsSurface::GetPointOnSurface(surface, UV(0.3, 0.6))));
+	EXPECT_THROW(store.GetCurveView(2), std::out_of_range);
+
+	// Views evaluate in place without copying into owning geometry.
+	for (int i = 0; i <= 10; i++)
+	{
+		double t = i / 10.0;
+		EXPECT_TRUE(NurbsCurve::GetPointOnCurve(view, t).IsAlmostEqualTo(NurbsCurve::GetPointOnCurve(curve, t)));
+		EXPECT_TRUE(NurbsSurface::GetPointOnSurface(surfaceView, UV(t, 1 - t)).IsAlmostEqualTo(NurbsSurface::GetPointOnSurface(surface, UV(t, 1 - t))));
+	}
+	EXPECT_THROW(NurbsCurve::GetPointOnCurve(view, 1.5), std::out_of_range);
+
+	std::vector<unsigned char> truncated(buffer.begin(), buffer.end() - 8);
+	EXPECT_FALSE(store.Open(truncated.data(), truncated.size()));
+	EXPECT_FALSE(store.IsOpen());
+	std::vector<unsigned char> corrupted = buffer;
+	corrupted[0] = 'X';
+	EXPECT_FALSE(store.Open(corrupted.data(), corrupted.size()));
+
+	// Record fields are little-endian, curve records start at 32 and the surface record at 96.
+	std::vector<unsigned char> plain;
+	GeometryStore::Write(curves, surfaces, false, plain);
+	ASSERT_TRUE(store.Open(plain.data(), plain.size()));
+	corrupted = plain;
+	for (int k = 0; k < 8; k++)
+	{
+		corrupted[32 + 24 + k] = 0xFF;
+	}
+	EXPECT_FALSE(store.Open(corrupted.data(), corrupted.size()));
+	corrupted = plain;
+	unsigned int rows = 0x7FFFFFFC;
+	unsigned int knotCountU = rows + 3;
+	std::memcpy(&corrupted[96 + 8], &knotCountU, 4);
+	std::memcpy(&corrupted[96 + 16], &rows, 4);
+	EXPECT_FALSE(store.Open(corrupted.data(), corrupted.size()));
+	corrupted = plain;
+	unsigned long long knotsOffset = 0;
+	std::memcpy(&knotsOffset, &corrupted[32 + 16], 8);
+	double decreasing = 0.7;
+	std::memcpy(&corrupted[knotsOffset + 8 * 4], &decreasing, 8);
+	EXPECT_FALSE(store.Open(corrupted.data(), corrupted.size()));
+
+	std::string path = ::testing::TempDir() + "lnlib_geometry_store.bin";
+	ASSERT_TRUE(GeometryStore::WriteFile(path, curves, surfaces, false));
+	GeometryStore mapped;
+	ASSERT_TRUE(mapped.OpenFile(path));
+	EXPECT_TRUE(mapped.GetCurveView(1).Bounds == nullptr);
+	mapped.GetCurve(1, restored);
+	EXPECT_TRUE(NurbsCurve::GetPointOnCurve(restored, 0.5).IsAlmostEqualTo(XYZ(1, 0, 0)));
+	mapped.Close();
+	std::remove(path.c_str());
+}
+
+TEST(Test_Additional, KnotVectorPool)
+{
+	LN_NurbsSurface surface;
+	surface.DegreeU = 2;
+	surface.DegreeV = 3;
+	surface.KnotVectorU = { 0,0,0,0.25,0.5,0.75,1,1,1 };
+	surface.KnotVectorV = { 0,0,0,0,0.2,0.4,0.6,0.8,1,1,1,1 };
+	surface.ControlPoints.resize(6);
+	for (int i = 0; i < 6; i++)
+	{
+		for (int j = 0; j < 8; j++)
+		{
+			surface.ControlPoints[i].emplace_back(XYZW(XYZ(i, j, 0.5 * sin(i + 0.7 * j)), 1.0));
+		}
+	}
+
+	KnotVectorPool pool;
+	{
+		std::vector<LN_SharedNurbsSurface> patches = pool.Share(NurbsSurface::DecomposeToBeziers(surface));
+		ASSERT_EQ(patches.size(), 20);
+		EXPECT_EQ(pool.GetCount(), 2);
+		for (int i = 1; i < patches.size(); i++)
+		{
+			EXPECT_EQ(patches[i].KnotVectorU.get(), patches[0].KnotVectorU.get());
+			EXPECT_EQ(patches[i].KnotVectorV.get(), patches[0].KnotVectorV.get());
+		}
+
+		LN_NurbsSurface restored;
+		KnotVectorPool::ToSurface(patches[7], restored);
+		EXPECT_EQ(restored.KnotVectorV, *patches[7].KnotVectorV);
+	}
+	EXPECT_EQ(pool.GetCount(), 0);
+	pool.Purge();
+
+	LN_NurbsCurve curve;
+	curve.Degree = 2;
+	curve.KnotVector = { 0,0,0,0.5,1,1,1 };
+	curve.ControlPoints = { XYZW(XYZ(0,0,0),1), XYZW(XYZ(1,2,0),2), XYZW(XYZ(3,2,0),1), XYZW(XYZ(4,0,0),1) };
+	LN_SharedNurbsCurve first;
+	pool.Share(curve, first);
+	LN_SharedNurbsCurve second;
+	pool.Share(curve, second);
+	EXPECT_EQ(first.KnotVector.get(), second.KnotVector.get());
+	EXPECT_NE(pool.Intern({ 0,0,1,1 }).get(), first.KnotVector.get());
+
+	LN_BsplineCurveView<XYZW> view(second.Degree, *second.KnotVector, second.ControlPoints);
+	XYZ point = BsplineCurve::GetPointOnCurve(view, 0.3).ToXYZ(true);
+	EXPECT_TRUE(point.IsAlmostEqualTo(NurbsCurve::GetPointOnCurve(curve, 0.3)));
+}
+
+TEST(Test_Additional, Cancellation)
+{
+	LN_NurbsSurface surface;
+	surface.DegreeU = 2;
+	surface.DegreeV = 2;
+	surface.KnotVectorU = { 0,0,0,0.5,1,1,1 };
+	surface.KnotVectorV = { 0,0,0,0.5,1,1,1 };
+	surface.ControlPoints.assign(4, std::vector<XYZW>(4));
+	for (int i = 0; i < 4; i++)
+	{
+		for (int j = 0; j < 4; j++)
+		{
+			surface.ControlPoints[i][j] = XYZW(XYZ(i, j, ((i + j) % 2) * 0.5), 1);
+		}
+	}
+
+	CancellationToken token;
+	EXPECT_FALSE(token.IsCancelled());
+	double area = NurbsSurface::ApproximateArea(surface, 1E-8, nullptr, &token);
+	std::future<double> pending = NurbsSurface::ApproximateAreaAsync(surface, 1E-8, nullptr, &token);
+	EXPECT_DOUBLE_EQ(pending.get(), area);
+
+	token.SetTimeBudget(60000);
+	EXPECT_FALSE(token.IsCancelled());
+	token.SetTimeBudget(0);
+	EXPECT_TRUE(token.IsCancelled());
+	EXPECT_THROW(NurbsSurface::ApproximateArea(surface, 1E-8, 100000, nullptr, &token), OperationCancelledException);
+
+	CancellationToken cancelled;
+	cancelled.Cancel();
+	EXPECT_TRUE(cancelled.IsCancelled());
+	EXPECT_THROW(NurbsSurface::ApproximateArea(surface, 1E-8, nullptr, &cancelled), OperationCancelledException);
+
+	std::vector<std::vector<XYZ>> grid(12, std::vector<XYZ>(10));
+	for (int i = 0; i < 12; i++)
+	{
+		for (int j = 0; j < 10; j++)
+		{
+			grid[i][j] = XYZ(i, j, std::sin(0.5 * i) * std::cos(0.4 * j));
+		}
+	}
+	LN_NurbsSurface fitted;
+	ASSERT_TRUE(NurbsSurface::GlobalApproximation(grid, 3, 3, 6, 5, fitted));
+	std::future<LN_NurbsSurface> pendingFit = NurbsSurface::GlobalApproximationAsync(grid, 3, 3, 6, 5);
+	LN_NurbsSurface asyncFitted = pendingFit.get();
+	ASSERT_EQ(asyncFitted.ControlPoints.size(), fitted.ControlPoints.size());
+	EXPECT_TRUE(asyncFitted.ControlPoints[2][3].IsAlmostEqualTo(fitted.ControlPoints[2][3]));
+	EXPECT_THROW(NurbsSurface::GlobalApproximation(grid, 3, 3, 6, 5, fitted, nullptr, &cancelled), OperationCancelledException);
+	pendingFit = NurbsSurface::GlobalApproximationAsync(grid, 3, 3, 6, 5, nullptr, &cancelled);
+	EXPECT_THROW(pendingFit.get(), OperationCancelledException);
+
+	std::vector<std::vector<XYZ>> degenerate(12, std::vector<XYZ>(10, XYZ(1, 2, 3)));
+	EXPECT_FALSE(NurbsSurface::GlobalApproximation(degenerate, 3, 3, 6, 5, fitted));
+	pendingFit = NurbsSurface::GlobalApproximationAsync(degenerate, 3, 3, 6, 5);
+	EXPECT_THROW(pendingFit.get(), std::runtime_error);
+
+	// Gordon stages pass the token on, so loft and interpolation stop inside their parallel loops.
+	std::vector<LN_NurbsCurve> sections(grid.size());
+	for (int i = 0; i < grid.size(); i++)
+	{
+		NurbsCurve::GlobalInterpolation(3, grid[i], sections[i]);
+	}
+	LN_NurbsSurface lofted;
+	EXPECT_THROW(NurbsSurface::CreateLoftSurface(sections, lofted, nullptr, &cancelled), OperationCancelledException);
+	EXPECT_THROW(NurbsSurface::GlobalInterpolation(grid, 3, 3, lofted, nullptr, &cancelled), OperationCancelledException);
+	NurbsSurface::CreateLoftSurface(sections, lofted);
+	EXPECT_EQ(lofted.ControlPoints[0].size(), sections.size());
+
+	std::vector<XYZ> points;
+	for (int i = 0; i < 60; i++)
+	{
+		points.emplace_back(XYZ(0.1 * i, std::sin(0.1 * i), 0));
+	}
+	LN_NurbsCurve curve;
+	NurbsCurve::GlobalApproximationByErrorBound(3, points, 1E-2, curve);
+	LN_NurbsCurve asyncCurve = NurbsCurve::GlobalApproximationByErrorBoundAsync(3, points, 1E-2).get();
+	EXPECT_EQ(asyncCurve.ControlPoints.size(), curve.ControlPoints.size());
+	std::future<LN_NurbsCurve> pendingCurve = NurbsCurve::GlobalApproximationByErrorBoundAsync(3, points, 1E-2, 0, &cancelled);
+	EXPECT_THROW(pendingCurve.get(), OperationCancelledException);
+}
@@ -22,4 +22,34 @@ TEST(Test_AdvancedSurface, All)
 		EXPECT_TRUE(result[0].size() == 4);
 		EXPECT_TRUE(result[1].size() == 3);
 	}
+
+	{
+		LN_NurbsCurve line;
+		line.Degree = 1;
+		line.KnotVector = { 0,0,1,1 };
+		line.ControlPoints = { XYZW(0,0,0,1), XYZW(2,0,0,1) };
+
+		LN_NurbsCurve middle;
+		middle.Degree = 2;
+		middle.KnotVector = { 0,0,0,1,1,1 };
+		middle.ControlPoints = { XYZW(0,0,1,1), XYZW(1,1,1,1), XYZW(2,0,1,1) };
+
+		LN_NurbsCurve top = middle;
+		top.ControlPoints = { XYZW(0,0,3,1), XYZW(1,2,3,1), XYZW(2,0,3,1) };
+
+		std::vector<LN_NurbsCurve> sections = { line, middle, top };
+		LN_NurbsSurface loft;
+		NurbsSurface::CreateLoftSurface(sections, loft);
+		EXPECT_EQ(loft.DegreeV, 2);
+		EXPECT_EQ(loft.ControlPoints.size(), 3);
+
+		double vl = (1.0 / 3 + sqrt(2.0) / (sqrt(2.0) + sqrt(5.0)) + 1.0 / 3) / 3;
+		for (int i = 0; i <= 4; i++)
+		{
+			double u = i / 4.0;
+			EXPECT_TRUE(NurbsSurface::GetPointOnSurface(loft, UV(u, 0)).IsAlmostEqualTo(NurbsCurve::GetPointOnCurve(line, u)));
+			EXPECT_TRUE(NurbsSurface::GetPointOnSurface(loft, UV(u, vl)).IsAlmostEqualTo(NurbsCurve::GetPointOnCurve(middle, u)));
+			EXPECT_TRUE(NurbsSurface::GetPointOnSurface(loft, UV(u, 1)).IsAlmostEqualTo(NurbsCurve::GetPointOnCurve(top, u)));
+		}
+	}
 }
\ No newline at end of file
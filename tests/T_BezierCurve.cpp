@@ -4,6 +4,8 @@
 #include "XYZW.h"
 #include "MathUtils.h"
 #include "LNObject.h"
+#include "Constants.h"
+#include "Polynomials.h"
 
 using namespace LNLib;
 
@@ -30,4 +32,44 @@ TEST(Test_BezierCurve, All)
 	EXPECT_TRUE(weightedResult.ToXYZ(true).IsAlmostEqualTo(XYZ(3.0 / 5, 4.0 / 5, 0)));
 	weightedResult = BezierCurve::GetPointOnCurveByDeCasteljau(curve1, 0.5);
 	EXPECT_TRUE(weightedResult.ToXYZ(true).IsAlmostEqualTo(XYZ(3.0 / 5, 4.0 / 5, 0)));
-}
\ No newline at end of file
+}
+
+TEST(Test_BezierCurve, BernsteinTable)
+{
+	LN_BezierCurve<XYZW> curve;
+	curve.Degree = 3;
+	curve.ControlPoints = { XYZW(XYZ(0, 0, 0), 1), XYZW(XYZ(1, 2, 0), 2), XYZW(XYZ(3, -1, 1), 0.5), XYZW(XYZ(4, 1, 0), 1) };
+
+	std::vector<double> params;
+	for (int i = 0; i <= 16; i++)
+	{
+		params.emplace_back(i / 16.0);
+	}
+	LN_BernsteinTable table;
+	BezierCurve::CreateBernsteinTable(curve.Degree, params, table);
+	ASSERT_EQ(table.Values.size(), 4 * params.size());
+	for (int i = 0; i < params.size(); i++)
+	{
+		double sum = 0.0;
+		std::vector<double> expected = Polynomials::AllBernstein(3, params[i]);
+		for (int k = 0; k <= 3; k++)
+		{
+			EXPECT_NEAR(table.Values[k * params.size() + i], expected[k], Constants::DoubleEpsilon);
+			sum += table.Values[k * params.size() + i];
+		}
+		EXPECT_NEAR(sum, 1.0, Constants::DoubleEpsilon);
+	}
+
+	std::vector<XYZW> points(params.size());
+	BezierCurve::GetPointsOnCurve(curve, table, points.data());
+	for (int i = 0; i < params.size(); i++)
+	{
+		XYZ expected = BezierCurve::GetPointOnCurveByDeCasteljau(curve, params[i]).ToXYZ(true);
+		EXPECT_TRUE(points[i].ToXYZ(true).IsAlmostEqualTo(expected));
+		EXPECT_TRUE(BezierCurve::GetPointOnCurveByBernstein(curve, params[i]).ToXYZ(true).IsAlmostEqualTo(expected));
+	}
+
+	LN_BernsteinTable quadratic;
+	BezierCurve::CreateBernsteinTable(2, params, quadratic);
+	EXPECT_THROW(BezierCurve::GetPointsOnCurve(curve, quadratic, points.data()), std::invalid_argument);
+}
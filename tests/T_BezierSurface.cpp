@@ -47,3 +47,37 @@ TEST(Test_BezierSurface, All)
 	XYZW weightedResult = BezierSurface::GetPointOnSurfaceByDeCasteljau(bezierSurface1, uv);
 	EXPECT_TRUE(weightedResult.ToXYZ(true).IsAlmostEqualTo(XYZ(0, 3.0 / 5, 4.0 / 5)));
 }
+
+TEST(Test_BezierSurface, BernsteinTable)
+{
+	LN_BezierSurface<XYZW> surface;
+	surface.DegreeU = 3;
+	surface.DegreeV = 2;
+	surface.ControlPoints.resize(4);
+	for (int i = 0; i <= 3; i++)
+	{
+		for (int j = 0; j <= 2; j++)
+		{
+			surface.ControlPoints[i].emplace_back(XYZW(XYZ(i, j, (i * j) % 3), 1.0 + 0.25 * ((i + j) % 2)));
+		}
+	}
+
+	std::vector<double> paramsU = { 0, 0.1, 0.35, 0.5, 0.8, 1 };
+	std::vector<double> paramsV = { 0, 0.2, 0.45, 0.7, 1 };
+	LN_BernsteinTable tableU;
+	LN_BernsteinTable tableV;
+	BezierCurve::CreateBernsteinTable(surface.DegreeU, paramsU, tableU);
+	BezierCurve::CreateBernsteinTable(surface.DegreeV, paramsV, tableV);
+
+	std::vector<XYZW> points(paramsU.size() * paramsV.size());
+	BezierSurface::GetPointsOnSurface(surface, tableU, tableV, points.data());
+	for (int i = 0; i < paramsU.size(); i++)
+	{
+		for (int j = 0; j < paramsV.size(); j++)
+		{
+			XYZ expected = BezierSurface::GetPointOnSurfaceByDeCasteljau(surface, UV(paramsU[i], paramsV[j])).ToXYZ(true);
+			EXPECT_TRUE(points[i * paramsV.size() + j].ToXYZ(true).IsAlmostEqualTo(expected));
+		}
+	}
+	EXPECT_THROW(BezierSurface::GetPointsOnSurface(surface, tableV, tableU, points.data()), std::invalid_argument);
+}
@@ -29,4 +29,19 @@ TEST(Test_BsplineCurve, All)
 	EXPECT_TRUE(ders[1].IsAlmostEqualTo(-0.5 * P2 + 0.5 * P4));
 	ders = BsplineCurve::ComputeDerivativesByAllBasisFunctions(bsplineCurve, 1, paramT);
 	EXPECT_TRUE(ders[1].IsAlmostEqualTo(-0.5 * P2 + 0.5 * P4));
+
+	LN_BsplineCurveView<XYZ> view(degree, knotVector, controlPoints);
+	EXPECT_TRUE(BsplineCurve::GetPointOnCurve(view, paramT).IsAlmostEqualTo(result));
+	ders = BsplineCurve::ComputeDerivatives(view, 1, paramT);
+	EXPECT_TRUE(ders[1].IsAlmostEqualTo(-0.5 * P2 + 0.5 * P4));
+
+	LN_DerivativeWorkspace workspace;
+	XYZ buffered[4];
+	BsplineCurve::ComputeDerivatives(bsplineCurve, 3, paramT, workspace, buffered);
+	ders = BsplineCurve::ComputeDerivatives(bsplineCurve, 3, paramT);
+	for (int k = 0; k <= 3; k++)
+	{
+		EXPECT_TRUE(buffered[k].IsAlmostEqualTo(ders[k]));
+	}
+	EXPECT_TRUE(buffered[3].IsZero());
 }
\ No newline at end of file
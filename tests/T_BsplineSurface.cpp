@@ -82,6 +82,9 @@ TEST(Test_BsplineSurface, All)
 	XYZ checked = N02 * a + N12 * b + N22 * c;
 	EXPECT_TRUE(result.IsAlmostEqualTo(checked));
 
+	LN_BsplineSurfaceView<XYZ> view(degreeU, degreeV, kvU, kvV, controlPoints);
+	EXPECT_TRUE(BsplineSurface::GetPointOnSurface(view, UV(u, v)).IsAlmostEqualTo(checked));
+
 	int derivative = 2;
 
 	std::vector<std::vector<XYZ>> ders = BsplineSurface::ComputeDerivatives(bsplineSurface, derivative, UV(u, v));
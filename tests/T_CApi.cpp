@@ -0,0 +1,177 @@
+﻿#include "gtest/gtest.h"
+#include "LNLibCApi.h"
+#include "XYZ.h"
+#include "XYZW.h"
+#include "UV.h"
+#include "LNObject.h"
+#include "NurbsCurve.h"
+#include "NurbsSurface.h"
+#include "Constants.h"
+#include <cstring>
+#include <vector>
+using namespace LNLib;
+
+TEST(Test_CApi, Curve)
+{
+	// Interleaved xyzw control points read in place, weights at offset 3.
+	double knots[] = { 0, 0, 0, 1, 2, 3, 3, 3 };
+	double data[] = { 0, 0, 0, 1, 1, 1, 0, 4, 3, 2, 0, 1, 4, 1, 0, 1, 5, -1, 0, 1 };
+	LNLib_CurveDesc desc;
+	desc.Degree = 2;
+	desc.ControlPointCount = 5;
+	desc.Knots = knots;
+	desc.ControlPoints = data;
+	desc.ControlPointStride = 4;
+	desc.Weights = data + 3;
+	desc.WeightStride = 4;
+	LNLib_PreparedCurve* curve = nullptr;
+	ASSERT_EQ(LNLib_CreatePreparedCurve(&desc, &curve), LNLIB_STATUS_OK);
+	ASSERT_TRUE(curve != nullptr);
+
+	LN_NurbsCurve expected;
+	expected.Degree = 2;
+	expected.KnotVector.assign(knots, knots + 8);
+	for (int i = 0; i < 5; i++)
+	{
+		expected.ControlPoints.emplace_back(XYZW(XYZ(data[4 * i], data[4 * i + 1], data[4 * i + 2]), data[4 * i + 3]));
+	}
+
+	// Params with stride 2 and points with stride 4, the padding must stay untouched.
+	const int count = 70;
+	std::vector<double> params(2 * count);
+	for (int i = 0; i < count; i++)
+	{
+		params[2 * i] = 3.0 * i / (count - 1);
+	}
+	std::vector<double> points(4 * count, -7.0);
+	ASSERT_EQ(LNLib_GetPointsOnCurve(curve, params.data(), 2, count, points.data(), 4), LNLIB_STATUS_OK);
+	std::vector<double> derivatives(6 * count);
+	ASSERT_EQ(LNLib_ComputeCurveDerivatives(curve, 1, params.data(), 2, count, derivatives.data(), 6), LNLIB_STATUS_OK);
+	for (int i = 0; i < count; i++)
+	{
+		XYZ point(points[4 * i], points[4 * i + 1], points[4 * i + 2]);
+		EXPECT_TRUE(point.IsAlmostEqualTo(NurbsCurve::GetPointOnCurve(expected, params[2 * i])));
+		EXPECT_EQ(points[4 * i + 3], -7.0);
+		std::vector<XYZ> ders = NurbsCurve::ComputeRationalCurveDerivatives(expected, 1, params[2 * i]);
+		EXPECT_TRUE(XYZ(derivatives[6 * i], derivatives[6 * i + 1], derivatives[6 * i + 2]).IsAlmostEqualTo(ders[0]));
+		EXPECT_TRUE(XYZ(derivatives[6 * i + 3], derivatives[6 * i + 4], derivatives[6 * i + 5]).IsAlmostEqualTo(ders[1]));
+	}
+
+	// Sized by a first call without buffers.
+	int pointCount = 0;
+	double error = -1.0;
+	EXPECT_EQ(LNLib_GetCurveLevelOfDetail(curve, 0.01, nullptr, 3, nullptr, 0, &pointCount, &error), LNLIB_STATUS_BUFFER_TOO_SMALL);
+	ASSERT_GT(pointCount, 2);
+	EXPECT_LE(error, 0.01);
+	std::vector<double> levelPoints(3 * pointCount);
+	std::vector<double> levelKnots(pointCount);
+	ASSERT_EQ(LNLib_GetCurveLevelOfDetail(curve, 0.01, levelPoints.data(), 3, levelKnots.data(), pointCount, &pointCount, nullptr), LNLIB_STATUS_OK);
+	for (int k = 0; k < pointCount; k++)
+	{
+		EXPECT_TRUE(XYZ(levelPoints[3 * k], levelPoints[3 * k + 1], levelPoints[3 * k + 2]).IsAlmostEqualTo(NurbsCurve::GetPointOnCurve(expected, levelKnots[k])));
+	}
+
+	double outside = 4.0;
+	EXPECT_EQ(LNLib_GetPointsOnCurve(curve, &outside, 1, 1, points.data(), 3), LNLIB_STATUS_INVALID_ARGUMENT);
+	EXPECT_GT(std::strlen(LNLib_GetLastErrorMessage()), 0);
+	LNLib_DestroyPreparedCurve(curve);
+
+	knots[3] = 2.5;
+	knots[4] = 1;
+	LNLib_PreparedCurve* invalid = curve;
+	EXPECT_EQ(LNLib_CreatePreparedCurve(&desc, &invalid), LNLIB_STATUS_INVALID_ARGUMENT);
+	EXPECT_TRUE(invalid == nullptr);
+	EXPECT_EQ(LNLib_CreatePreparedCurve(nullptr, &invalid), LNLIB_STATUS_INVALID_ARGUMENT);
+}
+
+TEST(Test_CApi, Surface)
+{
+	// Control points stored column major, which the strides transpose on the fly.
+	const int countU = 4;
+	const int countV = 3;
+	double knotsU[] = { 0, 0, 0, 0.5, 1, 1, 1 };
+	double knotsV[] = { 0, 0, 0, 1, 1, 1 };
+	std::vector<double> data(3 * countU * countV);
+	std::vector<double> weights(countU * countV);
+	LN_NurbsSurface expected;
+	expected.DegreeU = 2;
+	expected.DegreeV = 2;
+	expected.KnotVectorU.assign(knotsU, knotsU + 7);
+	expected.KnotVectorV.assign(knotsV, knotsV + 6);
+	expected.ControlPoints.resize(countU, std::vector<XYZW>(countV));
+	for (int i = 0; i < countU; i++)
+	{
+		for (int j = 0; j < countV; j++)
+		{
+			int k = j * countU + i;
+			data[3 * k] = i;
+			data[3 * k + 1] = j;
+			data[3 * k + 2] = (i + 2 * j) % 3;
+			weights[k] = 1.0 + 0.5 * ((i + j) % 2);
+			expected.ControlPoints[i][j] = XYZW(XYZ(data[3 * k], data[3 * k + 1], data[3 * k + 2]), weights[k]);
+		}
+	}
+	LNLib_SurfaceDesc desc;
+	desc.DegreeU = 2;
+	desc.DegreeV = 2;
+	desc.ControlPointCountU = countU;
+	desc.ControlPointCountV = countV;
+	desc.KnotsU = knotsU;
+	desc.KnotsV = knotsV;
+	desc.ControlPoints = data.data();
+	desc.RowStride = 3;
+	desc.ColumnStride = 3 * countU;
+	desc.Weights = weights.data();
+	desc.WeightRowStride = 1;
+	desc.WeightColumnStride = countU;
+	LNLib_PreparedSurface* surface = nullptr;
+	ASSERT_EQ(LNLib_CreatePreparedSurface(&desc, &surface), LNLIB_STATUS_OK);
+
+	std::vector<double> uvs;
+	for (int i = 0; i <= 9; i++)
+	{
+		for (int j = 0; j <= 9; j++)
+		{
+			uvs.emplace_back(i / 9.0);
+			uvs.emplace_back(j / 9.0);
+		}
+	}
+	int count = uvs.size() / 2;
+	std::vector<double> points(3 * count);
+	std::vector<double> normals(3 * count);
+	ASSERT_EQ(LNLib_EvaluateSurface(surface, uvs.data(), 2, count, points.data(), 3, normals.data(), 3), LNLIB_STATUS_OK);
+	for (int i = 0; i < count; i++)
+	{
+		UV uv(uvs[2 * i], uvs[2 * i + 1]);
+		EXPECT_TRUE(XYZ(points[3 * i], points[3 * i + 1], points[3 * i + 2]).IsAlmostEqualTo(NurbsSurface::GetPointOnSurface(expected, uv)));
+		EXPECT_TRUE(XYZ(normals[3 * i], normals[3 * i + 1], normals[3 * i + 2]).IsAlmostEqualTo(NurbsSurface::Normal(expected, uv)));
+	}
+
+	LNLib_MeshBuffers mesh;
+	std::memset(&mesh, 0, sizeof(mesh));
+	EXPECT_EQ(LNLib_GetSurfaceLevelOfDetail(surface, 0.05, &mesh, nullptr), LNLIB_STATUS_BUFFER_TOO_SMALL);
+	ASSERT_GT(mesh.VertexCount, 4);
+	std::vector<double> vertices(3 * mesh.VertexCount);
+	std::vector<double> meshUVs(2 * mesh.VertexCount);
+	std::vector<int> indices(mesh.IndexCount);
+	mesh.Vertices = vertices.data();
+	mesh.VertexStride = 3;
+	mesh.UVs = meshUVs.data();
+	mesh.UVStride = 2;
+	mesh.VertexCapacity = mesh.VertexCount;
+	mesh.Indices = indices.data();
+	mesh.IndexCapacity = mesh.IndexCount;
+	double error = -1.0;
+	ASSERT_EQ(LNLib_GetSurfaceLevelOfDetail(surface, 0.05, &mesh, &error), LNLIB_STATUS_OK);
+	EXPECT_LE(error, 0.05);
+	for (int k = 0; k < mesh.VertexCount; k++)
+	{
+		UV uv(meshUVs[2 * k], meshUVs[2 * k + 1]);
+		EXPECT_TRUE(XYZ(vertices[3 * k], vertices[3 * k + 1], vertices[3 * k + 2]).IsAlmostEqualTo(NurbsSurface::GetPointOnSurface(expected, uv)));
+	}
+	for (int k = 0; k < mesh.IndexCount; k++)
+	{
+		EXPECT_TRUE(indices[k] >= 0 && indices[k] < mesh.VertexCount);
+	}
+	LNLib_DestroyPreparedSurface(surface);
+}
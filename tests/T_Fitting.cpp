@@ -9,6 +9,9 @@
 #include "Interpolation.h"
 #include "Intersection.h"
 #include "LNObject.h"
+#include "StreamingCurveFitter.h"
+#include "CurveProjector.h"
+#include "Constants.h"
 
 using namespace LNLib;
 
@@ -121,6 +124,17 @@ TEST(Test_Fitting, Interpolation)
 		EXPECT_TRUE(C2.IsAlmostEqualTo(P70));
 		XYZ C3 = NurbsSurface::GetPointOnSurface(surface, UV(surface.KnotVectorU[surface.KnotVectorU.size() - 1], surface.KnotVectorV[surface.KnotVectorV.size() - 1]));
 		EXPECT_TRUE(C3.IsAlmostEqualTo(P74));
+
+		std::vector<double> uk;
+		std::vector<double> vl;
+		Interpolation::GetSurfaceMeshParameterization(Q, uk, vl);
+		for (int i = 0; i < Q.size(); i++)
+		{
+			for (int j = 0; j < Q[i].size(); j++)
+			{
+				EXPECT_TRUE(NurbsSurface::GetPointOnSurface(surface, UV(uk[i], vl[j])).IsAlmostEqualTo(Q[i][j]));
+			}
+		}
 	}
 
 	{
@@ -211,6 +225,10 @@ TEST(Test_Fitting, Approximation)
 		auto kv = curve.KnotVector;
 		auto cps = curve.ControlPoints;
 		EXPECT_TRUE(ValidationUtils::IsValidNurbs(3, kv.size(), cps.size()));
+		std::vector<XYZ> startDerivatives = NurbsCurve::ComputeRationalCurveDerivatives(curve, 1, kv.front());
+		std::vector<XYZ> endDerivatives = NurbsCurve::ComputeRationalCurveDerivatives(curve, 1, kv.back());
+		EXPECT_TRUE(startDerivatives[1].IsAlmostEqualTo(D[0]));
+		EXPECT_TRUE(endDerivatives[1].IsAlmostEqualTo(D[1]));
 	}
 	{
 		int degree = 3;
@@ -221,6 +239,31 @@ TEST(Test_Fitting, Approximation)
 		auto cps = curve.ControlPoints;
 		EXPECT_TRUE(ValidationUtils::IsValidNurbs(degree, kv.size(), cps.size()));
 	}
+	{
+		int degree = 3;
+		double maxError = 0.01;
+		std::vector<XYZ> Q;
+		for (int i = 0; i <= 200; i++)
+		{
+			double t = i / 200.0;
+			Q.emplace_back(XYZ(10 * t, 2 * sin(6 * t), cos(3 * t)));
+		}
+		std::vector<double> uk = Interpolation::GetChordParameterization(Q);
+
+		LN_NurbsCurve curve;
+		NurbsCurve::GlobalApproximationByErrorBound(degree, Q, maxError, curve);
+		EXPECT_TRUE(ValidationUtils::IsValidNurbs(degree, curve.KnotVector.size(), curve.ControlPoints.size()));
+		EXPECT_TRUE(curve.ControlPoints.size() < Q.size() / 4);
+		for (int i = 0; i < Q.size(); i++)
+		{
+			EXPECT_LE(NurbsCurve::GetPointOnCurve(curve, uk[i]).Distance(Q[i]), maxError + Constants::DistanceEpsilon);
+		}
+
+		LN_NurbsCurve capped;
+		NurbsCurve::GlobalApproximationByErrorBound(degree, Q, maxError, capped, 10);
+		EXPECT_EQ(capped.ControlPoints.size(), Q.size() + (degree - 1) * (Q.size() - 1) - 10);
+		EXPECT_TRUE(ValidationUtils::IsValidNurbs(degree, capped.KnotVector.size(), capped.ControlPoints.size()));
+	}
 	{
 		XYZ P00 = XYZ(0,  0, 0);
 		XYZ P01 = XYZ(10, 0, 0);
@@ -295,6 +338,8 @@ TEST(Test_Fitting, Approximation)
 		NurbsSurface::GlobalApproximation(Q, degreeU, degreeV, 4, 4, surface);
 		EXPECT_TRUE(ValidationUtils::IsValidNurbs(degreeU, surface.KnotVectorU.size(), surface.ControlPoints.size()));
 		EXPECT_TRUE(ValidationUtils::IsValidNurbs(degreeV, surface.KnotVectorV.size(), surface.ControlPoints[0].size()));
+		EXPECT_TRUE(NurbsSurface::GetPointOnSurface(surface, UV(0, 0)).IsAlmostEqualTo(Q.front().front()));
+		EXPECT_TRUE(NurbsSurface::GetPointOnSurface(surface, UV(1, 1)).IsAlmostEqualTo(Q.back().back()));
 	}
 	{
 		XYZ P00 = XYZ(0, 0, 0);
@@ -448,4 +493,61 @@ TEST(Test_Fitting, Approximation)
 		bool result = NurbsCurve::FitWithCubic(Q, 1, 2, XYZ(0, 1, 0), XYZ(0, -1, 1), 0.1, middlePoints);
 		EXPECT_TRUE(result);
 	}
-}
\ No newline at end of file
+}
+
+TEST(Test_Fitting, StreamingCurveFitter)
+{
+	std::vector<XYZ> points;
+	for (int i = 0; i <= 600; i++)
+	{
+		double t = i * 0.02;
+		points.emplace_back(XYZ(10 * cos(t), 10 * sin(t), 0.5 * t));
+	}
+
+	double maxError = 0.01;
+	StreamingCurveFitter fitter(3, maxError, 1, 64);
+	std::vector<LN_NurbsCurve> segments;
+	for (int start = 0; start < points.size(); start += 50)
+	{
+		std::vector<XYZ> chunk(points.begin() + start, points.begin() + std::min((int)points.size(), start + 50));
+		fitter.AddPoints(chunk);
+		EXPECT_TRUE(fitter.GetWindowSize() <= 64);
+		std::vector<LN_NurbsCurve> finished = fitter.TakeSegments();
+		segments.insert(segments.end(), finished.begin(), finished.end());
+	}
+	fitter.Finish();
+	std::vector<LN_NurbsCurve> finished = fitter.TakeSegments();
+	segments.insert(segments.end(), finished.begin(), finished.end());
+	ASSERT_TRUE(segments.size() > 1);
+	EXPECT_TRUE(fitter.TakeSegments().empty());
+
+	for (int i = 0; i < segments.size(); i++)
+	{
+		EXPECT_EQ(segments[i].Degree, 3);
+		EXPECT_TRUE(ValidationUtils::IsValidNurbs(3, segments[i].KnotVector.size(), segments[i].ControlPoints.size()));
+		if (i == 0) continue;
+		const LN_NurbsCurve& previous = segments[i - 1];
+		EXPECT_TRUE(MathUtils::IsAlmostEqualTo(previous.KnotVector.back(), segments[i].KnotVector.front()));
+		std::vector<XYZ> left = NurbsCurve::ComputeRationalCurveDerivatives(previous, 1, previous.KnotVector.back());
+		std::vector<XYZ> right = NurbsCurve::ComputeRationalCurveDerivatives(segments[i], 1, segments[i].KnotVector.front());
+		EXPECT_TRUE(left[0].IsAlmostEqualTo(right[0]));
+		EXPECT_TRUE(left[1].IsAlmostEqualTo(right[1]));
+	}
+	EXPECT_TRUE(NurbsCurve::GetPointOnCurve(segments.front(), segments.front().KnotVector.front()).IsAlmostEqualTo(points.front()));
+
+	std::vector<CurveProjector> projectors;
+	for (int j = 0; j < segments.size(); j++)
+	{
+		projectors.emplace_back(CurveProjector(segments[j]));
+	}
+	for (int i = 0; i < points.size(); i += 7)
+	{
+		double distance = Constants::MaxDistance;
+		for (int j = 0; j < projectors.size(); j++)
+		{
+			double param = projectors[j].GetParamOnCurve(points[i]);
+			distance = std::min(distance, NurbsCurve::GetPointOnCurve(segments[j], param).Distance(points[i]));
+		}
+		EXPECT_TRUE(distance <= maxError);
+	}
+}
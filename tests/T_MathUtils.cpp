@@ -1,5 +1,10 @@
 #include "gtest/gtest.h"
 #include "MathUtils.h"
+#include "ControlPointsUtils.h"
+#include "LNObject.h"
+#include "XYZW.h"
+#include <algorithm>
+#include <cmath>
 using namespace LNLib;
 
 TEST(Test_MathUtils, Compare)
@@ -39,4 +44,194 @@ TEST(Test_MathUtils, Matrix)
 				MathUtils::IsAlmostEqualTo(upper[2][0], 0) &&
 				MathUtils::IsAlmostEqualTo(upper[2][1], 0) &&
 				MathUtils::IsAlmostEqualTo(upper[2][2], -15));
-}
\ No newline at end of file
+}
+
+TEST(Test_MathUtils, LinearSystem)
+{
+	std::vector<std::vector<double>> a = { {0,2,4},{3,7,2},{2,3,3} };
+	EXPECT_TRUE(MathUtils::IsAlmostEqualTo(MathUtils::GetDeterminant(a, 3), -30));
+
+	std::vector<std::vector<double>> right = { {4,1},{16,0},{11,2} };
+	std::vector<std::vector<double>> x = MathUtils::SolveLinearSystem(a, right);
+	std::vector<std::vector<double>> check = MathUtils::MatrixMultiply(a, x);
+	for (int i = 0; i < 3; i++)
+	{
+		for (int j = 0; j < 2; j++)
+		{
+			EXPECT_TRUE(MathUtils::IsAlmostEqualTo(check[i][j], right[i][j]));
+		}
+	}
+
+	std::vector<std::vector<double>> inverse;
+	EXPECT_TRUE(MathUtils::MakeInverse(a, inverse));
+	std::vector<std::vector<double>> identity = MathUtils::MatrixMultiply(a, inverse);
+	for (int i = 0; i < 3; i++)
+	{
+		for (int j = 0; j < 3; j++)
+		{
+			EXPECT_TRUE(MathUtils::IsAlmostEqualTo(identity[i][j], i == j ? 1.0 : 0.0));
+		}
+	}
+
+	std::vector<std::vector<double>> singular = { {1,2},{2,4} };
+	EXPECT_FALSE(MathUtils::MakeInverse(singular, inverse));
+
+	std::vector<std::vector<double>> zero = MathUtils::CreateMatrix(3, 3);
+	EXPECT_FALSE(MathUtils::MakeInverse(zero, inverse));
+	EXPECT_EQ(MathUtils::GetDeterminant(zero, 3), 0.0);
+	std::vector<std::vector<double>> decomposed;
+	std::vector<int> pivot;
+	EXPECT_FALSE(MathUtils::LUPDecomposition(zero, decomposed, pivot));
+	EXPECT_TRUE(MathUtils::SolveLinearSystem(zero, right).empty());
+}
+
+TEST(Test_MathUtils, BandedLinearSystem)
+{
+	std::vector<std::vector<double>> dense = { {4,1,0,0},{1,4,1,0},{0,2,4,1},{0,0,1,4} };
+	std::vector<std::vector<double>> band = MathUtils::CreateBandedMatrix(4, 1, 1);
+	for (int i = 0; i < 4; i++)
+	{
+		for (int j = std::max(0, i - 1); j <= std::min(3, i + 1); j++)
+		{
+			band[i][j - i + 1] = dense[i][j];
+		}
+	}
+	std::vector<std::vector<double>> right = { {1,2},{2,0},{3,1},{4,5} };
+	std::vector<std::vector<double>> x = MathUtils::SolveBandedLinearSystem(band, 1, 1, right);
+	std::vector<std::vector<double>> checked = MathUtils::SolveLinearSystem(dense, right);
+	for (int i = 0; i < 4; i++)
+	{
+		for (int j = 0; j < 2; j++)
+		{
+			EXPECT_TRUE(MathUtils::IsAlmostEqualTo(x[i][j], checked[i][j]));
+		}
+	}
+
+	std::vector<std::vector<double>> zero = MathUtils::CreateBandedMatrix(4, 1, 1);
+	EXPECT_FALSE(MathUtils::BandedLUDecomposition(zero, 1, 1));
+}
+
+TEST(Test_MathUtils, SymmetricBandedLinearSystem)
+{
+	std::vector<std::vector<double>> dense = { {4,1,1,0,0},{1,5,2,1,0},{1,2,6,1,1},{0,1,1,5,2},{0,0,1,2,4} };
+	std::vector<std::vector<double>> band = MathUtils::CreateBandedMatrix(5, 2, 0);
+	for (int i = 0; i < 5; i++)
+	{
+		for (int j = std::max(0, i - 2); j <= i; j++)
+		{
+			band[i][j - i + 2] = dense[i][j];
+		}
+	}
+	std::vector<std::vector<double>> right = { {1,2},{2,0},{3,1},{4,5},{-1,2} };
+	std::vector<std::vector<double>> x = MathUtils::SolveSymmetricBandedLinearSystem(band, 2, right);
+	std::vector<std::vector<double>> checked = MathUtils::SolveLinearSystem(dense, right);
+	for (int i = 0; i < 5; i++)
+	{
+		for (int j = 0; j < 2; j++)
+		{
+			EXPECT_TRUE(MathUtils::IsAlmostEqualTo(x[i][j], checked[i][j]));
+		}
+	}
+
+	std::vector<std::vector<double>> indefinite = { {0,0,1},{0,1,0},{1,0,0} };
+	std::vector<std::vector<double>> indefiniteBand = MathUtils::CreateBandedMatrix(3, 2, 0);
+	for (int i = 0; i < 3; i++)
+	{
+		for (int j = 0; j <= i; j++)
+		{
+			indefiniteBand[i][j - i + 2] = indefinite[i][j];
+		}
+	}
+	std::vector<std::vector<double>> decomposed = indefiniteBand;
+	EXPECT_FALSE(MathUtils::SymmetricBandedCholeskyDecomposition(decomposed, 2));
+	std::vector<std::vector<double>> y = MathUtils::SolveSymmetricBandedLinearSystem(indefiniteBand, 2, { {1},{2},{3} });
+	EXPECT_TRUE(MathUtils::IsAlmostEqualTo(y[0][0], 3.0));
+	EXPECT_TRUE(MathUtils::IsAlmostEqualTo(y[2][0], 1.0));
+}
+
+TEST(Test_MathUtils, BlockedMatrixMultiply)
+{
+	int rows = 150;
+	int depth = 70;
+	int columns = 131;
+	std::vector<std::vector<double>> left(rows, std::vector<double>(depth));
+	std::vector<std::vector<double>> right(depth, std::vector<double>(columns));
+	for (int i = 0; i < rows; i++)
+	{
+		for (int k = 0; k < depth; k++)
+		{
+			left[i][k] = std::sin(0.3 * i + 0.7 * k);
+		}
+	}
+	for (int k = 0; k < depth; k++)
+	{
+		for (int j = 0; j < columns; j++)
+		{
+			right[k][j] = std::cos(0.2 * k - 0.5 * j);
+		}
+	}
+
+	std::vector<std::vector<double>> product = MathUtils::MatrixMultiply(left, right);
+	ASSERT_EQ(product.size(), rows);
+	double maxError = 0.0;
+	for (int i = 0; i < rows; i++)
+	{
+		ASSERT_EQ(product[i].size(), columns);
+		for (int j = 0; j < columns; j++)
+		{
+			double expected = 0.0;
+			for (int k = 0; k < depth; k++)
+			{
+				expected += left[i][k] * right[k][j];
+			}
+			maxError = std::max(maxError, std::abs(product[i][j] - expected));
+		}
+	}
+	EXPECT_LT(maxError, 1E-12);
+
+	LN_Matrix flatLeft;
+	LN_Matrix flatRight;
+	MathUtils::ToFlatMatrix(left, flatLeft);
+	MathUtils::ToFlatMatrix(right, flatRight);
+	EXPECT_EQ(flatLeft.Elements[3 * depth + 5], left[3][5]);
+	LN_Matrix flatProduct;
+	MathUtils::MatrixMultiply(flatLeft, flatRight, flatProduct);
+	EXPECT_EQ(flatProduct.RowCount, rows);
+	EXPECT_EQ(flatProduct.ColumnCount, columns);
+	EXPECT_TRUE(MathUtils::ToNestedMatrix(flatProduct) == product);
+	EXPECT_THROW(MathUtils::MatrixMultiply(flatLeft, flatLeft, flatProduct), std::invalid_argument);
+
+	std::vector<std::vector<XYZW>> net(depth, std::vector<XYZW>(5));
+	for (int k = 0; k < depth; k++)
+	{
+		for (int l = 0; l < 5; l++)
+		{
+			net[k][l] = XYZW(k + l, k - l, 0.1 * k * l, 1 + 0.01 * k);
+		}
+	}
+	std::vector<std::vector<std::vector<XYZW>>> products(2);
+	products[0] = ControlPointsUtils::Multiply(left, net);
+	std::vector<std::vector<XYZW>> transposedNet;
+	MathUtils::Transpose(net, transposedNet);
+	std::vector<std::vector<double>> transposedLeft;
+	MathUtils::Transpose(left, transposedLeft);
+	products[1] = ControlPointsUtils::Multiply(transposedNet, transposedLeft);
+	ASSERT_EQ(products[0].size(), rows);
+	ASSERT_EQ(products[1].size(), 5);
+	for (int i = 0; i < rows; i++)
+	{
+		for (int l = 0; l < 5; l++)
+		{
+			XYZW expected = XYZW(0, 0, 0, 0);
+			for (int k = 0; k < depth; k++)
+			{
+				expected += left[i][k] * net[k][l];
+			}
+			for (int c = 0; c < 4; c++)
+			{
+				EXPECT_NEAR(products[0][i][l][c], expected[c], 1E-10);
+				EXPECT_NEAR(products[1][l][i][c], expected[c], 1E-10);
+			}
+		}
+	}
+}
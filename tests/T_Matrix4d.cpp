@@ -1,6 +1,7 @@
 #include "gtest/gtest.h"
 #include "Matrix4d.h"
 #include "XYZ.h"
+#include "XYZW.h"
 #include "MathUtils.h"
 using namespace LNLib;
 
@@ -129,5 +130,28 @@ TEST(Test_Matrix4d, OperatorOverride)
 	EXPECT_TRUE(add.IsIdentity());
 }
 
-
-
+TEST(Test_Matrix4d, OfWeightedPoints)
+{
+	std::vector<XYZW> points;
+	for (int i = 0; i < 7; i++)
+	{
+		points.emplace_back(XYZW(XYZ(i, 1 - i, 0.5 * i), 1 + 0.25 * i));
+	}
+	Matrix4d matrices[2] = { Matrix4d::CreateRotation(XYZ(1, 1, 0), 0.3).Multiply(Matrix4d::CreateTranslation(XYZ(1, 2, 3))),
+							 Matrix4d(1, 2, 0, 1, 0, 1, 3, 0, 2, 0, 1, 1, 0.5, 0.1, 0.2, 2) };
+	EXPECT_TRUE(matrices[0].IsAffine());
+	EXPECT_FALSE(matrices[1].IsAffine());
+	for (int k = 0; k < 2; k++)
+	{
+		std::vector<XYZW> result(points.size());
+		matrices[k].OfWeightedPoints(points.data(), points.size(), result.data());
+		std::vector<XYZW> inPlace = points;
+		matrices[k].OfWeightedPoints(inPlace.data(), inPlace.size(), inPlace.data());
+		for (int i = 0; i < points.size(); i++)
+		{
+			XYZW expected = matrices[k].OfWeightedPoint(points[i]);
+			EXPECT_TRUE(result[i].IsAlmostEqualTo(expected));
+			EXPECT_TRUE(inPlace[i].IsAlmostEqualTo(expected));
+		}
+	}
+}
@@ -2,6 +2,12 @@
 #include "XYZ.h"
 #include "XYZW.h"
 #include "NurbsCurve.h"
+#include "CurveProjector.h"
+#include "PreparedCurve.h"
+#include "ScalarEvaluation.h"
+#include "MathUtils.h"
+#include <algorithm>
+#include <cmath>
 using namespace LNLib;
 
 TEST(Test_NurbsCurve, All)
@@ -18,6 +24,45 @@ TEST(Test_NurbsCurve, All)
 	XYZ result = NurbsCurve::GetPointOnCurve(curve, 1.0);
 	EXPECT_TRUE(result.IsAlmostEqualTo(XYZ(7.0/5,6.0/5,0)));
 
+	std::vector<double> params = { 0.0, 0.5, 1.0, 1.0, 2.5, 3.0, 0.25 };
+	std::vector<XYZ> points = NurbsCurve::GetPointsOnCurve(curve, params);
+	for (int i = 0; i < params.size(); i++)
+	{
+		EXPECT_TRUE(points[i].IsAlmostEqualTo(NurbsCurve::GetPointOnCurve(curve, params[i])));
+	}
+
+	LN_CheckedNurbsCurve checkedCurve = NurbsCurve::Check(curve);
+	for (int i = 0; i < params.size(); i++)
+	{
+		EXPECT_TRUE(NurbsCurve::GetPointOnCurve(checkedCurve, params[i]).IsAlmostEqualTo(points[i]));
+		EXPECT_TRUE(NurbsCurve::ComputeRationalCurveDerivatives(checkedCurve, 3, params[i])[1].IsAlmostEqualTo(NurbsCurve::ComputeRationalCurveDerivatives(curve, 3, params[i])[1]));
+	}
+
+	std::vector<double> sortedParams = { 0.0, 0.25, 0.5, 1.0, 2.5, 3.0 };
+	std::vector<XYZ> batchDers(sortedParams.size() * 3);
+	NurbsCurve::ComputeRationalCurveDerivatives(checkedCurve, 2, sortedParams.data(), sortedParams.size(), batchDers.data());
+	LN_DerivativeWorkspace workspace;
+	for (int i = 0; i < sortedParams.size(); i++)
+	{
+		XYZ singleDers[3];
+		NurbsCurve::ComputeRationalCurveDerivatives(checkedCurve, 2, sortedParams[i], workspace, singleDers);
+		std::vector<XYZ> expectedDers = NurbsCurve::ComputeRationalCurveDerivatives(curve, 2, sortedParams[i]);
+		for (int k = 0; k <= 2; k++)
+		{
+			EXPECT_TRUE(batchDers[i * 3 + k].IsAlmostEqualTo(expectedDers[k]) && singleDers[k].IsAlmostEqualTo(expectedDers[k]));
+		}
+	}
+
+	CurveProjector projector(curve);
+	std::vector<XYZ> givenPoints;
+	for (int i = 0; i < params.size(); i++)
+	{
+		givenPoints.emplace_back(points[i]);
+		EXPECT_TRUE(MathUtils::IsAlmostEqualTo(projector.GetParamOnCurve(points[i]), params[i], 1E-4));
+	}
+	std::vector<double> projectedParams = projector.GetParamsOnCurve(givenPoints);
+	EXPECT_TRUE(projectedParams.size() == params.size() && MathUtils::IsAlmostEqualTo(projectedParams[4], 2.5, 1E-4));
+
 	std::vector<double> kv1 = { 0,0,0,1,1,1 };
 	std::vector<XYZW> cps1 = { XYZW(XYZ(1,0,0),1), XYZW(XYZ(1,1,0),1), XYZW(XYZ(0,1,0),2)};
 
@@ -27,4 +72,946 @@ TEST(Test_NurbsCurve, All)
 	std::vector<XYZ> ders = NurbsCurve::ComputeRationalCurveDerivatives(curve, 2, 0.0);
 	EXPECT_TRUE(ders[1].IsAlmostEqualTo(XYZ(0, 2, 0)));
 	EXPECT_TRUE(ders[2].IsAlmostEqualTo(XYZ(-4, 0, 0)));
-}
\ No newline at end of file
+
+	std::vector<XYZ> tessellatedPoints;
+	std::vector<double> correspondingKnots;
+	NurbsCurve::Tessellate(curve, 1E-3, 0.1, tessellatedPoints, correspondingKnots);
+	EXPECT_TRUE(tessellatedPoints.size() > 2 && tessellatedPoints.size() == correspondingKnots.size());
+	EXPECT_TRUE(tessellatedPoints.back().IsAlmostEqualTo(XYZ(0, 1, 0)));
+	for (int i = 0; i < tessellatedPoints.size() - 1; i++)
+	{
+		XYZ chordMiddle = (tessellatedPoints[i] + tessellatedPoints[i + 1]) / 2.0;
+		XYZ curveMiddle = NurbsCurve::GetPointOnCurve(curve, (correspondingKnots[i] + correspondingKnots[i + 1]) / 2.0);
+		EXPECT_TRUE(chordMiddle.Distance(curveMiddle) < 2E-3);
+	}
+
+	LN_NurbsCurve line;
+	line.Degree = 1;
+	line.KnotVector = { 0,0,1,2,3,3 };
+	line.ControlPoints = { XYZW(XYZ(0,0,0),1), XYZW(XYZ(1,0,0),1), XYZW(XYZ(2,0,0),1), XYZW(XYZ(3,0,0),1) };
+	tessellatedPoints.clear();
+	correspondingKnots.clear();
+	NurbsCurve::Tessellate(line, 1E-3, 0.1, tessellatedPoints, correspondingKnots);
+	EXPECT_TRUE(tessellatedPoints.size() == 4);
+
+	LN_NurbsCurve bump;
+	bump.Degree = 2;
+	bump.KnotVector = { 0,0,0,1,1,1 };
+	bump.ControlPoints = { XYZW(XYZ(0,0,0),1), XYZW(XYZ(1,2,0),1), XYZW(XYZ(2,0,0),1) };
+	EXPECT_NEAR(NurbsCurve::GetBoundingBox(bump).Max.GetY(), 2.0, Constants::DoubleEpsilon);
+	LN_BoundingBox bumpBox = NurbsCurve::GetTightBoundingBox(bump);
+	EXPECT_TRUE(bumpBox.Min.IsAlmostEqualTo(XYZ(0, 0, 0)));
+	EXPECT_TRUE(bumpBox.Max.IsAlmostEqualTo(XYZ(2, 1, 0)));
+
+	LN_NurbsCurve circle;
+	NurbsCurve::CreateArc(XYZ(1, 1, 0), XYZ(1, 0, 0), XYZ(0, 1, 0), 0, 2 * Constants::Pi, 2, 2, circle);
+	LN_BoundingBox circleBox = NurbsCurve::GetTightBoundingBox(circle);
+	EXPECT_TRUE(circleBox.Min.IsAlmostEqualTo(XYZ(-1, -1, 0)));
+	EXPECT_TRUE(circleBox.Max.IsAlmostEqualTo(XYZ(3, 3, 0)));
+	std::vector<LN_BoundingBox> spanBoxes = NurbsCurve::GetSpanBoundingBoxes(circle);
+	std::vector<double> uniqueKnots = circle.KnotVector;
+	uniqueKnots.erase(std::unique(uniqueKnots.begin(), uniqueKnots.end()), uniqueKnots.end());
+	EXPECT_EQ(spanBoxes.size(), uniqueKnots.size() - 1);
+	for (int i = 0; i < spanBoxes.size(); i++)
+	{
+		XYZ middle = NurbsCurve::GetPointOnCurve(circle, (uniqueKnots[i] + uniqueKnots[i + 1]) / 2.0);
+		EXPECT_TRUE(middle.GetX() >= spanBoxes[i].Min.GetX() && middle.GetX() <= spanBoxes[i].Max.GetX());
+		EXPECT_TRUE(middle.GetY() >= spanBoxes[i].Min.GetY() && middle.GetY() <= spanBoxes[i].Max.GetY());
+	}
+
+	PreparedCurve prepared(circle);
+	EXPECT_EQ(prepared.GetBeziers().size(), spanBoxes.size());
+	EXPECT_TRUE(prepared.IsClosed());
+	EXPECT_NEAR(NurbsCurve::ApproximateLength(prepared), NurbsCurve::ApproximateLength(circle, IntegratorType::GaussLegendre), Constants::DistanceEpsilon);
+	const std::vector<std::vector<XYZW>>& powerBasis = prepared.GetPowerBasisCoefficients();
+	for (int i = 0; i < powerBasis.size(); i++)
+	{
+		EXPECT_TRUE(prepared.GetSpanBoundingBoxes()[i].Min.IsAlmostEqualTo(spanBoxes[i].Min));
+		XYZW value = powerBasis[i][circle.Degree];
+		for (int j = circle.Degree - 1; j >= 0; j--)
+		{
+			value = value * 0.5 + powerBasis[i][j];
+		}
+		XYZ middle = NurbsCurve::GetPointOnCurve(prepared.Checked(), (uniqueKnots[i] + uniqueKnots[i + 1]) / 2.0);
+		EXPECT_TRUE(value.ToXYZ(true).IsAlmostEqualTo(middle));
+	}
+
+	std::vector<double> preparedParams;
+	for (int i = 0; i <= 32; i++)
+	{
+		preparedParams.emplace_back(uniqueKnots.back() * i / 32.0);
+	}
+	std::vector<XYZ> preparedPoints(preparedParams.size());
+	prepared.GetPointsOnCurve(preparedParams.data(), preparedParams.size(), preparedPoints.data());
+	for (int i = 0; i < preparedParams.size(); i++)
+	{
+		XYZ expected = NurbsCurve::GetPointOnCurve(circle, preparedParams[i]);
+		EXPECT_TRUE(prepared.GetPointOnCurve(preparedParams[i]).IsAlmostEqualTo(expected));
+		EXPECT_TRUE(preparedPoints[i].IsAlmostEqualTo(expected));
+	}
+
+	LN_NurbsCurve inserted;
+	int insertedTimes = NurbsCurve::InsertKnot(circle, 0.3, 2, inserted);
+	LN_NurbsCurve inPlace = circle;
+	EXPECT_EQ(NurbsCurve::InsertKnot(inPlace, 0.3, 2), insertedTimes);
+	std::vector<double> refineElements = { 0.1, 0.5, 0.5, 0.7 };
+	NurbsCurve::RefineKnotVector(inPlace, refineElements);
+	LN_NurbsCurve refined;
+	NurbsCurve::RefineKnotVector(std::move(inserted), refineElements, refined);
+	EXPECT_EQ(inPlace.KnotVector.size(), circle.KnotVector.size() + insertedTimes + refineElements.size());
+	EXPECT_EQ(inPlace.ControlPoints.size(), refined.ControlPoints.size());
+	for (int i = 0; i < inPlace.ControlPoints.size(); i++)
+	{
+		EXPECT_TRUE(inPlace.ControlPoints[i].IsAlmostEqualTo(refined.ControlPoints[i]));
+	}
+	for (int i = 0; i < preparedParams.size(); i++)
+	{
+		EXPECT_TRUE(NurbsCurve::GetPointOnCurve(inPlace, preparedParams[i]).IsAlmostEqualTo(NurbsCurve::GetPointOnCurve(circle, preparedParams[i])));
+	}
+
+	double circleMin = circle.KnotVector.front();
+	double circleMax = circle.KnotVector.back();
+	LN_NurbsCurve chained = NurbsCurve::Reparametrize(NurbsCurve::Reverse(circle), 0.0, 1.0);
+	EXPECT_TRUE(MathUtils::IsAlmostEqualTo(chained.KnotVector.back(), 1.0));
+	for (int i = 0; i <= 8; i++)
+	{
+		double t = i / 8.0;
+		XYZ expected = NurbsCurve::GetPointOnCurve(circle, circleMax - t * (circleMax - circleMin));
+		EXPECT_TRUE(NurbsCurve::GetPointOnCurve(chained, t).IsAlmostEqualTo(expected));
+	}
+}
+
+TEST(Test_NurbsCurve, Offset)
+{
+	LN_NurbsCurve circle;
+	NurbsCurve::CreateArc(XYZ(1, 1, 0), XYZ(1, 0, 0), XYZ(0, 1, 0), 0, 2 * Constants::Pi, 2, 2, circle);
+
+	double maxError = 1E-3;
+	LN_NurbsCurve offsetCurve;
+	EXPECT_TRUE(NurbsCurve::Offset(circle, 0.5, maxError, offsetCurve));
+	EXPECT_EQ(offsetCurve.Degree, 3);
+	LN_NurbsCurve resampled;
+	NurbsCurve::Offset(circle, 0.5, resampled);
+	EXPECT_TRUE(offsetCurve.ControlPoints.size() * 10 < resampled.ControlPoints.size());
+
+	double start = offsetCurve.KnotVector.front();
+	double end = offsetCurve.KnotVector.back();
+	for (int i = 0; i <= 200; i++)
+	{
+		XYZ point = NurbsCurve::GetPointOnCurve(offsetCurve, start + i * (end - start) / 200);
+		// CurveNormal::Normal of a circle points to its center.
+		EXPECT_NEAR(point.Distance(XYZ(1, 1, 0)), 1.5, 2 * maxError);
+	}
+
+	// Straight sections have no principal normal, the line is offset across its chord and the first span along the plane normal.
+	LN_NurbsCurve line;
+	NurbsCurve::CreateLine(XYZ(0, 0, 0), XYZ(4, 0, 0), line);
+	LN_NurbsCurve offsetLine;
+	EXPECT_TRUE(NurbsCurve::Offset(line, 0.5, maxError, offsetLine));
+	for (int i = 0; i <= 20; i++)
+	{
+		XYZ point = NurbsCurve::GetPointOnCurve(offsetLine, i / 20.0);
+		EXPECT_NEAR(point.GetX(), 4 * i / 20.0, 2 * maxError);
+		EXPECT_NEAR(point.Distance(XYZ(point.GetX(), 0, 0)), 0.5, 2 * maxError);
+	}
+
+	LN_NurbsCurve bend;
+	bend.Degree = 3;
+	bend.KnotVector = { 0, 0, 0, 0, 0.5, 1, 1, 1, 1 };
+	bend.ControlPoints = { XYZW(0, 0, 0, 1), XYZW(1, 0, 0, 1), XYZW(2, 0, 0, 1), XYZW(3, 0, 0, 1), XYZW(8, 3, 0, 1) };
+	LN_NurbsCurve offsetBend;
+	EXPECT_TRUE(NurbsCurve::Offset(bend, 0.5, maxError, offsetBend));
+	for (int i = 0; i <= 10; i++)
+	{
+		XYZ point = NurbsCurve::GetPointOnCurve(offsetBend, 0.05 * i);
+		EXPECT_NEAR(point.GetY(), 0.5, 2 * maxError);
+		EXPECT_NEAR(point.GetZ(), 0, 2 * maxError);
+	}
+
+	// Offsetting beyond the radius of curvature folds the offset into a cusp that no cubic fit reaches.
+	LN_NurbsCurve wavy;
+	wavy.Degree = 3;
+	wavy.KnotVector = { 0, 0, 0, 0, 1, 1, 1, 1 };
+	wavy.ControlPoints = { XYZW(0, 0, 0, 1), XYZW(1, 3, 0, 1), XYZW(2, -3, 0, 1), XYZW(3, 0, 0, 1) };
+	LN_NurbsCurve wavyOffset;
+	EXPECT_FALSE(NurbsCurve::Offset(wavy, 2, 1E-4, wavyOffset));
+}
+
+TEST(Test_NurbsCurve, PolynomialPath)
+{
+	LN_NurbsCurve curve;
+	curve.Degree = 3;
+	curve.KnotVector = { 0,0,0,0,0.3,0.7,1,1,1,1 };
+	curve.ControlPoints = { XYZW(0,0,0,1), XYZW(1,2,0,1), XYZW(2,-1,1,1), XYZW(4,3,-1,1), XYZW(5,0,2,1), XYZW(7,1,0,1) };
+
+	// Scaling every weight by the same factor keeps the geometry but takes the rational path.
+	LN_NurbsCurve scaled = curve;
+	for (int i = 0; i < scaled.ControlPoints.size(); i++)
+	{
+		scaled.ControlPoints[i] = XYZW(curve.ControlPoints[i].ToXYZ(true), 2.0);
+	}
+
+	LN_CheckedNurbsCurve checkedCurve = NurbsCurve::Check(curve);
+	LN_CheckedNurbsCurve checkedScaled = NurbsCurve::Check(scaled);
+	EXPECT_FALSE(checkedCurve.IsRational());
+	EXPECT_TRUE(checkedScaled.IsRational());
+
+	std::vector<double> params = { 0.0, 0.1, 0.3, 0.45, 0.7, 0.9, 1.0 };
+	std::vector<XYZ> points(params.size());
+	NurbsCurve::GetPointsOnCurve(checkedCurve, params.data(), params.size(), points.data());
+	std::vector<XYZ> ders(params.size() * 5);
+	NurbsCurve::ComputeRationalCurveDerivatives(checkedCurve, 4, params.data(), params.size(), ders.data());
+	LN_DerivativeWorkspace workspace;
+	for (int i = 0; i < params.size(); i++)
+	{
+		EXPECT_TRUE(points[i].IsAlmostEqualTo(NurbsCurve::GetPointOnCurve(checkedScaled, params[i])));
+		EXPECT_TRUE(NurbsCurve::GetPointOnCurve(checkedCurve, params[i]).IsAlmostEqualTo(points[i]));
+
+		XYZ expected[5];
+		NurbsCurve::ComputeRationalCurveDerivatives(checkedScaled, 4, params[i], workspace, expected);
+		XYZ single[5];
+		NurbsCurve::ComputeRationalCurveDerivatives(checkedCurve, 4, params[i], workspace, single);
+		for (int k = 0; k <= 4; k++)
+		{
+			EXPECT_TRUE(single[k].IsAlmostEqualTo(expected[k]));
+			EXPECT_TRUE(ders[i * 5 + k].IsAlmostEqualTo(expected[k]));
+		}
+		EXPECT_TRUE(single[4].IsZero());
+	}
+
+	PreparedCurve prepared(curve);
+	EXPECT_FALSE(prepared.Checked().IsRational());
+
+	// Unchecked calls decide per span, only the last span sees the rational weight.
+	LN_NurbsCurve partial = curve;
+	partial.ControlPoints[5] = XYZW(partial.ControlPoints[5].ToXYZ(true), 2.5);
+	LN_CheckedNurbsCurve checkedPartial = NurbsCurve::Check(partial);
+	EXPECT_TRUE(checkedPartial.IsRational());
+	for (int i = 0; i < params.size(); i++)
+	{
+		EXPECT_TRUE(NurbsCurve::GetPointOnCurve(partial, params[i]).IsAlmostEqualTo(NurbsCurve::GetPointOnCurve(checkedPartial, params[i])));
+		std::vector<XYZ> unchecked = NurbsCurve::ComputeRationalCurveDerivatives(partial, 3, params[i]);
+		std::vector<XYZ> expected = NurbsCurve::ComputeRationalCurveDerivatives(checkedPartial, 3, params[i]);
+		for (int k = 0; k <= 3; k++)
+		{
+			EXPECT_TRUE(unchecked[k].IsAlmostEqualTo(expected[k]));
+		}
+		EXPECT_NEAR(NurbsCurve::Curvature(partial, params[i]), NurbsCurve::Curvature(checkedPartial, params[i], workspace), 1E-9);
+		EXPECT_NEAR(NurbsCurve::Torsion(partial, params[i]), NurbsCurve::Torsion(checkedPartial, params[i], workspace), 1E-9);
+		EXPECT_TRUE(NurbsCurve::Normal(partial, CurveNormal::Normal, params[i]).IsAlmostEqualTo(NurbsCurve::Normal(checkedPartial, CurveNormal::Normal, params[i], workspace)));
+		EXPECT_TRUE(NurbsCurve::Normal(partial, CurveNormal::Binormal, params[i]).IsAlmostEqualTo(NurbsCurve::Normal(checkedPartial, CurveNormal::Binormal, params[i], workspace)));
+	}
+}
+
+TEST(Test_NurbsCurve, Hodographs)
+{
+	LN_NurbsCurve curve;
+	curve.Degree = 3;
+	curve.KnotVector = { 0,0,0,0,1,2,2,3,3,3,3 };
+	curve.ControlPoints = { XYZW(XYZ(0,0,0),1), XYZW(XYZ(1,2,1),2), XYZW(XYZ(3,2,0),0.5), XYZW(XYZ(4,0,-1),1), XYZW(XYZ(5,-1,2),3), XYZW(XYZ(6,1,0),1), XYZW(XYZ(8,0,1),1) };
+
+	PreparedCurve prepared(curve);
+	const std::vector<LN_BsplineCurve<XYZW>>& hodographs = prepared.GetHodographs();
+	ASSERT_EQ(hodographs.size(), 4);
+	EXPECT_EQ(hodographs[3].Degree, 0);
+	EXPECT_EQ(hodographs[3].ControlPoints.size(), 4);
+
+	std::vector<double> params = { 0.0, 0.4, 1.0, 1.7, 2.0, 2.5, 3.0 };
+	std::vector<XYZ> batch(params.size() * 5);
+	prepared.ComputeDerivatives(4, params.data(), params.size(), batch.data());
+	for (int i = 0; i < params.size(); i++)
+	{
+		std::vector<XYZ> expected = NurbsCurve::ComputeRationalCurveDerivatives(curve, 4, params[i]);
+		std::vector<XYZ> single = prepared.ComputeDerivatives(4, params[i]);
+		for (int k = 0; k <= 4; k++)
+		{
+			EXPECT_TRUE(batch[i * 5 + k].IsAlmostEqualTo(expected[k]));
+			EXPECT_TRUE(single[k].IsAlmostEqualTo(expected[k]));
+		}
+	}
+
+	LN_NurbsCurve polynomial = curve;
+	for (int i = 0; i < polynomial.ControlPoints.size(); i++)
+	{
+		polynomial.ControlPoints[i] = XYZW(curve.ControlPoints[i].ToXYZ(true), 1.0);
+	}
+	PreparedCurve preparedPolynomial(polynomial);
+	for (int i = 0; i < params.size(); i++)
+	{
+		std::vector<XYZ> expected = NurbsCurve::ComputeRationalCurveDerivatives(polynomial, 3, params[i]);
+		std::vector<XYZ> ders = preparedPolynomial.ComputeDerivatives(3, params[i]);
+		for (int k = 0; k <= 3; k++)
+		{
+			EXPECT_TRUE(ders[k].IsAlmostEqualTo(expected[k]));
+		}
+	}
+}
+
+TEST(Test_NurbsCurve, WarmStartProjection)
+{
+	LN_NurbsCurve curve;
+	curve.Degree = 3;
+	curve.KnotVector = { 0,0,0,0,1,2,2,3,3,3,3 };
+	curve.ControlPoints = { XYZW(XYZ(0,0,0),1), XYZW(XYZ(1,2,1),2), XYZW(XYZ(3,2,0),0.5), XYZW(XYZ(4,0,-1),1), XYZW(XYZ(5,-1,2),3), XYZW(XYZ(6,1,0),1), XYZW(XYZ(8,0,1),1) };
+	CurveProjector projector(curve);
+
+	LN_ProjectionOptions options;
+	options.MaxIterations = 20;
+	double previous = 0.0;
+	for (int i = 0; i <= 150; i++)
+	{
+		double t = 3.0 * i / 150;
+		XYZ point = NurbsCurve::GetPointOnCurve(curve, t) + XYZ(0.01, -0.02, 0.01);
+		double tracked = projector.GetParamOnCurve(point, previous, options);
+		double global = projector.GetParamOnCurve(point, options);
+		EXPECT_NEAR(NurbsCurve::GetPointOnCurve(curve, tracked).Distance(point), NurbsCurve::GetPointOnCurve(curve, global).Distance(point), 1E-6);
+		previous = tracked;
+	}
+
+	// A jump far from the previous parameter falls back to the global search.
+	XYZ farPoint = NurbsCurve::GetPointOnCurve(curve, 2.9);
+	EXPECT_NEAR(projector.GetParamOnCurve(farPoint, 0.0), 2.9, 1E-4);
+	EXPECT_NEAR(NurbsCurve::GetParamOnCurve(curve, farPoint, options), 2.9, 1E-4);
+
+	EXPECT_THROW(projector.GetParamOnCurve(farPoint, 3.5), std::out_of_range);
+}
+
+TEST(Test_NurbsCurve, EndPointProjection)
+{
+	LN_NurbsCurve curve;
+	curve.Degree = 3;
+	curve.KnotVector = { 0,0,0,0,1,2,2,3,3,3,3 };
+	curve.ControlPoints = { XYZW(XYZ(0,0,0),1), XYZW(XYZ(1,2,1),2), XYZW(XYZ(3,2,0),0.5), XYZW(XYZ(4,0,-1),1), XYZW(XYZ(5,-1,2),3), XYZW(XYZ(6,1,0),1), XYZW(XYZ(8,0,1),1) };
+	CurveProjector projector(curve);
+
+	const int samples = 3000;
+	std::vector<XYZ> sampledPoints(samples + 1);
+	for (int i = 0; i <= samples; i++)
+	{
+		sampledPoints[i] = NurbsCurve::GetPointOnCurve(curve, 3.0 * i / samples);
+	}
+
+	// Points all around the curve, many of them nearest to an end where Newton iteration has no stationary point to reach.
+	unsigned int state = 12345;
+	for (int i = 0; i < 800; i++)
+	{
+		double coordinates[3];
+		for (int k = 0; k < 3; k++)
+		{
+			state = state * 1103515245u + 12345u;
+			coordinates[k] = (state >> 8) / 16777216.0;
+		}
+		XYZ point(-10 + 28 * coordinates[0], -12 + 24 * coordinates[1], -10 + 20 * coordinates[2]);
+		double sampled = Constants::MaxDistance;
+		for (int j = 0; j <= samples; j++)
+		{
+			sampled = std::min(sampled, sampledPoints[j].Distance(point));
+		}
+		double projected = NurbsCurve::GetPointOnCurve(curve, projector.GetParamOnCurve(point)).Distance(point);
+		EXPECT_LE(projected, sampled + Constants::DistanceEpsilon);
+	}
+
+	XYZ behindStart(-6, -1, 0);
+	EXPECT_NEAR(projector.GetParamOnCurve(behindStart), 0.0, Constants::DoubleEpsilon);
+	XYZ behindEnd(14, -2, 2);
+	EXPECT_NEAR(projector.GetParamOnCurve(behindEnd), 3.0, Constants::DoubleEpsilon);
+}
+
+TEST(Test_NurbsCurve, StatusAPI)
+{
+	LN_NurbsCurve curve;
+	curve.Degree = 3;
+	curve.KnotVector = { 0,0,0,0,1,2,2,3,3,3,3 };
+	curve.ControlPoints = { XYZW(XYZ(0,0,0),1), XYZW(XYZ(1,2,1),2), XYZW(XYZ(3,2,0),0.5), XYZW(XYZ(4,0,-1),1), XYZW(XYZ(5,-1,2),3), XYZW(XYZ(6,1,0),1), XYZW(XYZ(8,0,1),1) };
+	LN_CheckedNurbsCurve checkedCurve = NurbsCurve::Check(curve);
+
+	XYZ point;
+	EXPECT_EQ(NurbsCurve::TryGetPointOnCurve(checkedCurve, 1.5, point), EvaluationStatus::Success);
+	EXPECT_TRUE(point.IsAlmostEqualTo(NurbsCurve::GetPointOnCurve(curve, 1.5)));
+	EXPECT_EQ(NurbsCurve::TryGetPointOnCurve(checkedCurve, 3.5, point), EvaluationStatus::OutOfRange);
+	EXPECT_EQ(NurbsCurve::TryGetPointOnCurve(checkedCurve, std::numeric_limits<double>::quiet_NaN(), point, ParameterRangePolicy::Clamp), EvaluationStatus::InvalidArgument);
+	EXPECT_EQ(NurbsCurve::TryGetPointOnCurve(checkedCurve, 3.5, point, ParameterRangePolicy::Clamp), EvaluationStatus::Success);
+	EXPECT_TRUE(point.IsAlmostEqualTo(XYZ(8, 0, 1)));
+	EXPECT_EQ(NurbsCurve::TryGetPointOnCurve(checkedCurve, -1.0, point, ParameterRangePolicy::Clamp), EvaluationStatus::Success);
+	EXPECT_TRUE(point.IsAlmostEqualTo(XYZ(0, 0, 0)));
+
+	LN_DerivativeWorkspace workspace;
+	XYZ derivatives[3];
+	EXPECT_EQ(NurbsCurve::TryComputeRationalCurveDerivatives(checkedCurve, 2, 0.7, workspace, derivatives), EvaluationStatus::Success);
+	std::vector<XYZ> expected = NurbsCurve::ComputeRationalCurveDerivatives(curve, 2, 0.7);
+	for (int k = 0; k <= 2; k++)
+	{
+		EXPECT_TRUE(derivatives[k].IsAlmostEqualTo(expected[k]));
+	}
+	EXPECT_EQ(NurbsCurve::TryComputeRationalCurveDerivatives(checkedCurve, 0, 0.7, workspace, derivatives), EvaluationStatus::InvalidArgument);
+	EXPECT_EQ(NurbsCurve::TryComputeRationalCurveDerivatives(checkedCurve, 2, 4.0, workspace, derivatives), EvaluationStatus::OutOfRange);
+	EXPECT_EQ(NurbsCurve::TryComputeRationalCurveDerivatives(checkedCurve, 2, 4.0, workspace, derivatives, ParameterRangePolicy::Clamp), EvaluationStatus::Success);
+	expected = NurbsCurve::ComputeRationalCurveDerivatives(curve, 2, 3.0);
+	EXPECT_TRUE(derivatives[1].IsAlmostEqualTo(expected[1]));
+
+	CurveProjector projector(curve);
+	XYZ target = NurbsCurve::GetPointOnCurve(curve, 2.4);
+	double paramT = 0.0;
+	EXPECT_EQ(projector.TryGetParamOnCurve(target, paramT), EvaluationStatus::Success);
+	EXPECT_NEAR(paramT, 2.4, 1E-4);
+	EXPECT_EQ(projector.TryGetParamOnCurve(target, 2.3, paramT), EvaluationStatus::Success);
+	EXPECT_NEAR(paramT, 2.4, 1E-4);
+	EXPECT_EQ(projector.TryGetParamOnCurve(target, 3.5, paramT), EvaluationStatus::OutOfRange);
+	EXPECT_EQ(projector.TryGetParamOnCurve(target, 3.5, paramT, LN_ProjectionOptions(), ParameterRangePolicy::Clamp), EvaluationStatus::Success);
+	EXPECT_NEAR(paramT, 2.4, 1E-4);
+
+	LN_ProjectionOptions options;
+	options.MaxIterations = 0;
+	EXPECT_EQ(projector.TryGetParamOnCurve(target + XYZ(0.3, 0.3, 0.3), paramT, options), EvaluationStatus::NotConverged);
+	options.LocalSearchRange = -1;
+	EXPECT_EQ(projector.TryGetParamOnCurve(target, 2.3, paramT, options), EvaluationStatus::InvalidArgument);
+}
+
+TEST(Test_NurbsCurve, ScalarEvaluation)
+{
+	LN_NurbsCurve curve;
+	curve.Degree = 3;
+	curve.KnotVector = { 0,0,0,0,1,2,2,3,3,3,3 };
+	curve.ControlPoints = { XYZW(XYZ(0,0,0),1), XYZW(XYZ(1,2,1),2), XYZW(XYZ(3,2,0),0.5), XYZW(XYZ(4,0,-1),1), XYZW(XYZ(5,-1,2),3), XYZW(XYZ(6,1,0),1), XYZW(XYZ(8,0,1),1) };
+
+	int count = 37;
+	std::vector<double> params(count);
+	std::vector<float> floatParams(count);
+	for (int i = 0; i < count; i++)
+	{
+		params[i] = 3.0 * i / (count - 1);
+		floatParams[i] = static_cast<float>(params[i]);
+	}
+	std::vector<XYZ> expected = NurbsCurve::GetPointsOnCurve(curve, params);
+
+	LN_ScalarNurbsCurve<float> floatCurve;
+	ScalarEvaluation::Convert(curve, floatCurve);
+	EXPECT_TRUE(floatCurve.IsRational);
+	std::vector<float> floatPoints(3 * count);
+	ScalarEvaluation::GetPointsOnCurve(floatCurve, floatParams.data(), count, floatPoints.data());
+
+	LN_ScalarNurbsCurve<double> doubleCurve;
+	ScalarEvaluation::Convert(curve, doubleCurve);
+	std::vector<double> doublePoints(3 * count);
+	ScalarEvaluation::GetPointsOnCurve(doubleCurve, params.data(), count, doublePoints.data());
+
+	for (int i = 0; i < count; i++)
+	{
+		EXPECT_TRUE(XYZ(doublePoints[3 * i], doublePoints[3 * i + 1], doublePoints[3 * i + 2]).IsAlmostEqualTo(expected[i]));
+		EXPECT_LT(XYZ(floatPoints[3 * i], floatPoints[3 * i + 1], floatPoints[3 * i + 2]).Distance(expected[i]), 1E-4);
+	}
+
+	float outside[2] = { -1.0f, 4.0f };
+	float ends[6];
+	ScalarEvaluation::GetPointsOnCurve(floatCurve, outside, 2, ends);
+	EXPECT_LT(XYZ(ends[0], ends[1], ends[2]).Distance(XYZ(0, 0, 0)), 1E-5);
+	EXPECT_LT(XYZ(ends[3], ends[4], ends[5]).Distance(XYZ(8, 0, 1)), 1E-5);
+}
+
+TEST(Test_NurbsCurve, SplitAtParameters)
+{
+	LN_NurbsCurve curve;
+	curve.Degree = 3;
+	curve.KnotVector = { 0,0,0,0,0.3,0.5,0.5,1,1,1,1 };
+	curve.ControlPoints = { XYZW(XYZ(0,0,0),1), XYZW(XYZ(1,2,1),2), XYZW(XYZ(3,2,0),0.5), XYZW(XYZ(4,0,-1),1), XYZW(XYZ(5,-1,2),3), XYZW(XYZ(6,1,0),1), XYZW(XYZ(8,0,1),1) };
+
+	std::vector<double> parameters = { 0.7, 0.5, 0.2, 0.2, 0.0, 1.5 };
+	std::vector<LN_NurbsCurve> pieces = NurbsCurve::SplitAt(curve, parameters);
+	ASSERT_EQ(pieces.size(), 4);
+
+	double bounds[5] = { 0, 0.2, 0.5, 0.7, 1 };
+	for (int i = 0; i < 4; i++)
+	{
+		const LN_NurbsCurve& piece = pieces[i];
+		EXPECT_DOUBLE_EQ(piece.KnotVector[0], bounds[i]);
+		EXPECT_DOUBLE_EQ(piece.KnotVector[piece.KnotVector.size() - 1], bounds[i + 1]);
+		EXPECT_EQ(piece.KnotVector.size(), piece.ControlPoints.size() + piece.Degree + 1);
+		for (int k = 0; k <= 4; k++)
+		{
+			double t = bounds[i] + (bounds[i + 1] - bounds[i]) * k / 4.0;
+			EXPECT_TRUE(NurbsCurve::GetPointOnCurve(piece, t).IsAlmostEqualTo(NurbsCurve::GetPointOnCurve(curve, t)));
+		}
+	}
+
+	LN_NurbsCurve left;
+	LN_NurbsCurve right;
+	NurbsCurve::SplitAt(curve, 0.2, left, right);
+	ASSERT_EQ(left.ControlPoints.size(), pieces[0].ControlPoints.size());
+	for (int i = 0; i < left.ControlPoints.size(); i++)
+	{
+		EXPECT_TRUE(left.ControlPoints[i].IsAlmostEqualTo(pieces[0].ControlPoints[i]));
+	}
+
+	std::vector<LN_NurbsCurve> whole = NurbsCurve::SplitAt(curve, std::vector<double>());
+	ASSERT_EQ(whole.size(), 1);
+	EXPECT_EQ(whole[0].KnotVector, curve.KnotVector);
+}
+
+TEST(Test_NurbsCurve, MergeCurves)
+{
+	int count = 50;
+	std::vector<LN_NurbsCurve> segments(count);
+	for (int i = 0; i < count; i++)
+	{
+		LN_NurbsCurve& segment = segments[i];
+		XYZ start(i, 0, 0);
+		XYZ end(i + 1, 0, 0);
+		if (i % 2 == 0)
+		{
+			segment.Degree = 1;
+			segment.KnotVector = { 0,0,1,1 };
+			segment.ControlPoints = { XYZW(start,1), XYZW(end,1) };
+		}
+		else
+		{
+			segment.Degree = 2;
+			segment.KnotVector = { 0,0,0,1,1,1 };
+			segment.ControlPoints = { XYZW(start,1), XYZW(XYZ(i + 0.5, 1, 0),2), XYZW(end,1) };
+		}
+	}
+
+	LN_NurbsCurve merged;
+	ASSERT_TRUE(NurbsCurve::Merge(segments, merged));
+	EXPECT_EQ(merged.Degree, 2);
+	EXPECT_DOUBLE_EQ(merged.KnotVector[merged.KnotVector.size() - 1], count);
+	EXPECT_EQ(merged.KnotVector.size(), merged.ControlPoints.size() + merged.Degree + 1);
+	for (int i = 0; i < count; i++)
+	{
+		for (int k = 0; k <= 4; k++)
+		{
+			double t = k / 4.0;
+			EXPECT_TRUE(NurbsCurve::GetPointOnCurve(merged, i + t).IsAlmostEqualTo(NurbsCurve::GetPointOnCurve(segments[i], t)));
+		}
+	}
+
+	LN_NurbsCurve pair;
+	ASSERT_TRUE(NurbsCurve::Merge(segments[0], segments[1], pair));
+	EXPECT_TRUE(NurbsCurve::GetPointOnCurve(pair, 1.5).IsAlmostEqualTo(NurbsCurve::GetPointOnCurve(segments[1], 0.5)));
+
+	std::vector<LN_NurbsCurve> gap = { segments[0], segments[2] };
+	EXPECT_FALSE(NurbsCurve::Merge(gap, pair));
+
+	LN_NurbsCurve curve;
+	curve.Degree = 3;
+	curve.KnotVector = { 0,0,0,0,0.3,0.5,0.5,1,1,1,1 };
+	curve.ControlPoints = { XYZW(XYZ(0,0,0),1), XYZW(XYZ(1,2,1),2), XYZW(XYZ(3,2,0),0.5), XYZW(XYZ(4,0,-1),1), XYZW(XYZ(5,-1,2),3), XYZW(XYZ(6,1,0),1), XYZW(XYZ(8,0,1),1) };
+	std::vector<LN_NurbsCurve> pieces = NurbsCurve::SplitAt(curve, { 0.2, 0.5, 0.7 });
+	LN_NurbsCurve rejoined;
+	ASSERT_TRUE(NurbsCurve::Merge(pieces, rejoined));
+	for (int k = 0; k <= 10; k++)
+	{
+		double t = k / 10.0;
+		EXPECT_TRUE(NurbsCurve::GetPointOnCurve(rejoined, t).IsAlmostEqualTo(NurbsCurve::GetPointOnCurve(curve, t)));
+	}
+}
+
+TEST(Test_NurbsCurve, CompactBeziers)
+{
+	LN_NurbsCurve curve;
+	curve.Degree = 3;
+	curve.KnotVector = { 0,0,0,0,0.3,0.5,0.5,1,1,1,1 };
+	curve.ControlPoints = { XYZW(XYZ(0,0,0),1), XYZW(XYZ(1,2,1),2), XYZW(XYZ(3,2,0),0.5), XYZW(XYZ(4,0,-1),1), XYZW(XYZ(5,-1,2),3), XYZW(XYZ(6,1,0),1), XYZW(XYZ(8,0,1),1) };
+
+	LN_BezierSegmentArray segments;
+	NurbsCurve::DecomposeToBeziers(curve, segments);
+	ASSERT_EQ(segments.Count, 3);
+	EXPECT_EQ(segments.ControlPoints.size(), 3 * 4);
+	double bounds[4] = { 0, 0.3, 0.5, 1 };
+	for (int s = 0; s < segments.Count; s++)
+	{
+		EXPECT_DOUBLE_EQ(segments.Domains[2 * s], bounds[s]);
+		EXPECT_DOUBLE_EQ(segments.Domains[2 * s + 1], bounds[s + 1]);
+
+		LN_NurbsCurve bezier;
+		bezier.Degree = 3;
+		bezier.KnotVector = { bounds[s], bounds[s], bounds[s], bounds[s], bounds[s + 1], bounds[s + 1], bounds[s + 1], bounds[s + 1] };
+		bezier.ControlPoints.assign(segments.ControlPoints.begin() + 4 * s, segments.ControlPoints.begin() + 4 * (s + 1));
+		for (int k = 0; k <= 4; k++)
+		{
+			double t = bounds[s] + (bounds[s + 1] - bounds[s]) * k / 4.0;
+			EXPECT_TRUE(NurbsCurve::GetPointOnCurve(bezier, t).IsAlmostEqualTo(NurbsCurve::GetPointOnCurve(curve, t)));
+		}
+	}
+
+	// Every interior knot of a polyline has multiplicity equal to the degree, each segment is one edge.
+	LN_NurbsCurve polyline;
+	polyline.Degree = 1;
+	polyline.KnotVector = { 0, 0, 0.25, 0.5, 1, 1 };
+	polyline.ControlPoints = { XYZW(XYZ(0, 0, 0), 1), XYZW(XYZ(1, 1, 0), 2), XYZW(XYZ(2, 0, 0), 1), XYZW(XYZ(3, 2, 1), 0.5) };
+	NurbsCurve::DecomposeToBeziers(polyline, segments);
+	ASSERT_EQ(segments.Count, 3);
+	EXPECT_EQ(segments.ControlPoints.size(), 3 * 2);
+	double edgeBounds[4] = { 0, 0.25, 0.5, 1 };
+	for (int s = 0; s < segments.Count; s++)
+	{
+		EXPECT_DOUBLE_EQ(segments.Domains[2 * s], edgeBounds[s]);
+		EXPECT_DOUBLE_EQ(segments.Domains[2 * s + 1], edgeBounds[s + 1]);
+		EXPECT_TRUE(segments.ControlPoints[2 * s].IsAlmostEqualTo(polyline.ControlPoints[s]));
+		EXPECT_TRUE(segments.ControlPoints[2 * s + 1].IsAlmostEqualTo(polyline.ControlPoints[s + 1]));
+	}
+}
+
+TEST(Test_NurbsCurve, PreparedBeziers)
+{
+	LN_NurbsCurve polyline;
+	polyline.Degree = 1;
+	polyline.KnotVector = { 0, 0, 0.5, 1, 1 };
+	polyline.ControlPoints = { XYZW(XYZ(0, 0, 0), 1), XYZW(XYZ(1, 1, 0), 1), XYZW(XYZ(2, 0, 0), 1) };
+
+	// A triple interior knot makes the cubic only C0 there.
+	LN_NurbsCurve cusp;
+	cusp.Degree = 3;
+	cusp.KnotVector = { 0, 0, 0, 0, 0.4, 0.4, 0.4, 1, 1, 1, 1 };
+	cusp.ControlPoints = { XYZW(XYZ(0, 0, 0), 1), XYZW(XYZ(1, 2, 0), 2), XYZW(XYZ(3, 2, 1), 0.5), XYZW(XYZ(4, 0, 0), 1), XYZW(XYZ(5, -1, 2), 1), XYZW(XYZ(6, 1, 0), 3), XYZW(XYZ(8, 0, 1), 1) };
+
+	LN_NurbsCurve curves[2] = { polyline, cusp };
+	for (int c = 0; c < 2; c++)
+	{
+		const LN_NurbsCurve& curve = curves[c];
+		std::vector<LN_NurbsCurve> beziers = NurbsCurve::DecomposeToBeziers(curve);
+		ASSERT_EQ(beziers.size(), 2);
+		for (int i = 0; i < beziers.size(); i++)
+		{
+			for (int j = 0; j < beziers[i].ControlPoints.size(); j++)
+			{
+				EXPECT_TRUE(beziers[i].ControlPoints[j].GetW() > 0);
+			}
+		}
+
+		PreparedCurve prepared(curve);
+		EXPECT_EQ(prepared.GetBeziers().size(), 2);
+		for (int i = 0; i <= 20; i++)
+		{
+			double t = i / 20.0;
+			EXPECT_TRUE(prepared.GetPointOnCurve(t).IsAlmostEqualTo(NurbsCurve::GetPointOnCurve(curve, t)));
+		}
+		EXPECT_NEAR(NurbsCurve::ApproximateLength(prepared), NurbsCurve::ApproximateLength(curve, IntegratorType::GaussLegendre), Constants::DistanceEpsilon);
+	}
+	EXPECT_NEAR(NurbsCurve::ApproximateLength(PreparedCurve(polyline)), 2 * sqrt(2.0), Constants::DistanceEpsilon);
+}
+
+TEST(Test_NurbsCurve, DirtyRangeUpdate)
+{
+	LN_NurbsCurve curve;
+	curve.Degree = 3;
+	curve.KnotVector = { 0,0,0,0,1,2,3,4,5,6,7,8,9,9,9,9 };
+	for (int i = 0; i < 12; i++)
+	{
+		curve.ControlPoints.emplace_back(XYZW(XYZ(i, (i % 3) - 1.0, 0.2 * i), 1.0 + 0.1 * (i % 2)));
+	}
+
+	LN_NurbsCurve edited;
+	LN_DirtyRange dirty;
+	ASSERT_TRUE(NurbsCurve::ControlPointReposition(curve, 4.5, 5, XYZ(0, 0, 1), 0.5, edited, dirty));
+	EXPECT_EQ(dirty.FirstIndex, 5);
+	EXPECT_EQ(dirty.LastIndex, 5);
+	EXPECT_DOUBLE_EQ(dirty.Start, 2.0);
+	EXPECT_DOUBLE_EQ(dirty.End, 6.0);
+	EXPECT_EQ(dirty.FirstSpan, 2);
+	EXPECT_EQ(dirty.LastSpan, 5);
+	for (double t = 0.0; t <= 9.0; t += 0.25)
+	{
+		if (t < dirty.Start || t > dirty.End)
+		{
+			EXPECT_TRUE(NurbsCurve::GetPointOnCurve(edited, t).IsAlmostEqualTo(NurbsCurve::GetPointOnCurve(curve, t)));
+		}
+	}
+
+	LN_NurbsCurve weighted;
+	LN_DirtyRange weightDirty;
+	NurbsCurve::WeightModification(curve, 0.5, 0, 0.1, weighted, weightDirty);
+	EXPECT_EQ(weightDirty.FirstSpan, 0);
+	EXPECT_EQ(weightDirty.LastSpan, 0);
+
+	PreparedCurve previous(curve);
+	PreparedCurve updated(previous, edited, dirty);
+	PreparedCurve full(edited);
+	ASSERT_EQ(updated.GetBeziers().size(), full.GetBeziers().size());
+	for (int s = 0; s < full.GetBeziers().size(); s++)
+	{
+		const std::vector<XYZW>& expected = full.GetBeziers()[s].ControlPoints;
+		const std::vector<XYZW>& actual = updated.GetBeziers()[s].ControlPoints;
+		for (int i = 0; i < expected.size(); i++)
+		{
+			EXPECT_TRUE(actual[i].IsAlmostEqualTo(expected[i]));
+		}
+		EXPECT_TRUE(updated.GetSpanBoundingBoxes()[s].Min.IsAlmostEqualTo(full.GetSpanBoundingBoxes()[s].Min));
+		EXPECT_TRUE(updated.GetSpanBoundingBoxes()[s].Max.IsAlmostEqualTo(full.GetSpanBoundingBoxes()[s].Max));
+	}
+	for (double t = 0.0; t <= 9.0; t += 0.3)
+	{
+		EXPECT_TRUE(updated.GetPointOnCurve(t).IsAlmostEqualTo(NurbsCurve::GetPointOnCurve(edited, t)));
+	}
+
+	std::vector<XYZ> points;
+	std::vector<double> knots;
+	NurbsCurve::Tessellate(curve, 1e-3, 0.1, points, knots);
+	NurbsCurve::UpdateTessellation(edited, dirty, 1e-3, 0.1, points, knots);
+	std::vector<XYZ> expectedPoints;
+	std::vector<double> expectedKnots;
+	NurbsCurve::Tessellate(edited, 1e-3, 0.1, expectedPoints, expectedKnots);
+	ASSERT_EQ(knots.size(), expectedKnots.size());
+	for (int i = 0; i < knots.size(); i++)
+	{
+		EXPECT_DOUBLE_EQ(knots[i], expectedKnots[i]);
+		EXPECT_TRUE(points[i].IsAlmostEqualTo(expectedPoints[i]));
+	}
+
+	points.clear();
+	knots.clear();
+	NurbsCurve::EquallyTessellate(curve, points, knots);
+	NurbsCurve::UpdateEqualTessellation(edited, dirty, points, knots);
+	expectedPoints.clear();
+	expectedKnots.clear();
+	NurbsCurve::EquallyTessellate(edited, expectedPoints, expectedKnots);
+	ASSERT_EQ(points.size(), expectedPoints.size());
+	for (int i = 0; i < points.size(); i++)
+	{
+		EXPECT_TRUE(points[i].IsAlmostEqualTo(expectedPoints[i]));
+	}
+}
+
+TEST(Test_NurbsCurve, CachedClassification)
+{
+	LN_NurbsCurve arc;
+	NurbsCurve::CreateArc(XYZ(1, 1, 0), XYZ(1, 0, 0), XYZ(0, 1, 0), 0, 1.5 * Constants::Pi, 2, 2, arc);
+	PreparedCurve preparedArc(arc);
+	EXPECT_FALSE(preparedArc.IsLinear());
+	EXPECT_FALSE(preparedArc.IsClosed());
+	XYZ center;
+	XYZ normal;
+	double radius = 0.0;
+	double sweepAngle = 0.0;
+	ASSERT_TRUE(preparedArc.IsArc(center, normal, radius, sweepAngle));
+	EXPECT_TRUE(center.IsAlmostEqualTo(XYZ(1, 1, 0)));
+	EXPECT_TRUE(normal.IsAlmostEqualTo(XYZ(0, 0, 1)));
+	EXPECT_NEAR(radius, 2.0, Constants::DoubleEpsilon);
+	EXPECT_NEAR(sweepAngle, 1.5 * Constants::Pi, 1E-10);
+	EXPECT_NEAR(NurbsCurve::ApproximateLength(preparedArc), 3 * Constants::Pi, 1E-10);
+
+	LN_NurbsCurve circle;
+	NurbsCurve::CreateArc(XYZ(0, 0, 1), XYZ(0, 1, 0), XYZ(0, 0, 1), 0, 2 * Constants::Pi, 3, 3, circle);
+	PreparedCurve preparedCircle(circle);
+	ASSERT_TRUE(preparedCircle.IsArc(center, normal, radius, sweepAngle));
+	EXPECT_NEAR(sweepAngle, 2 * Constants::Pi, Constants::DoubleEpsilon);
+	EXPECT_NEAR(NurbsCurve::ApproximateLength(preparedCircle), 6 * Constants::Pi, 1E-10);
+
+	LN_NurbsCurve line;
+	line.Degree = 2;
+	line.KnotVector = { 0, 0, 0, 0.3, 1, 1, 1 };
+	line.ControlPoints = { XYZW(XYZ(0, 0, 0), 1), XYZW(XYZ(1, 2, 2), 2), XYZW(XYZ(2, 4, 4), 1), XYZW(XYZ(3, 6, 6), 1) };
+	PreparedCurve preparedLine(line);
+	EXPECT_TRUE(preparedLine.IsLinear());
+	EXPECT_FALSE(preparedLine.IsArc());
+	EXPECT_NEAR(NurbsCurve::ApproximateLength(preparedLine), 9.0, Constants::DoubleEpsilon);
+
+	LN_ProjectionOptions options;
+	options.DistanceTolerance = 1E-10;
+	options.MaxIterations = 20;
+	CurveProjector arcProjector(arc);
+	for (int i = 0; i < 12; i++)
+	{
+		double angle = 0.1 + i * 0.12 * Constants::Pi;
+		double distance = i % 3 == 0 ? 0.5 : (i % 3 == 1 ? 1.9 : 5.0);
+		XYZ direction = XYZ(std::cos(angle), std::sin(angle), 0);
+		XYZ point = XYZ(1, 1, 0.5 * i) + distance * direction;
+		double param = arcProjector.GetParamOnCurve(point, options);
+		XYZ expected = XYZ(1, 1, 0) + 2 * direction;
+		EXPECT_LT(NurbsCurve::GetPointOnCurve(arc, param).Distance(expected), 1E-8);
+	}
+	double outside = arcProjector.GetParamOnCurve(XYZ(3, -2, 0), options);
+	EXPECT_NEAR(outside, arc.KnotVector[arc.KnotVector.size() - 1], Constants::DoubleEpsilon);
+	double axis = arcProjector.GetParamOnCurve(XYZ(1, 1, 4), options);
+	EXPECT_NEAR(axis, arc.KnotVector[0], Constants::DoubleEpsilon);
+
+	CurveProjector lineProjector(line);
+	for (int i = 0; i <= 10; i++)
+	{
+		XYZ foot = XYZ(1, 2, 2) * (0.3 * i);
+		XYZ point = foot + XYZ(2, -1, 0) * (i - 5);
+		double param = lineProjector.GetParamOnCurve(point, options);
+		EXPECT_LT(NurbsCurve::GetPointOnCurve(line, param).Distance(foot), 1E-8);
+	}
+}
+
+TEST(Test_NurbsCurve, LevelsOfDetail)
+{
+	LN_NurbsCurve curve;
+	curve.Degree = 3;
+	curve.KnotVector = { 0, 0, 0, 0, 0.25, 0.5, 0.75, 1, 1, 1, 1 };
+	curve.ControlPoints = { XYZW(XYZ(0, 0, 0), 1), XYZW(XYZ(1, 3, 0), 2), XYZW(XYZ(2, -2, 1), 1), XYZW(XYZ(3, 4, 0), 0.5),
+		XYZW(XYZ(4, -1, 2), 1), XYZW(XYZ(5, 2, 0), 3), XYZW(XYZ(6, 0, 0), 1) };
+	PreparedCurve prepared(curve);
+	const std::vector<LN_CurveLevelOfDetail>& levels = prepared.GetLevelsOfDetail();
+	ASSERT_GT(levels.size(), 2);
+	EXPECT_EQ(&levels, &prepared.GetLevelsOfDetail());
+	for (int k = 0; k < levels.size(); k++)
+	{
+		const LN_CurveLevelOfDetail& lod = levels[k];
+		ASSERT_EQ(lod.Points.size(), 4 * (1 << k) + 1);
+		ASSERT_EQ(lod.Knots.size(), lod.Points.size());
+		if (k > 0)
+		{
+			EXPECT_LT(lod.Error, levels[k - 1].Error);
+		}
+		for (int i = 0; i < lod.Points.size(); i++)
+		{
+			EXPECT_TRUE(lod.Points[i].IsAlmostEqualTo(NurbsCurve::GetPointOnCurve(curve, lod.Knots[i])));
+		}
+		for (int i = 0; i <= 200; i++)
+		{
+			double t = i / 200.0;
+			int interval = std::min(static_cast<int>(std::upper_bound(lod.Knots.begin(), lod.Knots.end(), t) - lod.Knots.begin()) - 1, static_cast<int>(lod.Knots.size()) - 2);
+			XYZ start = lod.Points[interval];
+			XYZ chord = lod.Points[interval + 1] - start;
+			XYZ point = NurbsCurve::GetPointOnCurve(curve, t);
+			double s = std::max(0.0, std::min(1.0, (point - start).DotProduct(chord) / chord.SqrLength()));
+			EXPECT_LE(point.Distance(start + s * chord), lod.Error + Constants::DistanceEpsilon);
+		}
+	}
+
+	EXPECT_EQ(&prepared.GetLevelOfDetail(levels[1].Error), &levels[1]);
+	EXPECT_EQ(&prepared.GetLevelOfDetail(0.5 * (levels[1].Error + levels[2].Error)), &levels[2]);
+	EXPECT_EQ(&prepared.GetLevelOfDetail(0.0), &levels[levels.size() - 1]);
+	EXPECT_EQ(&prepared.GetLevelOfDetail(Constants::MaxDistance), &levels[0]);
+
+	// Levels built on demand keep their address while finer ones are added.
+	PreparedCurve lazy(curve);
+	const LN_CurveLevelOfDetail& coarse = lazy.GetLevelOfDetail(levels[1].Error);
+	EXPECT_EQ(coarse.Points.size(), levels[1].Points.size());
+	const std::vector<LN_CurveLevelOfDetail>& lazyLevels = lazy.GetLevelsOfDetail();
+	ASSERT_EQ(lazyLevels.size(), levels.size());
+	EXPECT_EQ(&coarse, &lazyLevels[1]);
+	for (int k = 0; k < levels.size(); k++)
+	{
+		EXPECT_DOUBLE_EQ(lazyLevels[k].Error, levels[k].Error);
+	}
+
+	LN_NurbsCurve line;
+	NurbsCurve::CreateLine(XYZ(0, 0, 0), XYZ(1, 2, 3), line);
+	PreparedCurve preparedLine(line);
+	ASSERT_EQ(preparedLine.GetLevelsOfDetail().size(), 1);
+	EXPECT_EQ(preparedLine.GetLevelOfDetail(0.0).Points.size(), 2);
+}
+
+TEST(Test_NurbsCurve, MinimumDistance)
+{
+	// Skew lines, closest at (1,0,0) and (1,0,3).
+	LN_NurbsCurve line0;
+	LN_NurbsCurve line1;
+	NurbsCurve::CreateLine(XYZ(0, 0, 0), XYZ(2, 0, 0), line0);
+	NurbsCurve::CreateLine(XYZ(1, -1, 3), XYZ(1, 1, 3), line1);
+	LN_CurveCurveDistance result = NurbsCurve::MinimumDistance(line0, line1);
+	EXPECT_NEAR(result.Distance, 3.0, Constants::DistanceEpsilon);
+	EXPECT_TRUE(result.Point0.IsAlmostEqualTo(XYZ(1, 0, 0)));
+	EXPECT_TRUE(result.Point1.IsAlmostEqualTo(XYZ(1, 0, 3)));
+	EXPECT_TRUE(result.Point0.IsAlmostEqualTo(NurbsCurve::GetPointOnCurve(line0, result.Param0)));
+	EXPECT_TRUE(result.Point1.IsAlmostEqualTo(NurbsCurve::GetPointOnCurve(line1, result.Param1)));
+
+	// Circle of radius 2 against a line at x = 5, z = 1.
+	LN_NurbsCurve circle;
+	ASSERT_TRUE(NurbsCurve::CreateArc(XYZ(0, 0, 0), XYZ(1, 0, 0), XYZ(0, 1, 0), 0, 2 * Constants::Pi, 2, 2, circle));
+	LN_NurbsCurve line2;
+	NurbsCurve::CreateLine(XYZ(5, -3, 1), XYZ(5, 3, 1), line2);
+	result = NurbsCurve::MinimumDistance(circle, line2);
+	EXPECT_NEAR(result.Distance, std::sqrt(10.0), Constants::DistanceEpsilon);
+	EXPECT_TRUE(result.Point0.IsAlmostEqualTo(XYZ(2, 0, 0)));
+	LN_CurveCurveDistance swapped = NurbsCurve::MinimumDistance(line2, circle);
+	EXPECT_NEAR(swapped.Distance, result.Distance, Constants::DistanceEpsilon);
+	EXPECT_TRUE(swapped.Point1.IsAlmostEqualTo(result.Point0));
+
+	// Polylines decompose to one segment per edge, closest at the vertex (2,2,0) and inside the first edge of the upper polyline.
+	LN_NurbsCurve zigzag;
+	zigzag.Degree = 1;
+	zigzag.KnotVector = { 0, 0, 1, 2, 3, 3 };
+	zigzag.ControlPoints = { XYZW(XYZ(0, 0, 0), 1), XYZW(XYZ(2, 2, 0), 1), XYZW(XYZ(4, 0, 0), 1), XYZW(XYZ(6, 2, 0), 1) };
+	LN_NurbsCurve roof;
+	roof.Degree = 1;
+	roof.KnotVector = { 0, 0, 1, 2, 2 };
+	roof.ControlPoints = { XYZW(XYZ(0, 5, 1), 1), XYZW(XYZ(3, 3, 1), 1), XYZW(XYZ(6, 5, 1), 1) };
+	result = NurbsCurve::MinimumDistance(zigzag, roof);
+	EXPECT_NEAR(result.Distance, std::sqrt(38.0 / 13.0), Constants::DistanceEpsilon);
+	EXPECT_TRUE(result.Point0.IsAlmostEqualTo(XYZ(2, 2, 0)));
+	// The distance is flat along the edge, tolerance on the distance leaves the foot point accurate to about its square root.
+	EXPECT_NEAR(result.Point1.Distance(XYZ(36.0 / 13.0, 41.0 / 13.0, 1)), 0.0, 1E-2);
+	EXPECT_TRUE(result.Point1.IsAlmostEqualTo(NurbsCurve::GetPointOnCurve(roof, result.Param1)));
+	LN_CurveCurveDistance preparedPolylines = NurbsCurve::MinimumDistance(PreparedCurve(zigzag), PreparedCurve(roof));
+	EXPECT_NEAR(preparedPolylines.Distance, result.Distance, Constants::DistanceEpsilon);
+
+	// Rational against an intersecting cubic, never worse than dense sampling.
+	LN_NurbsCurve rational;
+	rational.Degree = 2;
+	rational.KnotVector = { 0,0,0,1,2,3,3,3 };
+	rational.ControlPoints = { XYZW(XYZ(0,0,0),1), XYZW(XYZ(1,1,0),4), XYZW(XYZ(3,2,0),1), XYZW(XYZ(4,1,0),1), XYZW(XYZ(5,-1,0),1) };
+	LN_NurbsCurve cubic;
+	cubic.Degree = 3;
+	cubic.KnotVector = { 0,0,0,0,0.5,1,1,1,1 };
+	cubic.ControlPoints = { XYZW(XYZ(0,3,0.5),1), XYZW(XYZ(1,-1,0.5),1), XYZW(XYZ(2,4,0.3),1), XYZW(XYZ(4,2,0.8),1), XYZW(XYZ(6,-2,0.4),1) };
+	PreparedCurve prepared0(rational);
+	PreparedCurve prepared1(cubic);
+	result = NurbsCurve::MinimumDistance(prepared0, prepared1);
+	const int samples = 400;
+	std::vector<XYZ> points0(samples + 1);
+	std::vector<XYZ> points1(samples + 1);
+	for (int i = 0; i <= samples; i++)
+	{
+		points0[i] = prepared0.GetPointOnCurve(3.0 * i / samples);
+		points1[i] = prepared1.GetPointOnCurve(1.0 * i / samples);
+	}
+	double sampled = Constants::MaxDistance;
+	for (int i = 0; i <= samples; i++)
+	{
+		for (int j = 0; j <= samples; j++)
+		{
+			sampled = std::min(sampled, points0[i].Distance(points1[j]));
+		}
+	}
+	EXPECT_LE(result.Distance, sampled + Constants::DistanceEpsilon);
+	EXPECT_NEAR(result.Distance, result.Point0.Distance(result.Point1), Constants::DoubleEpsilon);
+	EXPECT_TRUE(result.Point0.IsAlmostEqualTo(prepared0.GetPointOnCurve(result.Param0)));
+	EXPECT_TRUE(result.Point1.IsAlmostEqualTo(prepared1.GetPointOnCurve(result.Param1)));
+
+	// Batch results match single calls.
+	std::vector<LN_NurbsCurve> others = { line2, cubic, line0 };
+	PreparedCurve preparedCircle(circle);
+	std::vector<LN_CurveCurveDistance> distances = NurbsCurve::MinimumDistance(preparedCircle, others);
+	ASSERT_EQ(distances.size(), others.size());
+	for (int i = 0; i < others.size(); i++)
+	{
+		LN_CurveCurveDistance single = NurbsCurve::MinimumDistance(circle, others[i]);
+		EXPECT_NEAR(distances[i].Distance, single.Distance, Constants::DistanceEpsilon);
+	}
+	EXPECT_NEAR(distances[2].Distance, 0.0, Constants::DistanceEpsilon);
+
+	EXPECT_THROW(NurbsCurve::MinimumDistance(line0, line1, 0.0), std::invalid_argument);
+}
+
+TEST(Test_NurbsCurve, MinimumDistanceOfConcentricCurves)
+{
+	// Every point is a closest point, pairs along the whole length stay within tolerance of the minimum.
+	LN_NurbsCurve inner;
+	LN_NurbsCurve outer;
+	ASSERT_TRUE(NurbsCurve::CreateArc(XYZ(0, 0, 0), XYZ(1, 0, 0), XYZ(0, 1, 0), 0, 2 * Constants::Pi, 1, 1, inner));
+	ASSERT_TRUE(NurbsCurve::CreateArc(XYZ(0, 0, 0), XYZ(1, 0, 0), XYZ(0, 1, 0), 0, 2 * Constants::Pi, 1.5, 1.5, outer));
+	double tolerances[] = { 1E-5, 1E-6, 1E-9 };
+	for (int i = 0; i < 3; i++)
+	{
+		LN_CurveCurveDistance result = NurbsCurve::MinimumDistance(inner, outer, tolerances[i]);
+		EXPECT_NEAR(result.Distance, 0.5, 1E-5);
+		EXPECT_NEAR(result.Point0.Length(), 1.0, Constants::DoubleEpsilon);
+		EXPECT_NEAR(result.Point1.Length(), 1.5, Constants::DoubleEpsilon);
+	}
+
+	// Offset cubic, translated off its plane by 0.2.
+	LN_NurbsCurve cubic;
+	cubic.Degree = 3;
+	cubic.KnotVector = { 0,0,0,0,0.25,0.5,0.75,1,1,1,1 };
+	cubic.ControlPoints = { XYZW(XYZ(0,0,0),1), XYZW(XYZ(1,2,0),1), XYZW(XYZ(2,-1,0),1), XYZW(XYZ(3,2,0),1), XYZW(XYZ(4,-2,0),1), XYZW(XYZ(5,1,0),1), XYZW(XYZ(6,0,0),1) };
+	LN_NurbsCurve offset = cubic;
+	for (int i = 0; i < offset.ControlPoints.size(); i++)
+	{
+		offset.ControlPoints[i] = XYZW(offset.ControlPoints[i].ToXYZ(true) + XYZ(0, 0, 0.2), 1);
+	}
+	LN_CurveCurveDistance result = NurbsCurve::MinimumDistance(cubic, offset, 1E-7);
+	EXPECT_NEAR(result.Distance, 0.2, 1E-6);
+}
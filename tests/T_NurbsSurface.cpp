@@ -3,9 +3,37 @@
 #include "XYZ.h"
 #include "XYZW.h"
 #include "NurbsSurface.h"
+#include "SurfaceProjector.h"
+#include "PreparedSurface.h"
+#include "ScalarEvaluation.h"
 #include "LNObject.h"
+#include "Matrix4d.h"
+#include "Constants.h"
+#include "MathUtils.h"
+#include "NurbsCurve.h"
+#include "TrimLoopClassifier.h"
+#include <map>
+#include <algorithm>
+#include <cmath>
 using namespace LNLib;
 
+namespace
+{
+	class SequentialExecutor : public ParallelExecutor
+	{
+	public:
+		int Calls = 0;
+		void Execute(int taskCount, ParallelTask& task) override
+		{
+			Calls++;
+			for (int i = 0; i < taskCount; i++)
+			{
+				task(i);
+			}
+		}
+	};
+}
+
 TEST(Test_NurbsSurface, All)
 {
 	int degreeU = 2; 
@@ -85,4 +113,1109 @@ TEST(Test_NurbsSurface, All)
 
 	std::vector<std::vector<XYZ>> ders =  NurbsSurface::ComputeRationalSurfaceDerivatives(surface,1,uv);
 	EXPECT_TRUE(ders[0][0].IsAlmostEqualTo(XYZ(2, 98.0 / 27, 68.0 / 27)));
-}
\ No newline at end of file
+
+	std::vector<double> uParams = { 0.0, 1.5, 2.5, 5.0 };
+	std::vector<double> vParams = { 0.0, 1.0, 2.2, 3.0 };
+	std::vector<std::vector<XYZ>> grid;
+	NurbsSurface::EvaluateGrid(surface, uParams, vParams, grid);
+	for (int i = 0; i < uParams.size(); i++)
+	{
+		for (int j = 0; j < vParams.size(); j++)
+		{
+			EXPECT_TRUE(grid[i][j].IsAlmostEqualTo(NurbsSurface::GetPointOnSurface(surface, UV(uParams[i], vParams[j]))));
+		}
+	}
+
+	LN_CheckedNurbsSurface checkedSurface = NurbsSurface::Check(surface);
+	std::vector<std::vector<XYZ>> checkedGrid;
+	NurbsSurface::EvaluateGrid(checkedSurface, uParams, vParams, checkedGrid);
+	for (int i = 0; i < uParams.size(); i++)
+	{
+		for (int j = 0; j < vParams.size(); j++)
+		{
+			UV gridUV = UV(uParams[i], vParams[j]);
+			EXPECT_TRUE(NurbsSurface::GetPointOnSurface(checkedSurface, gridUV).IsAlmostEqualTo(grid[i][j]));
+			EXPECT_TRUE(checkedGrid[i][j].IsAlmostEqualTo(grid[i][j]));
+			std::vector<std::vector<XYZ>> checkedDers = NurbsSurface::ComputeRationalSurfaceDerivatives(checkedSurface, 2, gridUV);
+			std::vector<std::vector<XYZ>> uncheckedDers = NurbsSurface::ComputeRationalSurfaceDerivatives(surface, 2, gridUV);
+			EXPECT_TRUE(checkedDers[1][1].IsAlmostEqualTo(uncheckedDers[1][1]) && checkedDers[2][0].IsAlmostEqualTo(uncheckedDers[2][0]));
+		}
+	}
+
+	LN_BoundingBox box = NurbsSurface::GetBoundingBox(surface);
+	std::vector<LN_BoundingBox> spanBoxes = NurbsSurface::GetSpanBoundingBoxes(surface);
+	EXPECT_EQ(spanBoxes.size(), 5 * 3);
+	for (int i = 0; i < uParams.size(); i++)
+	{
+		for (int j = 0; j < vParams.size(); j++)
+		{
+			bool isInSpanBox = false;
+			for (int p = 0; p < spanBoxes.size(); p++)
+			{
+				isInSpanBox = isInSpanBox || (grid[i][j].GetX() >= spanBoxes[p].Min.GetX() - Constants::DoubleEpsilon && grid[i][j].GetX() <= spanBoxes[p].Max.GetX() + Constants::DoubleEpsilon &&
+					grid[i][j].GetY() >= spanBoxes[p].Min.GetY() - Constants::DoubleEpsilon && grid[i][j].GetY() <= spanBoxes[p].Max.GetY() + Constants::DoubleEpsilon &&
+					grid[i][j].GetZ() >= spanBoxes[p].Min.GetZ() - Constants::DoubleEpsilon && grid[i][j].GetZ() <= spanBoxes[p].Max.GetZ() + Constants::DoubleEpsilon);
+			}
+			EXPECT_TRUE(isInSpanBox);
+			EXPECT_TRUE(grid[i][j].GetZ() >= box.Min.GetZ() && grid[i][j].GetZ() <= box.Max.GetZ());
+		}
+	}
+
+	PreparedSurface prepared(surface);
+	EXPECT_EQ(prepared.GetBeziers().size(), spanBoxes.size());
+	EXPECT_FALSE(prepared.IsClosed(true));
+	const std::vector<std::vector<std::vector<XYZW>>>& powerBasis = prepared.GetPowerBasisCoefficients();
+	int patchesV = prepared.GetSpanKnotsV().size() - 1;
+	for (int p = 0; p < powerBasis.size(); p++)
+	{
+		EXPECT_TRUE(prepared.GetSpanBoundingBoxes()[p].Max.IsAlmostEqualTo(spanBoxes[p].Max));
+		XYZW value;
+		for (int i = 0; i < powerBasis[p].size(); i++)
+		{
+			for (int j = 0; j < powerBasis[p][i].size(); j++)
+			{
+				value += powerBasis[p][i][j] * (std::pow(0.5, i) * std::pow(0.5, j));
+			}
+		}
+		const std::vector<double>& knotsU = prepared.GetSpanKnotsU();
+		const std::vector<double>& knotsV = prepared.GetSpanKnotsV();
+		UV middle = UV((knotsU[p / patchesV] + knotsU[p / patchesV + 1]) / 2.0, (knotsV[p % patchesV] + knotsV[p % patchesV + 1]) / 2.0);
+		EXPECT_TRUE(value.ToXYZ(true).IsAlmostEqualTo(NurbsSurface::GetPointOnSurface(prepared.Checked(), middle)));
+	}
+
+	LN_FlatNurbsSurface flat;
+	NurbsSurface::ToFlatSurface(surface, flat);
+	EXPECT_TRUE(flat.RowCount == 8 && flat.ColumnCount == 5);
+	EXPECT_TRUE(NurbsSurface::GetPointOnSurface(flat, uv).IsAlmostEqualTo(XYZ(2, 98.0 / 27, 68.0 / 27)));
+
+	LN_FlatNurbsSurface inserted;
+	NurbsSurface::InsertKnot(flat, 2.5, 1, false, inserted);
+	EXPECT_TRUE(inserted.ColumnCount == 6);
+	EXPECT_TRUE(NurbsSurface::GetPointOnSurface(inserted, UV(1.5, 2.2)).IsAlmostEqualTo(NurbsSurface::GetPointOnSurface(surface, UV(1.5, 2.2))));
+
+	LN_NurbsSurface nested;
+	NurbsSurface::ToNestedSurface(flat, nested);
+	EXPECT_TRUE(nested.ControlPoints[3][2].IsAlmostEqualTo(P32));
+
+	std::vector<XYZ> tessellatedPoints;
+	std::vector<UV> correspondingKnots;
+	NurbsSurface::EquallyTessellate(surface, 10, tessellatedPoints, correspondingKnots);
+	EXPECT_TRUE(tessellatedPoints.size() == 50 * 30 + 1);
+	for (int i = 0; i < tessellatedPoints.size(); i += 37)
+	{
+		EXPECT_TRUE(tessellatedPoints[i].IsAlmostEqualTo(NurbsSurface::GetPointOnSurface(surface, correspondingKnots[i])));
+	}
+	EXPECT_TRUE(correspondingKnots[31].IsAlmostEqualTo(UV(0.1, 0.1)));
+
+	SequentialExecutor executor;
+	std::vector<XYZ> sequentialPoints;
+	std::vector<UV> sequentialKnots;
+	NurbsSurface::EquallyTessellate(surface, 10, sequentialPoints, sequentialKnots, &executor);
+	EXPECT_TRUE(executor.Calls == 1);
+	EXPECT_TRUE(sequentialPoints.size() == tessellatedPoints.size());
+	EXPECT_TRUE(sequentialPoints[600].IsAlmostEqualTo(tessellatedPoints[600]));
+	EXPECT_TRUE(sequentialKnots.back().IsAlmostEqualTo(UV(5, 3)));
+
+	LN_Mesh mesh;
+	NurbsSurface::Tessellate(surface, 0.01, 0.2, mesh);
+	EXPECT_TRUE(mesh.Indices.size() > 0 && mesh.Indices.size() % 3 == 0);
+	EXPECT_TRUE(mesh.Normals.size() == mesh.Vertices.size() && mesh.UVs.size() == mesh.Vertices.size());
+	for (int i = 0; i < mesh.Vertices.size(); i += 7)
+	{
+		EXPECT_TRUE(mesh.Vertices[i].IsAlmostEqualTo(NurbsSurface::GetPointOnSurface(surface, mesh.UVs[i])));
+	}
+	std::map<std::pair<int, int>, int> edgeUses;
+	for (int i = 0; i < mesh.Indices.size(); i += 3)
+	{
+		for (int k = 0; k < 3; k++)
+		{
+			int a = mesh.Indices[i + k];
+			int b = mesh.Indices[i + (k + 1) % 3];
+			edgeUses[std::make_pair(std::min(a, b), std::max(a, b))]++;
+		}
+	}
+	bool isCrackFree = true;
+	for (auto it = edgeUses.begin(); it != edgeUses.end(); ++it)
+	{
+		if (it->second == 2) continue;
+		UV a = mesh.UVs[it->first.first];
+		UV b = mesh.UVs[it->first.second];
+		bool onBoundaryU = (a.GetU() == 0 && b.GetU() == 0) || (a.GetU() == 5 && b.GetU() == 5);
+		bool onBoundaryV = (a.GetV() == 0 && b.GetV() == 0) || (a.GetV() == 3 && b.GetV() == 3);
+		isCrackFree = isCrackFree && it->second == 1 && (onBoundaryU || onBoundaryV);
+	}
+	EXPECT_TRUE(isCrackFree);
+
+	SurfaceProjector projector(surface);
+	std::vector<XYZ> givenPoints;
+	for (int i = 0; i < uParams.size(); i++)
+	{
+		UV param = UV(uParams[i], vParams[i]);
+		givenPoints.emplace_back(NurbsSurface::GetPointOnSurface(surface, param));
+		UV projected = projector.GetParamOnSurface(givenPoints.back());
+		EXPECT_TRUE(NurbsSurface::GetPointOnSurface(surface, projected).Distance(givenPoints.back()) < 1E-4);
+	}
+	std::vector<UV> projectedParams = projector.GetParamsOnSurface(givenPoints);
+	EXPECT_TRUE(projectedParams.size() == givenPoints.size());
+	EXPECT_TRUE(NurbsSurface::GetPointOnSurface(surface, projectedParams[1]).Distance(givenPoints[1]) < 1E-4);
+
+	LN_NurbsSurface refined = surface;
+	std::vector<double> refineElements = { 0.5, 1.5, 1.5 };
+	NurbsSurface::RefineKnotVector(refined, refineElements, false);
+	NurbsSurface::RefineKnotVector(refined, refineElements, true);
+	NurbsSurface::InsertKnot(refined, 2.5, 1, true);
+	NurbsSurface::InsertKnot(refined, 2.5, 1, false);
+	EXPECT_EQ(refined.KnotVectorU.size(), surface.KnotVectorU.size() + 4);
+	EXPECT_EQ(refined.KnotVectorV.size(), surface.KnotVectorV.size() + 4);
+	EXPECT_EQ(refined.ControlPoints.size(), surface.ControlPoints.size() + 4);
+	EXPECT_EQ(refined.ControlPoints[0].size(), surface.ControlPoints[0].size() + 4);
+	LN_NurbsSurface moved;
+	NurbsSurface::RefineKnotVector(LN_NurbsSurface(surface), refineElements, false, moved);
+	for (int i = 0; i < uParams.size(); i++)
+	{
+		UV param = UV(uParams[i], vParams[i]);
+		XYZ expected = NurbsSurface::GetPointOnSurface(surface, param);
+		EXPECT_TRUE(NurbsSurface::GetPointOnSurface(refined, param).IsAlmostEqualTo(expected));
+		EXPECT_TRUE(NurbsSurface::GetPointOnSurface(moved, param).IsAlmostEqualTo(expected));
+	}
+
+	LN_NurbsSurface reparametrized = NurbsSurface::Reparametrize(NurbsSurface::Reverse(surface, SurfaceDirection::All), 0, 5, 0, 1);
+	for (int i = 0; i < uParams.size(); i++)
+	{
+		XYZ expected = NurbsSurface::GetPointOnSurface(surface, UV(uParams[i], vParams[i]));
+		UV reversed = UV(5 - uParams[i], (3 - vParams[i]) / 3.0);
+		EXPECT_TRUE(NurbsSurface::GetPointOnSurface(reparametrized, reversed).IsAlmostEqualTo(expected));
+	}
+
+	Matrix4d affine = Matrix4d::CreateRotationAtPoint(XYZ(1, 2, 0), XYZ(0, 1, 1), 0.7).Multiply(Matrix4d::CreateScale(XYZ(2, 1, 3)));
+	Matrix4d projective = Matrix4d(1, 0, 0, 1, 0, 2, 0, 0, 0, 0, 1, 0, 0.1, 0, 0.05, 1);
+	EXPECT_TRUE(affine.IsAffine());
+	EXPECT_FALSE(projective.IsAffine());
+	std::vector<LN_NurbsSurface> surfaces(5, surface);
+	std::vector<LN_NurbsSurface> transformed = NurbsSurface::CreateTransformed(surfaces, affine);
+	NurbsSurface::Transform(surfaces, projective);
+	for (int k = 0; k < surfaces.size(); k++)
+	{
+		for (int i = 0; i < uParams.size(); i++)
+		{
+			UV param = UV(uParams[i], vParams[i]);
+			XYZ point = NurbsSurface::GetPointOnSurface(surface, param);
+			EXPECT_TRUE(NurbsSurface::GetPointOnSurface(transformed[k], param).IsAlmostEqualTo(affine.OfPoint(point)));
+			EXPECT_TRUE(NurbsSurface::GetPointOnSurface(surfaces[k], param).IsAlmostEqualTo(projective.OfPoint(point)));
+		}
+	}
+}
+
+TEST(Test_NurbsSurface, Offset)
+{
+	LN_NurbsSurface cylinder;
+	ASSERT_TRUE(NurbsSurface::CreateCylindricalSurface(XYZ(0, 0, 0), XYZ(1, 0, 0), XYZ(0, 1, 0), 0, Constants::Pi, 2, 3, cylinder));
+	double minU = cylinder.KnotVectorU.front();
+	double maxU = cylinder.KnotVectorU.back();
+	double minV = cylinder.KnotVectorV.front();
+	double maxV = cylinder.KnotVectorV.back();
+
+	std::vector<double> uParams;
+	std::vector<double> vParams;
+	for (int i = 0; i <= 10; i++)
+	{
+		uParams.emplace_back(minU + i * (maxU - minU) / 10);
+		vParams.emplace_back(minV + i * (maxV - minV) / 10);
+	}
+	std::vector<std::vector<XYZ>> points;
+	std::vector<std::vector<XYZ>> normals;
+	NurbsSurface::EvaluateNormalGrid(cylinder, uParams, vParams, points, normals);
+	for (int i = 0; i < uParams.size(); i++)
+	{
+		for (int j = 0; j < vParams.size(); j++)
+		{
+			UV uv = UV(uParams[i], vParams[j]);
+			EXPECT_TRUE(points[i][j].IsAlmostEqualTo(NurbsSurface::GetPointOnSurface(cylinder, uv)));
+			EXPECT_TRUE(normals[i][j].IsAlmostEqualTo(NurbsSurface::Normal(cylinder, uv)));
+		}
+	}
+
+	double tolerance = 1E-3;
+	SequentialExecutor executor;
+	LN_NurbsSurface offsetSurface;
+	EXPECT_TRUE(NurbsSurface::Offset(cylinder, 0.5, tolerance, offsetSurface, &executor));
+	EXPECT_TRUE(executor.Calls > 0);
+
+	// Offsets beyond the radius of curvature of a wavy surface develop cusps no bicubic fit reaches.
+	LN_NurbsSurface wavy;
+	wavy.DegreeU = 3;
+	wavy.DegreeV = 3;
+	wavy.KnotVectorU = { 0,0,0,0,0.5,1,1,1,1 };
+	wavy.KnotVectorV = { 0,0,0,0,0.5,1,1,1,1 };
+	wavy.ControlPoints.resize(5);
+	for (int i = 0; i < 5; i++)
+	{
+		for (int j = 0; j < 5; j++)
+		{
+			wavy.ControlPoints[i].emplace_back(XYZW(XYZ(i, j, (i + j) % 2 == 0 ? 1 : -1), 1));
+		}
+	}
+	LN_NurbsSurface wavyOffset;
+	EXPECT_FALSE(NurbsSurface::Offset(wavy, 2, 1E-4, wavyOffset));
+	EXPECT_FALSE(wavyOffset.ControlPoints.empty());
+	std::vector<std::vector<XYZ>> offsetPoints;
+	std::vector<double> offsetU;
+	std::vector<double> offsetV;
+	for (int i = 0; i <= 20; i++)
+	{
+		offsetU.emplace_back(offsetSurface.KnotVectorU.front() + i * (offsetSurface.KnotVectorU.back() - offsetSurface.KnotVectorU.front()) / 20);
+		offsetV.emplace_back(offsetSurface.KnotVectorV.front() + i * (offsetSurface.KnotVectorV.back() - offsetSurface.KnotVectorV.front()) / 20);
+	}
+	NurbsSurface::EvaluateGrid(offsetSurface, offsetU, offsetV, offsetPoints);
+	XYZ radial = XYZ(points[5][5].GetX(), points[5][5].GetY(), 0).Normalize();
+	double radius = 2 + 0.5 * normals[5][5].DotProduct(radial);
+	for (int i = 0; i < offsetU.size(); i++)
+	{
+		for (int j = 0; j < offsetV.size(); j++)
+		{
+			const XYZ& point = offsetPoints[i][j];
+			EXPECT_NEAR(sqrt(point.GetX() * point.GetX() + point.GetY() * point.GetY()), radius, 2 * tolerance);
+		}
+	}
+}
+
+TEST(Test_NurbsSurface, CurvatureGrid)
+{
+	LN_NurbsSurface cylinder;
+	ASSERT_TRUE(NurbsSurface::CreateCylindricalSurface(XYZ(0, 0, 0), XYZ(1, 0, 0), XYZ(0, 1, 0), 0, Constants::Pi, 2, 3, cylinder));
+	LN_NurbsSurface twisted;
+	NurbsSurface::CreateBilinearSurface(XYZ(0, 0, 0), XYZ(4, 0, 1), XYZ(4, 4, 0), XYZ(0, 4, 1), twisted);
+	LN_NurbsSurface surfaces[2] = { cylinder, twisted };
+
+	SequentialExecutor executor;
+	for (int s = 0; s < 2; s++)
+	{
+		const LN_NurbsSurface& surface = surfaces[s];
+		std::vector<double> uParams;
+		std::vector<double> vParams;
+		for (int i = 0; i <= 12; i++)
+		{
+			uParams.emplace_back(surface.KnotVectorU.front() + i * (surface.KnotVectorU.back() - surface.KnotVectorU.front()) / 12);
+			vParams.emplace_back(surface.KnotVectorV.front() + i * (surface.KnotVectorV.back() - surface.KnotVectorV.front()) / 12);
+		}
+		std::vector<std::vector<LN_SurfaceCurvature>> curvatures;
+		NurbsSurface::EvaluateCurvatureGrid(surface, uParams, vParams, curvatures, &executor);
+		ASSERT_EQ(curvatures.size(), uParams.size());
+		for (int i = 0; i < uParams.size(); i++)
+		{
+			ASSERT_EQ(curvatures[i].size(), vParams.size());
+			for (int j = 0; j < vParams.size(); j++)
+			{
+				UV uv = UV(uParams[i], vParams[j]);
+				const LN_SurfaceCurvature& curvature = curvatures[i][j];
+				EXPECT_NEAR(curvature.Gauss, NurbsSurface::Curvature(surface, SurfaceCurvature::Gauss, uv), 1E-6);
+				EXPECT_NEAR(curvature.Mean, NurbsSurface::Curvature(surface, SurfaceCurvature::Mean, uv), 1E-6);
+				EXPECT_NEAR(curvature.Maximum, NurbsSurface::Curvature(surface, SurfaceCurvature::Maximum, uv), 1E-6);
+				EXPECT_NEAR(curvature.Minimum, NurbsSurface::Curvature(surface, SurfaceCurvature::Minimum, uv), 1E-6);
+
+				XYZ normal = NurbsSurface::Normal(surface, uv);
+				EXPECT_NEAR(curvature.MaximumDirection.DotProduct(normal), 0.0, 1E-6);
+				EXPECT_NEAR(curvature.MinimumDirection.DotProduct(curvature.MaximumDirection), 0.0, 1E-6);
+				if (s == 0)
+				{
+					// Zero curvature runs along the axis of the cylinder.
+					const XYZ& straight = abs(curvature.Maximum) < abs(curvature.Minimum) ? curvature.MaximumDirection : curvature.MinimumDirection;
+					EXPECT_NEAR(abs(straight.GetZ()), 1.0, 1E-6);
+					EXPECT_NEAR(abs(curvature.Maximum - curvature.Minimum), 0.5, 1E-6);
+				}
+			}
+		}
+	}
+	EXPECT_TRUE(executor.Calls > 0);
+}
+
+TEST(Test_NurbsSurface, PolynomialPath)
+{
+	LN_NurbsSurface surface;
+	surface.DegreeU = 2;
+	surface.DegreeV = 3;
+	surface.KnotVectorU = { 0,0,0,0.5,1,1,1 };
+	surface.KnotVectorV = { 0,0,0,0,0.4,1,1,1,1 };
+	surface.ControlPoints.resize(4);
+	for (int i = 0; i < 4; i++)
+	{
+		for (int j = 0; j < 5; j++)
+		{
+			surface.ControlPoints[i].emplace_back(XYZW(i, j, (i - 1.5) * (j - 2) + 0.3 * i * i, 1));
+		}
+	}
+
+	// Scaling every weight by the same factor keeps the geometry but takes the rational path.
+	LN_NurbsSurface scaled = surface;
+	for (int i = 0; i < 4; i++)
+	{
+		for (int j = 0; j < 5; j++)
+		{
+			scaled.ControlPoints[i][j] = XYZW(surface.ControlPoints[i][j].ToXYZ(true), 3.0);
+		}
+	}
+
+	LN_CheckedNurbsSurface checkedSurface = NurbsSurface::Check(surface);
+	LN_CheckedNurbsSurface checkedScaled = NurbsSurface::Check(scaled);
+	EXPECT_FALSE(checkedSurface.IsRational());
+	EXPECT_TRUE(checkedScaled.IsRational());
+
+	std::vector<double> uParams = { 0.0, 0.2, 0.5, 0.8, 1.0 };
+	std::vector<double> vParams = { 0.0, 0.3, 0.4, 0.75, 1.0 };
+	std::vector<std::vector<XYZ>> grid;
+	std::vector<std::vector<XYZ>> expectedGrid;
+	NurbsSurface::EvaluateGrid(checkedSurface, uParams, vParams, grid);
+	NurbsSurface::EvaluateGrid(checkedScaled, uParams, vParams, expectedGrid);
+	std::vector<std::vector<XYZ>> points;
+	std::vector<std::vector<XYZ>> normals;
+	std::vector<std::vector<XYZ>> expectedPoints;
+	std::vector<std::vector<XYZ>> expectedNormals;
+	NurbsSurface::EvaluateNormalGrid(checkedSurface, uParams, vParams, points, normals);
+	NurbsSurface::EvaluateNormalGrid(checkedScaled, uParams, vParams, expectedPoints, expectedNormals);
+	for (int i = 0; i < uParams.size(); i++)
+	{
+		for (int j = 0; j < vParams.size(); j++)
+		{
+			UV uv = UV(uParams[i], vParams[j]);
+			EXPECT_TRUE(grid[i][j].IsAlmostEqualTo(expectedGrid[i][j]));
+			EXPECT_TRUE(NurbsSurface::GetPointOnSurface(checkedSurface, uv).IsAlmostEqualTo(expectedGrid[i][j]));
+			EXPECT_TRUE(points[i][j].IsAlmostEqualTo(expectedPoints[i][j]));
+			EXPECT_TRUE(normals[i][j].IsAlmostEqualTo(expectedNormals[i][j]));
+
+			std::vector<std::vector<XYZ>> ders = NurbsSurface::ComputeRationalSurfaceDerivatives(checkedSurface, 3, uv);
+			std::vector<std::vector<XYZ>> expectedDers = NurbsSurface::ComputeRationalSurfaceDerivatives(checkedScaled, 3, uv);
+			for (int k = 0; k <= 3; k++)
+			{
+				for (int l = 0; l <= 3 - k; l++)
+				{
+					EXPECT_TRUE(ders[k][l].IsAlmostEqualTo(expectedDers[k][l]));
+				}
+			}
+		}
+	}
+
+	// Unchecked calls decide per span, only spans touching the corner see the rational weight.
+	LN_NurbsSurface partial = surface;
+	partial.ControlPoints[3][4] = XYZW(partial.ControlPoints[3][4].ToXYZ(true), 2.5);
+	LN_CheckedNurbsSurface checkedPartial = NurbsSurface::Check(partial);
+	EXPECT_TRUE(checkedPartial.IsRational());
+	for (int i = 0; i < uParams.size(); i++)
+	{
+		for (int j = 0; j < vParams.size(); j++)
+		{
+			UV uv = UV(uParams[i], vParams[j]);
+			EXPECT_TRUE(NurbsSurface::GetPointOnSurface(partial, uv).IsAlmostEqualTo(NurbsSurface::GetPointOnSurface(checkedPartial, uv)));
+			std::vector<std::vector<XYZ>> ders = NurbsSurface::ComputeRationalSurfaceDerivatives(partial, 2, uv);
+			std::vector<std::vector<XYZ>> expectedDers = NurbsSurface::ComputeRationalSurfaceDerivatives(checkedPartial, 2, uv);
+			for (int k = 0; k <= 2; k++)
+			{
+				for (int l = 0; l <= 2 - k; l++)
+				{
+					EXPECT_TRUE(ders[k][l].IsAlmostEqualTo(expectedDers[k][l]));
+				}
+			}
+		}
+	}
+}
+
+TEST(Test_NurbsSurface, Hodographs)
+{
+	LN_NurbsSurface surface;
+	surface.DegreeU = 2;
+	surface.DegreeV = 3;
+	surface.KnotVectorU = { 0,0,0,0.5,0.5,1,1,1 };
+	surface.KnotVectorV = { 0,0,0,0,0.4,1,1,1,1 };
+	surface.ControlPoints.resize(5);
+	for (int i = 0; i < 5; i++)
+	{
+		for (int j = 0; j < 5; j++)
+		{
+			surface.ControlPoints[i].emplace_back(XYZW(XYZ(i, j, (i - 2) * (j - 1.5) + 0.2 * j * j), 1.0 + 0.25 * ((i + 2 * j) % 3)));
+		}
+	}
+
+	PreparedSurface prepared(surface);
+	const std::vector<std::vector<LN_BsplineSurface<XYZW>>>& hodographs = prepared.GetHodographs();
+	ASSERT_EQ(hodographs.size(), 3);
+	ASSERT_EQ(hodographs[2].size(), 4);
+	EXPECT_EQ(hodographs[2][3].DegreeU, 0);
+	EXPECT_EQ(hodographs[2][3].ControlPoints.size(), 3);
+	EXPECT_EQ(hodographs[2][3].ControlPoints[0].size(), 2);
+
+	std::vector<UV> uvs = { UV(0, 0), UV(0.2, 0.3), UV(0.5, 0.4), UV(0.5, 0.9), UV(0.8, 0.1), UV(1, 1) };
+	int derivative = 3;
+	int stride = derivative + 1;
+	std::vector<XYZ> batch(uvs.size() * stride * stride);
+	prepared.ComputeDerivatives(derivative, uvs.data(), uvs.size(), batch.data());
+	for (int i = 0; i < uvs.size(); i++)
+	{
+		std::vector<std::vector<XYZ>> expected = NurbsSurface::ComputeRationalSurfaceDerivatives(prepared.Checked(), derivative, uvs[i]);
+		std::vector<std::vector<XYZ>> single = prepared.ComputeDerivatives(derivative, uvs[i]);
+		for (int k = 0; k <= derivative; k++)
+		{
+			for (int l = 0; l <= derivative - k; l++)
+			{
+				EXPECT_TRUE(single[k][l].IsAlmostEqualTo(expected[k][l]));
+				EXPECT_TRUE(batch[i * stride * stride + k * stride + l].IsAlmostEqualTo(expected[k][l]));
+			}
+		}
+	}
+}
+
+TEST(Test_NurbsSurface, WarmStartProjection)
+{
+	LN_NurbsSurface surface;
+	surface.DegreeU = 2;
+	surface.DegreeV = 3;
+	surface.KnotVectorU = { 0,0,0,0.25,0.5,0.75,1,1,1 };
+	surface.KnotVectorV = { 0,0,0,0,0.2,0.4,0.6,0.8,1,1,1,1 };
+	surface.ControlPoints.resize(6);
+	for (int i = 0; i < 6; i++)
+	{
+		for (int j = 0; j < 8; j++)
+		{
+			surface.ControlPoints[i].emplace_back(XYZW(XYZ(i, j, 0.5 * sin(i + 0.7 * j)), 1.0 + 0.25 * ((i + j) % 2)));
+		}
+	}
+	SurfaceProjector projector(surface);
+
+	LN_ProjectionOptions options;
+	options.MaxIterations = 20;
+	options.LocalSearchRange = 1;
+	UV previous = UV(0, 0);
+	for (int i = 0; i <= 100; i++)
+	{
+		UV uv = UV(0.1 + 0.8 * i / 100, 0.05 + 0.9 * i / 100);
+		XYZ point = NurbsSurface::GetPointOnSurface(surface, uv);
+		UV tracked = projector.GetParamOnSurface(point, previous, options);
+		EXPECT_LT(NurbsSurface::GetPointOnSurface(surface, tracked).Distance(point), 1E-4);
+		previous = tracked;
+	}
+
+	// A jump far from the previous parameter falls back to the global search.
+	XYZ farPoint = NurbsSurface::GetPointOnSurface(surface, UV(0.9, 0.1));
+	UV jumped = projector.GetParamOnSurface(farPoint, UV(0.1, 0.9), options);
+	EXPECT_LT(NurbsSurface::GetPointOnSurface(surface, jumped).Distance(farPoint), 1E-4);
+	UV global = NurbsSurface::GetParamOnSurface(surface, farPoint, options);
+	EXPECT_LT(NurbsSurface::GetPointOnSurface(surface, global).Distance(farPoint), 1E-4);
+}
+
+TEST(Test_NurbsSurface, StatusAPI)
+{
+	LN_NurbsSurface surface;
+	surface.DegreeU = 2;
+	surface.DegreeV = 3;
+	surface.KnotVectorU = { 0,0,0,0.25,0.5,0.75,1,1,1 };
+	surface.KnotVectorV = { 0,0,0,0,0.2,0.4,0.6,0.8,1,1,1,1 };
+	surface.ControlPoints.resize(6);
+	for (int i = 0; i < 6; i++)
+	{
+		for (int j = 0; j < 8; j++)
+		{
+			surface.ControlPoints[i].emplace_back(XYZW(XYZ(i, j, 0.5 * sin(i + 0.7 * j)), 1.0 + 0.25 * ((i + j) % 2)));
+		}
+	}
+	LN_CheckedNurbsSurface checkedSurface = NurbsSurface::Check(surface);
+
+	XYZ point;
+	EXPECT_EQ(NurbsSurface::TryGetPointOnSurface(checkedSurface, UV(0.3, 0.6), point), EvaluationStatus::Success);
+	EXPECT_TRUE(point.IsAlmostEqualTo(NurbsSurface::GetPointOnSurface(surface, UV(0.3, 0.6))));
+	EXPECT_EQ(NurbsSurface::TryGetPointOnSurface(checkedSurface, UV(0.3, 1.2), point), EvaluationStatus::OutOfRange);
+	EXPECT_EQ(NurbsSurface::TryGetPointOnSurface(checkedSurface, UV(-0.2, 1.2), point, ParameterRangePolicy::Clamp), EvaluationStatus::Success);
+	EXPECT_TRUE(point.IsAlmostEqualTo(NurbsSurface::GetPointOnSurface(surface, UV(0.0, 1.0))));
+
+	std::vector<std::vector<XYZ>> derivatives;
+	EXPECT_EQ(NurbsSurface::TryComputeRationalSurfaceDerivatives(checkedSurface, 1, UV(0.3, 0.6), derivatives), EvaluationStatus::Success);
+	std::vector<std::vector<XYZ>> expected = NurbsSurface::ComputeRationalSurfaceDerivatives(surface, 1, UV(0.3, 0.6));
+	EXPECT_TRUE(derivatives[1][0].IsAlmostEqualTo(expected[1][0]));
+	EXPECT_TRUE(derivatives[0][1].IsAlmostEqualTo(expected[0][1]));
+	EXPECT_EQ(NurbsSurface::TryComputeRationalSurfaceDerivatives(checkedSurface, 0, UV(0.3, 0.6), derivatives), EvaluationStatus::InvalidArgument);
+	EXPECT_EQ(NurbsSurface::TryComputeRationalSurfaceDerivatives(checkedSurface, 1, UV(1.5, 0.6), derivatives), EvaluationStatus::OutOfRange);
+
+	SurfaceProjector projector(surface);
+	XYZ target = NurbsSurface::GetPointOnSurface(surface, UV(0.55, 0.35));
+	UV param;
+	EXPECT_EQ(projector.TryGetParamOnSurface(target, param), EvaluationStatus::Success);
+	EXPECT_LT(NurbsSurface::GetPointOnSurface(surface, param).Distance(target), 1E-4);
+	EXPECT_EQ(projector.TryGetParamOnSurface(target, UV(0.5, 0.3), param), EvaluationStatus::Success);
+	EXPECT_LT(NurbsSurface::GetPointOnSurface(surface, param).Distance(target), 1E-4);
+	EXPECT_EQ(projector.TryGetParamOnSurface(target, UV(0.5, 1.3), param), EvaluationStatus::OutOfRange);
+	EXPECT_EQ(projector.TryGetParamOnSurface(target, UV(0.5, 1.3), param, LN_ProjectionOptions(), ParameterRangePolicy::Clamp), EvaluationStatus::Success);
+	EXPECT_LT(NurbsSurface::GetPointOnSurface(surface, param).Distance(target), 1E-4);
+	EXPECT_EQ(projector.TryGetParamOnSurface(XYZ(std::numeric_limits<double>::quiet_NaN(), 0, 0), param), EvaluationStatus::InvalidArgument);
+}
+
+TEST(Test_NurbsSurface, ScalarEvaluation)
+{
+	LN_NurbsSurface surface;
+	surface.DegreeU = 2;
+	surface.DegreeV = 3;
+	surface.KnotVectorU = { 0,0,0,0.25,0.5,0.75,1,1,1 };
+	surface.KnotVectorV = { 0,0,0,0,0.2,0.4,0.6,0.8,1,1,1,1 };
+	surface.ControlPoints.resize(6);
+	for (int i = 0; i < 6; i++)
+	{
+		for (int j = 0; j < 8; j++)
+		{
+			surface.ControlPoints[i].emplace_back(XYZW(XYZ(i, j, 0.5 * sin(i + 0.7 * j)), 1.0 + 0.25 * ((i + j) % 2)));
+		}
+	}
+
+	int rows = 9;
+	int columns = 11;
+	std::vector<double> uParams(rows);
+	std::vector<double> vParams(columns);
+	std::vector<float> floatU(rows);
+	std::vector<float> floatV(columns);
+	for (int i = 0; i < rows; i++)
+	{
+		uParams[i] = (double)i / (rows - 1);
+		floatU[i] = static_cast<float>(uParams[i]);
+	}
+	for (int j = 0; j < columns; j++)
+	{
+		vParams[j] = (double)j / (columns - 1);
+		floatV[j] = static_cast<float>(vParams[j]);
+	}
+	std::vector<std::vector<XYZ>> expectedPoints;
+	std::vector<std::vector<XYZ>> expectedNormals;
+	NurbsSurface::EvaluateNormalGrid(surface, uParams, vParams, expectedPoints, expectedNormals);
+
+	LN_ScalarNurbsSurface<float> floatSurface;
+	ScalarEvaluation::Convert(surface, floatSurface);
+	std::vector<float> points(3 * rows * columns);
+	std::vector<float> normals(3 * rows * columns);
+	ScalarEvaluation::EvaluateNormalGrid(floatSurface, floatU.data(), rows, floatV.data(), columns, points.data(), normals.data());
+	std::vector<float> gridPoints(3 * rows * columns);
+	ScalarEvaluation::EvaluateGrid(floatSurface, floatU.data(), rows, floatV.data(), columns, gridPoints.data());
+
+	LN_ScalarNurbsSurface<double> doubleSurface;
+	ScalarEvaluation::Convert(surface, doubleSurface);
+	std::vector<double> doublePoints(3 * rows * columns);
+	std::vector<double> doubleNormals(3 * rows * columns);
+	ScalarEvaluation::EvaluateNormalGrid(doubleSurface, uParams.data(), rows, vParams.data(), columns, doublePoints.data(), doubleNormals.data());
+
+	for (int i = 0; i < rows; i++)
+	{
+		for (int j = 0; j < columns; j++)
+		{
+			int index = 3 * (i * columns + j);
+			EXPECT_TRUE(XYZ(doublePoints[index], doublePoints[index + 1], doublePoints[index + 2]).IsAlmostEqualTo(expectedPoints[i][j]));
+			EXPECT_TRUE(XYZ(doubleNormals[index], doubleNormals[index + 1], doubleNormals[index + 2]).IsAlmostEqualTo(expectedNormals[i][j].Normalize()));
+			EXPECT_LT(XYZ(points[index], points[index + 1], points[index + 2]).Distance(expectedPoints[i][j]), 1E-4);
+			EXPECT_LT(XYZ(normals[index], normals[index + 1], normals[index + 2]).Distance(expectedNormals[i][j].Normalize()), 1E-4);
+			EXPECT_EQ(gridPoints[index], points[index]);
+		}
+	}
+}
+
+TEST(Test_NurbsSurface, ParallelLoft)
+{
+	int size = 40;
+	std::vector<LN_NurbsCurve> sections(size);
+	for (int k = 0; k < size; k++)
+	{
+		LN_NurbsCurve& section = sections[k];
+		double z = 0.5 * k;
+		double radius = 1.0 + 0.2 * sin(0.3 * k);
+		if (k % 2 == 0)
+		{
+			section.Degree = 2;
+			section.KnotVector = { 0,0,0,0.5,1,1,1 };
+		}
+		else
+		{
+			section.Degree = 3;
+			section.KnotVector = { 0,0,0,0,0.25,0.75,1,1,1,1 };
+		}
+		int count = section.KnotVector.size() - section.Degree - 1;
+		for (int i = 0; i < count; i++)
+		{
+			double angle = Constants::Pi * i / (count - 1);
+			section.ControlPoints.emplace_back(XYZW(XYZ(radius * cos(angle), radius * sin(angle), z), 1));
+		}
+	}
+
+	LN_NurbsSurface serial;
+	NurbsSurface::CreateLoftSurface(sections, serial);
+	SequentialExecutor executor;
+	LN_NurbsSurface parallel;
+	NurbsSurface::CreateLoftSurface(sections, parallel, &executor);
+	EXPECT_GT(executor.Calls, 0);
+	EXPECT_EQ(serial.DegreeU, 3);
+	EXPECT_EQ(serial.KnotVectorU, parallel.KnotVectorU);
+	EXPECT_EQ(serial.KnotVectorV, parallel.KnotVectorV);
+	ASSERT_EQ(serial.ControlPoints.size(), parallel.ControlPoints.size());
+	for (int i = 0; i < serial.ControlPoints.size(); i++)
+	{
+		for (int j = 0; j < serial.ControlPoints[i].size(); j++)
+		{
+			EXPECT_TRUE(serial.ControlPoints[i][j].IsAlmostEqualTo(parallel.ControlPoints[i][j]));
+		}
+	}
+
+	for (int i = 0; i <= 8; i++)
+	{
+		double u = i / 8.0;
+		EXPECT_TRUE(NurbsSurface::GetPointOnSurface(parallel, UV(u, 0)).IsAlmostEqualTo(NurbsCurve::GetPointOnCurve(sections[0], u)));
+		EXPECT_TRUE(NurbsSurface::GetPointOnSurface(parallel, UV(u, 1)).IsAlmostEqualTo(NurbsCurve::GetPointOnCurve(sections[size - 1], u)));
+	}
+
+	LN_NurbsCurve path;
+	path.Degree = 1;
+	path.KnotVector = { 0,0,1,1 };
+	path.ControlPoints = { XYZW(0,0,0,1), XYZW(0,0,10,1) };
+	std::vector<LN_NurbsCurve> profiles(sections.begin(), sections.begin() + 8);
+	LN_NurbsSurface serialSweep;
+	NurbsSurface::CreateSweepSurface(path, profiles, serialSweep);
+	LN_NurbsSurface parallelSweep;
+	NurbsSurface::CreateSweepSurface(path, profiles, parallelSweep, &executor);
+	for (int i = 0; i < serialSweep.ControlPoints.size(); i++)
+	{
+		for (int j = 0; j < serialSweep.ControlPoints[i].size(); j++)
+		{
+			EXPECT_TRUE(serialSweep.ControlPoints[i][j].IsAlmostEqualTo(parallelSweep.ControlPoints[i][j]));
+		}
+	}
+}
+
+TEST(Test_NurbsSurface, SplitAtParameters)
+{
+	LN_NurbsSurface surface;
+	surface.DegreeU = 2;
+	surface.DegreeV = 3;
+	surface.KnotVectorU = { 0,0,0,0.25,0.5,0.75,1,1,1 };
+	surface.KnotVectorV = { 0,0,0,0,0.2,0.4,0.6,0.8,1,1,1,1 };
+	surface.ControlPoints.resize(6);
+	for (int i = 0; i < 6; i++)
+	{
+		for (int j = 0; j < 8; j++)
+		{
+			surface.ControlPoints[i].emplace_back(XYZW(XYZ(i, j, 0.5 * sin(i + 0.7 * j)), 1.0 + 0.25 * ((i + j) % 2)));
+		}
+	}
+
+	double bounds[4] = { 0, 0.3, 0.5, 1 };
+	for (int d = 0; d < 2; d++)
+	{
+		bool isUDirection = d == 0;
+		std::vector<LN_NurbsSurface> pieces = NurbsSurface::SplitAt(surface, { 0.5, 0.3, 1.0 }, isUDirection);
+		ASSERT_EQ(pieces.size(), 3);
+		for (int i = 0; i < 3; i++)
+		{
+			const LN_NurbsSurface& piece = pieces[i];
+			for (int a = 0; a <= 3; a++)
+			{
+				for (int b = 0; b <= 3; b++)
+				{
+					double split = bounds[i] + (bounds[i + 1] - bounds[i]) * a / 3.0;
+					double other = b / 3.0;
+					UV uv = isUDirection ? UV(split, other) : UV(other, split);
+					EXPECT_TRUE(NurbsSurface::GetPointOnSurface(piece, uv).IsAlmostEqualTo(NurbsSurface::GetPointOnSurface(surface, uv)));
+				}
+			}
+		}
+	}
+}
+
+TEST(Test_NurbsSurface, CompactBeziers)
+{
+	LN_NurbsSurface surface;
+	surface.DegreeU = 2;
+	surface.DegreeV = 3;
+	surface.KnotVectorU = { 0,0,0,0.25,0.5,0.5,1,1,1 };
+	surface.KnotVectorV = { 0,0,0,0,0.2,0.4,0.6,0.8,1,1,1,1 };
+	surface.ControlPoints.resize(6);
+	for (int i = 0; i < 6; i++)
+	{
+		for (int j = 0; j < 8; j++)
+		{
+			surface.ControlPoints[i].emplace_back(XYZW(XYZ(i, j, 0.5 * sin(i + 0.7 * j)), 1.0 + 0.25 * ((i + j) % 2)));
+		}
+	}
+
+	LN_BezierPatchArray patches;
+	NurbsSurface::DecomposeToBeziers(surface, patches);
+	ASSERT_EQ(patches.CountU, 3);
+	ASSERT_EQ(patches.CountV, 5);
+	EXPECT_EQ(patches.ControlPoints.size(), 15 * 12);
+	for (int s = 0; s < patches.CountU * patches.CountV; s++)
+	{
+		const double* domain = &patches.Domains[4 * s];
+		LN_NurbsSurface patch;
+		patch.DegreeU = 2;
+		patch.DegreeV = 3;
+		patch.KnotVectorU = { domain[0], domain[0], domain[0], domain[1], domain[1], domain[1] };
+		patch.KnotVectorV = { domain[2], domain[2], domain[2], domain[2], domain[3], domain[3], domain[3], domain[3] };
+		patch.ControlPoints.resize(3);
+		for (int k = 0; k < 3; k++)
+		{
+			patch.ControlPoints[k].assign(patches.ControlPoints.begin() + (s * 3 + k) * 4, patches.ControlPoints.begin() + (s * 3 + k + 1) * 4);
+		}
+		for (int a = 0; a <= 2; a++)
+		{
+			for (int b = 0; b <= 2; b++)
+			{
+				UV uv(domain[0] + (domain[1] - domain[0]) * a / 2.0, domain[2] + (domain[3] - domain[2]) * b / 2.0);
+				EXPECT_TRUE(NurbsSurface::GetPointOnSurface(patch, uv).IsAlmostEqualTo(NurbsSurface::GetPointOnSurface(surface, uv)));
+			}
+		}
+	}
+
+	// The double knot in U has multiplicity equal to the degree, the patch list holds one patch per span pair.
+	std::vector<LN_NurbsSurface> bezierPatches = NurbsSurface::DecomposeToBeziers(surface);
+	ASSERT_EQ(bezierPatches.size(), 15);
+	for (int s = 0; s < bezierPatches.size(); s++)
+	{
+		for (int k = 0; k <= 2; k++)
+		{
+			for (int l = 0; l <= 3; l++)
+			{
+				EXPECT_TRUE(bezierPatches[s].ControlPoints[k][l].IsAlmostEqualTo(patches.ControlPoints[(s * 3 + k) * 4 + l]));
+			}
+		}
+	}
+}
+
+TEST(Test_NurbsSurface, PointDeviations)
+{
+	LN_NurbsSurface surface;
+	surface.DegreeU = 2;
+	surface.DegreeV = 3;
+	surface.KnotVectorU = { 0,0,0,0.25,0.5,0.75,1,1,1 };
+	surface.KnotVectorV = { 0,0,0,0,0.2,0.4,0.6,0.8,1,1,1,1 };
+	surface.ControlPoints.resize(6);
+	for (int i = 0; i < 6; i++)
+	{
+		for (int j = 0; j < 8; j++)
+		{
+			surface.ControlPoints[i].emplace_back(XYZW(XYZ(i, j, 0.3 * sin(i + 0.7 * j)), 1.0 + 0.25 * ((i + j) % 2)));
+		}
+	}
+
+	int rows = 30;
+	int columns = 30;
+	std::vector<XYZ> points;
+	std::vector<UV> params;
+	std::vector<double> offsets;
+	for (int i = 0; i < rows; i++)
+	{
+		for (int j = 0; j < columns; j++)
+		{
+			UV uv(0.02 + 0.96 * i / (rows - 1), 0.02 + 0.96 * j / (columns - 1));
+			std::vector<std::vector<XYZ>> derivatives = NurbsSurface::ComputeRationalSurfaceDerivatives(surface, 1, uv);
+			XYZ normal = derivatives[1][0].CrossProduct(derivatives[0][1]).Normalize();
+			double offset = ((i + j) % 3 - 1) * 0.01;
+			points.emplace_back(derivatives[0][0] + offset * normal);
+			params.emplace_back(uv);
+			offsets.emplace_back(offset);
+		}
+	}
+
+	SurfaceProjector projector(surface);
+	std::vector<LN_PointDeviation> coarse = projector.ComputeDeviations(points);
+	for (int i = 0; i < points.size(); i++)
+	{
+		EXPECT_NEAR(coarse[i].Distance, offsets[i], 2 * Constants::DistanceEpsilon);
+	}
+
+	LN_ProjectionOptions options;
+	options.MaxIterations = 20;
+	options.DistanceTolerance = 1E-10;
+	options.CosineTolerance = 1E-10;
+	std::vector<LN_PointDeviation> deviations = projector.ComputeDeviations(points, options);
+	ASSERT_EQ(deviations.size(), points.size());
+	for (int i = 0; i < points.size(); i++)
+	{
+		EXPECT_NEAR(deviations[i].Distance, offsets[i], 1E-6);
+		EXPECT_TRUE(deviations[i].FootPoint.IsAlmostEqualTo(NurbsSurface::GetPointOnSurface(surface, deviations[i].Param)));
+		EXPECT_LT(deviations[i].FootPoint.Distance(NurbsSurface::GetPointOnSurface(surface, params[i])), 1E-5);
+	}
+
+	SequentialExecutor executor;
+	std::vector<LN_PointDeviation> sequential(points.size());
+	projector.ComputeDeviations(points.data(), points.size(), sequential.data(), options, &executor);
+	EXPECT_EQ(executor.Calls, 1);
+	for (int i = 0; i < points.size(); i++)
+	{
+		EXPECT_DOUBLE_EQ(sequential[i].Distance, deviations[i].Distance);
+	}
+}
+
+TEST(Test_NurbsSurface, IsClosedByRows)
+{
+	LN_NurbsSurface cylinder;
+	ASSERT_TRUE(NurbsSurface::CreateCylindricalSurface(XYZ(0, 0, 0), XYZ(1, 0, 0), XYZ(0, 1, 0), 0, 2 * Constants::Pi, 2, 3, cylinder));
+	LN_NurbsSurface transposed = cylinder;
+	std::swap(transposed.DegreeU, transposed.DegreeV);
+	std::swap(transposed.KnotVectorU, transposed.KnotVectorV);
+	transposed.ControlPoints.clear();
+	MathUtils::Transpose(cylinder.ControlPoints, transposed.ControlPoints);
+
+	for (int k = 0; k < 2; k++)
+	{
+		bool isUDirection = k == 0;
+		for (int s = 0; s < 2; s++)
+		{
+			const LN_NurbsSurface& surface = s == 0 ? cylinder : transposed;
+			bool expected = true;
+			int rows = isUDirection ? surface.ControlPoints[0].size() : surface.ControlPoints.size();
+			for (int i = 0; i < rows; i++)
+			{
+				LN_NurbsCurve row;
+				row.Degree = isUDirection ? surface.DegreeU : surface.DegreeV;
+				row.KnotVector = isUDirection ? surface.KnotVectorU : surface.KnotVectorV;
+				for (int j = 0; j < (isUDirection ? surface.ControlPoints.size() : surface.ControlPoints[0].size()); j++)
+				{
+					row.ControlPoints.push_back(isUDirection ? surface.ControlPoints[j][i] : surface.ControlPoints[i][j]);
+				}
+				expected = expected && NurbsCurve::IsClosed(row);
+			}
+			EXPECT_EQ(NurbsSurface::IsClosed(surface, isUDirection), expected);
+		}
+	}
+	EXPECT_NE(NurbsSurface::IsClosed(cylinder, true), NurbsSurface::IsClosed(cylinder, false));
+	EXPECT_EQ(NurbsSurface::IsClosed(cylinder, true), NurbsSurface::IsClosed(transposed, false));
+}
+
+TEST(Test_NurbsSurface, BatchDegreeElevation)
+{
+	LN_NurbsSurface surface;
+	surface.DegreeU = 2;
+	surface.DegreeV = 3;
+	surface.KnotVectorU = { 0, 0, 0, 0.1, 0.25, 0.25, 0.4, 0.5, 0.55, 0.6, 0.7, 0.75, 0.8, 0.85, 0.9, 0.9, 0.95, 0.97, 0.99, 0.995, 1, 1, 1 };
+	surface.KnotVectorV = { 0, 0, 0, 0, 0.3, 0.6, 0.6, 1, 1, 1, 1 };
+	int rows = surface.KnotVectorU.size() - surface.DegreeU - 1;
+	int columns = surface.KnotVectorV.size() - surface.DegreeV - 1;
+	surface.ControlPoints.resize(rows, std::vector<XYZW>(columns));
+	for (int i = 0; i < rows; i++)
+	{
+		for (int j = 0; j < columns; j++)
+		{
+			double w = 1.0 + 0.3 * std::sin(i + 2.0 * j);
+			surface.ControlPoints[i][j] = XYZW(XYZ(i, j, std::cos(0.7 * i) * std::sin(j)), w);
+		}
+	}
+
+	for (int k = 0; k < 4; k++)
+	{
+		bool isUDirection = k % 2 == 0;
+		int times = k < 2 ? 1 : 2;
+		LN_NurbsSurface elevated = NurbsSurface::ElevateDegree(surface, times, isUDirection);
+		EXPECT_EQ(elevated.DegreeU, surface.DegreeU + (isUDirection ? times : 0));
+		EXPECT_EQ(elevated.DegreeV, surface.DegreeV + (isUDirection ? 0 : times));
+		NurbsSurface::Check(elevated);
+
+		int lanes = isUDirection ? columns : rows;
+		for (int l = 0; l < lanes; l++)
+		{
+			LN_NurbsCurve row;
+			row.Degree = isUDirection ? surface.DegreeU : surface.DegreeV;
+			row.KnotVector = isUDirection ? surface.KnotVectorU : surface.KnotVectorV;
+			for (int i = 0; i < (isUDirection ? rows : columns); i++)
+			{
+				row.ControlPoints.push_back(isUDirection ? surface.ControlPoints[i][l] : surface.ControlPoints[l][i]);
+			}
+			LN_NurbsCurve elevatedRow = NurbsCurve::ElevateDegree(row, times);
+			EXPECT_TRUE(elevatedRow.KnotVector == (isUDirection ? elevated.KnotVectorU : elevated.KnotVectorV));
+			ASSERT_EQ(elevatedRow.ControlPoints.size(), isUDirection ? elevated.ControlPoints.size() : elevated.ControlPoints[0].size());
+			for (int i = 0; i < elevatedRow.ControlPoints.size(); i++)
+			{
+				const XYZW& point = isUDirection ? elevated.ControlPoints[i][l] : elevated.ControlPoints[l][i];
+				for (int c = 0; c < 4; c++)
+				{
+					EXPECT_NEAR(point[c], elevatedRow.ControlPoints[i][c], 1E-12);
+				}
+			}
+		}
+
+		for (int i = 0; i <= 10; i++)
+		{
+			for (int j = 0; j <= 10; j++)
+			{
+				UV uv = UV(0.1 * i, 0.1 * j);
+				EXPECT_TRUE(NurbsSurface::GetPointOnSurface(elevated, uv).IsAlmostEqualTo(NurbsSurface::GetPointOnSurface(surface, uv)));
+			}
+		}
+
+		SequentialExecutor executor;
+		LN_NurbsSurface sequential;
+		NurbsSurface::ElevateDegree(surface, times, isUDirection, sequential, &executor);
+		EXPECT_EQ(executor.Calls, 1);
+		EXPECT_TRUE(sequential.ControlPoints.size() == elevated.ControlPoints.size());
+		for (int i = 0; i < sequential.ControlPoints.size(); i++)
+		{
+			for (int j = 0; j < sequential.ControlPoints[i].size(); j++)
+			{
+				EXPECT_TRUE(sequential.ControlPoints[i][j].IsAlmostEqualTo(elevated.ControlPoints[i][j]));
+			}
+		}
+	}
+}
+
+TEST(Test_NurbsSurface, TrimmedTessellation)
+{
+	LN_TrimmedSurface trimmed;
+	NurbsSurface::CreateBilinearSurface(XYZ(0, 0, 0), XYZ(1, 0, 0), XYZ(1, 1, 0), XYZ(0, 1, 0), trimmed.Surface);
+
+	// Square outer loop of four lines and a circular hole, S(u,v) = (u,v,0) so areas in space equal areas in parameters.
+	XYZ corners[4] = { XYZ(0.1, 0.1, 0), XYZ(0.9, 0.1, 0), XYZ(0.9, 0.9, 0), XYZ(0.1, 0.9, 0) };
+	std::vector<LN_NurbsCurve> outer(4);
+	for (int k = 0; k < 4; k++)
+	{
+		NurbsCurve::CreateLine(corners[k], corners[(k + 1) % 4], outer[k]);
+	}
+	LN_NurbsCurve circle;
+	double radius = 0.2;
+	EXPECT_TRUE(NurbsCurve::CreateArc(XYZ(0.5, 0.5, 0), XYZ(1, 0, 0), XYZ(0, 1, 0), 0, 2 * Constants::Pi, radius, radius, circle));
+	trimmed.Loops.emplace_back(outer);
+	trimmed.Loops.emplace_back(std::vector<LN_NurbsCurve>{ circle });
+
+	double tolerance = 1E-3;
+	TrimLoopClassifier trim(trimmed.Loops, tolerance);
+	const std::vector<UV>& starts = trim.GetSegmentStarts();
+	const std::vector<UV>& ends = trim.GetSegmentEnds();
+	for (int i = 0; i <= 40; i++)
+	{
+		for (int j = 0; j <= 40; j++)
+		{
+			UV uv(0.013 + i * 0.0243, 0.007 + j * 0.0247);
+			int crossings = 0;
+			for (int k = 0; k < starts.size(); k++)
+			{
+				if ((starts[k].GetV() > uv.GetV()) != (ends[k].GetV() > uv.GetV()) &&
+					starts[k].GetU() + (uv.GetV() - starts[k].GetV()) * (ends[k].GetU() - starts[k].GetU()) / (ends[k].GetV() - starts[k].GetV()) > uv.GetU())
+				{
+					crossings++;
+				}
+			}
+			EXPECT_EQ(trim.IsInside(uv), crossings % 2 == 1);
+		}
+	}
+	EXPECT_TRUE(trim.IsInside(UV(0.2, 0.2)));
+	EXPECT_FALSE(trim.IsInside(UV(0.5, 0.5)));
+	EXPECT_FALSE(trim.IsInside(UV(0.05, 0.5)));
+	EXPECT_TRUE(trim.Classify(UV(0.12, 0.12), UV(0.2, 0.2)) == TrimRegion::Inside);
+	EXPECT_TRUE(trim.Classify(UV(0.45, 0.45), UV(0.55, 0.55)) == TrimRegion::Outside);
+	EXPECT_TRUE(trim.Classify(UV(0.92, 0.0), UV(1.0, 1.0)) == TrimRegion::Outside);
+	EXPECT_TRUE(trim.Classify(UV(0.0, 0.0), UV(0.2, 0.2)) == TrimRegion::Boundary);
+
+	LN_Mesh mesh;
+	NurbsSurface::Tessellate(trimmed, 1E-3, 0.1, tolerance, mesh);
+	EXPECT_TRUE(mesh.Indices.size() > 0);
+	EXPECT_EQ(mesh.Vertices.size(), mesh.UVs.size());
+
+	std::vector<bool> isUsed(mesh.Vertices.size(), false);
+	double area = 0.0;
+	for (int k = 0; k < mesh.Indices.size(); k += 3)
+	{
+		const XYZ& a = mesh.Vertices[mesh.Indices[k]];
+		const XYZ& b = mesh.Vertices[mesh.Indices[k + 1]];
+		const XYZ& c = mesh.Vertices[mesh.Indices[k + 2]];
+		area += (b - a).CrossProduct(c - a).Length() / 2.0;
+		UV centroid = (mesh.UVs[mesh.Indices[k]] + mesh.UVs[mesh.Indices[k + 1]] + mesh.UVs[mesh.Indices[k + 2]]) / 3.0;
+		EXPECT_TRUE(trim.IsInside(centroid));
+		isUsed[mesh.Indices[k]] = isUsed[mesh.Indices[k + 1]] = isUsed[mesh.Indices[k + 2]] = true;
+	}
+	EXPECT_TRUE(std::find(isUsed.begin(), isUsed.end(), false) == isUsed.end());
+	double expectedArea = 0.8 * 0.8 - Constants::Pi * radius * radius;
+	EXPECT_NEAR(area, expectedArea, 0.01);
+
+	// Cells away from the loops stay coarse, only the boundary is refined.
+	LN_Mesh whole;
+	NurbsSurface::Tessellate(trimmed.Surface, 1E-3, 0.1, whole);
+	LN_TrimmedSurface untrimmed;
+	untrimmed.Surface = trimmed.Surface;
+	LN_Mesh untrimmedMesh;
+	NurbsSurface::Tessellate(untrimmed, 1E-3, 0.1, tolerance, untrimmedMesh);
+	EXPECT_EQ(untrimmedMesh.Indices.size(), whole.Indices.size());
+
+	// Appending keeps the vertices already in the mesh.
+	int firstCount = whole.Vertices.size();
+	NurbsSurface::Tessellate(trimmed.Surface, trim, 1E-3, 0.1, whole);
+	EXPECT_EQ(whole.Vertices.size(), firstCount + mesh.Vertices.size());
+	EXPECT_EQ(whole.Indices.size(), untrimmedMesh.Indices.size() + mesh.Indices.size());
+}
+
+TEST(Test_NurbsSurface, LevelsOfDetail)
+{
+	LN_NurbsSurface surface;
+	surface.DegreeU = 3;
+	surface.DegreeV = 2;
+	surface.KnotVectorU = { 0, 0, 0, 0, 0.5, 1, 1, 1, 1 };
+	surface.KnotVectorV = { 0, 0, 0, 0.5, 1, 1, 1 };
+	surface.ControlPoints.resize(5);
+	for (int i = 0; i < 5; i++)
+	{
+		for (int j = 0; j < 4; j++)
+		{
+			surface.ControlPoints[i].emplace_back(XYZW(XYZ(i, j, std::sin(1.3 * i + 0.7 * j) * (i % 2 + 1)), 1));
+		}
+	}
+	PreparedSurface prepared(surface);
+	const std::vector<LN_SurfaceLevelOfDetail>& levels = prepared.GetLevelsOfDetail();
+	ASSERT_GT(levels.size(), 2);
+	for (int k = 0; k < levels.size(); k++)
+	{
+		const LN_Mesh& mesh = levels[k].Mesh;
+		int side = 2 * (1 << k);
+		ASSERT_EQ(mesh.Vertices.size(), (side + 1) * (side + 1));
+		ASSERT_EQ(mesh.Indices.size(), 6 * side * side);
+		if (k > 0)
+		{
+			EXPECT_LT(levels[k].Error, levels[k - 1].Error);
+		}
+		for (int v = 0; v < mesh.Vertices.size(); v++)
+		{
+			EXPECT_TRUE(mesh.Vertices[v].IsAlmostEqualTo(NurbsSurface::GetPointOnSurface(surface, mesh.UVs[v])));
+		}
+
+		// Polynomial surfaces stay within Error of the triangle point at the same parameters.
+		for (int i = 0; i <= 12; i++)
+		{
+			for (int j = 0; j <= 12; j++)
+			{
+				UV uv(0.013 + i * 0.081, 0.007 + j * 0.0827);
+				XYZ point = NurbsSurface::GetPointOnSurface(surface, uv);
+				bool isFound = false;
+				for (int t = 0; t < mesh.Indices.size() && !isFound; t += 3)
+				{
+					const UV& a = mesh.UVs[mesh.Indices[t]];
+					const UV& b = mesh.UVs[mesh.Indices[t + 1]];
+					const UV& c = mesh.UVs[mesh.Indices[t + 2]];
+					double area = (b - a).CrossProduct(c - a);
+					double wb = (uv - a).CrossProduct(c - a) / area;
+					double wc = (b - a).CrossProduct(uv - a) / area;
+					if (wb >= 0 && wc >= 0 && wb + wc <= 1)
+					{
+						isFound = true;
+						XYZ interpolated = (1 - wb - wc) * mesh.Vertices[mesh.Indices[t]] + wb * mesh.Vertices[mesh.Indices[t + 1]] + wc * mesh.Vertices[mesh.Indices[t + 2]];
+						EXPECT_LE(point.Distance(interpolated), levels[k].Error + Constants::DistanceEpsilon);
+					}
+				}
+				EXPECT_TRUE(isFound);
+			}
+		}
+	}
+	EXPECT_EQ(&prepared.GetLevelOfDetail(levels[1].Error), &levels[1]);
+	EXPECT_EQ(&prepared.GetLevelOfDetail(0.0), &levels[levels.size() - 1]);
+
+	// Levels built on demand keep their address while finer ones are added.
+	PreparedSurface lazy(surface);
+	const LN_SurfaceLevelOfDetail& coarse = lazy.GetLevelOfDetail(levels[1].Error);
+	EXPECT_EQ(coarse.Mesh.Indices.size(), levels[1].Mesh.Indices.size());
+	const std::vector<LN_SurfaceLevelOfDetail>& lazyLevels = lazy.GetLevelsOfDetail();
+	ASSERT_EQ(lazyLevels.size(), levels.size());
+	EXPECT_EQ(&coarse, &lazyLevels[1]);
+	for (int k = 0; k < levels.size(); k++)
+	{
+		EXPECT_DOUBLE_EQ(lazyLevels[k].Error, levels[k].Error);
+	}
+
+	LN_NurbsSurface plane;
+	NurbsSurface::CreateBilinearSurface(XYZ(0, 0, 0), XYZ(1, 0, 0), XYZ(1, 1, 0), XYZ(0, 1, 0), plane);
+	PreparedSurface preparedPlane(plane);
+	ASSERT_EQ(preparedPlane.GetLevelsOfDetail().size(), 1);
+	EXPECT_EQ(preparedPlane.GetLevelOfDetail(0.0).Mesh.Indices.size(), 6);
+	EXPECT_TRUE(preparedPlane.GetLevelOfDetail(0.0).Mesh.Normals[0].IsAlmostEqualTo(XYZ(0, 0, 1)));
+}
@@ -0,0 +1,448 @@
+﻿#include "gtest/gtest.h"
+
+#ifdef LNLIB_ALLOCATION_TESTS
+
+#include "XYZ.h"
+#include "XYZW.h"
+#include "UV.h"
+#include "Matrix4d.h"
+#include "LNObject.h"
+#include "NurbsCurve.h"
+#include "NurbsSurface.h"
+#include "PreparedCurve.h"
+#include "PreparedSurface.h"
+#include "BezierCurve.h"
+#include "BezierSurface.h"
+#include "Constants.h"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <new>
+#include <vector>
+#include <algorithm>
+using namespace LNLib;
+
+// Counting replacement of the global allocation functions, only built with ENABLE_ALLOCATION_TESTS.
+// Calls from LNLib are counted as well where the platform resolves operator new across shared libraries (ELF),
+// Windows DLLs keep their own allocator and only see allocations of the test code itself.
+namespace
+{
+	std::atomic<bool> IsCountingAllocations(false);
+	std::atomic<long long> AllocationCount(0);
+
+	void* CountedAllocate(std::size_t size)
+	{
+		if (IsCountingAllocations.load(std::memory_order_relaxed))
+		{
+			AllocationCount.fetch_add(1, std::memory_order_relaxed);
+		}
+		return std::malloc(size == 0 ? 1 : size);
+	}
+
+	class AllocationCounter
+	{
+	public:
+
+		AllocationCounter()
+		{
+			AllocationCount.store(0);
+			IsCountingAllocations.store(true);
+		}
+
+		~AllocationCounter()
+		{
+			IsCountingAllocations.store(false);
+		}
+
+		long long Stop()
+		{
+			IsCountingAllocations.store(false);
+			return AllocationCount.load();
+		}
+	};
+}
+
+void* operator new(std::size_t size)
+{
+	void* memory = CountedAllocate(size);
+	if (memory == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+void* operator new[](std::size_t size)
+{
+	void* memory = CountedAllocate(size);
+	if (memory == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+	return CountedAllocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+	return CountedAllocate(size);
+}
+
+void operator delete(void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept
+{
+	std::free(memory);
+}
+
+namespace
+{
+	LN_NurbsCurve CreateWavyCurve(int controlPointsCount)
+	{
+		int degree = 3;
+		LN_NurbsCurve curve;
+		curve.Degree = degree;
+		for (int i = 0; i <= degree; i++)
+		{
+			curve.KnotVector.emplace_back(0.0);
+		}
+		int spans = controlPointsCount - degree;
+		for (int i = 1; i < spans; i++)
+		{
+			curve.KnotVector.emplace_back(static_cast<double>(i) / spans);
+		}
+		for (int i = 0; i <= degree; i++)
+		{
+			curve.KnotVector.emplace_back(1.0);
+		}
+		for (int i = 0; i < controlPointsCount; i++)
+		{
+			double weight = i % 2 == 0 ? 1.0 : 0.8;
+			curve.ControlPoints.emplace_back(XYZW(XYZ(i, std::sin(i * 0.7), std::cos(i * 0.3)), weight));
+		}
+		return curve;
+	}
+
+	LN_NurbsSurface CreateWavySurface(int controlPointsCount)
+	{
+		LN_NurbsCurve row = CreateWavyCurve(controlPointsCount);
+		LN_NurbsSurface surface;
+		surface.DegreeU = row.Degree;
+		surface.DegreeV = row.Degree;
+		surface.KnotVectorU = row.KnotVector;
+		surface.KnotVectorV = row.KnotVector;
+		surface.ControlPoints.resize(controlPointsCount);
+		for (int i = 0; i < controlPointsCount; i++)
+		{
+			for (int j = 0; j < controlPointsCount; j++)
+			{
+				double weight = (i + j) % 2 == 0 ? 1.0 : 0.9;
+				surface.ControlPoints[i].emplace_back(XYZW(XYZ(i, j, std::sin(i * 0.5) * std::cos(j * 0.4)), weight));
+			}
+		}
+		return surface;
+	}
+
+	std::vector<double> CreateParams(int count)
+	{
+		std::vector<double> params(count);
+		for (int i = 0; i < count; i++)
+		{
+			params[i] = static_cast<double>(i) / (count - 1);
+		}
+		return params;
+	}
+
+	std::vector<XYZ> CreateThroughPoints(int count)
+	{
+		std::vector<XYZ> points(count);
+		for (int i = 0; i < count; i++)
+		{
+			points[i] = XYZ(i, std::sin(i * 0.2), std::cos(i * 0.1));
+		}
+		return points;
+	}
+
+	class ScalingCase
+	{
+	public:
+		virtual ~ScalingCase() {}
+		virtual void Run(int size) = 0;
+	};
+
+	double GetMinimumSeconds(ScalingCase& scalingCase, int size)
+	{
+		double minimum = Constants::MaxDistance;
+		for (int run = 0; run < 5; run++)
+		{
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			scalingCase.Run(size);
+			std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+			minimum = std::min(minimum, elapsed.count());
+		}
+		return minimum;
+	}
+
+	// Worst case of three attempts, so one noisy measurement does not fail the test.
+	double GetScalingRatio(ScalingCase& scalingCase, int size, int factor)
+	{
+		double best = Constants::MaxDistance;
+		for (int attempt = 0; attempt < 3; attempt++)
+		{
+			double small = GetMinimumSeconds(scalingCase, size);
+			double large = GetMinimumSeconds(scalingCase, size * factor);
+			best = std::min(best, large / std::max(small, 1E-7));
+		}
+		return best;
+	}
+
+	class CurveEvaluationCase : public ScalingCase
+	{
+	public:
+		void Run(int size) override
+		{
+			LN_NurbsCurve curve = CreateWavyCurve(size);
+			std::vector<double> params = CreateParams(size * 8);
+			std::vector<XYZ> points(params.size());
+			NurbsCurve::GetPointsOnCurve(curve, params.data(), params.size(), points.data());
+		}
+	};
+
+	class CurveInterpolationCase : public ScalingCase
+	{
+	public:
+		void Run(int size) override
+		{
+			LN_NurbsCurve curve;
+			NurbsCurve::GlobalInterpolation(3, CreateThroughPoints(size), curve);
+		}
+	};
+
+	class CurveTessellationCase : public ScalingCase
+	{
+	public:
+		void Run(int size) override
+		{
+			std::vector<XYZ> points;
+			std::vector<double> knots;
+			NurbsCurve::Tessellate(CreateWavyCurve(size), 0.01, 0.1, points, knots);
+		}
+	};
+
+	// Allocations of a call at 4 times the size must stay within the linear bound.
+	const int AllocationScale = 4;
+	const double AllocationSlope = 4.5;
+	const long long AllocationOffset = 64;
+
+	// Time of a call at 8 times the size, linear code is at ~8 and quadratic code at ~64.
+	const int TimeScale = 8;
+	const double MaxTimeRatio = 20.0;
+}
+
+TEST(Test_Performance, CurveEvaluationAllocations)
+{
+	LN_NurbsCurve curve = CreateWavyCurve(20);
+	LN_CheckedNurbsCurve checkedCurve = NurbsCurve::Check(curve);
+	std::vector<double> params = CreateParams(50);
+	std::vector<XYZ> points(params.size());
+	std::vector<XYZ> derivatives(params.size() * 3);
+	LN_DerivativeWorkspace workspace;
+	NurbsCurve::ComputeRationalCurveDerivatives(checkedCurve, 2, 0.5, workspace, derivatives.data());
+
+	PreparedCurve prepared(curve);
+	prepared.GetPointOnCurve(0.5);
+	prepared.ComputeDerivatives(2, params.data(), 1, derivatives.data());
+
+	AllocationCounter counter;
+	XYZ sum;
+	for (int i = 0; i < params.size(); i++)
+	{
+		sum += NurbsCurve::GetPointOnCurve(checkedCurve, params[i]);
+		sum += prepared.GetPointOnCurve(params[i]);
+		NurbsCurve::ComputeRationalCurveDerivatives(checkedCurve, 2, params[i], workspace, derivatives.data());
+	}
+	prepared.GetPointsOnCurve(params.data(), params.size(), points.data());
+	prepared.ComputeDerivatives(2, params.data(), params.size(), derivatives.data());
+	long long allocations = counter.Stop();
+
+	EXPECT_EQ(allocations, 0);
+	EXPECT_TRUE(sum.Length() > 0.0);
+
+	// The unprepared batch gathers the spans it evaluates into stack lanes and does not allocate.
+	std::vector<double> moreParams = CreateParams(params.size() * 100);
+	std::vector<XYZ> morePoints(moreParams.size());
+
+	AllocationCounter batchCounter;
+	NurbsCurve::GetPointsOnCurve(checkedCurve, params.data(), params.size(), points.data());
+	long long batchAllocations = batchCounter.Stop();
+
+	AllocationCounter largeBatchCounter;
+	NurbsCurve::GetPointsOnCurve(checkedCurve, moreParams.data(), moreParams.size(), morePoints.data());
+	long long largeBatchAllocations = largeBatchCounter.Stop();
+
+	EXPECT_EQ(batchAllocations, 0);
+	EXPECT_EQ(largeBatchAllocations, 0);
+}
+
+TEST(Test_Performance, SurfaceEvaluationAllocations)
+{
+	LN_NurbsSurface surface = CreateWavySurface(8);
+	LN_CheckedNurbsSurface checkedSurface = NurbsSurface::Check(surface);
+	std::vector<UV> uvs;
+	for (int i = 0; i < 10; i++)
+	{
+		for (int j = 0; j < 10; j++)
+		{
+			uvs.emplace_back(UV(i / 9.0, j / 9.0));
+		}
+	}
+	int derivative = 1;
+	std::vector<XYZ> derivatives(uvs.size() * (derivative + 1) * (derivative + 1));
+
+	PreparedSurface prepared(surface);
+	prepared.ComputeDerivatives(derivative, uvs.data(), 1, derivatives.data());
+
+	Matrix4d rotation = Matrix4d::CreateRotation(XYZ(0, 0, 1), Constants::Pi / 3);
+	std::vector<XYZW> transformed(surface.ControlPoints[0].size());
+
+	AllocationCounter counter;
+	XYZ sum;
+	for (int i = 0; i < uvs.size(); i++)
+	{
+		sum += NurbsSurface::GetPointOnSurface(checkedSurface, uvs[i]);
+	}
+	prepared.ComputeDerivatives(derivative, uvs.data(), uvs.size(), derivatives.data());
+	rotation.OfWeightedPoints(surface.ControlPoints[0].data(), transformed.size(), transformed.data());
+	long long allocations = counter.Stop();
+
+	EXPECT_EQ(allocations, 0);
+	EXPECT_TRUE(sum.Length() > 0.0);
+}
+
+TEST(Test_Performance, BezierEvaluationAllocations)
+{
+	LN_NurbsSurface surface = CreateWavySurface(8);
+	LN_NurbsSurface patch = NurbsSurface::DecomposeToBeziers(surface)[0];
+	LN_BezierSurface<XYZW> bezierSurface;
+	bezierSurface.DegreeU = patch.DegreeU;
+	bezierSurface.DegreeV = patch.DegreeV;
+	bezierSurface.ControlPoints = patch.ControlPoints;
+	LN_BezierCurve<XYZW> bezierCurve;
+	bezierCurve.Degree = patch.DegreeV;
+	bezierCurve.ControlPoints = patch.ControlPoints[0];
+
+	std::vector<double> params = CreateParams(32);
+	LN_BernsteinTable tableU;
+	LN_BernsteinTable tableV;
+	BezierCurve::CreateBernsteinTable(bezierSurface.DegreeU, params, tableU);
+	BezierCurve::CreateBernsteinTable(bezierSurface.DegreeV, params, tableV);
+	std::vector<XYZW> curvePoints(params.size());
+	std::vector<XYZW> surfacePoints(params.size() * params.size());
+
+	AllocationCounter counter;
+	XYZW sum;
+	for (int i = 0; i < params.size(); i++)
+	{
+		sum += BezierCurve::GetPointOnCurveByBernstein(bezierCurve, params[i]);
+		sum += BezierCurve::GetPointOnCurveByDeCasteljau(bezierCurve, params[i]);
+		sum += BezierSurface::GetPointOnSurfaceByDeCasteljau(bezierSurface, UV(params[i], params[i]));
+	}
+	BezierCurve::GetPointsOnCurve(bezierCurve, tableV, curvePoints.data());
+	BezierSurface::GetPointsOnSurface(bezierSurface, tableU, tableV, surfacePoints.data());
+	long long allocations = counter.Stop();
+
+	EXPECT_EQ(allocations, 0);
+	EXPECT_TRUE(sum.GetW() > 0.0);
+	EXPECT_TRUE(surfacePoints[0].ToXYZ(true).IsAlmostEqualTo(patch.ControlPoints[0][0].ToXYZ(true)));
+}
+
+TEST(Test_Performance, FittingAllocations)
+{
+	int size = 200;
+	std::vector<XYZ> smallPoints = CreateThroughPoints(size);
+	std::vector<XYZ> largePoints = CreateThroughPoints(size * AllocationScale);
+	LN_NurbsCurve curve;
+
+	AllocationCounter smallCounter;
+	NurbsCurve::GlobalInterpolation(3, smallPoints, curve);
+	long long smallAllocations = smallCounter.Stop();
+
+	AllocationCounter largeCounter;
+	NurbsCurve::GlobalInterpolation(3, largePoints, curve);
+	long long largeAllocations = largeCounter.Stop();
+
+	EXPECT_TRUE(smallAllocations > 0);
+	EXPECT_LE(largeAllocations, AllocationSlope * smallAllocations + AllocationOffset);
+}
+
+TEST(Test_Performance, TessellationAllocations)
+{
+	int size = 50;
+	LN_NurbsCurve smallCurve = CreateWavyCurve(size);
+	LN_NurbsCurve largeCurve = CreateWavyCurve(size * AllocationScale);
+	std::vector<XYZ> smallPoints;
+	std::vector<double> smallKnots;
+	std::vector<XYZ> largePoints;
+	std::vector<double> largeKnots;
+
+	AllocationCounter smallCounter;
+	NurbsCurve::Tessellate(smallCurve, 0.01, 0.1, smallPoints, smallKnots);
+	long long smallAllocations = smallCounter.Stop();
+
+	AllocationCounter largeCounter;
+	NurbsCurve::Tessellate(largeCurve, 0.01, 0.1, largePoints, largeKnots);
+	long long largeAllocations = largeCounter.Stop();
+
+	EXPECT_TRUE(smallPoints.size() > size);
+	EXPECT_LE(largeAllocations, AllocationSlope * smallAllocations + AllocationOffset);
+
+	LN_NurbsSurface smallSurface = CreateWavySurface(6);
+	LN_NurbsSurface largeSurface = CreateWavySurface(12);
+	LN_Mesh smallMesh;
+	LN_Mesh largeMesh;
+
+	AllocationCounter smallSurfaceCounter;
+	NurbsSurface::Tessellate(smallSurface, 0.05, 0.2, smallMesh);
+	long long smallSurfaceAllocations = smallSurfaceCounter.Stop();
+
+	AllocationCounter largeSurfaceCounter;
+	NurbsSurface::Tessellate(largeSurface, 0.05, 0.2, largeMesh);
+	long long largeSurfaceAllocations = largeSurfaceCounter.Stop();
+
+	// Adaptive refinement decides the mesh size, allocations must follow the output linearly.
+	double outputRatio = static_cast<double>(largeMesh.Indices.size()) / smallMesh.Indices.size();
+	EXPECT_TRUE(outputRatio > 1.0);
+	EXPECT_LE(largeSurfaceAllocations, AllocationSlope / AllocationScale * outputRatio * smallSurfaceAllocations + AllocationOffset);
+}
+
+TEST(Test_Performance, LinearScaling)
+{
+	CurveEvaluationCase evaluation;
+	EXPECT_LT(GetScalingRatio(evaluation, 2000, TimeScale), MaxTimeRatio);
+
+	CurveInterpolationCase interpolation;
+	EXPECT_LT(GetScalingRatio(interpolation, 1000, TimeScale), MaxTimeRatio);
+
+	CurveTessellationCase tessellation;
+	EXPECT_LT(GetScalingRatio(tessellation, 200, TimeScale), MaxTimeRatio);
+}
+
+#endif
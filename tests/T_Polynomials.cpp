@@ -57,6 +57,30 @@ TEST(Test_Polynomials, All)
 					MathUtils::IsAlmostEqualTo(oneders[2], checkders[2 - i][2]));
 	}
 
+	KnotSpanCursor cursor(degree, knotVector);
+	std::vector<double> cursorParams = { 0.0, 0.5, 2.5, 2.5, 4.0, 4.5, 5.0, 1.0 };
+	for (int i = 0; i < cursorParams.size(); i++)
+	{
+		EXPECT_TRUE(cursor.Find(cursorParams[i]) == Polynomials::GetKnotSpanIndex(degree, knotVector, cursorParams[i]));
+	}
+	EXPECT_TRUE(cursor.GetSpanIndex() == 3);
+
+	std::vector<double> cubicKnotVector = { 0,0,0,0,1,2,3,3,3,3 };
+	int cubicSpanIndex = Polynomials::GetKnotSpanIndex(3, cubicKnotVector, 1.5);
+	double fixedBasis[4];
+	Polynomials::BasisFunctions<3>(cubicSpanIndex, cubicKnotVector, 1.5, fixedBasis);
+	double fixedDers[4 * 4];
+	Polynomials::BasisFunctionsDerivatives<3>(cubicSpanIndex, 3, cubicKnotVector, 1.5, fixedDers);
+	for (int j = 0; j <= 3; j++)
+	{
+		EXPECT_TRUE(MathUtils::IsAlmostEqualTo(fixedBasis[j], Polynomials::OneBasisFunction(cubicSpanIndex - 3 + j, 3, cubicKnotVector, 1.5)));
+		auto oneders = Polynomials::OneBasisFunctionDerivative(cubicSpanIndex - 3 + j, 3, 3, cubicKnotVector, 1.5);
+		for (int k = 0; k <= 3; k++)
+		{
+			EXPECT_TRUE(MathUtils::IsAlmostEqualTo(fixedDers[k * 4 + j], oneders[k]));
+		}
+	}
+
 	std::vector<double> u1 = { 0,0,0,1,2,2,4,4,4 };
 	std::vector<double> u2 = { 0,0,0,1,2,3,4,4,4 };
 	std::vector<double> insert1;
@@ -74,4 +98,26 @@ TEST(Test_Polynomials, All)
 	KnotVectorUtils::GetInsertedKnotElement(u1, u2, i1, i2);
 	EXPECT_TRUE(i1.size() == 4);
 	EXPECT_TRUE(i2.size() == 3);
-}
\ No newline at end of file
+
+	std::vector<std::vector<double>> cubicMatrix = Polynomials::BezierToPowerMatrix(3);
+	std::vector<std::vector<double>> expectedCubic = { {1,0,0,0},{-3,3,0,0},{3,-6,3,0},{-1,3,-3,1} };
+	for (int i = 0; i <= 3; i++)
+	{
+		for (int j = 0; j <= 3; j++)
+		{
+			EXPECT_TRUE(MathUtils::IsAlmostEqualTo(cubicMatrix[i][j], expectedCubic[i][j]));
+		}
+	}
+	for (int p = 1; p <= 6; p++)
+	{
+		std::vector<std::vector<double>> matrix = Polynomials::BezierToPowerMatrix(p);
+		std::vector<std::vector<double>> identity = MathUtils::MatrixMultiply(matrix, Polynomials::PowerToBezierMatrix(p, matrix));
+		for (int i = 0; i <= p; i++)
+		{
+			for (int j = 0; j <= p; j++)
+			{
+				EXPECT_TRUE(MathUtils::IsAlmostEqualTo(identity[i][j], i == j ? 1.0 : 0.0));
+			}
+		}
+	}
+}